@@ -46,6 +46,7 @@
 #include "i915/gem_create.h"
 #include "igt.h"
 #include "igt_device.h"
+#include "igt_spike.h"
 
 #define CONTEXT		0x1
 #define REALTIME	0x2
@@ -56,6 +57,7 @@ static int done;
 static int fd;
 static volatile uint32_t *timestamp_reg;
 static struct intel_mmio_data mmio_data;
+static igt_spike_t *spike;
 
 #define REG(x) (volatile uint32_t *)((volatile char *)igt_global_mmio + x)
 #define REG_OFFSET(x) ((volatile char *)(x) - (volatile char *)igt_global_mmio)
@@ -311,11 +313,17 @@ static void fence_wait(int fence)
 
 static void measure_latency(struct producer *p, struct igt_mean *mean)
 {
+	uint32_t cycles;
+
 	if (!(p->latency_dispatch.execbuf.flags & I915_EXEC_FENCE_OUT))
 		gem_sync(fd, p->latency_dispatch.exec[0].handle);
 	else
 		fence_wait(p->latency_dispatch.execbuf.rsvd2 >> 32);
-	igt_mean_add(mean, read_timestamp() - *p->last_timestamp);
+
+	cycles = read_timestamp() - *p->last_timestamp;
+	igt_mean_add(mean, cycles);
+	if (spike)
+		igt_spike_sample(spike, -1, CYCLES_TO_NS(cycles));
 }
 
 static void *producer(void *arg)
@@ -576,6 +584,9 @@ static int run(int seconds,
 		break;
 	}
 
+	if (spike)
+		igt_spike_report(spike, stdout, 10, false);
+
 	return 0;
 }
 
@@ -587,9 +598,10 @@ int main(int argc, char **argv)
 	int nop = 0;
 	int workload = 0;
 	unsigned flags = 0;
-	int c;
+	long spike_us = 0;
+	int c, ret;
 
-	while ((c = getopt(argc, argv, "Cp:c:n:w:t:f:sRF")) != -1) {
+	while ((c = getopt(argc, argv, "Cp:c:n:w:t:f:S:sRF")) != -1) {
 		switch (c) {
 		case 'p':
 			/* How many threads generate work? */
@@ -657,10 +669,34 @@ int main(int argc, char **argv)
 			flags |= FENCE_OUT;
 			break;
 
+		case 'S':
+			/* Capture the trace of latencies above (microseconds),
+			 * attributed to the CPU of the waiter.
+			 */
+			spike_us = atol(optarg);
+			break;
+
 		default:
 			break;
 		}
 	}
 
-	return run(time, producers, consumers, nop, workload, flags);
+	if (spike_us > 0) {
+		spike = malloc(sizeof(*spike));
+		if (!igt_spike_init(spike, NULL, spike_us * 1000, 0, 16)) {
+			fprintf(stderr, "Unable to open tracefs: %s\n",
+				strerror(errno));
+			free(spike);
+			spike = NULL;
+		}
+	}
+
+	ret = run(time, producers, consumers, nop, workload, flags);
+
+	if (spike) {
+		igt_spike_fini(spike);
+		free(spike);
+	}
+
+	return ret;
 }
@@ -49,12 +49,14 @@
 #include "i915/gem_create.h"
 #include "i915/gem_ring.h"
 #include "igt_aux.h"
+#include "igt_spike.h"
 
 #ifdef __FreeBSD__
 #include "igt_freebsd.h"
 #endif
 
 static volatile int done;
+static igt_spike_t *spike;
 
 struct gem_busyspin {
 	pthread_t thread;
@@ -67,6 +69,7 @@ struct gem_busyspin {
 struct sys_wait {
 	pthread_t thread;
 	struct igt_mean mean;
+	int cpu;
 };
 
 static void force_low_latency(void)
@@ -185,6 +188,9 @@ static void *sys_wait(void *arg)
 		sigwait(&mask, &sigs);
 		clock_gettime(CLOCK_MONOTONIC, &now);
 		igt_mean_add(&w->mean, elapsed(&its.it_value, &now));
+		if (spike)
+			igt_spike_sample(spike, w->cpu,
+					 elapsed(&its.it_value, &now));
 	}
 
 	sigprocmask(SIG_UNBLOCK, &mask, NULL);
@@ -216,6 +222,8 @@ static void *sys_thp_alloc(void *arg)
 
 		clock_gettime(CLOCK_MONOTONIC, &now);
 		igt_mean_add(&w->mean, elapsed(&start, &now));
+		if (spike)
+			igt_spike_sample(spike, w->cpu, elapsed(&start, &now));
 	}
 
 	return NULL;
@@ -356,9 +364,10 @@ int main(int argc, char **argv)
 	bool leak = false;
 	bool interrupts = false;
 	long batch = 0;
+	long spike_us = 0;
 	int n, c;
 
-	while ((c = getopt(argc, argv, "r:t:f:bmni1")) != -1) {
+	while ((c = getopt(argc, argv, "r:t:f:S:bmni1")) != -1) {
 		switch (c) {
 		case '1':
 			ncpus = 1;
@@ -392,6 +401,10 @@ int main(int argc, char **argv)
 			sys_fn = sys_thp_alloc;
 			leak = true;
 			break;
+		case 'S':
+			/* Capture the trace of latencies above (microseconds) */
+			spike_us = atol(optarg);
+			break;
 		default:
 			break;
 		}
@@ -419,11 +432,22 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (spike_us > 0) {
+		spike = malloc(sizeof(*spike));
+		if (!igt_spike_init(spike, NULL, spike_us * 1000, 0, 16)) {
+			fprintf(stderr, "Unable to open tracefs: %s\n",
+				strerror(errno));
+			free(spike);
+			spike = NULL;
+		}
+	}
+
 	wait = calloc(ncpus, sizeof(*wait));
 	pthread_attr_init(&attr);
 	rtprio(&attr, 99);
 	for (n = 0; n < ncpus; n++) {
 		igt_mean_init(&wait[n].mean);
+		wait[n].cpu = n;
 		bind_cpu(&attr, n);
 		pthread_create(&wait[n].thread, &attr, sys_fn, &wait[n]);
 	}
@@ -469,6 +493,12 @@ int main(int argc, char **argv)
 		break;
 	}
 
+	if (spike) {
+		igt_spike_report(spike, stdout, 10, false);
+		igt_spike_fini(spike);
+		free(spike);
+	}
+
 	return 0;
 
 }
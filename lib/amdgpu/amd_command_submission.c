@@ -10,6 +10,7 @@
 #include "lib/amdgpu/amd_sdma.h"
 #include "lib/amdgpu/amd_PM4.h"
 #include "lib/amdgpu/amd_command_submission.h"
+#include "lib/amdgpu/amd_ib_pool.h"
 #include "ioctl_wrappers.h"
 
 
@@ -18,6 +19,11 @@
  * Caller need create/release:
  * pm4_src, resources, ib_info, and ibs_request
  * submit command stream described in ibs_request and wait for this IB accomplished
+ *
+ * If ring_context->ib_pool is set the IB and BO list come from the pool
+ * instead of being allocated and destroyed for this submission, and the
+ * submission is not waited upon: the pool only blocks once its depth is
+ * exhausted, callers must amdgpu_ib_pool_sync() before checking results.
  */
 
 int amdgpu_test_exec_cs_helper(amdgpu_device_handle device, unsigned int ip_type,
@@ -35,6 +41,12 @@ int amdgpu_test_exec_cs_helper(amdgpu_device_handle device, unsigned int ip_type
 	const struct amdgpu_ip_block_version *ip_block = NULL;
 	amdgpu_bo_handle *all_res;
 
+	if (ring_context->ib_pool && !user_queue && !expect_failure) {
+		amdgpu_ib_pool_submit(ring_context->ib_pool, ip_type, ring_context);
+
+		return ring_context->err_codes.err_code_cs_submit;
+	}
+
 	ip_block = get_ip_block(device, ip_type);
 	all_res = alloca(sizeof(ring_context->resources[0]) * (ring_context->res_cnt + 1));
 
@@ -0,0 +1,361 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright 2026 Advanced Micro Devices, Inc.
+ */
+
+#include <amdgpu.h>
+#include <inttypes.h>
+#include "lib/amdgpu/amd_memory.h"
+#include "lib/amdgpu/amd_ip_blocks.h"
+#include "lib/amdgpu/amd_ib_pool.h"
+
+/*
+ * IB pool: one GTT buffer mapped once and carved into IBs by a ring
+ * suballocator. An IB is reused only after the submission that consumed it
+ * has signaled, which lets callers keep up to @depth submissions in flight
+ * instead of allocating, mapping and freeing a buffer per submission.
+ */
+
+#define AMDGPU_IB_POOL_ALIGNMENT 256
+
+static struct amdgpu_ib_pool_fence *
+pool_fence(struct amdgpu_ib_pool *pool, uint64_t seqno)
+{
+	return &pool->fences[seqno % pool->max_fences];
+}
+
+static bool pool_fence_wait(void *priv, uint64_t seqno, int64_t timeout_ns)
+{
+	struct amdgpu_ib_pool *pool = priv;
+	struct amdgpu_ib_pool_fence *f;
+	uint32_t expired = 0;
+	int r;
+
+	if (seqno <= pool->completed)
+		return true;
+
+	f = pool_fence(pool, seqno);
+	if (!f->signaled) {
+		r = pool->ops->query(pool, &f->fence,
+				     timeout_ns < 0 ? AMDGPU_TIMEOUT_INFINITE : timeout_ns,
+				     &expired);
+		/* we allow ECANCELED or ENODATA for good jobs temporally */
+		if (r == -ECANCELED || r == -ENODATA)
+			expired = 1;
+		else
+			igt_assert_eq(r, 0);
+
+		if (!expired)
+			return false;
+
+		f->signaled = true;
+	}
+
+	/* submissions may target different rings, so only advance in order */
+	while (pool->completed < pool->seqno &&
+	       pool_fence(pool, pool->completed + 1)->signaled)
+		pool->completed++;
+
+	return true;
+}
+
+static const struct igt_suballoc_ops pool_fence_ops = {
+	.wait = pool_fence_wait,
+};
+
+/**
+ * __amdgpu_ib_pool_create:
+ * @cpu: CPU mapping of the IB backing store
+ * @mc_address: GPU address of @cpu
+ * @size: size of the IB backing store in bytes
+ * @depth: maximum number of submissions kept in flight by
+ *	   amdgpu_ib_pool_submit(), 1 makes every submission synchronous
+ * @ops: backend submitting the IBs and querying their fences
+ * @priv: backend private data
+ *
+ * Creates a pool carving IBs out of a caller provided buffer. Allows
+ * exercising the pool without a device, amdgpu_ib_pool_create() should be
+ * used otherwise.
+ *
+ * Returns: a new IB pool, to be released with amdgpu_ib_pool_destroy().
+ */
+struct amdgpu_ib_pool *
+__amdgpu_ib_pool_create(void *cpu, uint64_t mc_address, uint32_t size,
+			unsigned int depth, const struct amdgpu_ib_pool_ops *ops,
+			void *priv)
+{
+	struct amdgpu_ib_pool *pool;
+
+	igt_assert(depth);
+
+	pool = calloc(1, sizeof(*pool));
+	igt_assert(pool);
+
+	pool->ops = ops;
+	pool->priv = priv;
+	pool->cpu = cpu;
+	pool->mc_address = mc_address;
+	pool->size = size;
+	pool->depth = depth;
+
+	/* every in-flight submission holds at least one chunk */
+	pool->max_fences = pool->size / AMDGPU_IB_POOL_ALIGNMENT + 1;
+	if (pool->max_fences <= depth)
+		pool->max_fences = depth + 1;
+	pool->fences = calloc(pool->max_fences, sizeof(*pool->fences));
+	igt_assert(pool->fences);
+
+	igt_suballoc_init(&pool->sa, pool->size, AMDGPU_IB_POOL_ALIGNMENT,
+			  &pool_fence_ops, pool);
+
+	return pool;
+}
+
+static amdgpu_bo_list_handle
+pool_get_bo_list(struct amdgpu_ib_pool *pool,
+		 const amdgpu_bo_handle *resources, int res_cnt)
+{
+	amdgpu_bo_handle all_res[AMDGPU_IB_POOL_MAX_RESOURCES + 1];
+	struct amdgpu_ib_pool_bo_list *l;
+	int r;
+
+	igt_assert(res_cnt <= AMDGPU_IB_POOL_MAX_RESOURCES);
+
+	for (int i = 0; i < AMDGPU_IB_POOL_BO_LISTS; i++) {
+		l = &pool->bo_lists[i];
+		if (l->list && l->res_cnt == res_cnt &&
+		    !memcmp(l->resources, resources, res_cnt * sizeof(*resources))) {
+			pool->stats.bo_list_hits++;
+			return l->list;
+		}
+	}
+
+	pool->stats.bo_list_misses++;
+
+	l = &pool->bo_lists[pool->next_bo_list++ % AMDGPU_IB_POOL_BO_LISTS];
+	if (l->list)
+		igt_assert_eq(amdgpu_bo_list_destroy(l->list), 0);
+
+	memcpy(all_res, resources, res_cnt * sizeof(*resources));
+	all_res[res_cnt] = pool->bo;
+
+	r = amdgpu_bo_list_create(pool->device, res_cnt + 1, all_res,
+				  NULL, &l->list);
+	igt_assert_eq(r, 0);
+
+	memcpy(l->resources, resources, res_cnt * sizeof(*resources));
+	l->res_cnt = res_cnt;
+
+	return l->list;
+}
+
+static int pool_submit(struct amdgpu_ib_pool *pool,
+		       struct amdgpu_ring_context *ring_context)
+{
+	ring_context->ibs_request.resources =
+		pool_get_bo_list(pool, ring_context->resources, ring_context->res_cnt);
+
+	return amdgpu_cs_submit(ring_context->context_handle, 0,
+				&ring_context->ibs_request, 1);
+}
+
+static int pool_query(struct amdgpu_ib_pool *pool, struct amdgpu_cs_fence *fence,
+		      uint64_t timeout_ns, uint32_t *expired)
+{
+	return amdgpu_cs_query_fence_status(fence, timeout_ns, 0, expired);
+}
+
+static const struct amdgpu_ib_pool_ops pool_ops = {
+	.submit = pool_submit,
+	.query = pool_query,
+};
+
+/**
+ * amdgpu_ib_pool_create:
+ * @device: amdgpu device handle
+ * @size: size of the IB backing store in bytes
+ * @depth: maximum number of submissions kept in flight by
+ *	   amdgpu_ib_pool_submit(), 1 makes every submission synchronous
+ *
+ * Returns: a new IB pool, to be released with amdgpu_ib_pool_destroy().
+ */
+struct amdgpu_ib_pool *
+amdgpu_ib_pool_create(amdgpu_device_handle device, uint32_t size, unsigned int depth)
+{
+	struct amdgpu_ib_pool *pool;
+	amdgpu_va_handle va_handle;
+	uint64_t mc_address;
+	amdgpu_bo_handle bo;
+	void *cpu;
+	int r;
+
+	size = ALIGN(size, 4096);
+
+	/* mapped uncached, as the per submission IBs were */
+	r = amdgpu_bo_alloc_and_map_raw(device, size, 4096,
+					AMDGPU_GEM_DOMAIN_GTT, 0,
+					AMDGPU_VM_MTYPE_UC,
+					&bo, &cpu, &mc_address, &va_handle);
+	igt_assert_eq(r, 0);
+
+	pool = __amdgpu_ib_pool_create(cpu, mc_address, size, depth,
+				       &pool_ops, NULL);
+	pool->device = device;
+	pool->bo = bo;
+	pool->va_handle = va_handle;
+
+	return pool;
+}
+
+/**
+ * amdgpu_ib_pool_invalidate_bo_lists:
+ * @pool: IB pool
+ *
+ * Drops the cached BO lists. Must be called before freeing any buffer that
+ * was passed as a resource to amdgpu_ib_pool_submit(), as a new buffer could
+ * otherwise alias the stale handle.
+ */
+void amdgpu_ib_pool_invalidate_bo_lists(struct amdgpu_ib_pool *pool)
+{
+	for (int i = 0; i < AMDGPU_IB_POOL_BO_LISTS; i++) {
+		struct amdgpu_ib_pool_bo_list *l = &pool->bo_lists[i];
+
+		if (l->list)
+			igt_assert_eq(amdgpu_bo_list_destroy(l->list), 0);
+		memset(l, 0, sizeof(*l));
+	}
+	pool->next_bo_list = 0;
+}
+
+/**
+ * amdgpu_ib_pool_destroy:
+ * @pool: IB pool
+ *
+ * Waits for all outstanding submissions and releases the pool.
+ */
+void amdgpu_ib_pool_destroy(struct amdgpu_ib_pool *pool)
+{
+	if (!pool)
+		return;
+
+	amdgpu_ib_pool_sync(pool);
+	amdgpu_ib_pool_invalidate_bo_lists(pool);
+
+	igt_debug("ib pool: %"PRIu64" submits, %"PRIu64" ib waits, bo lists %"PRIu64" hits / %"PRIu64" misses\n",
+		  pool->stats.submits, pool->sa.stats.waits,
+		  pool->stats.bo_list_hits, pool->stats.bo_list_misses);
+
+	igt_suballoc_fini(&pool->sa);
+	if (pool->bo)
+		amdgpu_bo_unmap_and_free(pool->bo, pool->va_handle,
+					 pool->mc_address, pool->size);
+	free(pool->fences);
+	free(pool);
+}
+
+/**
+ * amdgpu_ib_pool_submit:
+ * @pool: IB pool
+ * @ip_type: IP block to submit to
+ * @ring_context: ring context carrying the PM4 stream and the resources
+ *
+ * Copies the PM4 stream of @ring_context into an IB from @pool and submits
+ * it without waiting for completion. Once @pool->depth submissions are in
+ * flight the oldest one is waited upon first. The submission status is
+ * stored in @ring_context->err_codes.
+ *
+ * Returns: a sequence number to pass to amdgpu_ib_pool_wait().
+ */
+uint64_t amdgpu_ib_pool_submit(struct amdgpu_ib_pool *pool, unsigned int ip_type,
+			       struct amdgpu_ring_context *ring_context)
+{
+	uint32_t ib_size = ring_context->pm4_dw * sizeof(*ring_context->pm4);
+	struct amdgpu_ib_pool_fence *f;
+	uint64_t offset, seqno;
+	int r;
+
+	igt_assert(!ring_context->user_queue);
+
+	/* keep at most depth submissions (and their fence slots) in flight */
+	if (pool->seqno - pool->completed >= pool->depth)
+		amdgpu_ib_pool_wait(pool, pool->seqno + 1 - pool->depth);
+
+	igt_assert(igt_suballoc_alloc(&pool->sa, ib_size, &offset));
+	memcpy((char *)pool->cpu + offset, ring_context->pm4, ib_size);
+
+	ring_context->ib_info.ib_mc_address = pool->mc_address + offset;
+	ring_context->ib_info.size = ring_context->pm4_dw;
+	ring_context->ib_info.flags = ring_context->secure ? AMDGPU_IB_FLAGS_SECURE : 0;
+
+	ring_context->ibs_request.ip_type = ip_type;
+	ring_context->ibs_request.ring = ring_context->ring_id;
+	ring_context->ibs_request.number_of_ibs = 1;
+	ring_context->ibs_request.ibs = &ring_context->ib_info;
+	ring_context->ibs_request.fence_info.handle = NULL;
+
+	r = pool->ops->submit(pool, ring_context);
+	ring_context->err_codes.err_code_cs_submit = r;
+	/* we allow ECANCELED, ENODATA or -EHWPOISON for good jobs temporally */
+	if (r != -ECANCELED && r != -ENODATA && r != -EHWPOISON)
+		igt_assert_eq(r, 0);
+
+	seqno = ++pool->seqno;
+	f = pool_fence(pool, seqno);
+	memset(f, 0, sizeof(*f));
+	f->fence.ip_type = ip_type;
+	f->fence.ip_instance = 0;
+	f->fence.ring = ring_context->ibs_request.ring;
+	f->fence.context = ring_context->context_handle;
+	f->fence.fence = ring_context->ibs_request.seq_no;
+	/* nothing to wait for if the kernel rejected the job */
+	f->signaled = r != 0;
+
+	igt_suballoc_fence(&pool->sa, seqno);
+	pool->stats.submits++;
+
+	return seqno;
+}
+
+/**
+ * amdgpu_ib_pool_wait:
+ * @pool: IB pool
+ * @seqno: sequence number returned by amdgpu_ib_pool_submit()
+ *
+ * Waits until the submission @seqno has completed.
+ *
+ * Returns: 0 on success.
+ */
+int amdgpu_ib_pool_wait(struct amdgpu_ib_pool *pool, uint64_t seqno)
+{
+	igt_assert(seqno <= pool->seqno);
+
+	/* the fence slots of completed submissions may have been reused */
+	if (seqno <= pool->completed)
+		return 0;
+
+	igt_assert(pool->seqno - seqno < pool->max_fences);
+
+	return pool_fence_wait(pool, seqno, -1) ? 0 : -ETIME;
+}
+
+/**
+ * amdgpu_ib_pool_sync:
+ * @pool: IB pool
+ *
+ * Waits for every submission made through @pool and recycles all IBs.
+ *
+ * Returns: 0 on success.
+ */
+int amdgpu_ib_pool_sync(struct amdgpu_ib_pool *pool)
+{
+	for (uint64_t seqno = pool->completed + 1; seqno <= pool->seqno; seqno++) {
+		int r = amdgpu_ib_pool_wait(pool, seqno);
+
+		if (r)
+			return r;
+	}
+
+	igt_suballoc_retire(&pool->sa);
+
+	return 0;
+}
@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: MIT
+ * Copyright 2026 Advanced Micro Devices, Inc.
+ */
+
+#ifndef __AMD_IB_POOL_H__
+#define __AMD_IB_POOL_H__
+
+#include <amdgpu.h>
+
+#include "igt_suballoc.h"
+
+struct amdgpu_ring_context;
+struct amdgpu_ib_pool;
+
+/*
+ * Backend submitting the IBs and querying their fences. Allows exercising
+ * the pool without a device, see __amdgpu_ib_pool_create().
+ */
+struct amdgpu_ib_pool_ops {
+	/* submits @ring_context->ibs_request, filling in its seq_no */
+	int (*submit)(struct amdgpu_ib_pool *pool,
+		      struct amdgpu_ring_context *ring_context);
+	/* as amdgpu_cs_query_fence_status() */
+	int (*query)(struct amdgpu_ib_pool *pool, struct amdgpu_cs_fence *fence,
+		     uint64_t timeout_ns, uint32_t *expired);
+};
+
+#define AMDGPU_IB_POOL_BO_LISTS 8
+#define AMDGPU_IB_POOL_MAX_RESOURCES 4
+
+struct amdgpu_ib_pool_fence {
+	struct amdgpu_cs_fence fence;
+	bool signaled;
+};
+
+struct amdgpu_ib_pool_bo_list {
+	amdgpu_bo_handle resources[AMDGPU_IB_POOL_MAX_RESOURCES];
+	int res_cnt;
+	amdgpu_bo_list_handle list;
+};
+
+struct amdgpu_ib_pool {
+	amdgpu_device_handle device;
+
+	const struct amdgpu_ib_pool_ops *ops;
+	void *priv;
+
+	/* persistently mapped IB backing store */
+	amdgpu_bo_handle bo;
+	amdgpu_va_handle va_handle;
+	uint64_t mc_address;
+	void *cpu;
+	uint32_t size;
+
+	struct igt_suballoc sa;
+
+	/* fences of submissions in flight, indexed by seqno */
+	struct amdgpu_ib_pool_fence *fences;
+	unsigned int max_fences;
+	uint64_t seqno;
+	uint64_t completed;
+
+	/* maximum number of submissions kept in flight */
+	unsigned int depth;
+
+	struct amdgpu_ib_pool_bo_list bo_lists[AMDGPU_IB_POOL_BO_LISTS];
+	unsigned int next_bo_list;
+
+	struct {
+		uint64_t submits;
+		uint64_t bo_list_hits;
+		uint64_t bo_list_misses;
+	} stats;
+};
+
+struct amdgpu_ib_pool *
+__amdgpu_ib_pool_create(void *cpu, uint64_t mc_address, uint32_t size,
+			unsigned int depth, const struct amdgpu_ib_pool_ops *ops,
+			void *priv);
+struct amdgpu_ib_pool *
+amdgpu_ib_pool_create(amdgpu_device_handle device, uint32_t size, unsigned int depth);
+void amdgpu_ib_pool_destroy(struct amdgpu_ib_pool *pool);
+
+uint64_t amdgpu_ib_pool_submit(struct amdgpu_ib_pool *pool, unsigned int ip_type,
+			       struct amdgpu_ring_context *ring_context);
+int amdgpu_ib_pool_wait(struct amdgpu_ib_pool *pool, uint64_t seqno);
+int amdgpu_ib_pool_sync(struct amdgpu_ib_pool *pool);
+void amdgpu_ib_pool_invalidate_bo_lists(struct amdgpu_ib_pool *pool);
+
+#endif
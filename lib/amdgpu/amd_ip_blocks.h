@@ -203,6 +203,9 @@ struct amdgpu_ring_context {
 	bool user_queue;
 	uint64_t time_out;
 
+	/* optional IB suballocator used instead of a fresh IB per submission */
+	struct amdgpu_ib_pool *ib_pool;
+
 	struct drm_amdgpu_info_uq_fw_areas info;
 };
 
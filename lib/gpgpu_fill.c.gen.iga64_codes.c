@@ -78,3 +78,8 @@ struct iga64_template const iga64_code_gpgpu_fill[] = {
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
 	}}
 };
+
+struct iga64_template_info const iga64_templates_gpgpu_fill_c[] = {
+	{ "gpgpu_fill", iga64_code_gpgpu_fill },
+	{ }
+};
@@ -17,9 +17,6 @@ struct label_entry {
 	uint32_t offset;
 };
 
-#define IGA64_ARG0 0xc0ded000
-#define IGA64_ARG_MASK 0xffffff00
-
 #define SUPPORTED_GEN_VER 1200 /* Support TGL and up */
 
 #define PAGE_SIZE 4096
@@ -56,13 +53,12 @@ __emit_iga64_code(struct gpgpu_shader *shdr, struct iga64_template const *tpls,
 	ptr = shdr->code + shdr->size;
 	memcpy(ptr, tpls->code, 4 * tpls->size);
 
-	/* patch the template */
-	for (int n, i = 0; i < tpls->size; ++i) {
-		if ((ptr[i] & IGA64_ARG_MASK) != IGA64_ARG0)
-			continue;
-		n = ptr[i] - IGA64_ARG0;
-		igt_assert(n < argc);
-		ptr[i] = argv[n];
+	/* patch the template, placeholders were located by the generator */
+	for (int i = 0; i < tpls->num_patches; ++i) {
+		const struct iga64_patch *p = &tpls->patches[i];
+
+		igt_assert(p->arg < argc);
+		ptr[p->dw] = argv[p->arg];
 	}
 
 	shdr->size += tpls->size;
@@ -17,6 +17,8 @@ struct iga64_template const iga64_code_read_a64_d32[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 11, 1 },
 	}},
 	{ .gen_ver = 0, .size = 0, .code = (const uint32_t []) {
 
@@ -37,6 +39,8 @@ struct iga64_template const iga64_code_write_a64_d32[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 3, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 11, 1 }, { 31, 2 },
 	}},
 	{ .gen_ver = 0, .size = 0, .code = (const uint32_t []) {
 
@@ -57,6 +61,8 @@ struct iga64_template const iga64_code_end_system_routine_step_if_eq[] = {
 		0x84000965, 0x80118220, 0x02008010, 0xc0ded003,
 		0x80000965, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 4, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 19, 0 }, { 35, 2 }, { 39, 3 },
 	}},
 	{ .gen_ver = 1270, .size = 52, .code = (const uint32_t []) {
 		0x80000966, 0x80018220, 0x02008000, 0x00008000,
@@ -72,6 +78,8 @@ struct iga64_template const iga64_code_end_system_routine_step_if_eq[] = {
 		0x81000965, 0x80218220, 0x02008020, 0xc0ded003,
 		0x80000965, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 4, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 15, 0 }, { 39, 2 }, { 43, 3 },
 	}},
 	{ .gen_ver = 1260, .size = 48, .code = (const uint32_t []) {
 		0x80000966, 0x80018220, 0x02008000, 0x00008000,
@@ -86,6 +94,8 @@ struct iga64_template const iga64_code_end_system_routine_step_if_eq[] = {
 		0x84000965, 0x80118220, 0x02008010, 0xc0ded003,
 		0x80000965, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 4, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 15, 0 }, { 35, 2 }, { 39, 3 },
 	}},
 	{ .gen_ver = 1250, .size = 52, .code = (const uint32_t []) {
 		0x80000966, 0x80018220, 0x02008000, 0x00008000,
@@ -101,6 +111,8 @@ struct iga64_template const iga64_code_end_system_routine_step_if_eq[] = {
 		0x81000965, 0x80218220, 0x02008020, 0xc0ded003,
 		0x80000965, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 4, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 15, 0 }, { 39, 2 }, { 43, 3 },
 	}},
 	{ .gen_ver = 0, .size = 48, .code = (const uint32_t []) {
 		0x80000166, 0x80018220, 0x02008000, 0x00008000,
@@ -115,6 +127,8 @@ struct iga64_template const iga64_code_end_system_routine_step_if_eq[] = {
 		0x81000165, 0x80218220, 0x02008020, 0xc0ded003,
 		0x80000165, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 4, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 15, 0 }, { 35, 2 }, { 39, 3 },
 	}}
 };
 
@@ -123,26 +137,36 @@ struct iga64_template const iga64_code_end_system_routine[] = {
 		0x80000965, 0x80118220, 0x02008010, 0xc0ded000,
 		0x80000965, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1270, .size = 12, .code = (const uint32_t []) {
 		0x80000965, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000965, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1260, .size = 12, .code = (const uint32_t []) {
 		0x80000965, 0x80118220, 0x02008010, 0xc0ded000,
 		0x80000965, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1250, .size = 12, .code = (const uint32_t []) {
 		0x80000965, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000965, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 0, .size = 12, .code = (const uint32_t []) {
 		0x80000165, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000165, 0x80018220, 0x02008000, 0x7ffffffd,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}}
 };
 
@@ -172,6 +196,8 @@ struct iga64_template const iga64_code_write_on_exception[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 3, 2 }, { 15, 0 }, { 19, 1 }, { 27, 3 }, { 35, 4 },
 	}},
 	{ .gen_ver = 1270, .size = 60, .code = (const uint32_t []) {
 		0x80000061, 0x05054220, 0x00000000, 0xc0ded002,
@@ -189,6 +215,8 @@ struct iga64_template const iga64_code_write_on_exception[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 3, 2 }, { 15, 0 }, { 19, 1 }, { 31, 3 }, { 39, 4 },
 	}},
 	{ .gen_ver = 1260, .size = 56, .code = (const uint32_t []) {
 		0x80000061, 0x05054220, 0x00000000, 0xc0ded002,
@@ -205,6 +233,8 @@ struct iga64_template const iga64_code_write_on_exception[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 3, 2 }, { 15, 0 }, { 19, 1 }, { 31, 3 }, { 39, 4 },
 	}},
 	{ .gen_ver = 1250, .size = 60, .code = (const uint32_t []) {
 		0x80000061, 0x05054220, 0x00000000, 0xc0ded002,
@@ -222,6 +252,8 @@ struct iga64_template const iga64_code_write_on_exception[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 3, 2 }, { 15, 0 }, { 19, 1 }, { 31, 3 }, { 39, 4 },
 	}},
 	{ .gen_ver = 0, .size = 56, .code = (const uint32_t []) {
 		0x80000061, 0x05054220, 0x00000000, 0xc0ded002,
@@ -238,6 +270,8 @@ struct iga64_template const iga64_code_write_on_exception[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 3, 2 }, { 15, 0 }, { 19, 1 }, { 31, 3 }, { 39, 4 },
 	}}
 };
 
@@ -245,22 +279,32 @@ struct iga64_template const iga64_code_set_exception[] = {
 	{ .gen_ver = 2000, .size = 8, .code = (const uint32_t []) {
 		0x80000966, 0x80118220, 0x02008010, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1270, .size = 8, .code = (const uint32_t []) {
 		0x80000966, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1260, .size = 8, .code = (const uint32_t []) {
 		0x80000966, 0x80118220, 0x02008010, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1250, .size = 8, .code = (const uint32_t []) {
 		0x80000966, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 0, .size = 8, .code = (const uint32_t []) {
 		0x80000166, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}}
 };
 
@@ -268,22 +312,32 @@ struct iga64_template const iga64_code_clear_exception[] = {
 	{ .gen_ver = 2000, .size = 8, .code = (const uint32_t []) {
 		0x80000965, 0x80118220, 0x02008010, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1270, .size = 8, .code = (const uint32_t []) {
 		0x80000965, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1260, .size = 8, .code = (const uint32_t []) {
 		0x80000965, 0x80118220, 0x02008010, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1250, .size = 8, .code = (const uint32_t []) {
 		0x80000965, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 0, .size = 8, .code = (const uint32_t []) {
 		0x80000165, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}}
 };
 
@@ -299,6 +353,8 @@ struct iga64_template const iga64_code_media_block_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 3, 1 }, { 19, 0 },
 	}},
 	{ .gen_ver = 1270, .size = 48, .code = (const uint32_t []) {
 		0x80000061, 0x05054220, 0x00000000, 0xc0ded001,
@@ -313,6 +369,8 @@ struct iga64_template const iga64_code_media_block_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 3, 1 }, { 19, 0 },
 	}},
 	{ .gen_ver = 1260, .size = 44, .code = (const uint32_t []) {
 		0x80000061, 0x05054220, 0x00000000, 0xc0ded001,
@@ -326,6 +384,8 @@ struct iga64_template const iga64_code_media_block_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 3, 1 }, { 19, 0 },
 	}},
 	{ .gen_ver = 1250, .size = 48, .code = (const uint32_t []) {
 		0x80000061, 0x05054220, 0x00000000, 0xc0ded001,
@@ -340,6 +400,8 @@ struct iga64_template const iga64_code_media_block_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 3, 1 }, { 19, 0 },
 	}},
 	{ .gen_ver = 0, .size = 44, .code = (const uint32_t []) {
 		0x80000061, 0x05054220, 0x00000000, 0xc0ded001,
@@ -353,6 +415,8 @@ struct iga64_template const iga64_code_media_block_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 3, 1 }, { 19, 0 },
 	}}
 };
 
@@ -360,22 +424,32 @@ struct iga64_template const iga64_code_write_aip[] = {
 	{ .gen_ver = 2000, .size = 8, .code = (const uint32_t []) {
 		0x80000940, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1270, .size = 8, .code = (const uint32_t []) {
 		0x80000940, 0x80418220, 0x02008040, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1260, .size = 8, .code = (const uint32_t []) {
 		0x80000940, 0x80218220, 0x02008020, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 1250, .size = 8, .code = (const uint32_t []) {
 		0x80000940, 0x80418220, 0x02008040, 0xc0ded000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}},
 	{ .gen_ver = 0, .size = 8, .code = (const uint32_t []) {
 		0x80000140, 0x80418220, 0x02008040, 0xc0ded000,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 3, 0 },
 	}}
 };
 
@@ -391,6 +465,8 @@ struct iga64_template const iga64_code_media_block_write_aip[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 19, 0 },
 	}},
 	{ .gen_ver = 1270, .size = 48, .code = (const uint32_t []) {
 		0x80000961, 0x05050220, 0x00008040, 0x00000000,
@@ -405,6 +481,8 @@ struct iga64_template const iga64_code_media_block_write_aip[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 19, 0 },
 	}},
 	{ .gen_ver = 1260, .size = 44, .code = (const uint32_t []) {
 		0x80000961, 0x05050220, 0x00008020, 0x00000000,
@@ -418,6 +496,8 @@ struct iga64_template const iga64_code_media_block_write_aip[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 19, 0 },
 	}},
 	{ .gen_ver = 1250, .size = 48, .code = (const uint32_t []) {
 		0x80000961, 0x05050220, 0x00008040, 0x00000000,
@@ -432,6 +512,8 @@ struct iga64_template const iga64_code_media_block_write_aip[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 19, 0 },
 	}},
 	{ .gen_ver = 0, .size = 44, .code = (const uint32_t []) {
 		0x80000161, 0x05050220, 0x00008040, 0x00000000,
@@ -445,6 +527,8 @@ struct iga64_template const iga64_code_media_block_write_aip[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 19, 0 },
 	}}
 };
 
@@ -463,6 +547,8 @@ struct iga64_template const iga64_code_common_target_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 7, 1 }, { 11, 2 }, { 15, 3 }, { 19, 4 }, { 31, 0 },
 	}},
 	{ .gen_ver = 1270, .size = 56, .code = (const uint32_t []) {
 		0x80040061, 0x1f054220, 0x00000000, 0x00000000,
@@ -479,6 +565,8 @@ struct iga64_template const iga64_code_common_target_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 7, 1 }, { 11, 2 }, { 15, 3 }, { 19, 4 }, { 27, 0 },
 	}},
 	{ .gen_ver = 1260, .size = 52, .code = (const uint32_t []) {
 		0x80100061, 0x1f054220, 0x00000000, 0x00000000,
@@ -494,6 +582,8 @@ struct iga64_template const iga64_code_common_target_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 7, 1 }, { 11, 2 }, { 15, 3 }, { 19, 4 }, { 27, 0 },
 	}},
 	{ .gen_ver = 1250, .size = 56, .code = (const uint32_t []) {
 		0x80040061, 0x1f054220, 0x00000000, 0x00000000,
@@ -510,6 +600,8 @@ struct iga64_template const iga64_code_common_target_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 7, 1 }, { 11, 2 }, { 15, 3 }, { 19, 4 }, { 27, 0 },
 	}},
 	{ .gen_ver = 0, .size = 52, .code = (const uint32_t []) {
 		0x80040061, 0x1f054220, 0x00000000, 0x00000000,
@@ -525,6 +617,8 @@ struct iga64_template const iga64_code_common_target_write[] = {
 		0x80000001, 0x00010000, 0x20000000, 0x00000000,
 		0x80000001, 0x00010000, 0x30000000, 0x00000000,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 5, .patches = (const struct iga64_patch []) {
+		{ 7, 1 }, { 11, 2 }, { 15, 3 }, { 19, 4 }, { 27, 0 },
 	}}
 };
 
@@ -535,6 +629,8 @@ struct iga64_template const iga64_code_inc_r40_jump_neq[] = {
 		0x80001a70, 0x00018220, 0x22002804, 0xc0ded000,
 		0x84000020, 0x00004000, 0x00000000, 0xffffffd0,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 11, 0 },
 	}},
 	{ .gen_ver = 1270, .size = 20, .code = (const uint32_t []) {
 		0x80000040, 0x28058220, 0x02002804, 0x00000001,
@@ -542,6 +638,8 @@ struct iga64_template const iga64_code_inc_r40_jump_neq[] = {
 		0x80001a70, 0x00018220, 0x22002804, 0xc0ded000,
 		0x81000020, 0x00004000, 0x00000000, 0xffffffd0,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 11, 0 },
 	}},
 	{ .gen_ver = 1260, .size = 20, .code = (const uint32_t []) {
 		0x80000040, 0x28058220, 0x02002804, 0x00000001,
@@ -549,6 +647,8 @@ struct iga64_template const iga64_code_inc_r40_jump_neq[] = {
 		0x80001a70, 0x00018220, 0x22002804, 0xc0ded000,
 		0x84000020, 0x00004000, 0x00000000, 0xffffffd0,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 11, 0 },
 	}},
 	{ .gen_ver = 1250, .size = 20, .code = (const uint32_t []) {
 		0x80000040, 0x28058220, 0x02002804, 0x00000001,
@@ -556,6 +656,8 @@ struct iga64_template const iga64_code_inc_r40_jump_neq[] = {
 		0x80001a70, 0x00018220, 0x22002804, 0xc0ded000,
 		0x81000020, 0x00004000, 0x00000000, 0xffffffd0,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 11, 0 },
 	}},
 	{ .gen_ver = 0, .size = 20, .code = (const uint32_t []) {
 		0x80000040, 0x28058220, 0x02002804, 0x00000001,
@@ -563,6 +665,8 @@ struct iga64_template const iga64_code_inc_r40_jump_neq[] = {
 		0x80000270, 0x00018220, 0x22002804, 0xc0ded000,
 		0x81000120, 0x00004000, 0x00000000, 0xffffffd0,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 1, .patches = (const struct iga64_patch []) {
+		{ 11, 0 },
 	}}
 };
 
@@ -588,6 +692,8 @@ struct iga64_template const iga64_code_jump_dw_neq[] = {
 		0x80008070, 0x00018220, 0x22001f04, 0xc0ded001,
 		0x84000020, 0x00004000, 0x00000000, 0xffffff90,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 11, 0 }, { 27, 1 },
 	}},
 	{ .gen_ver = 1270, .size = 40, .code = (const uint32_t []) {
 		0x80030061, 0x1e054220, 0x00000000, 0x00000000,
@@ -600,6 +706,8 @@ struct iga64_template const iga64_code_jump_dw_neq[] = {
 		0x80002070, 0x00018220, 0x22001f04, 0xc0ded001,
 		0x81000020, 0x00004000, 0x00000000, 0xffffff80,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 31, 1 },
 	}},
 	{ .gen_ver = 1260, .size = 36, .code = (const uint32_t []) {
 		0x800c0061, 0x1e054220, 0x00000000, 0x00000000,
@@ -611,6 +719,8 @@ struct iga64_template const iga64_code_jump_dw_neq[] = {
 		0x80008070, 0x00018220, 0x22001f04, 0xc0ded001,
 		0x84000020, 0x00004000, 0x00000000, 0xffffff90,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 27, 1 },
 	}},
 	{ .gen_ver = 1250, .size = 40, .code = (const uint32_t []) {
 		0x80030061, 0x1e054220, 0x00000000, 0x00000000,
@@ -623,6 +733,8 @@ struct iga64_template const iga64_code_jump_dw_neq[] = {
 		0x80002070, 0x00018220, 0x22001f04, 0xc0ded001,
 		0x81000020, 0x00004000, 0x00000000, 0xffffff80,
 		0x80000901, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 31, 1 },
 	}},
 	{ .gen_ver = 0, .size = 36, .code = (const uint32_t []) {
 		0x80030061, 0x1e054220, 0x00000000, 0x00000000,
@@ -634,6 +746,8 @@ struct iga64_template const iga64_code_jump_dw_neq[] = {
 		0x80002070, 0x00018220, 0x22001f04, 0xc0ded001,
 		0x81000120, 0x00004000, 0x00000000, 0xffffff90,
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
+	}, .num_patches = 2, .patches = (const struct iga64_patch []) {
+		{ 7, 0 }, { 27, 1 },
 	}}
 };
 
@@ -719,3 +833,27 @@ struct iga64_template const iga64_code_sync_host[] = {
 		0x80000101, 0x00010000, 0x00000000, 0x00000000,
 	}}
 };
+
+struct iga64_template_info const iga64_templates_gpgpu_shader_c[] = {
+	{ "read_a64_d32", iga64_code_read_a64_d32 },
+	{ "write_a64_d32", iga64_code_write_a64_d32 },
+	{ "end_system_routine_step_if_eq", iga64_code_end_system_routine_step_if_eq },
+	{ "end_system_routine", iga64_code_end_system_routine },
+	{ "breakpoint_suppress", iga64_code_breakpoint_suppress },
+	{ "write_on_exception", iga64_code_write_on_exception },
+	{ "set_exception", iga64_code_set_exception },
+	{ "clear_exception", iga64_code_clear_exception },
+	{ "media_block_write", iga64_code_media_block_write },
+	{ "write_aip", iga64_code_write_aip },
+	{ "media_block_write_aip", iga64_code_media_block_write_aip },
+	{ "common_target_write", iga64_code_common_target_write },
+	{ "inc_r40_jump_neq", iga64_code_inc_r40_jump_neq },
+	{ "clear_r40", iga64_code_clear_r40 },
+	{ "jump_dw_neq", iga64_code_jump_dw_neq },
+	{ "jump", iga64_code_jump },
+	{ "eot", iga64_code_eot },
+	{ "eot_vrt", iga64_code_eot_vrt },
+	{ "nop", iga64_code_nop },
+	{ "sync_host", iga64_code_sync_host },
+	{ }
+};
@@ -31,12 +31,32 @@ struct gpgpu_shader {
 	enum gpgpu_shader_vrt_modes vrt;
 };
 
+/* Magic values encoding template args, must match scripts/generate_iga64_codes */
+#define IGA64_ARG0 0xc0ded000
+#define IGA64_ARG_MASK 0xffffff00
+
+struct iga64_patch {
+	uint16_t dw;
+	uint16_t arg;
+};
+
 struct iga64_template {
 	uint32_t gen_ver;
 	uint32_t size;
 	const uint32_t *code;
+	/* argument placeholders in @code, located at generation time */
+	uint32_t num_patches;
+	const struct iga64_patch *patches;
 };
 
+struct iga64_template_info {
+	const char *name;
+	const struct iga64_template *tpls;
+};
+
+extern struct iga64_template_info const iga64_templates_gpgpu_shader_c[];
+extern struct iga64_template_info const iga64_templates_gpgpu_fill_c[];
+
 #pragma GCC diagnostic ignored "-Wnested-externs"
 
 uint32_t
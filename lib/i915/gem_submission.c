@@ -37,6 +37,7 @@
 #include "igt_core.h"
 #include "igt_gt.h"
 #include "igt_params.h"
+#include "igt_probe_cache.h"
 #include "igt_sysfs.h"
 #include "intel_chipset.h"
 #include "intel_reg.h"
@@ -54,13 +55,7 @@
  * different methods: legacy ringbuffer submission, execlists, GuC submission.
  */
 
-/**
- * gem_submission_method:
- * @fd: open i915 drm file descriptor
- *
- * Returns: Submission method bitmap.
- */
-unsigned gem_submission_method(int fd)
+static uint64_t probe_submission_method(int fd, const void *data)
 {
 	const int gen = intel_gen(intel_get_drm_devid(fd));
 	unsigned method = GEM_SUBMISSION_RINGBUF;
@@ -82,6 +77,20 @@ unsigned gem_submission_method(int fd)
 	return method;
 }
 
+/**
+ * gem_submission_method:
+ * @fd: open i915 drm file descriptor
+ *
+ * The probe is shared with other processes through igt_probe_cache().
+ *
+ * Returns: Submission method bitmap.
+ */
+unsigned gem_submission_method(int fd)
+{
+	return igt_probe_cache(fd, "submission-method",
+			       probe_submission_method, NULL);
+}
+
 /**
  * gem_submission_print_method:
  * @fd: open i915 drm file descriptor
@@ -181,13 +190,7 @@ void gem_test_all_engines(int i915)
 	close(i915);
 }
 
-/**
- * gem_cmdparser_version:
- * @i915: open i915 drm file descriptor
- *
- * Returns the command parser version
- */
-int gem_cmdparser_version(int i915)
+static uint64_t probe_cmdparser_version(int i915, const void *data)
 {
 	int version = 0;
 	drm_i915_getparam_t gp = {
@@ -199,6 +202,19 @@ int gem_cmdparser_version(int i915)
 	return version;
 }
 
+/**
+ * gem_cmdparser_version:
+ * @i915: open i915 drm file descriptor
+ *
+ * Returns the command parser version. The probe is shared with other
+ * processes through igt_probe_cache(), and so with gem_engine_has_cmdparser().
+ */
+int gem_cmdparser_version(int i915)
+{
+	return (int)igt_probe_cache(i915, "cmdparser-version",
+				    probe_cmdparser_version, NULL);
+}
+
 /**
  * gem_engine_has_cmdparser:
  * @i915: open i915 drm file descriptor
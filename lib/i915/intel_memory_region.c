@@ -40,6 +40,7 @@
 #include "igt_dummyload.h"
 #include "igt_gt.h"
 #include "igt_params.h"
+#include "igt_probe_cache.h"
 #include "igt_sysfs.h"
 #include "intel_chipset.h"
 #include "igt_collection.h"
@@ -638,29 +639,14 @@ static struct cache_entry *find_entry_unlocked(enum cache_entry_type type,
 	return NULL;
 }
 
-/**
- * gem_detect_min_start_offset_for_region:
- * @i915: drm fd
- * @region: memory region
- *
- * Returns: minimum start offset at which kernel allows placing objects
- *          for memory region.
- */
-uint64_t gem_detect_min_start_offset_for_region(int i915, uint32_t region)
+static uint64_t probe_min_start_offset(int i915, const void *data)
 {
 	struct drm_i915_gem_exec_object2 obj;
 	struct drm_i915_gem_execbuffer2 eb;
+	uint32_t region = *(const uint32_t *)data;
 	uint64_t start_offset = 0;
 	uint64_t bb_size = PAGE_SIZE;
 	uint32_t *batch, ctx = 0;
-	uint16_t devid = intel_get_drm_devid(i915);
-	struct cache_entry *entry, *newentry;
-
-	pthread_mutex_lock(&cache_mutex);
-	entry = find_entry_unlocked(MIN_START_OFFSET, devid, region, 0);
-	if (entry)
-		goto out;
-	pthread_mutex_unlock(&cache_mutex);
 
 	/* Use separate context if possible to avoid offset overlapping */
 	__gem_context_create(i915, &ctx);
@@ -699,6 +685,36 @@ uint64_t gem_detect_min_start_offset_for_region(int i915, uint32_t region)
 	if (ctx)
 		gem_context_destroy(i915, ctx);
 
+	return start_offset;
+}
+
+/**
+ * gem_detect_min_start_offset_for_region:
+ * @i915: drm fd
+ * @region: memory region
+ *
+ * The probe is shared with other processes through igt_probe_cache().
+ *
+ * Returns: minimum start offset at which kernel allows placing objects
+ *          for memory region.
+ */
+uint64_t gem_detect_min_start_offset_for_region(int i915, uint32_t region)
+{
+	uint64_t start_offset;
+	uint16_t devid = intel_get_drm_devid(i915);
+	struct cache_entry *entry, *newentry;
+	char name[64];
+
+	pthread_mutex_lock(&cache_mutex);
+	entry = find_entry_unlocked(MIN_START_OFFSET, devid, region, 0);
+	if (entry)
+		goto out;
+	pthread_mutex_unlock(&cache_mutex);
+
+	snprintf(name, sizeof(name), "min-start-offset-0x%x", region);
+	start_offset = igt_probe_cache(i915, name, probe_min_start_offset,
+				       &region);
+
 	newentry = malloc(sizeof(*newentry));
 	if (!newentry)
 		return start_offset;
@@ -781,32 +797,19 @@ out:
 	return entry->safe_start_offset;
 }
 
-/**
- * gem_detect_min_alignment_for_regions:
- * @i915: drm fd
- * @region1: first region
- * @region2: second region
- *
- * Returns: minimum alignment which must be used when objects from @region1 and
- * @region2 are going to interact.
- */
-uint64_t gem_detect_min_alignment_for_regions(int i915,
-					      uint32_t region1,
-					      uint32_t region2)
+struct region_pair {
+	uint32_t region1;
+	uint32_t region2;
+};
+
+static uint64_t probe_min_alignment(int i915, const void *data)
 {
 	struct drm_i915_gem_exec_object2 obj[2];
 	struct drm_i915_gem_execbuffer2 eb;
+	const struct region_pair *regions = data;
 	uint64_t min_alignment = PAGE_SIZE;
 	uint64_t bb_size = PAGE_SIZE, obj_size = PAGE_SIZE;
 	uint32_t *batch, ctx = 0;
-	uint16_t devid = intel_get_drm_devid(i915);
-	struct cache_entry *entry, *newentry;
-
-	pthread_mutex_lock(&cache_mutex);
-	entry = find_entry_unlocked(MIN_ALIGNMENT, devid, region1, region2);
-	if (entry)
-		goto out;
-	pthread_mutex_unlock(&cache_mutex);
 
 	/* Use separate context if possible to avoid offset overlapping */
 	__gem_context_create(i915, &ctx);
@@ -820,7 +823,7 @@ uint64_t gem_detect_min_alignment_for_regions(int i915,
 	eb.flags = I915_EXEC_BATCH_FIRST | I915_EXEC_DEFAULT;
 	eb.rsvd1 = ctx;
 	igt_assert(__gem_create_in_memory_regions(i915, &obj[0].handle,
-						  &bb_size, region1) == 0);
+						  &bb_size, regions->region1) == 0);
 
 	batch = gem_mmap__device_coherent(i915, obj[0].handle, 0, bb_size,
 					  PROT_WRITE);
@@ -828,12 +831,14 @@ uint64_t gem_detect_min_alignment_for_regions(int i915,
 	munmap(batch, bb_size);
 
 	obj[0].flags = EXEC_OBJECT_PINNED;
-	obj[0].offset = gem_detect_min_start_offset_for_region(i915, region1);
+	obj[0].offset = gem_detect_min_start_offset_for_region(i915,
+							       regions->region1);
 
 	/* Find appropriate alignment of object */
 	igt_assert(__gem_create_in_memory_regions(i915, &obj[1].handle,
-						  &obj_size, region2) == 0);
-	obj[1].handle = gem_create_in_memory_regions(i915, PAGE_SIZE, region2);
+						  &obj_size, regions->region2) == 0);
+	obj[1].handle = gem_create_in_memory_regions(i915, PAGE_SIZE,
+						     regions->region2);
 	obj[1].flags = EXEC_OBJECT_PINNED;
 	while (1) {
 		obj[1].offset = ALIGN(obj[0].offset + bb_size, min_alignment);
@@ -850,6 +855,41 @@ uint64_t gem_detect_min_alignment_for_regions(int i915,
 	if (ctx)
 		gem_context_destroy(i915, ctx);
 
+	return min_alignment;
+}
+
+/**
+ * gem_detect_min_alignment_for_regions:
+ * @i915: drm fd
+ * @region1: first region
+ * @region2: second region
+ *
+ * The probe is shared with other processes through igt_probe_cache().
+ *
+ * Returns: minimum alignment which must be used when objects from @region1 and
+ * @region2 are going to interact.
+ */
+uint64_t gem_detect_min_alignment_for_regions(int i915,
+					      uint32_t region1,
+					      uint32_t region2)
+{
+	struct region_pair regions = { region1, region2 };
+	uint64_t min_alignment;
+	uint16_t devid = intel_get_drm_devid(i915);
+	struct cache_entry *entry, *newentry;
+	char name[64];
+
+	pthread_mutex_lock(&cache_mutex);
+	entry = find_entry_unlocked(MIN_ALIGNMENT, devid, region1, region2);
+	if (entry)
+		goto out;
+	pthread_mutex_unlock(&cache_mutex);
+
+	snprintf(name, sizeof(name), "min-alignment-0x%x-0x%x",
+		 region1, region2);
+	min_alignment = igt_probe_cache(i915, name, probe_min_alignment,
+					&regions);
+
 	newentry = malloc(sizeof(*newentry));
 	if (!newentry)
 		return min_alignment;
@@ -52,6 +52,9 @@ enum intel_perf_record_type {
 
 	/* intel_perf_record_timestamp_correlation */
 	INTEL_PERF_RECORD_TYPE_TIMESTAMP_CORRELATION,
+
+	/* intel_perf_record_marker */
+	INTEL_PERF_RECORD_TYPE_MARKER,
 };
 
 /* This structure cannot ever change. */
@@ -111,6 +114,34 @@ struct intel_perf_record_timestamp_correlation {
 	uint64_t gpu_timestamp;
 } __attribute__((packed));
 
+enum intel_perf_marker_type {
+	INTEL_PERF_MARKER_LABEL = 0,
+	INTEL_PERF_MARKER_BEGIN,
+	INTEL_PERF_MARKER_END,
+};
+
+#define INTEL_PERF_MARKER_LABEL_SIZE (64)
+
+/* User annotation (phase begin/end or a plain label), timestamped
+ * by the recorder when it receives it and written inline with the OA
+ * reports.
+ */
+struct intel_perf_record_marker {
+	/* In the correlation clock */
+	uint64_t cpu_timestamp;
+
+	/* Engine timestamp associated with the OA unit */
+	uint64_t gpu_timestamp;
+
+	/* enum intel_perf_marker_type */
+	uint32_t type;
+
+	uint32_t pad;
+
+	/* NUL terminated */
+	char label[INTEL_PERF_MARKER_LABEL_SIZE];
+} __attribute__((packed));
+
 #ifdef __cplusplus
 };
 #endif
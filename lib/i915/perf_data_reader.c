@@ -103,6 +103,25 @@ append_timestamp_correlation(struct intel_perf_data_reader *reader,
 	reader->correlations[reader->n_correlations++] = corr;
 }
 
+static void
+append_marker(struct intel_perf_data_reader *reader,
+	      const struct intel_perf_record_marker *marker)
+{
+	if (reader->n_markers >= reader->n_allocated_markers) {
+		reader->n_allocated_markers = MAX(100, 2 * reader->n_allocated_markers);
+		reader->markers =
+			(struct intel_perf_marker_item *)
+			realloc((void *) reader->markers,
+				reader->n_allocated_markers *
+				sizeof(*reader->markers));
+		assert(reader->markers);
+	}
+
+	reader->markers[reader->n_markers].marker = marker;
+	reader->markers[reader->n_markers].record = reader->n_records;
+	reader->n_markers++;
+}
+
 static struct intel_perf_metric_set *
 find_metric_set(struct intel_perf *perf, const char *symbol_name)
 {
@@ -167,6 +186,14 @@ parse_data(struct intel_perf_data_reader *reader)
 						     (const struct intel_perf_record_timestamp_correlation *) (header + 1));
 			break;
 		}
+
+		case INTEL_PERF_RECORD_TYPE_MARKER: {
+			assert(header->size == (sizeof(struct intel_perf_record_marker) +
+						sizeof(*header)));
+			append_marker(reader,
+				      (const struct intel_perf_record_marker *) (header + 1));
+			break;
+		}
 		}
 
 		iter += header->size;
@@ -382,5 +409,6 @@ intel_perf_data_reader_fini(struct intel_perf_data_reader *reader)
 	free(reader->records);
 	free(reader->timelines);
 	free(reader->correlations);
+	free(reader->markers);
 	munmap((void *)reader->mmap_data, reader->mmap_size);
 }
@@ -53,6 +53,15 @@ struct intel_perf_timeline_item {
 	void *user_data;
 };
 
+struct intel_perf_marker_item {
+	const struct intel_perf_record_marker *marker;
+
+	/* Offset into intel_perf_data_reader.records of the first OA report
+	 * following the marker in the recording.
+	 */
+	uint32_t record;
+};
+
 struct intel_perf_data_reader {
 	/* Array of pointers into the mmapped i915 perf file. */
 	const struct drm_i915_perf_record_header **records;
@@ -69,6 +78,11 @@ struct intel_perf_data_reader {
 	uint32_t n_correlations;
 	uint32_t n_allocated_correlations;
 
+	/**/
+	struct intel_perf_marker_item *markers;
+	uint32_t n_markers;
+	uint32_t n_allocated_markers;
+
 	struct {
 		uint64_t gpu_ts_begin;
 		uint64_t gpu_ts_end;
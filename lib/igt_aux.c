@@ -34,6 +34,7 @@
 #include <limits.h> // PATH_MAX
 #include <pwd.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <sys/ioctl.h>
 #include <string.h>
 #include <sys/mman.h>
@@ -53,12 +54,6 @@
 #include <assert.h>
 #include <grp.h>
 
-#ifdef HAVE_LIBPROCPS
-#  include <proc/readproc.h>
-#elif HAVE_LIBPROC2
-#  include <libproc2/pids.h>
-#endif
-
 #include <dirent.h>
 #ifdef __linux__
 #  include <libudev.h>
@@ -71,6 +66,7 @@
 #include "igt_debugfs.h"
 #include "igt_gt.h"
 #include "igt_params.h"
+#include "igt_proc.h"
 #include "igt_rand.h"
 #include "igt_sysfs.h"
 #include "config.h"
@@ -1285,95 +1281,6 @@ void igt_unlock_mem(void)
 	locked_mem = NULL;
 }
 
-struct igt_process {
-#ifdef HAVE_LIBPROCPS
-	PROCTAB * proc;
-	proc_t *proc_info;
-#elif HAVE_LIBPROC2
-	struct pids_info *info;
-	struct pids_stack *stack;
-#endif
-	pid_t tid;
-	pid_t euid;
-	pid_t egid;
-	char *comm;
-};
-
-static void open_process(struct igt_process *prcs)
-{
-#ifdef HAVE_LIBPROCPS
-	prcs->proc = openproc(PROC_FILLCOM | PROC_FILLSTAT | PROC_FILLARG);
-	igt_assert_f(prcs->proc != NULL, "procps open failed\n");
-	prcs->proc_info = NULL;
-#elif HAVE_LIBPROC2
-	enum pids_item Items[] = { PIDS_ID_PID, PIDS_ID_EUID, PIDS_ID_EGID, PIDS_CMD };
-	int err;
-
-	prcs->info = NULL;
-	err = procps_pids_new(&prcs->info, Items, 4);
-	igt_assert_f(err >= 0, "procps-ng open failed\n");
-	prcs->stack = NULL;
-#endif
-	prcs->tid = 0;
-	prcs->comm = NULL;
-}
-
-static void close_process(struct igt_process *prcs)
-{
-#ifdef HAVE_LIBPROCPS
-	if (prcs->proc_info)
-		freeproc(prcs->proc_info);
-
-	closeproc(prcs->proc);
-	prcs->proc_info = NULL;
-	prcs->proc = NULL;
-#elif HAVE_LIBPROC2
-	procps_pids_unref(&prcs->info);
-	prcs->info = NULL;
-#endif
-	prcs->tid = 0;
-	prcs->comm = NULL;
-}
-
-static bool get_process_ids(struct igt_process *prcs)
-{
-#ifdef HAVE_LIBPROCPS
-	if (prcs->proc_info)
-		freeproc(prcs->proc_info);
-
-	prcs->tid = 0;
-	prcs->comm = NULL;
-	prcs->proc_info = readproc(prcs->proc, NULL);
-
-	if (prcs->proc_info) {
-		prcs->tid = prcs->proc_info->tid;
-		prcs->euid = prcs->proc_info->euid;
-		prcs->egid = prcs->proc_info->egid;
-		prcs->comm = prcs->proc_info->cmd;
-	}
-#elif HAVE_LIBPROC2
-	enum rel_items { EU_PID, EU_EUID, EU_EGID, EU_CMD }; // order at open
-
-	prcs->tid = 0;
-	prcs->comm = NULL;
-	prcs->stack = procps_pids_get(prcs->info, PIDS_FETCH_TASKS_ONLY);
-	if (prcs->stack) {
-#if defined(HAVE_LIBPROC2_POST_4_0_5_API)
-		prcs->tid = PIDS_VAL(EU_PID, s_int, prcs->stack);
-		prcs->euid = PIDS_VAL(EU_EUID, s_int, prcs->stack);
-		prcs->egid = PIDS_VAL(EU_EGID, s_int, prcs->stack);
-		prcs->comm = PIDS_VAL(EU_CMD, str, prcs->stack);
-#else
-		prcs->tid = PIDS_VAL(EU_PID, s_int, prcs->stack, prcs->info);
-		prcs->euid = PIDS_VAL(EU_EUID, s_int, prcs->stack, prcs->info);
-		prcs->egid = PIDS_VAL(EU_EGID, s_int, prcs->stack, prcs->info);
-		prcs->comm = PIDS_VAL(EU_CMD, str, prcs->stack, prcs->info);
-#endif
-	}
-#endif
-	return prcs->tid != 0;
-}
-
 /**
  * igt_is_mountpoint() - Check if a path is a mounted filesystem
  * @path: Root directory to test
@@ -1416,26 +1323,17 @@ bool igt_is_mountpoint(const char *path)
  */
 int igt_is_process_running(const char *comm)
 {
-	struct igt_process pc;
-	bool found = false;
-	int len;
+	igt_proc_snapshot_t *snap;
+	bool found;
 
-	if (!comm)
-		return false;
-	len = strlen(comm);
-	if (!len)
+	if (!comm || !*comm)
 		return false;
 
-	open_process(&pc);
-	while (get_process_ids(&pc)) {
-		if (strlen(pc.comm) != len)
-			continue;
-		if (!strncasecmp(pc.comm, comm, len)) {
-			found = true;
-			break;
-		}
-	}
-	close_process(&pc);
+	snap = igt_proc_snapshot_create(NULL);
+	igt_assert_f(snap, "Failed to list processes\n");
+
+	found = igt_proc_find_comm(snap, comm);
+	igt_proc_snapshot_destroy(snap);
 
 	return found;
 }
@@ -1454,27 +1352,20 @@ int igt_is_process_running(const char *comm)
  */
 int igt_terminate_process(int sig, const char *comm)
 {
-	struct igt_process pc;
+	igt_proc_snapshot_t *snap;
+	igt_proc_t *proc;
 	int err = 0;
-	int len;
 
-	if (!comm)
-		return 0;
-	len = strlen(comm);
-	if (!len)
+	if (!comm || !*comm)
 		return 0;
 
-	open_process(&pc);
-	while (get_process_ids(&pc)) {
-		if (strlen(pc.comm) != len)
-			continue;
-		if (!strncasecmp(pc.comm, comm, len)) {
-			if (kill(pc.tid, sig) < 0)
-				err = -errno;
-			break;
-		}
-	}
-	close_process(&pc);
+	snap = igt_proc_snapshot_create(NULL);
+	igt_assert_f(snap, "Failed to list processes\n");
+
+	proc = igt_proc_find_comm(snap, comm);
+	if (proc && kill(proc->pid, sig) < 0)
+		err = -errno;
+	igt_proc_snapshot_destroy(snap);
 
 	return err;
 }
@@ -1557,63 +1448,78 @@ igt_show_stat(const pid_t tid, const char *cmd, int *state, const char *fn)
 	++*state;
 }
 
-static void
-__igt_lsof_fds(const pid_t tid, const char *cmd, int *state, char *proc_path, const char *dir)
+/*
+ * Returns the major shared by all the device nodes in @dir, or -1 if it
+ * holds anything else, so that the fds of other files can be skipped
+ * without reading their links.
+ */
+static int __igt_dir_device_major(const char *dir)
 {
-	/* default fds or kernel threads */
-	static const char *default_fds[] = { "/dev/pts", "/dev/null" };
 	struct dirent *d;
 	struct stat st;
-	char path[PATH_MAX];
-	char *fd_lnk;
+	int dev_major = -1;
 	DIR *dp;
 
-	dp = opendir(proc_path);
+	dp = opendir(dir);
 	if (!dp)
-		return;
+		return -1;
 
-again:
 	while ((d = readdir(dp))) {
-		char *copy_fd_lnk;
-		char *dirn;
-
-		unsigned int i;
-		ssize_t read;
-
 		if (*d->d_name == '.')
 			continue;
 
-		memset(path, 0, sizeof(path));
-		snprintf(path, sizeof(path), "%s/%s", proc_path, d->d_name);
+		if (fstatat(dirfd(dp), d->d_name, &st, AT_SYMLINK_NOFOLLOW))
+			continue;
 
-		if (lstat(path, &st) == -1)
+		/* fd links are resolved, they never point to symlinks */
+		if (S_ISDIR(st.st_mode) || S_ISLNK(st.st_mode))
 			continue;
 
-		fd_lnk = malloc(st.st_size + 1);
+		if ((!S_ISCHR(st.st_mode) && !S_ISBLK(st.st_mode)) ||
+		    (dev_major >= 0 && dev_major != major(st.st_rdev))) {
+			dev_major = -1;
+			break;
+		}
 
-		igt_assert((read = readlink(path, fd_lnk, st.st_size + 1)));
-		fd_lnk[read] = '\0';
+		dev_major = major(st.st_rdev);
+	}
 
-		for (i = 0; i < ARRAY_SIZE(default_fds); ++i) {
-			if (!strncmp(default_fds[i],
-				     fd_lnk,
-				     strlen(default_fds[i]))) {
-				free(fd_lnk);
-				goto again;
-			}
-		}
+	closedir(dp);
 
-		copy_fd_lnk = strdup(fd_lnk);
-		dirn = dirname(copy_fd_lnk);
+	return dev_major;
+}
 
-		if (!strncmp(dir, dirn, strlen(dir)))
-			igt_show_stat(tid, cmd, state, fd_lnk);
+struct lsof_state {
+	const char *dir;
+	int state;
+};
 
-		free(copy_fd_lnk);
-		free(fd_lnk);
-	}
+static int
+__igt_lsof_fd(igt_proc_snapshot_t *snap, igt_proc_t *proc, int fd,
+	      const char *target, void *data)
+{
+	/* default fds or kernel threads */
+	static const char *default_fds[] = { "/dev/pts", "/dev/null" };
+	struct lsof_state *lsof = data;
+	const char *comm;
+	char *copy_fd_lnk;
+	char *dirn;
+	unsigned int i;
 
-	closedir(dp);
+	for (i = 0; i < ARRAY_SIZE(default_fds); ++i)
+		if (!strncmp(default_fds[i], target, strlen(default_fds[i])))
+			return 0;
+
+	copy_fd_lnk = strdup(target);
+	dirn = dirname(copy_fd_lnk);
+
+	comm = igt_proc_comm(snap, proc);
+	if (comm && !strncmp(lsof->dir, dirn, strlen(lsof->dir)))
+		igt_show_stat(proc->pid, comm, &lsof->state, target);
+
+	free(copy_fd_lnk);
+
+	return 0;
 }
 
 /*
@@ -1623,40 +1529,36 @@ again:
 static void
 __igt_lsof(const char *dir)
 {
-	char path[30];
-	char *name_lnk;
-	struct stat st;
-	int state = 0;
-	struct igt_process pc;
+	igt_proc_fd_filter_t filter = {
+		.prefix = dir,
+		.major = __igt_dir_device_major(dir),
+		.minor = -1,
+	};
+	struct lsof_state lsof = { .dir = dir };
+	igt_proc_snapshot_t *snap;
+	char cwd[PATH_MAX];
+	igt_proc_t *proc;
 
-	open_process(&pc);
-	while (get_process_ids(&pc)) {
-		ssize_t read;
+	snap = igt_proc_snapshot_create(NULL);
+	igt_assert_f(snap, "Failed to list processes\n");
 
+	for_each_igt_proc(snap, proc) {
 		/* check current working directory */
-		memset(path, 0, sizeof(path));
-		snprintf(path, sizeof(path), "/proc/%d/cwd", pc.tid);
-
-		if (stat(path, &st) == -1)
+		if (igt_proc_cwd(snap, proc, cwd, sizeof(cwd)) < 0)
 			continue;
 
-		name_lnk = malloc(st.st_size + 1);
-
-		igt_assert((read = readlink(path, name_lnk, st.st_size + 1)));
-		name_lnk[read] = '\0';
+		if (!strncmp(dir, cwd, strlen(dir))) {
+			const char *comm = igt_proc_comm(snap, proc);
 
-		if (!strncmp(dir, name_lnk, strlen(dir)))
-			igt_show_stat(pc.tid, pc.comm, &state, name_lnk);
+			if (comm)
+				igt_show_stat(proc->pid, comm, &lsof.state, cwd);
+		}
 
 		/* check also fd, seems that lsof(8) doesn't look here */
-		memset(path, 0, sizeof(path));
-		snprintf(path, sizeof(path), "/proc/%d/fd", pc.tid);
-
-		__igt_lsof_fds(pc.tid, pc.comm, &state, path, dir);
-
-		free(name_lnk);
+		igt_proc_for_each_fd(snap, proc, &filter, __igt_lsof_fd, &lsof);
 	}
-	close_process(&pc);
+
+	igt_proc_snapshot_destroy(snap);
 }
 
 /**
@@ -1726,26 +1628,26 @@ static void pipewire_reserve_wait(void)
 	char xdg_dir[PATH_MAX];
 	const char *homedir;
 	struct passwd *pw;
-	int tid = 0, euid, egid;
+	uid_t euid;
+	gid_t egid;
 
 	igt_fork_helper(&pw_reserve_proc) {
-		struct igt_process pc;
+		igt_proc_snapshot_t *snap;
+		igt_proc_t *proc;
 
 		igt_info("Preventing pipewire-pulse to use the audio drivers\n");
-		open_process(&pc);
-		while (get_process_ids(&pc)) {
-			tid = pc.tid;
-			euid = pc.euid;
-			egid = pc.egid;
-			if (pipewire_pulse_pid == tid)
-				break;
-		}
-		close_process(&pc);
+		snap = igt_proc_snapshot_create(NULL);
+		igt_assert_f(snap, "Failed to list processes\n");
 
 		/* Sanity check: if it can't find the process, it means it has gone */
-		if (pipewire_pulse_pid != tid)
+		proc = igt_proc_find(snap, pipewire_pulse_pid);
+		if (!proc || igt_proc_ids(snap, proc))
 			exit(0);
 
+		euid = proc->euid;
+		egid = proc->egid;
+		igt_proc_snapshot_destroy(snap);
+
 		pw = getpwuid(euid);
 		homedir = pw->pw_dir;
 		snprintf(xdg_dir, sizeof(xdg_dir), "/run/user/%d", euid);
@@ -1770,7 +1672,8 @@ static void pipewire_reserve_wait(void)
 
 int pipewire_pulse_start_reserve(void)
 {
-	bool is_pw_reserve_running = false;
+	igt_proc_snapshot_t *snap;
+	igt_proc_t *proc = NULL;
 	int attempts = 0;
 
 	if (!pipewire_pulse_pid)
@@ -1778,28 +1681,26 @@ int pipewire_pulse_start_reserve(void)
 
 	pipewire_reserve_wait();
 
+	snap = igt_proc_snapshot_create(NULL);
+	igt_assert_f(snap, "Failed to list processes\n");
+
 	/*
 	 * Note: using pw-reserve to stop using audio only works with
 	 * pipewire version 0.3.50 or upper.
 	 */
 	for (attempts = 0; attempts < PIPEWIRE_RESERVE_MAX_TIME; attempts++) {
-		struct igt_process pc;
-
 		usleep(1000);
-		open_process(&pc);
-		while (get_process_ids(&pc)) {
-			if (!strcmp(pc.comm, "pw-reserve")) {
-				is_pw_reserve_running = true;
-				pipewire_pw_reserve_pid = pc.tid;
-				break;
-			}
-		}
-		close_process(&pc);
+		igt_proc_snapshot_refresh(snap);
 
-		if (is_pw_reserve_running)
+		proc = igt_proc_find_comm(snap, "pw-reserve");
+		if (proc) {
+			pipewire_pw_reserve_pid = proc->pid;
 			break;
+		}
 	}
-	if (!is_pw_reserve_running) {
+	igt_proc_snapshot_destroy(snap);
+
+	if (!proc) {
 		igt_warn("Failed to remove audio drivers from pipewire\n");
 		return 1;
 	}
@@ -1822,13 +1723,20 @@ void pipewire_pulse_stop_reserve(void)
 	igt_stop_helper(&pw_reserve_proc);
 }
 
+static int
+__igt_lsof_audio_fd(igt_proc_snapshot_t *snap, igt_proc_t *proc, int fd,
+		    const char *target, void *data)
+{
+	return 1;
+}
+
 /**
  * __igt_lsof_audio_and_kill_proc() - check if a given process is using an
  *	audio device. If so, stop or prevent them to use such devices.
  *
- * @proc_info: process struct, as returned by readproc()
- * @proc_path: path of the process under procfs
- * @pipewire_pulse_pid: PID of pipewire-pulse process
+ * @snap: process snapshot
+ * @proc: process in @snap
+ * @filter: selects the fds of audio devices
  *
  * No processes can be using an audio device by the time it gets removed.
  * This function checks if a process is using an audio device from /dev/snd.
@@ -1843,16 +1751,17 @@ void pipewire_pulse_stop_reserve(void)
  * If the check fails, it means that the process can simply be killed.
  */
 static int
-__igt_lsof_audio_and_kill_proc(const pid_t tid, const char *cmd, const uid_t euid, const gid_t egid, char *proc_path)
+__igt_lsof_audio_and_kill_proc(igt_proc_snapshot_t *snap, igt_proc_t *proc,
+			       const igt_proc_fd_filter_t *filter)
 {
-	const char *audio_dev = "/dev/snd/";
-	char path[PATH_MAX * 2];
-	struct dirent *d;
-	struct stat st;
-	char *fd_lnk;
+	const pid_t tid = proc->pid;
+	const char *cmd;
 	int fail = 0;
-	ssize_t read;
-	DIR *dp;
+	int ret;
+
+	cmd = igt_proc_comm(snap, proc);
+	if (!cmd)
+		return 0;
 
 	/*
 	 * Terminating pipewire-pulse require an special procedure, which
@@ -1888,63 +1797,38 @@ __igt_lsof_audio_and_kill_proc(const pid_t tid, const char *cmd, const uid_t eui
 	if (!strcmp(cmd, "wireplumber"))
 		return 0;
 
-	dp = opendir(proc_path);
-	if (!dp && errno == ENOENT)
+	ret = igt_proc_for_each_fd(snap, proc, filter, __igt_lsof_audio_fd, NULL);
+	if (!ret || ret == -ENOENT)
 		return 0;
-	if (!dp)
+	if (ret < 0)
 		return 1;
 
-	while ((d = readdir(dp))) {
-		if (*d->d_name == '.')
-			continue;
-
-		memset(path, 0, sizeof(path));
-		snprintf(path, sizeof(path), "%s/%s", proc_path, d->d_name);
-
-		if (lstat(path, &st) == -1)
-			continue;
-
-		fd_lnk = malloc(st.st_size + 1);
-
-		igt_assert((read = readlink(path, fd_lnk, st.st_size + 1)));
-		fd_lnk[read] = '\0';
-
-		if (strncmp(audio_dev, fd_lnk, strlen(audio_dev))) {
-			free(fd_lnk);
-			continue;
-		}
-
-		free(fd_lnk);
-
-		/*
-		 * In order to avoid racing against pa/systemd, ensure that
-		 * pulseaudio will close all audio files. This should be
-		 * enough to unbind audio modules and won't cause race issues
-		 * with systemd trying to reload it.
-		 */
-		if (!strcmp(cmd, "pulseaudio")) {
-			pulseaudio_unload_module(euid, egid);
-			break;
-		}
+	/*
+	 * In order to avoid racing against pa/systemd, ensure that
+	 * pulseaudio will close all audio files. This should be
+	 * enough to unbind audio modules and won't cause race issues
+	 * with systemd trying to reload it.
+	 */
+	if (!strcmp(cmd, "pulseaudio")) {
+		if (!igt_proc_ids(snap, proc))
+			pulseaudio_unload_module(proc->euid, proc->egid);
+		return 0;
+	}
 
-		/* For all other processes, just kill them */
-		igt_info("process %d (%s) is using audio device. Should be terminated.\n",
-				tid, cmd);
+	/* For all other processes, just kill them */
+	igt_info("process %d (%s) is using audio device. Should be terminated.\n",
+			tid, cmd);
 
-		if (kill(tid, SIGTERM) < 0) {
-			igt_info("Fail to terminate %s (pid: %d) with SIGTERM\n",
+	if (kill(tid, SIGTERM) < 0) {
+		igt_info("Fail to terminate %s (pid: %d) with SIGTERM\n",
+			cmd, tid);
+		if (kill(tid, SIGABRT) < 0) {
+			fail++;
+			igt_info("Fail to terminate %s (pid: %d) with SIGABRT\n",
 				cmd, tid);
-			if (kill(tid, SIGABRT) < 0) {
-				fail++;
-				igt_info("Fail to terminate %s (pid: %d) with SIGABRT\n",
-					cmd, tid);
-			}
 		}
-
-		break;
 	}
 
-	closedir(dp);
 	return fail;
 }
 
@@ -1958,19 +1842,23 @@ __igt_lsof_audio_and_kill_proc(const pid_t tid, const char *cmd, const uid_t eui
 int
 igt_lsof_kill_audio_processes(void)
 {
-	char path[PATH_MAX];
+	igt_proc_fd_filter_t filter = {
+		.prefix = "/dev/snd/",
+		.major = __igt_dir_device_major("/dev/snd"),
+		.minor = -1,
+	};
+	igt_proc_snapshot_t *snap;
+	igt_proc_t *proc;
 	int fail = 0;
-	struct igt_process pc;
 
-	open_process(&pc);
+	snap = igt_proc_snapshot_create(NULL);
+	igt_assert_f(snap, "Failed to list processes\n");
+
 	pipewire_pulse_pid = 0;
-	while (get_process_ids(&pc)) {
-		if (snprintf(path, sizeof(path), "/proc/%d/fd", pc.tid) < 1)
-			fail++;
-		else
-			fail += __igt_lsof_audio_and_kill_proc(pc.tid, pc.comm, pc.euid, pc.egid, path);
-	}
-	close_process(&pc);
+	for_each_igt_proc(snap, proc)
+		fail += __igt_lsof_audio_and_kill_proc(snap, proc, &filter);
+
+	igt_proc_snapshot_destroy(snap);
 
 	return fail;
 }
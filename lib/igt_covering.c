@@ -0,0 +1,610 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_core.h"
+#include "igt_covering.h"
+#include "igt_rand.h"
+
+/**
+ * SECTION:igt_covering
+ * @short_description: Combinatorial reduction of matrix tests
+ * @title: Covering arrays
+ * @include: igt_covering.h
+ *
+ * Matrix tests enumerating the full cartesian product of their modes,
+ * buffer types, operations and engines take hours to run. Most bugs
+ * depend on the interaction of a few parameters only, so running a subset
+ * where every combination of the values of any t dimensions appears at
+ * least once (a covering array of strength t, pairwise for t = 2) finds
+ * most of them in a fraction of the time.
+ *
+ * The rows are generated greedily and deterministically from a seed, and
+ * are usually run as dynamic subtests:
+ *
+ * |[<!-- language="C" -->
+ *	static const char * const modes[] = { "gtt", "wc", "cpu", NULL };
+ *	static const char * const engines[] = { "rcs", "bcs", "vcs", NULL };
+ *	...
+ *	igt_subtest_with_dynamic("matrix") {
+ *		igt_covering_t cov;
+ *		unsigned int row;
+ *
+ *		igt_covering_init(&cov, "matrix", 2, 0);
+ *		igt_covering_add(&cov, "mode", modes);
+ *		igt_covering_add(&cov, "engine", engines);
+ *		igt_covering_add(&cov, "op", ops);
+ *		igt_covering_generate(&cov);
+ *
+ *		igt_covering_dynamic(&cov, row)
+ *			run(igt_covering_value(&cov, row, 0),
+ *			    igt_covering_value(&cov, row, 1),
+ *			    igt_covering_value(&cov, row, 2));
+ *
+ *		igt_covering_fini(&cov);
+ *	}
+ * ]|
+ *
+ * CI can override the choices of the test through the environment:
+ * IGT_COVERING_STRENGTH takes a strength or "full", IGT_COVERING_SEED a
+ * seed, and IGT_COVERING_HISTORY the path of a file the rows run are
+ * appended to, along with the tuples they covered. The rows of the
+ * history are loaded before generating, and among the candidate rows
+ * covering as many new t-way tuples, those covering the most (t+1)-way
+ * tuples not run before are preferred, so that the coverage rotates over
+ * the runs. Without an explicit seed, the seed is perturbed by the size
+ * of the history for the same reason.
+ */
+
+/* candidate rows built per row kept */
+#define CANDIDATES 16
+
+struct tuple_space {
+	const igt_covering_t *cov;
+	unsigned int t;
+	unsigned int n_subsets;
+	unsigned int *subsets;
+	uint64_t *base;
+	uint64_t n_tuples;
+	uint64_t n_covered;
+	uint8_t *covered;
+};
+
+static unsigned int env_strength(unsigned int strength)
+{
+	const char *env = getenv("IGT_COVERING_STRENGTH");
+
+	if (!env)
+		return strength;
+	if (!strcmp(env, "full"))
+		return 0;
+
+	return atoi(env);
+}
+
+/**
+ * igt_covering_init:
+ * @cov: test space to initialize
+ * @name: name of the test space
+ * @strength: number of dimensions whose combinations must all be covered,
+ *	      0 for the full cartesian product
+ * @seed: seed of the generation
+ *
+ * IGT_COVERING_STRENGTH and IGT_COVERING_SEED override @strength and @seed
+ * when set.
+ */
+void igt_covering_init(igt_covering_t *cov, const char *name,
+		       unsigned int strength, uint32_t seed)
+{
+	const char *env = getenv("IGT_COVERING_SEED");
+
+	memset(cov, 0, sizeof(*cov));
+	cov->name = strdup(name);
+	igt_assert(cov->name);
+	cov->strength = env_strength(strength);
+	cov->seed = env ? strtoul(env, NULL, 0) : seed;
+}
+
+/**
+ * igt_covering_fini:
+ * @cov: test space
+ */
+void igt_covering_fini(igt_covering_t *cov)
+{
+	for (unsigned int i = 0; i < cov->n_rows; i++)
+		free(cov->names[i]);
+	free(cov->names);
+	free(cov->rows);
+	free(cov->history);
+	free(cov->dims);
+	free(cov->name);
+	memset(cov, 0, sizeof(*cov));
+}
+
+/**
+ * igt_covering_add:
+ * @cov: test space
+ * @name: name of the dimension
+ * @values: names of its values, NULL-terminated, kept by reference
+ *
+ * Adds a dimension, before igt_covering_generate().
+ */
+void igt_covering_add(igt_covering_t *cov, const char *name,
+		      const char * const *values)
+{
+	igt_covering_dim_t *dim;
+
+	igt_assert(!cov->rows && !cov->history);
+	igt_assert(values[0]);
+
+	cov->dims = realloc(cov->dims, (cov->n_dims + 1) * sizeof(*cov->dims));
+	igt_assert(cov->dims);
+
+	dim = &cov->dims[cov->n_dims++];
+	dim->name = name;
+	dim->values = values;
+	for (dim->n_values = 0; values[dim->n_values]; dim->n_values++)
+		;
+}
+
+/* all the t-subsets of the dimensions, and a slot per tuple of values */
+static void space_init(struct tuple_space *space, const igt_covering_t *cov,
+		       unsigned int t)
+{
+	unsigned int idx[t];
+
+	memset(space, 0, sizeof(*space));
+	space->cov = cov;
+	space->t = t;
+	if (!t || t > cov->n_dims)
+		return;
+
+	for (unsigned int i = 0; i < t; i++)
+		idx[i] = i;
+
+	do {
+		uint64_t n = 1;
+		int i;
+
+		space->subsets = realloc(space->subsets,
+					 (space->n_subsets + 1) * t *
+					 sizeof(*space->subsets));
+		space->base = realloc(space->base, (space->n_subsets + 1) *
+				      sizeof(*space->base));
+		igt_assert(space->subsets && space->base);
+
+		memcpy(&space->subsets[space->n_subsets * t], idx, sizeof(idx));
+		space->base[space->n_subsets++] = space->n_tuples;
+		for (i = 0; i < t; i++)
+			n *= cov->dims[idx[i]].n_values;
+		space->n_tuples += n;
+
+		/* next combination in lexicographic order */
+		for (i = t - 1; i >= 0 && idx[i] == cov->n_dims - t + i; i--)
+			;
+		if (i < 0)
+			break;
+		idx[i]++;
+		for (i++; i < t; i++)
+			idx[i] = idx[i - 1] + 1;
+	} while (1);
+
+	space->covered = calloc(space->n_tuples, 1);
+	igt_assert(space->covered);
+}
+
+static void space_fini(struct tuple_space *space)
+{
+	free(space->covered);
+	free(space->base);
+	free(space->subsets);
+}
+
+/* index of the tuple of @row in subset @s, -1 if not all of it is set */
+static int64_t tuple_index(const struct tuple_space *space, unsigned int s,
+			   const int *row)
+{
+	const unsigned int *dims = &space->subsets[s * space->t];
+	uint64_t idx = 0;
+
+	for (unsigned int i = 0; i < space->t; i++) {
+		if (row[dims[i]] < 0)
+			return -1;
+		idx = idx * space->cov->dims[dims[i]].n_values + row[dims[i]];
+	}
+
+	return space->base[s] + idx;
+}
+
+static unsigned int space_count(const struct tuple_space *space,
+				const int *row)
+{
+	unsigned int count = 0;
+
+	for (unsigned int s = 0; s < space->n_subsets; s++) {
+		int64_t idx = tuple_index(space, s, row);
+
+		if (idx >= 0 && !space->covered[idx])
+			count++;
+	}
+
+	return count;
+}
+
+static void space_mark(struct tuple_space *space, const int *row)
+{
+	for (unsigned int s = 0; s < space->n_subsets; s++) {
+		int64_t idx = tuple_index(space, s, row);
+
+		if (idx >= 0 && !space->covered[idx]) {
+			space->covered[idx] = 1;
+			space->n_covered++;
+		}
+	}
+}
+
+/* sets the values of the first uncovered tuple from @start in @row */
+static void space_seed(const struct tuple_space *space, uint64_t start,
+		       int *row)
+{
+	uint64_t idx = start;
+	unsigned int s;
+
+	while (space->covered[idx])
+		idx = (idx + 1) % space->n_tuples;
+
+	for (s = space->n_subsets - 1; space->base[s] > idx; s--)
+		;
+
+	idx -= space->base[s];
+	for (int i = space->t - 1; i >= 0; i--) {
+		unsigned int dim = space->subsets[s * space->t + i];
+		unsigned int n = space->cov->dims[dim].n_values;
+
+		row[dim] = idx % n;
+		idx /= n;
+	}
+}
+
+static uint32_t random_max(uint32_t *state, uint32_t ep_ro)
+{
+	return ((uint64_t)hars_petruska_f54_1_random(state) * ep_ro) >> 32;
+}
+
+static void add_row(igt_covering_t *cov, const int *row)
+{
+	unsigned int *values;
+	size_t len = 0;
+	char *name;
+
+	cov->rows = realloc(cov->rows, (cov->n_rows + 1) * cov->n_dims *
+			    sizeof(*cov->rows));
+	cov->names = realloc(cov->names,
+			     (cov->n_rows + 1) * sizeof(*cov->names));
+	igt_assert(cov->rows && cov->names);
+
+	values = &cov->rows[cov->n_rows * cov->n_dims];
+	for (unsigned int d = 0; d < cov->n_dims; d++) {
+		values[d] = row[d];
+		len += strlen(cov->dims[d].values[row[d]]) + 1;
+	}
+
+	name = malloc(len);
+	igt_assert(name);
+	for (unsigned int d = 0, pos = 0; d < cov->n_dims; d++)
+		pos += sprintf(name + pos, "%s%s", d ? "-" : "",
+			       cov->dims[d].values[row[d]]);
+
+	cov->names[cov->n_rows++] = name;
+}
+
+static void generate_full(igt_covering_t *cov)
+{
+	int row[cov->n_dims];
+	int d;
+
+	memset(row, 0, sizeof(row));
+	do {
+		add_row(cov, row);
+
+		for (d = cov->n_dims - 1; d >= 0; d--) {
+			if (++row[d] < cov->dims[d].n_values)
+				break;
+			row[d] = 0;
+		}
+	} while (d >= 0);
+}
+
+/*
+ * Builds a row around a random uncovered tuple, filling the other
+ * dimensions, in random order, with the value covering the most new
+ * tuples.
+ */
+static void build_candidate(const struct tuple_space *space, uint32_t *state,
+			    int *row)
+{
+	const igt_covering_t *cov = space->cov;
+	unsigned int order[cov->n_dims];
+
+	for (unsigned int d = 0; d < cov->n_dims; d++) {
+		row[d] = -1;
+		order[d] = d;
+	}
+
+	space_seed(space, ((uint64_t)hars_petruska_f54_1_random(state) *
+			   space->n_tuples) >> 32, row);
+
+	for (unsigned int i = cov->n_dims; i > 1; i--) {
+		unsigned int j = random_max(state, i), tmp = order[i - 1];
+
+		order[i - 1] = order[j];
+		order[j] = tmp;
+	}
+	for (unsigned int i = 0; i < cov->n_dims; i++) {
+		const igt_covering_dim_t *dim = &cov->dims[order[i]];
+		unsigned int best = 0, ties = 0;
+		int value = 0;
+
+		if (row[order[i]] >= 0)
+			continue;
+
+		for (unsigned int v = 0; v < dim->n_values; v++) {
+			unsigned int count;
+
+			row[order[i]] = v;
+			count = space_count(space, row);
+			if (count > best || !ties) {
+				best = count;
+				ties = 1;
+				value = v;
+			} else if (count == best &&
+				   !random_max(state, ++ties)) {
+				value = v;
+			}
+		}
+
+		row[order[i]] = value;
+	}
+}
+
+static void generate_covering(igt_covering_t *cov)
+{
+	struct tuple_space space, rotation;
+	uint32_t state = cov->seed;
+	int row[cov->n_dims];
+
+	space_init(&space, cov, cov->strength);
+	space_init(&rotation, cov, cov->strength + 1);
+
+	for (unsigned int i = 0; i < cov->n_history; i++) {
+		for (unsigned int d = 0; d < cov->n_dims; d++)
+			row[d] = cov->history[i * cov->n_dims + d];
+		space_mark(&rotation, row);
+	}
+
+	while (space.n_covered < space.n_tuples) {
+		unsigned int best = 0, best_rotation = 0;
+		int candidate[cov->n_dims];
+
+		for (unsigned int c = 0; c < CANDIDATES; c++) {
+			unsigned int count, count_rotation;
+
+			build_candidate(&space, &state, candidate);
+			count = space_count(&space, candidate);
+			count_rotation = space_count(&rotation, candidate);
+
+			if (count > best ||
+			    (count == best && count_rotation > best_rotation)) {
+				best = count;
+				best_rotation = count_rotation;
+				memcpy(row, candidate, sizeof(row));
+			}
+		}
+
+		space_mark(&space, row);
+		space_mark(&rotation, row);
+		add_row(cov, row);
+	}
+
+	space_fini(&rotation);
+	space_fini(&space);
+}
+
+/**
+ * igt_covering_generate:
+ * @cov: test space
+ *
+ * Generates the rows covering all the combinations of values of any
+ * @strength dimensions, or the full cartesian product if @strength is 0
+ * or not less than the number of dimensions.
+ *
+ * When IGT_COVERING_HISTORY is set, loads the history from that file
+ * first, and appends the rows generated to it.
+ */
+void igt_covering_generate(igt_covering_t *cov)
+{
+	const char *history = getenv("IGT_COVERING_HISTORY");
+	FILE *f;
+
+	igt_assert(cov->n_dims);
+	igt_assert(!cov->rows);
+
+	if (history) {
+		f = fopen(history, "r");
+		if (f) {
+			igt_covering_load(cov, f);
+			fclose(f);
+		}
+
+		if (!getenv("IGT_COVERING_SEED"))
+			cov->seed ^= cov->n_history;
+	}
+
+	if (!cov->strength || cov->strength >= cov->n_dims)
+		generate_full(cov);
+	else
+		generate_covering(cov);
+
+	igt_debug("%s: %u rows of strength %u, seed %u\n",
+		  cov->name, cov->n_rows, cov->strength, cov->seed);
+
+	if (history) {
+		f = fopen(history, "a");
+		if (f) {
+			igt_covering_save(cov, f);
+			fclose(f);
+		} else {
+			igt_warn("Unable to append to %s\n", history);
+		}
+	}
+}
+
+static int find_value(const igt_covering_dim_t *dim, const char *value,
+		      size_t len)
+{
+	for (unsigned int v = 0; v < dim->n_values; v++)
+		if (strlen(dim->values[v]) == len &&
+		    !strncmp(dim->values[v], value, len))
+			return v;
+
+	return -1;
+}
+
+/* "row <name> <dim>=<value> ..." with every dimension set */
+static bool parse_row(const igt_covering_t *cov, char *line, int *row)
+{
+	unsigned int n = 0;
+	char *tok, *save;
+
+	tok = strtok_r(line, " \n", &save);
+	if (!tok || strcmp(tok, "row"))
+		return false;
+
+	tok = strtok_r(NULL, " \n", &save);
+	if (!tok || strcmp(tok, cov->name))
+		return false;
+
+	for (unsigned int d = 0; d < cov->n_dims; d++)
+		row[d] = -1;
+
+	while ((tok = strtok_r(NULL, " \n", &save))) {
+		char *eq = strchr(tok, '=');
+		unsigned int d;
+		int v;
+
+		if (!eq)
+			return false;
+
+		for (d = 0; d < cov->n_dims; d++)
+			if (!strncmp(cov->dims[d].name, tok, eq - tok) &&
+			    !cov->dims[d].name[eq - tok])
+				break;
+		if (d == cov->n_dims)
+			return false;
+
+		v = find_value(&cov->dims[d], eq + 1, strlen(eq + 1));
+		if (v < 0 || row[d] != -1)
+			return false;
+
+		row[d] = v;
+		n++;
+	}
+
+	return n == cov->n_dims;
+}
+
+/**
+ * igt_covering_load:
+ * @cov: test space, with all its dimensions
+ * @f: history
+ *
+ * Loads the rows of @cov run previously, skipping those of other test
+ * spaces and those whose dimensions or values don't exist anymore.
+ *
+ * Returns: false if @f had no row for @cov.
+ */
+bool igt_covering_load(igt_covering_t *cov, FILE *f)
+{
+	unsigned int start = cov->n_history;
+	int row[cov->n_dims];
+	char *line = NULL;
+	size_t len = 0;
+
+	igt_assert(!cov->rows);
+
+	while (getline(&line, &len, f) > 0) {
+		if (!parse_row(cov, line, row))
+			continue;
+
+		cov->history = realloc(cov->history,
+				       (cov->n_history + 1) * cov->n_dims *
+				       sizeof(*cov->history));
+		igt_assert(cov->history);
+		for (unsigned int d = 0; d < cov->n_dims; d++)
+			cov->history[cov->n_history * cov->n_dims + d] = row[d];
+		cov->n_history++;
+	}
+	free(line);
+
+	return cov->n_history > start;
+}
+
+static void save_tuples(const igt_covering_t *cov, FILE *f)
+{
+	struct tuple_space space;
+	int row[cov->n_dims];
+
+	space_init(&space, cov, cov->strength);
+	for (unsigned int r = 0; r < cov->n_rows; r++) {
+		for (unsigned int d = 0; d < cov->n_dims; d++)
+			row[d] = igt_covering_value(cov, r, d);
+
+		for (unsigned int s = 0; s < space.n_subsets; s++) {
+			int64_t idx = tuple_index(&space, s, row);
+
+			if (space.covered[idx])
+				continue;
+			space.covered[idx] = 1;
+
+			fprintf(f, "tuple %s", cov->name);
+			for (unsigned int i = 0; i < space.t; i++) {
+				const igt_covering_dim_t *dim =
+					&cov->dims[space.subsets[s * space.t + i]];
+
+				fprintf(f, " %s=%s", dim->name,
+					dim->values[row[dim - cov->dims]]);
+			}
+			fprintf(f, "\n");
+		}
+	}
+	space_fini(&space);
+}
+
+/**
+ * igt_covering_save:
+ * @cov: generated test space
+ * @f: history
+ *
+ * Writes the rows of @cov in the format read by igt_covering_load(),
+ * followed by the t-way tuples they cover.
+ */
+void igt_covering_save(const igt_covering_t *cov, FILE *f)
+{
+	fprintf(f, "# %s: strength %u, seed %u\n",
+		cov->name, cov->strength, cov->seed);
+
+	for (unsigned int r = 0; r < cov->n_rows; r++) {
+		fprintf(f, "row %s", cov->name);
+		for (unsigned int d = 0; d < cov->n_dims; d++)
+			fprintf(f, " %s=%s", cov->dims[d].name,
+				cov->dims[d].values[igt_covering_value(cov, r, d)]);
+		fprintf(f, "\n");
+	}
+
+	if (cov->strength && cov->strength < cov->n_dims)
+		save_tuples(cov, f);
+}
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_COVERING_H
+#define IGT_COVERING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * igt_covering_dim_t: A dimension of the test space
+ * @name: name of the dimension, e.g. "mode"
+ * @values: names of the values, NULL-terminated
+ * @n_values: number of entries in @values
+ */
+typedef struct {
+	const char *name;
+	const char * const *values;
+	unsigned int n_values;
+} igt_covering_dim_t;
+
+/**
+ * igt_covering_t: Subset of a test space covering all t-way combinations
+ * @name: name of the test space, identifies its rows in the history
+ * @strength: number of dimensions whose combinations are all covered,
+ *	      0 for the full cartesian product
+ * @seed: seed of the generation
+ * @dims: dimensions of the test space
+ * @n_dims: number of entries in @dims
+ * @rows: value indices of each row, @n_dims per row
+ * @names: name of each row, the value names joined by '-'
+ * @n_rows: number of rows
+ * @history: value indices of the rows run previously, @n_dims per row
+ * @n_history: number of rows in @history
+ */
+typedef struct {
+	char *name;
+	unsigned int strength;
+	uint32_t seed;
+	igt_covering_dim_t *dims;
+	unsigned int n_dims;
+	unsigned int *rows;
+	char **names;
+	unsigned int n_rows;
+	unsigned int *history;
+	unsigned int n_history;
+} igt_covering_t;
+
+void igt_covering_init(igt_covering_t *cov, const char *name,
+		       unsigned int strength, uint32_t seed);
+void igt_covering_fini(igt_covering_t *cov);
+void igt_covering_add(igt_covering_t *cov, const char *name,
+		      const char * const *values);
+void igt_covering_generate(igt_covering_t *cov);
+bool igt_covering_load(igt_covering_t *cov, FILE *f);
+void igt_covering_save(const igt_covering_t *cov, FILE *f);
+
+/**
+ * igt_covering_value:
+ * @cov: generated test space
+ * @row: row index
+ * @dim: dimension index, in the order of igt_covering_add()
+ *
+ * Returns: the index of the value of @dim in @row.
+ */
+static inline unsigned int
+igt_covering_value(const igt_covering_t *cov, unsigned int row,
+		   unsigned int dim)
+{
+	return cov->rows[row * cov->n_dims + dim];
+}
+
+/**
+ * igt_covering_name:
+ * @cov: generated test space
+ * @row: row index
+ *
+ * Returns: the name of @row, suitable for a dynamic subtest.
+ */
+static inline const char *
+igt_covering_name(const igt_covering_t *cov, unsigned int row)
+{
+	return cov->names[row];
+}
+
+/**
+ * for_each_covering_row:
+ * @cov: generated test space
+ * @row: unsigned int iterator
+ */
+#define for_each_covering_row(cov, row) \
+	for ((row) = 0; (row) < (cov)->n_rows; (row)++)
+
+/**
+ * igt_covering_dynamic:
+ * @cov: generated test space
+ * @row: unsigned int iterator
+ *
+ * Runs the following block as a dynamic subtest for each row of @cov,
+ * named after the row.
+ */
+#define igt_covering_dynamic(cov, row) \
+	for_each_covering_row(cov, row) \
+		igt_dynamic_f("%s", igt_covering_name(cov, row))
+
+#endif /* IGT_COVERING_H */
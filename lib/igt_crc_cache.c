@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "igt_core.h"
+#include "igt_crc_cache.h"
+
+/**
+ * SECTION:igt_crc_cache
+ * @short_description: Reference CRCs shared across pipes and planes
+ * @title: CRC cache
+ * @include: igt_crc_cache.h
+ *
+ * Format and plane sweeps compare the CRCs of each format against
+ * references rendered in a well known format. The references only depend
+ * on what reaches the CRC source, so the same ones can be reused on every
+ * pipe driving the same mode with the same contents, instead of being
+ * captured again for each of them.
+ *
+ * A cache entry is keyed by the CRC source, the mode timings, a pattern
+ * string describing the framebuffer and plane setup, and the display
+ * version. A modeset to other timings hence never hits an older entry.
+ * State outside of the key which affects the CRCs, like the gamma LUT or
+ * the CSC, must be reset to the same values before each lookup, or the
+ * cache dropped with igt_crc_cache_invalidate() when it changes.
+ */
+
+struct entry {
+	igt_crc_cache_key_t key;
+	int count;
+	igt_crc_t crcs[IGT_CRC_CACHE_MAX_CRCS];
+};
+
+/**
+ * igt_crc_cache_init:
+ * @cache: cache to initialize
+ */
+void igt_crc_cache_init(igt_crc_cache_t *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+	igt_vec_init(&cache->entries, sizeof(struct entry));
+}
+
+/**
+ * igt_crc_cache_fini:
+ * @cache: cache to release
+ */
+void igt_crc_cache_fini(igt_crc_cache_t *cache)
+{
+	igt_vec_fini(&cache->entries);
+}
+
+/**
+ * igt_crc_cache_key_init:
+ * @key: key to fill
+ * @source: CRC source name
+ * @mode: mode of the pipe
+ * @display_ver: display IP version, 0 if not applicable
+ * @pattern_fmt: printf() format of the pattern description
+ * @...: arguments of @pattern_fmt
+ *
+ * The source name must also tell apart CRC sources that the kernel picks
+ * itself, like the port behind "auto" on some platforms.
+ */
+void igt_crc_cache_key_init(igt_crc_cache_key_t *key, const char *source,
+			    const drmModeModeInfo *mode,
+			    unsigned int display_ver,
+			    const char *pattern_fmt, ...)
+{
+	va_list ap;
+
+	memset(key, 0, sizeof(*key));
+	snprintf(key->source, sizeof(key->source), "%s", source);
+	key->mode = *mode;
+	key->display_ver = display_ver;
+
+	va_start(ap, pattern_fmt);
+	vsnprintf(key->pattern, sizeof(key->pattern), pattern_fmt, ap);
+	va_end(ap);
+}
+
+static bool same_timings(const drmModeModeInfo *a, const drmModeModeInfo *b)
+{
+	return a->clock == b->clock &&
+	       a->hdisplay == b->hdisplay &&
+	       a->hsync_start == b->hsync_start &&
+	       a->hsync_end == b->hsync_end &&
+	       a->htotal == b->htotal &&
+	       a->hskew == b->hskew &&
+	       a->vdisplay == b->vdisplay &&
+	       a->vsync_start == b->vsync_start &&
+	       a->vsync_end == b->vsync_end &&
+	       a->vtotal == b->vtotal &&
+	       a->vscan == b->vscan &&
+	       a->flags == b->flags;
+}
+
+static bool same_key(const igt_crc_cache_key_t *a, const igt_crc_cache_key_t *b)
+{
+	return a->display_ver == b->display_ver &&
+	       !strcmp(a->source, b->source) &&
+	       !strcmp(a->pattern, b->pattern) &&
+	       same_timings(&a->mode, &b->mode);
+}
+
+/**
+ * igt_crc_cache_get:
+ * @cache: cache to look up
+ * @key: what the CRCs depend on
+ * @crcs: returns the CRCs
+ * @count: number of CRCs, at most #IGT_CRC_CACHE_MAX_CRCS
+ * @capture: called to capture the CRCs on a miss
+ * @data: passed to @capture
+ *
+ * Looks up the @count CRCs of @key, and captures them with @capture if
+ * they aren't known yet. CRCs returned from the cache keep the frame
+ * number of their original capture.
+ *
+ * Returns:
+ * True if the CRCs came from the cache.
+ */
+bool igt_crc_cache_get(igt_crc_cache_t *cache, const igt_crc_cache_key_t *key,
+		       igt_crc_t *crcs, int count,
+		       igt_crc_cache_capture_t capture, void *data)
+{
+	struct entry e;
+
+	igt_assert(count > 0 && count <= IGT_CRC_CACHE_MAX_CRCS);
+
+	for (int i = 0; i < igt_vec_length(&cache->entries); i++) {
+		struct entry *cached = igt_vec_elem(&cache->entries, i);
+
+		if (cached->count != count || !same_key(&cached->key, key))
+			continue;
+
+		memcpy(crcs, cached->crcs, count * sizeof(*crcs));
+		cache->hits++;
+		cache->crcs_saved += count;
+		igt_debug("CRC cache hit: %s, %dx%d, %s\n", key->source,
+			  key->mode.hdisplay, key->mode.vdisplay, key->pattern);
+
+		return true;
+	}
+
+	capture(data, crcs, count);
+	cache->misses++;
+
+	memset(&e, 0, sizeof(e));
+	e.key = *key;
+	e.count = count;
+	memcpy(e.crcs, crcs, count * sizeof(*crcs));
+	igt_vec_push(&cache->entries, &e);
+
+	return false;
+}
+
+/**
+ * igt_crc_cache_invalidate:
+ * @cache: cache to empty
+ *
+ * Drops all the cached CRCs, to be called when state which is not part of
+ * the keys changes the CRCs.
+ */
+void igt_crc_cache_invalidate(igt_crc_cache_t *cache)
+{
+	if (!igt_vec_length(&cache->entries))
+		return;
+
+	igt_vec_fini(&cache->entries);
+	igt_vec_init(&cache->entries, sizeof(struct entry));
+	cache->invalidations++;
+}
+
+/**
+ * igt_crc_cache_report:
+ * @cache: cache to report about
+ *
+ * Logs how many lookups were served from the cache.
+ */
+void igt_crc_cache_report(const igt_crc_cache_t *cache)
+{
+	igt_info("CRC cache: %u hits, %u misses, %u CRCs not captured again, %u invalidations\n",
+		 cache->hits, cache->misses, cache->crcs_saved,
+		 cache->invalidations);
+}
@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_CRC_CACHE_H
+#define IGT_CRC_CACHE_H
+
+#include <stdbool.h>
+#include <xf86drmMode.h>
+
+#include "igt_pipe_crc.h"
+#include "igt_vec.h"
+
+#define IGT_CRC_CACHE_MAX_CRCS 16
+
+/**
+ * igt_crc_cache_key_t: What a set of reference CRCs depends on
+ * @source: CRC source, and anything else selecting where it is computed
+ * @mode: mode the CRCs were captured with, only the timings are compared
+ * @pattern: description of the framebuffer contents and plane setup
+ * @display_ver: display IP version, 0 if not applicable
+ */
+typedef struct {
+	char source[64];
+	drmModeModeInfo mode;
+	char pattern[128];
+	unsigned int display_ver;
+} igt_crc_cache_key_t;
+
+/**
+ * igt_crc_cache_t: Reference CRCs captured so far
+ * @entries: cached CRC sets
+ * @hits: lookups served from the cache
+ * @misses: lookups that had to capture
+ * @crcs_saved: CRCs served from the cache instead of captured
+ * @invalidations: number of igt_crc_cache_invalidate() dropping entries
+ */
+typedef struct {
+	struct igt_vec entries;
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int crcs_saved;
+	unsigned int invalidations;
+} igt_crc_cache_t;
+
+/**
+ * igt_crc_cache_capture_t: Captures the CRCs of a cache miss
+ * @data: caller data given to igt_crc_cache_get()
+ * @crcs: where to store the CRCs
+ * @count: number of CRCs to capture
+ */
+typedef void (*igt_crc_cache_capture_t)(void *data, igt_crc_t *crcs, int count);
+
+void igt_crc_cache_init(igt_crc_cache_t *cache);
+void igt_crc_cache_fini(igt_crc_cache_t *cache);
+void igt_crc_cache_key_init(igt_crc_cache_key_t *key, const char *source,
+			    const drmModeModeInfo *mode,
+			    unsigned int display_ver,
+			    const char *pattern_fmt, ...)
+	__attribute__((format(printf, 5, 6)));
+bool igt_crc_cache_get(igt_crc_cache_t *cache, const igt_crc_cache_key_t *key,
+		       igt_crc_t *crcs, int count,
+		       igt_crc_cache_capture_t capture, void *data);
+void igt_crc_cache_invalidate(igt_crc_cache_t *cache);
+void igt_crc_cache_report(const igt_crc_cache_t *cache);
+
+#endif /* IGT_CRC_CACHE_H */
@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_damage.h"
+
+/**
+ * SECTION:igt_damage
+ * @short_description: Dirty rectangle bookkeeping
+ * @title: Damage
+ * @include: igt_damage.h
+ *
+ * Tracks the regions of a surface changed since the last write-back, so
+ * only those need to be copied. Regions are either added explicitly with
+ * igt_damage_add(), or found with igt_damage_diff() by comparing the
+ * surface with a reference copy of its contents at the last write-back,
+ * which catches any drawing, whatever API did it.
+ *
+ * Adjacent regions lining up are merged, and past
+ * #igt_damage_t.max_rects regions everything collapses into the bounding
+ * box: a few larger copies are cheaper than many small ones.
+ */
+
+static bool rect_contains(const igt_damage_rect_t *outer,
+			  const igt_damage_rect_t *inner)
+{
+	return outer->x <= inner->x && outer->y <= inner->y &&
+		inner->x + inner->width <= outer->x + outer->width &&
+		inner->y + inner->height <= outer->y + outer->height;
+}
+
+/* Whether @a and @b touch along a full edge, so their union is a rect */
+static bool rect_joins(const igt_damage_rect_t *a, const igt_damage_rect_t *b)
+{
+	if (a->y == b->y && a->height == b->height)
+		return a->x <= b->x + b->width && b->x <= a->x + a->width;
+
+	if (a->x == b->x && a->width == b->width)
+		return a->y <= b->y + b->height && b->y <= a->y + a->height;
+
+	return false;
+}
+
+static void rect_union(igt_damage_rect_t *a, const igt_damage_rect_t *b)
+{
+	int x2 = max(a->x + a->width, b->x + b->width);
+	int y2 = max(a->y + a->height, b->y + b->height);
+
+	a->x = min(a->x, b->x);
+	a->y = min(a->y, b->y);
+	a->width = x2 - a->x;
+	a->height = y2 - a->y;
+}
+
+/**
+ * igt_damage_init:
+ * @damage: damage to initialize
+ * @width: width of the surface
+ * @height: height of the surface
+ *
+ * Initializes @damage without any damaged region.
+ */
+void igt_damage_init(igt_damage_t *damage, int width, int height)
+{
+	igt_vec_init(&damage->rects, sizeof(igt_damage_rect_t));
+	damage->width = width;
+	damage->height = height;
+	damage->max_rects = IGT_DAMAGE_MAX_RECTS;
+}
+
+/**
+ * igt_damage_fini:
+ * @damage: damage
+ *
+ * Frees @damage.
+ */
+void igt_damage_fini(igt_damage_t *damage)
+{
+	igt_vec_fini(&damage->rects);
+}
+
+/**
+ * igt_damage_reset:
+ * @damage: damage
+ *
+ * Drops all damaged regions, usually once written back.
+ */
+void igt_damage_reset(igt_damage_t *damage)
+{
+	igt_vec_fini(&damage->rects);
+	igt_vec_init(&damage->rects, sizeof(igt_damage_rect_t));
+}
+
+/**
+ * igt_damage_add:
+ * @damage: damage
+ * @x: left edge in pixels
+ * @y: top edge in pixels
+ * @width: width in pixels
+ * @height: height in pixels
+ *
+ * Adds a damaged region, clipped to the surface.
+ */
+void igt_damage_add(igt_damage_t *damage, int x, int y, int width, int height)
+{
+	igt_damage_rect_t rect;
+	int x2 = min(x + width, damage->width);
+	int y2 = min(y + height, damage->height);
+	bool merged;
+
+	rect.x = max(x, 0);
+	rect.y = max(y, 0);
+	rect.width = x2 - rect.x;
+	rect.height = y2 - rect.y;
+	if (rect.width <= 0 || rect.height <= 0)
+		return;
+
+	/* grown rects may join or contain others in turn */
+	do {
+		merged = false;
+		for (int i = igt_vec_length(&damage->rects) - 1; i >= 0; i--) {
+			igt_damage_rect_t *r = igt_vec_elem(&damage->rects, i);
+
+			if (rect_contains(r, &rect))
+				return;
+
+			if (rect_contains(&rect, r) || rect_joins(r, &rect)) {
+				rect_union(&rect, r);
+				igt_vec_swap_remove(&damage->rects, i);
+				merged = true;
+			}
+		}
+	} while (merged);
+
+	igt_vec_push(&damage->rects, &rect);
+
+	if (igt_vec_length(&damage->rects) > damage->max_rects) {
+		for (int i = 0; i < igt_vec_length(&damage->rects); i++)
+			rect_union(&rect, igt_vec_elem(&damage->rects, i));
+
+		igt_damage_reset(damage);
+		igt_vec_push(&damage->rects, &rect);
+	}
+}
+
+/**
+ * igt_damage_count:
+ * @damage: damage
+ *
+ * Returns: the number of damaged regions.
+ */
+int igt_damage_count(const igt_damage_t *damage)
+{
+	return igt_vec_length(&damage->rects);
+}
+
+/**
+ * igt_damage_rect:
+ * @damage: damage
+ * @idx: index of the region, below igt_damage_count()
+ *
+ * Returns: the damaged region @idx.
+ */
+const igt_damage_rect_t *igt_damage_rect(const igt_damage_t *damage, int idx)
+{
+	return igt_vec_elem(&damage->rects, idx);
+}
+
+/**
+ * igt_damage_area:
+ * @damage: damage
+ *
+ * Returns: the number of pixels in the damaged regions. Regions may
+ * overlap, so this is an upper bound.
+ */
+uint64_t igt_damage_area(const igt_damage_t *damage)
+{
+	uint64_t area = 0;
+
+	for (int i = 0; i < igt_damage_count(damage); i++) {
+		const igt_damage_rect_t *r = igt_damage_rect(damage, i);
+
+		area += (uint64_t)r->width * r->height;
+	}
+
+	return area;
+}
+
+/**
+ * igt_damage_is_full:
+ * @damage: damage
+ *
+ * Returns: whether the whole surface is damaged.
+ */
+bool igt_damage_is_full(const igt_damage_t *damage)
+{
+	const igt_damage_rect_t *r;
+
+	if (igt_damage_count(damage) != 1)
+		return false;
+
+	r = igt_damage_rect(damage, 0);
+
+	return r->width == damage->width && r->height == damage->height;
+}
+
+/**
+ * igt_damage_diff:
+ * @damage: damage
+ * @ptr: surface contents
+ * @ref: reference contents, as of the last write-back
+ * @stride: stride of both @ptr and @ref in bytes
+ * @cpp: bytes per pixel
+ * @tile_width: width of the compared tiles in pixels
+ * @tile_height: height of the compared tiles in pixels
+ *
+ * Compares @ptr to @ref tile by tile, and adds the runs of differing tiles
+ * of each tile row to @damage.
+ *
+ * Returns: the number of differing tiles.
+ */
+int igt_damage_diff(igt_damage_t *damage, const void *ptr, const void *ref,
+		    unsigned int stride, unsigned int cpp,
+		    int tile_width, int tile_height)
+{
+	int tiles_x = DIV_ROUND_UP(damage->width, tile_width);
+	bool *dirty;
+	int count = 0;
+
+	dirty = malloc(tiles_x * sizeof(*dirty));
+	igt_assert(dirty);
+
+	for (int ty = 0; ty * tile_height < damage->height; ty++) {
+		int y0 = ty * tile_height;
+		int y1 = min(y0 + tile_height, damage->height);
+		int run = -1;
+
+		memset(dirty, 0, tiles_x * sizeof(*dirty));
+		for (int y = y0; y < y1; y++) {
+			const uint8_t *a = (const uint8_t *)ptr + y * stride;
+			const uint8_t *b = (const uint8_t *)ref + y * stride;
+
+			/* most lines are untouched */
+			if (!memcmp(a, b, damage->width * cpp))
+				continue;
+
+			for (int tx = 0; tx < tiles_x; tx++) {
+				int x0 = tx * tile_width;
+				int w = min(tile_width, damage->width - x0);
+
+				if (!dirty[tx] &&
+				    memcmp(a + x0 * cpp, b + x0 * cpp, w * cpp))
+					dirty[tx] = true;
+			}
+		}
+
+		for (int tx = 0; tx <= tiles_x; tx++) {
+			if (tx < tiles_x && dirty[tx]) {
+				count++;
+				if (run < 0)
+					run = tx;
+				continue;
+			}
+
+			if (run >= 0) {
+				igt_damage_add(damage, run * tile_width, y0,
+					       (tx - run) * tile_width, y1 - y0);
+				run = -1;
+			}
+		}
+	}
+
+	free(dirty);
+
+	return count;
+}
+
+/**
+ * igt_damage_copy:
+ * @damage: damage
+ * @dst: destination surface
+ * @src: source surface
+ * @stride: stride of both @dst and @src in bytes
+ * @cpp: bytes per pixel
+ *
+ * Copies the damaged regions of @src to @dst, like to bring the reference
+ * of igt_damage_diff() up to date after a write-back.
+ */
+void igt_damage_copy(const igt_damage_t *damage, void *dst, const void *src,
+		     unsigned int stride, unsigned int cpp)
+{
+	for (int i = 0; i < igt_damage_count(damage); i++) {
+		const igt_damage_rect_t *r = igt_damage_rect(damage, i);
+
+		for (int y = r->y; y < r->y + r->height; y++) {
+			uint64_t offset = (uint64_t)y * stride + r->x * cpp;
+
+			memcpy((uint8_t *)dst + offset,
+			       (const uint8_t *)src + offset, r->width * cpp);
+		}
+	}
+}
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_DAMAGE_H
+#define IGT_DAMAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "igt_vec.h"
+
+#define IGT_DAMAGE_MAX_RECTS 16
+
+/**
+ * igt_damage_rect_t: A damaged region
+ * @x: left edge in pixels
+ * @y: top edge in pixels
+ * @width: width in pixels
+ * @height: height in pixels
+ */
+typedef struct {
+	int x, y;
+	int width, height;
+} igt_damage_rect_t;
+
+/**
+ * igt_damage_t: Regions of a surface changed since the last reset
+ * @rects: igt_damage_rect_t, none contained in another
+ * @width: width of the surface
+ * @height: height of the surface
+ * @max_rects: number of rects beyond which they collapse into their
+ *             bounding box
+ */
+typedef struct {
+	struct igt_vec rects;
+	int width, height;
+	int max_rects;
+} igt_damage_t;
+
+void igt_damage_init(igt_damage_t *damage, int width, int height);
+void igt_damage_fini(igt_damage_t *damage);
+void igt_damage_reset(igt_damage_t *damage);
+void igt_damage_add(igt_damage_t *damage, int x, int y, int width, int height);
+int igt_damage_count(const igt_damage_t *damage);
+const igt_damage_rect_t *igt_damage_rect(const igt_damage_t *damage, int idx);
+uint64_t igt_damage_area(const igt_damage_t *damage);
+bool igt_damage_is_full(const igt_damage_t *damage);
+int igt_damage_diff(igt_damage_t *damage, const void *ptr, const void *ref,
+		    unsigned int stride, unsigned int cpp,
+		    int tile_width, int tile_height);
+void igt_damage_copy(const igt_damage_t *damage, void *dst, const void *src,
+		     unsigned int stride, unsigned int cpp);
+
+#endif /* IGT_DAMAGE_H */
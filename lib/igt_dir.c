@@ -5,6 +5,10 @@
 
 #include <dirent.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <time.h>
 
 #include "igt.h"
 #include "igt_dir.h"
@@ -59,6 +63,24 @@
  *	closedir(debugfs);
  *	drm_close_driver(fd);
  * }
+ *
+ * Reading the files one after another means a single slow or blocking node
+ * stalls the whole walk. igt_dir_crawl() reads the scanned files from a pool
+ * of threads instead, with a timeout for every node, and records how long
+ * each node took so that pathological ones show up with
+ * igt_dir_crawl_report():
+ *
+ * igt_dir_crawl_opts_t opts = { .timeout_ms = 1000 };
+ * igt_dir_crawl_t crawl;
+ *
+ * igt_dir_scan_dirfd(igt_dir, -1);
+ * igt_dir_crawl(igt_dir, &opts, &crawl);
+ * igt_dir_crawl_report(&crawl, 10); // the 10 slowest nodes
+ * igt_dir_crawl_fini(&crawl);
+ *
+ * igt_dir_process_files_simple() reads the files one after another, the
+ * crawler has to be asked for explicitly, igt_dir_crawl_simple() being the
+ * crawling counterpart.
  */
 
 /**
@@ -157,59 +179,70 @@ igt_dir_t *igt_dir_create(int dirfd)
 }
 
 static int _igt_dir_scan_dirfd(igt_dir_t *config, int scan_maxdepth,
-			       int depth, const char *current_path)
+			       int depth, int fd, char *relative_path,
+			       size_t len)
 {
 	struct dirent *entry;
 	igt_dir_file_list_t *file_list_entry;
 	DIR *dirp;
-	int dirfd;
 	int ret = 0;
 
 	if (depth > scan_maxdepth && scan_maxdepth != -1) {
 		igt_debug("Max scan depth reached\n");
+		close(fd);
 		return 0;
 	}
 
-	if (!current_path) {
-		igt_debug("Invalid current path\n");
-		return -1;
-	}
-
-	dirfd = open(current_path, O_RDONLY | O_DIRECTORY);
-	if (dirfd < 0) {
-		igt_debug("Failed to open directory %s\n", current_path);
-		return -1;
-	}
-
-	dirp = fdopendir(dirfd);
+	dirp = fdopendir(fd);
 	if (!dirp) {
-		igt_debug("Failed to fdopendir %s\n", current_path);
-		close(dirfd);
+		igt_debug("Failed to fdopendir %s\n", relative_path);
+		close(fd);
 		return -1;
 	}
 
 	while ((entry = readdir(dirp))) {
-		char entry_path[PATH_MAX];
+		size_t entry_len;
+		bool is_dir;
 
 		if (strcmp(entry->d_name, ".") == 0 ||
 		    strcmp(entry->d_name, "..") == 0)
 			continue;
 
-		snprintf(entry_path, sizeof(entry_path),
-			 "%s/%s", current_path, entry->d_name);
+		/* Paths are only built for the list, lookups are fd relative */
+		entry_len = snprintf(relative_path + len, PATH_MAX - len,
+				     "%s%s", len ? "/" : "", entry->d_name);
+		if (len + entry_len >= PATH_MAX) {
+			igt_debug("Path too long: %s\n", relative_path);
+			relative_path[len] = '\0';
+			continue;
+		}
+
+		is_dir = entry->d_type == DT_DIR;
+		if (entry->d_type == DT_UNKNOWN) {
+			struct stat st;
+
+			is_dir = !fstatat(dirfd(dirp), entry->d_name, &st,
+					  AT_SYMLINK_NOFOLLOW) &&
+				 S_ISDIR(st.st_mode);
+		}
+
+		if (is_dir) {
+			int subdir_fd = openat(dirfd(dirp), entry->d_name,
+					       O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+			if (subdir_fd < 0) {
+				igt_debug("Failed to open directory %s\n",
+					  relative_path);
+				ret = -1;
+				break;
+			}
 
-		if (entry->d_type == DT_DIR) {
 			ret = _igt_dir_scan_dirfd(config, scan_maxdepth,
-						  depth + 1, entry_path);
+						  depth + 1, subdir_fd,
+						  relative_path, len + entry_len);
 			if (ret)
 				break;
 		} else {
-			/* Compute path relative to the scan root */
-			const char *relative_path = entry_path +
-						    strlen(config->root_path);
-			if (*relative_path == '/')
-				relative_path++; /* skip leading slash */
-
 			file_list_entry = malloc(sizeof(igt_dir_file_list_t));
 			if (!file_list_entry) {
 				igt_debug("Failed to allocate memory for file list entry\n");
@@ -222,8 +255,8 @@ static int _igt_dir_scan_dirfd(igt_dir_t *config, int scan_maxdepth,
 		}
 	}
 
+	relative_path[len] = '\0';
 	closedir(dirp);
-	close(dirfd);
 
 	return ret;
 }
@@ -237,6 +270,9 @@ static int _igt_dir_scan_dirfd(igt_dir_t *config, int scan_maxdepth,
  */
 int igt_dir_scan_dirfd(igt_dir_t *config, int scan_maxdepth)
 {
+	char relative_path[PATH_MAX] = "";
+	int fd;
+
 	igt_require(config);
 	igt_require(config->root_path);
 	igt_require(config->dirfd >= 0);
@@ -252,9 +288,17 @@ int igt_dir_scan_dirfd(igt_dir_t *config, int scan_maxdepth)
 			free(file_list_entry->relative_path);
 			free(file_list_entry);
 		}
+		IGT_INIT_LIST_HEAD(&config->file_list_head);
+	}
+
+	fd = openat(config->dirfd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		igt_debug("Failed to open directory %s\n", config->root_path);
+		return -1;
 	}
 
-	return _igt_dir_scan_dirfd(config, scan_maxdepth, 0, config->root_path);
+	return _igt_dir_scan_dirfd(config, scan_maxdepth, 0, fd,
+				   relative_path, 0);
 }
 
 /**
@@ -296,6 +340,508 @@ int igt_dir_process_files(igt_dir_t *config,
 	return ret;
 }
 
+/*
+ * Crawler: the files are read by a pool of threads, each one opened relative
+ * to a private dup of the root directory fd. The calling thread is the
+ * watchdog: a node exceeding the timeout is recorded as timed out and its
+ * reader interrupted with IGT_DIR_CRAWL_SIGNAL. A reader that still does not
+ * return within another timeout period (e.g. stuck in an uninterruptible
+ * wait in the kernel) is abandoned and replaced. Abandoned readers hold a
+ * reference to the shared state, freed by whoever drops the last one.
+ *
+ * The handler of IGT_DIR_CRAWL_SIGNAL is only installed while crawls are
+ * running, the previous one is restored after the last one. Unless a reader
+ * was abandoned: the signal may still be pending for it, and the default
+ * action would terminate the process.
+ */
+
+#define IGT_DIR_CRAWL_SIGNAL (SIGRTMIN + 1)
+#define IGT_DIR_CRAWL_MAX_WORKERS 16
+#define IGT_DIR_CRAWL_READ_SIZE 4096
+#define IGT_DIR_CRAWL_DEFAULT_TIMEOUT_MS 10000
+
+struct crawl_job {
+	char *relative_path;
+	uint64_t latency_ns;
+	ssize_t bytes;
+	int err;
+	bool done;
+};
+
+struct crawl_state {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned int refcount;
+
+	int dirfd;
+	size_t read_size;
+
+	struct crawl_job *jobs;
+	unsigned int count;
+	unsigned int next;
+	unsigned int finished;
+};
+
+struct crawl_worker {
+	struct crawl_state *state;
+	pthread_t thread;
+	char *buf;
+
+	/* protected by state->lock */
+	int job;
+	uint64_t start_ns;
+	uint64_t kicked_ns;
+	bool abandoned;
+};
+
+static uint64_t crawl_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void crawl_state_put(struct crawl_state *state)
+{
+	bool last;
+
+	pthread_mutex_lock(&state->lock);
+	last = !--state->refcount;
+	pthread_mutex_unlock(&state->lock);
+
+	if (!last)
+		return;
+
+	for (unsigned int i = 0; i < state->count; i++)
+		free(state->jobs[i].relative_path);
+	free(state->jobs);
+	close(state->dirfd);
+	pthread_cond_destroy(&state->cond);
+	pthread_mutex_destroy(&state->lock);
+	free(state);
+}
+
+static bool crawl_kicked(struct crawl_worker *w)
+{
+	bool kicked;
+
+	pthread_mutex_lock(&w->state->lock);
+	kicked = w->kicked_ns;
+	pthread_mutex_unlock(&w->state->lock);
+
+	return kicked;
+}
+
+static int crawl_read(struct crawl_worker *w, const char *relative_path,
+		      ssize_t *bytes)
+{
+	struct crawl_state *state = w->state;
+	int fd, err = 0;
+
+	*bytes = 0;
+
+	/* EINTR from anything but the watchdog is retried */
+	do {
+		fd = openat(state->dirfd, relative_path, O_RDONLY | O_CLOEXEC);
+		err = fd < 0 ? -errno : 0;
+	} while (err == -EINTR && !crawl_kicked(w));
+
+	if (fd < 0)
+		return err;
+
+	while (*bytes < state->read_size) {
+		ssize_t ret = read(fd, w->buf + *bytes,
+				   state->read_size - *bytes);
+
+		if (ret > 0) {
+			*bytes += ret;
+			continue;
+		}
+
+		if (ret < 0) {
+			err = -errno;
+			if (err == -EINTR && !crawl_kicked(w)) {
+				err = 0;
+				continue;
+			}
+		}
+		break;
+	}
+
+	close(fd);
+
+	return err;
+}
+
+static void *crawl_worker(void *data)
+{
+	struct crawl_worker *w = data;
+	struct crawl_state *state = w->state;
+	bool abandoned;
+
+	pthread_mutex_lock(&state->lock);
+	while (!w->abandoned && state->next < state->count) {
+		struct crawl_job *job = &state->jobs[state->next];
+		ssize_t bytes;
+		int err;
+
+		w->job = state->next++;
+		w->start_ns = crawl_now_ns();
+		w->kicked_ns = 0;
+		pthread_mutex_unlock(&state->lock);
+
+		err = crawl_read(w, job->relative_path, &bytes);
+
+		pthread_mutex_lock(&state->lock);
+		/* the watchdog may already have given up on this node */
+		if (!job->done) {
+			job->latency_ns = crawl_now_ns() - w->start_ns;
+			job->bytes = bytes;
+			job->err = err;
+			job->done = true;
+			state->finished++;
+		}
+		w->job = -1;
+		pthread_cond_signal(&state->cond);
+	}
+	abandoned = w->abandoned;
+	pthread_mutex_unlock(&state->lock);
+
+	if (abandoned) {
+		free(w->buf);
+		free(w);
+	}
+	crawl_state_put(state);
+
+	return NULL;
+}
+
+static void crawl_signal_handler(int sig)
+{
+}
+
+static pthread_mutex_t crawl_signal_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct sigaction crawl_signal_old;
+static unsigned int crawl_signal_users;
+static bool crawl_signal_pinned;
+
+static void crawl_signal_get(void)
+{
+	/* no SA_RESTART, the whole point is to break out of syscalls */
+	struct sigaction act = {
+		.sa_handler = crawl_signal_handler,
+	};
+
+	pthread_mutex_lock(&crawl_signal_lock);
+	if (!crawl_signal_users++ && !crawl_signal_pinned)
+		sigaction(IGT_DIR_CRAWL_SIGNAL, &act, &crawl_signal_old);
+	pthread_mutex_unlock(&crawl_signal_lock);
+}
+
+static void crawl_signal_put(bool abandoned)
+{
+	pthread_mutex_lock(&crawl_signal_lock);
+	crawl_signal_pinned |= abandoned;
+	if (!--crawl_signal_users && !crawl_signal_pinned)
+		sigaction(IGT_DIR_CRAWL_SIGNAL, &crawl_signal_old, NULL);
+	pthread_mutex_unlock(&crawl_signal_lock);
+}
+
+static struct crawl_worker *crawl_spawn(struct crawl_state *state)
+{
+	struct crawl_worker *w;
+
+	w = calloc(1, sizeof(*w));
+	igt_assert(w);
+	w->buf = malloc(state->read_size);
+	igt_assert(w->buf);
+	w->state = state;
+	w->job = -1;
+
+	state->refcount++;
+	igt_assert_eq(pthread_create(&w->thread, NULL, crawl_worker, w), 0);
+
+	return w;
+}
+
+/* Returns the next deadline of @w, 0 if it has none */
+static uint64_t crawl_watchdog(struct crawl_state *state,
+			       struct crawl_worker **slot,
+			       uint64_t timeout_ns, igt_dir_crawl_t *crawl)
+{
+	struct crawl_worker *w = *slot;
+	uint64_t now = crawl_now_ns();
+	struct crawl_job *job;
+
+	if (w->job < 0)
+		return 0;
+
+	job = &state->jobs[w->job];
+
+	if (!w->kicked_ns) {
+		if (now - w->start_ns < timeout_ns)
+			return w->start_ns + timeout_ns;
+
+		job->latency_ns = now - w->start_ns;
+		job->err = -ETIMEDOUT;
+		job->done = true;
+		state->finished++;
+
+		w->kicked_ns = now;
+		pthread_kill(w->thread, IGT_DIR_CRAWL_SIGNAL);
+
+		return now + timeout_ns;
+	}
+
+	if (now - w->kicked_ns < timeout_ns)
+		return w->kicked_ns + timeout_ns;
+
+	igt_debug("Abandoning reader stuck on %s\n", job->relative_path);
+	w->abandoned = true;
+	pthread_detach(w->thread);
+	crawl->stuck++;
+
+	*slot = state->next < state->count ? crawl_spawn(state) : NULL;
+
+	return 0;
+}
+
+static bool crawl_busy(struct crawl_state *state,
+		       struct crawl_worker **workers, unsigned int num_workers)
+{
+	if (state->finished < state->count)
+		return true;
+
+	/* wait for interrupted readers to return or be abandoned */
+	for (unsigned int i = 0; i < num_workers; i++)
+		if (workers[i] && workers[i]->job >= 0)
+			return true;
+
+	return false;
+}
+
+/**
+ * igt_dir_crawl: Read the files in the directory concurrently
+ * @config: Pointer to the igt_dir struct
+ * @opts: crawl options, NULL selects one reader per CPU and a timeout of
+ *	  10 seconds per node
+ * @crawl: filled with the per node results, release with
+ *	   igt_dir_crawl_fini()
+ *
+ * Reads and discards the contents of every matching file of the list,
+ * using a pool of threads. Unlike igt_dir_process_files(), an error does not
+ * stop the walk and a node that does not complete within the timeout is
+ * interrupted and recorded as timed out, while the other readers carry on.
+ *
+ * Returns: 0 if every node was read, -ETIMEDOUT if a node timed out,
+ * otherwise the error of the first node that failed.
+ */
+int igt_dir_crawl(igt_dir_t *config, const igt_dir_crawl_opts_t *opts,
+		  igt_dir_crawl_t *crawl)
+{
+	igt_dir_crawl_opts_t o = {
+		.timeout_ms = IGT_DIR_CRAWL_DEFAULT_TIMEOUT_MS,
+	};
+	igt_dir_file_list_t *file_list_entry;
+	struct crawl_worker **workers;
+	struct crawl_state *state;
+	pthread_condattr_t attr;
+	unsigned int num_workers;
+	uint64_t timeout_ns, start;
+	int ret = 0;
+
+	igt_require(config);
+	igt_require(config->dirfd >= 0);
+	igt_assert(crawl);
+
+	if (opts)
+		o = *opts;
+
+	memset(crawl, 0, sizeof(*crawl));
+	start = crawl_now_ns();
+
+	state = calloc(1, sizeof(*state));
+	igt_assert(state);
+	pthread_mutex_init(&state->lock, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&state->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	state->refcount = 1;
+	state->read_size = o.read_size ?: IGT_DIR_CRAWL_READ_SIZE;
+	state->dirfd = fcntl(config->dirfd, F_DUPFD_CLOEXEC, 0);
+	igt_assert_fd(state->dirfd);
+
+	igt_list_for_each_entry(file_list_entry, &config->file_list_head, link)
+		state->count += file_list_entry->match;
+
+	state->jobs = calloc(state->count ?: 1, sizeof(*state->jobs));
+	igt_assert(state->jobs);
+	igt_list_for_each_entry(file_list_entry, &config->file_list_head, link) {
+		if (file_list_entry->match) {
+			state->jobs[state->next].relative_path =
+				strdup(file_list_entry->relative_path);
+			igt_assert(state->jobs[state->next++].relative_path);
+		}
+	}
+	state->next = 0;
+
+	num_workers = o.workers;
+	if (!num_workers)
+		num_workers = min_t(long, sysconf(_SC_NPROCESSORS_ONLN),
+				    IGT_DIR_CRAWL_MAX_WORKERS);
+	num_workers = max_t(unsigned int, min(num_workers, state->count), 1);
+
+	timeout_ns = (uint64_t)o.timeout_ms * NSEC_PER_SEC / 1000;
+	if (timeout_ns)
+		crawl_signal_get();
+
+	workers = calloc(num_workers, sizeof(*workers));
+	igt_assert(workers);
+
+	pthread_mutex_lock(&state->lock);
+
+	for (unsigned int i = 0; i < num_workers; i++)
+		workers[i] = crawl_spawn(state);
+
+	while (crawl_busy(state, workers, num_workers)) {
+		uint64_t deadline = 0;
+
+		for (unsigned int i = 0; timeout_ns && i < num_workers; i++) {
+			uint64_t next;
+
+			if (!workers[i])
+				continue;
+
+			next = crawl_watchdog(state, &workers[i], timeout_ns, crawl);
+			if (next && (!deadline || next < deadline))
+				deadline = next;
+		}
+
+		if (!crawl_busy(state, workers, num_workers))
+			break;
+
+		if (deadline) {
+			struct timespec ts = {
+				.tv_sec = deadline / NSEC_PER_SEC,
+				.tv_nsec = deadline % NSEC_PER_SEC,
+			};
+
+			pthread_cond_timedwait(&state->cond, &state->lock, &ts);
+		} else {
+			pthread_cond_wait(&state->cond, &state->lock);
+		}
+	}
+
+	pthread_mutex_unlock(&state->lock);
+
+	for (unsigned int i = 0; i < num_workers; i++) {
+		if (!workers[i])
+			continue;
+
+		pthread_join(workers[i]->thread, NULL);
+		free(workers[i]->buf);
+		free(workers[i]);
+	}
+	free(workers);
+
+	if (timeout_ns)
+		crawl_signal_put(crawl->stuck);
+
+	crawl->count = state->count;
+	crawl->nodes = calloc(state->count ?: 1, sizeof(*crawl->nodes));
+	igt_assert(crawl->nodes);
+
+	for (unsigned int i = 0; i < state->count; i++) {
+		const struct crawl_job *job = &state->jobs[i];
+		igt_dir_node_t *node = &crawl->nodes[i];
+
+		node->relative_path = strdup(job->relative_path);
+		node->latency_ns = job->latency_ns;
+		node->bytes = job->bytes;
+		node->err = job->err;
+
+		if (node->err == -ETIMEDOUT)
+			crawl->timed_out++;
+		else if (node->err)
+			crawl->failed++;
+
+		if (node->err && !ret)
+			ret = node->err;
+
+		igt_debug("Read %zd bytes from file %s in %"PRIu64" us (%d)\n",
+			  node->bytes, node->relative_path,
+			  node->latency_ns / 1000, node->err);
+	}
+
+	crawl_state_put(state);
+
+	crawl->elapsed_ns = crawl_now_ns() - start;
+
+	return crawl->timed_out ? -ETIMEDOUT : ret;
+}
+
+static int crawl_cmp_latency(const void *a, const void *b)
+{
+	const igt_dir_node_t *na = *(const igt_dir_node_t **)a;
+	const igt_dir_node_t *nb = *(const igt_dir_node_t **)b;
+
+	if (na->latency_ns != nb->latency_ns)
+		return na->latency_ns < nb->latency_ns ? 1 : -1;
+
+	return strcmp(na->relative_path, nb->relative_path);
+}
+
+/**
+ * igt_dir_crawl_report: Print a summary of a crawl
+ * @crawl: results of igt_dir_crawl()
+ * @max_nodes: maximum number of nodes to list, slowest first
+ *
+ * Prints the totals of @crawl followed by the latency of its slowest nodes.
+ */
+void igt_dir_crawl_report(const igt_dir_crawl_t *crawl, unsigned int max_nodes)
+{
+	const igt_dir_node_t **sorted;
+
+	igt_info("Read %u nodes in %.1f ms: %u failed, %u timed out, %u readers stuck\n",
+		 crawl->count, crawl->elapsed_ns / 1e6, crawl->failed,
+		 crawl->timed_out, crawl->stuck);
+
+	max_nodes = min(max_nodes, crawl->count);
+	if (!max_nodes)
+		return;
+
+	sorted = malloc(crawl->count * sizeof(*sorted));
+	igt_assert(sorted);
+	for (unsigned int i = 0; i < crawl->count; i++)
+		sorted[i] = &crawl->nodes[i];
+	qsort(sorted, crawl->count, sizeof(*sorted), crawl_cmp_latency);
+
+	for (unsigned int i = 0; i < max_nodes; i++) {
+		const igt_dir_node_t *node = sorted[i];
+
+		igt_info("  %10.3f ms  %s%s%s\n", node->latency_ns / 1e6,
+			 node->relative_path, node->err ? ": " : "",
+			 node->err ? strerror(-node->err) : "");
+	}
+
+	free(sorted);
+}
+
+/**
+ * igt_dir_crawl_fini: Release the results of a crawl
+ * @crawl: results of igt_dir_crawl()
+ */
+void igt_dir_crawl_fini(igt_dir_crawl_t *crawl)
+{
+	for (unsigned int i = 0; i < crawl->count; i++)
+		free(crawl->nodes[i].relative_path);
+	free(crawl->nodes);
+	memset(crawl, 0, sizeof(*crawl));
+}
+
 /**
  * igt_dir_destroy: Destroy the igt_dir struct
  * @config: Pointer to the igt_dir struct
@@ -345,3 +891,39 @@ int igt_dir_process_files_simple(int dirfd)
 
 	return ret;
 }
+
+/**
+ * igt_dir_crawl_simple: Read the files in the directory with igt_dir_crawl()
+ *			 and report the slowest ones.
+ *
+ * @dirfd: file descriptor of the root directory
+ * @timeout_ms: per node timeout, 0 means no timeout
+ *
+ * Files that cannot be opened or read are only reported, as with
+ * igt_dir_process_files_simple().
+ *
+ * Returns: the number of nodes that timed out, or a negative error code on
+ * failure
+ */
+int igt_dir_crawl_simple(int dirfd, unsigned int timeout_ms)
+{
+	igt_dir_crawl_opts_t opts = { .timeout_ms = timeout_ms };
+	igt_dir_crawl_t crawl;
+	igt_dir_t *config;
+	int ret;
+
+	config = igt_dir_create(dirfd);
+	if (!config)
+		return -1;
+
+	igt_dir_scan_dirfd(config, -1);
+
+	igt_dir_crawl(config, &opts, &crawl);
+	igt_dir_crawl_report(&crawl, 10);
+	ret = crawl.timed_out;
+
+	igt_dir_crawl_fini(&crawl);
+	igt_dir_destroy(config);
+
+	return ret;
+}
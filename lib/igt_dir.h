@@ -5,6 +5,9 @@
 #ifndef IGT_DIR_H
 #define IGT_DIR_H
 
+#include <stdint.h>
+#include <sys/types.h>
+
 #include "igt_list.h"
 
 /**
@@ -49,6 +52,53 @@ typedef struct {
 	igt_dir_file_callback callback;
 } igt_dir_t;
 
+/**
+ * igt_dir_crawl_opts_t: Options for igt_dir_crawl()
+ * @workers: number of reader threads, 0 means one per online CPU (up to 16)
+ * @timeout_ms: per node timeout for opening and reading a file, 0 means no
+ *		timeout
+ * @read_size: maximum number of bytes read from each file, 0 means 4096
+ */
+typedef struct {
+	unsigned int workers;
+	unsigned int timeout_ms;
+	size_t read_size;
+} igt_dir_crawl_opts_t;
+
+/**
+ * igt_dir_node_t: Result of reading a single file during a crawl
+ * @relative_path: path to the file, relative to the root directory
+ * @latency_ns: time spent opening and reading the file
+ * @bytes: number of bytes read
+ * @err: 0 on success, -ETIMEDOUT if the node exceeded the timeout,
+ *	 otherwise the negative errno of the failing open or read
+ */
+typedef struct {
+	char *relative_path;
+	uint64_t latency_ns;
+	ssize_t bytes;
+	int err;
+} igt_dir_node_t;
+
+/**
+ * igt_dir_crawl_t: Results of igt_dir_crawl()
+ * @nodes: per file results, in file list order
+ * @count: number of entries in @nodes
+ * @failed: number of nodes which could not be opened or read
+ * @timed_out: number of nodes which exceeded the timeout
+ * @stuck: number of reader threads that did not return from an
+ *	   interrupted syscall and were abandoned
+ * @elapsed_ns: wall time of the whole crawl
+ */
+typedef struct {
+	igt_dir_node_t *nodes;
+	unsigned int count;
+	unsigned int failed;
+	unsigned int timed_out;
+	unsigned int stuck;
+	uint64_t elapsed_ns;
+} igt_dir_crawl_t;
+
 int igt_dir_get_fd_path(int fd, char *path, size_t path_len);
 int igt_dir_callback_read_discard(const char *filename,
 				  void *callback_data);
@@ -57,6 +107,11 @@ int igt_dir_scan_dirfd(igt_dir_t *config, int scan_maxdepth);
 int igt_dir_process_files(igt_dir_t *config,
 			  igt_dir_file_callback callback,
 			  void *callback_data);
+int igt_dir_crawl(igt_dir_t *config, const igt_dir_crawl_opts_t *opts,
+		  igt_dir_crawl_t *crawl);
+void igt_dir_crawl_report(const igt_dir_crawl_t *crawl, unsigned int max_nodes);
+void igt_dir_crawl_fini(igt_dir_crawl_t *crawl);
 void igt_dir_destroy(igt_dir_t *config);
 int igt_dir_process_files_simple(int dirfd);
+int igt_dir_crawl_simple(int dirfd, unsigned int timeout_ms);
 #endif /* IGT_DIR_H */
@@ -0,0 +1,434 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_drm_usage.h"
+
+/**
+ * SECTION:igt_drm_usage
+ * @short_description: GPU time and memory used by a process tree
+ * @title: DRM usage
+ * @include: igt_drm_usage.h
+ *
+ * Attributes the DRM clients opened by the descendants of a process, and
+ * their per engine busy time and per region memory, from the DRM fdinfo
+ * found in a procfs. Clients are identified by driver, device and client
+ * id, so an fd shared across fork() or dup() is only accounted once.
+ *
+ * fdinfo goes away with the last fd of a client, so a client is only seen
+ * by the samples taken while one of the tracked processes has it open.
+ * With #IGT_DRM_USAGE_HOLD_FDS a duplicate of the fd is taken from the
+ * process the first time the client is seen, and the client is then
+ * sampled through it until igt_drm_usage_destroy(), which also keeps the
+ * client objects alive until then. Processes reparented away from the
+ * tree are no longer found, the root should usually be a child subreaper.
+ */
+
+enum {
+	TREE_UNKNOWN,
+	TREE_IN,
+	TREE_OUT,
+};
+
+struct sample {
+	igt_drm_usage_t *usage;
+	uint64_t now_ns;
+	pid_t dir_pid;
+	int dir;
+};
+
+/**
+ * igt_drm_usage_create:
+ * @procfs: path to a procfs, NULL for /proc
+ * @root: pid whose descendants are tracked, @root itself is not
+ * @flags: IGT_DRM_USAGE_* flags
+ *
+ * Returns:
+ * A tracker without any sample, or NULL if @procfs can't be opened.
+ */
+igt_drm_usage_t *igt_drm_usage_create(const char *procfs, pid_t root,
+				      unsigned int flags)
+{
+	igt_drm_usage_t *usage;
+
+	usage = calloc(1, sizeof(*usage));
+	igt_assert(usage);
+
+	usage->snap = igt_proc_snapshot_create(procfs);
+	if (!usage->snap) {
+		free(usage);
+		return NULL;
+	}
+
+	usage->root = root;
+	usage->flags = flags;
+
+	return usage;
+}
+
+/**
+ * igt_drm_usage_destroy:
+ * @usage: tracker
+ *
+ * Closes the fds held with #IGT_DRM_USAGE_HOLD_FDS and frees @usage.
+ */
+void igt_drm_usage_destroy(igt_drm_usage_t *usage)
+{
+	if (!usage)
+		return;
+
+	for (int i = 0; i < usage->num_clients; i++)
+		if (usage->clients[i].held_fd >= 0)
+			close(usage->clients[i].held_fd);
+
+	igt_proc_snapshot_destroy(usage->snap);
+	free(usage->clients);
+	free(usage->tree);
+	free(usage);
+}
+
+static bool in_tree(igt_drm_usage_t *usage, int idx)
+{
+	igt_proc_snapshot_t *snap = usage->snap;
+	igt_proc_t *parent;
+	pid_t ppid;
+
+	if (usage->tree[idx] != TREE_UNKNOWN)
+		return usage->tree[idx] == TREE_IN;
+
+	/* also stops a walk looping over pids reused mid snapshot */
+	usage->tree[idx] = TREE_OUT;
+
+	ppid = igt_proc_ppid(snap, &snap->procs[idx]);
+	if (ppid == usage->root)
+		usage->tree[idx] = TREE_IN;
+	else if (ppid > 0 && (parent = igt_proc_find(snap, ppid)) &&
+		 in_tree(usage, parent - snap->procs))
+		usage->tree[idx] = TREE_IN;
+
+	return usage->tree[idx] == TREE_IN;
+}
+
+static int hold_fd(pid_t pid, int fd)
+{
+#if defined(SYS_pidfd_open) && defined(SYS_pidfd_getfd)
+	int pidfd, dup;
+
+	pidfd = syscall(SYS_pidfd_open, pid, 0);
+	if (pidfd < 0)
+		return -1;
+
+	dup = syscall(SYS_pidfd_getfd, pidfd, fd, 0);
+	close(pidfd);
+
+	return dup;
+#else
+	return -1;
+#endif
+}
+
+static igt_drm_usage_client_t *
+find_client(igt_drm_usage_t *usage, const struct drm_client_fdinfo *info)
+{
+	for (int i = 0; i < usage->num_clients; i++) {
+		igt_drm_usage_client_t *client = &usage->clients[i];
+
+		if (client->first.id == info->id &&
+		    !strcmp(client->first.driver, info->driver) &&
+		    !strcmp(client->first.pdev, info->pdev))
+			return client;
+	}
+
+	return NULL;
+}
+
+static igt_drm_usage_client_t *
+add_client(igt_drm_usage_t *usage, const struct drm_client_fdinfo *info,
+	   uint64_t now_ns, pid_t pid, int fd)
+{
+	igt_drm_usage_client_t *client;
+
+	if (usage->num_clients == usage->size) {
+		usage->size = usage->size ? 2 * usage->size : 8;
+		usage->clients = realloc(usage->clients,
+					 usage->size * sizeof(*usage->clients));
+		igt_assert(usage->clients);
+	}
+
+	client = &usage->clients[usage->num_clients++];
+	memset(client, 0, sizeof(*client));
+	client->first = *info;
+	client->first_ns = now_ns;
+	client->pid = pid;
+	client->held_fd = -1;
+
+	if (usage->flags & IGT_DRM_USAGE_HOLD_FDS && fd >= 0)
+		client->held_fd = hold_fd(pid, fd);
+
+	return client;
+}
+
+static void update_client(igt_drm_usage_t *usage,
+			  igt_drm_usage_client_t *client,
+			  const struct drm_client_fdinfo *info, uint64_t now_ns)
+{
+	client->last = *info;
+	client->last_ns = now_ns;
+	client->generation = usage->generation;
+
+	for (int r = 0; r < DRM_CLIENT_FDINFO_MAX_REGIONS; r++)
+		if (info->region_mem[r].resident > client->peak_resident[r])
+			client->peak_resident[r] = info->region_mem[r].resident;
+}
+
+static int sample_fd(igt_proc_snapshot_t *snap, igt_proc_t *proc, int fd,
+		     const char *target, void *data)
+{
+	struct drm_client_fdinfo info = {};
+	struct sample *s = data;
+	igt_drm_usage_client_t *client;
+	char name[32];
+
+	if (s->dir_pid != proc->pid) {
+		if (s->dir >= 0)
+			close(s->dir);
+
+		snprintf(name, sizeof(name), "%d/fdinfo", proc->pid);
+		s->dir = openat(snap->procfd, name, O_RDONLY | O_DIRECTORY);
+		s->dir_pid = proc->pid;
+	}
+
+	if (s->dir < 0)
+		return 0;
+
+	snprintf(name, sizeof(name), "%d", fd);
+	if (!__igt_parse_drm_fdinfo(s->dir, name, &info, NULL, 0, NULL, 0))
+		return 0;
+
+	client = find_client(s->usage, &info);
+	if (!client)
+		client = add_client(s->usage, &info, s->now_ns, proc->pid, fd);
+
+	if (client->generation != s->usage->generation)
+		update_client(s->usage, client, &info, s->now_ns);
+
+	return 0;
+}
+
+/**
+ * igt_drm_usage_sample:
+ * @usage: tracker
+ * @now_ns: time of the sample, on any monotonic clock
+ *
+ * Lists the descendants of the root, and reads the fdinfo of their DRM
+ * fds and of the held ones.
+ *
+ * Returns:
+ * The number of clients sampled, or a negative errno if the processes
+ * can't be listed.
+ */
+int igt_drm_usage_sample(igt_drm_usage_t *usage, uint64_t now_ns)
+{
+	static const igt_proc_fd_filter_t drm_fds = {
+		.prefix = "/dev/dri/",
+		.major = -1,
+		.minor = -1,
+	};
+	igt_proc_snapshot_t *snap = usage->snap;
+	struct sample s = {
+		.usage = usage,
+		.now_ns = now_ns,
+		.dir = -1,
+	};
+	bool scan_all = false;
+	int ret, count = 0;
+
+	/* looking up the parent of every process is the fallback */
+	ret = igt_proc_snapshot_refresh_tree(snap, usage->root);
+	if (ret == -ENOENT) {
+		ret = igt_proc_snapshot_refresh(snap);
+		scan_all = true;
+	}
+	if (ret < 0)
+		return ret;
+
+	if (usage->tree_size < snap->count) {
+		usage->tree_size = snap->size;
+		usage->tree = realloc(usage->tree, usage->tree_size);
+		igt_assert(usage->tree);
+	}
+	memset(usage->tree, scan_all ? TREE_UNKNOWN : TREE_IN, snap->count);
+
+	usage->generation++;
+	for (int i = 0; i < snap->count; i++)
+		if (in_tree(usage, i))
+			igt_proc_for_each_fd(snap, &snap->procs[i], &drm_fds,
+					     sample_fd, &s);
+
+	if (s.dir >= 0)
+		close(s.dir);
+
+	for (int i = 0; i < usage->num_clients; i++) {
+		igt_drm_usage_client_t *client = &usage->clients[i];
+		struct drm_client_fdinfo info = {};
+
+		if (client->generation != usage->generation &&
+		    client->held_fd >= 0 &&
+		    igt_parse_drm_fdinfo(client->held_fd, &info,
+					 NULL, 0, NULL, 0))
+			update_client(usage, client, &info, now_ns);
+
+		count += client->generation == usage->generation;
+	}
+
+	return count;
+}
+
+/*
+ * A client may have been opened before the tracked processes got it, e.g.
+ * inherited from outside the tree, so only what it used since it was first
+ * seen is accounted, nothing until a second sample.
+ */
+static uint64_t client_busy_ns(const igt_drm_usage_client_t *client, int idx)
+{
+	const struct drm_client_fdinfo *first = &client->first;
+	const struct drm_client_fdinfo *last = &client->last;
+	uint64_t ticks;
+
+	if (client->last_ns == client->first_ns)
+		return 0;
+
+	if (last->utilization_mask & DRM_FDINFO_UTILIZATION_ENGINE_TIME)
+		return last->engine_time[idx] - first->engine_time[idx];
+
+	if (!(last->utilization_mask & DRM_FDINFO_UTILIZATION_CYCLES))
+		return 0;
+
+	/*
+	 * Cycles are counted in engine timestamp ticks, whose rate is only
+	 * known from how fast the total advanced between two samples.
+	 */
+	ticks = last->total_cycles[idx] - first->total_cycles[idx];
+	if (!ticks)
+		return 0;
+
+	return (double)(last->cycles[idx] - first->cycles[idx]) *
+		(client->last_ns - client->first_ns) / ticks;
+}
+
+/**
+ * igt_drm_usage_engines:
+ * @usage: tracker
+ * @engines: returns an array, to be freed by the caller
+ *
+ * Sums the busy time of the clients per device and engine class.
+ *
+ * Returns:
+ * The number of entries in @engines.
+ */
+int igt_drm_usage_engines(igt_drm_usage_t *usage,
+			  igt_drm_usage_engine_t **engines)
+{
+	igt_drm_usage_engine_t *e = NULL;
+	int count = 0;
+
+	for (int c = 0; c < usage->num_clients; c++) {
+		igt_drm_usage_client_t *client = &usage->clients[c];
+		const struct drm_client_fdinfo *info = &client->last;
+
+		if (!client->generation)
+			continue;
+
+		for (int i = 0; i <= info->last_engine_index; i++) {
+			int n;
+
+			if (!info->names[i][0])
+				continue;
+
+			for (n = 0; n < count; n++)
+				if (!strcmp(e[n].pdev, info->pdev) &&
+				    !strcmp(e[n].name, info->names[i]))
+					break;
+
+			if (n == count) {
+				e = realloc(e, ++count * sizeof(*e));
+				igt_assert(e);
+				memset(&e[n], 0, sizeof(*e));
+				strcpy(e[n].pdev, info->pdev);
+				strcpy(e[n].name, info->names[i]);
+			}
+
+			if (info->capacity[i] > e[n].capacity)
+				e[n].capacity = info->capacity[i];
+			e[n].busy_ns += client_busy_ns(client, i);
+		}
+	}
+
+	*engines = e;
+
+	return count;
+}
+
+/**
+ * igt_drm_usage_regions:
+ * @usage: tracker
+ * @regions: returns an array, to be freed by the caller
+ *
+ * Sums the memory of the clients per device and memory region.
+ *
+ * Returns:
+ * The number of entries in @regions.
+ */
+int igt_drm_usage_regions(igt_drm_usage_t *usage,
+			  igt_drm_usage_region_t **regions)
+{
+	igt_drm_usage_region_t *r = NULL;
+	int count = 0;
+
+	for (int c = 0; c < usage->num_clients; c++) {
+		igt_drm_usage_client_t *client = &usage->clients[c];
+		const struct drm_client_fdinfo *info = &client->last;
+
+		if (!client->generation)
+			continue;
+
+		for (int i = 0; i <= info->last_region_index; i++) {
+			int n;
+
+			if (!info->region_names[i][0])
+				continue;
+
+			for (n = 0; n < count; n++)
+				if (!strcmp(r[n].pdev, info->pdev) &&
+				    !strcmp(r[n].name, info->region_names[i]))
+					break;
+
+			if (n == count) {
+				r = realloc(r, ++count * sizeof(*r));
+				igt_assert(r);
+				memset(&r[n], 0, sizeof(*r));
+				strcpy(r[n].pdev, info->pdev);
+				strcpy(r[n].name, info->region_names[i]);
+			}
+
+			r[n].peak_resident += client->peak_resident[i];
+			r[n].total += info->region_mem[i].total;
+			if (client->generation == usage->generation)
+				r[n].resident += info->region_mem[i].resident;
+		}
+	}
+
+	*regions = r;
+
+	return count;
+}
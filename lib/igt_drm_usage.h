@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_DRM_USAGE_H
+#define IGT_DRM_USAGE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "igt_drm_fdinfo.h"
+#include "igt_proc.h"
+
+/* Keep a duplicate of every client fd so that it outlives its process */
+#define IGT_DRM_USAGE_HOLD_FDS	(1 << 0)
+
+/**
+ * igt_drm_usage_client_t: A DRM client used by the tracked processes
+ * @first: fdinfo when the client was first seen
+ * @last: fdinfo at the last sample including the client
+ * @first_ns: time of @first
+ * @last_ns: time of @last
+ * @peak_resident: highest resident memory seen, per region of @last
+ * @pid: first process the client was found in
+ * @held_fd: duplicate of the client fd owned by the caller, or -1
+ */
+typedef struct {
+	struct drm_client_fdinfo first, last;
+	uint64_t first_ns, last_ns;
+	uint64_t peak_resident[DRM_CLIENT_FDINFO_MAX_REGIONS];
+	pid_t pid;
+	int held_fd;
+
+	/* private */
+	unsigned int generation;
+} igt_drm_usage_client_t;
+
+/**
+ * igt_drm_usage_t: DRM usage of a process tree
+ * @snap: process snapshot, refreshed by every sample
+ * @root: pid whose descendants are tracked
+ * @flags: IGT_DRM_USAGE_* flags
+ * @clients: clients found so far
+ * @num_clients: number of entries in @clients
+ */
+typedef struct {
+	igt_proc_snapshot_t *snap;
+	pid_t root;
+	unsigned int flags;
+	igt_drm_usage_client_t *clients;
+	int num_clients;
+
+	/* private */
+	int size;
+	unsigned int generation;
+	uint8_t *tree;
+	int tree_size;
+} igt_drm_usage_t;
+
+/**
+ * igt_drm_usage_engine_t: Busy time of an engine class of a device
+ * @pdev: PCI device of the engines
+ * @name: engine class name, as reported in fdinfo
+ * @capacity: number of engines of the class
+ * @busy_ns: time the tracked clients kept the engines busy, since each
+ *	     client was first seen
+ */
+typedef struct {
+	char pdev[128];
+	char name[256];
+	unsigned int capacity;
+	uint64_t busy_ns;
+} igt_drm_usage_engine_t;
+
+/**
+ * igt_drm_usage_region_t: Memory used in a region of a device
+ * @pdev: PCI device of the region
+ * @name: memory region name, as reported in fdinfo
+ * @peak_resident: sum over the clients of their highest resident memory
+ * @resident: sum of the resident memory of the clients in the last sample
+ * @total: sum over the clients of their last total memory
+ */
+typedef struct {
+	char pdev[128];
+	char name[256];
+	uint64_t peak_resident;
+	uint64_t resident;
+	uint64_t total;
+} igt_drm_usage_region_t;
+
+igt_drm_usage_t *igt_drm_usage_create(const char *procfs, pid_t root,
+				      unsigned int flags);
+void igt_drm_usage_destroy(igt_drm_usage_t *usage);
+int igt_drm_usage_sample(igt_drm_usage_t *usage, uint64_t now_ns);
+int igt_drm_usage_engines(igt_drm_usage_t *usage,
+			  igt_drm_usage_engine_t **engines);
+int igt_drm_usage_regions(igt_drm_usage_t *usage,
+			  igt_drm_usage_region_t **regions);
+
+#endif /* IGT_DRM_USAGE_H */
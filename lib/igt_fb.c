@@ -40,6 +40,7 @@
 #include "intel_pat.h"
 #include "igt_aux.h"
 #include "igt_color_encoding.h"
+#include "igt_damage.h"
 #include "igt_fb.h"
 #include "igt_halffloat.h"
 #include "igt_kms.h"
@@ -2808,11 +2809,31 @@ static bool use_vebox_copy(const struct igt_fb *src_fb,
 	       igt_format_is_yuv(dst_fb->drm_format);
 }
 
+static int damage_count(const igt_damage_t *damage)
+{
+	return damage ? igt_damage_count(damage) : 1;
+}
+
+/* The damaged region @idx, or the whole @plane without damage */
+static igt_damage_rect_t damage_rect(const igt_damage_t *damage,
+				     const struct igt_fb *fb,
+				     int plane, int idx)
+{
+	if (damage)
+		return *igt_damage_rect(damage, idx);
+
+	return (igt_damage_rect_t) {
+		.width = fb->plane_width[plane],
+		.height = fb->plane_height[plane],
+	};
+}
+
 /**
  * copy_with_engine:
  * @blit: context for the copy operation
  * @dst_fb: destination buffer
  * @src_fb: source buffer
+ * @damage: regions to copy, or NULL for all of it
  *
  * Copy @src_fb to @dst_fb using either the render or vebox engine. The engine
  * is selected based on the compression surface format required by the @dst_fb
@@ -2824,7 +2845,8 @@ static bool use_vebox_copy(const struct igt_fb *src_fb,
  */
 static void copy_with_engine(struct fb_blit_upload *blit,
 			     const struct igt_fb *dst_fb,
-			     const struct igt_fb *src_fb)
+			     const struct igt_fb *src_fb,
+			     const igt_damage_t *damage)
 {
 	struct intel_buf *src, *dst;
 	igt_render_copyfunc_t render_copy = NULL;
@@ -2843,17 +2865,26 @@ static void copy_with_engine(struct fb_blit_upload *blit,
 	src = create_buf(blit, src_fb, "cairo enginecopy src");
 	dst = create_buf(blit, dst_fb, "cairo enginecopy dst");
 
-	if (vebox_copy)
+	/* vebox copies whole surfaces, and partial CCS updates are untested */
+	if (vebox_copy || igt_fb_is_ccs_modifier(dst_fb->modifier))
+		damage = NULL;
+
+	if (vebox_copy) {
 		vebox_copy(blit->ibb, src,
 			   dst_fb->plane_width[0], dst_fb->plane_height[0],
 			   dst);
-	else
-		render_copy(blit->ibb,
-			    src,
-			    0, 0,
-			    dst_fb->plane_width[0], dst_fb->plane_height[0],
-			    dst,
-			    0, 0);
+	} else {
+		for (int i = 0; i < damage_count(damage); i++) {
+			igt_damage_rect_t r = damage_rect(damage, dst_fb, 0, i);
+
+			render_copy(blit->ibb,
+				    src,
+				    r.x, r.y,
+				    r.width, r.height,
+				    dst,
+				    r.x, r.y);
+		}
+	}
 
 	fini_buf(dst);
 	fini_buf(src);
@@ -3102,7 +3133,8 @@ static void do_block_copy(const struct igt_fb *src_fb,
 }
 
 static void blitcopy(const struct igt_fb *dst_fb,
-		     const struct igt_fb *src_fb)
+		     const struct igt_fb *src_fb,
+		     const igt_damage_t *damage)
 {
 	uint32_t src_tiling = igt_fb_mod_to_tiling(src_fb->modifier);
 	uint32_t dst_tiling = igt_fb_mod_to_tiling(dst_fb->modifier);
@@ -3118,6 +3150,13 @@ static void blitcopy(const struct igt_fb *dst_fb,
 	igt_assert(!igt_fb_is_gen12_rc_ccs_cc_modifier(src_fb->modifier));
 	igt_assert(!igt_fb_is_gen12_rc_ccs_cc_modifier(dst_fb->modifier));
 
+	/*
+	 * Damage is tracked for single plane fbs only, and XY_SRC_COPY
+	 * doesn't scale the x offsets of 64bpp planes.
+	 */
+	if (dst_fb->num_planes > 1 || dst_fb->plane_bpp[0] > 32)
+		damage = NULL;
+
 	setup_context_and_memory_region(dst_fb, &ctx, &ahnd, &mem_region,
 					&vm, &bb, &bb_size, &ictx,
 					&exec_queue, &xe_ctx);
@@ -3132,23 +3171,27 @@ static void blitcopy(const struct igt_fb *dst_fb,
 				      bb, bb_size, xe_ctx, NULL,
 				      intel_get_pat_idx_uc(dst_fb->fd));
 		} else if (fast_blit_ok(src_fb) && fast_blit_ok(dst_fb)) {
-			igt_blitter_fast_copy__raw(dst_fb->fd,
-						   ahnd, ctx, NULL,
-						   src_fb->gem_handle,
-						   src_fb->offsets[i],
-						   src_fb->strides[i],
-						   src_tiling,
-						   0, 0, /* src_x, src_y */
-						   src_fb->size,
-						   dst_fb->plane_width[i],
-						   dst_fb->plane_height[i],
-						   dst_fb->plane_bpp[i],
-						   dst_fb->gem_handle,
-						   dst_fb->offsets[i],
-						   dst_fb->strides[i],
-						   dst_tiling,
-						   0, 0 /* dst_x, dst_y */,
-						   dst_fb->size);
+			for (int j = 0; j < damage_count(damage); j++) {
+				igt_damage_rect_t r = damage_rect(damage, dst_fb, i, j);
+
+				igt_blitter_fast_copy__raw(dst_fb->fd,
+							   ahnd, ctx, NULL,
+							   src_fb->gem_handle,
+							   src_fb->offsets[i],
+							   src_fb->strides[i],
+							   src_tiling,
+							   r.x, r.y,
+							   src_fb->size,
+							   r.width,
+							   r.height,
+							   dst_fb->plane_bpp[i],
+							   dst_fb->gem_handle,
+							   dst_fb->offsets[i],
+							   dst_fb->strides[i],
+							   dst_tiling,
+							   r.x, r.y,
+							   dst_fb->size);
+			}
 		} else if (ahnd && block_copy_ok(src_fb) && block_copy_ok(dst_fb)) {
 			for_each_ctx_engine(src_fb->fd, ictx, e) {
 				if (gem_engine_can_block_copy(src_fb->fd, e)) {
@@ -3160,23 +3203,27 @@ static void blitcopy(const struct igt_fb *dst_fb,
 			}
 			igt_assert_f(e, "No block copy capable engine found!\n");
 		} else {
-			igt_blitter_src_copy(dst_fb->fd,
-					     ahnd, ctx, NULL,
-					     src_fb->gem_handle,
-					     src_fb->offsets[i],
-					     src_fb->strides[i],
-					     src_tiling,
-					     0, 0, /* src_x, src_y */
-					     src_fb->size,
-					     dst_fb->plane_width[i],
-					     dst_fb->plane_height[i],
-					     dst_fb->plane_bpp[i],
-					     dst_fb->gem_handle,
-					     dst_fb->offsets[i],
-					     dst_fb->strides[i],
-					     dst_tiling,
-					     0, 0 /* dst_x, dst_y */,
-					     dst_fb->size);
+			for (int j = 0; j < damage_count(damage); j++) {
+				igt_damage_rect_t r = damage_rect(damage, dst_fb, i, j);
+
+				igt_blitter_src_copy(dst_fb->fd,
+						     ahnd, ctx, NULL,
+						     src_fb->gem_handle,
+						     src_fb->offsets[i],
+						     src_fb->strides[i],
+						     src_tiling,
+						     r.x, r.y,
+						     src_fb->size,
+						     r.width,
+						     r.height,
+						     dst_fb->plane_bpp[i],
+						     dst_fb->gem_handle,
+						     dst_fb->offsets[i],
+						     dst_fb->strides[i],
+						     dst_tiling,
+						     r.x, r.y,
+						     dst_fb->size);
+			}
 		}
 	}
 
@@ -3223,6 +3270,62 @@ void igt_xe2_blit_with_dst_pat(const struct igt_fb *dst_fb,
 			      src_fb->fd, NULL);
 }
 
+/* Copies the linear BO back to the fb, the damaged regions only if given */
+static void writeback_linear(struct fb_blit_upload *blit,
+			     const igt_damage_t *damage)
+{
+	int fd = blit->fd;
+	struct igt_fb *fb = blit->fb;
+	struct fb_blit_linear *linear = &blit->linear;
+
+	if (!is_xe_device(fd))
+		gem_set_domain(fd, linear->fb.gem_handle,
+			       I915_GEM_DOMAIN_GTT, 0);
+
+	if (blit->ibb)
+		copy_with_engine(blit, fb, &linear->fb, damage);
+	else
+		blitcopy(fb, &linear->fb, damage);
+
+	if (!is_xe_device(fd))
+		gem_sync(fd, linear->fb.gem_handle);
+}
+
+/* Copies the fb to the linear BO, leaving it ready for CPU access */
+static void readback_linear(struct fb_blit_upload *blit)
+{
+	int fd = blit->fd;
+	struct igt_fb *fb = blit->fb;
+	struct fb_blit_linear *linear = &blit->linear;
+
+	if (!is_xe_device(fd))
+		gem_set_domain(fd, linear->fb.gem_handle,
+			       I915_GEM_DOMAIN_GTT, 0);
+
+	if (blit->ibb)
+		copy_with_engine(blit, &linear->fb, fb, NULL);
+	else
+		blitcopy(&linear->fb, fb, NULL);
+
+	if (!is_xe_device(fd)) {
+		gem_sync(fd, linear->fb.gem_handle);
+		gem_set_domain(fd, linear->fb.gem_handle,
+			       I915_GEM_DOMAIN_CPU, I915_GEM_DOMAIN_CPU);
+	}
+}
+
+static void *map_linear(struct fb_blit_upload *blit)
+{
+	struct fb_blit_linear *linear = &blit->linear;
+
+	if (is_xe_device(blit->fd))
+		return xe_bo_mmap_ext(blit->fd, linear->fb.gem_handle,
+				      linear->fb.size, PROT_READ | PROT_WRITE);
+
+	return gem_mmap__cpu(blit->fd, linear->fb.gem_handle,
+			     0, linear->fb.size, PROT_READ | PROT_WRITE);
+}
+
 static void free_linear_mapping(struct fb_blit_upload *blit)
 {
 	int fd = blit->fd;
@@ -3244,26 +3347,9 @@ static void free_linear_mapping(struct fb_blit_upload *blit)
 	} else if (is_nouveau_device(fd)) {
 		igt_nouveau_fb_blit(fb, &linear->fb);
 		igt_nouveau_delete_bo(&linear->fb);
-	} else if (is_xe_device(fd)) {
-		gem_munmap(linear->map, linear->fb.size);
-
-		if (blit->ibb)
-			copy_with_engine(blit, fb, &linear->fb);
-		else
-			blitcopy(fb, &linear->fb);
-
-		gem_close(fd, linear->fb.gem_handle);
 	} else {
 		gem_munmap(linear->map, linear->fb.size);
-		gem_set_domain(fd, linear->fb.gem_handle,
-			I915_GEM_DOMAIN_GTT, 0);
-
-		if (blit->ibb)
-			copy_with_engine(blit, fb, &linear->fb);
-		else
-			blitcopy(fb, &linear->fb);
-
-		gem_sync(fd, linear->fb.gem_handle);
+		writeback_linear(blit, NULL);
 		gem_close(fd, linear->fb.gem_handle);
 	}
 
@@ -3330,33 +3416,143 @@ static void setup_linear_mapping(struct fb_blit_upload *blit)
 		igt_nouveau_fb_blit(&linear->fb, fb);
 
 		linear->map = igt_nouveau_mmap_bo(&linear->fb, PROT_READ | PROT_WRITE);
-	} else if (is_xe_device(fd)) {
-		if (blit->ibb)
-			copy_with_engine(blit, &linear->fb, fb);
-		else
-			blitcopy(&linear->fb, fb);
-
-		linear->map = xe_bo_mmap_ext(fd, linear->fb.gem_handle,
-					     linear->fb.size, PROT_READ | PROT_WRITE);
 	} else {
 		/* Copy fb content to linear BO */
-		gem_set_domain(fd, linear->fb.gem_handle,
-				I915_GEM_DOMAIN_GTT, 0);
+		readback_linear(blit);
 
-		if (blit->ibb)
-			copy_with_engine(blit, &linear->fb, fb);
-		else
-			blitcopy(&linear->fb, fb);
+		/* Setup cairo context */
+		linear->map = map_linear(blit);
+	}
+}
 
-		gem_sync(fd, linear->fb.gem_handle);
+/*
+ * Cairo draws into @ptr, a copy of the fb in system memory kept across
+ * cairo surfaces along with the linear BO, its mapping and the engine copy
+ * objects. @ref holds the contents as of the last write-back, comparing
+ * both tells the regions to write back.
+ */
+struct fb_shadow {
+	struct fb_blit_upload blit;
+	uint8_t *ptr;
+	uint8_t *ref;
+	size_t size;
+	igt_damage_t damage;
+	bool valid;
+};
 
-		gem_set_domain(fd, linear->fb.gem_handle,
-			I915_GEM_DOMAIN_CPU, I915_GEM_DOMAIN_CPU);
+/* Tile size for the damage, about the copy granularity of tiled fbs */
+#define SHADOW_TILE_WIDTH 64
+#define SHADOW_TILE_HEIGHT 16
 
-		/* Setup cairo context */
-		linear->map = gem_mmap__cpu(fd, linear->fb.gem_handle,
-					0, linear->fb.size, PROT_READ | PROT_WRITE);
+static void shadow_setup(struct fb_shadow *shadow, struct igt_fb *fb)
+{
+	struct fb_blit_upload *blit = &shadow->blit;
+	struct fb_blit_linear *linear = &blit->linear;
+
+	if (use_enginecopy(fb)) {
+		blit->bops = buf_ops_create(fb->fd);
+		blit->ibb = intel_bb_create(fb->fd, 4096);
 	}
+
+	igt_init_fb(&linear->fb, fb->fd, fb->width, fb->height,
+		    fb->drm_format, DRM_FORMAT_MOD_LINEAR,
+		    fb->color_encoding, fb->color_range);
+	create_bo_for_fb(&linear->fb, true);
+	igt_assert(linear->fb.gem_handle > 0);
+	linear->map = map_linear(blit);
+
+	shadow->size = (size_t)linear->fb.strides[0] * fb->height;
+	shadow->ptr = malloc(shadow->size);
+	shadow->ref = malloc(shadow->size);
+	igt_assert(shadow->ptr && shadow->ref);
+
+	igt_damage_init(&shadow->damage, fb->width, fb->height);
+}
+
+static void shadow_flush(struct fb_shadow *shadow)
+{
+	struct fb_blit_upload *blit = &shadow->blit;
+	struct fb_blit_linear *linear = &blit->linear;
+	unsigned int stride = linear->fb.strides[0];
+	unsigned int cpp = linear->fb.plane_bpp[0] / 8;
+
+	if (!igt_damage_diff(&shadow->damage, shadow->ptr, shadow->ref,
+			     stride, cpp,
+			     SHADOW_TILE_WIDTH, SHADOW_TILE_HEIGHT))
+		return;
+
+	if (!is_xe_device(blit->fd))
+		gem_set_domain(blit->fd, linear->fb.gem_handle,
+			       I915_GEM_DOMAIN_CPU, I915_GEM_DOMAIN_CPU);
+
+	igt_damage_copy(&shadow->damage, linear->map, shadow->ptr, stride, cpp);
+	writeback_linear(blit, &shadow->damage);
+	igt_damage_copy(&shadow->damage, shadow->ref, shadow->ptr, stride, cpp);
+
+	igt_damage_reset(&shadow->damage);
+}
+
+static void destroy_cairo_surface__shadow(void *arg)
+{
+	struct fb_shadow *shadow = arg;
+
+	shadow->blit.fb->cairo_surface = NULL;
+
+	shadow_flush(shadow);
+}
+
+static void create_cairo_surface__shadow(struct igt_fb *fb)
+{
+	struct fb_shadow *shadow = fb->shadow;
+	struct fb_blit_upload *blit = &shadow->blit;
+
+	/* the igt_fb may have been copied since */
+	blit->fd = fb->fd;
+	blit->fb = fb;
+
+	if (!blit->linear.map)
+		shadow_setup(shadow, fb);
+
+	if (!shadow->valid) {
+		readback_linear(blit);
+		memcpy(shadow->ptr, blit->linear.map, shadow->size);
+		memcpy(shadow->ref, shadow->ptr, shadow->size);
+		shadow->valid = true;
+	}
+
+	fb->cairo_surface =
+		cairo_image_surface_create_for_data(shadow->ptr,
+						    drm_format_to_cairo(fb->drm_format),
+						    fb->width, fb->height,
+						    blit->linear.fb.strides[0]);
+	fb->domain = I915_GEM_DOMAIN_GTT;
+
+	cairo_surface_set_user_data(fb->cairo_surface,
+				    (cairo_user_data_key_t *)create_cairo_surface__shadow,
+				    shadow, destroy_cairo_surface__shadow);
+}
+
+static void free_shadow(struct igt_fb *fb)
+{
+	struct fb_shadow *shadow = fb->shadow;
+	struct fb_blit_linear *linear = &shadow->blit.linear;
+
+	if (linear->map) {
+		gem_munmap(linear->map, linear->fb.size);
+		gem_close(fb->fd, linear->fb.gem_handle);
+
+		if (shadow->blit.ibb) {
+			intel_bb_destroy(shadow->blit.ibb);
+			buf_ops_destroy(shadow->blit.bops);
+		}
+
+		igt_damage_fini(&shadow->damage);
+		free(shadow->ptr);
+		free(shadow->ref);
+	}
+
+	free(shadow);
+	fb->shadow = NULL;
 }
 
 static void create_cairo_surface__gpu(int fd, struct igt_fb *fb)
@@ -3364,6 +3560,11 @@ static void create_cairo_surface__gpu(int fd, struct igt_fb *fb)
 	struct fb_blit_upload *blit;
 	cairo_format_t cairo_format;
 
+	if (fb->shadow && is_intel_device(fd)) {
+		create_cairo_surface__shadow(fb);
+		return;
+	}
+
 	blit = calloc(1, sizeof(*blit));
 	igt_assert(blit);
 
@@ -3384,6 +3585,50 @@ static void create_cairo_surface__gpu(int fd, struct igt_fb *fb)
 				    blit, destroy_cairo_surface__gpu);
 }
 
+/**
+ * igt_fb_enable_shadow:
+ * @fb: pointer to an #igt_fb structure
+ *
+ * Keeps the linear copy cairo draws into for tiled Intel framebuffers
+ * around, instead of creating it for every igt_get_cairo_surface() and
+ * writing all of it back when the surface is released. The framebuffer is
+ * read back once, and releasing the surface only writes back the regions
+ * which changed since, which suits tests redrawing small parts of a
+ * framebuffer repeatedly.
+ *
+ * The copy isn't updated by writes to the framebuffer from anything else
+ * than cairo, like the GPU or a direct mapping, so callers need to call
+ * igt_fb_invalidate_shadow() after those. Framebuffers not using a linear
+ * copy ignore this. The copy is freed by igt_remove_fb().
+ */
+void igt_fb_enable_shadow(struct igt_fb *fb)
+{
+	if (fb->shadow)
+		return;
+
+	fb->shadow = calloc(1, sizeof(struct fb_shadow));
+	igt_assert(fb->shadow);
+}
+
+/**
+ * igt_fb_invalidate_shadow:
+ * @fb: pointer to an #igt_fb structure
+ *
+ * Makes the next igt_get_cairo_surface() read @fb back, after it was
+ * written to without cairo. This must not be called while a cairo surface
+ * of @fb is in use, as its drawing would be lost.
+ */
+void igt_fb_invalidate_shadow(struct igt_fb *fb)
+{
+	struct fb_shadow *shadow = fb->shadow;
+
+	if (!shadow)
+		return;
+
+	igt_assert(!fb->cairo_surface);
+	shadow->valid = false;
+}
+
 /**
  * igt_dirty_fb:
  * @fd: open drm file descriptor
@@ -4738,6 +4983,8 @@ void igt_remove_fb(int fd, struct igt_fb *fb)
 		return;
 
 	cairo_surface_destroy(fb->cairo_surface);
+	if (fb->shadow)
+		free_shadow(fb);
 	do_or_die(drmModeRmFB(fd, fb->fb_id));
 	if (fb->is_dumb)
 		kmstest_dumb_destroy(fd, fb->gem_handle);
@@ -77,6 +77,7 @@ typedef struct _igt_crc igt_crc_t;
  * @plane_width: The width for each plane.
  * @plane_height: The height for each plane.
  * @driver_priv: Private driver-specific data, if any
+ * @shadow: Persistent linear copy for cairo, see igt_fb_enable_shadow()
  *
  * Tracking structure for KMS framebuffer objects.
  */
@@ -101,6 +102,7 @@ typedef struct igt_fb {
 	unsigned int plane_width[4];
 	unsigned int plane_height[4];
 	void *driver_priv;
+	void *shadow;
 } igt_fb_t;
 
 /**
@@ -193,6 +195,8 @@ void igt_xe2_blit_with_dst_pat(const struct igt_fb *dst_fb,
 
 /* cairo-based painting */
 cairo_surface_t *igt_get_cairo_surface(int fd, struct igt_fb *fb);
+void igt_fb_enable_shadow(struct igt_fb *fb);
+void igt_fb_invalidate_shadow(struct igt_fb *fb);
 cairo_surface_t *igt_cairo_image_surface_create_from_png(const char *filename);
 cairo_t *igt_get_cairo_ctx(int fd, struct igt_fb *fb);
 void igt_put_cairo_ctx(cairo_t *cr);
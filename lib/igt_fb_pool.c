@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "igt_core.h"
+#include "igt_fb.h"
+#include "igt_fb_pool.h"
+
+/**
+ * SECTION:igt_fb_pool
+ * @short_description: Recycling of framebuffers
+ * @title: Framebuffer pool
+ * @include: igt_fb_pool.h
+ *
+ * Format and modifier sweeps create and remove the same framebuffers for
+ * every pipe and output, each time allocating a buffer object, computing
+ * its layout and adding a KMS framebuffer. A framebuffer pool keeps the
+ * framebuffers returned to it, and hands them out again for the same
+ * size, format and modifier, the latter covering tiling and compression.
+ *
+ * The contents of a recycled framebuffer are whatever its previous user
+ * left, unless IGT_FB_POOL_CLEAR asks for black. Recycled framebuffers are
+ * only cleared then, and if they were used since the last clear. Idle
+ * framebuffers beyond the size limit of the pool are removed, least
+ * recently used first. Framebuffers not returned to the pool are reported
+ * when it is destroyed, and at exit.
+ *
+ * |[<!-- language="c" -->
+ *	struct igt_fb_pool *pool = igt_fb_pool_create(fd, 256 << 20);
+ *
+ *	for_each_pipe_with_valid_output(display, pipe, output) {
+ *		igt_fb_pool_get(pool, mode->hdisplay, mode->vdisplay,
+ *				DRM_FORMAT_XRGB8888, modifier,
+ *				IGT_FB_POOL_CLEAR, &fb);
+ *		...
+ *		igt_fb_pool_put(pool, &fb);
+ *	}
+ *
+ *	igt_fb_pool_destroy(pool);
+ * ]|
+ */
+
+struct pool_entry {
+	struct igt_list_head link;
+	struct igt_fb fb;
+	bool dirty;
+};
+
+static IGT_LIST_HEAD(pools);
+
+static void entry_destroy(struct igt_fb_pool *pool, struct pool_entry *entry)
+{
+	pool->ops->destroy(pool, &entry->fb);
+	igt_list_del(&entry->link);
+	free(entry);
+}
+
+static bool entry_match(const struct pool_entry *entry, int width, int height,
+			uint32_t format, uint64_t modifier)
+{
+	return entry->fb.width == width && entry->fb.height == height &&
+		entry->fb.drm_format == format &&
+		entry->fb.modifier == modifier;
+}
+
+static void report_leaks_at_exit(int sig)
+{
+	struct igt_fb_pool *pool;
+
+	igt_list_for_each_entry(pool, &pools, link)
+		igt_fb_pool_report_leaks(pool);
+}
+
+/**
+ * __igt_fb_pool_create:
+ * @fd: DRM device fd
+ * @max_bytes: size of the idle framebuffers to keep at most
+ * @ops: backend creating and destroying the framebuffers
+ * @priv: backend private data
+ *
+ * Creates a pool on a caller provided backend. Allows exercising the pool
+ * without a device, igt_fb_pool_create() should be used otherwise.
+ *
+ * Returns: a new pool, to be released with igt_fb_pool_destroy().
+ */
+struct igt_fb_pool *__igt_fb_pool_create(int fd, uint64_t max_bytes,
+					 const struct igt_fb_pool_ops *ops,
+					 void *priv)
+{
+	static bool exit_handler;
+	struct igt_fb_pool *pool;
+
+	pool = calloc(1, sizeof(*pool));
+	igt_assert(pool);
+
+	pool->fd = fd;
+	pool->max_bytes = max_bytes;
+	pool->ops = ops;
+	pool->priv = priv;
+	IGT_INIT_LIST_HEAD(&pool->idle);
+	IGT_INIT_LIST_HEAD(&pool->used);
+
+	if (!exit_handler) {
+		igt_install_exit_handler(report_leaks_at_exit);
+		exit_handler = true;
+	}
+	igt_list_add_tail(&pool->link, &pools);
+
+	return pool;
+}
+
+static unsigned int pool_create(struct igt_fb_pool *pool, int width, int height,
+				uint32_t format, uint64_t modifier,
+				struct igt_fb *fb)
+{
+	return igt_create_fb(pool->fd, width, height, format, modifier, fb);
+}
+
+static void pool_destroy(struct igt_fb_pool *pool, struct igt_fb *fb)
+{
+	igt_remove_fb(pool->fd, fb);
+}
+
+static void pool_clear(struct igt_fb_pool *pool, struct igt_fb *fb)
+{
+	cairo_t *cr = igt_get_cairo_ctx(pool->fd, fb);
+
+	igt_paint_color(cr, 0, 0, fb->width, fb->height, 0, 0, 0);
+	igt_put_cairo_ctx(cr);
+}
+
+static void pool_release(struct igt_fb_pool *pool, struct igt_fb *fb)
+{
+	/* flushes the drawing, as igt_remove_fb() would */
+	cairo_surface_destroy(fb->cairo_surface);
+	fb->cairo_surface = NULL;
+}
+
+static const struct igt_fb_pool_ops pool_ops = {
+	.create = pool_create,
+	.destroy = pool_destroy,
+	.clear = pool_clear,
+	.release = pool_release,
+};
+
+/**
+ * igt_fb_pool_create:
+ * @fd: DRM device fd
+ * @max_bytes: size of the idle framebuffers to keep at most
+ *
+ * Creates a pool of framebuffers created with igt_create_fb() on @fd.
+ *
+ * Returns: a new pool, to be released with igt_fb_pool_destroy().
+ */
+struct igt_fb_pool *igt_fb_pool_create(int fd, uint64_t max_bytes)
+{
+	return __igt_fb_pool_create(fd, max_bytes, &pool_ops, NULL);
+}
+
+/**
+ * igt_fb_pool_report_leaks:
+ * @pool: pool
+ *
+ * Warns about each framebuffer of @pool not returned with
+ * igt_fb_pool_put().
+ *
+ * Returns: the number of such framebuffers.
+ */
+int igt_fb_pool_report_leaks(struct igt_fb_pool *pool)
+{
+	struct pool_entry *entry;
+	int count = 0;
+
+	igt_list_for_each_entry(entry, &pool->used, link) {
+		igt_warn("Framebuffer %u (%dx%d, format=" IGT_FORMAT_FMT
+			 ", modifier=0x%" PRIx64 ") not returned to the pool\n",
+			 entry->fb.fb_id, entry->fb.width, entry->fb.height,
+			 IGT_FORMAT_ARGS(entry->fb.drm_format),
+			 entry->fb.modifier);
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * igt_fb_pool_destroy:
+ * @pool: pool
+ *
+ * Removes the idle framebuffers of @pool and frees it. The framebuffers
+ * not returned to the pool are reported, and left to their users.
+ *
+ * Returns: the number of framebuffers not returned to the pool.
+ */
+int igt_fb_pool_destroy(struct igt_fb_pool *pool)
+{
+	struct pool_entry *entry, *tmp;
+	int leaks;
+
+	leaks = igt_fb_pool_report_leaks(pool);
+	igt_list_for_each_entry_safe(entry, tmp, &pool->used, link) {
+		igt_list_del(&entry->link);
+		free(entry);
+	}
+
+	igt_fb_pool_trim(pool, 0);
+	igt_list_del(&pool->link);
+	free(pool);
+
+	return leaks;
+}
+
+/**
+ * igt_fb_pool_get:
+ * @pool: pool
+ * @width: width of the framebuffer in pixel
+ * @height: height of the framebuffer in pixel
+ * @format: drm fourcc pixel format code
+ * @modifier: tiling layout of the framebuffer
+ * @flags: IGT_FB_POOL_CLEAR to get a black framebuffer, or 0 for any
+ *         contents
+ * @fb: pointer to an #igt_fb structure
+ *
+ * Like igt_create_fb(), but recycles a framebuffer of @pool if one was
+ * returned with the same parameters, the most recently returned first.
+ * Without IGT_FB_POOL_CLEAR, the contents of a recycled framebuffer are
+ * whatever its previous user left. The framebuffer must be returned with
+ * igt_fb_pool_put() instead of being removed.
+ *
+ * Returns: the KMS id of the framebuffer.
+ */
+unsigned int igt_fb_pool_get(struct igt_fb_pool *pool, int width, int height,
+			     uint32_t format, uint64_t modifier,
+			     unsigned int flags, struct igt_fb *fb)
+{
+	struct pool_entry *entry;
+
+	igt_list_for_each_entry_reverse(entry, &pool->idle, link) {
+		if (!entry_match(entry, width, height, format, modifier))
+			continue;
+
+		igt_list_move_tail(&entry->link, &pool->used);
+		pool->idle_bytes -= entry->fb.size;
+		pool->stats.hits++;
+
+		if ((flags & IGT_FB_POOL_CLEAR) && entry->dirty) {
+			pool->ops->clear(pool, &entry->fb);
+			pool->stats.clears++;
+			entry->dirty = false;
+		}
+
+		*fb = entry->fb;
+
+		return fb->fb_id;
+	}
+
+	entry = calloc(1, sizeof(*entry));
+	igt_assert(entry);
+
+	/* new framebuffers are black already */
+	pool->ops->create(pool, width, height, format, modifier, &entry->fb);
+	igt_list_add_tail(&entry->link, &pool->used);
+	pool->stats.misses++;
+
+	*fb = entry->fb;
+
+	return fb->fb_id;
+}
+
+/**
+ * igt_fb_pool_put:
+ * @pool: pool
+ * @fb: framebuffer from igt_fb_pool_get()
+ *
+ * Returns @fb to @pool, for reuse by igt_fb_pool_get(). Like with
+ * igt_remove_fb(), @fb is not to be used anymore, its KMS id is reset.
+ * The least recently used idle framebuffers beyond the size limit of the
+ * pool are removed, or @fb itself if it exceeds the limit alone.
+ */
+void igt_fb_pool_put(struct igt_fb_pool *pool, struct igt_fb *fb)
+{
+	struct pool_entry *entry;
+
+	if (!fb->fb_id)
+		return;
+
+	igt_list_for_each_entry(entry, &pool->used, link)
+		if (entry->fb.fb_id == fb->fb_id)
+			break;
+	igt_assert_f(&entry->link != &pool->used,
+		     "Framebuffer %u is not from this pool\n", fb->fb_id);
+
+	if (pool->ops->release)
+		pool->ops->release(pool, fb);
+
+	entry->fb = *fb;
+	entry->dirty = true;
+	fb->fb_id = 0;
+
+	/* rather than evicting everything else for it */
+	if (entry->fb.size > pool->max_bytes) {
+		pool->stats.evictions++;
+		entry_destroy(pool, entry);
+		return;
+	}
+
+	igt_list_move_tail(&entry->link, &pool->idle);
+	pool->idle_bytes += entry->fb.size;
+
+	igt_fb_pool_trim(pool, pool->max_bytes);
+}
+
+/**
+ * igt_fb_pool_trim:
+ * @pool: pool
+ * @max_bytes: size of the idle framebuffers to keep at most
+ *
+ * Removes the least recently used idle framebuffers of @pool, until their
+ * size is @max_bytes at most. Trimming to 0 removes all of them.
+ */
+void igt_fb_pool_trim(struct igt_fb_pool *pool, uint64_t max_bytes)
+{
+	while (pool->idle_bytes > max_bytes) {
+		struct pool_entry *entry;
+
+		entry = igt_list_first_entry(&pool->idle, entry, link);
+		pool->idle_bytes -= entry->fb.size;
+		pool->stats.evictions++;
+		entry_destroy(pool, entry);
+	}
+}
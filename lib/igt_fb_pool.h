@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_FB_POOL_H
+#define IGT_FB_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "igt_fb.h"
+#include "igt_list.h"
+
+#define IGT_FB_POOL_CLEAR (1 << 0)
+
+struct igt_fb_pool;
+
+/**
+ * igt_fb_pool_ops:
+ * @create: creates @fb like igt_create_fb(), returning its KMS id
+ * @destroy: destroys @fb like igt_remove_fb()
+ * @clear: paints @fb black
+ * @release: detaches what the user of @fb left attached to it, when it
+ *           returns to the pool, may be NULL
+ */
+struct igt_fb_pool_ops {
+	unsigned int (*create)(struct igt_fb_pool *pool, int width, int height,
+			       uint32_t format, uint64_t modifier,
+			       struct igt_fb *fb);
+	void (*destroy)(struct igt_fb_pool *pool, struct igt_fb *fb);
+	void (*clear)(struct igt_fb_pool *pool, struct igt_fb *fb);
+	void (*release)(struct igt_fb_pool *pool, struct igt_fb *fb);
+};
+
+/**
+ * igt_fb_pool:
+ * @fd: DRM device fd the framebuffers are created on
+ * @max_bytes: size of the idle framebuffers kept at most
+ * @ops: backend creating and destroying the framebuffers
+ * @priv: backend private data
+ * @idle: framebuffers available for reuse, least recently used first
+ * @used: framebuffers handed out by igt_fb_pool_get()
+ * @idle_bytes: size of the framebuffers in @idle
+ * @link: in the list of pools checked for leaks at exit
+ * @stats: counters of the pool activity
+ */
+struct igt_fb_pool {
+	int fd;
+	uint64_t max_bytes;
+
+	const struct igt_fb_pool_ops *ops;
+	void *priv;
+
+	struct igt_list_head idle;
+	struct igt_list_head used;
+	uint64_t idle_bytes;
+
+	struct igt_list_head link;
+
+	struct {
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t clears;
+		uint64_t evictions;
+	} stats;
+};
+
+struct igt_fb_pool *__igt_fb_pool_create(int fd, uint64_t max_bytes,
+					 const struct igt_fb_pool_ops *ops,
+					 void *priv);
+struct igt_fb_pool *igt_fb_pool_create(int fd, uint64_t max_bytes);
+int igt_fb_pool_destroy(struct igt_fb_pool *pool);
+unsigned int igt_fb_pool_get(struct igt_fb_pool *pool, int width, int height,
+			     uint32_t format, uint64_t modifier,
+			     unsigned int flags, struct igt_fb *fb);
+void igt_fb_pool_put(struct igt_fb_pool *pool, struct igt_fb *fb);
+void igt_fb_pool_trim(struct igt_fb_pool *pool, uint64_t max_bytes);
+int igt_fb_pool_report_leaks(struct igt_fb_pool *pool);
+
+#endif /* IGT_FB_POOL_H */
@@ -0,0 +1,342 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dmabuf_sync_file.h"
+#include "drmtest.h"
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_fence_mux.h"
+#include "igt_syncobj.h"
+#include "sw_sync.h"
+
+/**
+ * SECTION:igt_fence_mux
+ * @short_description: Wait for many fences of different kinds at once
+ * @title: Fence multiplexer
+ * @include: igt_fence_mux.h
+ *
+ * syncobj_wait(), sync_fence_wait() and dmabuf_sync_file_busy() each wait
+ * for one kind of fence, so tests tracking many submissions of different
+ * kinds end up polling them in turn. The fence multiplexer turns every
+ * fence into a file descriptor registered in a single epoll instance:
+ * sync_files as they are, dma-bufs through the sync_file of their fences,
+ * and syncobj points through an eventfd. Any other file descriptor
+ * becoming readable once signaled, like an eventfd, can be added as well.
+ *
+ * Each fence has a callback, called once from igt_fence_mux_wait_any() or
+ * igt_fence_mux_wait_all() with the completion status and time, after
+ * which the fence is forgotten. Callbacks may add new fences.
+ *
+ * |[<!-- language="c" -->
+ *	igt_fence_mux_t mux;
+ *
+ *	igt_fence_mux_init(&mux);
+ *	for (int i = 0; i < count; i++)
+ *		igt_fence_mux_add_sync_file(&mux, fences[i], retire, &jobs[i]);
+ *	igt_assert_eq(igt_fence_mux_wait_all(&mux, igt_fence_mux_deadline(NSEC_PER_SEC)),
+ *		      count);
+ *	igt_fence_mux_fini(&mux);
+ * ]|
+ */
+
+struct fence {
+	struct igt_list_head link;
+	int fd;
+	bool sync_file;
+	igt_fence_mux_cb_t cb;
+	void *data;
+};
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+
+	/* the clock of dma_fence timestamps */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * igt_fence_mux_init:
+ * @mux: multiplexer to initialize
+ *
+ * Initializes @mux without any fence.
+ */
+void igt_fence_mux_init(igt_fence_mux_t *mux)
+{
+	mux->epoll = epoll_create1(EPOLL_CLOEXEC);
+	igt_assert(mux->epoll >= 0);
+
+	IGT_INIT_LIST_HEAD(&mux->pending);
+	mux->num_pending = 0;
+	mux->completed = 0;
+}
+
+static void fence_free(igt_fence_mux_t *mux, struct fence *f)
+{
+	epoll_ctl(mux->epoll, EPOLL_CTL_DEL, f->fd, NULL);
+	close(f->fd);
+	igt_list_del(&f->link);
+	mux->num_pending--;
+	free(f);
+}
+
+/**
+ * igt_fence_mux_fini:
+ * @mux: multiplexer
+ *
+ * Frees @mux, dropping the fences still pending without calling their
+ * callbacks.
+ */
+void igt_fence_mux_fini(igt_fence_mux_t *mux)
+{
+	struct fence *f, *tmp;
+
+	igt_list_for_each_entry_safe(f, tmp, &mux->pending, link)
+		fence_free(mux, f);
+
+	close(mux->epoll);
+	mux->epoll = -1;
+}
+
+static void fence_add(igt_fence_mux_t *mux, int fd, bool sync_file,
+		      igt_fence_mux_cb_t cb, void *data)
+{
+	struct epoll_event ev = { .events = EPOLLIN | EPOLLONESHOT };
+	struct fence *f;
+
+	igt_assert(fd >= 0);
+
+	f = malloc(sizeof(*f));
+	igt_assert(f);
+	f->fd = fd;
+	f->sync_file = sync_file;
+	f->cb = cb;
+	f->data = data;
+
+	ev.data.ptr = f;
+	igt_assert_f(epoll_ctl(mux->epoll, EPOLL_CTL_ADD, fd, &ev) == 0,
+		     "Cannot poll fd %d: %m\n", fd);
+
+	igt_list_add_tail(&f->link, &mux->pending);
+	mux->num_pending++;
+}
+
+/**
+ * igt_fence_mux_add_fd:
+ * @mux: multiplexer
+ * @fd: file descriptor becoming readable once signaled, like an eventfd
+ * @cb: called once @fd is readable
+ * @data: passed to @cb
+ *
+ * Adds a generic fence to @mux, which takes ownership of @fd.
+ */
+void igt_fence_mux_add_fd(igt_fence_mux_t *mux, int fd,
+			  igt_fence_mux_cb_t cb, void *data)
+{
+	fence_add(mux, fd, false, cb, data);
+}
+
+/**
+ * igt_fence_mux_add_sync_file:
+ * @mux: multiplexer
+ * @sync_file: sync_file fd
+ * @cb: called once @sync_file signals
+ * @data: passed to @cb
+ *
+ * Adds a sync_file to @mux, which takes ownership of @sync_file. The
+ * callback gets the status and time the sync_file signaled with.
+ */
+void igt_fence_mux_add_sync_file(igt_fence_mux_t *mux, int sync_file,
+				 igt_fence_mux_cb_t cb, void *data)
+{
+	fence_add(mux, sync_file, true, cb, data);
+}
+
+/**
+ * igt_fence_mux_add_dmabuf:
+ * @mux: multiplexer
+ * @dmabuf: dma-buf fd
+ * @flags: DMA_BUF_SYNC_READ and/or DMA_BUF_SYNC_WRITE, as for
+ *         dmabuf_export_sync_file()
+ * @cb: called once the fences of @dmabuf signal
+ * @data: passed to @cb
+ *
+ * Adds the fences currently attached to @dmabuf to @mux, through an
+ * exported sync_file. @dmabuf itself stays owned by the caller.
+ */
+void igt_fence_mux_add_dmabuf(igt_fence_mux_t *mux, int dmabuf,
+			      uint32_t flags, igt_fence_mux_cb_t cb,
+			      void *data)
+{
+	fence_add(mux, dmabuf_export_sync_file(dmabuf, flags), true, cb, data);
+}
+
+/**
+ * igt_fence_mux_add_syncobj:
+ * @mux: multiplexer
+ * @fd: drm fd
+ * @handle: syncobj handle
+ * @point: timeline point, or 0 for binary syncobjs
+ * @flags: DRM_SYNCOBJ_WAIT_FLAGS_WAIT_AVAILABLE to wait for the point to
+ *         be submitted only, or 0
+ * @cb: called once the point signals
+ * @data: passed to @cb
+ *
+ * Adds a syncobj point to @mux, through an eventfd attached with
+ * syncobj_eventfd().
+ */
+void igt_fence_mux_add_syncobj(igt_fence_mux_t *mux, int fd, uint32_t handle,
+			       uint64_t point, uint32_t flags,
+			       igt_fence_mux_cb_t cb, void *data)
+{
+	int ev_fd = eventfd(0, EFD_CLOEXEC);
+
+	igt_assert(ev_fd >= 0);
+	syncobj_eventfd(fd, handle, point, flags, ev_fd);
+	fence_add(mux, ev_fd, false, cb, data);
+}
+
+/**
+ * igt_fence_mux_deadline:
+ * @timeout_ns: time from now
+ *
+ * Returns: the deadline @timeout_ns from now, for the wait functions.
+ */
+int64_t igt_fence_mux_deadline(int64_t timeout_ns)
+{
+	int64_t now = now_ns();
+
+	if (timeout_ns >= IGT_FENCE_MUX_FOREVER - now)
+		return IGT_FENCE_MUX_FOREVER;
+
+	return now + timeout_ns;
+}
+
+/* Returns: whether @f completed, instead of being woken up early */
+static bool fence_complete(igt_fence_mux_t *mux, struct fence *f,
+			   uint32_t events)
+{
+	struct epoll_event ev = { .events = EPOLLIN | EPOLLONESHOT };
+	uint64_t timestamp = now_ns();
+	int status = 1;
+
+	if (f->sync_file) {
+		status = sync_fence_status(f->fd);
+		if (status == SW_SYNC_FENCE_STATUS_ACTIVE) {
+			ev.data.ptr = f;
+			igt_assert(!epoll_ctl(mux->epoll, EPOLL_CTL_MOD, f->fd, &ev));
+			return false;
+		}
+
+		if (status == SW_SYNC_FENCE_STATUS_SIGNALED)
+			timestamp = sync_fence_timestamp(f->fd) ?: timestamp;
+	} else if (events & EPOLLERR) {
+		status = -EIO;
+	}
+
+	/* unlinked first, so the callback may add fences */
+	igt_list_del(&f->link);
+	mux->num_pending--;
+	mux->completed++;
+	epoll_ctl(mux->epoll, EPOLL_CTL_DEL, f->fd, NULL);
+	close(f->fd);
+
+	if (f->cb)
+		f->cb(f->data, status, timestamp);
+	free(f);
+
+	return true;
+}
+
+static int dispatch(igt_fence_mux_t *mux, int timeout_ms)
+{
+	struct epoll_event events[64];
+	int count, completed = 0;
+
+	count = epoll_wait(mux->epoll, events, ARRAY_SIZE(events), timeout_ms);
+	if (count < 0)
+		return errno == EINTR ? 0 : -errno;
+
+	for (int i = 0; i < count; i++)
+		completed += fence_complete(mux, events[i].data.ptr,
+					    events[i].events);
+
+	return completed;
+}
+
+static int mux_wait(igt_fence_mux_t *mux, int64_t deadline_ns, bool all)
+{
+	int done = 0;
+
+	for (;;) {
+		int64_t now = now_ns();
+		int timeout, ret;
+
+		if (!mux->num_pending || (!all && done))
+			return done;
+
+		if (deadline_ns == IGT_FENCE_MUX_FOREVER)
+			timeout = -1;
+		else if (deadline_ns <= now)
+			timeout = 0;
+		else
+			timeout = min_t(int64_t, INT_MAX,
+					DIV_ROUND_UP(deadline_ns - now,
+						     NSEC_PER_SEC / 1000));
+
+		ret = dispatch(mux, timeout);
+		if (ret < 0)
+			return ret;
+
+		done += ret;
+		if (!timeout && mux->num_pending && (all || !done))
+			return -ETIME;
+	}
+}
+
+/**
+ * igt_fence_mux_wait_any:
+ * @mux: multiplexer
+ * @deadline_ns: CLOCK_MONOTONIC time to give up at, see
+ *               igt_fence_mux_deadline(), or IGT_FENCE_MUX_FOREVER
+ *
+ * Waits for at least one of the pending fences, and calls the callbacks of
+ * all those completed by then.
+ *
+ * Returns: the number of fences completed, 0 if none was pending, or
+ * -ETIME if none completed before @deadline_ns.
+ */
+int igt_fence_mux_wait_any(igt_fence_mux_t *mux, int64_t deadline_ns)
+{
+	return mux_wait(mux, deadline_ns, false);
+}
+
+/**
+ * igt_fence_mux_wait_all:
+ * @mux: multiplexer
+ * @deadline_ns: CLOCK_MONOTONIC time to give up at, see
+ *               igt_fence_mux_deadline(), or IGT_FENCE_MUX_FOREVER
+ *
+ * Waits for all the pending fences, including those added by the
+ * callbacks, calling the callbacks as they complete.
+ *
+ * Returns: the number of fences completed, or -ETIME if some were still
+ * pending at @deadline_ns. The callbacks of the fences completed by then
+ * are called either way.
+ */
+int igt_fence_mux_wait_all(igt_fence_mux_t *mux, int64_t deadline_ns)
+{
+	return mux_wait(mux, deadline_ns, true);
+}
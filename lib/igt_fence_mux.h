@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_FENCE_MUX_H
+#define IGT_FENCE_MUX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "igt_list.h"
+
+#define IGT_FENCE_MUX_FOREVER INT64_MAX
+
+/**
+ * igt_fence_mux_cb_t: Called once a fence completes
+ * @data: caller data given when adding the fence
+ * @status: 1 once signaled, or a negative error the fence signaled with
+ * @timestamp_ns: CLOCK_MONOTONIC time of the signal if the fence records
+ *                it, or else of its delivery
+ */
+typedef void (*igt_fence_mux_cb_t)(void *data, int status,
+				   uint64_t timestamp_ns);
+
+/**
+ * igt_fence_mux_t: Fences waited for together
+ * @epoll: epoll instance all fences are registered in
+ * @pending: fences not completed yet
+ * @num_pending: length of @pending
+ * @completed: fences completed so far
+ */
+typedef struct {
+	int epoll;
+	struct igt_list_head pending;
+	unsigned int num_pending;
+	uint64_t completed;
+} igt_fence_mux_t;
+
+void igt_fence_mux_init(igt_fence_mux_t *mux);
+void igt_fence_mux_fini(igt_fence_mux_t *mux);
+void igt_fence_mux_add_fd(igt_fence_mux_t *mux, int fd,
+			  igt_fence_mux_cb_t cb, void *data);
+void igt_fence_mux_add_sync_file(igt_fence_mux_t *mux, int sync_file,
+				 igt_fence_mux_cb_t cb, void *data);
+void igt_fence_mux_add_dmabuf(igt_fence_mux_t *mux, int dmabuf,
+			      uint32_t flags, igt_fence_mux_cb_t cb,
+			      void *data);
+void igt_fence_mux_add_syncobj(igt_fence_mux_t *mux, int fd, uint32_t handle,
+			       uint64_t point, uint32_t flags,
+			       igt_fence_mux_cb_t cb, void *data);
+int64_t igt_fence_mux_deadline(int64_t timeout_ns);
+int igt_fence_mux_wait_any(igt_fence_mux_t *mux, int64_t deadline_ns);
+int igt_fence_mux_wait_all(igt_fence_mux_t *mux, int64_t deadline_ns);
+
+#endif /* IGT_FENCE_MUX_H */
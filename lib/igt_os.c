@@ -36,6 +36,8 @@
 #include <errno.h>
 #include <err.h>
 #include <assert.h>
+#include <limits.h>
+#include <time.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -142,6 +144,533 @@ uint64_t igt_get_meminfo(const char *field)
 	return retval;
 }
 
+/*
+ * Memory planner
+ *
+ * Reads /proc/meminfo, the cgroup v2 memory controller of every ancestor of
+ * the cgroup of the process and the memory pressure stall information once,
+ * keeping the files open so that a refresh is only a handful of preads.
+ */
+
+#define MP_MAX_CGROUP_LEVELS 8
+#define MP_PRESSURE_POLL_MS 10
+
+enum {
+	MP_CG_MAX,
+	MP_CG_CURRENT,
+	MP_CG_STAT,
+	MP_CG_SWAP_MAX,
+	MP_CG_SWAP_CURRENT,
+	MP_CG_FILES,
+};
+
+static const char * const mp_cgroup_files[MP_CG_FILES] = {
+	[MP_CG_MAX] = "memory.max",
+	[MP_CG_CURRENT] = "memory.current",
+	[MP_CG_STAT] = "memory.stat",
+	[MP_CG_SWAP_MAX] = "memory.swap.max",
+	[MP_CG_SWAP_CURRENT] = "memory.swap.current",
+};
+
+struct igt_mem_planner {
+	int meminfo;
+	int pressure;
+	int cgroup[MP_MAX_CGROUP_LEVELS][MP_CG_FILES];
+	int cgroup_levels;
+
+	double throttle_some;
+	double abort_full;
+
+	struct igt_mem_info info;
+	uint64_t timestamp_ns;
+
+	/* previous pressure sample, to catch stalls shorter than avg10 */
+	struct igt_mem_psi last_some, last_full;
+	uint64_t last_psi_ns;
+	double stall_some, stall_full;
+};
+
+static uint64_t mp_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int mp_open(int dirfd, const char *path)
+{
+	return openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+}
+
+static void mp_close(int *fd)
+{
+	if (*fd >= 0)
+		close(*fd);
+	*fd = -1;
+}
+
+static ssize_t mp_read(int fd, char *buf, size_t size)
+{
+	ssize_t len;
+
+	if (fd < 0)
+		return -ENOENT;
+
+	len = pread(fd, buf, size - 1, 0);
+	if (len < 0)
+		return -errno;
+
+	buf[len] = '\0';
+
+	return len;
+}
+
+/* Reads a cgroup limit, "max" or a missing file meaning no limit */
+static uint64_t mp_read_u64(int fd)
+{
+	char buf[32];
+
+	if (mp_read(fd, buf, sizeof(buf)) <= 0 || !strncmp(buf, "max", 3))
+		return UINT64_MAX;
+
+	return strtoull(buf, NULL, 0);
+}
+
+static uint64_t mp_find_u64(const char *buf, const char *key)
+{
+	size_t len = strlen(key);
+
+	for (const char *line = buf; line; line = strchr(line, '\n')) {
+		if (*line == '\n')
+			line++;
+
+		if (!strncmp(line, key, len) &&
+		    (line[len] == ' ' || line[len] == ':'))
+			return strtoull(line + len + 1, NULL, 10);
+	}
+
+	return 0;
+}
+
+static void mp_parse_meminfo(const char *buf, struct igt_mem_info *info)
+{
+	/* values in kB, apart from the hugepage counts */
+	info->ram_total = mp_find_u64(buf, "MemTotal") << 10;
+	info->swap_total = mp_find_u64(buf, "SwapTotal") << 10;
+	info->swap_free = mp_find_u64(buf, "SwapFree") << 10;
+
+	/*
+	 * Include the file+swap cache as "available" for the test.
+	 * We believe that we can revoke these pages back to their
+	 * on disk counterpart, with no loss of functionality while
+	 * the test runs using those pages for ourselves without the
+	 * test itself being swapped to disk.
+	 */
+	info->ram_available = (mp_find_u64(buf, "MemAvailable") +
+			       mp_find_u64(buf, "Buffers") +
+			       mp_find_u64(buf, "Cached") +
+			       mp_find_u64(buf, "SwapCached")) << 10;
+
+	info->hugepage_size = mp_find_u64(buf, "Hugepagesize") << 10;
+	info->hugepages_total = mp_find_u64(buf, "HugePages_Total");
+	info->hugepages_free = mp_find_u64(buf, "HugePages_Free");
+}
+
+static bool mp_parse_psi_line(const char *line, struct igt_mem_psi *psi)
+{
+	const char *avg10 = strstr(line, "avg10=");
+	const char *total = strstr(line, "total=");
+
+	if (!avg10 || !total)
+		return false;
+
+	psi->avg10 = strtod(avg10 + 6, NULL);
+	psi->total_us = strtoull(total + 6, NULL, 10);
+
+	return true;
+}
+
+static bool mp_read_psi(struct igt_mem_planner *planner)
+{
+	struct igt_mem_info *info = &planner->info;
+	char buf[256], *full;
+
+	if (mp_read(planner->pressure, buf, sizeof(buf)) <= 0)
+		return false;
+
+	full = strstr(buf, "full ");
+	if (!full || strncmp(buf, "some ", 5))
+		return false;
+
+	return mp_parse_psi_line(buf, &info->some) &&
+	       mp_parse_psi_line(full, &info->full);
+}
+
+static void mp_read_cgroup(struct igt_mem_planner *planner)
+{
+	struct igt_mem_info *info = &planner->info;
+
+	info->cgroup_limit = UINT64_MAX;
+	info->cgroup_headroom = UINT64_MAX;
+	info->cgroup_swap_headroom = UINT64_MAX;
+
+	for (int level = 0; level < planner->cgroup_levels; level++) {
+		int *fd = planner->cgroup[level];
+		uint64_t limit, current, file = 0;
+		char buf[8192];
+
+		limit = mp_read_u64(fd[MP_CG_MAX]);
+		if (limit != UINT64_MAX) {
+			current = mp_read_u64(fd[MP_CG_CURRENT]);
+			if (current == UINT64_MAX)
+				current = 0;
+
+			/* the page cache charged to the cgroup can be reclaimed */
+			if (mp_read(fd[MP_CG_STAT], buf, sizeof(buf)) > 0)
+				file = min(mp_find_u64(buf, "file"), current);
+
+			info->cgroup_limit = min(info->cgroup_limit, limit);
+			current -= file;
+			info->cgroup_headroom = min(info->cgroup_headroom,
+						    limit > current ? limit - current : 0);
+		}
+
+		limit = mp_read_u64(fd[MP_CG_SWAP_MAX]);
+		if (limit != UINT64_MAX) {
+			current = mp_read_u64(fd[MP_CG_SWAP_CURRENT]);
+			if (current == UINT64_MAX)
+				current = 0;
+
+			info->cgroup_swap_headroom = min(info->cgroup_swap_headroom,
+							 limit > current ? limit - current : 0);
+		}
+	}
+}
+
+/*
+ * Opens the memory controller files of the cgroup of the process and of its
+ * ancestors, leaf first. The root cgroup carries no memory limits.
+ */
+static void mp_open_cgroup(struct igt_mem_planner *planner, int proc,
+			   const char *cgroupfs)
+{
+	char buf[PATH_MAX], *path, *end;
+	int root, fd;
+
+	fd = mp_open(proc, "self/cgroup");
+	if (fd < 0)
+		return;
+
+	/* v2 only: a single "0::/path" line */
+	path = NULL;
+	if (mp_read(fd, buf, sizeof(buf)) > 0) {
+		path = strstr(buf, "0::/");
+		if (path) {
+			path += 4;
+			end = strchr(path, '\n');
+			if (end)
+				*end = '\0';
+		}
+	}
+	close(fd);
+
+	if (!path)
+		return;
+
+	root = open(cgroupfs, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (root < 0)
+		return;
+
+	fd = openat(root, path[0] ? path : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd >= 0) {
+		planner->pressure = mp_open(fd, "memory.pressure");
+		close(fd);
+	}
+
+	while (*path && planner->cgroup_levels < MP_MAX_CGROUP_LEVELS) {
+		int dir = openat(root, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+		if (dir >= 0) {
+			int *level = planner->cgroup[planner->cgroup_levels++];
+
+			for (int i = 0; i < MP_CG_FILES; i++)
+				level[i] = mp_open(dir, mp_cgroup_files[i]);
+			close(dir);
+		}
+
+		end = strrchr(path, '/');
+		if (!end)
+			break;
+		*end = '\0';
+	}
+
+	close(root);
+}
+
+/**
+ * igt_mem_planner_create:
+ * @procfs: procfs mount point, NULL for /proc
+ * @cgroupfs: cgroup v2 mount point, NULL for /sys/fs/cgroup
+ *
+ * Creates a memory planner reading the memory state from @procfs and
+ * @cgroupfs, which allows pointing it at a fake tree. Most tests should use
+ * the shared planner returned by igt_mem_planner() instead.
+ *
+ * Returns: the new planner, to be released with igt_mem_planner_destroy().
+ */
+struct igt_mem_planner *igt_mem_planner_create(const char *procfs,
+					       const char *cgroupfs)
+{
+	struct igt_mem_planner *planner;
+	int proc;
+
+	planner = calloc(1, sizeof(*planner));
+	igt_assert(planner);
+
+	planner->meminfo = -1;
+	planner->pressure = -1;
+	planner->throttle_some = 10.0;
+	planner->abort_full = 50.0;
+
+	proc = open(procfs ?: "/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (proc >= 0) {
+		planner->meminfo = mp_open(proc, "meminfo");
+		mp_open_cgroup(planner, proc, cgroupfs ?: "/sys/fs/cgroup");
+
+		/* fall back to the system wide pressure */
+		if (planner->pressure < 0)
+			planner->pressure = mp_open(proc, "pressure/memory");
+		close(proc);
+	}
+
+	igt_mem_planner_refresh(planner);
+
+	return planner;
+}
+
+/**
+ * igt_mem_planner_destroy:
+ * @planner: memory planner
+ *
+ * Releases @planner.
+ */
+void igt_mem_planner_destroy(struct igt_mem_planner *planner)
+{
+	if (!planner)
+		return;
+
+	mp_close(&planner->meminfo);
+	mp_close(&planner->pressure);
+	for (int level = 0; level < planner->cgroup_levels; level++)
+		for (int i = 0; i < MP_CG_FILES; i++)
+			mp_close(&planner->cgroup[level][i]);
+
+	free(planner);
+}
+
+static struct igt_mem_planner *default_planner;
+
+static void mp_default_fini(int sig)
+{
+	igt_mem_planner_destroy(default_planner);
+	default_planner = NULL;
+}
+
+/**
+ * igt_mem_planner:
+ *
+ * Returns: the planner for the memory of the test process, created on
+ * first use.
+ */
+struct igt_mem_planner *igt_mem_planner(void)
+{
+	if (!default_planner) {
+		default_planner = igt_mem_planner_create(NULL, NULL);
+		igt_install_exit_handler(mp_default_fini);
+	}
+
+	return default_planner;
+}
+
+/**
+ * igt_mem_planner_refresh:
+ * @planner: memory planner
+ *
+ * Rereads the memory state.
+ *
+ * Returns: 0 on success, a negative error code if /proc/meminfo could not
+ * be read.
+ */
+int igt_mem_planner_refresh(struct igt_mem_planner *planner)
+{
+	char buf[8192];
+	ssize_t len;
+
+	len = mp_read(planner->meminfo, buf, sizeof(buf));
+	if (len > 0)
+		mp_parse_meminfo(buf, &planner->info);
+
+	mp_read_cgroup(planner);
+	planner->info.has_psi = mp_read_psi(planner);
+	planner->timestamp_ns = mp_now_ns();
+
+	return len > 0 ? 0 : len ?: -ENODATA;
+}
+
+/**
+ * igt_mem_planner_info:
+ * @planner: memory planner
+ *
+ * Returns: the memory state as of the last refresh of @planner.
+ */
+const struct igt_mem_info *igt_mem_planner_info(struct igt_mem_planner *planner)
+{
+	return &planner->info;
+}
+
+/**
+ * igt_mem_planner_budget:
+ * @planner: memory planner
+ * @mode: CHECK_RAM or CHECK_RAM | CHECK_SWAP, and/or CHECK_HUGEPAGES
+ *
+ * Computes how much memory a test may use for its working set without
+ * pushing the system, or its cgroup, into reclaim. A reserve of 1/64th of
+ * RAM, clamped to [32MiB, 1GiB], is kept back for the rest of the system.
+ * Hugepages are accounted on their own as they come from a separate pool.
+ *
+ * Returns: the working set budget in bytes, as of the last refresh.
+ */
+uint64_t igt_mem_planner_budget(struct igt_mem_planner *planner, unsigned mode)
+{
+	const struct igt_mem_info *info = &planner->info;
+	uint64_t budget = 0, reserve;
+
+	if (mode & (CHECK_RAM | CHECK_SWAP)) {
+		reserve = min(max(info->ram_total >> 6, 32ull << 20), 1ull << 30);
+		budget = min(info->ram_available, info->cgroup_headroom);
+		budget = budget > reserve ? budget - reserve : 0;
+	}
+
+	if (mode & CHECK_SWAP)
+		budget += min(info->swap_free, info->cgroup_swap_headroom);
+
+	if (mode & CHECK_HUGEPAGES)
+		budget += info->hugepages_free * info->hugepage_size;
+
+	return budget;
+}
+
+/**
+ * igt_mem_planner_set_thresholds:
+ * @planner: memory planner
+ * @throttle_some: "some" stall percentage above which tests should throttle
+ * @abort_full: "full" stall percentage above which tests should stop
+ *
+ * Sets the thresholds used by igt_mem_planner_pressure(), the defaults are
+ * 10% and 50%.
+ */
+void igt_mem_planner_set_thresholds(struct igt_mem_planner *planner,
+				    double throttle_some, double abort_full)
+{
+	planner->throttle_some = throttle_some;
+	planner->abort_full = abort_full;
+}
+
+static double mp_stall(const struct igt_mem_psi *now,
+		       const struct igt_mem_psi *last, uint64_t elapsed_ns)
+{
+	double stall = now->avg10;
+
+	if (elapsed_ns && now->total_us > last->total_us)
+		stall = max(stall, (now->total_us - last->total_us) * 1e5 / elapsed_ns);
+
+	return stall;
+}
+
+/**
+ * igt_mem_planner_pressure:
+ * @planner: memory planner
+ *
+ * Samples the memory pressure stall information and classifies it against
+ * the thresholds of @planner. Besides the 10s average, the stall time
+ * accumulated since the previous call is taken into account so that short
+ * bursts are not smoothed away.
+ *
+ * Returns: the current memory pressure, IGT_MEM_PRESSURE_NONE when the
+ * kernel does not provide pressure information.
+ */
+enum igt_mem_pressure igt_mem_planner_pressure(struct igt_mem_planner *planner)
+{
+	struct igt_mem_info *info = &planner->info;
+	uint64_t now, elapsed = 0;
+	double some, full;
+
+	info->has_psi = mp_read_psi(planner);
+	if (!info->has_psi)
+		return IGT_MEM_PRESSURE_NONE;
+
+	now = mp_now_ns();
+	if (planner->last_psi_ns)
+		elapsed = now - planner->last_psi_ns;
+
+	some = mp_stall(&info->some, &planner->last_some, elapsed);
+	full = mp_stall(&info->full, &planner->last_full, elapsed);
+	planner->stall_some = some;
+	planner->stall_full = full;
+
+	planner->last_some = info->some;
+	planner->last_full = info->full;
+	planner->last_psi_ns = now;
+
+	igt_debug("memory pressure: some %.1f%%, full %.1f%%\n", some, full);
+
+	if (full >= planner->abort_full)
+		return IGT_MEM_PRESSURE_ABORT;
+	if (some >= planner->throttle_some)
+		return IGT_MEM_PRESSURE_THROTTLE;
+
+	return IGT_MEM_PRESSURE_NONE;
+}
+
+/**
+ * igt_mem_planner_throttle:
+ * @planner: memory planner
+ * @max_wait_ms: upper bound on the time spent waiting
+ *
+ * To be called periodically by tests growing their working set. Waits for
+ * the memory pressure to ease for up to @max_wait_ms and skips the test if
+ * tasks are fully stalled on memory, before the OOM killer steps in.
+ *
+ * Returns: the time spent waiting in milliseconds.
+ */
+unsigned int igt_mem_planner_throttle(struct igt_mem_planner *planner,
+				      unsigned int max_wait_ms)
+{
+	unsigned int waited = 0;
+
+	for (;;) {
+		switch (igt_mem_planner_pressure(planner)) {
+		case IGT_MEM_PRESSURE_ABORT:
+			igt_skip("Memory pressure too high, tasks stalled %.1f%% of the time\n",
+				 planner->stall_full);
+			break;
+		case IGT_MEM_PRESSURE_THROTTLE:
+			if (waited < max_wait_ms) {
+				usleep(MP_PRESSURE_POLL_MS * 1000);
+				waited += MP_PRESSURE_POLL_MS;
+				continue;
+			}
+			break;
+		case IGT_MEM_PRESSURE_NONE:
+			break;
+		}
+
+		return waited;
+	}
+}
+
 /**
  * igt_get_avail_ram_mb:
  *
@@ -154,30 +683,18 @@ igt_get_avail_ram_mb(void)
 	uint64_t retval;
 
 #ifdef HAVE_STRUCT_SYSINFO_TOTALRAM /* Linux */
-	char *info;
+	struct igt_mem_planner *planner = igt_mem_planner();
 	int fd;
 
 	fd = drm_open_driver(DRIVER_ANY);
 	igt_purge_vm_caches(fd);
 	close(fd);
 
-	fd = open("/proc", O_RDONLY);
-	info = igt_sysfs_get(fd, "meminfo");
-	close(fd);
+	if (igt_mem_planner_refresh(planner) == 0) {
+		const struct igt_mem_info *info = igt_mem_planner_info(planner);
 
-	if (info) {
-		retval  = get_meminfo(info, "MemAvailable:");
-		retval += get_meminfo(info, "Buffers:");
-		/*
-		 * Include the file+swap cache as "available" for the test.
-		 * We believe that we can revoke these pages back to their
-		 * on disk counterpart, with no loss of functionality while
-		 * the test runs using those pages for ourselves without the
-		 * test itself being swapped to disk.
-		 */
-		retval += get_meminfo(info, "Cached:");
-		retval += get_meminfo(info, "SwapCached:");
-		free(info);
+		/* a cgroup limit caps what we can use, whatever is free */
+		retval = min(info->ram_available, info->cgroup_headroom);
 	} else {
 		struct sysinfo sysinf;
 
@@ -221,11 +738,16 @@ igt_get_total_swap_mb(void)
 	uint64_t retval;
 
 #ifdef HAVE_STRUCT_SYSINFO_TOTALRAM /* Linux */
+	struct igt_mem_planner *planner = igt_mem_planner();
 	struct sysinfo sysinf;
 
 	igt_assert(sysinfo(&sysinf) == 0);
 	retval = sysinf.freeswap;
 	retval *= sysinf.mem_unit;
+
+	/* the cgroup limits are reread even if /proc/meminfo is not */
+	igt_mem_planner_refresh(planner);
+	retval = min(retval, igt_mem_planner_info(planner)->cgroup_swap_headroom);
 #elif defined(HAVE_SWAPCTL) /* Solaris */
 	long pagesize = sysconf(_SC_PAGESIZE);
 	uint64_t totalpages = 0;
@@ -374,10 +896,11 @@ int __igt_check_memory(uint64_t count, uint64_t size, unsigned mode,
 	required *= size + KERNEL_BO_OVERHEAD;
 	required = ALIGN(required, 4096);
 
-	igt_debug("Checking %'llu surfaces of size %'llu bytes (total %'llu) against %s%s\n",
+	igt_debug("Checking %'llu surfaces of size %'llu bytes (total %'llu) against %s%s%s\n",
 		  (long long)count, (long long)size, (long long)required,
 		  mode & (CHECK_RAM | CHECK_SWAP) ? "RAM" : "",
-		  mode & CHECK_SWAP ? " + swap": "");
+		  mode & CHECK_SWAP ? " + swap": "",
+		  mode & CHECK_HUGEPAGES ? "hugepages" : "");
 
 	total = 0;
 	if (mode & (CHECK_RAM | CHECK_SWAP))
@@ -386,6 +909,13 @@ int __igt_check_memory(uint64_t count, uint64_t size, unsigned mode,
 		total += igt_get_total_swap_mb();
 	total *= 1024 * 1024;
 
+	if (mode & CHECK_HUGEPAGES) {
+		struct igt_mem_planner *planner = igt_mem_planner();
+
+		igt_mem_planner_refresh(planner);
+		total += igt_mem_planner_budget(planner, CHECK_HUGEPAGES);
+	}
+
 	if (out_required)
 		*out_required = required;
 
@@ -402,13 +932,14 @@ int __igt_check_memory(uint64_t count, uint64_t size, unsigned mode,
  * igt_require_memory:
  * @count: number of surfaces that will be created
  * @size: the size in bytes of each surface
- * @mode: a bit field declaring whether the test will be run in RAM or in SWAP
+ * @mode: a bit field declaring whether the test will be run in RAM or in SWAP,
+ *	  or from the hugepage pool with CHECK_HUGEPAGES
  *
  * Computes the total amount of memory required to allocate @count surfaces,
  * each of @size bytes, and includes an estimate for kernel overhead. It then
  * queries the kernel for the available amount of memory on the system (either
- * RAM and/or SWAP depending upon @mode) and determines whether there is
- * sufficient to run the test.
+ * RAM and/or SWAP depending upon @mode, within the limits of the cgroup of the
+ * test) and determines whether there is sufficient to run the test.
  *
  * Most tests should check that there is enough RAM to hold their working set.
  * The rare swap thrashing tests should check that there is enough RAM + SWAP
@@ -450,12 +981,13 @@ void igt_require_memory(uint64_t count, uint64_t size, unsigned mode)
 	}
 
 	igt_require_f(sufficient_memory,
-		      "Estimated that we need %'llu objects and %'llu MiB for the test, but only have %'llu MiB available (%s%s) and a maximum of %'llu objects\n",
+		      "Estimated that we need %'llu objects and %'llu MiB for the test, but only have %'llu MiB available (%s%s%s) and a maximum of %'llu objects\n",
 		      (long long)count,
 		      (long long)((required + ((1<<20) - 1)) >> 20),
 		      (long long)(total >> 20),
 		      mode & (CHECK_RAM | CHECK_SWAP) ? "RAM" : "",
 		      mode & CHECK_SWAP ? " + swap": "",
+		      mode & CHECK_HUGEPAGES ? "hugepages" : "",
 		      (long long)vfs_file_max());
 }
 
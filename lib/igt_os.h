@@ -25,6 +25,7 @@
 #ifndef IGT_OS_H
 #define IGT_OS_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -43,6 +44,65 @@ void igt_require_memory(uint64_t count, uint64_t size, unsigned mode);
 void igt_require_files(uint64_t count);
 #define CHECK_RAM 0x1
 #define CHECK_SWAP 0x2
+#define CHECK_HUGEPAGES 0x4
+
+/**
+ * igt_mem_psi:
+ * @avg10: share of the last 10 seconds stalled on memory, in percent
+ * @total_us: accumulated stall time in microseconds
+ */
+struct igt_mem_psi {
+	double avg10;
+	uint64_t total_us;
+};
+
+/**
+ * igt_mem_info:
+ *
+ * Snapshot of the memory state as seen by the test process, all sizes are
+ * in bytes. The cgroup headrooms are the tightest over all ancestors of
+ * the cgroup of the process and UINT64_MAX when no limit applies.
+ */
+struct igt_mem_info {
+	uint64_t ram_total;
+	uint64_t ram_available;
+	uint64_t swap_total;
+	uint64_t swap_free;
+
+	uint64_t hugepage_size;
+	uint64_t hugepages_total;
+	uint64_t hugepages_free;
+
+	uint64_t cgroup_limit;
+	uint64_t cgroup_headroom;
+	uint64_t cgroup_swap_headroom;
+
+	bool has_psi;
+	struct igt_mem_psi some;
+	struct igt_mem_psi full;
+};
+
+enum igt_mem_pressure {
+	IGT_MEM_PRESSURE_NONE,
+	IGT_MEM_PRESSURE_THROTTLE,
+	IGT_MEM_PRESSURE_ABORT,
+};
+
+struct igt_mem_planner;
+
+struct igt_mem_planner *igt_mem_planner_create(const char *procfs,
+					       const char *cgroupfs);
+void igt_mem_planner_destroy(struct igt_mem_planner *planner);
+struct igt_mem_planner *igt_mem_planner(void);
+
+int igt_mem_planner_refresh(struct igt_mem_planner *planner);
+const struct igt_mem_info *igt_mem_planner_info(struct igt_mem_planner *planner);
+uint64_t igt_mem_planner_budget(struct igt_mem_planner *planner, unsigned mode);
+void igt_mem_planner_set_thresholds(struct igt_mem_planner *planner,
+				    double throttle_some, double abort_full);
+enum igt_mem_pressure igt_mem_planner_pressure(struct igt_mem_planner *planner);
+unsigned int igt_mem_planner_throttle(struct igt_mem_planner *planner,
+				      unsigned int max_wait_ms);
 
 void igt_purge_vm_caches(int drm_fd);
 
@@ -0,0 +1,460 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_params.h"
+#include "igt_probe_cache.h"
+#include "igt_sysfs.h"
+#include "igt_vec.h"
+
+/**
+ * SECTION:igt_probe_cache
+ * @short_description: On-disk cache of probed device capabilities
+ * @title: Probe cache
+ * @include: igt_probe_cache.h
+ *
+ * Some capabilities are only discovered by trial submission, like the
+ * minimum start offset or alignment of a memory region, and every test
+ * binary probes them again. When IGT_PROBE_CACHE names a directory, the
+ * probes wrapped in igt_probe_cache() are stored there and reused by the
+ * following processes.
+ *
+ * Each device has a file named after its PCI slot. The file starts with
+ * the key the probes depend on: the PCI device id and slot, the kernel
+ * build id and a hash of the driver module parameters. A file with
+ * another key is discarded, and rewritten with the next probe. Updates
+ * are serialized between processes with a lock file and land in a
+ * temporary file renamed over the previous one, so readers never need a
+ * lock and never see a partial file.
+ *
+ * Anything else a probe depends on, like a debugfs knob, has to be part
+ * of the probe name.
+ */
+
+#define NAME_LEN 64
+
+struct entry {
+	char name[NAME_LEN];
+	uint64_t value;
+};
+
+/* The probes of the last file read, so lookups don't go to disk */
+static struct {
+	bool valid;
+	char dir[PATH_MAX];
+	igt_probe_cache_key_t key;
+	struct igt_vec entries;
+} memo;
+static pthread_mutex_t memo_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* The keys of the devices seen, as reading them walks sysfs */
+struct device_key {
+	dev_t rdev;
+	bool valid;
+	igt_probe_cache_key_t key;
+};
+static struct igt_vec device_keys;
+
+static uint64_t fnv1a(uint64_t hash, const char *s)
+{
+	while (*s) {
+		hash ^= (unsigned char)*s++;
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+static void kernel_id(char *buf, size_t len)
+{
+	struct {
+		uint32_t namesz;
+		uint32_t descsz;
+		uint32_t type;
+	} note;
+	unsigned char data[1024];
+	struct utsname uts;
+	ssize_t size;
+	size_t pos = 0;
+	int fd;
+
+	/* the GNU build id in the ELF notes of the running kernel */
+	fd = open("/sys/kernel/notes", O_RDONLY);
+	size = fd >= 0 ? read(fd, data, sizeof(data)) : -1;
+	if (fd >= 0)
+		close(fd);
+
+	while (size > 0 && pos + sizeof(note) <= size) {
+		size_t name = pos + sizeof(note), desc;
+
+		memcpy(&note, data + pos, sizeof(note));
+		desc = name + ALIGN(note.namesz, 4);
+		pos = desc + ALIGN(note.descsz, 4);
+		if (pos > size)
+			break;
+
+		if (note.type == 3 && note.namesz == 4 &&
+		    !memcmp(data + name, "GNU", 4) && note.descsz < len / 2) {
+			for (uint32_t i = 0; i < note.descsz; i++)
+				sprintf(buf + 2 * i, "%02x", data[desc + i]);
+			return;
+		}
+	}
+
+	uname(&uts);
+	snprintf(buf, len, "%s %s", uts.release, uts.version);
+}
+
+static uint64_t params_hash(int params)
+{
+	uint64_t hash = 0;
+	struct dirent *de;
+	DIR *dir;
+
+	dir = fdopendir(params);
+	if (!dir) {
+		close(params);
+		return 0;
+	}
+
+	/* summed, to not depend on the order of the entries */
+	while ((de = readdir(dir))) {
+		char *value;
+
+		if (de->d_name[0] == '.')
+			continue;
+
+		value = igt_sysfs_get(dirfd(dir), de->d_name);
+		if (!value)
+			continue;
+
+		hash += fnv1a(fnv1a(0xcbf29ce484222325ull, de->d_name), value);
+		free(value);
+	}
+	closedir(dir);
+
+	return hash;
+}
+
+/**
+ * igt_probe_cache_key_init:
+ * @key: key to fill
+ * @fd: device
+ *
+ * Fills @key for the probes of @fd.
+ *
+ * Returns: false if @fd is not a PCI device.
+ */
+bool igt_probe_cache_key_init(igt_probe_cache_key_t *key, int fd)
+{
+	char link[PATH_MAX], *devid, *slot;
+	int sysfs, params;
+	ssize_t len;
+
+	memset(key, 0, sizeof(*key));
+
+	sysfs = igt_sysfs_open(fd);
+	if (sysfs < 0)
+		return false;
+
+	len = readlinkat(sysfs, "device", link, sizeof(link) - 1);
+	devid = igt_sysfs_get(sysfs, "device/device");
+	close(sysfs);
+	if (len < 0 || !devid) {
+		free(devid);
+		return false;
+	}
+
+	link[len] = '\0';
+	slot = strrchr(link, '/');
+	snprintf(key->slot, sizeof(key->slot), "%s", slot ? slot + 1 : link);
+	key->devid = strtoul(devid, NULL, 16);
+	free(devid);
+
+	kernel_id(key->kernel, sizeof(key->kernel));
+
+	params = igt_params_open(fd);
+	if (params >= 0)
+		key->params = params_hash(params);
+
+	return true;
+}
+
+static int header(char *buf, size_t len, const igt_probe_cache_key_t *key)
+{
+	return snprintf(buf, len,
+			"devid 0x%04x\nslot %s\nkernel %s\nparams 0x%016" PRIx64 "\n",
+			key->devid, key->slot, key->kernel, key->params);
+}
+
+static void path(char *buf, size_t len, const char *dir,
+		 const igt_probe_cache_key_t *key, const char *suffix)
+{
+	snprintf(buf, len, "%s/%s%s", dir, key->slot[0] ? key->slot : "device",
+		 suffix);
+}
+
+static struct entry *find(const char *name)
+{
+	for (int i = 0; i < igt_vec_length(&memo.entries); i++) {
+		struct entry *e = igt_vec_elem(&memo.entries, i);
+
+		if (!strcmp(e->name, name))
+			return e;
+	}
+
+	return NULL;
+}
+
+/* The probes of the file, none if it has another key */
+static void load(const char *dir, const igt_probe_cache_key_t *key)
+{
+	char expected[512], line[512], filename[PATH_MAX];
+	size_t len = 0;
+	struct entry e;
+	FILE *f;
+
+	igt_vec_fini(&memo.entries);
+	igt_vec_init(&memo.entries, sizeof(struct entry));
+	snprintf(memo.dir, sizeof(memo.dir), "%s", dir);
+	memo.key = *key;
+	memo.valid = true;
+
+	path(filename, sizeof(filename), dir, key, ".probes");
+	f = fopen(filename, "r");
+	if (!f)
+		return;
+
+	/* the key is the first lines */
+	header(expected, sizeof(expected), key);
+	while (expected[len] && fgets(line, sizeof(line), f)) {
+		if (strncmp(line, expected + len, strlen(line))) {
+			igt_debug("Probe cache %s is stale\n", filename);
+			fclose(f);
+			return;
+		}
+		len += strlen(line);
+	}
+
+	while (!expected[len] && fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%63s %" SCNx64, e.name, &e.value) == 2 &&
+		    !find(e.name))
+			igt_vec_push(&memo.entries, &e);
+	}
+	fclose(f);
+}
+
+static bool store(const char *dir, const igt_probe_cache_key_t *key)
+{
+	char buf[512], filename[PATH_MAX], tmp[PATH_MAX];
+	FILE *f;
+	int fd;
+
+	path(filename, sizeof(filename), dir, key, ".probes");
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", filename);
+
+	fd = mkstemp(tmp);
+	if (fd < 0)
+		return false;
+
+	fchmod(fd, 0644);
+	f = fdopen(fd, "w");
+	if (!f) {
+		close(fd);
+		unlink(tmp);
+		return false;
+	}
+
+	header(buf, sizeof(buf), key);
+	fputs(buf, f);
+	for (int i = 0; i < igt_vec_length(&memo.entries); i++) {
+		struct entry *e = igt_vec_elem(&memo.entries, i);
+
+		fprintf(f, "%s 0x%" PRIx64 "\n", e->name, e->value);
+	}
+
+	if (fclose(f) || rename(tmp, filename)) {
+		unlink(tmp);
+		return false;
+	}
+
+	return true;
+}
+
+static bool memo_matches(const char *dir, const igt_probe_cache_key_t *key)
+{
+	return memo.valid && !strcmp(memo.dir, dir) &&
+		memo.key.devid == key->devid &&
+		!strcmp(memo.key.slot, key->slot) &&
+		!strcmp(memo.key.kernel, key->kernel) &&
+		memo.key.params == key->params;
+}
+
+/**
+ * __igt_probe_cache:
+ * @dir: cache directory
+ * @key: what the probe depends on
+ * @name: probe name, including any argument of the probe
+ * @probe: probes on a cache miss
+ * @fd: device passed to @probe
+ * @data: passed to @probe
+ *
+ * igt_probe_cache() with an explicit directory and key.
+ *
+ * Returns: the value cached for @name, or returned by @probe.
+ */
+uint64_t __igt_probe_cache(const char *dir, const igt_probe_cache_key_t *key,
+			   const char *name, igt_probe_cache_probe_t probe,
+			   int fd, const void *data)
+{
+	char lockname[PATH_MAX];
+	struct entry e = {};
+	uint64_t value;
+	int lock;
+
+	igt_assert(strlen(name) < NAME_LEN && !strpbrk(name, " \n"));
+
+	pthread_mutex_lock(&memo_mutex);
+	if (!memo_matches(dir, key))
+		load(dir, key);
+	if (find(name)) {
+		value = find(name)->value;
+		pthread_mutex_unlock(&memo_mutex);
+		return value;
+	}
+	pthread_mutex_unlock(&memo_mutex);
+
+	/* unlocked, as probes may use the cache themselves */
+	value = probe(fd, data);
+
+	if (mkdir(dir, 0755) && errno != EEXIST) {
+		igt_debug("Cannot create probe cache %s: %s\n",
+			  dir, strerror(errno));
+		return value;
+	}
+
+	pthread_mutex_lock(&memo_mutex);
+
+	path(lockname, sizeof(lockname), dir, key, ".lock");
+	lock = open(lockname, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (lock < 0 || flock(lock, LOCK_EX)) {
+		igt_debug("Cannot lock probe cache %s: %s\n",
+			  lockname, strerror(errno));
+		if (lock >= 0)
+			close(lock);
+		pthread_mutex_unlock(&memo_mutex);
+		return value;
+	}
+
+	/* keep what other processes probed in the meantime */
+	load(dir, key);
+	if (!find(name)) {
+		snprintf(e.name, sizeof(e.name), "%s", name);
+		e.value = value;
+		igt_vec_push(&memo.entries, &e);
+
+		if (!store(dir, key))
+			igt_debug("Cannot write probe cache in %s: %s\n",
+				  dir, strerror(errno));
+	}
+
+	close(lock);
+	pthread_mutex_unlock(&memo_mutex);
+
+	return value;
+}
+
+static bool device_key(igt_probe_cache_key_t *key, int fd)
+{
+	struct device_key *dk = NULL;
+	struct stat st;
+	bool valid;
+
+	if (fstat(fd, &st) || !S_ISCHR(st.st_mode))
+		return false;
+
+	pthread_mutex_lock(&memo_mutex);
+	if (!device_keys.elem_size)
+		igt_vec_init(&device_keys, sizeof(*dk));
+
+	for (int i = 0; i < igt_vec_length(&device_keys); i++) {
+		dk = igt_vec_elem(&device_keys, i);
+		if (dk->rdev == st.st_rdev)
+			break;
+		dk = NULL;
+	}
+
+	if (!dk) {
+		struct device_key new = { .rdev = st.st_rdev };
+
+		new.valid = igt_probe_cache_key_init(&new.key, fd);
+		igt_vec_push(&device_keys, &new);
+		dk = igt_vec_elem(&device_keys,
+				  igt_vec_length(&device_keys) - 1);
+	}
+
+	*key = dk->key;
+	valid = dk->valid;
+	pthread_mutex_unlock(&memo_mutex);
+
+	return valid;
+}
+
+/**
+ * igt_probe_cache:
+ * @fd: device
+ * @name: probe name, including any argument of the probe
+ * @probe: probes on a cache miss
+ * @data: passed to @probe
+ *
+ * Looks @name up in the cache directory named by IGT_PROBE_CACHE, and on a
+ * miss, calls @probe and stores its result. Without IGT_PROBE_CACHE, or if
+ * @fd isn't a PCI device, just calls @probe. The key of each device is only
+ * read once, until igt_probe_cache_drop().
+ *
+ * Returns: the value cached for @name, or returned by @probe.
+ */
+uint64_t igt_probe_cache(int fd, const char *name,
+			 igt_probe_cache_probe_t probe, const void *data)
+{
+	const char *dir = getenv("IGT_PROBE_CACHE");
+	igt_probe_cache_key_t key;
+
+	if (!dir || !*dir || !device_key(&key, fd))
+		return probe(fd, data);
+
+	return __igt_probe_cache(dir, &key, name, probe, fd, data);
+}
+
+/**
+ * igt_probe_cache_drop:
+ *
+ * Forgets the probes and the device keys read so far, so the next lookup
+ * reads them again, e.g. once the driver was reloaded with other
+ * parameters.
+ */
+void igt_probe_cache_drop(void)
+{
+	pthread_mutex_lock(&memo_mutex);
+	igt_vec_fini(&device_keys);
+	igt_vec_fini(&memo.entries);
+	memo.valid = false;
+	pthread_mutex_unlock(&memo_mutex);
+}
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_PROBE_CACHE_H
+#define IGT_PROBE_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * igt_probe_cache_key_t: What probed capabilities depend on
+ * @devid: PCI device id
+ * @slot: PCI slot name
+ * @kernel: kernel build id, or its release and version when it has none
+ * @params: hash of the driver module parameters and their values
+ */
+typedef struct {
+	uint16_t devid;
+	char slot[32];
+	char kernel[128];
+	uint64_t params;
+} igt_probe_cache_key_t;
+
+/**
+ * igt_probe_cache_probe_t: Probes a capability on a cache miss
+ * @fd: device given to igt_probe_cache()
+ * @data: caller data given to igt_probe_cache()
+ */
+typedef uint64_t (*igt_probe_cache_probe_t)(int fd, const void *data);
+
+bool igt_probe_cache_key_init(igt_probe_cache_key_t *key, int fd);
+uint64_t __igt_probe_cache(const char *dir, const igt_probe_cache_key_t *key,
+			   const char *name, igt_probe_cache_probe_t probe,
+			   int fd, const void *data);
+uint64_t igt_probe_cache(int fd, const char *name,
+			 igt_probe_cache_probe_t probe, const void *data);
+void igt_probe_cache_drop(void);
+
+#endif /* IGT_PROBE_CACHE_H */
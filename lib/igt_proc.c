@@ -0,0 +1,527 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_proc.h"
+
+/**
+ * SECTION:igt_proc
+ * @short_description: Lightweight procfs process inspector
+ * @title: proc
+ * @include: igt_proc.h
+ *
+ * A snapshot lists the processes of a procfs with a single directory
+ * walk. Everything else is read on demand and only for the processes a
+ * query looks at: the command name, the parent and effective ids, the
+ * working directory and the open fds. A snapshot may be reused for several
+ * queries and refreshed when the process list may have changed.
+ *
+ * igt_proc_snapshot_refresh_tree() lists the descendants of a process only,
+ * following the children files of its threads, which is far cheaper on a
+ * busy host than finding them from the parent of every process.
+ */
+
+#define PROC_COMM	0x1
+#define PROC_STATUS	0x2
+#define PROC_GONE	0x4
+
+/**
+ * igt_proc_snapshot_create:
+ * @procfs: path to a procfs, NULL for /proc
+ *
+ * Returns:
+ * A snapshot of the processes in @procfs, or NULL if it can't be opened.
+ */
+igt_proc_snapshot_t *igt_proc_snapshot_create(const char *procfs)
+{
+	igt_proc_snapshot_t *snap;
+
+	snap = calloc(1, sizeof(*snap));
+	igt_assert(snap);
+
+	snap->procfd = open(procfs ?: "/proc", O_RDONLY | O_DIRECTORY);
+	if (snap->procfd < 0 || igt_proc_snapshot_refresh(snap) < 0) {
+		igt_proc_snapshot_destroy(snap);
+		return NULL;
+	}
+
+	return snap;
+}
+
+/**
+ * igt_proc_snapshot_destroy:
+ * @snap: snapshot
+ */
+void igt_proc_snapshot_destroy(igt_proc_snapshot_t *snap)
+{
+	if (!snap)
+		return;
+
+	if (snap->procfd >= 0)
+		close(snap->procfd);
+	free(snap->procs);
+	free(snap);
+}
+
+static bool parse_num(const char *name, int *num)
+{
+	long val = 0;
+
+	if (!*name)
+		return false;
+
+	for (; *name; name++) {
+		if (!isdigit(*name))
+			return false;
+		val = val * 10 + *name - '0';
+		if (val > INT_MAX)
+			return false;
+	}
+
+	*num = val;
+
+	return true;
+}
+
+static igt_proc_t *add_proc(igt_proc_snapshot_t *snap, pid_t pid)
+{
+	igt_proc_t *proc;
+
+	if (snap->count == snap->size) {
+		snap->size = snap->size ? 2 * snap->size : 256;
+		snap->procs = realloc(snap->procs,
+				      snap->size * sizeof(*snap->procs));
+		igt_assert(snap->procs);
+	}
+
+	proc = &snap->procs[snap->count++];
+	memset(proc, 0, sizeof(*proc));
+	proc->pid = pid;
+
+	return proc;
+}
+
+/**
+ * igt_proc_snapshot_refresh:
+ * @snap: snapshot
+ *
+ * Lists the processes again, dropping everything read on demand.
+ *
+ * Returns:
+ * The number of processes found, or a negative errno.
+ */
+int igt_proc_snapshot_refresh(igt_proc_snapshot_t *snap)
+{
+	struct dirent *d;
+	DIR *dir;
+	int fd;
+
+	fd = openat(snap->procfd, ".", O_RDONLY | O_DIRECTORY);
+	if (fd < 0)
+		return -errno;
+
+	dir = fdopendir(fd);
+	if (!dir) {
+		close(fd);
+		return -errno;
+	}
+
+	snap->count = 0;
+	while ((d = readdir(dir))) {
+		int pid;
+
+		if (d->d_type != DT_DIR && d->d_type != DT_UNKNOWN)
+			continue;
+
+		if (!parse_num(d->d_name, &pid) || !pid)
+			continue;
+
+		add_proc(snap, pid);
+	}
+
+	closedir(dir);
+
+	return snap->count;
+}
+
+static int add_children(igt_proc_snapshot_t *snap, pid_t pid, pid_t root)
+{
+	char path[64];
+	struct dirent *d;
+	int fd, err = -ENOENT;
+	DIR *dir;
+
+	snprintf(path, sizeof(path), "%d/task", pid);
+	fd = openat(snap->procfd, path, O_RDONLY | O_DIRECTORY);
+	if (fd < 0)
+		return -errno;
+
+	dir = fdopendir(fd);
+	if (!dir) {
+		close(fd);
+		return -errno;
+	}
+
+	/* each thread lists the children it forked */
+	while ((d = readdir(dir))) {
+		FILE *children;
+		int tid, child;
+
+		if (!parse_num(d->d_name, &tid))
+			continue;
+
+		snprintf(path, sizeof(path), "%d/children", tid);
+		fd = openat(dirfd(dir), path, O_RDONLY);
+		if (fd < 0) {
+			err = -errno;
+			continue;
+		}
+
+		children = fdopen(fd, "r");
+		igt_assert(children);
+		while (fscanf(children, "%d", &child) == 1)
+			/* a reused pid could otherwise make a loop */
+			if (child != root && !igt_proc_find(snap, child))
+				add_proc(snap, child);
+		fclose(children);
+
+		err = 0;
+	}
+
+	closedir(dir);
+
+	return err;
+}
+
+/**
+ * igt_proc_snapshot_refresh_tree:
+ * @snap: snapshot
+ * @root: pid whose descendants are listed, @root itself is not
+ *
+ * Lists the descendants of @root again, dropping everything read on demand.
+ * Relies on the /proc/pid/task/tid/children files, which only exist with
+ * CONFIG_PROC_CHILDREN, igt_proc_snapshot_refresh() has to be used without.
+ *
+ * Returns:
+ * The number of processes found, or a negative errno, -ENOENT if the
+ * procfs has no children files.
+ */
+int igt_proc_snapshot_refresh_tree(igt_proc_snapshot_t *snap, pid_t root)
+{
+	int ret;
+
+	snap->count = 0;
+
+	ret = add_children(snap, root, root);
+	if (ret < 0)
+		return ret;
+
+	/* the snapshot is the queue, processes that exited meanwhile are fine */
+	for (int i = 0; i < snap->count; i++)
+		add_children(snap, snap->procs[i].pid, root);
+
+	return snap->count;
+}
+
+static ssize_t read_proc_file(igt_proc_snapshot_t *snap, pid_t pid,
+			      const char *name, char *buf, size_t size)
+{
+	char path[32];
+	ssize_t len;
+	int fd;
+
+	snprintf(path, sizeof(path), "%d/%s", pid, name);
+	fd = openat(snap->procfd, path, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+
+	len = read(fd, buf, size - 1);
+	if (len < 0)
+		len = -errno;
+	else
+		buf[len] = '\0';
+
+	close(fd);
+
+	return len;
+}
+
+/**
+ * igt_proc_comm:
+ * @snap: snapshot
+ * @proc: process in @snap
+ *
+ * Returns:
+ * The command name of @proc as found in /proc/pid/comm, or NULL if the
+ * process has exited.
+ */
+const char *igt_proc_comm(igt_proc_snapshot_t *snap, igt_proc_t *proc)
+{
+	ssize_t len;
+
+	if (proc->flags & PROC_GONE)
+		return NULL;
+
+	if (proc->flags & PROC_COMM)
+		return proc->comm;
+
+	len = read_proc_file(snap, proc->pid, "comm",
+			     proc->comm, sizeof(proc->comm));
+	if (len < 0) {
+		proc->flags |= PROC_GONE;
+		return NULL;
+	}
+
+	if (len && proc->comm[len - 1] == '\n')
+		proc->comm[len - 1] = '\0';
+
+	proc->flags |= PROC_COMM;
+
+	return proc->comm;
+}
+
+static bool parse_status_id(const char *status, const char *key,
+			    unsigned int *id)
+{
+	const char *line = strstr(status, key);
+
+	/* Real, effective, saved and filesystem id */
+	return line && sscanf(line + strlen(key), "%*u %u", id) == 1;
+}
+
+static int read_status(igt_proc_snapshot_t *snap, igt_proc_t *proc)
+{
+	unsigned int euid, egid;
+	char status[4096];
+	const char *line;
+	ssize_t len;
+	int ppid;
+
+	if (proc->flags & PROC_GONE)
+		return -ESRCH;
+
+	if (proc->flags & PROC_STATUS)
+		return 0;
+
+	len = read_proc_file(snap, proc->pid, "status", status, sizeof(status));
+	if (len < 0) {
+		proc->flags |= PROC_GONE;
+		return len;
+	}
+
+	line = strstr(status, "\nPPid:");
+	if (!line || sscanf(line + strlen("\nPPid:"), "%d", &ppid) != 1)
+		return -EINVAL;
+
+	if (!parse_status_id(status, "\nUid:", &euid) ||
+	    !parse_status_id(status, "\nGid:", &egid))
+		return -EINVAL;
+
+	proc->ppid = ppid;
+	proc->euid = euid;
+	proc->egid = egid;
+	proc->flags |= PROC_STATUS;
+
+	return 0;
+}
+
+/**
+ * igt_proc_ids:
+ * @snap: snapshot
+ * @proc: process in @snap
+ *
+ * Reads the effective user and group ids of @proc into @proc->euid and
+ * @proc->egid.
+ *
+ * Returns:
+ * 0 on success, or a negative errno if the process has exited.
+ */
+int igt_proc_ids(igt_proc_snapshot_t *snap, igt_proc_t *proc)
+{
+	return read_status(snap, proc);
+}
+
+/**
+ * igt_proc_ppid:
+ * @snap: snapshot
+ * @proc: process in @snap
+ *
+ * Returns:
+ * The parent pid of @proc, 0 for the init and kernel threads roots, or a
+ * negative errno if the process has exited.
+ */
+pid_t igt_proc_ppid(igt_proc_snapshot_t *snap, igt_proc_t *proc)
+{
+	int err = read_status(snap, proc);
+
+	return err ?: proc->ppid;
+}
+
+/**
+ * igt_proc_find:
+ * @snap: snapshot
+ * @pid: process id
+ *
+ * Returns:
+ * The process with @pid, or NULL if it is not in @snap.
+ */
+igt_proc_t *igt_proc_find(igt_proc_snapshot_t *snap, pid_t pid)
+{
+	igt_proc_t *proc;
+
+	for_each_igt_proc(snap, proc)
+		if (proc->pid == pid)
+			return proc;
+
+	return NULL;
+}
+
+/**
+ * igt_proc_find_comm:
+ * @snap: snapshot
+ * @comm: command name, compared ignoring case
+ *
+ * Returns:
+ * The first running process named @comm, or NULL.
+ */
+igt_proc_t *igt_proc_find_comm(igt_proc_snapshot_t *snap, const char *comm)
+{
+	igt_proc_t *proc;
+
+	for_each_igt_proc(snap, proc) {
+		const char *name = igt_proc_comm(snap, proc);
+
+		if (name && !strcasecmp(name, comm))
+			return proc;
+	}
+
+	return NULL;
+}
+
+/**
+ * igt_proc_cwd:
+ * @snap: snapshot
+ * @proc: process in @snap
+ * @buf: buffer for the path
+ * @size: size of @buf
+ *
+ * Returns:
+ * The length of the working directory of @proc stored in @buf, or a
+ * negative errno.
+ */
+int igt_proc_cwd(igt_proc_snapshot_t *snap, igt_proc_t *proc,
+		 char *buf, size_t size)
+{
+	char path[32];
+	ssize_t len;
+
+	snprintf(path, sizeof(path), "%d/cwd", proc->pid);
+	len = readlinkat(snap->procfd, path, buf, size - 1);
+	if (len < 0)
+		return -errno;
+
+	buf[len] = '\0';
+
+	return len;
+}
+
+static bool fd_matches_device(int dirfd, const char *name,
+			      const igt_proc_fd_filter_t *filter)
+{
+	struct stat st;
+
+	if (filter->major < 0)
+		return true;
+
+	if (fstatat(dirfd, name, &st, 0))
+		return false;
+
+	if (!S_ISCHR(st.st_mode) && !S_ISBLK(st.st_mode))
+		return false;
+
+	if (major(st.st_rdev) != filter->major)
+		return false;
+
+	return filter->minor < 0 || minor(st.st_rdev) == filter->minor;
+}
+
+/**
+ * igt_proc_for_each_fd:
+ * @snap: snapshot
+ * @proc: process in @snap
+ * @filter: fds to report, NULL for all
+ * @callback: called for each fd passing @filter
+ * @data: passed to @callback
+ *
+ * Walks the open fds of @proc. Device numbers from @filter are checked
+ * with a stat of the fd, before its link target is read.
+ *
+ * Returns:
+ * 0 once all fds have been walked, the first non zero value returned by
+ * @callback, or a negative errno if the fds of @proc can't be listed.
+ */
+int igt_proc_for_each_fd(igt_proc_snapshot_t *snap, igt_proc_t *proc,
+			 const igt_proc_fd_filter_t *filter,
+			 igt_proc_fd_callback callback, void *data)
+{
+	static const igt_proc_fd_filter_t any = { .major = -1, .minor = -1 };
+	char path[32], target[PATH_MAX];
+	struct dirent *d;
+	DIR *dir;
+	int fd, ret = 0;
+
+	if (!filter)
+		filter = &any;
+
+	snprintf(path, sizeof(path), "%d/fd", proc->pid);
+	fd = openat(snap->procfd, path, O_RDONLY | O_DIRECTORY);
+	if (fd < 0)
+		return -errno;
+
+	dir = fdopendir(fd);
+	if (!dir) {
+		close(fd);
+		return -errno;
+	}
+
+	while (!ret && (d = readdir(dir))) {
+		ssize_t len;
+		int num;
+
+		if (!parse_num(d->d_name, &num))
+			continue;
+
+		if (!fd_matches_device(dirfd(dir), d->d_name, filter))
+			continue;
+
+		len = readlinkat(dirfd(dir), d->d_name, target, sizeof(target) - 1);
+		if (len < 0)
+			continue;
+		target[len] = '\0';
+
+		if (filter->prefix &&
+		    strncmp(target, filter->prefix, strlen(filter->prefix)))
+			continue;
+
+		ret = callback(snap, proc, num, target, data);
+	}
+
+	closedir(dir);
+
+	return ret;
+}
@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_PROC_H
+#define IGT_PROC_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+/**
+ * igt_proc_t: A process found in a snapshot
+ * @pid: process id
+ *
+ * Other process attributes are read on demand, see igt_proc_comm(),
+ * igt_proc_ppid() and igt_proc_ids().
+ */
+typedef struct {
+	pid_t pid;
+
+	/* private */
+	unsigned int flags;
+	char comm[16];
+	pid_t ppid;
+	uid_t euid;
+	gid_t egid;
+} igt_proc_t;
+
+/**
+ * igt_proc_snapshot_t: List of the processes found in a procfs
+ * @procfd: file descriptor of the procfs root
+ * @procs: processes found by the last igt_proc_snapshot_refresh()
+ * @count: number of entries in @procs
+ */
+typedef struct {
+	int procfd;
+	igt_proc_t *procs;
+	int count;
+
+	/* private */
+	int size;
+} igt_proc_snapshot_t;
+
+/**
+ * igt_proc_fd_filter_t: Selects the fds reported by igt_proc_for_each_fd()
+ * @prefix: the fd link target has to start with @prefix, NULL for any
+ * @major: the fd has to be a device with this major, -1 for any file
+ * @minor: the fd has to be a device with this minor, -1 for any minor
+ *
+ * Device numbers are compared before the link is read, so they are the
+ * cheapest way to discard uninteresting fds.
+ */
+typedef struct {
+	const char *prefix;
+	int major;
+	int minor;
+} igt_proc_fd_filter_t;
+
+/**
+ * igt_proc_fd_callback:
+ * @snap: snapshot being walked
+ * @proc: process owning the fd
+ * @fd: fd number in @proc
+ * @target: fd link target
+ * @data: user data passed to igt_proc_for_each_fd()
+ *
+ * Returns:
+ * 0 to continue the walk, anything else stops it and is returned by
+ * igt_proc_for_each_fd().
+ */
+typedef int (*igt_proc_fd_callback)(igt_proc_snapshot_t *snap,
+				    igt_proc_t *proc, int fd,
+				    const char *target, void *data);
+
+#define for_each_igt_proc(snap, proc) \
+	for ((proc) = (snap)->procs; (proc) < (snap)->procs + (snap)->count; (proc)++)
+
+igt_proc_snapshot_t *igt_proc_snapshot_create(const char *procfs);
+void igt_proc_snapshot_destroy(igt_proc_snapshot_t *snap);
+int igt_proc_snapshot_refresh(igt_proc_snapshot_t *snap);
+int igt_proc_snapshot_refresh_tree(igt_proc_snapshot_t *snap, pid_t root);
+
+const char *igt_proc_comm(igt_proc_snapshot_t *snap, igt_proc_t *proc);
+int igt_proc_ids(igt_proc_snapshot_t *snap, igt_proc_t *proc);
+pid_t igt_proc_ppid(igt_proc_snapshot_t *snap, igt_proc_t *proc);
+igt_proc_t *igt_proc_find(igt_proc_snapshot_t *snap, pid_t pid);
+igt_proc_t *igt_proc_find_comm(igt_proc_snapshot_t *snap, const char *comm);
+int igt_proc_cwd(igt_proc_snapshot_t *snap, igt_proc_t *proc,
+		 char *buf, size_t size);
+int igt_proc_for_each_fd(igt_proc_snapshot_t *snap, igt_proc_t *proc,
+			 const igt_proc_fd_filter_t *filter,
+			 igt_proc_fd_callback callback, void *data);
+
+#endif /* IGT_PROC_H */
@@ -0,0 +1,665 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "drmtest.h"
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_spike.h"
+
+/**
+ * SECTION:igt_spike
+ * @short_description: Attribution of latency spikes from ftrace
+ * @title: Latency spikes
+ * @include: igt_spike.h
+ *
+ * Latency benchmarks only report a mean and a maximum, which says nothing
+ * about what caused the worst samples. This keeps the scheduler, interrupt
+ * and i915/xe tracepoints enabled while the benchmark runs, and whenever a
+ * sample goes above a threshold, writes a trace marker and snapshots the
+ * trace buffer of the CPU the sample was measured on.
+ *
+ * The trace preceding the marker, over the latency of the sample plus
+ * some margin, is kept for the largest spikes and reduced to what ran on
+ * the CPU meanwhile: the tasks switched in, the interrupt and softirq
+ * handlers, and the GPU events. igt_spike_report() then lists the top
+ * offenders over all the spikes.
+ *
+ * Captures are serialized and take a while, the samples following a
+ * capture are delayed by it.
+ */
+
+/* scheduling and interrupt context, plus whatever the GPU drivers trace */
+static const char * const events[] = {
+	"sched/sched_switch",
+	"sched/sched_wakeup",
+	"irq/irq_handler_entry",
+	"irq/irq_handler_exit",
+	"irq/softirq_entry",
+	"irq/softirq_exit",
+	"i915",
+	"xe",
+};
+
+#define MARKER "igt-spike: "
+
+struct trace_line {
+	uint64_t ts;
+	int pid;
+	char event[IGT_SPIKE_NAME_LEN];
+	const char *args;
+};
+
+struct context {
+	char name[IGT_SPIKE_NAME_LEN];
+	uint64_t since;
+	bool active;
+};
+
+static int read_attr(int dir, const char *path, char *buf, size_t len)
+{
+	ssize_t ret;
+	int fd;
+
+	fd = openat(dir, path, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+
+	ret = read(fd, buf, len - 1);
+	close(fd);
+	if (ret < 0)
+		return -errno;
+
+	buf[ret] = '\0';
+	return ret;
+}
+
+static bool write_attr(int dir, const char *path, const char *value)
+{
+	size_t len = strlen(value);
+	bool ret;
+	int fd;
+
+	fd = openat(dir, path, O_WRONLY);
+	if (fd < 0)
+		return false;
+
+	ret = write(fd, value, len) == len;
+	close(fd);
+
+	return ret;
+}
+
+static char *read_file(int dir, const char *path)
+{
+	size_t len = 0, size = 64 << 10;
+	char *buf;
+	ssize_t ret;
+	int fd;
+
+	fd = openat(dir, path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	buf = malloc(size);
+	igt_assert(buf);
+	while ((ret = read(fd, buf + len, size - len - 1)) > 0) {
+		len += ret;
+		if (size - len == 1) {
+			size *= 2;
+			buf = realloc(buf, size);
+			igt_assert(buf);
+		}
+	}
+	close(fd);
+
+	buf[len] = '\0';
+	return buf;
+}
+
+static void enable_events(igt_spike_t *spike)
+{
+	for (int i = 0; i < ARRAY_SIZE(events); i++) {
+		char path[128], value[8];
+
+		snprintf(path, sizeof(path), "events/%s/enable", events[i]);
+		if (read_attr(spike->dir, path, value, sizeof(value)) < 0)
+			continue;
+
+		/* "X" for a partly enabled system, leave that to its owner */
+		if (value[0] != '0' || !write_attr(spike->dir, path, "1"))
+			continue;
+
+		spike->enabled = realloc(spike->enabled,
+					 (spike->n_enabled + 1) *
+					 sizeof(*spike->enabled));
+		igt_assert(spike->enabled);
+		spike->enabled[spike->n_enabled++] = strdup(path);
+	}
+}
+
+/**
+ * igt_spike_init:
+ * @spike: spike capture to initialize
+ * @tracefs: path of tracefs, NULL for its usual mount points
+ * @threshold_ns: latency above which a sample is captured
+ * @window_ns: trace to keep before a spike, in addition to its latency
+ * @max_windows: number of spikes to keep, the largest ones are kept
+ *
+ * Enables the tracepoints used for the attribution which aren't already,
+ * and turns tracing on. igt_spike_fini() restores both.
+ *
+ * Returns: false if tracefs couldn't be opened.
+ */
+bool igt_spike_init(igt_spike_t *spike, const char *tracefs,
+		    uint64_t threshold_ns, uint64_t window_ns,
+		    unsigned int max_windows)
+{
+	char buf[128];
+
+	igt_assert(max_windows);
+
+	memset(spike, 0, sizeof(*spike));
+	spike->threshold_ns = threshold_ns;
+	spike->window_ns = window_ns;
+	spike->max_windows = max_windows;
+
+	if (tracefs) {
+		spike->dir = open(tracefs, O_RDONLY | O_DIRECTORY);
+	} else {
+		spike->dir = open("/sys/kernel/tracing",
+				  O_RDONLY | O_DIRECTORY);
+		if (spike->dir < 0)
+			spike->dir = open("/sys/kernel/debug/tracing",
+					  O_RDONLY | O_DIRECTORY);
+	}
+	if (spike->dir < 0)
+		return false;
+
+	spike->marker_fd = openat(spike->dir, "trace_marker", O_WRONLY);
+	if (spike->marker_fd < 0) {
+		close(spike->dir);
+		return false;
+	}
+
+	pthread_mutex_init(&spike->mutex, NULL);
+	spike->windows = calloc(max_windows, sizeof(*spike->windows));
+	igt_assert(spike->windows);
+
+	spike->was_tracing = read_attr(spike->dir, "tracing_on",
+				       buf, sizeof(buf)) > 0 && buf[0] == '1';
+	spike->had_snapshot = read_attr(spike->dir, "snapshot",
+					buf, sizeof(buf)) > 0 &&
+			      !strstr(buf, "NOT ALLOCATED");
+
+	enable_events(spike);
+	write_attr(spike->dir, "tracing_on", "1");
+
+	return true;
+}
+
+static void free_window(igt_spike_window_t *w)
+{
+	free(w->offenders);
+	free(w->trace);
+	memset(w, 0, sizeof(*w));
+}
+
+/**
+ * igt_spike_fini:
+ * @spike: spike capture
+ *
+ * Disables the tracepoints enabled by igt_spike_init(), restores tracing_on
+ * and frees the captured spikes.
+ */
+void igt_spike_fini(igt_spike_t *spike)
+{
+	for (unsigned int i = 0; i < spike->n_enabled; i++) {
+		write_attr(spike->dir, spike->enabled[i], "0");
+		free(spike->enabled[i]);
+	}
+	free(spike->enabled);
+
+	/* release the snapshot buffer, if we were the ones allocating it */
+	if (!spike->had_snapshot)
+		write_attr(spike->dir, "snapshot", "0");
+	if (!spike->was_tracing)
+		write_attr(spike->dir, "tracing_on", "0");
+
+	for (unsigned int i = 0; i < spike->n_windows; i++)
+		free_window(&spike->windows[i]);
+	free(spike->windows);
+
+	pthread_mutex_destroy(&spike->mutex);
+	close(spike->marker_fd);
+	close(spike->dir);
+}
+
+/*
+ * "<comm>-<pid> [<cpu>] <flags> <secs>.<usecs>: <event>: <args>", the
+ * comm may hold anything and the cpu and flags depend on the options.
+ */
+static bool parse_line(const char *line, struct trace_line *out)
+{
+	const char *p, *ts = NULL, *task_end, *q;
+	uint64_t frac = 0;
+	int digits = 0;
+	size_t len;
+
+	if (line[0] == '#')
+		return false;
+
+	for (p = strstr(line, ": "); p; p = strstr(p + 1, ": ")) {
+		q = p;
+		while (q > line && (isdigit(q[-1]) || q[-1] == '.'))
+			q--;
+		if (q < p && q > line && q[-1] == ' ' && memchr(q, '.', p - q)) {
+			ts = q;
+			break;
+		}
+	}
+	if (!ts)
+		return false;
+
+	out->ts = strtoull(ts, (char **)&q, 10) * 1000000000ull;
+	for (q++; isdigit(*q) && digits < 9; q++, digits++)
+		frac = frac * 10 + *q - '0';
+	for (; digits < 9; digits++)
+		frac *= 10;
+	out->ts += frac;
+
+	/* the pid ends the task, before the cpu if there is one */
+	task_end = memchr(line, '[', ts - line);
+	if (!task_end)
+		task_end = ts;
+	while (task_end > line && task_end[-1] == ' ')
+		task_end--;
+	q = task_end;
+	while (q > line && isdigit(q[-1]))
+		q--;
+	out->pid = q < task_end && q > line && q[-1] == '-' ? atoi(q) : -1;
+
+	p += 2;
+	q = strstr(p, ": ");
+	len = q ? q - p : strlen(p);
+	if (len >= sizeof(out->event))
+		len = sizeof(out->event) - 1;
+	memcpy(out->event, p, len);
+	out->event[len] = '\0';
+	out->args = q ? q + 2 : "";
+
+	return true;
+}
+
+/* copies the value of @key up to @until, or the end of the arguments */
+static bool get_field(const char *args, const char *key, const char *until,
+		      char *buf, size_t len)
+{
+	const char *p, *end;
+
+	p = strstr(args, key);
+	if (!p)
+		return false;
+
+	p += strlen(key);
+	end = until ? strstr(p, until) : NULL;
+	if (!end)
+		end = p + strlen(p);
+	if (end - p >= len)
+		end = p + len - 1;
+
+	memcpy(buf, p, end - p);
+	buf[end - p] = '\0';
+	return true;
+}
+
+static void add_offender(igt_spike_window_t *w, const char *name,
+			 uint64_t from, uint64_t to)
+{
+	igt_spike_offender_t *o = NULL;
+
+	if (to < w->start_ns || from > w->end_ns)
+		return;
+
+	from = max(from, w->start_ns);
+	to = min(to, w->end_ns);
+
+	for (unsigned int i = 0; i < w->n_offenders; i++) {
+		if (!strcmp(w->offenders[i].name, name)) {
+			o = &w->offenders[i];
+			break;
+		}
+	}
+
+	if (!o) {
+		w->offenders = realloc(w->offenders, (w->n_offenders + 1) *
+				       sizeof(*w->offenders));
+		igt_assert(w->offenders);
+		o = &w->offenders[w->n_offenders++];
+		memset(o, 0, sizeof(*o));
+		snprintf(o->name, sizeof(o->name), "%s", name);
+	}
+
+	o->time_ns += to - from;
+	o->count++;
+}
+
+static void close_context(igt_spike_window_t *w, struct context *c,
+			  uint64_t ts)
+{
+	if (c->active)
+		add_offender(w, c->name, c->since, ts);
+	c->active = false;
+}
+
+static void open_context(struct context *c, const char *prefix,
+			 const char *name, uint64_t ts)
+{
+	snprintf(c->name, sizeof(c->name), "%s:%s", prefix, name);
+	c->since = ts;
+	c->active = true;
+}
+
+static int cmp_offender(const void *A, const void *B)
+{
+	const igt_spike_offender_t *a = A, *b = B;
+
+	if (a->time_ns != b->time_ns)
+		return a->time_ns > b->time_ns ? -1 : 1;
+	if (a->count != b->count)
+		return a->count > b->count ? -1 : 1;
+
+	return strcmp(a->name, b->name);
+}
+
+/*
+ * Walks the trace of the spike's CPU up to the marker, keeping the lines
+ * within the window and accounting what ran during it. The sampling task
+ * itself, identified by the marker it wrote, and the idle task don't count.
+ */
+static void attribute(igt_spike_window_t *w, uint64_t span, char *buf)
+{
+	struct context task = {}, irq = {}, softirq = {};
+	uint64_t last_ts = 0;
+	char marker[32], value[IGT_SPIKE_NAME_LEN];
+	size_t len = 0;
+	int marker_pid = -1;
+	char *line, *next;
+
+	/* find the marker, or fall back on the end of the trace */
+	snprintf(marker, sizeof(marker), MARKER "%u ", w->seq);
+	w->end_ns = 0;
+	for (line = buf; line && *line; line = next) {
+		struct trace_line tl;
+
+		next = strchr(line, '\n');
+		if (next)
+			*next = '\0';
+
+		if (parse_line(line, &tl)) {
+			last_ts = tl.ts;
+			if (!strcmp(tl.event, "tracing_mark_write") &&
+			    !strncmp(tl.args, marker, strlen(marker))) {
+				w->end_ns = tl.ts;
+				marker_pid = tl.pid;
+			}
+		}
+
+		if (next)
+			*next++ = '\n';
+	}
+	if (!w->end_ns)
+		w->end_ns = last_ts;
+	w->start_ns = w->end_ns > span ? w->end_ns - span : 0;
+
+	w->trace = malloc(strlen(buf) + 1);
+	igt_assert(w->trace);
+
+	for (line = buf; line && *line; line = next) {
+		struct trace_line tl;
+
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+
+		if (!parse_line(line, &tl))
+			continue;
+		if (tl.ts > w->end_ns)
+			break;
+
+		if (tl.ts >= w->start_ns)
+			len += sprintf(w->trace + len, "%s\n", line);
+
+		if (!strcmp(tl.event, "sched_switch")) {
+			close_context(w, &task, tl.ts);
+			if (get_field(tl.args, "next_comm=", " next_pid=",
+				      value, sizeof(value))) {
+				const char *pid = strstr(tl.args, "next_pid=");
+				int next_pid = pid ? atoi(pid + 9) : -1;
+
+				if (next_pid > 0 && next_pid != marker_pid)
+					open_context(&task, "task", value, tl.ts);
+			}
+		} else if (!strcmp(tl.event, "irq_handler_entry")) {
+			if (get_field(tl.args, "name=", NULL,
+				      value, sizeof(value)))
+				open_context(&irq, "irq", value, tl.ts);
+		} else if (!strcmp(tl.event, "irq_handler_exit")) {
+			close_context(w, &irq, tl.ts);
+		} else if (!strcmp(tl.event, "softirq_entry")) {
+			if (get_field(tl.args, "action=", "]",
+				      value, sizeof(value)))
+				open_context(&softirq, "softirq", value, tl.ts);
+		} else if (!strcmp(tl.event, "softirq_exit")) {
+			close_context(w, &softirq, tl.ts);
+		} else if (!strncmp(tl.event, "i915_", 5) ||
+			   !strncmp(tl.event, "xe_", 3)) {
+			if (tl.ts >= w->start_ns) {
+				snprintf(value, sizeof(value), "gpu:%.*s",
+					 (int)sizeof(value) - 5, tl.event);
+				add_offender(w, value, tl.ts, tl.ts);
+			}
+		}
+	}
+	w->trace[len] = '\0';
+
+	close_context(w, &task, w->end_ns);
+	close_context(w, &irq, w->end_ns);
+	close_context(w, &softirq, w->end_ns);
+
+	if (w->n_offenders)
+		qsort(w->offenders, w->n_offenders, sizeof(*w->offenders),
+		      cmp_offender);
+}
+
+static void capture(igt_spike_t *spike, igt_spike_window_t *w)
+{
+	char path[64];
+	char *buf;
+
+	/* freeze the trace while we read it, if the kernel allows */
+	if (write_attr(spike->dir, "snapshot", "1"))
+		snprintf(path, sizeof(path), "per_cpu/cpu%d/snapshot", w->cpu);
+	else
+		snprintf(path, sizeof(path), "per_cpu/cpu%d/trace", w->cpu);
+
+	buf = read_file(spike->dir, path);
+	if (!buf) {
+		w->trace = strdup("");
+		return;
+	}
+
+	attribute(w, w->latency_ns + spike->window_ns, buf);
+	free(buf);
+}
+
+/**
+ * igt_spike_sample:
+ * @spike: spike capture
+ * @cpu: CPU the latency was measured on, -1 for the current one
+ * @latency_ns: measured latency
+ *
+ * Checks a sample against the threshold, and if above, writes a trace
+ * marker and captures the trace of @cpu, unless the spike is smaller than
+ * all the ones already kept.
+ *
+ * Returns: true if the sample was captured.
+ */
+bool igt_spike_sample(igt_spike_t *spike, int cpu, uint64_t latency_ns)
+{
+	igt_spike_window_t *w = NULL;
+	char marker[96];
+	unsigned int seq;
+	int len;
+
+	if (latency_ns <= spike->threshold_ns)
+		return false;
+
+	if (cpu < 0)
+		cpu = sched_getcpu();
+
+	pthread_mutex_lock(&spike->mutex);
+
+	seq = spike->n_spikes++;
+	len = snprintf(marker, sizeof(marker),
+		       MARKER "%u cpu=%d latency=%" PRIu64 "ns\n",
+		       seq, cpu, latency_ns);
+	igt_assert(write(spike->marker_fd, marker, len) == len);
+
+	if (spike->n_windows < spike->max_windows) {
+		w = &spike->windows[spike->n_windows++];
+	} else {
+		for (unsigned int i = 0; i < spike->n_windows; i++) {
+			if (spike->windows[i].latency_ns < latency_ns &&
+			    (!w || spike->windows[i].latency_ns < w->latency_ns))
+				w = &spike->windows[i];
+		}
+		if (w)
+			free_window(w);
+	}
+
+	if (w) {
+		w->seq = seq;
+		w->cpu = cpu;
+		w->latency_ns = latency_ns;
+		capture(spike, w);
+	}
+
+	pthread_mutex_unlock(&spike->mutex);
+
+	return w != NULL;
+}
+
+struct total {
+	igt_spike_offender_t offender;
+	unsigned int spikes;
+};
+
+static int cmp_total(const void *A, const void *B)
+{
+	const struct total *a = A, *b = B;
+
+	return cmp_offender(&a->offender, &b->offender);
+}
+
+static int cmp_window(const void *A, const void *B)
+{
+	const igt_spike_window_t *a = A, *b = B;
+
+	if (a->latency_ns != b->latency_ns)
+		return a->latency_ns > b->latency_ns ? -1 : 1;
+
+	return a->seq - b->seq;
+}
+
+/**
+ * igt_spike_report:
+ * @spike: spike capture
+ * @f: where to print
+ * @top: number of offenders to list, overall and per spike
+ * @trace: whether to print the trace of each spike
+ *
+ * Prints the offenders summed over all the captured spikes, weighted by
+ * the time they held the CPU, then each spike from the largest.
+ */
+void igt_spike_report(igt_spike_t *spike, FILE *f, unsigned int top,
+		      bool trace)
+{
+	struct total *total = NULL;
+	unsigned int n_total = 0;
+
+	pthread_mutex_lock(&spike->mutex);
+
+	fprintf(f, "Spikes: %u above %.3fus, %u captured\n",
+		spike->n_spikes, spike->threshold_ns / 1e3, spike->n_windows);
+	if (!spike->n_windows)
+		goto out;
+
+	qsort(spike->windows, spike->n_windows, sizeof(*spike->windows),
+	      cmp_window);
+
+	for (unsigned int i = 0; i < spike->n_windows; i++) {
+		const igt_spike_window_t *w = &spike->windows[i];
+
+		for (unsigned int j = 0; j < w->n_offenders; j++) {
+			const igt_spike_offender_t *o = &w->offenders[j];
+			unsigned int k;
+
+			for (k = 0; k < n_total; k++)
+				if (!strcmp(total[k].offender.name, o->name))
+					break;
+
+			if (k == n_total) {
+				total = realloc(total,
+						++n_total * sizeof(*total));
+				igt_assert(total);
+				total[k].offender = *o;
+				total[k].spikes = 0;
+			} else {
+				total[k].offender.time_ns += o->time_ns;
+				total[k].offender.count += o->count;
+			}
+			total[k].spikes++;
+		}
+	}
+
+	if (n_total)
+		qsort(total, n_total, sizeof(*total), cmp_total);
+
+	fprintf(f, "Top offenders:\n");
+	fprintf(f, "%12s %8s %8s  %s\n", "time (us)", "count", "spikes", "name");
+	for (unsigned int k = 0; k < min(top, n_total); k++)
+		fprintf(f, "%12.3f %8u %8u  %s\n",
+			total[k].offender.time_ns / 1e3,
+			total[k].offender.count, total[k].spikes,
+			total[k].offender.name);
+
+	for (unsigned int i = 0; i < spike->n_windows; i++) {
+		const igt_spike_window_t *w = &spike->windows[i];
+
+		fprintf(f, "Spike %u: cpu %d, latency %.3fus, trace %" PRIu64 ".%06" PRIu64 "-%" PRIu64 ".%06" PRIu64 "\n",
+			w->seq, w->cpu, w->latency_ns / 1e3,
+			w->start_ns / 1000000000, w->start_ns % 1000000000 / 1000,
+			w->end_ns / 1000000000, w->end_ns % 1000000000 / 1000);
+		for (unsigned int j = 0; j < min(top, w->n_offenders); j++)
+			fprintf(f, "  %12.3fus %6u  %s\n",
+				w->offenders[j].time_ns / 1e3,
+				w->offenders[j].count, w->offenders[j].name);
+		if (trace)
+			fputs(w->trace, f);
+	}
+
+out:
+	pthread_mutex_unlock(&spike->mutex);
+	free(total);
+}
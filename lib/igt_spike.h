@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_SPIKE_H
+#define IGT_SPIKE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define IGT_SPIKE_NAME_LEN 48
+
+/**
+ * igt_spike_offender_t: What ran on the CPU during a spike
+ * @name: "task:<comm>", "irq:<handler>", "softirq:<action>" or
+ *	  "gpu:<tracepoint>"
+ * @time_ns: time spent within the spike window, 0 for gpu events
+ * @count: number of occurrences within the spike window
+ */
+typedef struct {
+	char name[IGT_SPIKE_NAME_LEN];
+	uint64_t time_ns;
+	unsigned int count;
+} igt_spike_offender_t;
+
+/**
+ * igt_spike_window_t: A captured spike
+ * @seq: sequence number of the spike, as written to the trace marker
+ * @cpu: CPU the latency was measured on
+ * @latency_ns: measured latency
+ * @start_ns: trace time of the start of the window
+ * @end_ns: trace time of the trace marker closing the window
+ * @offenders: what ran on @cpu within the window, by decreasing time
+ * @n_offenders: number of entries in @offenders
+ * @trace: the trace lines of @cpu within the window
+ */
+typedef struct {
+	unsigned int seq;
+	int cpu;
+	uint64_t latency_ns;
+	uint64_t start_ns, end_ns;
+	igt_spike_offender_t *offenders;
+	unsigned int n_offenders;
+	char *trace;
+} igt_spike_window_t;
+
+/**
+ * igt_spike_t: Latency spike capture
+ * @dir: directory fd of tracefs
+ * @marker_fd: fd of the trace marker
+ * @threshold_ns: latency above which a sample is a spike
+ * @window_ns: trace kept before the spike, in addition to its latency
+ * @max_windows: maximum number of windows kept
+ * @windows: the largest spikes captured, up to @max_windows
+ * @n_windows: number of entries in @windows
+ * @n_spikes: number of samples above @threshold_ns
+ * @enabled: events enabled by igt_spike_init(), disabled by igt_spike_fini()
+ * @n_enabled: number of entries in @enabled
+ * @was_tracing: whether tracing was on before igt_spike_init()
+ * @had_snapshot: whether a snapshot buffer was allocated before
+ *		  igt_spike_init(), in which case it isn't ours to free
+ * @mutex: serializes the captures
+ */
+typedef struct {
+	int dir;
+	int marker_fd;
+	uint64_t threshold_ns;
+	uint64_t window_ns;
+	unsigned int max_windows;
+	igt_spike_window_t *windows;
+	unsigned int n_windows;
+	unsigned int n_spikes;
+	char **enabled;
+	unsigned int n_enabled;
+	bool was_tracing;
+	bool had_snapshot;
+	pthread_mutex_t mutex;
+} igt_spike_t;
+
+bool igt_spike_init(igt_spike_t *spike, const char *tracefs,
+		    uint64_t threshold_ns, uint64_t window_ns,
+		    unsigned int max_windows);
+void igt_spike_fini(igt_spike_t *spike);
+bool igt_spike_sample(igt_spike_t *spike, int cpu, uint64_t latency_ns);
+void igt_spike_report(igt_spike_t *spike, FILE *f, unsigned int top,
+		      bool trace);
+
+#endif /* IGT_SPIKE_H */
@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_suballoc.h"
+
+/**
+ * SECTION:igt_suballoc
+ * @short_description: Ring suballocator with fence tracked reuse
+ * @title: Suballocator
+ * @include: igt_suballoc.h
+ *
+ * Hands out aligned ranges of one large, persistently mapped buffer in
+ * ring order. Every range is tagged with the fence of the submission that
+ * consumed it and is only reused once that fence has signaled, so callers
+ * can keep several submissions in flight without allocating a new buffer
+ * object for each of them.
+ *
+ * Ranges are allocated with igt_suballoc_alloc() and stay pinned until a
+ * fence is attached with igt_suballoc_fence(); all ranges allocated since
+ * the previous call share that fence.
+ */
+
+static struct igt_suballoc_chunk *oldest(struct igt_suballoc *sa)
+{
+	return &sa->chunks[sa->first];
+}
+
+static void push_chunk(struct igt_suballoc *sa, uint64_t offset, uint64_t size)
+{
+	struct igt_suballoc_chunk *chunk;
+
+	if (sa->count == sa->capacity) {
+		unsigned int capacity = sa->capacity ? sa->capacity * 2 : 16;
+		struct igt_suballoc_chunk *chunks;
+
+		chunks = calloc(capacity, sizeof(*chunks));
+		igt_assert(chunks);
+		for (unsigned int i = 0; i < sa->count; i++)
+			chunks[i] = sa->chunks[(sa->first + i) % sa->capacity];
+
+		free(sa->chunks);
+		sa->chunks = chunks;
+		sa->capacity = capacity;
+		sa->first = 0;
+	}
+
+	chunk = &sa->chunks[(sa->first + sa->count++) % sa->capacity];
+	chunk->offset = offset;
+	chunk->size = size;
+	chunk->fenced = false;
+}
+
+static void pop_chunk(struct igt_suballoc *sa)
+{
+	sa->first = (sa->first + 1) % sa->capacity;
+	if (!--sa->count)
+		sa->head = 0;
+	sa->stats.retired++;
+}
+
+static bool fit(struct igt_suballoc *sa, uint64_t size, uint64_t *offset)
+{
+	uint64_t tail;
+
+	if (!sa->count) {
+		sa->head = 0;
+		*offset = 0;
+		return size <= sa->size;
+	}
+
+	tail = oldest(sa)->offset;
+	if (sa->head > tail) {
+		/* [tail, head) in use, free space at the end and the start */
+		if (sa->head + size <= sa->size) {
+			*offset = sa->head;
+			return true;
+		}
+
+		if (size <= tail) {
+			*offset = 0;
+			return true;
+		}
+
+		return false;
+	}
+
+	/* wrapped around, [head, tail) is the only free range */
+	if (sa->head + size <= tail) {
+		*offset = sa->head;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * igt_suballoc_init:
+ * @sa: suballocator to initialize
+ * @size: size of the backing buffer
+ * @alignment: alignment of every returned offset, must be a power of two
+ * @ops: fence backend
+ * @priv: opaque pointer passed to @ops
+ */
+void igt_suballoc_init(struct igt_suballoc *sa, uint64_t size, uint64_t alignment,
+		       const struct igt_suballoc_ops *ops, void *priv)
+{
+	igt_assert(alignment && !(alignment & (alignment - 1)));
+	igt_assert(ops && ops->wait);
+
+	memset(sa, 0, sizeof(*sa));
+	sa->size = size;
+	sa->alignment = alignment;
+	sa->ops = ops;
+	sa->priv = priv;
+}
+
+/**
+ * igt_suballoc_fini:
+ * @sa: suballocator
+ *
+ * Releases the bookkeeping. Callers must make sure the backing buffer is
+ * idle, e.g. with igt_suballoc_wait_idle().
+ */
+void igt_suballoc_fini(struct igt_suballoc *sa)
+{
+	free(sa->chunks);
+	memset(sa, 0, sizeof(*sa));
+}
+
+/**
+ * igt_suballoc_retire:
+ * @sa: suballocator
+ *
+ * Releases, oldest first, every chunk whose fence has already signaled.
+ * Never blocks.
+ *
+ * Returns: the number of chunks released.
+ */
+unsigned int igt_suballoc_retire(struct igt_suballoc *sa)
+{
+	unsigned int retired = 0;
+	bool known = false;
+	uint64_t signaled = 0;
+
+	while (sa->count) {
+		struct igt_suballoc_chunk *chunk = oldest(sa);
+
+		if (!chunk->fenced)
+			break;
+
+		/* consecutive chunks usually share the fence of one submission */
+		if (!known || chunk->fence != signaled) {
+			if (!sa->ops->wait(sa->priv, chunk->fence, 0))
+				break;
+
+			known = true;
+			signaled = chunk->fence;
+		}
+
+		pop_chunk(sa);
+		retired++;
+	}
+
+	return retired;
+}
+
+static bool __igt_suballoc_alloc(struct igt_suballoc *sa, uint64_t size,
+				 uint64_t *offset, bool wait)
+{
+	size = ALIGN(size, sa->alignment);
+	if (!size || size > sa->size)
+		return false;
+
+	for (;;) {
+		struct igt_suballoc_chunk *chunk;
+
+		igt_suballoc_retire(sa);
+
+		if (fit(sa, size, offset)) {
+			push_chunk(sa, *offset, size);
+			sa->head = *offset + size;
+			sa->stats.allocs++;
+			return true;
+		}
+
+		/* whatever is in the way has not been submitted yet */
+		chunk = oldest(sa);
+		if (!wait || !chunk->fenced)
+			return false;
+
+		sa->stats.waits++;
+		igt_assert(sa->ops->wait(sa->priv, chunk->fence, -1));
+	}
+}
+
+/**
+ * igt_suballoc_try_alloc:
+ * @sa: suballocator
+ * @size: number of bytes requested
+ * @offset: returns the offset of the allocation in the backing buffer
+ *
+ * Like igt_suballoc_alloc() but fails instead of waiting for in-flight
+ * chunks to retire.
+ *
+ * Returns: true on success.
+ */
+bool igt_suballoc_try_alloc(struct igt_suballoc *sa, uint64_t size, uint64_t *offset)
+{
+	return __igt_suballoc_alloc(sa, size, offset, false);
+}
+
+/**
+ * igt_suballoc_alloc:
+ * @sa: suballocator
+ * @size: number of bytes requested
+ * @offset: returns the offset of the allocation in the backing buffer
+ *
+ * Allocates @size bytes, waiting on the oldest in-flight fences until enough
+ * contiguous space is available.
+ *
+ * Returns: true on success, false if @size can never fit or the space is
+ * held by chunks that have not been fenced yet.
+ */
+bool igt_suballoc_alloc(struct igt_suballoc *sa, uint64_t size, uint64_t *offset)
+{
+	return __igt_suballoc_alloc(sa, size, offset, true);
+}
+
+/**
+ * igt_suballoc_fence:
+ * @sa: suballocator
+ * @fence: fence cookie signaling once the GPU is done with the chunks
+ *
+ * Attaches @fence to all chunks allocated since the previous call, making
+ * them eligible for reuse once it signals.
+ */
+void igt_suballoc_fence(struct igt_suballoc *sa, uint64_t fence)
+{
+	for (unsigned int i = sa->count; i--; ) {
+		struct igt_suballoc_chunk *chunk =
+			&sa->chunks[(sa->first + i) % sa->capacity];
+
+		if (chunk->fenced)
+			break;
+
+		chunk->fence = fence;
+		chunk->fenced = true;
+	}
+}
+
+/**
+ * igt_suballoc_wait_idle:
+ * @sa: suballocator
+ *
+ * Waits for every fenced chunk to retire.
+ */
+void igt_suballoc_wait_idle(struct igt_suballoc *sa)
+{
+	while (sa->count && oldest(sa)->fenced) {
+		igt_assert(sa->ops->wait(sa->priv, oldest(sa)->fence, -1));
+		pop_chunk(sa);
+	}
+}
+
+/**
+ * igt_suballoc_used:
+ * @sa: suballocator
+ *
+ * Returns: the number of bytes currently held by in-flight chunks,
+ * including any padding skipped when wrapping around.
+ */
+uint64_t igt_suballoc_used(const struct igt_suballoc *sa)
+{
+	uint64_t tail;
+
+	if (!sa->count)
+		return 0;
+
+	tail = sa->chunks[sa->first].offset;
+	if (sa->head > tail)
+		return sa->head - tail;
+
+	return sa->size - tail + sa->head;
+}
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef __IGT_SUBALLOC_H__
+#define __IGT_SUBALLOC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * igt_suballoc_ops:
+ * @wait: returns true once @fence has signaled, waiting at most @timeout_ns
+ *	  (0 polls, -1 waits forever)
+ *
+ * Fence backend used by the suballocator to decide when a chunk handed out
+ * earlier may be reused. Fences are opaque 64-bit cookies chosen by the user.
+ */
+struct igt_suballoc_ops {
+	bool (*wait)(void *priv, uint64_t fence, int64_t timeout_ns);
+};
+
+struct igt_suballoc_chunk {
+	uint64_t offset;
+	uint64_t size;
+	uint64_t fence;
+	bool fenced;
+};
+
+struct igt_suballoc {
+	uint64_t size;
+	uint64_t alignment;
+	uint64_t head;
+
+	/* ring of in-flight chunks, oldest first */
+	struct igt_suballoc_chunk *chunks;
+	unsigned int first, count, capacity;
+
+	const struct igt_suballoc_ops *ops;
+	void *priv;
+
+	struct {
+		uint64_t allocs;
+		uint64_t retired;
+		uint64_t waits;
+	} stats;
+};
+
+void igt_suballoc_init(struct igt_suballoc *sa, uint64_t size, uint64_t alignment,
+		       const struct igt_suballoc_ops *ops, void *priv);
+void igt_suballoc_fini(struct igt_suballoc *sa);
+
+bool igt_suballoc_try_alloc(struct igt_suballoc *sa, uint64_t size, uint64_t *offset);
+bool igt_suballoc_alloc(struct igt_suballoc *sa, uint64_t size, uint64_t *offset);
+void igt_suballoc_fence(struct igt_suballoc *sa, uint64_t fence);
+unsigned int igt_suballoc_retire(struct igt_suballoc *sa);
+void igt_suballoc_wait_idle(struct igt_suballoc *sa);
+uint64_t igt_suballoc_used(const struct igt_suballoc *sa);
+
+#endif /* __IGT_SUBALLOC_H__ */
@@ -21,6 +21,8 @@
  * IN THE SOFTWARE.
  */
 
+#include <pthread.h>
+
 #include "drmtest.h"
 #include "igt_aux.h"
 #include "igt_fb.h"
@@ -242,8 +244,21 @@ void igt_vc4_perfmon_destroy(int fd, uint32_t id)
 /* Calculate the t-tile width so that size = width * height * bpp / 8. */
 #define VC4_T_TILE_W(size, height, bpp) ((size) / (height) / ((bpp) / 8))
 
-static size_t igt_vc4_t_tiled_offset(size_t stride, size_t height, size_t bpp,
-				     size_t x, size_t y)
+/**
+ * igt_vc4_t_tiled_offset:
+ * @stride: stride of the T-tiled buffer in bytes
+ * @height: height of the buffer in pixels
+ * @bpp: bits per pixel, 16 or 32
+ * @x: pixel column
+ * @y: pixel row
+ *
+ * Reference per-pixel address computation for the VC4 T-tiled layout. The
+ * framebuffer converters use igt_vc4_t_tiled_copy() instead.
+ *
+ * Returns: the byte offset of pixel (@x, @y) in the T-tiled buffer.
+ */
+size_t igt_vc4_t_tiled_offset(size_t stride, size_t height, size_t bpp,
+			      size_t x, size_t y)
 {
 	const size_t t1k_map_even[] = { 0, 3, 1, 2 };
 	const size_t t1k_map_odd[] = { 2, 1, 3, 0 };
@@ -317,70 +332,266 @@ static size_t igt_vc4_t_tiled_offset(size_t stride, size_t height, size_t bpp,
 	return offset;
 }
 
-static void vc4_fb_convert_plane_to_t_tiled(struct igt_fb *dst, void *dst_buf,
-					    struct igt_fb *src, void *src_buf,
-					    unsigned int plane)
+/*
+ * Independently of the bpp, a 4K tile covers 128 bytes x 32 rows of the
+ * linear image, a 1K tile 64 bytes x 16 rows and a 64-byte micro-tile
+ * 16 bytes x 4 rows, each micro-tile row being contiguous. The converters
+ * below walk the tiled image in memory order and move whole micro-tile
+ * rows, which lets the compiler emit one 16-byte load/store per row.
+ */
+#define VC4_T4K_ROW_BYTES	128
+#define VC4_T4K_ROWS		32
+#define VC4_T64_ROW_BYTES	16
+#define VC4_T64_ROWS		4
+
+struct vc4_tiling_job {
+	uint8_t *tiled;
+	uint8_t *linear;
+	size_t tiled_stride;
+	size_t linear_stride;
+	size_t width_bytes;
+	unsigned int height;
+	bool to_tiled;
+
+	/* SAND only */
+	size_t column_bytes;
+	size_t column_size;
+
+	/* rows handled by this job, in 4K tile rows or pixel rows */
+	unsigned int first, last;
+};
+
+static inline void
+vc4_copy_span(const struct vc4_tiling_job *job, uint8_t *tiled,
+	      uint8_t *linear, size_t len)
+{
+	if (job->to_tiled)
+		memcpy(tiled, linear, len);
+	else
+		memcpy(linear, tiled, len);
+}
+
+static void vc4_t_tiled_copy_64(const struct vc4_tiling_job *job,
+				uint8_t *tiled, size_t x, size_t y)
 {
-	size_t bpp = src->plane_bpp[plane];
-	unsigned int i, j;
-
-	for (i = 0; i < src->height; i++) {
-		for (j = 0; j < src->width; j++) {
-			size_t src_offset = src->offsets[plane];
-			size_t dst_offset = dst->offsets[plane];
-
-			src_offset += src->strides[plane] * i + j * bpp / 8;
-			dst_offset += igt_vc4_t_tiled_offset(dst->strides[plane],
-							     dst->height,
-							     bpp, j, i);
-
-			switch (bpp) {
-			case 16:
-				*(uint16_t *)(dst_buf + dst_offset) =
-					*(uint16_t *)(src_buf + src_offset);
-				break;
-			case 32:
-				*(uint32_t *)(dst_buf + dst_offset) =
-					*(uint32_t *)(src_buf + src_offset);
-				break;
+	uint8_t *linear = job->linear + y * job->linear_stride + x;
+	unsigned int rows = min_t(unsigned int, VC4_T64_ROWS, job->height - y);
+	size_t len = min_t(size_t, VC4_T64_ROW_BYTES, job->width_bytes - x);
+	unsigned int r;
+
+	if (len == VC4_T64_ROW_BYTES && rows == VC4_T64_ROWS) {
+		for (r = 0; r < VC4_T64_ROWS; r++) {
+			vc4_copy_span(job, tiled, linear, VC4_T64_ROW_BYTES);
+			tiled += VC4_T64_ROW_BYTES;
+			linear += job->linear_stride;
+		}
+		return;
+	}
+
+	/* Partial micro-tile on the right or bottom edge. */
+	for (r = 0; r < rows; r++) {
+		vc4_copy_span(job, tiled, linear, len);
+		tiled += VC4_T64_ROW_BYTES;
+		linear += job->linear_stride;
+	}
+}
+
+static void vc4_t_tiled_copy_rows(const struct vc4_tiling_job *job)
+{
+	static const unsigned int t1k_map_even[] = { 0, 3, 1, 2 };
+	static const unsigned int t1k_map_odd[] = { 2, 1, 3, 0 };
+	size_t t4k_w = job->tiled_stride / VC4_T4K_ROW_BYTES;
+	unsigned int t4k_y;
+
+	for (t4k_y = job->first; t4k_y < job->last; t4k_y++) {
+		const unsigned int *map = t4k_y % 2 ? t1k_map_odd : t1k_map_even;
+		uint8_t *row = job->tiled + t4k_y * t4k_w * 4096;
+		size_t t4k_x;
+
+		for (t4k_x = 0; t4k_x * VC4_T4K_ROW_BYTES < job->width_bytes; t4k_x++) {
+			/* Odd rows start from the right, even rows from the left. */
+			uint8_t *t4k = row + (t4k_y % 2 ? t4k_w - t4k_x - 1 : t4k_x) * 4096;
+			unsigned int index;
+
+			for (index = 0; index < 4; index++) {
+				size_t x = t4k_x * VC4_T4K_ROW_BYTES + (index % 2) * 64;
+				size_t y = t4k_y * VC4_T4K_ROWS + (index / 2) * 16;
+				uint8_t *t1k = t4k + map[index] * 1024;
+				unsigned int t64;
+
+				if (x >= job->width_bytes || y >= job->height)
+					continue;
+
+				for (t64 = 0; t64 < 16; t64++) {
+					size_t x64 = x + (t64 % 4) * VC4_T64_ROW_BYTES;
+					size_t y64 = y + (t64 / 4) * VC4_T64_ROWS;
+
+					if (x64 >= job->width_bytes || y64 >= job->height)
+						continue;
+
+					vc4_t_tiled_copy_64(job, t1k + t64 * 64, x64, y64);
+				}
 			}
 		}
 	}
 }
 
+static void vc4_sand_tiled_copy_rows(const struct vc4_tiling_job *job)
+{
+	unsigned int y;
+
+	for (y = job->first; y < job->last; y++) {
+		uint8_t *linear = job->linear + y * job->linear_stride;
+		uint8_t *tiled = job->tiled + y * job->column_bytes;
+		size_t x;
+
+		/* Each column holds a column_bytes wide strip of every row. */
+		for (x = 0; x < job->width_bytes; x += job->column_bytes) {
+			vc4_copy_span(job, tiled, linear + x,
+				      min_t(size_t, job->column_bytes,
+					    job->width_bytes - x));
+			tiled += job->column_size;
+		}
+	}
+}
+
+struct vc4_tiling_thread {
+	pthread_t thread;
+	struct vc4_tiling_job job;
+	void (*fn)(const struct vc4_tiling_job *job);
+};
+
+static void *vc4_tiling_thread(void *data)
+{
+	struct vc4_tiling_thread *t = data;
+
+	t->fn(&t->job);
+
+	return NULL;
+}
+
+/*
+ * Splits the rows of @job evenly between the online CPUs. Rows below
+ * @min_rows per thread are not worth the thread creation overhead.
+ */
+static void vc4_tiling_run(void (*fn)(const struct vc4_tiling_job *job),
+			   const struct vc4_tiling_job *job, unsigned int rows,
+			   unsigned int min_rows)
+{
+	struct vc4_tiling_thread *threads;
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int nthreads, i;
+
+	nthreads = min_t(unsigned int, ncpus > 0 ? ncpus : 1, rows / min_rows);
+	if (nthreads <= 1) {
+		struct vc4_tiling_job single = *job;
+
+		single.first = 0;
+		single.last = rows;
+		fn(&single);
+		return;
+	}
+
+	threads = calloc(nthreads, sizeof(*threads));
+	igt_assert(threads);
+
+	for (i = 0; i < nthreads; i++) {
+		threads[i].fn = fn;
+		threads[i].job = *job;
+		threads[i].job.first = rows * i / nthreads;
+		threads[i].job.last = rows * (i + 1) / nthreads;
+	}
+
+	/* The calling thread takes the first slice itself. */
+	for (i = 1; i < nthreads; i++)
+		igt_assert_eq(pthread_create(&threads[i].thread, NULL,
+					     vc4_tiling_thread, &threads[i]), 0);
+
+	fn(&threads[0].job);
+
+	for (i = 1; i < nthreads; i++)
+		pthread_join(threads[i].thread, NULL);
+
+	free(threads);
+}
+
+/**
+ * igt_vc4_t_tiled_copy:
+ * @tiled: T-tiled buffer
+ * @linear: linear buffer
+ * @tiled_stride: stride of @tiled in bytes
+ * @linear_stride: stride of @linear in bytes
+ * @width: width of the image in pixels
+ * @height: height of the image in pixels
+ * @bpp: bits per pixel, 16 or 32
+ * @to_tiled: copy from @linear to @tiled if true, the other way round otherwise
+ *
+ * Converts an image between the linear and the VC4 T-tiled layouts, producing
+ * the same result as copying every pixel to igt_vc4_t_tiled_offset(). Bytes
+ * of the destination outside of the image are left untouched.
+ */
+void igt_vc4_t_tiled_copy(void *tiled, void *linear,
+			  size_t tiled_stride, size_t linear_stride,
+			  unsigned int width, unsigned int height,
+			  unsigned int bpp, bool to_tiled)
+{
+	struct vc4_tiling_job job = {
+		.tiled = tiled,
+		.linear = linear,
+		.tiled_stride = tiled_stride,
+		.linear_stride = linear_stride,
+		.width_bytes = (size_t)width * bpp / 8,
+		.height = height,
+		.to_tiled = to_tiled,
+	};
+
+	/* T-tiling is only supported for 16 and 32 bpp. */
+	igt_assert(bpp == 16 || bpp == 32);
+
+	/* T-tiling stride must be aligned to the 4K tiles strides. */
+	igt_assert((tiled_stride % VC4_T4K_ROW_BYTES) == 0);
+	igt_assert(job.width_bytes <= tiled_stride);
+
+	vc4_tiling_run(vc4_t_tiled_copy_rows, &job,
+		       DIV_ROUND_UP(height, VC4_T4K_ROWS), 4);
+}
+
+static void vc4_fb_convert_plane_to_t_tiled(struct igt_fb *dst, void *dst_buf,
+					    struct igt_fb *src, void *src_buf,
+					    unsigned int plane)
+{
+	igt_vc4_t_tiled_copy(dst_buf + dst->offsets[plane],
+			     src_buf + src->offsets[plane],
+			     dst->strides[plane], src->strides[plane],
+			     src->width, src->height,
+			     src->plane_bpp[plane], true);
+}
+
 static void vc4_fb_convert_plane_from_t_tiled(struct igt_fb *dst, void *dst_buf,
 					      struct igt_fb *src, void *src_buf,
 					      unsigned int plane)
 {
-	size_t bpp = src->plane_bpp[plane];
-	unsigned int i, j;
-
-	for (i = 0; i < src->height; i++) {
-		for (j = 0; j < src->width; j++) {
-			size_t src_offset = src->offsets[plane];
-			size_t dst_offset = dst->offsets[plane];
-
-			src_offset += igt_vc4_t_tiled_offset(src->strides[plane],
-							     src->height,
-							     bpp, j, i);
-			src_offset += dst->strides[plane] * i + j * bpp / 8;
-
-			switch (bpp) {
-			case 16:
-				*(uint16_t *)(dst_buf + dst_offset) =
-					*(uint16_t *)(src_buf + src_offset);
-				break;
-			case 32:
-				*(uint32_t *)(dst_buf + dst_offset) =
-					*(uint32_t *)(src_buf + src_offset);
-				break;
-			}
-		}
-	}
+	igt_vc4_t_tiled_copy(src_buf + src->offsets[plane],
+			     dst_buf + dst->offsets[plane],
+			     src->strides[plane], dst->strides[plane],
+			     src->width, src->height,
+			     src->plane_bpp[plane], false);
 }
 
-static size_t vc4_sand_tiled_offset(size_t column_width, size_t column_size, size_t x,
-				    size_t y, size_t bpp)
+/**
+ * igt_vc4_sand_tiled_offset:
+ * @column_width: width of a column in pixels
+ * @column_size: size of a column in bytes
+ * @x: pixel column
+ * @y: pixel row
+ * @bpp: bits per pixel
+ *
+ * Reference per-pixel address computation for the Broadcom SAND layouts.
+ *
+ * Returns: the byte offset of pixel (@x, @y) in the SAND buffer.
+ */
+size_t igt_vc4_sand_tiled_offset(size_t column_width, size_t column_size, size_t x,
+				 size_t y, size_t bpp)
 {
 	size_t offset = 0;
 	size_t cols_x;
@@ -397,116 +608,95 @@ static size_t vc4_sand_tiled_offset(size_t column_width, size_t column_size, siz
 	return offset;
 }
 
-static void vc4_fb_convert_plane_to_sand_tiled(struct igt_fb *dst, void *dst_buf,
-					       struct igt_fb *src, void *src_buf,
-					       unsigned int plane)
+/**
+ * igt_vc4_sand_tiled_copy:
+ * @tiled: SAND buffer
+ * @linear: linear buffer
+ * @column_width: width of a column in pixels
+ * @column_size: size of a column in bytes
+ * @linear_stride: stride of @linear in bytes
+ * @width: width of the plane in pixels
+ * @height: height of the plane in pixels
+ * @bpp: bits per pixel, 8 or 16
+ * @to_tiled: copy from @linear to @tiled if true, the other way round otherwise
+ *
+ * Converts a plane between the linear and a Broadcom SAND layout, producing
+ * the same result as copying every pixel to igt_vc4_sand_tiled_offset().
+ */
+void igt_vc4_sand_tiled_copy(void *tiled, void *linear,
+			     size_t column_width, size_t column_size,
+			     size_t linear_stride,
+			     unsigned int width, unsigned int height,
+			     unsigned int bpp, bool to_tiled)
 {
-	uint64_t modifier_base = fourcc_mod_broadcom_mod(dst->modifier);
-	uint32_t column_height = fourcc_mod_broadcom_param(dst->modifier);
-	uint32_t column_width_bytes, column_width, column_size;
-	size_t bpp = dst->plane_bpp[plane];
-	unsigned int i, j;
+	struct vc4_tiling_job job = {
+		.tiled = tiled,
+		.linear = linear,
+		.linear_stride = linear_stride,
+		.width_bytes = (size_t)width * bpp / 8,
+		.height = height,
+		.to_tiled = to_tiled,
+		.column_bytes = column_width * bpp / 8,
+		.column_size = column_size,
+	};
 
-	switch (modifier_base) {
+	igt_assert(bpp == 8 || bpp == 16);
+	igt_assert(job.column_bytes);
+
+	vc4_tiling_run(vc4_sand_tiled_copy_rows, &job, height, 128);
+}
+
+static uint32_t vc4_sand_column_width_bytes(uint64_t modifier)
+{
+	switch (fourcc_mod_broadcom_mod(modifier)) {
 	case DRM_FORMAT_MOD_BROADCOM_SAND32:
-		column_width_bytes = 32;
-		break;
+		return 32;
 	case DRM_FORMAT_MOD_BROADCOM_SAND64:
-		column_width_bytes = 64;
-		break;
+		return 64;
 	case DRM_FORMAT_MOD_BROADCOM_SAND128:
-		column_width_bytes = 128;
-		break;
+		return 128;
 	case DRM_FORMAT_MOD_BROADCOM_SAND256:
-		column_width_bytes = 256;
-		break;
+		return 256;
 	default:
 		igt_assert(false);
+		return 0;
 	}
+}
+
+static void vc4_fb_convert_plane_to_sand_tiled(struct igt_fb *dst, void *dst_buf,
+					       struct igt_fb *src, void *src_buf,
+					       unsigned int plane)
+{
+	uint32_t column_height = fourcc_mod_broadcom_param(dst->modifier);
+	uint32_t column_width_bytes = vc4_sand_column_width_bytes(dst->modifier);
+	uint32_t column_width, column_size;
 
 	column_width = column_width_bytes * dst->plane_width[plane] / dst->width;
 	column_size = column_width_bytes * column_height;
 
-	for (i = 0; i < dst->plane_height[plane]; i++) {
-		for (j = 0; j < src->plane_width[plane]; j++) {
-			size_t src_offset = src->offsets[plane];
-			size_t dst_offset = dst->offsets[plane];
-
-			src_offset += src->strides[plane] * i + j * bpp / 8;
-			dst_offset += vc4_sand_tiled_offset(column_width,
-							    column_size, j, i,
-							    bpp);
-
-			switch (bpp) {
-			case 8:
-				*(uint8_t *)(dst_buf + dst_offset) =
-					*(uint8_t *)(src_buf + src_offset);
-				break;
-			case 16:
-				*(uint16_t *)(dst_buf + dst_offset) =
-					*(uint16_t *)(src_buf + src_offset);
-				break;
-			default:
-				igt_assert(false);
-			}
-		}
-	}
+	igt_vc4_sand_tiled_copy(dst_buf + dst->offsets[plane],
+				src_buf + src->offsets[plane],
+				column_width, column_size, src->strides[plane],
+				src->plane_width[plane], dst->plane_height[plane],
+				dst->plane_bpp[plane], true);
 }
 
 static void vc4_fb_convert_plane_from_sand_tiled(struct igt_fb *dst, void *dst_buf,
 						 struct igt_fb *src, void *src_buf,
 						 unsigned int plane)
 {
-	uint64_t modifier_base = fourcc_mod_broadcom_mod(src->modifier);
 	uint32_t column_height = fourcc_mod_broadcom_param(src->modifier);
-	uint32_t column_width_bytes, column_width, column_size;
-	size_t bpp = src->plane_bpp[plane];
-	unsigned int i, j;
-
-	switch (modifier_base) {
-	case DRM_FORMAT_MOD_BROADCOM_SAND32:
-		column_width_bytes = 32;
-		break;
-	case DRM_FORMAT_MOD_BROADCOM_SAND64:
-		column_width_bytes = 64;
-		break;
-	case DRM_FORMAT_MOD_BROADCOM_SAND128:
-		column_width_bytes = 128;
-		break;
-	case DRM_FORMAT_MOD_BROADCOM_SAND256:
-		column_width_bytes = 256;
-		break;
-	default:
-		igt_assert(false);
-	}
+	uint32_t column_width_bytes = vc4_sand_column_width_bytes(src->modifier);
+	uint32_t column_width, column_size;
 
 	column_width = column_width_bytes * src->plane_width[plane] / src->width;
 	column_size = column_width_bytes * column_height;
 
-	for (i = 0; i < dst->plane_height[plane]; i++) {
-		for (j = 0; j < src->plane_width[plane]; j++) {
-			size_t src_offset = src->offsets[plane];
-			size_t dst_offset = dst->offsets[plane];
-
-			src_offset += vc4_sand_tiled_offset(column_width,
-							    column_size, j, i,
-							    bpp);
-			dst_offset += dst->strides[plane] * i + j * bpp / 8;
-
-			switch (bpp) {
-			case 8:
-				*(uint8_t *)(dst_buf + dst_offset) =
-					*(uint8_t *)(src_buf + src_offset);
-				break;
-			case 16:
-				*(uint16_t *)(dst_buf + dst_offset) =
-					*(uint16_t *)(src_buf + src_offset);
-				break;
-			default:
-				igt_assert(false);
-			}
-		}
-	}
+	igt_vc4_sand_tiled_copy(src_buf + src->offsets[plane],
+				dst_buf + dst->offsets[plane],
+				column_width, column_size, dst->strides[plane],
+				src->plane_width[plane], dst->plane_height[plane],
+				src->plane_bpp[plane], false);
 }
 
 void vc4_fb_convert_plane_to_tiled(struct igt_fb *dst, void *dst_buf,
@@ -48,6 +48,20 @@ void igt_vc4_perfmon_destroy(int fd, uint32_t id);
 void igt_vc4_set_tiling(int fd, uint32_t handle, uint64_t modifier);
 uint64_t igt_vc4_get_tiling(int fd, uint32_t handle);
 
+size_t igt_vc4_t_tiled_offset(size_t stride, size_t height, size_t bpp,
+			      size_t x, size_t y);
+void igt_vc4_t_tiled_copy(void *tiled, void *linear,
+			  size_t tiled_stride, size_t linear_stride,
+			  unsigned int width, unsigned int height,
+			  unsigned int bpp, bool to_tiled);
+size_t igt_vc4_sand_tiled_offset(size_t column_width, size_t column_size, size_t x,
+				 size_t y, size_t bpp);
+void igt_vc4_sand_tiled_copy(void *tiled, void *linear,
+			     size_t column_width, size_t column_size,
+			     size_t linear_stride,
+			     unsigned int width, unsigned int height,
+			     unsigned int bpp, bool to_tiled);
+
 void vc4_fb_convert_plane_to_tiled(struct igt_fb *dst, void *dst_buf,
 				     struct igt_fb *src, void *src_buf);
 void vc4_fb_convert_plane_from_tiled(struct igt_fb *dst, void *dst_buf,
@@ -27,15 +27,25 @@
 #include "igt_core.h"
 #include "igt_vec.h"
 
+/*
+ * Short vectors live in the storage embedded in struct igt_vec, so a vector
+ * must not be copied by value. Longer ones move to the heap, growing the
+ * capacity by doubling.
+ */
+
 void igt_vec_init(struct igt_vec *vec, int elem_size)
 {
 	memset(vec, 0, sizeof(*vec));
 	vec->elem_size = elem_size;
+	vec->size = sizeof(vec->inline_elems) / elem_size;
+	vec->elems = vec->size ? vec->inline_elems : NULL;
 }
 
 void igt_vec_fini(struct igt_vec *vec)
 {
-	free(vec->elems);
+	if (vec->elems != vec->inline_elems)
+		free(vec->elems);
+	free(vec->index);
 	memset(vec, 0, sizeof(*vec));
 }
 
@@ -46,20 +56,98 @@ void *igt_vec_elem(const struct igt_vec *vec, int idx)
 	return vec->elems + idx * vec->elem_size;
 }
 
-static void *igt_vec_grow(struct igt_vec *vec)
+static void index_invalidate(struct igt_vec *vec)
 {
-	if (vec->len++ >= vec->size) {
-		vec->size = vec->size ? vec->size * 2 : 8;
-		vec->elems = realloc(vec->elems, vec->size * vec->elem_size);
-		igt_assert(vec->elems);
+	vec->index_len = 0;
+}
+
+/**
+ * igt_vec_reserve:
+ * @vec: vector
+ * @size: number of elements
+ *
+ * Makes room for at least @size elements, so that they can be added
+ * without reallocating.
+ */
+void igt_vec_reserve(struct igt_vec *vec, int size)
+{
+	void *elems;
+
+	if (size <= vec->size)
+		return;
+
+	if (vec->elems == vec->inline_elems) {
+		elems = malloc(size * vec->elem_size);
+		igt_assert(elems);
+		memcpy(elems, vec->elems, vec->len * vec->elem_size);
+	} else {
+		elems = realloc(vec->elems, size * vec->elem_size);
+		igt_assert(elems);
 	}
 
-	return igt_vec_elem(vec, vec->len - 1);
+	vec->elems = elems;
+	vec->size = size;
+}
+
+static void *igt_vec_grow(struct igt_vec *vec, int count)
+{
+	if (vec->len + count > vec->size) {
+		int size = vec->size ? vec->size * 2 : 8;
+
+		while (size < vec->len + count)
+			size *= 2;
+
+		igt_vec_reserve(vec, size);
+	}
+
+	vec->len += count;
+
+	return igt_vec_elem(vec, vec->len - count);
 }
 
 void igt_vec_push(struct igt_vec *vec, void *elem)
 {
-	memcpy(igt_vec_grow(vec), elem, vec->elem_size);
+	memcpy(igt_vec_grow(vec, 1), elem, vec->elem_size);
+}
+
+/**
+ * igt_vec_append:
+ * @vec: vector
+ * @elems: array of elements
+ * @count: number of elements in @elems
+ *
+ * Appends @count elements at once, growing @vec at most once.
+ */
+void igt_vec_append(struct igt_vec *vec, const void *elems, int count)
+{
+	if (count <= 0)
+		return;
+
+	memcpy(igt_vec_grow(vec, count), elems, count * vec->elem_size);
+}
+
+/**
+ * igt_vec_insert:
+ * @vec: vector
+ * @idx: position of the new element, up to the length of @vec
+ * @elem: element to insert
+ *
+ * Inserts @elem before the element at @idx, shifting the tail.
+ */
+void igt_vec_insert(struct igt_vec *vec, int idx, const void *elem)
+{
+	void *dst;
+
+	igt_assert(idx >= 0 && idx <= vec->len);
+
+	igt_vec_grow(vec, 1);
+	dst = igt_vec_elem(vec, idx);
+	memmove(dst + vec->elem_size, dst,
+		(vec->len - 1 - idx) * vec->elem_size);
+	memcpy(dst, elem, vec->elem_size);
+
+	if (idx < vec->len - 1)
+		index_invalidate(vec);
 }
 
 int igt_vec_length(const struct igt_vec *vec)
@@ -67,8 +155,88 @@ int igt_vec_length(const struct igt_vec *vec)
 	return vec->len;
 }
 
+static uint32_t elem_hash(const struct igt_vec *vec, const void *elem)
+{
+	const uint8_t *p = elem;
+	uint32_t hash = 2166136261u;
+
+	/* FNV-1a */
+	for (int i = 0; i < vec->elem_size; i++)
+		hash = (hash ^ p[i]) * 16777619u;
+
+	return hash;
+}
+
+/* Returns the slot holding an element equal to @elem, or the empty one to use */
+static int *index_slot(const struct igt_vec *vec, const void *elem)
+{
+	uint32_t mask = vec->index_size - 1;
+	uint32_t slot = elem_hash(vec, elem) & mask;
+
+	while (vec->index[slot] &&
+	       memcmp(igt_vec_elem(vec, vec->index[slot] - 1), elem, vec->elem_size))
+		slot = (slot + 1) & mask;
+
+	return &vec->index[slot];
+}
+
+/* Catches up with the elements added since the last lookup */
+static void index_update(struct igt_vec *vec)
+{
+	if (vec->index_len && vec->len * 2 <= vec->index_size)
+		goto add;
+
+	if (!vec->index || vec->len * 2 > vec->index_size) {
+		vec->index_size = vec->index_size ?: 64;
+		while (vec->len * 2 > vec->index_size)
+			vec->index_size *= 2;
+
+		free(vec->index);
+		vec->index = malloc(vec->index_size * sizeof(*vec->index));
+		igt_assert(vec->index);
+	}
+
+	memset(vec->index, 0, vec->index_size * sizeof(*vec->index));
+	vec->index_len = 0;
+
+add:
+	for (; vec->index_len < vec->len; vec->index_len++) {
+		int *slot = index_slot(vec, igt_vec_elem(vec, vec->index_len));
+
+		/* keep pointing at the first of equal elements */
+		if (!*slot)
+			*slot = vec->index_len + 1;
+	}
+}
+
+/**
+ * igt_vec_enable_index:
+ * @vec: vector
+ *
+ * Makes igt_vec_index() use a hash of the elements instead of a linear
+ * search. The index is updated incrementally as elements are appended, and
+ * rebuilt on the next lookup after any other change. Elements must not be
+ * modified in place while indexed.
+ */
+void igt_vec_enable_index(struct igt_vec *vec)
+{
+	if (!vec->index)
+		index_update(vec);
+}
+
 int igt_vec_index(const struct igt_vec *vec, void *elem)
 {
+	if (vec->index) {
+		/* the index is a cache, refreshing it does not change @vec */
+		struct igt_vec *v = (struct igt_vec *)vec;
+		int *slot;
+
+		index_update(v);
+		slot = index_slot(v, elem);
+
+		return *slot - 1;
+	}
+
 	for (int i = 0; i < vec->len; i++) {
 		if (!memcmp(igt_vec_elem(vec, i), elem, vec->elem_size))
 			return i;
@@ -79,11 +247,94 @@ int igt_vec_index(const struct igt_vec *vec, void *elem)
 
 void igt_vec_remove(struct igt_vec *vec, int idx)
 {
-	igt_assert(idx >= 0 && idx < vec->len);
+	void *dst = igt_vec_elem(vec, idx);
 
-	memmove(igt_vec_elem(vec, idx),
-		igt_vec_elem(vec, idx + 1),
+	memmove(dst, dst + vec->elem_size,
 		(vec->len - 1 - idx) * vec->elem_size);
 
 	vec->len--;
+	index_invalidate(vec);
+}
+
+/**
+ * igt_vec_swap_remove:
+ * @vec: vector
+ * @idx: index of the element to remove
+ *
+ * Removes the element at @idx in constant time by moving the last element
+ * in its place, not preserving the order of the elements.
+ */
+void igt_vec_swap_remove(struct igt_vec *vec, int idx)
+{
+	void *dst = igt_vec_elem(vec, idx);
+
+	if (idx != vec->len - 1)
+		memcpy(dst, igt_vec_elem(vec, vec->len - 1), vec->elem_size);
+
+	vec->len--;
+	index_invalidate(vec);
+}
+
+/* Index of the first element greater than @elem */
+static int upper_bound(const struct igt_vec *vec, const void *elem,
+		       igt_vec_cmp_t cmp)
+{
+	int lo = 0, hi = vec->len;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (cmp(igt_vec_elem(vec, mid), elem) <= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/**
+ * igt_vec_insert_sorted:
+ * @vec: vector sorted according to @cmp
+ * @elem: element to insert
+ * @cmp: comparison function, as for qsort()
+ *
+ * Inserts @elem keeping @vec sorted, after any elements comparing equal.
+ *
+ * Returns: the index of the inserted element.
+ */
+int igt_vec_insert_sorted(struct igt_vec *vec, const void *elem, igt_vec_cmp_t cmp)
+{
+	int idx = upper_bound(vec, elem, cmp);
+
+	igt_vec_insert(vec, idx, elem);
+
+	return idx;
+}
+
+/**
+ * igt_vec_bsearch:
+ * @vec: vector sorted according to @cmp
+ * @elem: element to look for
+ * @cmp: comparison function, as for qsort()
+ *
+ * Returns: the index of the first element comparing equal to @elem, or -1.
+ */
+int igt_vec_bsearch(const struct igt_vec *vec, const void *elem, igt_vec_cmp_t cmp)
+{
+	int lo = 0, hi = vec->len;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (cmp(igt_vec_elem(vec, mid), elem) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < vec->len && !cmp(igt_vec_elem(vec, lo), elem))
+		return lo;
+
+	return -1;
 }
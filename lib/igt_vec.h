@@ -24,17 +24,43 @@
 #ifndef __IGT_VEC_H__
 #define __IGT_VEC_H__
 
+#include <stdint.h>
+
+/* bytes of storage embedded in struct igt_vec, used before going to the heap */
+#define IGT_VEC_INLINE_BYTES 64
+
+/*
+ * Small vectors keep their elements in inline_elems and elems points into the
+ * struct itself. A struct igt_vec must thus not be copied by value, moved with
+ * memcpy() or realloc(), or be part of an element of another igt_vec: the copy
+ * would keep using the storage of the original. Pass pointers instead.
+ */
 struct igt_vec {
 	void *elems;
 	int elem_size, size, len;
+
+	/* optional hash index over the elements, see igt_vec_enable_index() */
+	int *index;
+	int index_size, index_len;
+
+	uint64_t inline_elems[IGT_VEC_INLINE_BYTES / sizeof(uint64_t)];
 };
 
+typedef int (*igt_vec_cmp_t)(const void *a, const void *b);
+
 void igt_vec_init(struct igt_vec *vec, int elem_size);
 void igt_vec_fini(struct igt_vec *vec);
+void igt_vec_reserve(struct igt_vec *vec, int size);
 void igt_vec_push(struct igt_vec *vec, void *elem);
+void igt_vec_append(struct igt_vec *vec, const void *elems, int count);
+void igt_vec_insert(struct igt_vec *vec, int idx, const void *elem);
 int igt_vec_length(const struct igt_vec *vec);
 void *igt_vec_elem(const struct igt_vec *vec, int idx);
 int igt_vec_index(const struct igt_vec *vec, void *elem);
+void igt_vec_enable_index(struct igt_vec *vec);
 void igt_vec_remove(struct igt_vec *vec, int idx);
+void igt_vec_swap_remove(struct igt_vec *vec, int idx);
+int igt_vec_insert_sorted(struct igt_vec *vec, const void *elem, igt_vec_cmp_t cmp);
+int igt_vec_bsearch(const struct igt_vec *vec, const void *elem, igt_vec_cmp_t cmp);
 
 #endif /* __IGT_VEC_H__ */
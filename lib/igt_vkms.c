@@ -44,14 +44,25 @@ enum vkms_pipeline_item {
  * First, create a VKMS device, next, add pipeline items (planes, CRTCs,
  * encoders, CRTCs and connectors) compose the pipeline by attaching each item
  * using the _attach_ functions and finally, enable the VKMS device.
+ *
+ * Alternatively, describe the whole topology with an #igt_vkms_config_t,
+ * check it with igt_vkms_config_validate() and apply it in one pass with
+ * igt_vkms_device_apply_config(). Applying a configuration to an existing
+ * device only touches the items that differ, which igt_vkms_pool_get() uses
+ * to recycle devices across subtests instead of tearing them down.
  */
 
+static char *vkms_root_override;
+
 static const char *mount_vkms_configfs(void)
 {
 	static char vkms_root_path[PATH_MAX];
 	const char *configfs_path;
 	int ret;
 
+	if (vkms_root_override)
+		return vkms_root_override;
+
 	configfs_path = igt_configfs_mount();
 	igt_assert_f(configfs_path, "Error mounting configfs");
 
@@ -487,12 +498,8 @@ igt_vkms_t *igt_vkms_device_create(const char *name)
 igt_vkms_t *igt_vkms_device_create_from_config(igt_vkms_config_t *cfg)
 {
 	igt_vkms_t *dev;
-	igt_vkms_plane_config_t *plane;
-	igt_vkms_crtc_config_t *crtc;
-	igt_vkms_encoder_config_t *encoder;
 	igt_vkms_connector_config_t *connector;
-	const char *name;
-	int n, i;
+	int n;
 
 	igt_debug("Creating device from configuration:\n");
 	igt_debug("\t- Device name: %s\n", cfg->device_name);
@@ -501,67 +508,13 @@ igt_vkms_t *igt_vkms_device_create_from_config(igt_vkms_config_t *cfg)
 	if (!dev)
 		return NULL;
 
-	for (n = 0; (crtc = &cfg->crtcs[n])->name; n++) {
-		igt_debug("\t- CRTC %d:\n", n);
-		igt_debug("\t\t- name: %s\n", crtc->name);
-		igt_debug("\t\t- writeback: %d\n", crtc->writeback);
-
-		igt_vkms_device_add_crtc(dev, crtc->name);
-		igt_vkms_crtc_set_writeback_enabled(dev, crtc->name,
-						    crtc->writeback);
-	}
-
-	for (n = 0; (plane = &cfg->planes[n])->name; n++) {
-		igt_debug("\t- Plane %d:\n", n);
-		igt_debug("\t\t- name: %s\n", plane->name);
-		igt_debug("\t\t- type: %d\n", plane->type);
-		igt_debug("\t\t- possible_crtcs:\n");
-
-		igt_vkms_device_add_plane(dev, plane->name);
-		igt_vkms_plane_set_type(dev, plane->name, plane->type);
-
-		for (i = 0; (name = plane->possible_crtcs[i]); i++) {
-			igt_debug("\t\t\t- %s\n", name);
-
-			igt_vkms_plane_attach_crtc(dev, plane->name, name);
-		}
-	}
-
-	for (n = 0; (encoder = &cfg->encoders[n])->name; n++) {
-		igt_debug("\t- Encoder %d:\n", n);
-		igt_debug("\t\t- name: %s\n", encoder->name);
-		igt_debug("\t\t- possible_crtcs:\n");
-
-		igt_vkms_device_add_encoder(dev, encoder->name);
-
-		for (i = 0; (name = encoder->possible_crtcs[i]); i++) {
-			igt_debug("\t\t\t- %s\n", name);
-
-			igt_vkms_encoder_attach_crtc(dev, encoder->name, name);
-		}
-	}
-
 	for (n = 0; (connector = &cfg->connectors[n])->name; n++) {
 		if (connector->status == 0)
 			connector->status = DRM_MODE_CONNECTED;
-
-		igt_debug("\t- Connector %d:\n", n);
-		igt_debug("\t\t- name: %s\n", connector->name);
-		igt_debug("\t\t- status: %d\n", connector->status);
-		igt_debug("\t\t- possible_encoders:\n");
-
-		igt_vkms_device_add_connector(dev, connector->name);
-		igt_vkms_connector_set_status(dev, connector->name,
-					      connector->status);
-
-		for (i = 0; (name = connector->possible_encoders[i]); i++) {
-			igt_debug("\t\t\t- %s\n", name);
-
-			igt_vkms_connector_attach_encoder(dev, connector->name,
-							  name);
-		}
 	}
 
+	igt_vkms_device_apply_config(dev, cfg);
+
 	return dev;
 }
 
@@ -1001,3 +954,900 @@ bool igt_vkms_connector_detach_encoder(igt_vkms_t *dev,
 	return detach_pipeline_item(dev, VKMS_PIPELINE_ITEM_CONNECTOR,
 				    connector_name, encoder_name);
 }
+
+#define VKMS_NUM_PIPELINE_ITEMS		(VKMS_PIPELINE_ITEM_CONNECTOR + 1)
+#define VKMS_POOL_SIZE			8
+
+/*
+ * In-memory view of a device topology, either read back from configfs or
+ * built from an igt_vkms_config_t. Item values are the plane type, the CRTC
+ * writeback flag and the connector status; links are the names of the items
+ * in the possible_crtcs/possible_encoders directory.
+ */
+struct vkms_item_state {
+	char *name;
+	int value;
+	int n_links;
+	char *links[VKMS_MAX_PIPELINE_ITEMS];
+};
+
+struct vkms_topology {
+	int count[VKMS_NUM_PIPELINE_ITEMS];
+	struct vkms_item_state items[VKMS_NUM_PIPELINE_ITEMS][VKMS_MAX_PIPELINE_ITEMS];
+};
+
+/* Items are created in this order and removed in the reverse one */
+static const enum vkms_pipeline_item vkms_creation_order[] = {
+	VKMS_PIPELINE_ITEM_CRTC,
+	VKMS_PIPELINE_ITEM_PLANE,
+	VKMS_PIPELINE_ITEM_ENCODER,
+	VKMS_PIPELINE_ITEM_CONNECTOR,
+};
+
+static struct vkms_pool_entry {
+	igt_vkms_t *dev;
+	struct vkms_topology *topology;
+	bool in_use;
+} vkms_pool[VKMS_POOL_SIZE];
+
+static struct {
+	unsigned int gets;
+	unsigned int created;
+	unsigned int ops;
+} vkms_pool_stats;
+
+static const char *get_pipeline_item_value_file(enum vkms_pipeline_item item)
+{
+	switch (item) {
+	case VKMS_PIPELINE_ITEM_PLANE:
+		return VKMS_FILE_PLANE_TYPE;
+	case VKMS_PIPELINE_ITEM_CRTC:
+		return VKMS_FILE_CRTC_WRITEBACK;
+	case VKMS_PIPELINE_ITEM_CONNECTOR:
+		return VKMS_FILE_CONNECTOR_STATUS;
+	default:
+		return NULL;
+	}
+}
+
+/* Value of an attribute right after the item has been created */
+static int get_pipeline_item_default_value(enum vkms_pipeline_item item)
+{
+	switch (item) {
+	case VKMS_PIPELINE_ITEM_PLANE:
+		return DRM_PLANE_TYPE_OVERLAY;
+	case VKMS_PIPELINE_ITEM_CONNECTOR:
+		return DRM_MODE_CONNECTED;
+	default:
+		return 0;
+	}
+}
+
+static bool pipeline_item_has_links(enum vkms_pipeline_item item)
+{
+	return item != VKMS_PIPELINE_ITEM_CRTC;
+}
+
+static enum vkms_pipeline_item get_link_target(enum vkms_pipeline_item item)
+{
+	return item == VKMS_PIPELINE_ITEM_CONNECTOR ?
+		VKMS_PIPELINE_ITEM_ENCODER : VKMS_PIPELINE_ITEM_CRTC;
+}
+
+static const char *get_pipeline_item_label(enum vkms_pipeline_item item)
+{
+	switch (item) {
+	case VKMS_PIPELINE_ITEM_PLANE:
+		return "Plane";
+	case VKMS_PIPELINE_ITEM_CRTC:
+		return "CRTC";
+	case VKMS_PIPELINE_ITEM_ENCODER:
+		return "Encoder";
+	case VKMS_PIPELINE_ITEM_CONNECTOR:
+		return "Connector";
+	}
+
+	igt_assert(!"Cannot be reached: Unknown VKMS pipeline item type");
+}
+
+static void topology_free(struct vkms_topology *topo)
+{
+	if (!topo)
+		return;
+
+	for (int k = 0; k < VKMS_NUM_PIPELINE_ITEMS; k++) {
+		for (int n = 0; n < topo->count[k]; n++) {
+			struct vkms_item_state *it = &topo->items[k][n];
+
+			for (int i = 0; i < it->n_links; i++)
+				free(it->links[i]);
+			free(it->name);
+		}
+	}
+
+	free(topo);
+}
+
+static struct vkms_item_state *topology_add(struct vkms_topology *topo,
+					    enum vkms_pipeline_item item,
+					    const char *name, int value)
+{
+	struct vkms_item_state *it;
+
+	igt_assert_f(topo->count[item] < VKMS_MAX_PIPELINE_ITEMS,
+		     "Too many %s items\n", get_pipeline_item_dir_name(item));
+
+	it = &topo->items[item][topo->count[item]++];
+	it->name = strdup(name);
+	it->value = value;
+	igt_assert(it->name);
+
+	return it;
+}
+
+static void topology_add_link(struct vkms_item_state *it, const char *name)
+{
+	igt_assert_f(it->n_links < VKMS_MAX_PIPELINE_ITEMS,
+		     "Too many links from '%s'\n", it->name);
+
+	it->links[it->n_links] = strdup(name);
+	igt_assert(it->links[it->n_links]);
+	it->n_links++;
+}
+
+static struct vkms_item_state *topology_find(const struct vkms_topology *topo,
+					     enum vkms_pipeline_item item,
+					     const char *name)
+{
+	for (int n = 0; n < topo->count[item]; n++) {
+		if (strcmp(topo->items[item][n].name, name) == 0)
+			return (struct vkms_item_state *)&topo->items[item][n];
+	}
+
+	return NULL;
+}
+
+static bool item_has_link(const struct vkms_item_state *it, const char *name)
+{
+	for (int i = 0; i < it->n_links; i++) {
+		if (strcmp(it->links[i], name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+static struct vkms_topology *topology_from_config(const igt_vkms_config_t *cfg)
+{
+	const igt_vkms_plane_config_t *plane;
+	const igt_vkms_crtc_config_t *crtc;
+	const igt_vkms_encoder_config_t *encoder;
+	const igt_vkms_connector_config_t *connector;
+	struct vkms_topology *topo;
+	struct vkms_item_state *it;
+	int n, i;
+
+	topo = calloc(1, sizeof(*topo));
+	igt_assert(topo);
+
+	for (n = 0; n < VKMS_MAX_PIPELINE_ITEMS && (crtc = &cfg->crtcs[n])->name; n++)
+		topology_add(topo, VKMS_PIPELINE_ITEM_CRTC, crtc->name,
+			     crtc->writeback);
+
+	for (n = 0; n < VKMS_MAX_PIPELINE_ITEMS && (plane = &cfg->planes[n])->name; n++) {
+		it = topology_add(topo, VKMS_PIPELINE_ITEM_PLANE, plane->name,
+				  plane->type);
+		for (i = 0; i < VKMS_MAX_PIPELINE_ITEMS && plane->possible_crtcs[i]; i++)
+			topology_add_link(it, plane->possible_crtcs[i]);
+	}
+
+	for (n = 0; n < VKMS_MAX_PIPELINE_ITEMS && (encoder = &cfg->encoders[n])->name; n++) {
+		it = topology_add(topo, VKMS_PIPELINE_ITEM_ENCODER, encoder->name, 0);
+		for (i = 0; i < VKMS_MAX_PIPELINE_ITEMS && encoder->possible_crtcs[i]; i++)
+			topology_add_link(it, encoder->possible_crtcs[i]);
+	}
+
+	for (n = 0; n < VKMS_MAX_PIPELINE_ITEMS && (connector = &cfg->connectors[n])->name; n++) {
+		it = topology_add(topo, VKMS_PIPELINE_ITEM_CONNECTOR, connector->name,
+				  connector->status ?: DRM_MODE_CONNECTED);
+		for (i = 0; i < VKMS_MAX_PIPELINE_ITEMS && connector->possible_encoders[i]; i++)
+			topology_add_link(it, connector->possible_encoders[i]);
+	}
+
+	return topo;
+}
+
+static void topology_dump(const struct vkms_topology *topo)
+{
+	for (int o = 0; o < ARRAY_SIZE(vkms_creation_order); o++) {
+		enum vkms_pipeline_item item = vkms_creation_order[o];
+
+		for (int n = 0; n < topo->count[item]; n++) {
+			const struct vkms_item_state *it = &topo->items[item][n];
+
+			igt_debug("\t- %s %d:\n", get_pipeline_item_label(item), n);
+			igt_debug("\t\t- name: %s\n", it->name);
+			if (get_pipeline_item_value_file(item))
+				igt_debug("\t\t- %s: %d\n",
+					  get_pipeline_item_value_file(item),
+					  it->value);
+			if (!pipeline_item_has_links(item))
+				continue;
+
+			igt_debug("\t\t- %s:\n", get_attach_dir_name(item));
+			for (int i = 0; i < it->n_links; i++)
+				igt_debug("\t\t\t- %s\n", it->links[i]);
+		}
+	}
+}
+
+static bool topology_validate(const struct vkms_topology *topo, char *err,
+			      size_t len)
+{
+#define invalid(...) ({ snprintf(err, len, __VA_ARGS__); false; })
+	if (!topo->count[VKMS_PIPELINE_ITEM_CRTC])
+		return invalid("No CRTC");
+
+	for (int k = 0; k < VKMS_NUM_PIPELINE_ITEMS; k++) {
+		for (int n = 0; n < topo->count[k]; n++) {
+			const struct vkms_item_state *it = &topo->items[k][n];
+
+			if (!*it->name || strchr(it->name, '/'))
+				return invalid("Invalid %s name '%s'",
+					       get_pipeline_item_label(k), it->name);
+
+			for (int m = 0; m < n; m++) {
+				if (strcmp(topo->items[k][m].name, it->name) == 0)
+					return invalid("Duplicated %s '%s'",
+						       get_pipeline_item_label(k),
+						       it->name);
+			}
+
+			if (!pipeline_item_has_links(k))
+				continue;
+
+			if (!it->n_links)
+				return invalid("%s '%s' has no %s",
+					       get_pipeline_item_label(k), it->name,
+					       get_attach_dir_name(k));
+
+			for (int i = 0; i < it->n_links; i++) {
+				if (!topology_find(topo, get_link_target(k), it->links[i]))
+					return invalid("%s '%s' links to unknown %s '%s'",
+						       get_pipeline_item_label(k), it->name,
+						       get_pipeline_item_label(get_link_target(k)),
+						       it->links[i]);
+
+				for (int j = 0; j < i; j++) {
+					if (strcmp(it->links[i], it->links[j]) == 0)
+						return invalid("%s '%s' links twice to '%s'",
+							       get_pipeline_item_label(k),
+							       it->name, it->links[i]);
+				}
+			}
+		}
+	}
+
+	for (int n = 0; n < topo->count[VKMS_PIPELINE_ITEM_PLANE]; n++) {
+		int type = topo->items[VKMS_PIPELINE_ITEM_PLANE][n].value;
+
+		if (type != DRM_PLANE_TYPE_OVERLAY &&
+		    type != DRM_PLANE_TYPE_PRIMARY &&
+		    type != DRM_PLANE_TYPE_CURSOR)
+			return invalid("Plane '%s' has unknown type %d",
+				       topo->items[VKMS_PIPELINE_ITEM_PLANE][n].name,
+				       type);
+	}
+
+	for (int n = 0; n < topo->count[VKMS_PIPELINE_ITEM_CONNECTOR]; n++) {
+		int status = topo->items[VKMS_PIPELINE_ITEM_CONNECTOR][n].value;
+
+		if (status != DRM_MODE_CONNECTED &&
+		    status != DRM_MODE_DISCONNECTED &&
+		    status != DRM_MODE_UNKNOWNCONNECTION)
+			return invalid("Connector '%s' has unknown status %d",
+				       topo->items[VKMS_PIPELINE_ITEM_CONNECTOR][n].name,
+				       status);
+	}
+
+	/* Every CRTC needs exactly one primary plane and at most one cursor */
+	for (int c = 0; c < topo->count[VKMS_PIPELINE_ITEM_CRTC]; c++) {
+		const char *crtc = topo->items[VKMS_PIPELINE_ITEM_CRTC][c].name;
+		int primary = 0, cursor = 0;
+
+		for (int n = 0; n < topo->count[VKMS_PIPELINE_ITEM_PLANE]; n++) {
+			const struct vkms_item_state *plane =
+				&topo->items[VKMS_PIPELINE_ITEM_PLANE][n];
+
+			if (!item_has_link(plane, crtc))
+				continue;
+
+			primary += plane->value == DRM_PLANE_TYPE_PRIMARY;
+			cursor += plane->value == DRM_PLANE_TYPE_CURSOR;
+		}
+
+		if (primary != 1)
+			return invalid("CRTC '%s' has %d primary planes", crtc, primary);
+		if (cursor > 1)
+			return invalid("CRTC '%s' has %d cursor planes", crtc, cursor);
+	}
+
+	return true;
+#undef invalid
+}
+
+static DIR *opendirat(int dir_fd, const char *name)
+{
+	DIR *dir;
+	int fd;
+
+	fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY);
+	if (fd < 0)
+		return NULL;
+
+	dir = fdopendir(fd);
+	if (!dir)
+		close(fd);
+
+	return dir;
+}
+
+static bool is_dir_entry(int dir_fd, const struct dirent *ent)
+{
+	struct stat st;
+
+	if (ent->d_type != DT_UNKNOWN)
+		return ent->d_type == DT_DIR;
+
+	return fstatat(dir_fd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 &&
+	       S_ISDIR(st.st_mode);
+}
+
+static int read_int_at(int dir_fd, const char *name, int default_value)
+{
+	char buf[32];
+	ssize_t len;
+	int fd;
+
+	fd = openat(dir_fd, name, O_RDONLY);
+	if (fd < 0)
+		return default_value;
+
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (len <= 0)
+		return default_value;
+
+	buf[len] = '\0';
+	return atoi(buf);
+}
+
+static void write_int_at(int dir_fd, const char *name, int value)
+{
+	char buf[32];
+	int len, fd;
+
+	len = snprintf(buf, sizeof(buf), "%d", value);
+
+	fd = openat(dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	igt_assert_f(fd >= 0, "Error opening '%s'. Got errno=%d (%s)\n",
+		     name, errno, strerror(errno));
+	igt_assert_f(write(fd, buf, len) == len,
+		     "Error writing to '%s'. Got errno=%d (%s)\n",
+		     name, errno, strerror(errno));
+	close(fd);
+}
+
+/*
+ * Removes a pipeline item directory. VKMS removes the attribute files and
+ * default groups itself, but when not backed by configfs (e.g. the fake tree
+ * used by unit tests) they have to be removed by hand.
+ */
+static int vkms_rmdirat(int dir_fd, const char *name)
+{
+	struct dirent *ent;
+	DIR *dir;
+	int fd;
+
+	if (unlinkat(dir_fd, name, AT_REMOVEDIR) == 0)
+		return 0;
+	if (errno != ENOTEMPTY && errno != EEXIST)
+		return -errno;
+
+	dir = opendirat(dir_fd, name);
+	if (!dir)
+		return -errno;
+
+	fd = dirfd(dir);
+	while ((ent = readdir(dir))) {
+		if (strcmp(ent->d_name, ".") == 0 ||
+		    strcmp(ent->d_name, "..") == 0)
+			continue;
+
+		if (is_dir_entry(fd, ent))
+			vkms_rmdirat(fd, ent->d_name);
+		else
+			unlinkat(fd, ent->d_name, 0);
+	}
+	closedir(dir);
+
+	return unlinkat(dir_fd, name, AT_REMOVEDIR) ? -errno : 0;
+}
+
+static struct vkms_topology *topology_read(int dev_fd)
+{
+	struct vkms_topology *topo;
+
+	topo = calloc(1, sizeof(*topo));
+	igt_assert(topo);
+
+	for (int k = 0; k < VKMS_NUM_PIPELINE_ITEMS; k++) {
+		const char *value_file = get_pipeline_item_value_file(k);
+		struct dirent *ent;
+		DIR *group;
+
+		group = opendirat(dev_fd, get_pipeline_item_dir_name(k));
+		if (!group)
+			continue;
+
+		while ((ent = readdir(group))) {
+			struct vkms_item_state *it;
+			struct dirent *link;
+			DIR *links;
+			int item_fd;
+
+			if (ent->d_name[0] == '.' ||
+			    !is_dir_entry(dirfd(group), ent))
+				continue;
+
+			item_fd = openat(dirfd(group), ent->d_name,
+					 O_RDONLY | O_DIRECTORY);
+			if (item_fd < 0)
+				continue;
+
+			it = topology_add(topo, k, ent->d_name,
+					  get_pipeline_item_default_value(k));
+			if (value_file)
+				it->value = read_int_at(item_fd, value_file,
+							it->value);
+
+			if (pipeline_item_has_links(k) &&
+			    (links = opendirat(item_fd, get_attach_dir_name(k)))) {
+				while ((link = readdir(links))) {
+					if (link->d_name[0] != '.')
+						topology_add_link(it, link->d_name);
+				}
+				closedir(links);
+			}
+
+			close(item_fd);
+		}
+
+		closedir(group);
+	}
+
+	return topo;
+}
+
+/*
+ * Brings the device from the @cur topology to the @want one, touching only
+ * what differs. With @dev_fd < 0 nothing is written and only the number of
+ * required operations is computed.
+ */
+static int topology_sync(igt_vkms_t *dev, int dev_fd,
+			 const struct vkms_topology *cur,
+			 const struct vkms_topology *want)
+{
+	int group_fd[VKMS_NUM_PIPELINE_ITEMS];
+	bool apply = dev_fd >= 0;
+	int ops = 0;
+
+	for (int k = 0; k < VKMS_NUM_PIPELINE_ITEMS; k++) {
+		const char *group = get_pipeline_item_dir_name(k);
+
+		group_fd[k] = -1;
+		if (!apply)
+			continue;
+
+		group_fd[k] = openat(dev_fd, group, O_RDONLY | O_DIRECTORY);
+		if (group_fd[k] < 0 && errno == ENOENT &&
+		    mkdirat(dev_fd, group, 0777) == 0)
+			group_fd[k] = openat(dev_fd, group, O_RDONLY | O_DIRECTORY);
+		igt_assert_f(group_fd[k] >= 0,
+			     "Unable to open '%s/%s'. Got errno=%d (%s)\n",
+			     dev->path, group, errno, strerror(errno));
+	}
+
+	/* Links first, items cannot be removed while linked */
+	for (int k = 0; k < VKMS_NUM_PIPELINE_ITEMS; k++) {
+		if (!pipeline_item_has_links(k))
+			continue;
+
+		for (int n = 0; n < cur->count[k]; n++) {
+			const struct vkms_item_state *it = &cur->items[k][n];
+			const struct vkms_item_state *w = topology_find(want, k, it->name);
+			char path[PATH_MAX];
+			int ret;
+
+			for (int i = 0; i < it->n_links; i++) {
+				if (w && item_has_link(w, it->links[i]))
+					continue;
+
+				ops++;
+				if (!apply)
+					continue;
+
+				ret = snprintf(path, sizeof(path), "%s/%s/%s",
+					       it->name, get_attach_dir_name(k),
+					       it->links[i]);
+				igt_assert(ret >= 0 && ret < sizeof(path));
+				igt_debug("Detaching pipeline item %s/%s\n",
+					  get_pipeline_item_dir_name(k), path);
+				igt_assert_f(unlinkat(group_fd[k], path, 0) == 0,
+					     "Unable to unlink '%s'. Got errno=%d (%s)\n",
+					     path, errno, strerror(errno));
+			}
+		}
+	}
+
+	for (int o = ARRAY_SIZE(vkms_creation_order) - 1; o >= 0; o--) {
+		enum vkms_pipeline_item k = vkms_creation_order[o];
+
+		for (int n = 0; n < cur->count[k]; n++) {
+			const char *name = cur->items[k][n].name;
+			int ret;
+
+			if (topology_find(want, k, name))
+				continue;
+
+			ops++;
+			if (!apply)
+				continue;
+
+			igt_debug("Removing pipeline item %s/%s\n",
+				  get_pipeline_item_dir_name(k), name);
+			ret = vkms_rmdirat(group_fd[k], name);
+			igt_assert_f(ret == 0,
+				     "Unable to rmdir '%s'. Got errno=%d (%s)\n",
+				     name, -ret, strerror(-ret));
+		}
+	}
+
+	for (int o = 0; o < ARRAY_SIZE(vkms_creation_order); o++) {
+		enum vkms_pipeline_item k = vkms_creation_order[o];
+		const char *value_file = get_pipeline_item_value_file(k);
+
+		for (int n = 0; n < want->count[k]; n++) {
+			const struct vkms_item_state *w = &want->items[k][n];
+			const struct vkms_item_state *it = topology_find(cur, k, w->name);
+			int value = it ? it->value : get_pipeline_item_default_value(k);
+			int item_fd = -1;
+
+			if (!it) {
+				ops++;
+				if (apply) {
+					igt_debug("Adding pipeline item %s/%s\n",
+						  get_pipeline_item_dir_name(k), w->name);
+					igt_assert_f(mkdirat(group_fd[k], w->name, 0777) == 0,
+						     "Unable to mkdir directory '%s'. Got errno=%d (%s)\n",
+						     w->name, errno, strerror(errno));
+				}
+			}
+
+			if (apply) {
+				item_fd = openat(group_fd[k], w->name,
+						 O_RDONLY | O_DIRECTORY);
+				igt_assert(item_fd >= 0);
+			}
+
+			if (value_file && value != w->value) {
+				ops++;
+				if (apply)
+					write_int_at(item_fd, value_file, w->value);
+			}
+
+			if (!it && apply && pipeline_item_has_links(k) &&
+			    mkdirat(item_fd, get_attach_dir_name(k), 0777))
+				igt_assert(errno == EEXIST);
+
+			for (int i = 0; pipeline_item_has_links(k) && i < w->n_links; i++) {
+				char target[PATH_MAX];
+				char link[PATH_MAX];
+				int ret;
+
+				if (it && item_has_link(it, w->links[i]))
+					continue;
+
+				ops++;
+				if (!apply)
+					continue;
+
+				get_pipeline_item_path(dev, get_link_target(k),
+						       w->links[i], target,
+						       sizeof(target));
+				ret = snprintf(link, sizeof(link), "%s/%s",
+					       get_attach_dir_name(k), w->links[i]);
+				igt_assert(ret >= 0 && ret < sizeof(link));
+
+				/* Invalid configurations are allowed on purpose */
+				if (symlinkat(target, item_fd, link))
+					igt_debug("Unable to link '%s' to '%s'. Got errno=%d (%s)\n",
+						  link, target, errno, strerror(errno));
+			}
+
+			if (item_fd >= 0)
+				close(item_fd);
+		}
+	}
+
+	for (int k = 0; k < VKMS_NUM_PIPELINE_ITEMS; k++) {
+		if (group_fd[k] >= 0)
+			close(group_fd[k]);
+	}
+
+	return ops;
+}
+
+/**
+ * igt_vkms_set_configfs_path:
+ * @path: Directory to use as VKMS configfs root, or NULL to use configfs
+ *
+ * Override the directory holding the VKMS devices. This is meant for unit
+ * tests, which can exercise the topology helpers against a plain directory
+ * tree instead of configfs.
+ */
+void igt_vkms_set_configfs_path(const char *path)
+{
+	free(vkms_root_override);
+	vkms_root_override = path ? strdup(path) : NULL;
+}
+
+/**
+ * igt_vkms_config_validate:
+ * @cfg: Configuration to validate
+ * @err: Output buffer for a description of the first problem found
+ * @len: Size of @err
+ *
+ * Check that @cfg describes a topology VKMS accepts: unique item names, links
+ * only to existing items, every plane, encoder and connector linked at least
+ * once and every CRTC with exactly one primary and at most one cursor plane.
+ *
+ * Returns: true if @cfg is valid.
+ */
+bool igt_vkms_config_validate(const igt_vkms_config_t *cfg, char *err, size_t len)
+{
+	struct vkms_topology *topo;
+	bool valid;
+
+	topo = topology_from_config(cfg);
+	valid = topology_validate(topo, err, len);
+	topology_free(topo);
+
+	return valid;
+}
+
+/**
+ * igt_vkms_device_apply_config:
+ * @dev: Device to update
+ * @cfg: Wanted configuration
+ *
+ * Reads back the current topology of @dev and applies, in a single pass,
+ * only the changes needed to match @cfg: stale links and items are removed,
+ * missing ones are created and attributes are written only when they differ.
+ * If @dev is enabled and anything has to change it is disabled first and
+ * left disabled. @cfg->device_name is ignored.
+ *
+ * Returns: the number of configfs operations performed.
+ */
+int igt_vkms_device_apply_config(igt_vkms_t *dev, const igt_vkms_config_t *cfg)
+{
+	struct vkms_topology *cur, *want;
+	int dev_fd, ops;
+
+	dev_fd = open(dev->path, O_RDONLY | O_DIRECTORY);
+	igt_assert_f(dev_fd >= 0, "Unable to open '%s'. Got errno=%d (%s)\n",
+		     dev->path, errno, strerror(errno));
+
+	want = topology_from_config(cfg);
+	cur = topology_read(dev_fd);
+
+	igt_debug("Applying configuration to %s:\n", dev->path);
+	topology_dump(want);
+
+	ops = topology_sync(dev, -1, cur, want);
+	if (ops) {
+		if (read_int_at(dev_fd, VKMS_FILE_ENABLED, 0))
+			igt_vkms_device_set_enabled(dev, false);
+
+		topology_sync(dev, dev_fd, cur, want);
+	}
+
+	topology_free(cur);
+	topology_free(want);
+	close(dev_fd);
+
+	return ops;
+}
+
+/* Unlike igt_vkms_device_is_enabled(), a missing file reads as disabled */
+static bool device_is_enabled(igt_vkms_t *dev)
+{
+	char path[PATH_MAX];
+
+	igt_vkms_get_device_enabled_path(dev, path, sizeof(path));
+
+	return read_int_at(AT_FDCWD, path, 0);
+}
+
+static void vkms_pool_release(struct vkms_pool_entry *entry)
+{
+	struct vkms_topology *empty;
+	const char *root = mount_vkms_configfs();
+	char *name = strrchr(entry->dev->path, '/') + 1;
+	int dev_fd, root_fd;
+
+	dev_fd = open(entry->dev->path, O_RDONLY | O_DIRECTORY);
+	if (dev_fd >= 0) {
+		struct vkms_topology *cur = topology_read(dev_fd);
+
+		empty = calloc(1, sizeof(*empty));
+		igt_assert(empty);
+
+		if (read_int_at(dev_fd, VKMS_FILE_ENABLED, 0))
+			igt_vkms_device_set_enabled(entry->dev, false);
+		topology_sync(entry->dev, dev_fd, cur, empty);
+		topology_free(cur);
+		topology_free(empty);
+		close(dev_fd);
+	}
+
+	root_fd = open(root, O_RDONLY | O_DIRECTORY);
+	if (root_fd >= 0) {
+		vkms_rmdirat(root_fd, name);
+		close(root_fd);
+	}
+
+	topology_free(entry->topology);
+	free(entry->dev->path);
+	free(entry->dev);
+	memset(entry, 0, sizeof(*entry));
+}
+
+/**
+ * igt_vkms_pool_destroy:
+ *
+ * Destroy every device created by igt_vkms_pool_get(). Called automatically
+ * at exit.
+ */
+void igt_vkms_pool_destroy(void)
+{
+	if (vkms_pool_stats.gets)
+		igt_debug("VKMS pool: %u requests, %u devices created, %u configfs operations\n",
+			  vkms_pool_stats.gets, vkms_pool_stats.created,
+			  vkms_pool_stats.ops);
+
+	for (int i = 0; i < VKMS_POOL_SIZE; i++) {
+		if (vkms_pool[i].dev)
+			vkms_pool_release(&vkms_pool[i]);
+	}
+
+	memset(&vkms_pool_stats, 0, sizeof(vkms_pool_stats));
+}
+
+static void vkms_pool_exit_handler(int sig)
+{
+	igt_vkms_pool_destroy();
+}
+
+static igt_vkms_t *vkms_pool_create_device(const char *name)
+{
+	char unique[NAME_MAX];
+	int suffix = 0;
+	int ret;
+
+	ret = snprintf(unique, sizeof(unique), "%s", name);
+	igt_assert(ret >= 0 && ret < sizeof(unique));
+
+	for (int i = 0; i < VKMS_POOL_SIZE; i++) {
+		if (!vkms_pool[i].dev ||
+		    strcmp(strrchr(vkms_pool[i].dev->path, '/') + 1, unique))
+			continue;
+
+		ret = snprintf(unique, sizeof(unique), "%s-%d", name, ++suffix);
+		igt_assert(ret >= 0 && ret < sizeof(unique));
+		i = -1;
+	}
+
+	return igt_vkms_device_create(unique);
+}
+
+/**
+ * igt_vkms_pool_get:
+ * @cfg: Wanted configuration, must be valid
+ *
+ * Get an enabled VKMS device matching @cfg. Devices returned to the pool
+ * with igt_vkms_pool_put() are recycled: the idle device whose topology is
+ * the closest to @cfg is picked and only the differences are applied, so
+ * getting the same topology again costs no configfs write at all.
+ *
+ * The returned device is only named after @cfg->device_name when it has
+ * just been created; use @dev->path to find it.
+ *
+ * Returns: a device to hand back with igt_vkms_pool_put().
+ */
+igt_vkms_t *igt_vkms_pool_get(const igt_vkms_config_t *cfg)
+{
+	struct vkms_pool_entry *best = NULL, *empty = NULL;
+	struct vkms_topology *want;
+	int best_ops = INT_MAX;
+	char err[256];
+
+	want = topology_from_config(cfg);
+	igt_assert_f(topology_validate(want, err, sizeof(err)),
+		     "Invalid VKMS configuration '%s': %s\n",
+		     cfg->device_name, err);
+
+	if (!vkms_pool_stats.gets++)
+		igt_install_exit_handler(vkms_pool_exit_handler);
+
+	for (int i = 0; i < VKMS_POOL_SIZE; i++) {
+		struct vkms_pool_entry *entry = &vkms_pool[i];
+		int ops;
+
+		if (!entry->dev) {
+			empty = empty ?: entry;
+			continue;
+		}
+
+		if (entry->in_use)
+			continue;
+
+		ops = topology_sync(entry->dev, -1, entry->topology, want);
+		if (ops < best_ops) {
+			best = entry;
+			best_ops = ops;
+		}
+	}
+
+	if (!best) {
+		igt_assert_f(empty, "VKMS pool exhausted\n");
+
+		empty->dev = vkms_pool_create_device(cfg->device_name);
+		igt_assert(empty->dev);
+		vkms_pool_stats.created++;
+		best = empty;
+	}
+
+	/* The device may have been modified since it was cached */
+	vkms_pool_stats.ops += igt_vkms_device_apply_config(best->dev, cfg);
+	if (!device_is_enabled(best->dev)) {
+		igt_vkms_device_set_enabled(best->dev, true);
+		vkms_pool_stats.ops++;
+	}
+
+	topology_free(best->topology);
+	best->topology = want;
+	best->in_use = true;
+
+	return best->dev;
+}
+
+/**
+ * igt_vkms_pool_put:
+ * @dev: Device obtained from igt_vkms_pool_get()
+ *
+ * Hand a device back to the pool. It is left enabled and configured so it
+ * can be reused by the next igt_vkms_pool_get().
+ */
+void igt_vkms_pool_put(igt_vkms_t *dev)
+{
+	for (int i = 0; i < VKMS_POOL_SIZE; i++) {
+		if (vkms_pool[i].dev == dev) {
+			igt_assert(vkms_pool[i].in_use);
+			vkms_pool[i].in_use = false;
+			return;
+		}
+	}
+
+	igt_assert(!"Device not from the VKMS pool");
+}
@@ -9,6 +9,7 @@
 #define __IGT_VKMS_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #define VKMS_MAX_PIPELINE_ITEMS	40
 
@@ -63,6 +64,7 @@ typedef struct igt_vkms_config {
 } igt_vkms_config_t;
 
 void igt_require_vkms_configfs(void);
+void igt_vkms_set_configfs_path(const char *path);
 
 void igt_vkms_get_device_enabled_path(igt_vkms_t *dev, char *path, size_t len);
 void igt_vkms_get_plane_path(igt_vkms_t *dev, const char *name, char *path,
@@ -89,9 +91,15 @@ void igt_vkms_get_connector_possible_encoders_path(igt_vkms_t *dev,
 
 igt_vkms_t *igt_vkms_device_create(const char *name);
 igt_vkms_t *igt_vkms_device_create_from_config(igt_vkms_config_t *cfg);
+int igt_vkms_device_apply_config(igt_vkms_t *dev, const igt_vkms_config_t *cfg);
+bool igt_vkms_config_validate(const igt_vkms_config_t *cfg, char *err, size_t len);
 void igt_vkms_device_destroy(igt_vkms_t *dev);
 void igt_vkms_destroy_all_devices(void);
 
+igt_vkms_t *igt_vkms_pool_get(const igt_vkms_config_t *cfg);
+void igt_vkms_pool_put(igt_vkms_t *dev);
+void igt_vkms_pool_destroy(void);
+
 bool igt_vkms_device_is_enabled(igt_vkms_t *dev);
 void igt_vkms_device_set_enabled(igt_vkms_t *dev, bool enabled);
 
@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_window_stats.h"
+
+/**
+ * SECTION:igt_window_stats
+ * @short_description: Aggregation of samples in time windows
+ * @title: Window statistics
+ * @include: igt_window_stats.h
+ *
+ * Reduces long series of samples, like the counter deltas of an OA
+ * recording, to the minimum, average and maximum of each value over
+ * fixed time windows, optionally split per key such as a context id.
+ *
+ * The samples are read through a callback, in contiguous chunks handled
+ * by several threads, and the per thread windows merged at the end. The
+ * result doesn't depend on the number of threads, up to the rounding of
+ * the sums.
+ */
+
+/* below this many samples per thread, threads cost more than they bring */
+#define MIN_SAMPLES_PER_THREAD 4096
+
+struct chunk {
+	igt_window_stats_t *stats;
+	igt_window_stats_sample_t sample;
+	void *data;
+	uint64_t start, end;
+
+	igt_window_stats_window_t *windows;
+	uint64_t n_windows, size;
+};
+
+/**
+ * igt_window_stats_init:
+ * @stats: statistics to initialize
+ * @window_ns: size of the time windows
+ * @n_values: number of values per sample
+ * @per_key: whether to split the windows per sample key
+ */
+void igt_window_stats_init(igt_window_stats_t *stats, uint64_t window_ns,
+			   unsigned int n_values, bool per_key)
+{
+	igt_assert(window_ns);
+
+	memset(stats, 0, sizeof(*stats));
+	stats->window_ns = window_ns;
+	stats->n_values = n_values;
+	stats->per_key = per_key;
+}
+
+static void free_windows(igt_window_stats_window_t *windows, uint64_t count)
+{
+	for (uint64_t i = 0; i < count; i++)
+		free(windows[i].min);
+	free(windows);
+}
+
+/**
+ * igt_window_stats_fini:
+ * @stats: statistics to release
+ */
+void igt_window_stats_fini(igt_window_stats_t *stats)
+{
+	free_windows(stats->windows, stats->n_windows);
+	stats->windows = NULL;
+	stats->n_windows = 0;
+}
+
+static igt_window_stats_window_t *
+get_window(struct chunk *chunk, uint64_t index, uint32_t key)
+{
+	unsigned int n_values = chunk->stats->n_values;
+	igt_window_stats_window_t *w;
+
+	/* samples mostly come in time order, only the last index is searched */
+	for (uint64_t i = chunk->n_windows; i-- > 0; ) {
+		w = &chunk->windows[i];
+		if (w->index != index)
+			break;
+		if (w->key == key)
+			return w;
+	}
+
+	if (chunk->n_windows == chunk->size) {
+		chunk->size = chunk->size ? chunk->size * 2 : 64;
+		chunk->windows = realloc(chunk->windows,
+					 chunk->size * sizeof(*chunk->windows));
+		igt_assert(chunk->windows);
+	}
+
+	w = &chunk->windows[chunk->n_windows++];
+	w->index = index;
+	w->key = key;
+	w->n_samples = 0;
+	w->min = malloc(3 * n_values * sizeof(double));
+	igt_assert(w->min || !n_values);
+	w->max = w->min + n_values;
+	w->sum = w->max + n_values;
+
+	return w;
+}
+
+static void *collect_chunk(void *arg)
+{
+	struct chunk *chunk = arg;
+	igt_window_stats_t *stats = chunk->stats;
+	double *values;
+
+	values = malloc((stats->n_values + 1) * sizeof(*values));
+	igt_assert(values);
+
+	for (uint64_t i = chunk->start; i < chunk->end; i++) {
+		igt_window_stats_window_t *w;
+		uint32_t key = 0;
+		uint64_t ts;
+
+		if (!chunk->sample(chunk->data, i, &ts, &key, values))
+			continue;
+
+		w = get_window(chunk, ts / stats->window_ns,
+			       stats->per_key ? key : 0);
+
+		for (unsigned int v = 0; v < stats->n_values; v++) {
+			if (!w->n_samples || values[v] < w->min[v])
+				w->min[v] = values[v];
+			if (!w->n_samples || values[v] > w->max[v])
+				w->max[v] = values[v];
+			w->sum[v] = (w->n_samples ? w->sum[v] : 0) + values[v];
+		}
+		w->n_samples++;
+	}
+
+	free(values);
+
+	return NULL;
+}
+
+static int cmp_window(const void *_a, const void *_b)
+{
+	const igt_window_stats_window_t *a = _a, *b = _b;
+
+	if (a->index != b->index)
+		return a->index < b->index ? -1 : 1;
+	if (a->key != b->key)
+		return a->key < b->key ? -1 : 1;
+
+	return 0;
+}
+
+static void merge_window(igt_window_stats_window_t *dst,
+			 igt_window_stats_window_t *src, unsigned int n_values)
+{
+	for (unsigned int v = 0; v < n_values; v++) {
+		if (src->min[v] < dst->min[v])
+			dst->min[v] = src->min[v];
+		if (src->max[v] > dst->max[v])
+			dst->max[v] = src->max[v];
+		dst->sum[v] += src->sum[v];
+	}
+	dst->n_samples += src->n_samples;
+	free(src->min);
+}
+
+/**
+ * igt_window_stats_collect:
+ * @stats: statistics to add the samples to
+ * @n_samples: number of samples
+ * @sample: reads a sample
+ * @data: passed to @sample
+ * @n_threads: maximum number of threads, 0 for one per CPU
+ *
+ * Reads the samples 0 to @n_samples - 1 with @sample and adds them to the
+ * windows of @stats, which are then sorted by time and key.
+ */
+void igt_window_stats_collect(igt_window_stats_t *stats, uint64_t n_samples,
+			      igt_window_stats_sample_t sample, void *data,
+			      unsigned int n_threads)
+{
+	struct chunk *chunks;
+	pthread_t *threads;
+	bool *started;
+	uint64_t total, n;
+
+	if (!n_threads) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+		n_threads = cpus > 0 ? cpus : 1;
+	}
+	if (n_threads > n_samples / MIN_SAMPLES_PER_THREAD)
+		n_threads = n_samples / MIN_SAMPLES_PER_THREAD;
+	if (!n_threads)
+		n_threads = 1;
+
+	chunks = calloc(n_threads, sizeof(*chunks));
+	threads = calloc(n_threads, sizeof(*threads));
+	started = calloc(n_threads, sizeof(*started));
+	igt_assert(chunks && threads && started);
+
+	for (unsigned int t = 0; t < n_threads; t++) {
+		chunks[t].stats = stats;
+		chunks[t].sample = sample;
+		chunks[t].data = data;
+		chunks[t].start = n_samples * t / n_threads;
+		chunks[t].end = n_samples * (t + 1) / n_threads;
+	}
+
+	/* the first chunk is handled by the calling thread */
+	for (unsigned int t = 1; t < n_threads; t++)
+		started[t] = !pthread_create(&threads[t], NULL,
+					     collect_chunk, &chunks[t]);
+	collect_chunk(&chunks[0]);
+	for (unsigned int t = 1; t < n_threads; t++) {
+		if (started[t])
+			pthread_join(threads[t], NULL);
+		else
+			collect_chunk(&chunks[t]);
+	}
+
+	total = stats->n_windows;
+	for (unsigned int t = 0; t < n_threads; t++)
+		total += chunks[t].n_windows;
+
+	stats->windows = realloc(stats->windows, total * sizeof(*stats->windows));
+	igt_assert(stats->windows || !total);
+	for (unsigned int t = 0; t < n_threads; t++) {
+		memcpy(stats->windows + stats->n_windows, chunks[t].windows,
+		       chunks[t].n_windows * sizeof(*chunks[t].windows));
+		stats->n_windows += chunks[t].n_windows;
+		free(chunks[t].windows);
+	}
+
+	/* windows spanning several chunks, or out of order samples */
+	qsort(stats->windows, stats->n_windows, sizeof(*stats->windows),
+	      cmp_window);
+	n = 0;
+	for (uint64_t i = 0; i < stats->n_windows; i++) {
+		if (n && !cmp_window(&stats->windows[n - 1], &stats->windows[i]))
+			merge_window(&stats->windows[n - 1], &stats->windows[i],
+				     stats->n_values);
+		else
+			stats->windows[n++] = stats->windows[i];
+	}
+	stats->n_windows = n;
+
+	free(started);
+	free(threads);
+	free(chunks);
+}
+
+/**
+ * igt_window_stats_write_csv:
+ * @stats: statistics to write
+ * @f: output file
+ * @key_name: header of the key column, only written when split per key
+ * @value_names: names of the values
+ *
+ * Writes one line per window, with its start and end times in ns, its key,
+ * its number of samples and the minimum, average and maximum of each value.
+ */
+void igt_window_stats_write_csv(const igt_window_stats_t *stats, FILE *f,
+				const char *key_name,
+				const char * const *value_names)
+{
+	fprintf(f, "start_ns,end_ns");
+	if (stats->per_key)
+		fprintf(f, ",%s", key_name);
+	fprintf(f, ",samples");
+	for (unsigned int v = 0; v < stats->n_values; v++)
+		fprintf(f, ",%s_min,%s_avg,%s_max",
+			value_names[v], value_names[v], value_names[v]);
+	fprintf(f, "\n");
+
+	for (uint64_t i = 0; i < stats->n_windows; i++) {
+		const igt_window_stats_window_t *w = &stats->windows[i];
+
+		fprintf(f, "%" PRIu64 ",%" PRIu64,
+			w->index * stats->window_ns,
+			(w->index + 1) * stats->window_ns);
+		if (stats->per_key)
+			fprintf(f, ",0x%x", w->key);
+		fprintf(f, ",%" PRIu64, w->n_samples);
+		for (unsigned int v = 0; v < stats->n_values; v++)
+			fprintf(f, ",%.15g,%.15g,%.15g", w->min[v],
+				w->sum[v] / w->n_samples, w->max[v]);
+		fprintf(f, "\n");
+	}
+}
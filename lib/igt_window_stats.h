@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef IGT_WINDOW_STATS_H
+#define IGT_WINDOW_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * igt_window_stats_sample_t: Reads a sample
+ * @data: caller data given to igt_window_stats_collect()
+ * @idx: index of the sample
+ * @ts_ns: returns the time of the sample, from the start of the recording
+ * @key: returns what the sample is attributed to, e.g. a context id
+ * @values: returns the values of the sample
+ *
+ * Called concurrently from several threads, for different samples.
+ *
+ * Returns: false to leave the sample out.
+ */
+typedef bool (*igt_window_stats_sample_t)(void *data, uint64_t idx,
+					  uint64_t *ts_ns, uint32_t *key,
+					  double *values);
+
+/**
+ * igt_window_stats_window_t: Statistics of the samples of a time window
+ * @index: window number, the window starts at @index times the window size
+ * @key: key of the samples, 0 when not split per key
+ * @n_samples: number of samples
+ * @min: per value minimum
+ * @max: per value maximum
+ * @sum: per value sum
+ */
+typedef struct {
+	uint64_t index;
+	uint32_t key;
+	uint64_t n_samples;
+	double *min, *max, *sum;
+} igt_window_stats_window_t;
+
+/**
+ * igt_window_stats_t: Samples aggregated in time windows
+ * @window_ns: size of the windows
+ * @n_values: number of values per sample
+ * @per_key: whether samples with different keys get their own windows
+ * @windows: windows with samples, sorted by index and key
+ * @n_windows: number of entries in @windows
+ */
+typedef struct {
+	uint64_t window_ns;
+	unsigned int n_values;
+	bool per_key;
+	igt_window_stats_window_t *windows;
+	uint64_t n_windows;
+} igt_window_stats_t;
+
+void igt_window_stats_init(igt_window_stats_t *stats, uint64_t window_ns,
+			   unsigned int n_values, bool per_key);
+void igt_window_stats_fini(igt_window_stats_t *stats);
+void igt_window_stats_collect(igt_window_stats_t *stats, uint64_t n_samples,
+			      igt_window_stats_sample_t sample, void *data,
+			      unsigned int n_threads);
+void igt_window_stats_write_csv(const igt_window_stats_t *stats, FILE *f,
+				const char *key_name,
+				const char * const *value_names);
+
+#endif /* IGT_WINDOW_STATS_H */
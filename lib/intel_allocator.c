@@ -441,6 +441,164 @@ static bool allocator_close(uint64_t ahnd)
 	return is_empty;
 }
 
+/*
+ * Operations log, in the format read by intel_allocator_replay. Requests
+ * are logged where they are served, so in multiprocess mode the allocator
+ * thread logs them on behalf of the children. Each line goes out in a
+ * single write to an O_APPEND descriptor, so igt processes can share
+ * the file.
+ */
+static int trace_fd = -1;
+
+static uint64_t trace_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void trace_request(const struct alloc_req *req,
+			  const struct alloc_resp *resp, uint64_t ts)
+{
+	pid_t tid = req->tid ?: gettid();
+	char line[256];
+	bool reserved;
+	int len;
+
+	switch (req->request_type) {
+	case REQ_OPEN:
+		len = snprintf(line, sizeof(line),
+			       "%" PRIu64 " %d open 0x%" PRIx64
+			       " fd=%d ctx=%u vm=%u start=0x%" PRIx64
+			       " end=0x%" PRIx64 " type=%u strategy=%u"
+			       " alignment=0x%" PRIx64 "\n",
+			       ts, tid, resp->open.allocator_handle,
+			       req->open.fd, req->open.ctx, req->open.vm,
+			       req->open.start, req->open.end,
+			       req->open.allocator_type,
+			       req->open.allocator_strategy,
+			       req->open.default_alignment);
+		break;
+
+	case REQ_CLOSE:
+		len = snprintf(line, sizeof(line),
+			       "%" PRIu64 " %d close 0x%" PRIx64 " empty=%d\n",
+			       ts, tid, req->allocator_handle,
+			       resp->close.is_empty);
+		break;
+
+	case REQ_ALLOC:
+		len = snprintf(line, sizeof(line),
+			       "%" PRIu64 " %d alloc 0x%" PRIx64
+			       " handle=%u size=0x%" PRIx64
+			       " alignment=0x%" PRIx64 " pat=%u strategy=%u"
+			       " offset=0x%" PRIx64 "\n",
+			       ts, tid, req->allocator_handle,
+			       req->alloc.handle, req->alloc.size,
+			       req->alloc.alignment, req->alloc.pat_index,
+			       req->alloc.strategy, resp->alloc.offset);
+		break;
+
+	case REQ_FREE:
+		len = snprintf(line, sizeof(line),
+			       "%" PRIu64 " %d free 0x%" PRIx64
+			       " handle=%u freed=%d\n",
+			       ts, tid, req->allocator_handle,
+			       req->free.handle, resp->free.freed);
+		break;
+
+	case REQ_RESERVE:
+	case REQ_RESERVE_IF_NOT_ALLOCATED:
+		if (req->request_type == REQ_RESERVE)
+			reserved = resp->reserve.reserved;
+		else
+			reserved = resp->reserve_if_not_allocated.reserved;
+
+		/* nothing changed if it was allocated */
+		if (req->request_type == REQ_RESERVE_IF_NOT_ALLOCATED &&
+		    !reserved)
+			return;
+
+		len = snprintf(line, sizeof(line),
+			       "%" PRIu64 " %d reserve 0x%" PRIx64
+			       " handle=%u start=0x%" PRIx64 " end=0x%" PRIx64
+			       " reserved=%d\n",
+			       ts, tid, req->allocator_handle,
+			       req->reserve.handle, req->reserve.start,
+			       req->reserve.end, reserved);
+		break;
+
+	case REQ_UNRESERVE:
+		len = snprintf(line, sizeof(line),
+			       "%" PRIu64 " %d unreserve 0x%" PRIx64
+			       " handle=%u start=0x%" PRIx64 " end=0x%" PRIx64
+			       " unreserved=%d\n",
+			       ts, tid, req->allocator_handle,
+			       req->unreserve.handle, req->unreserve.start,
+			       req->unreserve.end, resp->unreserve.unreserved);
+		break;
+
+	default:
+		return;
+	}
+
+	igt_assert(write(trace_fd, line, len) == len);
+}
+
+static void trace_header(const char *what)
+{
+	char line[64];
+	int len;
+
+	len = snprintf(line, sizeof(line), "# intel_allocator %s pid=%d\n",
+		       what, getpid());
+	igt_assert(write(trace_fd, line, len) == len);
+}
+
+/**
+ * intel_allocator_trace_start:
+ * @path: file to log into
+ *
+ * Logs the open, close, alloc, free, reserve and unreserve operations served
+ * by the allocator, with their timestamps and the thread issuing them, for
+ * replaying them CPU-only with intel_allocator_replay. The log is appended
+ * to @path, starting with a line identifying the process. Each later
+ * intel_allocator_init(), as done between subtests, is logged too.
+ *
+ * Tracing starts at init when IGT_ALLOCATOR_TRACE names a file.
+ *
+ * Returns: true if the log could be opened.
+ */
+bool intel_allocator_trace_start(const char *path)
+{
+	intel_allocator_trace_stop();
+
+	trace_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (trace_fd < 0) {
+		igt_warn("Cannot open allocator trace %s: %s\n", path,
+			 strerror(errno));
+		return false;
+	}
+
+	trace_header("trace");
+
+	return true;
+}
+
+/**
+ * intel_allocator_trace_stop:
+ *
+ * Stops logging the allocator operations.
+ */
+void intel_allocator_trace_stop(void)
+{
+	if (trace_fd >= 0)
+		close(trace_fd);
+	trace_fd = -1;
+}
+
 static int send_req_recv_resp(struct msg_channel *msgchan,
 			      struct alloc_req *request,
 			      struct alloc_resp *response)
@@ -480,7 +638,7 @@ static int handle_request(struct alloc_req *req, struct alloc_resp *resp)
 	if (is_same_process()) {
 		struct intel_allocator *ial;
 		struct allocator *al;
-		uint64_t start, end, size, ahnd;
+		uint64_t start, end, size, ahnd, ts = 0;
 		uint32_t ctx, vm;
 		bool allocated, reserved, unreserved;
 		/* Used when debug is on, so avoid compilation warnings */
@@ -506,6 +664,9 @@ static int handle_request(struct alloc_req *req, struct alloc_resp *resp)
 			pthread_mutex_lock(&ial->mutex);
 		}
 
+		if (trace_fd >= 0)
+			ts = trace_time();
+
 		switch (req->request_type) {
 		case REQ_STOP:
 			alloc_info("<stop>\n");
@@ -716,6 +877,9 @@ static int handle_request(struct alloc_req *req, struct alloc_resp *resp)
 			break;
 		}
 
+		if (trace_fd >= 0)
+			trace_request(req, resp, ts);
+
 		if (req->request_type > REQ_CLOSE)
 			pthread_mutex_unlock(&ial->mutex);
 
@@ -1687,6 +1851,12 @@ void intel_allocator_init(void)
 	igt_assert(handles && ctx_map && vm_map && ahnd_map);
 
 	channel = intel_allocator_get_msgchannel(CHANNEL_SYSVIPC_MSGQUEUE);
+
+	/* the allocators are gone, and the handles start over */
+	if (trace_fd >= 0)
+		trace_header("reset");
+	else if (getenv("IGT_ALLOCATOR_TRACE"))
+		intel_allocator_trace_start(getenv("IGT_ALLOCATOR_TRACE"));
 }
 
 igt_constructor {
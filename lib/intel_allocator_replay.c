@@ -0,0 +1,621 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_map.h"
+#include "intel_allocator.h"
+#include "intel_allocator_replay.h"
+
+/* Avoid compilation warning */
+struct intel_allocator *
+intel_allocator_reloc_create(int fd, uint64_t start, uint64_t end);
+struct intel_allocator *
+intel_allocator_simple_create(int fd, uint64_t start, uint64_t end,
+			      enum allocator_strategy strategy);
+
+/* Mutating operations between two fragmentation samples */
+#define FRAGMENTATION_INTERVAL 256
+
+static const char * const op_names[] = {
+	[INTEL_ALLOCATOR_TRACE_OPEN] = "open",
+	[INTEL_ALLOCATOR_TRACE_CLOSE] = "close",
+	[INTEL_ALLOCATOR_TRACE_ALLOC] = "alloc",
+	[INTEL_ALLOCATOR_TRACE_FREE] = "free",
+	[INTEL_ALLOCATOR_TRACE_RESERVE] = "reserve",
+	[INTEL_ALLOCATOR_TRACE_UNRESERVE] = "unreserve",
+};
+
+struct range {
+	uint32_t handle;
+	uint64_t start;
+	uint64_t end;
+};
+
+/* A backend instance, shared by the handles opened on the same fd/ctx/vm */
+struct replay_allocator {
+	int fd;
+	uint32_t ctx;
+	uint32_t vm;
+	int refcount;
+	struct intel_allocator *ial;
+	/* handle -> struct range */
+	struct igt_map *objects;
+	struct igt_vec reserved;
+};
+
+struct replay_state {
+	struct intel_allocator_replay *replay;
+	uint8_t allocator_type;
+	/* struct replay_allocator * */
+	struct igt_vec allocators;
+	/* ahnd -> struct replay_allocator */
+	struct igt_map *handles;
+	unsigned int mutations;
+	double fragmentation;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static bool parse_entry(const char *line, struct intel_allocator_trace_entry *e)
+{
+	unsigned int type, strategy, pat_index, result;
+	char op[16];
+	int n;
+
+	memset(e, 0, sizeof(*e));
+
+	if (!strncmp(line, "# intel_allocator trace", 23)) {
+		e->op = INTEL_ALLOCATOR_TRACE_PROCESS;
+		return true;
+	}
+
+	if (!strncmp(line, "# intel_allocator reset", 23)) {
+		e->op = INTEL_ALLOCATOR_TRACE_RESET;
+		return true;
+	}
+
+	if (sscanf(line, "%" SCNu64 " %d %15s %" SCNx64 " %n",
+		   &e->ts, &e->tid, op, &e->ahnd, &n) != 4)
+		return false;
+	line += n;
+
+	if (!strcmp(op, "open")) {
+		e->op = INTEL_ALLOCATOR_TRACE_OPEN;
+		if (sscanf(line, "fd=%d ctx=%u vm=%u start=%" SCNx64
+			   " end=%" SCNx64 " type=%u strategy=%u"
+			   " alignment=%" SCNx64,
+			   &e->open.fd, &e->open.ctx, &e->open.vm,
+			   &e->open.start, &e->open.end, &type, &strategy,
+			   &e->open.default_alignment) != 8)
+			return false;
+		e->open.allocator_type = type;
+		e->open.allocator_strategy = strategy;
+	} else if (!strcmp(op, "close")) {
+		e->op = INTEL_ALLOCATOR_TRACE_CLOSE;
+	} else if (!strcmp(op, "alloc")) {
+		e->op = INTEL_ALLOCATOR_TRACE_ALLOC;
+		if (sscanf(line, "handle=%u size=%" SCNx64
+			   " alignment=%" SCNx64 " pat=%u strategy=%u",
+			   &e->alloc.handle, &e->alloc.size,
+			   &e->alloc.alignment, &pat_index, &strategy) != 5)
+			return false;
+		e->alloc.pat_index = pat_index;
+		e->alloc.strategy = strategy;
+	} else if (!strcmp(op, "free")) {
+		e->op = INTEL_ALLOCATOR_TRACE_FREE;
+		if (sscanf(line, "handle=%u", &e->free.handle) != 1)
+			return false;
+	} else if (!strcmp(op, "reserve") || !strcmp(op, "unreserve")) {
+		e->op = op[0] == 'u' ? INTEL_ALLOCATOR_TRACE_UNRESERVE :
+				       INTEL_ALLOCATOR_TRACE_RESERVE;
+		if (sscanf(line, "handle=%u start=%" SCNx64 " end=%" SCNx64
+			   " %*[a-z]=%u",
+			   &e->reserve.handle, &e->reserve.start,
+			   &e->reserve.end, &result) != 4)
+			return false;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * intel_allocator_replay_load:
+ * @replay: replay to initialize
+ * @trace: log of the allocator operations
+ *
+ * Reads the operations logged in @trace, which may hold the logs of several
+ * processes one after the other.
+ *
+ * Returns: false if @trace holds anything but allocator operations.
+ */
+bool intel_allocator_replay_load(struct intel_allocator_replay *replay,
+				 FILE *trace)
+{
+	struct intel_allocator_trace_entry e;
+	struct igt_vec tids;
+	unsigned int lineno = 0;
+	size_t len = 0;
+	char *line = NULL;
+	bool ret = true;
+
+	memset(replay, 0, sizeof(*replay));
+	igt_vec_init(&replay->entries, sizeof(e));
+	for (int op = 0; op < INTEL_ALLOCATOR_TRACE_OPS; op++)
+		igt_vec_init(&replay->ops[op].latency, sizeof(uint64_t));
+
+	igt_vec_init(&tids, sizeof(pid_t));
+	igt_vec_enable_index(&tids);
+
+	while (getline(&line, &len, trace) > 0) {
+		lineno++;
+
+		if (line[0] == '\n' ||
+		    (line[0] == '#' && strncmp(line, "# intel_allocator", 17)))
+			continue;
+
+		if (!parse_entry(line, &e)) {
+			igt_warn("Invalid allocator trace line %u: %s",
+				 lineno, line);
+			ret = false;
+			break;
+		}
+
+		if (e.op == INTEL_ALLOCATOR_TRACE_PROCESS)
+			replay->processes++;
+		else if (e.op == INTEL_ALLOCATOR_TRACE_RESET)
+			replay->resets++;
+		else if (igt_vec_index(&tids, &e.tid) < 0)
+			igt_vec_push(&tids, &e.tid);
+
+		igt_vec_push(&replay->entries, &e);
+	}
+
+	replay->threads = igt_vec_length(&tids);
+	igt_vec_fini(&tids);
+	free(line);
+
+	return ret;
+}
+
+/**
+ * intel_allocator_replay_fini:
+ * @replay: replay to free
+ */
+void intel_allocator_replay_fini(struct intel_allocator_replay *replay)
+{
+	igt_vec_fini(&replay->entries);
+	for (int op = 0; op < INTEL_ALLOCATOR_TRACE_OPS; op++)
+		igt_vec_fini(&replay->ops[op].latency);
+}
+
+static int cmp_range(const void *a, const void *b)
+{
+	const struct range *ra = a, *rb = b;
+
+	return ra->start < rb->start ? -1 : ra->start > rb->start;
+}
+
+/* 1 - largest hole / free space, after the live objects and reservations */
+static double fragmentation(struct replay_allocator *ra)
+{
+	uint64_t start, end, cursor, hole, largest = 0, total = 0;
+	struct igt_map_entry *pos;
+	struct igt_vec ranges;
+	struct range *r;
+
+	ra->ial->get_address_range(ra->ial, &start, &end);
+
+	igt_vec_init(&ranges, sizeof(struct range));
+	igt_map_foreach(ra->objects, pos)
+		igt_vec_push(&ranges, pos->data);
+	igt_vec_append(&ranges, ra->reserved.elems,
+		       igt_vec_length(&ra->reserved));
+	qsort(ranges.elems, igt_vec_length(&ranges), sizeof(struct range),
+	      cmp_range);
+
+	cursor = start;
+	for (int i = 0; i <= igt_vec_length(&ranges); i++) {
+		uint64_t next = end;
+
+		if (i < igt_vec_length(&ranges)) {
+			r = igt_vec_elem(&ranges, i);
+			next = min_t(uint64_t, r->start, end);
+		}
+
+		if (next > cursor) {
+			hole = next - cursor;
+			total += hole;
+			largest = max(largest, hole);
+		}
+
+		if (i < igt_vec_length(&ranges))
+			cursor = max(cursor, r->end);
+	}
+	igt_vec_fini(&ranges);
+
+	return total ? 1.0 - (double)largest / total : 0.0;
+}
+
+static void sample(struct replay_state *st, struct replay_allocator *ra)
+{
+	struct intel_allocator_replay *replay = st->replay;
+	double f;
+
+	/* an empty address space says nothing */
+	if (!ra->objects->entries && !igt_vec_length(&ra->reserved))
+		return;
+
+	f = fragmentation(ra);
+	st->fragmentation += f;
+	replay->max_fragmentation = max(replay->max_fragmentation, f);
+	replay->samples++;
+}
+
+static void sample_all(struct replay_state *st)
+{
+	for (int i = 0; i < igt_vec_length(&st->allocators); i++)
+		sample(st, *(struct replay_allocator **)
+			   igt_vec_elem(&st->allocators, i));
+}
+
+static void record(struct replay_state *st, enum intel_allocator_trace_op op,
+		   uint64_t start, bool failed)
+{
+	struct intel_allocator_replay_op *stats = &st->replay->ops[op];
+	uint64_t latency = now_ns() - start;
+
+	stats->count++;
+	stats->failed += failed;
+	igt_vec_push(&stats->latency, &latency);
+
+	if (op != INTEL_ALLOCATOR_TRACE_OPEN &&
+	    op != INTEL_ALLOCATOR_TRACE_CLOSE &&
+	    !(++st->mutations % FRAGMENTATION_INTERVAL))
+		sample_all(st);
+}
+
+static void map_entry_free_func(struct igt_map_entry *entry)
+{
+	free(entry->data);
+}
+
+static void destroy_allocator(struct replay_state *st,
+			      struct replay_allocator *ra)
+{
+	for (int i = 0; i < igt_vec_length(&st->allocators); i++) {
+		if (*(struct replay_allocator **)
+		    igt_vec_elem(&st->allocators, i) == ra) {
+			igt_vec_swap_remove(&st->allocators, i);
+			break;
+		}
+	}
+
+	ra->ial->destroy(ra->ial);
+	igt_map_destroy(ra->objects, map_entry_free_func);
+	igt_vec_fini(&ra->reserved);
+	free(ra);
+}
+
+/* What is left open when a process exits, or reinitializes the allocators */
+static void reset(struct replay_state *st)
+{
+	sample_all(st);
+	while (igt_vec_length(&st->allocators))
+		destroy_allocator(st, *(struct replay_allocator **)
+				  igt_vec_elem(&st->allocators, 0));
+
+	igt_map_destroy(st->handles, NULL);
+	st->handles = igt_map_create(igt_map_hash_64, igt_map_equal_64);
+}
+
+static void replay_open(struct replay_state *st,
+			const struct intel_allocator_trace_entry *e)
+{
+	uint8_t type = st->allocator_type ?: e->open.allocator_type;
+	struct replay_allocator *ra = NULL;
+	uint64_t start;
+
+	for (int i = 0; i < igt_vec_length(&st->allocators); i++) {
+		struct replay_allocator *a =
+			*(struct replay_allocator **)igt_vec_elem(&st->allocators, i);
+
+		if (a->fd == e->open.fd && a->ctx == e->open.ctx &&
+		    a->vm == e->open.vm) {
+			ra = a;
+			break;
+		}
+	}
+
+	start = now_ns();
+	if (!ra) {
+		ra = calloc(1, sizeof(*ra));
+		igt_assert(ra);
+		ra->fd = e->open.fd;
+		ra->ctx = e->open.ctx;
+		ra->vm = e->open.vm;
+
+		if (type == INTEL_ALLOCATOR_RELOC)
+			ra->ial = intel_allocator_reloc_create(-1, e->open.start,
+							       e->open.end);
+		else
+			ra->ial = intel_allocator_simple_create(-1, e->open.start,
+								e->open.end,
+								e->open.allocator_strategy);
+		ra->ial->type = type;
+		ra->ial->strategy = e->open.allocator_strategy;
+		ra->ial->default_alignment = e->open.default_alignment;
+
+		ra->objects = igt_map_create(igt_map_hash_32, igt_map_equal_32);
+		igt_vec_init(&ra->reserved, sizeof(struct range));
+		igt_vec_push(&st->allocators, &ra);
+	}
+	ra->refcount++;
+	igt_map_insert(st->handles, &e->ahnd, ra);
+	record(st, INTEL_ALLOCATOR_TRACE_OPEN, start, false);
+}
+
+static void replay_entry(struct replay_state *st,
+			 const struct intel_allocator_trace_entry *e)
+{
+	struct replay_allocator *ra;
+	struct intel_allocator *ial;
+	struct range *r;
+	uint64_t start, offset;
+	bool ok;
+
+	if (e->op == INTEL_ALLOCATOR_TRACE_OPEN) {
+		replay_open(st, e);
+		return;
+	}
+
+	/* opened before the trace started */
+	ra = igt_map_search(st->handles, &e->ahnd);
+	if (!ra) {
+		st->replay->ops[e->op].failed++;
+		return;
+	}
+	ial = ra->ial;
+
+	switch (e->op) {
+	case INTEL_ALLOCATOR_TRACE_CLOSE:
+		/* what is left behind by the last user */
+		if (ra->refcount == 1)
+			sample(st, ra);
+
+		start = now_ns();
+		igt_map_remove(st->handles, &e->ahnd, NULL);
+		if (!--ra->refcount)
+			destroy_allocator(st, ra);
+		record(st, e->op, start, false);
+		break;
+
+	case INTEL_ALLOCATOR_TRACE_ALLOC:
+		start = now_ns();
+		offset = ial->alloc(ial, e->alloc.handle, e->alloc.size,
+				    e->alloc.alignment, e->alloc.pat_index,
+				    e->alloc.strategy);
+		record(st, e->op, start, offset == ALLOC_INVALID_ADDRESS);
+
+		if (offset != ALLOC_INVALID_ADDRESS &&
+		    !igt_map_search(ra->objects, &e->alloc.handle)) {
+			r = malloc(sizeof(*r));
+			igt_assert(r);
+			r->handle = e->alloc.handle;
+			r->start = offset;
+			r->end = offset + e->alloc.size;
+			igt_map_insert(ra->objects, &r->handle, r);
+		}
+		break;
+
+	case INTEL_ALLOCATOR_TRACE_FREE:
+		start = now_ns();
+		ok = ial->free(ial, e->free.handle);
+		record(st, e->op, start, !ok);
+		if (ok)
+			igt_map_remove(ra->objects, &e->free.handle,
+				       map_entry_free_func);
+		break;
+
+	case INTEL_ALLOCATOR_TRACE_RESERVE:
+		start = now_ns();
+		ok = ial->reserve(ial, e->reserve.handle, e->reserve.start,
+				  e->reserve.end);
+		record(st, e->op, start, !ok);
+
+		if (ok) {
+			struct range res = {
+				.handle = e->reserve.handle,
+				.start = e->reserve.start,
+				.end = e->reserve.end,
+			};
+
+			igt_vec_push(&ra->reserved, &res);
+		}
+		break;
+
+	case INTEL_ALLOCATOR_TRACE_UNRESERVE:
+		start = now_ns();
+		ok = ial->unreserve(ial, e->unreserve.handle,
+				    e->unreserve.start, e->unreserve.end);
+		record(st, e->op, start, !ok);
+
+		for (int i = 0; ok && i < igt_vec_length(&ra->reserved); i++) {
+			r = igt_vec_elem(&ra->reserved, i);
+			if (r->start == e->unreserve.start &&
+			    r->end == e->unreserve.end) {
+				igt_vec_swap_remove(&ra->reserved, i);
+				break;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+ * intel_allocator_replay_run:
+ * @replay: loaded replay
+ * @allocator_type: INTEL_ALLOCATOR_SIMPLE or INTEL_ALLOCATOR_RELOC to
+ * replay against, or 0 for the type logged at open
+ * @paced: wait for the logged time of each operation, relative to the start
+ * of its process, instead of running them back to back
+ *
+ * Runs the operations of @replay against the allocator backends, replacing
+ * the results of any previous run.
+ */
+void intel_allocator_replay_run(struct intel_allocator_replay *replay,
+				uint8_t allocator_type, bool paced)
+{
+	struct replay_state st = {
+		.replay = replay,
+		.allocator_type = allocator_type,
+	};
+	uint64_t trace_start = 0, real_start = 0, t0 = now_ns();
+
+	for (int op = 0; op < INTEL_ALLOCATOR_TRACE_OPS; op++) {
+		igt_vec_fini(&replay->ops[op].latency);
+		memset(&replay->ops[op], 0, sizeof(replay->ops[op]));
+		igt_vec_init(&replay->ops[op].latency, sizeof(uint64_t));
+	}
+	replay->fragmentation = replay->max_fragmentation = 0;
+	replay->samples = 0;
+
+	igt_vec_init(&st.allocators, sizeof(struct replay_allocator *));
+	st.handles = igt_map_create(igt_map_hash_64, igt_map_equal_64);
+
+	for (int i = 0; i < igt_vec_length(&replay->entries); i++) {
+		const struct intel_allocator_trace_entry *e =
+			igt_vec_elem(&replay->entries, i);
+
+		if (e->op == INTEL_ALLOCATOR_TRACE_PROCESS) {
+			reset(&st);
+			trace_start = 0;
+			continue;
+		}
+
+		/* the handles are reused from 1, keep the pacing */
+		if (e->op == INTEL_ALLOCATOR_TRACE_RESET) {
+			reset(&st);
+			continue;
+		}
+
+		if (paced && !trace_start) {
+			trace_start = e->ts;
+			real_start = now_ns();
+		} else if (paced && e->ts > trace_start) {
+			uint64_t target = real_start + e->ts - trace_start;
+			struct timespec ts = {
+				.tv_sec = target / NSEC_PER_SEC,
+				.tv_nsec = target % NSEC_PER_SEC,
+			};
+
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+					       &ts, NULL) == EINTR)
+				;
+		}
+
+		replay_entry(&st, e);
+	}
+
+	reset(&st);
+	igt_map_destroy(st.handles, NULL);
+	igt_vec_fini(&st.allocators);
+
+	replay->duration_ns = now_ns() - t0;
+	if (replay->samples)
+		replay->fragmentation = st.fragmentation / replay->samples;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t ua = *(const uint64_t *)a, ub = *(const uint64_t *)b;
+
+	return ua < ub ? -1 : ua > ub;
+}
+
+/**
+ * intel_allocator_replay_percentile:
+ * @replay: replay after a run
+ * @op: operation
+ * @percent: 0 to 100
+ *
+ * Returns: the latency in ns of @op at @percent, nearest rank, or 0 if the
+ * operation never ran.
+ */
+uint64_t intel_allocator_replay_percentile(struct intel_allocator_replay *replay,
+					   enum intel_allocator_trace_op op,
+					   unsigned int percent)
+{
+	struct igt_vec *latency = &replay->ops[op].latency;
+	int n = igt_vec_length(latency), rank;
+
+	if (!n)
+		return 0;
+
+	igt_assert_lte(percent, 100);
+	qsort(latency->elems, n, sizeof(uint64_t), cmp_u64);
+
+	rank = ((uint64_t)percent * n + 99) / 100;
+
+	return *(uint64_t *)igt_vec_elem(latency, rank ? rank - 1 : 0);
+}
+
+/**
+ * intel_allocator_replay_report:
+ * @replay: replay after a run
+ * @out: stream to print to
+ *
+ * Prints the latency percentiles of each operation and the fragmentation.
+ */
+void intel_allocator_replay_report(struct intel_allocator_replay *replay,
+				   FILE *out)
+{
+	fprintf(out, "%d operations from %u processes, %u threads, "
+		"replayed in %.3fms\n",
+		igt_vec_length(&replay->entries) - replay->processes -
+		replay->resets,
+		replay->processes, replay->threads,
+		replay->duration_ns / 1e6);
+
+	fprintf(out, "%-10s %10s %8s %10s %10s %10s %10s\n",
+		"op", "count", "failed", "p50 (ns)", "p90 (ns)", "p99 (ns)",
+		"max (ns)");
+	for (int op = 0; op < INTEL_ALLOCATOR_TRACE_OPS; op++) {
+		if (!replay->ops[op].count)
+			continue;
+
+		fprintf(out, "%-10s %10" PRIu64 " %8" PRIu64
+			" %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+			" %10" PRIu64 "\n",
+			op_names[op], replay->ops[op].count,
+			replay->ops[op].failed,
+			intel_allocator_replay_percentile(replay, op, 50),
+			intel_allocator_replay_percentile(replay, op, 90),
+			intel_allocator_replay_percentile(replay, op, 99),
+			intel_allocator_replay_percentile(replay, op, 100));
+	}
+
+	fprintf(out, "fragmentation: %.1f%% mean, %.1f%% max over %u samples\n",
+		replay->fragmentation * 100, replay->max_fragmentation * 100,
+		replay->samples);
+}
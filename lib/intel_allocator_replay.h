@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef __INTEL_ALLOCATOR_REPLAY_H__
+#define __INTEL_ALLOCATOR_REPLAY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "igt_vec.h"
+
+/**
+ * SECTION:intel_allocator_replay
+ * @short_description: CPU-only replay of allocator operation logs
+ * @title: Intel allocator replay
+ * @include: intel_allocator_replay.h
+ *
+ * intel_allocator_trace_start(), or IGT_ALLOCATOR_TRACE, logs the operations
+ * served by the allocator, one per line:
+ *
+ * |[
+ * # intel_allocator trace pid=<pid>
+ * <ns> <tid> open <ahnd> fd=<fd> ctx=<ctx> vm=<vm> start=<start> end=<end> type=<type> strategy=<strategy> alignment=<alignment>
+ * <ns> <tid> alloc <ahnd> handle=<handle> size=<size> alignment=<alignment> pat=<pat_index> strategy=<strategy> offset=<offset>
+ * <ns> <tid> free <ahnd> handle=<handle> freed=<freed>
+ * <ns> <tid> reserve <ahnd> handle=<handle> start=<start> end=<end> reserved=<reserved>
+ * <ns> <tid> unreserve <ahnd> handle=<handle> start=<start> end=<end> unreserved=<unreserved>
+ * <ns> <tid> close <ahnd> empty=<empty>
+ * # intel_allocator reset pid=<pid>
+ * ]|
+ *
+ * The replay runs the logged operations again straight against the
+ * allocator backends, without any device, either at full speed or with the
+ * original pacing. It measures the latency of each backend operation and
+ * samples the fragmentation of the address spaces along the way. Each
+ * process in the log starts from a fresh allocator state, and so does each
+ * reset logged by intel_allocator_init() between subtests.
+ */
+
+enum intel_allocator_trace_op {
+	INTEL_ALLOCATOR_TRACE_OPEN,
+	INTEL_ALLOCATOR_TRACE_CLOSE,
+	INTEL_ALLOCATOR_TRACE_ALLOC,
+	INTEL_ALLOCATOR_TRACE_FREE,
+	INTEL_ALLOCATOR_TRACE_RESERVE,
+	INTEL_ALLOCATOR_TRACE_UNRESERVE,
+	INTEL_ALLOCATOR_TRACE_OPS,
+	/* start of the operations of another process */
+	INTEL_ALLOCATOR_TRACE_PROCESS = INTEL_ALLOCATOR_TRACE_OPS,
+	/* the allocators of the process were reinitialized */
+	INTEL_ALLOCATOR_TRACE_RESET,
+};
+
+struct intel_allocator_trace_entry {
+	uint64_t ts;
+	pid_t tid;
+	enum intel_allocator_trace_op op;
+	uint64_t ahnd;
+
+	union {
+		struct {
+			int fd;
+			uint32_t ctx;
+			uint32_t vm;
+			uint64_t start;
+			uint64_t end;
+			uint8_t allocator_type;
+			uint8_t allocator_strategy;
+			uint64_t default_alignment;
+		} open;
+
+		struct {
+			uint32_t handle;
+			uint64_t size;
+			uint64_t alignment;
+			uint8_t pat_index;
+			uint8_t strategy;
+		} alloc;
+
+		struct {
+			uint32_t handle;
+		} free;
+
+		struct {
+			uint32_t handle;
+			uint64_t start;
+			uint64_t end;
+		} reserve, unreserve;
+	};
+};
+
+struct intel_allocator_replay_op {
+	uint64_t count;
+	/*
+	 * allocations out of space, failed reserves, frees of nothing,
+	 * operations on handles not opened in the trace
+	 */
+	uint64_t failed;
+	/* ns spent in the backend by each operation */
+	struct igt_vec latency;
+};
+
+struct intel_allocator_replay {
+	struct igt_vec entries;
+	unsigned int processes;
+	unsigned int resets;
+	unsigned int threads;
+
+	/* Results of the last run */
+	struct intel_allocator_replay_op ops[INTEL_ALLOCATOR_TRACE_OPS];
+	uint64_t duration_ns;
+	/* 1 - largest hole / free space, over the samples */
+	double fragmentation;
+	double max_fragmentation;
+	unsigned int samples;
+};
+
+bool intel_allocator_replay_load(struct intel_allocator_replay *replay,
+				 FILE *trace);
+void intel_allocator_replay_fini(struct intel_allocator_replay *replay);
+
+void intel_allocator_replay_run(struct intel_allocator_replay *replay,
+				uint8_t allocator_type, bool paced);
+uint64_t intel_allocator_replay_percentile(struct intel_allocator_replay *replay,
+					   enum intel_allocator_trace_op op,
+					   unsigned int percent);
+void intel_allocator_replay_report(struct intel_allocator_replay *replay,
+				   FILE *out);
+
+#endif /* __INTEL_ALLOCATOR_REPLAY_H__ */
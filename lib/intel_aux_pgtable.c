@@ -44,11 +44,106 @@ struct pgtable {
 	struct pgtable_level_info *level_info;
 	int size;
 	int max_align;
+	/* relocations are only emitted when building for a batch */
 	struct intel_bb *ibb;
-	struct intel_buf *buf;
+	uint32_t handle;
+	uint64_t address;
 	void *ptr;
 };
 
+/* Main and AUX CCS ranges of one surface, addresses are absolute. */
+struct aux_surface {
+	uint64_t addr;
+	uint64_t end;
+	uint64_t aux_addr;
+	uint64_t l1_flags;
+};
+
+static const struct pgtable_level_desc level_desc_table_tgl[] = {
+	{
+		.idx_shift = 16,
+		.idx_bits = 8,
+		.entry_ptr_shift = 8,
+		.table_size = 8 * 1024,
+	},
+	{
+		.idx_shift = 24,
+		.idx_bits = 12,
+		.entry_ptr_shift = 13,
+		.table_size = 32 * 1024,
+	},
+	{
+		.idx_shift = 36,
+		.idx_bits = 12,
+		.entry_ptr_shift = 15,
+		.table_size = 32 * 1024,
+	}
+};
+
+static const struct pgtable_level_desc level_desc_table_mtl[] = {
+	{
+		.idx_shift = 20,
+		.idx_bits = 4,
+		.entry_ptr_shift = 12,
+		.table_size = 8 * 1024,
+	},
+	{
+		.idx_shift = 24,
+		.idx_bits = 12,
+		.entry_ptr_shift = 11,
+		.table_size = 32 * 1024,
+	},
+	{
+		.idx_shift = 36,
+		.idx_bits = 12,
+		.entry_ptr_shift = 15,
+		.table_size = 32 * 1024,
+	},
+};
+
+static const struct pgtable_level_desc *
+pgt_level_desc(uint32_t devid, int *levels)
+{
+	if (IS_METEORLAKE(devid)) {
+		*levels = ARRAY_SIZE(level_desc_table_mtl);
+		return level_desc_table_mtl;
+	}
+
+	*levels = ARRAY_SIZE(level_desc_table_tgl);
+	return level_desc_table_tgl;
+}
+
+static int level_entry_index(const struct pgtable_level_desc *ld,
+			     uint64_t address)
+{
+	uint64_t mask = BITMASK(ld->idx_shift + ld->idx_bits - 1,
+				ld->idx_shift);
+
+	return (address & mask) >> ld->idx_shift;
+}
+
+static uint64_t level_ptr_mask(const struct pgtable_level_desc *ld)
+{
+	return BITMASK(GFX_ADDRESS_BITS - 1, ld->entry_ptr_shift);
+}
+
+/*
+ * The block size on the main surface mapped by one AUX CCS block:
+ *       CCS block size *
+ *   8   bits per byte /
+ *   2   bits per main surface CL *
+ *   64  bytes per main surface CL
+ */
+static uint64_t aux_ccs_block_size(const struct pgtable_level_desc *ld)
+{
+	return 1ULL << ld[0].entry_ptr_shift;
+}
+
+static uint64_t main_surface_block_size(const struct pgtable_level_desc *ld)
+{
+	return aux_ccs_block_size(ld) * 8 / 2 * 64;
+}
+
 static uint64_t last_buf_surface_end(struct intel_buf *buf)
 {
 	uint64_t end_offset = 0;
@@ -136,18 +231,12 @@ static uint64_t pgt_alloc_table(struct pgtable *pgt, int level)
 
 static int pgt_entry_index(struct pgtable *pgt, int level, uint64_t address)
 {
-	const struct pgtable_level_desc *ld = pgt->level_info[level].desc;
-	uint64_t mask = BITMASK(ld->idx_shift + ld->idx_bits - 1,
-				ld->idx_shift);
-
-	return (address & mask) >> ld->idx_shift;
+	return level_entry_index(pgt->level_info[level].desc, address);
 }
 
 static uint64_t ptr_mask(struct pgtable *pgt, int level)
 {
-	const struct pgtable_level_desc *ld = pgt->level_info[level].desc;
-
-	return BITMASK(GFX_ADDRESS_BITS - 1, ld->entry_ptr_shift);
+	return level_ptr_mask(pgt->level_info[level].desc);
 }
 
 static uint64_t
@@ -168,24 +257,25 @@ pgt_get_child_table(struct pgtable *pgt, uint64_t parent_table,
 		uint32_t offset;
 
 		child_table = pgt_alloc_table(pgt, level - 1);
-		igt_assert(!((child_table + pgt->buf->addr.offset) &
+		igt_assert(!((child_table + pgt->address) &
 			     ~ptr_mask(pgt, level)));
 
 		pte = child_table | flags;
-		*child_entry_ptr = pgt->buf->addr.offset + pte;
+		*child_entry_ptr = pgt->address + pte;
 
 		igt_assert(pte <= INT32_MAX);
 
 		offset = parent_table + child_entry_idx * sizeof(uint64_t);
-		intel_bb_offset_reloc_to_object(pgt->ibb,
-						pgt->buf->handle,
-						pgt->buf->handle,
-						0, 0,
-						pte, offset,
-						pgt->buf->addr.offset);
+		if (pgt->ibb)
+			intel_bb_offset_reloc_to_object(pgt->ibb,
+							pgt->handle,
+							pgt->handle,
+							0, 0,
+							pte, offset,
+							pgt->address);
 	} else {
 		child_table = (*child_entry_ptr & ptr_mask(pgt, level)) -
-			      pgt->buf->addr.offset;
+			      pgt->address;
 	}
 
 	return child_table;
@@ -341,35 +431,36 @@ static uint64_t pgt_get_lx_flags(void)
 	return entry.l;
 }
 
+static void aux_surface_get(const struct intel_buf *buf, int surface_idx,
+			    struct aux_surface *s)
+{
+	igt_assert(!(buf->surface[surface_idx].stride % 512));
+	igt_assert_eq(buf->ccs[surface_idx].stride,
+		      buf->surface[surface_idx].stride / 512 * 64);
+
+	s->addr = buf->addr.offset + buf->surface[surface_idx].offset;
+	s->end = s->addr + buf->surface[surface_idx].size;
+	s->aux_addr = buf->addr.offset + buf->ccs[surface_idx].offset;
+	s->l1_flags = pgt_get_l1_flags(buf, surface_idx);
+}
+
 static void
 pgt_populate_entries_for_buf(struct pgtable *pgt,
 			     struct intel_buf *buf,
 			     uint64_t top_table,
 			     int surface_idx)
 {
-	uint64_t surface_addr = buf->addr.offset + buf->surface[surface_idx].offset;
-	uint64_t surface_end = surface_addr +  buf->surface[surface_idx].size;
-	uint64_t aux_addr = buf->addr.offset + buf->ccs[surface_idx].offset;
-	uint64_t l1_flags = pgt_get_l1_flags(buf, surface_idx);
+	const struct pgtable_level_desc *ld = pgt->level_info[0].desc;
 	uint64_t lx_flags = pgt_get_lx_flags();
-	uint64_t aux_ccs_block_size = 1 << pgt->level_info->desc[0].entry_ptr_shift;
-
-	/*
-	 * The block size on the main surface mapped by one AUX CCS block:
-	 *       CCS block size *
-	 *   8   bits per byte /
-	 *   2   bits per main surface CL *
-	 *   64  bytes per main surface CL
-	 */
-	uint64_t main_surface_block_size = aux_ccs_block_size * 8 / 2 * 64;
+	uint64_t surface_addr, aux_addr;
+	struct aux_surface s;
 
-	igt_assert(!(buf->surface[surface_idx].stride % 512));
-	igt_assert_eq(buf->ccs[surface_idx].stride,
-		      buf->surface[surface_idx].stride / 512 * 64);
+	aux_surface_get(buf, surface_idx, &s);
 
-	for (; surface_addr < surface_end;
-	     surface_addr += main_surface_block_size,
-	     aux_addr += aux_ccs_block_size) {
+	for (surface_addr = s.addr, aux_addr = s.aux_addr;
+	     surface_addr < s.end;
+	     surface_addr += main_surface_block_size(ld),
+	     aux_addr += aux_ccs_block_size(ld)) {
 		uint64_t table = top_table;
 		int level;
 
@@ -377,22 +468,17 @@ pgt_populate_entries_for_buf(struct pgtable *pgt,
 			table = pgt_get_child_table(pgt, table, level,
 						    surface_addr, lx_flags);
 
-		pgt_set_l1_entry(pgt, table, surface_addr, aux_addr, l1_flags);
+		pgt_set_l1_entry(pgt, table, surface_addr, aux_addr, s.l1_flags);
 	}
 }
 
-static void pgt_map(int drm_fd, struct pgtable *pgt)
+static void *pgt_map(int drm_fd, uint32_t handle, uint32_t size)
 {
-	pgt->ptr = is_i915_device(drm_fd) ?
-			gem_mmap__device_coherent(drm_fd, pgt->buf->handle, 0,
-						  pgt->size, PROT_READ | PROT_WRITE):
-			xe_bo_mmap_ext(drm_fd, pgt->buf->handle,
-				       pgt->size, PROT_READ | PROT_WRITE);
-}
-
-static void pgt_unmap(struct pgtable *pgt)
-{
-	munmap(pgt->ptr, pgt->size);
+	return is_i915_device(drm_fd) ?
+		gem_mmap__device_coherent(drm_fd, handle, 0,
+					  size, PROT_READ | PROT_WRITE):
+		xe_bo_mmap_ext(drm_fd, handle,
+			       size, PROT_READ | PROT_WRITE);
 }
 
 static void pgt_populate_entries(struct pgtable *pgt,
@@ -449,53 +535,48 @@ static void pgt_destroy(struct pgtable *pgt)
 	free(pgt);
 }
 
+/**
+ * intel_aux_pgtable_build:
+ * @devid: PCI device ID
+ * @bufs: compressed buffers to map, sorted by address
+ * @buf_count: number of buffers in @bufs
+ * @ptr: CPU pointer to the table memory, or NULL to only compute its size
+ * @address: GPU address of the table memory
+ *
+ * Builds the AUX page table for @bufs from scratch into @ptr, which must be
+ * zeroed and at least as large as the returned size.
+ *
+ * Returns: the size of the table in bytes.
+ */
+uint32_t intel_aux_pgtable_build(uint32_t devid, struct intel_buf **bufs,
+				 int buf_count, void *ptr, uint64_t address)
+{
+	const struct pgtable_level_desc *level_desc;
+	struct pgtable *pgt;
+	uint32_t size;
+	int levels;
+
+	level_desc = pgt_level_desc(devid, &levels);
+	pgt = pgt_create(level_desc, levels, bufs, buf_count);
+	size = pgt->size;
+
+	if (ptr) {
+		pgt->ptr = ptr;
+		pgt->address = address;
+		pgt_populate_entries(pgt, bufs, buf_count);
+	}
+
+	pgt_destroy(pgt);
+
+	return size;
+}
+
 struct intel_buf *
 intel_aux_pgtable_create(struct intel_bb *ibb,
 			 struct intel_buf **bufs, int buf_count)
 {
-	static const struct pgtable_level_desc level_desc_table_tgl[] = {
-		{
-			.idx_shift = 16,
-			.idx_bits = 8,
-			.entry_ptr_shift = 8,
-			.table_size = 8 * 1024,
-		},
-		{
-			.idx_shift = 24,
-			.idx_bits = 12,
-			.entry_ptr_shift = 13,
-			.table_size = 32 * 1024,
-		},
-		{
-			.idx_shift = 36,
-			.idx_bits = 12,
-			.entry_ptr_shift = 15,
-			.table_size = 32 * 1024,
-		}
-	};
-	static const struct pgtable_level_desc level_desc_table_mtl[] = {
-		{
-			.idx_shift = 20,
-			.idx_bits = 4,
-			.entry_ptr_shift = 12,
-			.table_size = 8 * 1024,
-		},
-		{
-			.idx_shift = 24,
-			.idx_bits = 12,
-			.entry_ptr_shift = 11,
-			.table_size = 32 * 1024,
-		},
-		{
-			.idx_shift = 36,
-			.idx_bits = 12,
-			.entry_ptr_shift = 15,
-			.table_size = 32 * 1024,
-		},
-	};
-
 	const struct pgtable_level_desc *level_desc;
-	uint32_t levels;
+	int levels;
 	struct pgtable *pgt;
 	struct buf_ops *bops;
 	struct intel_buf *buf;
@@ -503,33 +584,796 @@ intel_aux_pgtable_create(struct intel_bb *ibb,
 	igt_assert(buf_count);
 	bops = bufs[0]->bops;
 
-	if (IS_METEORLAKE(ibb->devid)) {
-		level_desc = level_desc_table_mtl;
-		levels = ARRAY_SIZE(level_desc_table_mtl);
-	} else {
-		level_desc = level_desc_table_tgl;
-		levels = ARRAY_SIZE(level_desc_table_tgl);
-	}
+	level_desc = pgt_level_desc(ibb->devid, &levels);
 
-	pgt = pgt_create(&level_desc[0], levels, bufs, buf_count);
+	pgt = pgt_create(level_desc, levels, bufs, buf_count);
 	pgt->ibb = ibb;
-	pgt->buf = intel_buf_create(bops, pgt->size, 1, 8, 0, I915_TILING_NONE,
-				    I915_COMPRESSION_NONE);
+	buf = intel_buf_create(bops, pgt->size, 1, 8, 0, I915_TILING_NONE,
+			       I915_COMPRESSION_NONE);
 
 	/* We need to use pgt->max_align for aux table */
-	intel_bb_add_intel_buf_with_alignment(ibb, pgt->buf,
+	intel_bb_add_intel_buf_with_alignment(ibb, buf,
 					      pgt->max_align, false);
 
-	pgt_map(ibb->fd, pgt);
+	pgt->handle = buf->handle;
+	pgt->address = buf->addr.offset;
+	pgt->ptr = pgt_map(ibb->fd, buf->handle, pgt->size);
 	pgt_populate_entries(pgt, bufs, buf_count);
-	pgt_unmap(pgt);
+	munmap(pgt->ptr, pgt->size);
 
-	buf = pgt->buf;
 	pgt_destroy(pgt);
 
 	return buf;
 }
 
+/*
+ * Persistent AUX table: the table lives in one buffer kept mapped for the
+ * lifetime of the intel_bb. Each batch only rewrites the entries of surfaces
+ * which are new or whose address or format changed, table pages are reused
+ * through per level free lists and a table whose last entry is cleared is
+ * released. Mappings of buffers which are not part of the batch are kept
+ * (up to AUX_PGT_MAX_MAPPINGS, least recently used first out) so that
+ * ping-ponging between a few surfaces costs nothing, and are dropped as soon
+ * as another surface shows up in their address range.
+ */
+
+#define AUX_PGT_MAX_LEVELS	3
+#define AUX_PGT_MIN_TABLE_SIZE	(8 * 1024)
+#define AUX_PGT_MAX_MAPPINGS	32
+#define AUX_PGT_INITIAL_SIZE	(256 * 1024)
+
+struct aux_pgt_mapping {
+	uint32_t handle;
+	int surface_count;
+	struct aux_surface surface[2];
+	/* main surface range, aligned to the L1 entry granularity */
+	uint64_t start, end;
+	uint64_t last_used;
+};
+
+struct intel_aux_pgtable {
+	const struct pgtable_level_desc *desc;
+	int levels;
+	int max_align;
+
+	/* table storage, the top level table is at offset 0 */
+	void *ptr;
+	uint64_t address;
+	uint32_t size;
+	uint32_t alloc_ptr;
+	uint16_t *entry_count;
+	struct {
+		uint32_t *tables;
+		unsigned int count;
+		unsigned int allocated;
+	} free[AUX_PGT_MAX_LEVELS];
+
+	struct aux_pgt_mapping mappings[AUX_PGT_MAX_MAPPINGS];
+	int mapping_count;
+	uint64_t epoch;
+
+	/* backing buffer, NULL for tables in caller provided memory */
+	struct intel_bb *ibb;
+	struct buf_ops *bops;
+	struct intel_buf *buf;
+
+	struct intel_aux_pgtable_stats stats;
+};
+
+static uint64_t *apt_table(struct intel_aux_pgtable *pgt, uint32_t table)
+{
+	return pgt->ptr + table;
+}
+
+static uint16_t *apt_entry_count(struct intel_aux_pgtable *pgt, uint32_t table)
+{
+	return &pgt->entry_count[table / AUX_PGT_MIN_TABLE_SIZE];
+}
+
+static bool apt_alloc_table(struct intel_aux_pgtable *pgt, int level,
+			    uint32_t *table)
+{
+	uint32_t table_size = pgt->desc[level].table_size;
+
+	if (pgt->free[level].count) {
+		/* released tables have all their entries cleared */
+		*table = pgt->free[level].tables[--pgt->free[level].count];
+	} else {
+		*table = ALIGN(pgt->alloc_ptr, table_size);
+		if (*table + table_size > pgt->size)
+			return false;
+		pgt->alloc_ptr = *table + table_size;
+	}
+
+	pgt->stats.tables++;
+	pgt->stats.tables_allocated++;
+
+	return true;
+}
+
+static void apt_free_table(struct intel_aux_pgtable *pgt, int level,
+			   uint32_t table)
+{
+	typeof(pgt->free[0]) *free_list = &pgt->free[level];
+
+	if (free_list->count == free_list->allocated) {
+		free_list->allocated = free_list->allocated * 2 ?: 16;
+		free_list->tables = realloc(free_list->tables,
+					    free_list->allocated *
+					    sizeof(*free_list->tables));
+		igt_assert(free_list->tables);
+	}
+	free_list->tables[free_list->count++] = table;
+
+	pgt->stats.tables--;
+	pgt->stats.tables_freed++;
+}
+
+static int apt_map_surface(struct intel_aux_pgtable *pgt,
+			   const struct aux_surface *s)
+{
+	uint64_t lx_flags = pgt_get_lx_flags();
+	uint64_t addr, aux_addr;
+	int written = 0;
+
+	for (addr = s->addr, aux_addr = s->aux_addr; addr < s->end;
+	     addr += main_surface_block_size(pgt->desc),
+	     aux_addr += aux_ccs_block_size(pgt->desc)) {
+		uint64_t value = aux_addr | s->l1_flags;
+		uint32_t table = 0;
+		uint64_t *entry;
+		int level;
+
+		for (level = pgt->levels - 1; level >= 1; level--) {
+			const struct pgtable_level_desc *ld = &pgt->desc[level];
+			uint32_t child;
+
+			entry = &apt_table(pgt, table)[level_entry_index(ld, addr)];
+			if (*entry) {
+				table = (*entry & level_ptr_mask(ld)) - pgt->address;
+				continue;
+			}
+
+			if (!apt_alloc_table(pgt, level - 1, &child))
+				return -ENOSPC;
+			igt_assert(!((child + pgt->address) & ~level_ptr_mask(ld)));
+
+			*entry = pgt->address + (child | lx_flags);
+			(*apt_entry_count(pgt, table))++;
+			written++;
+			table = child;
+		}
+
+		igt_assert(!(aux_addr & ~level_ptr_mask(&pgt->desc[0])));
+
+		entry = &apt_table(pgt, table)[level_entry_index(&pgt->desc[0], addr)];
+		if (*entry == value)
+			continue;
+
+		if (!*entry)
+			(*apt_entry_count(pgt, table))++;
+		*entry = value;
+		written++;
+	}
+
+	return written;
+}
+
+/*
+ * A surface maps the blocks from the one holding its start up to the one
+ * holding its last block sized step, which may not be the one holding its
+ * end as surfaces do not have to start on a block boundary.
+ */
+static uint64_t apt_surface_end(const struct aux_surface *s,
+				uint64_t block_size)
+{
+	uint64_t steps = DIV_ROUND_UP(s->end - s->addr, block_size);
+
+	return ALIGN_DOWN(s->addr + (steps - 1) * block_size, block_size) +
+	       block_size;
+}
+
+static bool apt_mapping_covers(const struct intel_aux_pgtable *pgt,
+			       const struct aux_pgt_mapping *m, uint64_t addr)
+{
+	uint64_t block_size = main_surface_block_size(pgt->desc);
+
+	for (int i = 0; m && i < m->surface_count; i++)
+		if (addr >= ALIGN_DOWN(m->surface[i].addr, block_size) &&
+		    addr < apt_surface_end(&m->surface[i], block_size))
+			return true;
+
+	return false;
+}
+
+static int apt_unmap_surface(struct intel_aux_pgtable *pgt,
+			     const struct aux_surface *s,
+			     const struct aux_pgt_mapping *keep)
+{
+	uint64_t addr;
+	int cleared = 0;
+
+	for (addr = s->addr; addr < s->end;
+	     addr += main_surface_block_size(pgt->desc)) {
+		uint64_t *entries[AUX_PGT_MAX_LEVELS];
+		uint32_t tables[AUX_PGT_MAX_LEVELS];
+		uint32_t table = 0;
+		int level;
+
+		/* rewritten in place by the mapping replacing this one */
+		if (apt_mapping_covers(pgt, keep, addr))
+			continue;
+
+		for (level = pgt->levels - 1; level >= 0; level--) {
+			const struct pgtable_level_desc *ld = &pgt->desc[level];
+
+			tables[level] = table;
+			entries[level] = &apt_table(pgt, table)[level_entry_index(ld, addr)];
+			if (!*entries[level])
+				break;
+
+			if (level)
+				table = (*entries[level] & level_ptr_mask(ld)) -
+					pgt->address;
+		}
+
+		/* already cleared, e.g. a block shared by both planes */
+		if (level >= 0)
+			continue;
+
+		/* clear the L1 entry and release the tables it emptied */
+		for (level = 0; level < pgt->levels; level++) {
+			*entries[level] = 0;
+			cleared++;
+
+			if (--*apt_entry_count(pgt, tables[level]) ||
+			    level == pgt->levels - 1)
+				break;
+
+			apt_free_table(pgt, level, tables[level]);
+		}
+	}
+
+	return cleared;
+}
+
+static int apt_map(struct intel_aux_pgtable *pgt,
+		   const struct aux_pgt_mapping *m)
+{
+	int written = 0;
+
+	for (int i = 0; i < m->surface_count; i++) {
+		int ret = apt_map_surface(pgt, &m->surface[i]);
+
+		if (ret < 0)
+			return ret;
+		written += ret;
+	}
+
+	return written;
+}
+
+/*
+ * Clears the entries of mapping @idx which are not covered by @keep and
+ * replaces it with @keep, or drops it if @keep is NULL.
+ */
+static int apt_unmap(struct intel_aux_pgtable *pgt, int idx,
+		     const struct aux_pgt_mapping *keep)
+{
+	struct aux_pgt_mapping *m = &pgt->mappings[idx];
+	int cleared = 0;
+
+	for (int i = 0; i < m->surface_count; i++)
+		cleared += apt_unmap_surface(pgt, &m->surface[i], keep);
+
+	if (keep)
+		*m = *keep;
+	else
+		*m = pgt->mappings[--pgt->mapping_count];
+	pgt->stats.mappings = pgt->mapping_count;
+
+	return cleared;
+}
+
+static void apt_mapping_init(struct intel_aux_pgtable *pgt,
+			     struct aux_pgt_mapping *m,
+			     const struct intel_buf *buf)
+{
+	uint64_t block_size = main_surface_block_size(pgt->desc);
+
+	igt_assert(intel_buf_compressed(buf));
+	igt_assert_eq(buf->surface[0].offset, 0);
+
+	memset(m, 0, sizeof(*m));
+	m->handle = buf->handle;
+	m->surface_count = buf->format_is_yuv_semiplanar ? 2 : 1;
+
+	for (int i = 0; i < m->surface_count; i++) {
+		aux_surface_get(buf, i, &m->surface[i]);
+		m->end = max(m->end, apt_surface_end(&m->surface[i], block_size));
+	}
+	m->start = ALIGN_DOWN(m->surface[0].addr, block_size);
+}
+
+static int apt_find(struct intel_aux_pgtable *pgt, uint32_t handle)
+{
+	for (int i = 0; i < pgt->mapping_count; i++)
+		if (pgt->mappings[i].handle == handle)
+			return i;
+
+	return -1;
+}
+
+static bool apt_mapping_equal(const struct aux_pgt_mapping *a,
+			      const struct aux_pgt_mapping *b)
+{
+	return a->surface_count == b->surface_count &&
+	       !memcmp(a->surface, b->surface,
+		       a->surface_count * sizeof(a->surface[0]));
+}
+
+/**
+ * intel_aux_pgtable_new:
+ * @devid: PCI device ID
+ *
+ * Creates a persistent AUX page table. The table memory is provided with
+ * intel_aux_pgtable_set_storage(), see gen12_aux_pgtable_init() for the
+ * variant backed by a buffer object.
+ *
+ * Returns: a new table, to be released with intel_aux_pgtable_free().
+ */
+struct intel_aux_pgtable *intel_aux_pgtable_new(uint32_t devid)
+{
+	struct intel_aux_pgtable *pgt;
+
+	pgt = calloc(1, sizeof(*pgt));
+	igt_assert(pgt);
+
+	pgt->desc = pgt_level_desc(devid, &pgt->levels);
+	igt_assert(pgt->levels <= AUX_PGT_MAX_LEVELS);
+
+	for (int level = 0; level < pgt->levels; level++)
+		pgt->max_align = max(pgt->max_align, pgt->desc[level].table_size);
+
+	return pgt;
+}
+
+/**
+ * intel_aux_pgtable_set_storage:
+ * @pgt: AUX page table
+ * @ptr: CPU pointer to the table memory
+ * @address: GPU address of the table memory
+ * @size: size of the table memory
+ *
+ * Moves @pgt to new memory and rewrites all the mappings it holds.
+ *
+ * Returns: 0 on success, -ENOSPC if @size is too small for the mappings.
+ */
+int intel_aux_pgtable_set_storage(struct intel_aux_pgtable *pgt, void *ptr,
+				  uint64_t address, uint32_t size)
+{
+	uint32_t top;
+
+	igt_assert(!(address % pgt->max_align));
+	igt_assert(size >= pgt->desc[pgt->levels - 1].table_size);
+
+	pgt->ptr = ptr;
+	pgt->address = address;
+	pgt->size = size;
+	pgt->alloc_ptr = 0;
+	pgt->stats.tables = 0;
+	for (int level = 0; level < pgt->levels; level++)
+		pgt->free[level].count = 0;
+
+	free(pgt->entry_count);
+	pgt->entry_count = calloc(size / AUX_PGT_MIN_TABLE_SIZE,
+				  sizeof(*pgt->entry_count));
+	igt_assert(pgt->entry_count);
+
+	memset(ptr, 0, size);
+	igt_assert(apt_alloc_table(pgt, pgt->levels - 1, &top));
+	igt_assert_eq(top, 0);
+
+	pgt->stats.rebuilds++;
+
+	for (int i = 0; i < pgt->mapping_count; i++) {
+		int ret = apt_map(pgt, &pgt->mappings[i]);
+
+		if (ret < 0)
+			return ret;
+		pgt->stats.entries_written += ret;
+	}
+
+	return 0;
+}
+
+/**
+ * intel_aux_pgtable_needs_update:
+ * @pgt: AUX page table
+ * @bufs: compressed buffers
+ * @buf_count: number of buffers in @bufs
+ *
+ * Returns: true if intel_aux_pgtable_update() would modify the table for
+ * @bufs, that is the table must not be in use by the GPU any more.
+ */
+bool intel_aux_pgtable_needs_update(struct intel_aux_pgtable *pgt,
+				    struct intel_buf **bufs, int buf_count)
+{
+	struct aux_pgt_mapping m;
+
+	for (int i = 0; i < buf_count; i++) {
+		int idx = apt_find(pgt, bufs[i]->handle);
+
+		apt_mapping_init(pgt, &m, bufs[i]);
+		if (idx < 0 || !apt_mapping_equal(&pgt->mappings[idx], &m))
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * intel_aux_pgtable_update:
+ * @pgt: AUX page table
+ * @bufs: compressed buffers to map
+ * @buf_count: number of buffers in @bufs
+ *
+ * Makes sure that @bufs are mapped in @pgt at their current address and
+ * format. Only the entries of buffers which are new or changed since the
+ * previous update are written, the entries of other buffers stay in place
+ * until another buffer is mapped over their address range.
+ *
+ * Returns: the number of entries written or cleared, or -ENOSPC if the table
+ * memory is too small, in which case it must be grown with
+ * intel_aux_pgtable_set_storage() before retrying.
+ */
+int intel_aux_pgtable_update(struct intel_aux_pgtable *pgt,
+			     struct intel_buf **bufs, int buf_count)
+{
+	int changed = 0;
+
+	igt_assert(pgt->ptr);
+
+	pgt->epoch++;
+	pgt->stats.updates++;
+
+	for (int i = 0; i < buf_count; i++) {
+		struct aux_pgt_mapping m;
+		int idx, old, ret;
+
+		apt_mapping_init(pgt, &m, bufs[i]);
+		m.last_used = pgt->epoch;
+
+		old = apt_find(pgt, m.handle);
+		if (old >= 0 && apt_mapping_equal(&pgt->mappings[old], &m)) {
+			pgt->mappings[old].last_used = pgt->epoch;
+			continue;
+		}
+
+		/* stale mappings of other buffers which moved or are gone */
+		for (idx = pgt->mapping_count - 1; idx >= 0; idx--) {
+			if (pgt->mappings[idx].handle == m.handle ||
+			    pgt->mappings[idx].start >= m.end ||
+			    m.start >= pgt->mappings[idx].end)
+				continue;
+
+			changed += apt_unmap(pgt, idx, NULL);
+		}
+		old = apt_find(pgt, m.handle);
+
+		if (old < 0 && pgt->mapping_count == AUX_PGT_MAX_MAPPINGS) {
+			int lru = 0;
+
+			for (idx = 1; idx < pgt->mapping_count; idx++)
+				if (pgt->mappings[idx].last_used <
+				    pgt->mappings[lru].last_used)
+					lru = idx;
+			changed += apt_unmap(pgt, lru, NULL);
+		}
+
+		/*
+		 * Map first, so that the entries the new and the old location
+		 * have in common are rewritten in place rather than cleared
+		 * and their tables released and allocated again.
+		 */
+		ret = apt_map(pgt, &m);
+		if (ret < 0)
+			return ret;
+		changed += ret;
+
+		if (old >= 0) {
+			changed += apt_unmap(pgt, old, &m);
+		} else {
+			pgt->mappings[pgt->mapping_count++] = m;
+			pgt->stats.mappings = pgt->mapping_count;
+		}
+	}
+
+	pgt->stats.entries_written += changed;
+
+	return changed;
+}
+
+/**
+ * intel_aux_pgtable_evict:
+ * @pgt: AUX page table
+ * @handle: buffer handle
+ *
+ * Removes the entries of the buffer @handle from @pgt, releasing the tables
+ * which are no longer referenced.
+ *
+ * Returns: the number of entries cleared.
+ */
+int intel_aux_pgtable_evict(struct intel_aux_pgtable *pgt, uint32_t handle)
+{
+	int idx = apt_find(pgt, handle);
+	int cleared;
+
+	if (idx < 0)
+		return 0;
+
+	cleared = apt_unmap(pgt, idx, NULL);
+	pgt->stats.entries_written += cleared;
+
+	return cleared;
+}
+
+/**
+ * intel_aux_pgtable_translate:
+ * @devid: PCI device ID
+ * @ptr: CPU pointer to the table memory
+ * @table_address: GPU address of the table memory
+ * @address: main surface address to look up
+ *
+ * Walks an AUX page table built for @devid.
+ *
+ * Returns: the L1 entry mapping @address, 0 if there is none.
+ */
+uint64_t intel_aux_pgtable_translate(uint32_t devid, const void *ptr,
+				     uint64_t table_address, uint64_t address)
+{
+	const struct pgtable_level_desc *ld;
+	uint64_t table = 0;
+	int levels;
+
+	ld = pgt_level_desc(devid, &levels);
+
+	for (int level = levels - 1; level >= 1; level--) {
+		const uint64_t *entries = ptr + table;
+		uint64_t entry = entries[level_entry_index(&ld[level], address)];
+
+		if (!entry)
+			return 0;
+
+		table = (entry & level_ptr_mask(&ld[level])) - table_address;
+	}
+
+	return ((const uint64_t *)(ptr + table))[level_entry_index(&ld[0], address)];
+}
+
+/**
+ * intel_aux_pgtable_lookup:
+ * @pgt: AUX page table
+ * @address: main surface address to look up
+ *
+ * Returns: the L1 entry mapping @address in @pgt, 0 if there is none.
+ */
+uint64_t intel_aux_pgtable_lookup(struct intel_aux_pgtable *pgt,
+				  uint64_t address)
+{
+	uint64_t table = 0;
+
+	for (int level = pgt->levels - 1; level >= 1; level--) {
+		const struct pgtable_level_desc *ld = &pgt->desc[level];
+		uint64_t entry = apt_table(pgt, table)[level_entry_index(ld, address)];
+
+		if (!entry)
+			return 0;
+
+		table = (entry & level_ptr_mask(ld)) - pgt->address;
+	}
+
+	return apt_table(pgt, table)[level_entry_index(&pgt->desc[0], address)];
+}
+
+static int apt_check_table(struct intel_aux_pgtable *pgt, int level,
+			   uint32_t table, uint8_t *seen)
+{
+	const struct pgtable_level_desc *ld = &pgt->desc[level];
+	int entries = ld->table_size / sizeof(uint64_t);
+	int valid = 0, tables = 1;
+
+	igt_assert(!(table % ld->table_size));
+	igt_assert(table + ld->table_size <= pgt->alloc_ptr);
+	igt_assert_f(!seen[table / AUX_PGT_MIN_TABLE_SIZE],
+		     "table 0x%x referenced twice\n", table);
+	seen[table / AUX_PGT_MIN_TABLE_SIZE] = 1;
+
+	for (int i = 0; i < entries; i++) {
+		uint64_t entry = apt_table(pgt, table)[i];
+
+		if (!entry)
+			continue;
+
+		valid++;
+		if (level)
+			tables += apt_check_table(pgt, level - 1,
+						  (entry & level_ptr_mask(ld)) -
+						  pgt->address, seen);
+	}
+
+	igt_assert_eq(valid, *apt_entry_count(pgt, table));
+
+	return tables;
+}
+
+/**
+ * intel_aux_pgtable_check:
+ * @pgt: AUX page table
+ *
+ * Asserts the consistency of @pgt: every table is referenced once, the
+ * bookkeeping matches the table contents, released tables are clear and
+ * every mapping held by @pgt is correct.
+ */
+void intel_aux_pgtable_check(struct intel_aux_pgtable *pgt)
+{
+	uint8_t *seen;
+
+	seen = calloc(pgt->size / AUX_PGT_MIN_TABLE_SIZE, 1);
+	igt_assert(seen);
+
+	igt_assert_eq(apt_check_table(pgt, pgt->levels - 1, 0, seen),
+		      pgt->stats.tables);
+
+	for (int level = 0; level < pgt->levels; level++) {
+		for (int i = 0; i < pgt->free[level].count; i++) {
+			uint32_t table = pgt->free[level].tables[i];
+			const uint64_t *entries = apt_table(pgt, table);
+
+			igt_assert(!seen[table / AUX_PGT_MIN_TABLE_SIZE]);
+			for (int j = 0; j < pgt->desc[level].table_size / 8; j++)
+				igt_assert(!entries[j]);
+		}
+	}
+
+	for (int i = 0; i < pgt->mapping_count; i++) {
+		const struct aux_pgt_mapping *m = &pgt->mappings[i];
+
+		for (int j = 0; j < m->surface_count; j++) {
+			const struct aux_surface *s = &m->surface[j];
+			uint64_t addr, aux_addr;
+
+			for (addr = s->addr, aux_addr = s->aux_addr;
+			     addr < s->end;
+			     addr += main_surface_block_size(pgt->desc),
+			     aux_addr += aux_ccs_block_size(pgt->desc)) {
+				uint64_t entry = intel_aux_pgtable_lookup(pgt, addr);
+
+				/* the UV plane may share its first block */
+				if (j + 1 < m->surface_count &&
+				    addr + main_surface_block_size(pgt->desc) >= s->end)
+					continue;
+
+				igt_assert_eq_u64(entry, aux_addr | s->l1_flags);
+			}
+		}
+	}
+
+	free(seen);
+}
+
+/**
+ * intel_aux_pgtable_get_stats:
+ * @pgt: AUX page table
+ *
+ * Returns: the counters of @pgt.
+ */
+struct intel_aux_pgtable_stats
+intel_aux_pgtable_get_stats(struct intel_aux_pgtable *pgt)
+{
+	return pgt->stats;
+}
+
+static void apt_release_buf(struct intel_aux_pgtable *pgt)
+{
+	if (!pgt->buf)
+		return;
+
+	munmap(pgt->ptr, pgt->size);
+	intel_buf_destroy(pgt->buf);
+	pgt->buf = NULL;
+	pgt->ptr = NULL;
+}
+
+/**
+ * intel_aux_pgtable_free:
+ * @pgt: AUX page table
+ *
+ * Releases @pgt and its backing buffer, if any.
+ */
+void intel_aux_pgtable_free(struct intel_aux_pgtable *pgt)
+{
+	if (!pgt)
+		return;
+
+	igt_debug("aux pgtable: %"PRIu64" updates, %"PRIu64" entries written, %"PRIu64" tables allocated, %"PRIu64" rebuilds\n",
+		  pgt->stats.updates, pgt->stats.entries_written,
+		  pgt->stats.tables_allocated, pgt->stats.rebuilds);
+
+	apt_release_buf(pgt);
+
+	for (int level = 0; level < pgt->levels; level++)
+		free(pgt->free[level].tables);
+	free(pgt->entry_count);
+	free(pgt);
+}
+
+static void apt_add_to_bb(struct intel_aux_pgtable *pgt)
+{
+	intel_bb_add_intel_buf_with_alignment(pgt->ibb, pgt->buf,
+					      pgt->max_align, false);
+	/* the entries hold absolute addresses, the table must not move */
+	intel_bb_object_set_flag(pgt->ibb, pgt->buf->handle, EXEC_OBJECT_PINNED);
+}
+
+static void apt_resize(struct intel_aux_pgtable *pgt, uint32_t size)
+{
+	/* the GPU may still walk the previous table */
+	intel_bb_sync(pgt->ibb);
+	apt_release_buf(pgt);
+
+	size = ALIGN(size, pgt->max_align);
+	do {
+		pgt->buf = intel_buf_create(pgt->bops, size, 1, 8, 0,
+					    I915_TILING_NONE,
+					    I915_COMPRESSION_NONE);
+		apt_add_to_bb(pgt);
+		pgt->ptr = pgt_map(pgt->ibb->fd, pgt->buf->handle, size);
+
+		if (!intel_aux_pgtable_set_storage(pgt, pgt->ptr,
+						   pgt->buf->addr.offset, size))
+			break;
+
+		apt_release_buf(pgt);
+		size *= 2;
+	} while (1);
+}
+
+static void apt_bind(struct intel_aux_pgtable *pgt,
+		     struct intel_buf **bufs, int buf_count)
+{
+	if (!pgt->buf)
+		apt_resize(pgt, max_t(uint32_t, AUX_PGT_INITIAL_SIZE,
+				      intel_aux_pgtable_build(pgt->ibb->devid,
+							      bufs, buf_count,
+							      NULL, 0)));
+	else
+		apt_add_to_bb(pgt);
+
+	/* the bb objects cache was purged, all entries must be rewritten */
+	if (pgt->buf->addr.offset != pgt->address) {
+		intel_bb_sync(pgt->ibb);
+		if (intel_aux_pgtable_set_storage(pgt, pgt->ptr,
+						  pgt->buf->addr.offset,
+						  pgt->size))
+			apt_resize(pgt, pgt->size * 2);
+	}
+
+	if (!intel_aux_pgtable_needs_update(pgt, bufs, buf_count))
+		return;
+
+	intel_bb_sync(pgt->ibb);
+	while (intel_aux_pgtable_update(pgt, bufs, buf_count) == -ENOSPC)
+		apt_resize(pgt, pgt->size * 2);
+}
+
+static bool aux_pgtable_persistent(struct intel_bb *ibb)
+{
+	/* entries for pinned buffers are only reusable without relocations */
+	return ibb->allocator_type != INTEL_ALLOCATOR_NONE &&
+	       ibb->allocator_type != INTEL_ALLOCATOR_RELOC;
+}
+
 static void
 aux_pgtable_reserve_buf_slot(struct intel_buf **bufs, int buf_count,
 			     struct intel_buf *new_buf)
@@ -625,9 +1469,21 @@ gen12_aux_pgtable_init(struct aux_pgtable_info *info,
 		info->buf_count++;
 	}
 
-	info->pgtable_buf = intel_aux_pgtable_create(ibb,
-						     info->bufs,
-						     info->buf_count);
+	if (aux_pgtable_persistent(ibb)) {
+		if (!ibb->aux_pgtable) {
+			ibb->aux_pgtable = intel_aux_pgtable_new(ibb->devid);
+			ibb->aux_pgtable->ibb = ibb;
+			ibb->aux_pgtable->bops = info->bufs[0]->bops;
+		}
+
+		info->pgtable = ibb->aux_pgtable;
+		apt_bind(info->pgtable, info->bufs, info->buf_count);
+		info->pgtable_buf = info->pgtable->buf;
+	} else {
+		info->pgtable_buf = intel_aux_pgtable_create(ibb,
+							     info->bufs,
+							     info->buf_count);
+	}
 
 	igt_assert(info->pgtable_buf);
 }
@@ -645,7 +1501,8 @@ gen12_aux_pgtable_cleanup(struct intel_bb *ibb, struct aux_pgtable_info *info)
 		igt_assert_eq_u64(addr, info->buf_pin_offsets[i]);
 	}
 
-	if (info->pgtable_buf) {
+	/* a persistent table is kept for the next batch */
+	if (info->pgtable_buf && !info->pgtable) {
 		intel_bb_remove_intel_buf(ibb, info->pgtable_buf);
 		intel_buf_destroy(info->pgtable_buf);
 	}
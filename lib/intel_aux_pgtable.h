@@ -3,17 +3,51 @@
 
 #include "intel_bufops.h"
 
+struct intel_aux_pgtable;
+
 struct aux_pgtable_info {
 	int buf_count;
 	struct intel_buf *bufs[2];
 	uint64_t buf_pin_offsets[2];
 	struct intel_buf *pgtable_buf;
+	/* set when pgtable_buf belongs to the persistent table of the bb */
+	struct intel_aux_pgtable *pgtable;
+};
+
+struct intel_aux_pgtable_stats {
+	uint64_t updates;
+	uint64_t entries_written;
+	uint64_t tables_allocated;
+	uint64_t tables_freed;
+	uint64_t rebuilds;
+	unsigned int tables;
+	unsigned int mappings;
 };
 
 struct intel_buf *
 intel_aux_pgtable_create(struct intel_bb *ibb,
 			 struct intel_buf **bufs, int buf_count);
 
+uint32_t intel_aux_pgtable_build(uint32_t devid, struct intel_buf **bufs,
+				 int buf_count, void *ptr, uint64_t address);
+
+struct intel_aux_pgtable *intel_aux_pgtable_new(uint32_t devid);
+void intel_aux_pgtable_free(struct intel_aux_pgtable *pgt);
+int intel_aux_pgtable_set_storage(struct intel_aux_pgtable *pgt, void *ptr,
+				  uint64_t address, uint32_t size);
+bool intel_aux_pgtable_needs_update(struct intel_aux_pgtable *pgt,
+				    struct intel_buf **bufs, int buf_count);
+int intel_aux_pgtable_update(struct intel_aux_pgtable *pgt,
+			     struct intel_buf **bufs, int buf_count);
+int intel_aux_pgtable_evict(struct intel_aux_pgtable *pgt, uint32_t handle);
+uint64_t intel_aux_pgtable_lookup(struct intel_aux_pgtable *pgt,
+				  uint64_t address);
+uint64_t intel_aux_pgtable_translate(uint32_t devid, const void *ptr,
+				     uint64_t table_address, uint64_t address);
+void intel_aux_pgtable_check(struct intel_aux_pgtable *pgt);
+struct intel_aux_pgtable_stats
+intel_aux_pgtable_get_stats(struct intel_aux_pgtable *pgt);
+
 void
 gen12_aux_pgtable_init(struct aux_pgtable_info *info,
 		       struct intel_bb *ibb,
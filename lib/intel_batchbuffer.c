@@ -39,6 +39,7 @@
 #include "intel_blt.h"
 #include "igt_aux.h"
 #include "igt_syncobj.h"
+#include "intel_aux_pgtable.h"
 #include "intel_batchbuffer.h"
 #include "intel_bufops.h"
 #include "intel_chipset.h"
@@ -1312,6 +1313,7 @@ void intel_bb_destroy(struct intel_bb *ibb)
 	ibb->refcount--;
 	igt_assert_f(ibb->refcount == 0, "Trying to destroy referenced bb!");
 
+	intel_aux_pgtable_free(ibb->aux_pgtable);
 	__intel_bb_remove_intel_bufs(ibb);
 	__intel_bb_destroy_relocations(ibb);
 	__intel_bb_destroy_objects(ibb);
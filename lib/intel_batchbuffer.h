@@ -308,6 +308,9 @@ struct intel_bb {
 	bool lr_mode;
 	int64_t user_fence_offset;
 	uint64_t user_fence_value;
+
+	/* AUX page table kept across batches, see gen12_aux_pgtable_init() */
+	struct intel_aux_pgtable *aux_pgtable;
 };
 
 struct intel_bb *
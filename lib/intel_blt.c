@@ -975,6 +975,54 @@ void blt_copy_init(int fd, struct blt_copy_data *blt)
 	blt->driver = get_intel_driver(fd);
 }
 
+static uint64_t __emit_bbe(uint8_t *bb, uint64_t bb_size, uint64_t bb_pos)
+{
+	uint32_t bbe = MI_BATCH_BUFFER_END;
+
+	igt_assert(bb_pos + sizeof(bbe) < bb_size);
+	memcpy(bb + bb_pos, &bbe, sizeof(bbe));
+
+	return bb_pos + sizeof(bbe);
+}
+
+static uint64_t __emit_block_copy(uint32_t devid,
+				  const struct blt_copy_data *blt,
+				  const struct blt_block_copy_data_ext *ext,
+				  uint64_t src_offset, uint64_t dst_offset,
+				  uint64_t bb_offset, uint8_t *bb,
+				  uint64_t bb_size, uint64_t bb_pos)
+{
+	unsigned int ip_ver = intel_graphics_ver(devid);
+	struct gen12_block_copy_data data = {};
+	struct gen12_block_copy_data_ext dext = {};
+
+	fill_data(&data, blt, src_offset, dst_offset, ext, ip_ver);
+
+	igt_assert(bb_pos + sizeof(data) < bb_size);
+	memcpy(bb + bb_pos, &data, sizeof(data));
+	bb_pos += sizeof(data);
+
+	if (ext) {
+		fill_data_ext(&dext, ext);
+		igt_assert(bb_pos + sizeof(dext) < bb_size);
+		memcpy(bb + bb_pos, &dext, sizeof(dext));
+		bb_pos += sizeof(dext);
+	}
+
+	if (blt->print_bb) {
+		igt_info("[BLOCK COPY]\n");
+		igt_info("src offset: %" PRIx64 ", dst offset: %" PRIx64
+			 ", bb offset: %" PRIx64 "\n",
+			 src_offset, dst_offset, bb_offset);
+
+		dump_bb_cmd(&data, ip_ver);
+		if (ext)
+			dump_bb_ext(&dext);
+	}
+
+	return bb_pos;
+}
+
 /**
  * emit_blt_block_copy:
  * @fd: drm fd
@@ -997,11 +1045,7 @@ uint64_t emit_blt_block_copy(int fd,
 			     uint64_t bb_pos,
 			     bool emit_bbe)
 {
-	unsigned int ip_ver = intel_graphics_ver(intel_get_drm_devid(fd));
-	struct gen12_block_copy_data data = {};
-	struct gen12_block_copy_data_ext dext = {};
 	uint64_t dst_offset, src_offset, bb_offset;
-	uint32_t bbe = MI_BATCH_BUFFER_END;
 	uint8_t *bb;
 
 	igt_assert_f(ahnd, "block-copy supports softpin only\n");
@@ -1015,37 +1059,13 @@ uint64_t emit_blt_block_copy(int fd,
 	dst_offset += blt->dst.plane_offset;
 	bb_offset = get_offset(ahnd, blt->bb.handle, blt->bb.size, 0);
 
-	fill_data(&data, blt, src_offset, dst_offset, ext, ip_ver);
-
 	bb = bo_map(fd, blt->bb.handle, blt->bb.size, blt->driver);
 
-	igt_assert(bb_pos + sizeof(data) < blt->bb.size);
-	memcpy(bb + bb_pos, &data, sizeof(data));
-	bb_pos += sizeof(data);
-
-	if (ext) {
-		fill_data_ext(&dext, ext);
-		igt_assert(bb_pos + sizeof(dext) < blt->bb.size);
-		memcpy(bb + bb_pos, &dext, sizeof(dext));
-		bb_pos += sizeof(dext);
-	}
-
-	if (emit_bbe) {
-		igt_assert(bb_pos + sizeof(uint32_t) < blt->bb.size);
-		memcpy(bb + bb_pos, &bbe, sizeof(bbe));
-		bb_pos += sizeof(uint32_t);
-	}
-
-	if (blt->print_bb) {
-		igt_info("[BLOCK COPY]\n");
-		igt_info("src offset: %" PRIx64 ", dst offset: %" PRIx64
-			 ", bb offset: %" PRIx64 "\n",
-			 src_offset, dst_offset, bb_offset);
-
-		dump_bb_cmd(&data, ip_ver);
-		if (ext)
-			dump_bb_ext(&dext);
-	}
+	bb_pos = __emit_block_copy(intel_get_drm_devid(fd), blt, ext,
+				   src_offset, dst_offset, bb_offset,
+				   bb, blt->bb.size, bb_pos);
+	if (emit_bbe)
+		bb_pos = __emit_bbe(bb, blt->bb.size, bb_pos);
 
 	munmap(bb, blt->bb.size);
 
@@ -1120,10 +1140,15 @@ int blt_block_copy(int fd,
  * has to divide ccs copy of bigger surfaces to couple of separate commands.
  * This function returns total size of ccs data used for the surface.
  */
-static uint32_t __ccs_size(int fd, const struct blt_ctrl_surf_copy_data *surf)
+static uint16_t __ccs_ratio(uint32_t devid)
+{
+	return intel_gen(devid) >= 20 ? 512 : 256;
+}
+
+static uint32_t __ccs_size(uint32_t devid, const struct blt_ctrl_surf_copy_data *surf)
 {
 	uint32_t src_size, dst_size;
-	uint16_t ccsratio = CCS_RATIO(fd);
+	uint16_t ccsratio = __ccs_ratio(devid);
 
 	src_size = surf->src.access_type == DIRECT_ACCESS ?
 				surf->src.size : surf->src.size / ccsratio;
@@ -1264,48 +1289,18 @@ void blt_ctrl_surf_copy_init(int fd, struct blt_ctrl_surf_copy_data *surf)
 	surf->driver = get_intel_driver(fd);
 }
 
-/**
- * emit_blt_ctrl_surf_copy:
- * @fd: drm fd
- * @ahnd: allocator handle
- * @surf: blitter data for ctrl-surf-copy
- * @bb_pos: position at which insert block copy commands
- * @emit_bbe: emit MI_BATCH_BUFFER_END after ctrl-surf-copy or not
- *
- * Function emits ctrl-surf-copy blit between @src and @dst described in
- * @blt object at @bb_pos. Allows concatenating with other commands to
- * achieve pipelining.
- *
- * Returns:
- * Next write position in batch.
- */
-uint64_t emit_blt_ctrl_surf_copy(int fd,
-				 uint64_t ahnd,
-				 const struct blt_ctrl_surf_copy_data *surf,
-				 uint64_t bb_pos,
-				 bool emit_bbe)
+static uint64_t __emit_ctrl_surf_copy(uint32_t devid,
+				      const struct blt_ctrl_surf_copy_data *surf,
+				      uint64_t src_offset, uint64_t dst_offset,
+				      uint64_t bb_offset, uint8_t *bb,
+				      uint64_t bb_size, uint64_t bb_pos)
 {
-	unsigned int ip_ver = intel_graphics_ver(intel_get_drm_devid(fd));
+	unsigned int ip_ver = intel_graphics_ver(devid);
 	union ctrl_surf_copy_data data = { };
 	size_t data_sz;
-	uint64_t dst_offset, src_offset, bb_offset, alignment;
-	uint32_t bbe = MI_BATCH_BUFFER_END;
-	uint32_t *bb;
 	uint32_t ccs_per_page, max_blocks, src_step, dst_step;
 	int32_t left_blocks;
 
-	igt_assert_f(ahnd, "ctrl-surf-copy supports softpin only\n");
-	igt_assert_f(surf, "ctrl-surf-copy requires data to do ctrl-surf-copy blit\n");
-
-	alignment = 1ull << 16;
-	src_offset = get_offset_pat_index(ahnd, surf->src.handle, surf->src.size,
-					  alignment, surf->src.pat_index);
-	dst_offset = get_offset_pat_index(ahnd, surf->dst.handle, surf->dst.size,
-					  alignment, surf->dst.pat_index);
-	bb_offset = get_offset(ahnd, surf->bb.handle, surf->bb.size, alignment);
-
-	bb = bo_map(fd, surf->bb.handle, surf->bb.size, surf->driver);
-
 	/*
 	 * Copying in/out CCS data is limited by bitfield size_of_ctrl_copy size
 	 * what means operation on bigger surface needs to be handled on couple
@@ -1316,7 +1311,7 @@ uint64_t emit_blt_ctrl_surf_copy(int fd,
 	 * in bitfield location [and in future platforms potentially size]).
 	 */
 	if (ip_ver >= IP_VER(20, 0)) {
-		ccs_per_page = SZ_4K / CCS_RATIO(fd);
+		ccs_per_page = SZ_4K / __ccs_ratio(devid);
 
 		data.xe2.dw00.client = 0x2;
 		data.xe2.dw00.opcode = 0x48;
@@ -1341,7 +1336,7 @@ uint64_t emit_blt_ctrl_surf_copy(int fd,
 
 		data_sz = sizeof(data.xe2);
 	} else {
-		ccs_per_page = SZ_64K / CCS_RATIO(fd);
+		ccs_per_page = SZ_64K / __ccs_ratio(devid);
 
 		data.gen12.dw00.client = 0x2;
 		data.gen12.dw00.opcode = 0x48;
@@ -1367,7 +1362,7 @@ uint64_t emit_blt_ctrl_surf_copy(int fd,
 		data_sz = sizeof(data.gen12);
 	}
 
-	left_blocks = __ccs_size(fd, surf) / ccs_per_page;
+	left_blocks = __ccs_size(devid, surf) / ccs_per_page;
 
 	while (left_blocks > 0) {
 		int32_t nblocks = min_t(int32_t, left_blocks, max_blocks);
@@ -1390,7 +1385,7 @@ uint64_t emit_blt_ctrl_surf_copy(int fd,
 		dst_offset += dst_step;
 		src_offset += src_step;
 
-		igt_assert(bb_pos + data_sz < surf->bb.size);
+		igt_assert(bb_pos + data_sz < bb_size);
 		memcpy(bb + bb_pos, &data, data_sz);
 		bb_pos += data_sz;
 
@@ -1407,11 +1402,50 @@ uint64_t emit_blt_ctrl_surf_copy(int fd,
 		}
 	}
 
-	if (emit_bbe) {
-		igt_assert(bb_pos + sizeof(uint32_t) < surf->bb.size);
-		memcpy(bb + bb_pos, &bbe, sizeof(bbe));
-		bb_pos += sizeof(uint32_t);
-	}
+	return bb_pos;
+}
+
+/**
+ * emit_blt_ctrl_surf_copy:
+ * @fd: drm fd
+ * @ahnd: allocator handle
+ * @surf: blitter data for ctrl-surf-copy
+ * @bb_pos: position at which insert block copy commands
+ * @emit_bbe: emit MI_BATCH_BUFFER_END after ctrl-surf-copy or not
+ *
+ * Function emits ctrl-surf-copy blit between @src and @dst described in
+ * @blt object at @bb_pos. Allows concatenating with other commands to
+ * achieve pipelining.
+ *
+ * Returns:
+ * Next write position in batch.
+ */
+uint64_t emit_blt_ctrl_surf_copy(int fd,
+				 uint64_t ahnd,
+				 const struct blt_ctrl_surf_copy_data *surf,
+				 uint64_t bb_pos,
+				 bool emit_bbe)
+{
+	uint64_t dst_offset, src_offset, bb_offset, alignment;
+	uint8_t *bb;
+
+	igt_assert_f(ahnd, "ctrl-surf-copy supports softpin only\n");
+	igt_assert_f(surf, "ctrl-surf-copy requires data to do ctrl-surf-copy blit\n");
+
+	alignment = 1ull << 16;
+	src_offset = get_offset_pat_index(ahnd, surf->src.handle, surf->src.size,
+					  alignment, surf->src.pat_index);
+	dst_offset = get_offset_pat_index(ahnd, surf->dst.handle, surf->dst.size,
+					  alignment, surf->dst.pat_index);
+	bb_offset = get_offset(ahnd, surf->bb.handle, surf->bb.size, alignment);
+
+	bb = bo_map(fd, surf->bb.handle, surf->bb.size, surf->driver);
+
+	bb_pos = __emit_ctrl_surf_copy(intel_get_drm_devid(fd), surf,
+				       src_offset, dst_offset, bb_offset,
+				       bb, surf->bb.size, bb_pos);
+	if (emit_bbe)
+		bb_pos = __emit_bbe(bb, surf->bb.size, bb_pos);
 
 	munmap(bb, surf->bb.size);
 
@@ -1629,33 +1663,14 @@ static void dump_bb_fast_cmd(struct gen12_fast_copy_data *data)
 		 cmd[9], data->dw09.src_address_hi);
 }
 
-/**
- * emit_blt_fast_copy:
- * @fd: drm fd
- * @ahnd: allocator handle
- * @blt: blitter data for fast-copy (same as for block-copy but doesn't use
- * compression fields).
- * @bb_pos: position at which insert block copy commands
- * @emit_bbe: emit MI_BATCH_BUFFER_END after fast-copy or not
- *
- * Function emits fast-copy blit between @src and @dst described in @blt object
- * at @bb_pos. Allows concatenating with other commands to
- * achieve pipelining.
- *
- * Returns:
- * Next write position in batch.
- */
-uint64_t emit_blt_fast_copy(int fd,
-			    uint64_t ahnd,
-			    const struct blt_copy_data *blt,
-			    uint64_t bb_pos,
-			    bool emit_bbe)
+static uint64_t __emit_fast_copy(uint32_t devid,
+				 const struct blt_copy_data *blt,
+				 uint64_t src_offset, uint64_t dst_offset,
+				 uint64_t bb_offset, uint8_t *bb,
+				 uint64_t bb_size, uint64_t bb_pos)
 {
-	unsigned int ip_ver = intel_graphics_ver(intel_get_drm_devid(fd));
+	unsigned int ip_ver = intel_graphics_ver(devid);
 	struct gen12_fast_copy_data data = {};
-	uint64_t dst_offset, src_offset, bb_offset;
-	uint32_t bbe = MI_BATCH_BUFFER_END;
-	uint32_t *bb;
 
 	data.dw00.client = 0x2;
 	data.dw00.opcode = 0x42;
@@ -1686,14 +1701,6 @@ uint64_t emit_blt_fast_copy(int fd,
 	data.dw03.dst_x2 = blt->dst.x2;
 	data.dw03.dst_y2 = blt->dst.y2;
 
-	src_offset = get_offset_pat_index(ahnd, blt->src.handle, blt->src.size,
-					  0, blt->src.pat_index);
-	src_offset += blt->src.plane_offset;
-	dst_offset = get_offset_pat_index(ahnd, blt->dst.handle, blt->dst.size, 0,
-					  blt->dst.pat_index);
-	dst_offset += blt->dst.plane_offset;
-	bb_offset = get_offset(ahnd, blt->bb.handle, blt->bb.size, 0);
-
 	data.dw04.dst_address_lo = dst_offset;
 	data.dw05.dst_address_hi = dst_offset >> 32;
 
@@ -1710,18 +1717,10 @@ uint64_t emit_blt_fast_copy(int fd,
 	data.dw08.src_address_lo = src_offset;
 	data.dw09.src_address_hi = src_offset >> 32;
 
-	bb = bo_map(fd, blt->bb.handle, blt->bb.size, blt->driver);
-
-	igt_assert(bb_pos + sizeof(data) < blt->bb.size);
+	igt_assert(bb_pos + sizeof(data) < bb_size);
 	memcpy(bb + bb_pos, &data, sizeof(data));
 	bb_pos += sizeof(data);
 
-	if (emit_bbe) {
-		igt_assert(bb_pos + sizeof(uint32_t) < blt->bb.size);
-		memcpy(bb + bb_pos, &bbe, sizeof(bbe));
-		bb_pos += sizeof(uint32_t);
-	}
-
 	if (blt->print_bb) {
 		igt_info("[FAST COPY]\n");
 		igt_info("src offset: %" PRIx64 ", dst offset: %" PRIx64
@@ -1730,6 +1729,50 @@ uint64_t emit_blt_fast_copy(int fd,
 		dump_bb_fast_cmd(&data);
 	}
 
+	return bb_pos;
+}
+
+/**
+ * emit_blt_fast_copy:
+ * @fd: drm fd
+ * @ahnd: allocator handle
+ * @blt: blitter data for fast-copy (same as for block-copy but doesn't use
+ * compression fields).
+ * @bb_pos: position at which insert block copy commands
+ * @emit_bbe: emit MI_BATCH_BUFFER_END after fast-copy or not
+ *
+ * Function emits fast-copy blit between @src and @dst described in @blt object
+ * at @bb_pos. Allows concatenating with other commands to
+ * achieve pipelining.
+ *
+ * Returns:
+ * Next write position in batch.
+ */
+uint64_t emit_blt_fast_copy(int fd,
+			    uint64_t ahnd,
+			    const struct blt_copy_data *blt,
+			    uint64_t bb_pos,
+			    bool emit_bbe)
+{
+	uint64_t dst_offset, src_offset, bb_offset;
+	uint8_t *bb;
+
+	src_offset = get_offset_pat_index(ahnd, blt->src.handle, blt->src.size,
+					  0, blt->src.pat_index);
+	src_offset += blt->src.plane_offset;
+	dst_offset = get_offset_pat_index(ahnd, blt->dst.handle, blt->dst.size, 0,
+					  blt->dst.pat_index);
+	dst_offset += blt->dst.plane_offset;
+	bb_offset = get_offset(ahnd, blt->bb.handle, blt->bb.size, 0);
+
+	bb = bo_map(fd, blt->bb.handle, blt->bb.size, blt->driver);
+
+	bb_pos = __emit_fast_copy(intel_get_drm_devid(fd), blt,
+				  src_offset, dst_offset, bb_offset,
+				  bb, blt->bb.size, bb_pos);
+	if (emit_bbe)
+		bb_pos = __emit_bbe(bb, blt->bb.size, bb_pos);
+
 	munmap(bb, blt->bb.size);
 
 	return bb_pos;
@@ -1915,10 +1958,9 @@ void blt_mem_copy_init(int fd, struct blt_mem_copy_data *mem,
 	mem->copy_type = copy_type;
 }
 
-static void dump_bb_mem_copy_cmd(int fd, struct xe_mem_copy_data *data)
+static void dump_bb_mem_copy_cmd(uint32_t devid, struct xe_mem_copy_data *data)
 {
 	uint32_t *cmd = (uint32_t *) data;
-	uint32_t devid = intel_get_drm_devid(fd);
 
 	igt_info("BB details:\n");
 
@@ -1963,16 +2005,14 @@ static void dump_bb_mem_copy_cmd(int fd, struct xe_mem_copy_data *data)
 	}
 }
 
-static uint64_t emit_blt_mem_copy(int fd, uint64_t ahnd,
-				  const struct blt_mem_copy_data *mem,
-				  uint64_t bb_pos, bool emit_bbe)
+static uint64_t __emit_mem_copy(uint32_t devid,
+				const struct blt_mem_copy_data *mem,
+				uint64_t src_offset, uint64_t dst_offset,
+				uint8_t *bb, uint64_t bb_size, uint64_t bb_pos)
 {
 	struct xe_mem_copy_data data = {};
-	uint64_t dst_offset, src_offset, shift;
+	uint64_t shift;
 	uint32_t width, height, width_max, height_max, remain;
-	uint32_t bbe = MI_BATCH_BUFFER_END;
-	uint32_t *bb;
-	uint32_t devid = intel_get_drm_devid(fd);
 
 	if (mem->mode == MODE_BYTE) {
 		data.dw01.byte_copy.width = -1;
@@ -1985,13 +2025,6 @@ static uint64_t emit_blt_mem_copy(int fd, uint64_t ahnd,
 		shift = width_max << 8;
 	}
 
-	src_offset = get_offset_pat_index(ahnd, mem->src.handle, mem->src.size,
-					  0, mem->src.pat_index);
-	dst_offset = get_offset_pat_index(ahnd, mem->dst.handle, mem->dst.size,
-					  0, mem->dst.pat_index);
-
-	bb = bo_map(fd, mem->bb.handle, mem->bb.size, mem->driver);
-
 	width = mem->src.width;
 	height = mem->dst.height;
 
@@ -2037,13 +2070,13 @@ static uint64_t emit_blt_mem_copy(int fd, uint64_t ahnd,
 		data.dw03.src_pitch = mem->src.pitch - 1;
 		data.dw04.dst_pitch = mem->dst.pitch - 1;
 
-		igt_assert(bb_pos + sizeof(data) < mem->bb.size);
+		igt_assert(bb_pos + sizeof(data) < bb_size);
 		memcpy(bb + bb_pos, &data, sizeof(data));
 		bb_pos += sizeof(data);
 
 		if (mem->print_bb) {
 			igt_info("[MEM COPY]\n");
-			dump_bb_mem_copy_cmd(fd, &data);
+			dump_bb_mem_copy_cmd(devid, &data);
 		}
 	} else {
 		remain = mem->src.width;
@@ -2062,7 +2095,7 @@ static uint64_t emit_blt_mem_copy(int fd, uint64_t ahnd,
 		while (remain) {
 			data.dw01.val = min_t(uint32_t, width_max, remain) - 1;
 
-			igt_assert(bb_pos + sizeof(data) < mem->bb.size);
+			igt_assert(bb_pos + sizeof(data) < bb_size);
 			memcpy(bb + bb_pos, &data, sizeof(data));
 			bb_pos += sizeof(data);
 
@@ -2077,16 +2110,33 @@ static uint64_t emit_blt_mem_copy(int fd, uint64_t ahnd,
 
 			if (mem->print_bb) {
 				igt_info("[MEM COPY]\n");
-				dump_bb_mem_copy_cmd(fd, &data);
+				dump_bb_mem_copy_cmd(devid, &data);
 			}
 		}
 	}
 
-	if (emit_bbe) {
-		igt_assert(bb_pos + sizeof(uint32_t) < mem->bb.size);
-		memcpy(bb + bb_pos, &bbe, sizeof(bbe));
-		bb_pos += sizeof(uint32_t);
-	}
+	return bb_pos;
+}
+
+static uint64_t emit_blt_mem_copy(int fd, uint64_t ahnd,
+				  const struct blt_mem_copy_data *mem,
+				  uint64_t bb_pos, bool emit_bbe)
+{
+	uint64_t dst_offset, src_offset;
+	uint8_t *bb;
+
+	src_offset = get_offset_pat_index(ahnd, mem->src.handle, mem->src.size,
+					  0, mem->src.pat_index);
+	dst_offset = get_offset_pat_index(ahnd, mem->dst.handle, mem->dst.size,
+					  0, mem->dst.pat_index);
+
+	bb = bo_map(fd, mem->bb.handle, mem->bb.size, mem->driver);
+
+	bb_pos = __emit_mem_copy(intel_get_drm_devid(fd), mem,
+				 src_offset, dst_offset,
+				 bb, mem->bb.size, bb_pos);
+	if (emit_bbe)
+		bb_pos = __emit_bbe(bb, mem->bb.size, bb_pos);
 
 	munmap(bb, mem->bb.size);
 
@@ -2169,20 +2219,15 @@ void blt_mem_set_init(int fd, struct blt_mem_set_data *mem,
 	mem->fill_type = fill_type;
 }
 
-static void emit_blt_mem_set(int fd, uint64_t ahnd,
-			     const struct blt_mem_set_data *mem,
-			     uint8_t fill_data)
+static uint64_t __emit_mem_set(uint32_t devid,
+			       const struct blt_mem_set_data *mem,
+			       uint64_t dst_offset, uint8_t fill_data,
+			       uint8_t *bb, uint64_t bb_size, uint64_t bb_pos)
 {
-	uint64_t dst_offset;
-	int b;
-	uint32_t *batch;
+	uint32_t batch[7];
 	uint32_t value;
-	uint32_t devid = intel_get_drm_devid(fd);
-
-	dst_offset = get_offset_pat_index(ahnd, mem->dst.handle, mem->dst.size,
-					  0, mem->dst.pat_index);
+	int b;
 
-	batch = bo_map(fd, mem->bb.handle, mem->bb.size, mem->driver);
 	value = (uint32_t)fill_data << 24;
 
 	b = 0;
@@ -2191,16 +2236,35 @@ static void emit_blt_mem_set(int fd, uint64_t ahnd,
 	batch[b++] = mem->dst.height - 1;
 	batch[b++] = mem->dst.pitch - 1;
 	batch[b++] = dst_offset;
-	batch[b++] = dst_offset << 32;
+	batch[b++] = dst_offset >> 32;
 	if (intel_graphics_ver(devid) >= IP_VER(20, 0))
 		batch[b++] = value | (mem->dst.mocs_index << 3);
 	else
 		batch[b++] = value | mem->dst.mocs_index;
 
-	batch[b++] = MI_BATCH_BUFFER_END;
+	igt_assert(bb_pos + sizeof(batch) < bb_size);
+	memcpy(bb + bb_pos, batch, sizeof(batch));
+
+	return bb_pos + sizeof(batch);
+}
 
-	munmap(batch, mem->bb.size);
+static void emit_blt_mem_set(int fd, uint64_t ahnd,
+			     const struct blt_mem_set_data *mem,
+			     uint8_t fill_data)
+{
+	uint64_t dst_offset, bb_pos;
+	uint8_t *bb;
 
+	dst_offset = get_offset_pat_index(ahnd, mem->dst.handle, mem->dst.size,
+					  0, mem->dst.pat_index);
+
+	bb = bo_map(fd, mem->bb.handle, mem->bb.size, mem->driver);
+
+	bb_pos = __emit_mem_set(intel_get_drm_devid(fd), mem, dst_offset,
+				fill_data, bb, mem->bb.size, 0);
+	__emit_bbe(bb, mem->bb.size, bb_pos);
+
+	munmap(bb, mem->bb.size);
 }
 /**
  * blt_mem_set:
@@ -2254,6 +2318,461 @@ int blt_mem_set(int fd, const intel_ctx_t *ctx,
 	return ret;
 }
 
+/*
+ * Blitter stream: the batch is created and mapped once, operations are
+ * appended to it and a single submission executes all of them. Objects
+ * touched since the last MI_FLUSH_DW are tracked, and a flush is inserted
+ * only when an operation depends on a previous one (read or write after
+ * write, write after read).
+ */
+
+#define BLT_STREAM_SCRATCH_SIZE		SZ_16K
+#define BLT_STREAM_FLUSH_SIZE		(4 * sizeof(uint32_t))
+#define BLT_STREAM_BBE_SIZE		(2 * sizeof(uint32_t))
+
+static uint64_t stream_offset(struct blt_stream *s, uint32_t handle,
+			      uint64_t size, uint64_t alignment,
+			      uint8_t pat_index)
+{
+	return get_offset_pat_index(s->ahnd, handle, size, alignment, pat_index);
+}
+
+static int stream_exec(struct blt_stream *s)
+{
+	struct drm_i915_gem_execbuffer2 execbuf = {};
+	struct drm_i915_gem_exec_object2 *obj;
+	int ret;
+
+	if (s->driver == INTEL_DRIVER_XE) {
+		ret = __intel_ctx_xe_exec(s->ctx, s->ahnd, CANONICAL(s->bb_offset));
+		if (!ret && s->ctx->sync_bind && s->ctx->sync_out)
+			ret = syncobj_wait_err(s->fd, (uint32_t *)&s->ctx->sync_out,
+					       1, INT64_MAX, 0);
+
+		return ret;
+	}
+
+	obj = calloc(s->num_objs + 1, sizeof(*obj));
+	igt_assert(obj);
+
+	for (int i = 0; i < s->num_objs; i++) {
+		obj[i].handle = s->objs[i].handle;
+		obj[i].offset = CANONICAL(s->objs[i].offset);
+		obj[i].flags = EXEC_OBJECT_PINNED | EXEC_OBJECT_SUPPORTS_48B_ADDRESS;
+		if (s->objs[i].write)
+			obj[i].flags |= EXEC_OBJECT_WRITE;
+	}
+	obj[s->num_objs].handle = s->bb.handle;
+	obj[s->num_objs].offset = CANONICAL(s->bb_offset);
+	obj[s->num_objs].flags = EXEC_OBJECT_PINNED | EXEC_OBJECT_SUPPORTS_48B_ADDRESS;
+
+	execbuf.buffer_count = s->num_objs + 1;
+	execbuf.buffers_ptr = to_user_pointer(obj);
+	execbuf.rsvd1 = s->ctx ? s->ctx->id : 0;
+	execbuf.flags = s->e ? s->e->flags : I915_EXEC_BLT;
+
+	ret = __gem_execbuf(s->fd, &execbuf);
+	if (!ret)
+		gem_sync(s->fd, s->bb.handle);
+
+	free(obj);
+
+	return ret;
+}
+
+static const struct blt_stream_ops stream_ops = {
+	.offset = stream_offset,
+	.exec = stream_exec,
+};
+
+/**
+ * __blt_stream_create:
+ * @devid: device id the commands are encoded for
+ * @driver: INTEL_DRIVER_I915 or INTEL_DRIVER_XE
+ * @batch: CPU mapping of the batch
+ * @size: size of @batch in bytes
+ * @batch_offset: GPU address of @batch
+ * @ops: backend resolving object addresses and executing the batch
+ * @priv: backend private data
+ *
+ * Creates a stream writing to a caller provided batch. Allows exercising
+ * the command encoding without a device, blt_stream_create() should be
+ * used otherwise.
+ *
+ * Returns: a new stream, to be released with blt_stream_destroy().
+ */
+struct blt_stream *__blt_stream_create(uint32_t devid, enum intel_driver driver,
+				       void *batch, uint64_t size,
+				       uint64_t batch_offset,
+				       const struct blt_stream_ops *ops,
+				       void *priv)
+{
+	struct blt_stream *s;
+
+	igt_assert(batch && ops && ops->offset && ops->exec);
+	igt_assert(size > BLT_STREAM_FLUSH_SIZE + BLT_STREAM_BBE_SIZE);
+
+	s = calloc(1, sizeof(*s));
+	igt_assert(s);
+
+	s->fd = -1;
+	s->driver = driver;
+	s->devid = devid;
+	s->ops = ops;
+	s->priv = priv;
+	s->ptr = batch;
+	s->bb.size = size;
+	s->bb_offset = batch_offset;
+
+	s->scratch = malloc(BLT_STREAM_SCRATCH_SIZE);
+	igt_assert(s->scratch);
+
+	return s;
+}
+
+/**
+ * blt_stream_create:
+ * @fd: drm fd
+ * @ctx: intel_ctx_t context
+ * @e: blitter engine for @ctx
+ * @ahnd: allocator handle
+ * @region: memory region of the batch
+ * @bb_size: size of the batch
+ *
+ * Creates a batch in @region and maps it for the lifetime of the stream.
+ * Blits queued with blt_stream_block_copy() and friends are executed by
+ * blt_stream_flush(), or earlier when the batch runs out of space.
+ *
+ * Returns: a new stream, to be released with blt_stream_destroy().
+ */
+struct blt_stream *blt_stream_create(int fd, const intel_ctx_t *ctx,
+				     const struct intel_execution_engine2 *e,
+				     uint64_t ahnd, uint32_t region,
+				     uint64_t bb_size)
+{
+	enum intel_driver driver = get_intel_driver(fd);
+	struct blt_stream *s;
+	uint32_t handle;
+	uint64_t offset;
+	void *ptr;
+
+	igt_assert_f(ahnd, "blitter stream supports softpin only\n");
+	igt_assert_f(ctx || driver == INTEL_DRIVER_I915,
+		     "blitter stream requires a context on xe\n");
+
+	if (driver == INTEL_DRIVER_XE) {
+		bb_size = xe_bb_size(fd, bb_size);
+		handle = xe_bo_create(fd, 0, bb_size, region, 0);
+	} else {
+		bb_size = ALIGN(bb_size, 4096);
+		handle = gem_create_in_memory_regions(fd, bb_size, region);
+	}
+
+	offset = get_offset(ahnd, handle, bb_size, 0);
+	ptr = bo_map(fd, handle, bb_size, driver);
+
+	s = __blt_stream_create(intel_get_drm_devid(fd), driver, ptr, bb_size,
+				offset, &stream_ops, NULL);
+	s->fd = fd;
+	s->ctx = ctx;
+	s->e = e;
+	s->ahnd = ahnd;
+	blt_set_batch(&s->bb, handle, bb_size, region);
+
+	return s;
+}
+
+/**
+ * blt_stream_destroy:
+ * @s: blitter stream
+ *
+ * Executes the pending blits and releases the stream.
+ */
+void blt_stream_destroy(struct blt_stream *s)
+{
+	if (!s)
+		return;
+
+	igt_assert_eq(blt_stream_flush(s), 0);
+
+	igt_debug("blt stream: %" PRIu64 " ops, %" PRIu64 " flushes, %"
+		  PRIu64 " submits\n",
+		  s->stats.ops, s->stats.flushes, s->stats.submits);
+
+	if (s->fd >= 0) {
+		munmap(s->ptr, s->bb.size);
+		put_offset(s->ahnd, s->bb.handle);
+		gem_close(s->fd, s->bb.handle);
+	}
+
+	free(s->scratch);
+	free(s->objs);
+	free(s);
+}
+
+static struct blt_stream_obj *stream_obj(struct blt_stream *s, uint32_t handle)
+{
+	for (int i = 0; i < s->num_objs; i++)
+		if (s->objs[i].handle == handle)
+			return &s->objs[i];
+
+	return NULL;
+}
+
+static void stream_add(struct blt_stream *s, uint32_t handle, uint64_t offset)
+{
+	struct blt_stream_obj *obj;
+
+	if (stream_obj(s, handle))
+		return;
+
+	if (s->num_objs == s->max_objs) {
+		s->max_objs = s->max_objs ? 2 * s->max_objs : 16;
+		s->objs = realloc(s->objs, s->max_objs * sizeof(*s->objs));
+		igt_assert(s->objs);
+	}
+
+	obj = &s->objs[s->num_objs++];
+	memset(obj, 0, sizeof(*obj));
+	obj->handle = handle;
+	obj->offset = offset;
+}
+
+static uint64_t stream_use(struct blt_stream *s, uint32_t handle,
+			   uint64_t size, uint64_t alignment,
+			   uint8_t pat_index)
+{
+	struct blt_stream_obj *obj = stream_obj(s, handle);
+	uint64_t offset;
+
+	if (obj)
+		return obj->offset;
+
+	offset = s->ops->offset(s, handle, size, alignment, pat_index);
+	stream_add(s, handle, offset);
+
+	return offset;
+}
+
+static bool stream_hazard(struct blt_stream *s, uint32_t src, uint32_t dst)
+{
+	struct blt_stream_obj *obj;
+
+	obj = src ? stream_obj(s, src) : NULL;
+	if (obj && obj->written)
+		return true;
+
+	obj = stream_obj(s, dst);
+
+	return obj->read || obj->written;
+}
+
+static void stream_emit_flush(struct blt_stream *s)
+{
+	uint32_t flush[4] = { MI_FLUSH_DW_CMD | 2, };
+
+	memcpy(s->ptr + s->pos, flush, sizeof(flush));
+	s->pos += sizeof(flush);
+
+	for (int i = 0; i < s->num_objs; i++)
+		s->objs[i].read = s->objs[i].written = false;
+
+	s->stats.flushes++;
+}
+
+/*
+ * Appends @len bytes of commands from the scratch buffer. The batch is
+ * submitted first if they don't fit, and a flush separates them from a
+ * previous blit touching the same objects. Room for a flush and the batch
+ * end is always kept.
+ */
+static void stream_commit(struct blt_stream *s, uint64_t len,
+			  uint32_t src, uint64_t src_offset,
+			  uint32_t dst, uint64_t dst_offset)
+{
+	uint64_t avail = s->bb.size - BLT_STREAM_FLUSH_SIZE - BLT_STREAM_BBE_SIZE;
+
+	igt_assert_f(len <= avail, "blit doesn't fit in the stream batch\n");
+
+	if (s->pos + len > avail) {
+		igt_assert_eq(blt_stream_flush(s), 0);
+		if (src)
+			stream_add(s, src, src_offset);
+		stream_add(s, dst, dst_offset);
+	}
+
+	if (stream_hazard(s, src, dst))
+		stream_emit_flush(s);
+
+	memcpy(s->ptr + s->pos, s->scratch, len);
+	s->pos += len;
+
+	if (src)
+		stream_obj(s, src)->read = true;
+	stream_obj(s, dst)->written = true;
+	stream_obj(s, dst)->write = true;
+
+	s->stats.ops++;
+}
+
+/**
+ * blt_stream_block_copy:
+ * @s: blitter stream
+ * @blt: blitter data for block-copy, batch fields are ignored
+ * @ext: extended blitter data (for DG2+, used for flatccs compression)
+ *
+ * Queues a block-copy blit in @s.
+ */
+void blt_stream_block_copy(struct blt_stream *s,
+			   const struct blt_copy_data *blt,
+			   const struct blt_block_copy_data_ext *ext)
+{
+	uint64_t src_offset, dst_offset, len;
+
+	src_offset = stream_use(s, blt->src.handle, blt->src.size, 0,
+				blt->src.pat_index);
+	dst_offset = stream_use(s, blt->dst.handle, blt->dst.size, 0,
+				blt->dst.pat_index);
+
+	len = __emit_block_copy(s->devid, blt, ext,
+				src_offset + blt->src.plane_offset,
+				dst_offset + blt->dst.plane_offset,
+				s->bb_offset, s->scratch,
+				BLT_STREAM_SCRATCH_SIZE, 0);
+
+	stream_commit(s, len, blt->src.handle, src_offset,
+		      blt->dst.handle, dst_offset);
+}
+
+/**
+ * blt_stream_fast_copy:
+ * @s: blitter stream
+ * @blt: blitter data for fast-copy, batch fields are ignored
+ *
+ * Queues a fast-copy blit in @s.
+ */
+void blt_stream_fast_copy(struct blt_stream *s,
+			  const struct blt_copy_data *blt)
+{
+	uint64_t src_offset, dst_offset, len;
+
+	src_offset = stream_use(s, blt->src.handle, blt->src.size, 0,
+				blt->src.pat_index);
+	dst_offset = stream_use(s, blt->dst.handle, blt->dst.size, 0,
+				blt->dst.pat_index);
+
+	len = __emit_fast_copy(s->devid, blt,
+			       src_offset + blt->src.plane_offset,
+			       dst_offset + blt->dst.plane_offset,
+			       s->bb_offset, s->scratch,
+			       BLT_STREAM_SCRATCH_SIZE, 0);
+
+	stream_commit(s, len, blt->src.handle, src_offset,
+		      blt->dst.handle, dst_offset);
+}
+
+/**
+ * blt_stream_ctrl_surf_copy:
+ * @s: blitter stream
+ * @surf: blitter data for ctrl-surf-copy, batch fields are ignored
+ *
+ * Queues a ctrl-surf-copy blit in @s.
+ */
+void blt_stream_ctrl_surf_copy(struct blt_stream *s,
+			       const struct blt_ctrl_surf_copy_data *surf)
+{
+	uint64_t src_offset, dst_offset, len;
+
+	src_offset = stream_use(s, surf->src.handle, surf->src.size, 1ull << 16,
+				surf->src.pat_index);
+	dst_offset = stream_use(s, surf->dst.handle, surf->dst.size, 1ull << 16,
+				surf->dst.pat_index);
+
+	len = __emit_ctrl_surf_copy(s->devid, surf, src_offset, dst_offset,
+				    s->bb_offset, s->scratch,
+				    BLT_STREAM_SCRATCH_SIZE, 0);
+
+	stream_commit(s, len, surf->src.handle, src_offset,
+		      surf->dst.handle, dst_offset);
+}
+
+/**
+ * blt_stream_mem_copy:
+ * @s: blitter stream
+ * @mem: mem-copy data, batch fields are ignored
+ *
+ * Queues a mem-copy blit in @s.
+ */
+void blt_stream_mem_copy(struct blt_stream *s,
+			 const struct blt_mem_copy_data *mem)
+{
+	uint64_t src_offset, dst_offset, len;
+
+	src_offset = stream_use(s, mem->src.handle, mem->src.size, 0,
+				mem->src.pat_index);
+	dst_offset = stream_use(s, mem->dst.handle, mem->dst.size, 0,
+				mem->dst.pat_index);
+
+	len = __emit_mem_copy(s->devid, mem, src_offset, dst_offset,
+			      s->scratch, BLT_STREAM_SCRATCH_SIZE, 0);
+
+	stream_commit(s, len, mem->src.handle, src_offset,
+		      mem->dst.handle, dst_offset);
+}
+
+/**
+ * blt_stream_mem_set:
+ * @s: blitter stream
+ * @mem: mem-set data, batch fields are ignored
+ * @fill_data: byte written to the destination
+ *
+ * Queues a mem-set blit in @s.
+ */
+void blt_stream_mem_set(struct blt_stream *s,
+			const struct blt_mem_set_data *mem,
+			uint8_t fill_data)
+{
+	uint64_t dst_offset, len;
+
+	dst_offset = stream_use(s, mem->dst.handle, mem->dst.size, 0,
+				mem->dst.pat_index);
+
+	len = __emit_mem_set(s->devid, mem, dst_offset, fill_data,
+			     s->scratch, BLT_STREAM_SCRATCH_SIZE, 0);
+
+	stream_commit(s, len, 0, 0, mem->dst.handle, dst_offset);
+}
+
+/**
+ * blt_stream_flush:
+ * @s: blitter stream
+ *
+ * Terminates the batch, submits it and waits for completion. Objects used
+ * by the stream keep their addresses, so they may be used with the
+ * allocator handle of the stream afterwards.
+ *
+ * Returns: 0 on success or the error returned by the submission.
+ */
+int blt_stream_flush(struct blt_stream *s)
+{
+	uint32_t bbe[2] = { MI_BATCH_BUFFER_END, MI_NOOP };
+	int ret;
+
+	if (!s->pos)
+		return 0;
+
+	memcpy(s->ptr + s->pos, bbe, sizeof(bbe));
+	s->pos += sizeof(bbe);
+
+	ret = s->ops->exec(s);
+
+	s->pos = 0;
+	s->num_objs = 0;
+	s->stats.submits++;
+
+	return ret;
+}
+
 void blt_set_geom(struct blt_copy_object *obj, uint32_t pitch,
 		  int16_t x1, int16_t y1, int16_t x2, int16_t y2,
 		  uint16_t x_offset, uint16_t y_offset)
@@ -42,6 +42,15 @@
  * fast-copy copy (like compression) and command which use this exclusively
  * is annotated in the comment.
  *
+ * # Streams
+ *
+ * Each blt_*() call above creates its own submission and the emit_blt_*()
+ * helpers map the batch for every command. When many blits are issued
+ * back to back, a struct blt_stream keeps one batch mapped and collects
+ * the blits queued with blt_stream_*() into a single submission. A
+ * MI_FLUSH_DW is inserted only between blits sharing an object where at
+ * least one of them writes it.
+ *
  */
 
 #include <errno.h>
@@ -291,6 +300,75 @@ int blt_mem_set(int fd, const intel_ctx_t *ctx,
 			const struct intel_execution_engine2 *e, uint64_t ahnd,
 			const struct blt_mem_set_data *mem, uint8_t fill_data);
 
+struct blt_stream;
+
+struct blt_stream_ops {
+	uint64_t (*offset)(struct blt_stream *s, uint32_t handle, uint64_t size,
+			   uint64_t alignment, uint8_t pat_index);
+	int (*exec)(struct blt_stream *s);
+};
+
+struct blt_stream_obj {
+	uint32_t handle;
+	uint64_t offset;
+	bool read;	/* since the last flush */
+	bool written;	/* since the last flush */
+	bool write;	/* in the pending submission */
+};
+
+struct blt_stream {
+	int fd;
+	enum intel_driver driver;
+	uint32_t devid;
+	const intel_ctx_t *ctx;
+	const struct intel_execution_engine2 *e;
+	uint64_t ahnd;
+
+	const struct blt_stream_ops *ops;
+	void *priv;
+
+	struct blt_copy_batch bb;
+	uint64_t bb_offset;
+	uint8_t *ptr;
+	uint64_t pos;
+
+	/* objects used by the pending submission */
+	struct blt_stream_obj *objs;
+	int num_objs, max_objs;
+
+	uint8_t *scratch;
+
+	struct {
+		uint64_t ops;
+		uint64_t flushes;
+		uint64_t submits;
+	} stats;
+};
+
+struct blt_stream *__blt_stream_create(uint32_t devid, enum intel_driver driver,
+				       void *batch, uint64_t size,
+				       uint64_t batch_offset,
+				       const struct blt_stream_ops *ops,
+				       void *priv);
+struct blt_stream *blt_stream_create(int fd, const intel_ctx_t *ctx,
+				     const struct intel_execution_engine2 *e,
+				     uint64_t ahnd, uint32_t region,
+				     uint64_t bb_size);
+void blt_stream_destroy(struct blt_stream *s);
+void blt_stream_block_copy(struct blt_stream *s,
+			   const struct blt_copy_data *blt,
+			   const struct blt_block_copy_data_ext *ext);
+void blt_stream_fast_copy(struct blt_stream *s,
+			  const struct blt_copy_data *blt);
+void blt_stream_ctrl_surf_copy(struct blt_stream *s,
+			       const struct blt_ctrl_surf_copy_data *surf);
+void blt_stream_mem_copy(struct blt_stream *s,
+			 const struct blt_mem_copy_data *mem);
+void blt_stream_mem_set(struct blt_stream *s,
+			const struct blt_mem_set_data *mem,
+			uint8_t fill_data);
+int blt_stream_flush(struct blt_stream *s);
+
 void blt_set_geom(struct blt_copy_object *obj, uint32_t pitch,
 		  int16_t x1, int16_t y1, int16_t x2, int16_t y2,
 		  uint16_t x_offset, uint16_t y_offset);
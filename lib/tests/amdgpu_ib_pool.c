@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright 2026 Advanced Micro Devices, Inc.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drmtest.h"
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+#include "lib/amdgpu/amd_ib_pool.h"
+#include "lib/amdgpu/amd_ip_blocks.h"
+
+IGT_TEST_DESCRIPTION("Check the amdgpu IB pool fence retirement and IB recycling against a fake ring");
+
+#define POOL_SIZE 4096
+#define MC_BASE 0x100000ull
+#define MAX_JOBS 4096
+#define MAX_RINGS 4
+
+struct job {
+	uint64_t start, end;	/* GPU address range of the IB */
+	uint64_t seq_no;	/* per ring */
+	int ring;
+	bool done;
+};
+
+/* Submissions only complete when the test says so, or when waited for */
+struct fake {
+	uint8_t *cpu;
+	struct job jobs[MAX_JOBS];
+	int num_jobs;
+	uint64_t ring_seq[MAX_RINGS];
+	int blocking_waits;
+	int in_flight_max;
+};
+
+static struct job *find_job(struct fake *f, int ring, uint64_t seq_no)
+{
+	for (int i = 0; i < f->num_jobs; i++)
+		if (f->jobs[i].ring == ring && f->jobs[i].seq_no == seq_no)
+			return &f->jobs[i];
+
+	igt_assert_f(0, "no job %"PRIu64" on ring %d\n", seq_no, ring);
+	return NULL;
+}
+
+static int fake_submit(struct amdgpu_ib_pool *pool,
+		       struct amdgpu_ring_context *ring_context)
+{
+	struct amdgpu_cs_ib_info *ib = &ring_context->ib_info;
+	struct fake *f = pool->priv;
+	struct job *job;
+	int in_flight = 0;
+
+	igt_assert(f->num_jobs < MAX_JOBS);
+	job = &f->jobs[f->num_jobs++];
+	job->ring = ring_context->ibs_request.ring;
+	job->start = ib->ib_mc_address;
+	job->end = ib->ib_mc_address + ib->size * 4;
+	job->seq_no = ++f->ring_seq[job->ring];
+	ring_context->ibs_request.seq_no = job->seq_no;
+
+	/* the IB holds the stream, and nothing in flight uses its range */
+	igt_assert(job->start >= MC_BASE && job->end <= MC_BASE + POOL_SIZE);
+	igt_assert(!memcmp(f->cpu + (job->start - MC_BASE), ring_context->pm4,
+			   ib->size * 4));
+	for (int i = 0; i < f->num_jobs - 1; i++) {
+		struct job *other = &f->jobs[i];
+
+		if (other->done)
+			continue;
+
+		in_flight++;
+		igt_assert_f(job->end <= other->start || other->end <= job->start,
+			     "IB [%"PRIx64", %"PRIx64") reused while in flight\n",
+			     other->start, other->end);
+	}
+	f->in_flight_max = max(f->in_flight_max, in_flight + 1);
+
+	return 0;
+}
+
+static int fake_query(struct amdgpu_ib_pool *pool, struct amdgpu_cs_fence *fence,
+		      uint64_t timeout_ns, uint32_t *expired)
+{
+	struct fake *f = pool->priv;
+	struct job *job = find_job(f, fence->ring, fence->fence);
+
+	/* waiting lets the ring run until the job is done */
+	if (!job->done && timeout_ns) {
+		job->done = true;
+		f->blocking_waits++;
+	}
+	*expired = job->done;
+
+	return 0;
+}
+
+static const struct amdgpu_ib_pool_ops fake_ops = {
+	.submit = fake_submit,
+	.query = fake_query,
+};
+
+static struct amdgpu_ib_pool *fake_pool(struct fake *f, unsigned int depth)
+{
+	memset(f, 0, sizeof(*f));
+	f->cpu = calloc(1, POOL_SIZE);
+	igt_assert(f->cpu);
+
+	return __amdgpu_ib_pool_create(f->cpu, MC_BASE, POOL_SIZE, depth,
+				       &fake_ops, f);
+}
+
+static void fake_pool_destroy(struct amdgpu_ib_pool *pool, struct fake *f)
+{
+	amdgpu_ib_pool_destroy(pool);
+	for (int i = 0; i < f->num_jobs; i++)
+		igt_assert(f->jobs[i].done);
+	free(f->cpu);
+}
+
+static uint64_t submit(struct amdgpu_ib_pool *pool, struct amdgpu_ring_context *rc,
+		       int ring, int dwords, uint32_t tag)
+{
+	for (int i = 0; i < dwords; i++)
+		rc->pm4[i] = tag + i;
+	rc->pm4_dw = dwords;
+	rc->ring_id = ring;
+
+	return amdgpu_ib_pool_submit(pool, AMDGPU_HW_IP_GFX, rc);
+}
+
+static struct amdgpu_ring_context *ring_context(void)
+{
+	struct amdgpu_ring_context *rc = calloc(1, sizeof(*rc));
+
+	igt_assert(rc);
+	rc->pm4 = calloc(POOL_SIZE / 4, sizeof(*rc->pm4));
+	igt_assert(rc->pm4);
+
+	return rc;
+}
+
+static void ring_context_free(struct amdgpu_ring_context *rc)
+{
+	free(rc->pm4);
+	free(rc);
+}
+
+static void test_retire_order(void)
+{
+	struct amdgpu_ring_context *rc = ring_context();
+	struct amdgpu_ib_pool *pool;
+	uint64_t seqno[4];
+	struct fake f;
+
+	pool = fake_pool(&f, 8);
+
+	/* alternating rings, completing out of submission order */
+	for (int i = 0; i < ARRAY_SIZE(seqno); i++)
+		seqno[i] = submit(pool, rc, i % 2, 16, i << 8);
+
+	f.jobs[1].done = true;
+	f.jobs[3].done = true;
+	igt_assert_eq(amdgpu_ib_pool_wait(pool, seqno[1]), 0);
+	igt_assert_eq(amdgpu_ib_pool_wait(pool, seqno[3]), 0);
+	igt_assert_eq(f.blocking_waits, 0);
+
+	/* the pool only retires in order, as ring 0 is still busy */
+	igt_assert_eq(pool->completed, 0);
+
+	f.jobs[0].done = true;
+	igt_assert_eq(amdgpu_ib_pool_wait(pool, seqno[0]), 0);
+	igt_assert_eq(pool->completed, 2);
+
+	igt_assert_eq(amdgpu_ib_pool_wait(pool, seqno[2]), 0);
+	igt_assert_eq(f.blocking_waits, 1);
+	igt_assert_eq(pool->completed, 4);
+
+	fake_pool_destroy(pool, &f);
+	ring_context_free(rc);
+}
+
+static void test_wait_old(void)
+{
+	struct amdgpu_ring_context *rc = ring_context();
+	struct amdgpu_ib_pool *pool;
+	uint64_t first;
+	struct fake f;
+
+	pool = fake_pool(&f, 1);
+
+	/* far more submissions than fence slots */
+	first = submit(pool, rc, 0, 16, 0);
+	for (int i = 1; i < 4 * pool->max_fences; i++)
+		submit(pool, rc, 0, 16, i << 8);
+
+	/* completed long ago, its slot reused many times */
+	igt_assert_eq(amdgpu_ib_pool_wait(pool, first), 0);
+
+	fake_pool_destroy(pool, &f);
+	ring_context_free(rc);
+}
+
+static void test_depth(void)
+{
+	struct amdgpu_ring_context *rc = ring_context();
+	struct amdgpu_ib_pool *pool;
+	struct fake f;
+
+	pool = fake_pool(&f, 3);
+
+	for (int i = 0; i < 100; i++)
+		submit(pool, rc, 0, 16, i << 8);
+	igt_assert_eq(f.in_flight_max, 3);
+
+	fake_pool_destroy(pool, &f);
+	ring_context_free(rc);
+}
+
+static void test_secure(void)
+{
+	struct amdgpu_ring_context *rc = ring_context();
+	struct amdgpu_ib_pool *pool;
+	struct fake f;
+
+	pool = fake_pool(&f, 4);
+
+	rc->secure = true;
+	submit(pool, rc, 0, 16, 0);
+	igt_assert_eq(rc->ib_info.flags, AMDGPU_IB_FLAGS_SECURE);
+
+	/* the same ring context, no longer secure */
+	rc->secure = false;
+	submit(pool, rc, 0, 16, 0);
+	igt_assert_eq(rc->ib_info.flags, 0);
+
+	fake_pool_destroy(pool, &f);
+	ring_context_free(rc);
+}
+
+/*
+ * IBs of random sizes on random rings, with the GPU completing random jobs
+ * in between: the fake checks no IB range is reused while in flight.
+ */
+static void test_recycle(void)
+{
+	struct amdgpu_ring_context *rc = ring_context();
+	struct amdgpu_ib_pool *pool;
+	uint32_t seed = 0xab;
+	struct fake f;
+
+	pool = fake_pool(&f, 16);
+
+	for (int i = 0; i < 2000; i++) {
+		int dwords = 1 + hars_petruska_f54_1_random(&seed) % 256;
+		int ring = hars_petruska_f54_1_random(&seed) % MAX_RINGS;
+
+		submit(pool, rc, ring, dwords, i << 12);
+
+		for (int j = 0; j < f.num_jobs; j++)
+			if (hars_petruska_f54_1_random(&seed) % 4 == 0)
+				f.jobs[j].done = true;
+
+		igt_assert_lte(pool->seqno - pool->completed, pool->depth);
+	}
+
+	igt_info("%"PRIu64" submits, %"PRIu64" IB waits, %d blocking fence waits\n",
+		 pool->stats.submits, pool->sa.stats.waits, f.blocking_waits);
+	igt_assert(pool->sa.stats.retired > 0);
+
+	igt_assert_eq(amdgpu_ib_pool_sync(pool), 0);
+	igt_assert_eq(pool->completed, pool->seqno);
+
+	fake_pool_destroy(pool, &f);
+	ring_context_free(rc);
+}
+
+igt_main
+{
+	igt_describe("Submissions retire in order, whatever order their rings complete in");
+	igt_subtest("retire-order")
+		test_retire_order();
+
+	igt_describe("Waiting for a long completed submission returns at once");
+	igt_subtest("wait-old")
+		test_wait_old();
+
+	igt_describe("No more submissions than the pool depth are in flight");
+	igt_subtest("depth")
+		test_depth();
+
+	igt_describe("A reused ring context only stays secure while asked for");
+	igt_subtest("secure")
+		test_secure();
+
+	igt_describe("IBs are only recycled once their submission completed");
+	igt_subtest("recycle")
+		test_recycle();
+}
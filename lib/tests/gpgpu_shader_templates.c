@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include "igt_core.h"
+#include "gpgpu_shader.h"
+
+IGT_TEST_DESCRIPTION("Check the generated iga64 patch lists against a full template scan");
+
+#define SUPPORTED_GEN_VER 1200
+#define MAX_ARGS 16
+
+/* The emitter as it was before the generator located the placeholders */
+static void reference_emit(uint32_t *dst, const struct iga64_template *tpl,
+			   int argc, const uint32_t *argv)
+{
+	memcpy(dst, tpl->code, 4 * tpl->size);
+
+	for (int n, i = 0; i < tpl->size; ++i) {
+		if ((dst[i] & IGA64_ARG_MASK) != IGA64_ARG0)
+			continue;
+		n = dst[i] - IGA64_ARG0;
+		igt_assert(n < argc);
+		dst[i] = argv[n];
+	}
+}
+
+static int count_args(const struct iga64_template *tpl, int *placeholders)
+{
+	int argc = 0;
+
+	*placeholders = 0;
+	for (int i = 0; i < tpl->size; i++) {
+		if ((tpl->code[i] & IGA64_ARG_MASK) != IGA64_ARG0)
+			continue;
+		if (tpl->code[i] - IGA64_ARG0 >= argc)
+			argc = tpl->code[i] - IGA64_ARG0 + 1;
+		(*placeholders)++;
+	}
+
+	return argc;
+}
+
+static void check_template(const char *name, const struct iga64_template *tpls,
+			   const struct iga64_template *tpl)
+{
+	struct gpgpu_shader shdr = {
+		.gen_ver = tpl->gen_ver ?: SUPPORTED_GEN_VER,
+		.max_size = 4,
+	};
+	uint32_t argv[MAX_ARGS], *ref;
+	int argc, placeholders;
+	uint32_t size;
+
+	argc = count_args(tpl, &placeholders);
+	igt_assert_lte(argc, MAX_ARGS);
+	igt_assert_f(tpl->num_patches == placeholders,
+		     "%s/%u: %u patches for %d placeholders\n",
+		     name, tpl->gen_ver, tpl->num_patches, placeholders);
+
+	for (int i = 0; i < MAX_ARGS; i++)
+		argv[i] = 0x5a5a0000 | i << 8 | tpl->gen_ver;
+
+	shdr.code = malloc(4 * shdr.max_size);
+	igt_assert(shdr.code);
+	ref = malloc(4 * (2 * tpl->size + 1));
+	igt_assert(ref);
+
+	/* emit twice behind an odd sized prefix to catch offset mistakes */
+	shdr.code[0] = ref[0] = 0xdeadbeef;
+	shdr.size = 1;
+	for (int pass = 0; pass < 2; pass++) {
+		size = __emit_iga64_code(&shdr, tpls, argc, argv);
+		igt_assert_eq_u32(size, tpl->size);
+		reference_emit(ref + 1 + pass * tpl->size, tpl, argc, argv);
+	}
+
+	igt_assert_eq_u32(shdr.size, 2 * tpl->size + 1);
+	igt_assert_f(!memcmp(shdr.code, ref, 4 * shdr.size),
+		     "%s/%u differs from the reference\n", name, tpl->gen_ver);
+
+	free(ref);
+	free(shdr.code);
+}
+
+static void check_table(const struct iga64_template_info *info)
+{
+	int count = 0;
+
+	for (; info->name; info++) {
+		const struct iga64_template *tpl = info->tpls;
+
+		do {
+			check_template(info->name, info->tpls, tpl);
+			count++;
+		} while ((tpl++)->gen_ver);
+	}
+
+	igt_debug("%d templates checked\n", count);
+	igt_assert(count);
+}
+
+igt_main
+{
+	igt_describe("Check gpgpu_shader templates patch like a full scan");
+	igt_subtest("gpgpu-shader")
+		check_table(iga64_templates_gpgpu_shader_c);
+
+	igt_describe("Check gpgpu_fill templates patch like a full scan");
+	igt_subtest("gpgpu-fill")
+		check_table(iga64_templates_gpgpu_fill_c);
+}
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "igt_core.h"
+
+#include "i915/perf_data_reader.h"
+
+IGT_TEST_DESCRIPTION("Check that markers of a fake i915-perf recording are surfaced by the reader");
+
+#define TGL_GT2_DEVID 0x9a49
+#define REPORT_SIZE 256
+
+static void write_record(FILE *f, uint32_t type, const void *data, uint32_t size)
+{
+	struct drm_i915_perf_record_header header = {
+		.type = type,
+		.size = sizeof(header) + size,
+	};
+
+	igt_assert_eq(fwrite(&header, sizeof(header), 1, f), 1);
+	if (size)
+		igt_assert_eq(fwrite(data, size, 1, f), 1);
+}
+
+static void write_preamble(FILE *f)
+{
+	struct intel_perf_record_version version = {
+		.version = INTEL_PERF_RECORD_VERSION,
+	};
+	struct intel_perf_record_device_info info = {
+		.timestamp_frequency = 19200000,
+		.device_id = TGL_GT2_DEVID,
+		.gt_min_frequency = 300000000,
+		.gt_max_frequency = 1100000000,
+		.oa_format = I915_OA_FORMAT_A32u40_A4u32_B8_C8,
+		.metric_set_name = "RenderBasic",
+	};
+	/* 1 slice, 6 subslices of 16 EUs */
+	struct {
+		struct drm_i915_query_topology_info info;
+		uint8_t data[1 + 1 + 6 * 2];
+		uint8_t pad[2];
+	} topology = {
+		.info = {
+			.max_slices = 1,
+			.max_subslices = 6,
+			.max_eus_per_subslice = 16,
+			.subslice_offset = 1,
+			.subslice_stride = 1,
+			.eu_offset = 2,
+			.eu_stride = 2,
+		},
+	};
+
+	memset(topology.data, 0xff, sizeof(topology.data));
+	topology.data[1] = 0x3f;
+
+	write_record(f, INTEL_PERF_RECORD_TYPE_VERSION, &version, sizeof(version));
+	write_record(f, INTEL_PERF_RECORD_TYPE_DEVICE_INFO, &info, sizeof(info));
+	write_record(f, INTEL_PERF_RECORD_TYPE_DEVICE_TOPOLOGY,
+		     &topology, sizeof(topology));
+}
+
+static void write_correlation(FILE *f, uint64_t cpu_ts, uint64_t gpu_ts)
+{
+	struct intel_perf_record_timestamp_correlation corr = {
+		.cpu_timestamp = cpu_ts,
+		.gpu_timestamp = gpu_ts,
+	};
+
+	write_record(f, INTEL_PERF_RECORD_TYPE_TIMESTAMP_CORRELATION,
+		     &corr, sizeof(corr));
+}
+
+/* Stands for the OA unit, only the timestamp and context id matter. */
+static void write_report(FILE *f, uint32_t gpu_ts, uint32_t ctx_id)
+{
+	uint32_t report[REPORT_SIZE / 4] = {};
+
+	report[1] = gpu_ts;
+	report[2] = ctx_id;
+
+	write_record(f, DRM_I915_PERF_RECORD_SAMPLE, report, sizeof(report));
+}
+
+static void write_marker(FILE *f, uint32_t type, const char *label,
+			 uint64_t cpu_ts, uint64_t gpu_ts)
+{
+	struct intel_perf_record_marker marker = {
+		.cpu_timestamp = cpu_ts,
+		.gpu_timestamp = gpu_ts,
+		.type = type,
+	};
+
+	snprintf(marker.label, sizeof(marker.label), "%s", label);
+	write_record(f, INTEL_PERF_RECORD_TYPE_MARKER, &marker, sizeof(marker));
+}
+
+static void check_marker(const struct intel_perf_data_reader *reader,
+			 uint32_t idx, uint32_t type, const char *label,
+			 uint64_t gpu_ts, uint32_t record)
+{
+	const struct intel_perf_marker_item *item = &reader->markers[idx];
+
+	igt_assert_eq_u32(item->marker->type, type);
+	igt_assert_eq_u64(item->marker->gpu_timestamp, gpu_ts);
+	igt_assert_eq_u32(item->record, record);
+	igt_assert_f(!strcmp(item->marker->label, label),
+		     "marker %u: '%s' != '%s'\n", idx, item->marker->label, label);
+}
+
+static void test_markers(void)
+{
+	struct intel_perf_data_reader reader;
+	FILE *f = tmpfile();
+
+	igt_assert(f);
+
+	write_preamble(f);
+	write_correlation(f, 1000000, 0x10000);
+
+	write_report(f, 0x10100, 1);
+	write_marker(f, INTEL_PERF_MARKER_BEGIN, "upload", 1000300, 0x10180);
+	write_report(f, 0x10200, 1);
+	write_report(f, 0x10300, 1);
+	write_marker(f, INTEL_PERF_MARKER_END, "upload", 1000700, 0x10380);
+	write_marker(f, INTEL_PERF_MARKER_LABEL, "frame 1", 1000710, 0x10390);
+	write_report(f, 0x10400, 2);
+	write_report(f, 0x10500, 2);
+
+	write_correlation(f, 2000000, 0x20000);
+	igt_assert_eq(fflush(f), 0);
+
+	igt_assert_f(intel_perf_data_reader_init(&reader, fileno(f)),
+		     "%s\n", reader.error_msg);
+
+	igt_assert_eq_u32(reader.n_records, 5);
+	igt_assert_eq_u32(reader.n_correlations, 2);
+	igt_assert_eq_u32(reader.n_markers, 3);
+
+	/* Each marker precedes the report written after it. */
+	check_marker(&reader, 0, INTEL_PERF_MARKER_BEGIN, "upload", 0x10180, 1);
+	check_marker(&reader, 1, INTEL_PERF_MARKER_END, "upload", 0x10380, 3);
+	check_marker(&reader, 2, INTEL_PERF_MARKER_LABEL, "frame 1", 0x10390, 3);
+	igt_assert_eq_u64(reader.markers[1].marker->cpu_timestamp, 1000700);
+
+	/* Markers don't disturb the context timeline. */
+	igt_assert_eq_u32(reader.n_timelines, 2);
+	igt_assert_eq_u32(reader.timelines[0].hw_id, 1);
+	igt_assert_eq_u32(reader.timelines[0].record_end, 3);
+
+	intel_perf_data_reader_fini(&reader);
+	fclose(f);
+}
+
+igt_main
+{
+	igt_describe("Parse markers written inline with fake OA reports");
+	igt_subtest("markers")
+		test_markers();
+}
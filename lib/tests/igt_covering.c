@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_core.h"
+#include "igt_covering.h"
+
+IGT_TEST_DESCRIPTION("Check the covering arrays generated for synthetic test spaces");
+
+static const char * const modes[] = { "gtt", "wc", "cpu", NULL };
+static const char * const buffers[] = { "bo", "userptr", "dmabuf", NULL };
+static const char * const ops[] = { "copy", "fill", "read", "write", NULL };
+static const char * const engines[] = { "rcs", "bcs", NULL };
+static const char * const sizes[] = { "small", "large", "huge", NULL };
+
+static void setup(igt_covering_t *cov, unsigned int strength, uint32_t seed)
+{
+	igt_covering_init(cov, "synthetic", strength, seed);
+	igt_covering_add(cov, "mode", modes);
+	igt_covering_add(cov, "buffer", buffers);
+	igt_covering_add(cov, "op", ops);
+	igt_covering_add(cov, "engine", engines);
+	igt_covering_add(cov, "size", sizes);
+}
+
+/* number of t-tuples of values over any t dimensions covered by the rows */
+static unsigned int count_covered(const igt_covering_t *cov, unsigned int t,
+				  const unsigned int *rows, unsigned int n_rows,
+				  unsigned int *n_tuples)
+{
+	unsigned int covered = 0, total = 0;
+
+	for (unsigned int mask = 0; mask < 1u << cov->n_dims; mask++) {
+		unsigned int n = 1, stride[8], tuple;
+		unsigned char *seen;
+
+		if (__builtin_popcount(mask) != t)
+			continue;
+
+		for (unsigned int d = 0; d < cov->n_dims; d++) {
+			if (!(mask & 1 << d))
+				continue;
+			stride[d] = n;
+			n *= cov->dims[d].n_values;
+		}
+
+		seen = calloc(n, 1);
+		for (unsigned int r = 0; r < n_rows; r++) {
+			tuple = 0;
+			for (unsigned int d = 0; d < cov->n_dims; d++)
+				if (mask & 1 << d)
+					tuple += rows[r * cov->n_dims + d] * stride[d];
+			if (!seen[tuple]++)
+				covered++;
+		}
+		free(seen);
+
+		total += n;
+	}
+
+	*n_tuples = total;
+	return covered;
+}
+
+static void check_strength(unsigned int t)
+{
+	igt_covering_t cov;
+	unsigned int covered, total;
+
+	setup(&cov, t, 1);
+	igt_covering_generate(&cov);
+
+	covered = count_covered(&cov, t, cov.rows, cov.n_rows, &total);
+	igt_assert_eq_u32(covered, total);
+	igt_assert_lt(cov.n_rows, 3 * 3 * 4 * 2 * 3);
+	/* at least the largest t dimensions */
+	igt_assert_lte(t == 2 ? 4 * 3 : 4 * 3 * 3, cov.n_rows);
+
+	igt_covering_fini(&cov);
+}
+
+static void test_deterministic(void)
+{
+	igt_covering_t a, b, c;
+	unsigned int covered, total;
+
+	setup(&a, 2, 42);
+	setup(&b, 2, 42);
+	setup(&c, 2, 43);
+	igt_covering_generate(&a);
+	igt_covering_generate(&b);
+	igt_covering_generate(&c);
+
+	igt_assert_eq_u32(a.n_rows, b.n_rows);
+	for (unsigned int r = 0; r < a.n_rows; r++)
+		igt_assert(!strcmp(igt_covering_name(&a, r),
+				   igt_covering_name(&b, r)));
+
+	covered = count_covered(&c, 2, c.rows, c.n_rows, &total);
+	igt_assert_eq_u32(covered, total);
+
+	igt_covering_fini(&a);
+	igt_covering_fini(&b);
+	igt_covering_fini(&c);
+}
+
+static void test_full(void)
+{
+	igt_covering_t cov;
+
+	setup(&cov, 0, 0);
+	igt_covering_generate(&cov);
+
+	igt_assert_eq_u32(cov.n_rows, 3 * 3 * 4 * 2 * 3);
+	igt_assert(!strcmp(igt_covering_name(&cov, 0), "gtt-bo-copy-rcs-small"));
+	igt_assert(!strcmp(igt_covering_name(&cov, 1), "gtt-bo-copy-rcs-large"));
+	igt_assert(!strcmp(igt_covering_name(&cov, cov.n_rows - 1),
+			   "cpu-dmabuf-write-bcs-huge"));
+	igt_assert_eq_u32(igt_covering_value(&cov, cov.n_rows - 1, 2), 3);
+	igt_covering_fini(&cov);
+
+	setenv("IGT_COVERING_STRENGTH", "full", 1);
+	setup(&cov, 2, 0);
+	unsetenv("IGT_COVERING_STRENGTH");
+	igt_covering_generate(&cov);
+	igt_assert_eq_u32(cov.n_rows, 3 * 3 * 4 * 2 * 3);
+	igt_covering_fini(&cov);
+}
+
+/*
+ * Each run remains pairwise, while the 3-way coverage accumulated through
+ * the history grows from run to run.
+ */
+static void test_rotation(void)
+{
+	unsigned int *all = NULL, n_all = 0;
+	unsigned int covered, prev = 0, total, pairs = 0;
+	char path[] = "/tmp/igt_covering.XXXXXX";
+	igt_covering_t cov;
+	char line[256];
+	FILE *f;
+	int fd;
+
+	fd = mkstemp(path);
+	igt_assert(fd >= 0);
+	close(fd);
+	setenv("IGT_COVERING_HISTORY", path, 1);
+
+	for (int run = 0; run < 4; run++) {
+		setup(&cov, 2, 7);
+		igt_covering_generate(&cov);
+		igt_assert_eq_u32(cov.n_history, n_all);
+
+		covered = count_covered(&cov, 2, cov.rows, cov.n_rows, &pairs);
+		igt_assert_eq_u32(covered, pairs);
+
+		all = realloc(all, (n_all + cov.n_rows) * cov.n_dims *
+			      sizeof(*all));
+		memcpy(all + n_all * cov.n_dims, cov.rows,
+		       cov.n_rows * cov.n_dims * sizeof(*all));
+		n_all += cov.n_rows;
+
+		covered = count_covered(&cov, 3, all, n_all, &total);
+		igt_assert_lt(prev, covered);
+		prev = covered;
+
+		igt_covering_fini(&cov);
+	}
+	unsetenv("IGT_COVERING_HISTORY");
+
+	/* the rows of other test spaces and stale values are skipped */
+	f = fopen(path, "a");
+	igt_assert(f);
+	fprintf(f, "row other mode=gtt buffer=bo op=copy engine=rcs size=small\n");
+	fprintf(f, "row synthetic mode=uc buffer=bo op=copy engine=rcs size=small\n");
+	fprintf(f, "row synthetic mode=gtt buffer=bo op=copy engine=rcs\n");
+	fclose(f);
+
+	setup(&cov, 2, 7);
+	f = fopen(path, "r");
+	igt_assert(igt_covering_load(&cov, f));
+	fclose(f);
+	igt_assert_eq_u32(cov.n_history, n_all);
+	igt_assert(!memcmp(cov.history, all, n_all * cov.n_dims * sizeof(*all)));
+	igt_covering_fini(&cov);
+
+	/* the tuples covered are recorded along with the rows */
+	f = fopen(path, "r");
+	igt_assert(f);
+	covered = 0;
+	while (fgets(line, sizeof(line), f))
+		covered += !strncmp(line, "tuple synthetic ", 16);
+	igt_assert_eq_u32(covered, 4 * pairs);
+	fclose(f);
+
+	remove(path);
+	free(all);
+}
+
+igt_main
+{
+	igt_describe("Every pair of values of any two dimensions is covered");
+	igt_subtest("pairwise")
+		check_strength(2);
+
+	igt_describe("Every triple of values of any three dimensions is covered");
+	igt_subtest("3-way")
+		check_strength(3);
+
+	igt_describe("The same seed generates the same rows");
+	igt_subtest("deterministic")
+		test_deterministic();
+
+	igt_describe("Strength 0 expands the full cartesian product");
+	igt_subtest("full")
+		test_full();
+
+	igt_describe("The history rotates the higher order coverage over runs");
+	igt_subtest("rotation")
+		test_rotation();
+
+	igt_describe("Rows run as dynamic subtests");
+	igt_subtest_with_dynamic("dynamic") {
+		igt_covering_t cov;
+		unsigned int row, n = 0;
+
+		setup(&cov, 2, 0);
+		igt_covering_generate(&cov);
+		igt_covering_dynamic(&cov, row)
+			igt_assert(row == n++);
+		igt_assert_eq_u32(n, cov.n_rows);
+		igt_covering_fini(&cov);
+	}
+}
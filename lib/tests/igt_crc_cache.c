@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <string.h>
+
+#include "igt_core.h"
+#include "igt_crc_cache.h"
+
+IGT_TEST_DESCRIPTION("Check the reference CRC cache against a mock CRC provider");
+
+/* stands for the pipe, every capture gives new CRCs */
+struct mock_provider {
+	int captures;
+	uint32_t next;
+};
+
+static void mock_capture(void *data, igt_crc_t *crcs, int count)
+{
+	struct mock_provider *mock = data;
+
+	mock->captures++;
+	for (int i = 0; i < count; i++) {
+		memset(&crcs[i], 0, sizeof(crcs[i]));
+		crcs[i].n_words = 1;
+		crcs[i].crc[0] = mock->next++;
+		crcs[i].frame = crcs[i].crc[0];
+		crcs[i].has_valid_frame = true;
+	}
+}
+
+static const drmModeModeInfo mode_1080p = {
+	.clock = 148500,
+	.hdisplay = 1920, .hsync_start = 2008, .hsync_end = 2052, .htotal = 2200,
+	.vdisplay = 1080, .vsync_start = 1084, .vsync_end = 1089, .vtotal = 1125,
+	.vrefresh = 60,
+	.flags = DRM_MODE_FLAG_PHSYNC | DRM_MODE_FLAG_PVSYNC,
+	.name = "1920x1080",
+};
+
+static bool get(igt_crc_cache_t *cache, struct mock_provider *mock,
+		const drmModeModeInfo *mode, unsigned int display_ver,
+		const char *pattern, igt_crc_t *crcs, int count)
+{
+	igt_crc_cache_key_t key;
+
+	igt_crc_cache_key_init(&key, "auto:HDMI-A-1", mode, display_ver,
+			       "%s", pattern);
+
+	return igt_crc_cache_get(cache, &key, crcs, count, mock_capture, mock);
+}
+
+static void test_lookup(void)
+{
+	struct mock_provider mock = {};
+	igt_crc_t ref[4], crcs[4];
+	drmModeModeInfo mode = mode_1080p;
+	igt_crc_cache_t cache;
+
+	igt_crc_cache_init(&cache);
+
+	igt_assert(!get(&cache, &mock, &mode, 20, "red green", ref, 2));
+	igt_assert_eq(mock.captures, 1);
+
+	/* another pipe with the same mode, only the timings matter */
+	mode.vrefresh = 59;
+	mode.type = DRM_MODE_TYPE_USERDEF;
+	strcpy(mode.name, "other");
+	igt_assert(get(&cache, &mock, &mode, 20, "red green", crcs, 2));
+	igt_assert_eq(mock.captures, 1);
+	igt_assert(!memcmp(crcs, ref, 2 * sizeof(crcs[0])));
+
+	/* any part of the key differing is a miss */
+	igt_assert(!get(&cache, &mock, &mode, 20, "red blue", crcs, 2));
+	igt_assert(!get(&cache, &mock, &mode, 30, "red green", crcs, 2));
+	igt_assert(!get(&cache, &mock, &mode, 20, "red green", crcs, 3));
+	mode.htotal++;
+	igt_assert(!get(&cache, &mock, &mode, 20, "red green", crcs, 2));
+	igt_assert_eq(mock.captures, 5);
+	igt_assert(memcmp(crcs, ref, 2 * sizeof(crcs[0])));
+
+	igt_assert_eq(cache.hits, 1);
+	igt_assert_eq(cache.misses, 5);
+	igt_assert_eq(cache.crcs_saved, 2);
+	igt_crc_cache_report(&cache);
+
+	igt_crc_cache_fini(&cache);
+}
+
+static void test_invalidate(void)
+{
+	struct mock_provider mock = {};
+	igt_crc_t ref, crc;
+	igt_crc_cache_t cache;
+
+	igt_crc_cache_init(&cache);
+
+	igt_crc_cache_invalidate(&cache);
+	igt_assert_eq(cache.invalidations, 0);
+
+	igt_assert(!get(&cache, &mock, &mode_1080p, 0, "black", &ref, 1));
+	igt_assert(get(&cache, &mock, &mode_1080p, 0, "black", &crc, 1));
+
+	/* eg. after a LUT change, the CRCs must be captured again */
+	igt_crc_cache_invalidate(&cache);
+	igt_assert_eq(cache.invalidations, 1);
+	igt_assert(!get(&cache, &mock, &mode_1080p, 0, "black", &crc, 1));
+	igt_assert_eq(mock.captures, 2);
+	igt_assert_neq_u32(crc.crc[0], ref.crc[0]);
+
+	igt_assert(get(&cache, &mock, &mode_1080p, 0, "black", &ref, 1));
+	igt_assert_eq_u32(crc.crc[0], ref.crc[0]);
+
+	igt_crc_cache_fini(&cache);
+}
+
+igt_main
+{
+	igt_describe("Reuse CRCs when the key matches and capture them otherwise");
+	igt_subtest("lookup")
+		test_lookup();
+
+	igt_describe("Capture the CRCs again after invalidating the cache");
+	igt_subtest("invalidate")
+		test_invalidate();
+}
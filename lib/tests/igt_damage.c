@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_core.h"
+#include "igt_damage.h"
+#include "igt_rand.h"
+
+IGT_TEST_DESCRIPTION("Check the dirty rectangle bookkeeping of framebuffer shadows");
+
+#define WIDTH 300
+#define HEIGHT 200
+#define CPP 4
+#define STRIDE (WIDTH * CPP + 64)
+
+static void assert_rect(const igt_damage_t *d, int idx,
+			int x, int y, int width, int height)
+{
+	const igt_damage_rect_t *r = igt_damage_rect(d, idx);
+
+	igt_assert_f(r->x == x && r->y == y &&
+		     r->width == width && r->height == height,
+		     "rect %d is %dx%d+%d+%d, expected %dx%d+%d+%d\n", idx,
+		     r->width, r->height, r->x, r->y, width, height, x, y);
+}
+
+static void test_add(void)
+{
+	igt_damage_t d;
+
+	igt_damage_init(&d, WIDTH, HEIGHT);
+	igt_assert_eq(igt_damage_count(&d), 0);
+
+	/* clipped to the surface, empty ones ignored */
+	igt_damage_add(&d, -10, -10, 20, 30);
+	assert_rect(&d, 0, 0, 0, 10, 20);
+	igt_damage_add(&d, WIDTH, 0, 10, 10);
+	igt_damage_add(&d, 50, 50, 0, 10);
+	igt_assert_eq(igt_damage_count(&d), 1);
+
+	/* contained ones ignored, containing ones replace */
+	igt_damage_add(&d, 2, 2, 4, 4);
+	igt_assert_eq(igt_damage_count(&d), 1);
+	igt_damage_add(&d, 0, 0, 40, 40);
+	igt_assert_eq(igt_damage_count(&d), 1);
+	assert_rect(&d, 0, 0, 0, 40, 40);
+
+	/* disjoint ones kept apart */
+	igt_damage_add(&d, 100, 100, 10, 10);
+	igt_assert_eq(igt_damage_count(&d), 2);
+	igt_assert_eq(igt_damage_area(&d), 40 * 40 + 10 * 10);
+	igt_assert(!igt_damage_is_full(&d));
+
+	igt_damage_add(&d, 0, 0, WIDTH, HEIGHT);
+	igt_assert(igt_damage_is_full(&d));
+
+	igt_damage_reset(&d);
+	igt_assert_eq(igt_damage_count(&d), 0);
+	igt_damage_fini(&d);
+}
+
+static void test_merge(void)
+{
+	igt_damage_t d;
+
+	igt_damage_init(&d, WIDTH, HEIGHT);
+
+	/* a row of adjacent rects becomes one */
+	for (int x = 0; x < 100; x += 10)
+		igt_damage_add(&d, x, 20, 10, 8);
+	igt_assert_eq(igt_damage_count(&d), 1);
+	assert_rect(&d, 0, 0, 20, 100, 8);
+
+	/* and so does a column of such rows */
+	igt_damage_add(&d, 0, 28, 100, 4);
+	igt_assert_eq(igt_damage_count(&d), 1);
+	assert_rect(&d, 0, 0, 20, 100, 12);
+
+	/* merging cascades: the middle joins both neighbours */
+	igt_damage_add(&d, 200, 0, 10, 10);
+	igt_damage_add(&d, 220, 0, 10, 10);
+	igt_assert_eq(igt_damage_count(&d), 3);
+	igt_damage_add(&d, 210, 0, 10, 10);
+	igt_assert_eq(igt_damage_count(&d), 2);
+	assert_rect(&d, 1, 200, 0, 30, 10);
+
+	/* misaligned neighbours are not merged, the union is not a rect */
+	igt_damage_add(&d, 230, 1, 10, 10);
+	igt_assert_eq(igt_damage_count(&d), 3);
+
+	igt_damage_fini(&d);
+}
+
+static void test_collapse(void)
+{
+	igt_damage_t d;
+
+	igt_damage_init(&d, WIDTH, HEIGHT);
+
+	/* a checkerboard does not merge, until there are too many */
+	for (int i = 0; i < d.max_rects; i++)
+		igt_damage_add(&d, (i % 8) * 20, (i / 8) * 20, 10, 10);
+	igt_assert_eq(igt_damage_count(&d), d.max_rects);
+
+	igt_damage_add(&d, 250, 150, 10, 10);
+	igt_assert_eq(igt_damage_count(&d), 1);
+	assert_rect(&d, 0, 0, 0, 260, 160);
+
+	igt_damage_fini(&d);
+}
+
+static bool covered(const igt_damage_t *d, int x, int y)
+{
+	for (int i = 0; i < igt_damage_count(d); i++) {
+		const igt_damage_rect_t *r = igt_damage_rect(d, i);
+
+		if (x >= r->x && x < r->x + r->width &&
+		    y >= r->y && y < r->y + r->height)
+			return true;
+	}
+
+	return false;
+}
+
+static void test_diff(void)
+{
+	uint8_t *ptr = calloc(HEIGHT, STRIDE);
+	uint8_t *ref = calloc(HEIGHT, STRIDE);
+	igt_damage_t d;
+
+	igt_damage_init(&d, WIDTH, HEIGHT);
+
+	igt_assert_eq(igt_damage_diff(&d, ptr, ref, STRIDE, CPP, 64, 16), 0);
+	igt_assert_eq(igt_damage_count(&d), 0);
+
+	/* the padding past the width is not compared */
+	ptr[10 * STRIDE + WIDTH * CPP] = 1;
+	igt_assert_eq(igt_damage_diff(&d, ptr, ref, STRIDE, CPP, 64, 16), 0);
+
+	/* a pixel damages its tile */
+	ptr[20 * STRIDE + 70 * CPP] = 1;
+	igt_assert_eq(igt_damage_diff(&d, ptr, ref, STRIDE, CPP, 64, 16), 1);
+	igt_assert_eq(igt_damage_count(&d), 1);
+	assert_rect(&d, 0, 64, 16, 64, 16);
+
+	/* a line across damages a run of tiles, clipped to the surface */
+	igt_damage_reset(&d);
+	memset(ptr + 199 * STRIDE + 100 * CPP, 0xff, 200 * CPP);
+	igt_assert_eq(igt_damage_diff(&d, ptr, ref, STRIDE, CPP, 64, 16), 1 + 4);
+	igt_assert_eq(igt_damage_count(&d), 2);
+	igt_assert(covered(&d, 70, 20));
+	igt_assert(covered(&d, 299, 199));
+	igt_assert(!covered(&d, 0, 199));
+
+	/* once copied, nothing differs anymore */
+	igt_damage_copy(&d, ref, ptr, STRIDE, CPP);
+	igt_damage_reset(&d);
+	igt_assert_eq(igt_damage_diff(&d, ptr, ref, STRIDE, CPP, 64, 16), 0);
+
+	igt_damage_fini(&d);
+	free(ptr);
+	free(ref);
+}
+
+/*
+ * Random drawing: writing back the damaged rects only must bring a copy of
+ * the surface up to date, while copying a fraction of it.
+ */
+static void test_random(void)
+{
+	uint8_t *ptr = calloc(HEIGHT, STRIDE);
+	uint8_t *ref = calloc(HEIGHT, STRIDE);
+	uint8_t *gpu = calloc(HEIGHT, STRIDE);
+	uint32_t seed = 0x1234;
+	uint64_t copied = 0;
+	igt_damage_t d;
+
+	igt_damage_init(&d, WIDTH, HEIGHT);
+
+	for (int frame = 0; frame < 500; frame++) {
+		int draws = hars_petruska_f54_1_random(&seed) % 4;
+
+		for (int i = 0; i < draws; i++) {
+			int w = 1 + hars_petruska_f54_1_random(&seed) % 32;
+			int h = 1 + hars_petruska_f54_1_random(&seed) % 32;
+			int x = hars_petruska_f54_1_random(&seed) % (WIDTH - w);
+			int y = hars_petruska_f54_1_random(&seed) % (HEIGHT - h);
+			uint8_t c = frame + i + 1;
+
+			for (int row = y; row < y + h; row++)
+				memset(ptr + row * STRIDE + x * CPP, c, w * CPP);
+		}
+
+		igt_damage_diff(&d, ptr, ref, STRIDE, CPP, 32, 8);
+		for (int i = 0; i < igt_damage_count(&d); i++) {
+			const igt_damage_rect_t *r = igt_damage_rect(&d, i);
+
+			igt_assert(r->x >= 0 && r->y >= 0 &&
+				   r->x + r->width <= WIDTH &&
+				   r->y + r->height <= HEIGHT);
+		}
+		copied += igt_damage_area(&d);
+
+		/* the write-back, and the reference update */
+		igt_damage_copy(&d, gpu, ptr, STRIDE, CPP);
+		igt_damage_copy(&d, ref, ptr, STRIDE, CPP);
+		igt_damage_reset(&d);
+
+		for (int y = 0; y < HEIGHT; y++)
+			igt_assert(!memcmp(gpu + y * STRIDE, ptr + y * STRIDE,
+					   WIDTH * CPP));
+	}
+
+	igt_info("Copied %.1f%% of full write-backs\n",
+		 100. * copied / (500ull * WIDTH * HEIGHT));
+	igt_assert(copied < 500ull * WIDTH * HEIGHT / 2);
+
+	igt_damage_fini(&d);
+	free(ptr);
+	free(ref);
+	free(gpu);
+}
+
+igt_main
+{
+	igt_describe("Rects are clipped, and contained ones dropped");
+	igt_subtest("add")
+		test_add();
+
+	igt_describe("Adjacent rects forming a rect are merged");
+	igt_subtest("merge")
+		test_merge();
+
+	igt_describe("Too many rects collapse into their bounding box");
+	igt_subtest("collapse")
+		test_collapse();
+
+	igt_describe("Comparing to a reference finds the changed tiles");
+	igt_subtest("diff")
+		test_diff();
+
+	igt_describe("Writing back the damage only keeps a copy up to date");
+	igt_subtest("random")
+		test_random();
+}
@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+#include "drmtest.h"
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_dir.h"
+
+#include "igt_tests_common.h"
+
+IGT_TEST_DESCRIPTION("Exercise the igt_dir scanner and crawler against a synthetic tree");
+
+static char root[] = "/tmp/igt_dir_crawl.XXXXXX";
+
+static const struct {
+	const char *path;
+	size_t size;
+} files[] = {
+	{ "version", 12 },
+	{ "empty", 0 },
+	{ "gt0/freq", 5 },
+	{ "gt0/engines/rcs0/name", 5 },
+	{ "gt0/engines/rcs0/big", 3 * 4096 + 7 },
+	{ "gt1/freq", 5 },
+};
+
+static int root_fd = -1;
+static int silent_writer = -1;
+
+static void write_file(const char *path, size_t size)
+{
+	char *buf;
+
+	buf = malloc(size + 1);
+	igt_assert(buf);
+	memset(buf, 'x', size);
+	buf[size] = '\0';
+	scratch_write(root, path, buf);
+
+	free(buf);
+}
+
+static void make_tree(void)
+{
+	scratch_create(root);
+
+	scratch_mkdirs(root, "gt0/engines/rcs0");
+	scratch_mkdir(root, "gt1");
+
+	for (int i = 0; i < ARRAY_SIZE(files); i++)
+		write_file(files[i].path, files[i].size);
+
+	root_fd = open(root, O_RDONLY | O_DIRECTORY);
+	igt_assert_fd(root_fd);
+}
+
+/* A FIFO without a writer blocks in open(), one with an idle writer in read() */
+static void make_fifos(void)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/gt0/never", root);
+	igt_assert_eq(mkfifo(path, 0644), 0);
+
+	snprintf(path, sizeof(path), "%s/gt1/silent", root);
+	igt_assert_eq(mkfifo(path, 0644), 0);
+	silent_writer = open(path, O_RDWR);
+	igt_assert_fd(silent_writer);
+}
+
+static void remove_fifos(void)
+{
+	char path[PATH_MAX];
+
+	close(silent_writer);
+	snprintf(path, sizeof(path), "%s/gt0/never", root);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/gt1/silent", root);
+	unlink(path);
+}
+
+static const igt_dir_node_t *find_node(const igt_dir_crawl_t *crawl,
+				       const char *path)
+{
+	for (unsigned int i = 0; i < crawl->count; i++)
+		if (!strcmp(crawl->nodes[i].relative_path, path))
+			return &crawl->nodes[i];
+
+	return NULL;
+}
+
+static int count_files(igt_dir_t *dir)
+{
+	igt_dir_file_list_t *entry;
+	int count = 0;
+
+	igt_list_for_each_entry(entry, &dir->file_list_head, link)
+		count++;
+
+	return count;
+}
+
+static void test_scan(void)
+{
+	igt_dir_file_list_t *entry;
+	igt_dir_t *dir;
+
+	dir = igt_dir_create(root_fd);
+	igt_assert(dir);
+
+	igt_assert_eq(igt_dir_scan_dirfd(dir, -1), 0);
+	igt_assert_eq(count_files(dir), ARRAY_SIZE(files));
+
+	for (int i = 0; i < ARRAY_SIZE(files); i++) {
+		bool found = false;
+
+		igt_list_for_each_entry(entry, &dir->file_list_head, link)
+			found |= !strcmp(entry->relative_path, files[i].path);
+		igt_assert_f(found, "%s not scanned\n", files[i].path);
+	}
+
+	/* rescanning replaces the list */
+	igt_assert_eq(igt_dir_scan_dirfd(dir, 1), 0);
+	igt_assert_eq(count_files(dir), 4);
+
+	igt_dir_destroy(dir);
+}
+
+static void test_crawl(unsigned int workers, size_t read_size)
+{
+	igt_dir_crawl_opts_t opts = {
+		.workers = workers,
+		.read_size = read_size,
+	};
+	igt_dir_crawl_t crawl;
+	igt_dir_t *dir;
+
+	dir = igt_dir_create(root_fd);
+	igt_assert(dir);
+	igt_assert_eq(igt_dir_scan_dirfd(dir, -1), 0);
+
+	igt_assert_eq(igt_dir_crawl(dir, &opts, &crawl), 0);
+	igt_assert_eq(crawl.count, ARRAY_SIZE(files));
+	igt_assert_eq(crawl.failed + crawl.timed_out + crawl.stuck, 0);
+
+	for (int i = 0; i < ARRAY_SIZE(files); i++) {
+		const igt_dir_node_t *node = find_node(&crawl, files[i].path);
+		size_t expected = min(files[i].size, read_size ?: 4096);
+
+		igt_assert(node);
+		igt_assert_eq(node->err, 0);
+		igt_assert_eq(node->bytes, expected);
+	}
+
+	igt_dir_crawl_fini(&crawl);
+	igt_dir_destroy(dir);
+}
+
+static void other_handler(int sig)
+{
+}
+
+static void test_timeout(unsigned int workers)
+{
+	struct sigaction act = { .sa_handler = other_handler }, old, cur;
+	igt_dir_crawl_opts_t opts = {
+		.workers = workers,
+		.timeout_ms = 100,
+	};
+	const igt_dir_node_t *node;
+	igt_dir_file_list_t *entry;
+	igt_dir_crawl_t crawl;
+	igt_dir_t *dir;
+
+	dir = igt_dir_create(root_fd);
+	igt_assert(dir);
+	igt_assert_eq(igt_dir_scan_dirfd(dir, -1), 0);
+
+	/* filtered out nodes are left alone */
+	igt_list_for_each_entry(entry, &dir->file_list_head, link)
+		if (!strcmp(entry->relative_path, "empty"))
+			entry->match = false;
+
+	igt_assert_eq(sigaction(SIGRTMIN + 1, &act, &old), 0);
+	igt_assert_eq(igt_dir_crawl(dir, &opts, &crawl), -ETIMEDOUT);
+	igt_dir_crawl_report(&crawl, 3);
+
+	/* the crawler only borrows the signal while running */
+	igt_assert_eq(sigaction(SIGRTMIN + 1, &old, &cur), 0);
+	igt_assert(cur.sa_handler == other_handler);
+
+	igt_assert_eq(crawl.count, ARRAY_SIZE(files) + 1);
+	igt_assert_eq(crawl.timed_out, 2);
+	igt_assert_eq(crawl.failed, 0);
+	igt_assert_eq(crawl.stuck, 0);
+	igt_assert(!find_node(&crawl, "empty"));
+
+	node = find_node(&crawl, "gt0/never");
+	igt_assert(node);
+	igt_assert_eq(node->err, -ETIMEDOUT);
+	igt_assert_lte_u64(100 * 1000000ull, node->latency_ns);
+
+	node = find_node(&crawl, "gt1/silent");
+	igt_assert(node);
+	igt_assert_eq(node->err, -ETIMEDOUT);
+
+	/* the blocked nodes did not hold up the rest */
+	node = find_node(&crawl, "gt0/engines/rcs0/big");
+	igt_assert(node);
+	igt_assert_eq(node->err, 0);
+	igt_assert_eq(node->bytes, 4096);
+
+	/* one reader handles both FIFOs back to back */
+	igt_assert_lt_u64(crawl.elapsed_ns, 2000 * 1000000ull);
+
+	igt_dir_crawl_fini(&crawl);
+	igt_dir_destroy(dir);
+}
+
+static void test_crawl_simple(void)
+{
+	/* both FIFOs time out, the files that can be read are not counted */
+	igt_assert_eq(igt_dir_crawl_simple(root_fd, 100), 2);
+}
+
+igt_main
+{
+	igt_fixture
+		make_tree();
+
+	igt_describe("Check the scanner finds every file, honoring the depth limit");
+	igt_subtest("scan")
+		test_scan();
+
+	igt_describe("Check every file is read by a single reader");
+	igt_subtest("crawl-serial")
+		test_crawl(1, 0);
+
+	igt_describe("Check every file is read by concurrent readers");
+	igt_subtest("crawl-parallel")
+		test_crawl(4, 0);
+
+	igt_describe("Check the read size limit is honored");
+	igt_subtest("crawl-read-size")
+		test_crawl(3, 8 * 4096);
+
+	igt_subtest_group {
+		igt_fixture
+			make_fifos();
+
+		igt_describe("Check blocking nodes time out without stalling a single reader");
+		igt_subtest("timeout-serial")
+			test_timeout(1);
+
+		igt_describe("Check blocking nodes time out without stalling the other readers");
+		igt_subtest("timeout-parallel")
+			test_timeout(4);
+
+		igt_describe("Check igt_dir_crawl_simple() counts the nodes that timed out");
+		igt_subtest("crawl-simple")
+			test_crawl_simple();
+
+		igt_fixture
+			remove_fifos();
+	}
+
+	igt_fixture {
+		close(root_fd);
+		scratch_remove(root, NULL);
+	}
+}
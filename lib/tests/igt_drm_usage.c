@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_drm_usage.h"
+
+#include "igt_tests_common.h"
+
+IGT_TEST_DESCRIPTION("Attribute DRM fdinfo usage to a process tree of a synthetic procfs");
+
+#define ROOT_PID 100
+#define IGPU "0000:00:02.0"
+#define DGPU "0000:03:00.0"
+
+static char root[] = "/tmp/igt_drm_usage.XXXXXX";
+
+static void make_dir(pid_t pid, const char *subdir)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "%d%s", pid, subdir);
+	scratch_mkdir(root, path);
+}
+
+static void make_status(pid_t pid, pid_t ppid)
+{
+	char path[64], buf[256];
+
+	snprintf(path, sizeof(path), "%d/status", pid);
+	snprintf(buf, sizeof(buf),
+		 "Name:\tproc%d\nPPid:\t%d\nUid:\t0\t0\t0\t0\nGid:\t0\t0\t0\t0\n",
+		 pid, ppid);
+	scratch_write(root, path, buf);
+}
+
+static void make_proc(pid_t pid, pid_t ppid)
+{
+	make_dir(pid, "");
+	make_dir(pid, "/fd");
+	make_dir(pid, "/fdinfo");
+	make_status(pid, ppid);
+}
+
+static void make_fd(pid_t pid, int fd, const char *target)
+{
+	char full[PATH_MAX];
+
+	snprintf(full, sizeof(full), "%s/%d/fd/%d", root, pid, fd);
+	igt_assert_eq(symlink(target, full), 0);
+}
+
+__attribute__((format(printf, 3, 4)))
+static void write_fdinfo(pid_t pid, int fd, const char *fmt, ...)
+{
+	char path[64], buf[1024];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	snprintf(path, sizeof(path), "%d/fdinfo/%d", pid, fd);
+	scratch_write(root, path, buf);
+}
+
+static void i915_client(pid_t pid, int fd, unsigned long id,
+			unsigned long render_ns, unsigned int resident_mib)
+{
+	write_fdinfo(pid, fd,
+		     "pos:\t0\nflags:\t02100002\n"
+		     "drm-driver:\ti915\n"
+		     "drm-client-id:\t%lu\n"
+		     "drm-pdev:\t" IGPU "\n"
+		     "drm-total-system0:\t8 MiB\n"
+		     "drm-resident-system0:\t%u MiB\n"
+		     "drm-engine-render:\t%lu ns\n"
+		     "drm-engine-copy:\t500 ns\n"
+		     "drm-engine-capacity-video:\t2\n"
+		     "drm-engine-video:\t0 ns\n",
+		     id, resident_mib, render_ns);
+}
+
+static void xe_client(pid_t pid, int fd, unsigned long id,
+		      unsigned long cycles, unsigned long total)
+{
+	write_fdinfo(pid, fd,
+		     "drm-driver:\txe\n"
+		     "drm-client-id:\t%lu\n"
+		     "drm-pdev:\t" DGPU "\n"
+		     "drm-total-vram0:\t64 MiB\n"
+		     "drm-resident-vram0:\t64 MiB\n"
+		     "drm-cycles-rcs:\t%lu\n"
+		     "drm-total-cycles-rcs:\t%lu\n",
+		     id, cycles, total);
+}
+
+/*
+ * 100 is the tracker, 200 and its child 201 are tracked, 300 is not a
+ * descendant of 100 and 400 has a non DRM fd under /dev/dri.
+ */
+static void make_tree(void)
+{
+	scratch_create(root);
+
+	make_proc(ROOT_PID, 1);
+	make_fd(ROOT_PID, 3, "/dev/dri/card0");
+	i915_client(ROOT_PID, 3, 1, 1000, 1);
+
+	make_proc(200, ROOT_PID);
+	make_fd(200, 0, "/dev/null");
+	make_fd(200, 3, "/dev/dri/renderD128");
+	make_fd(200, 5, "/dev/dri/renderD128");
+	i915_client(200, 3, 7, 1000000, 4);
+	i915_client(200, 5, 7, 1000000, 4);
+
+	make_proc(201, 200);
+	make_fd(201, 7, "/dev/dri/renderD129");
+	xe_client(201, 7, 3, 100, 1000);
+
+	make_proc(300, 1);
+	make_fd(300, 3, "/dev/dri/renderD128");
+	i915_client(300, 3, 9, 5000000, 16);
+
+	make_proc(400, 201);
+	make_fd(400, 1, "/dev/dri/by-path");
+	write_fdinfo(400, 1, "pos:\t0\nflags:\t0\n");
+}
+
+static const igt_drm_usage_engine_t *
+find_engine(const igt_drm_usage_engine_t *e, int count,
+	    const char *pdev, const char *name)
+{
+	for (int i = 0; i < count; i++)
+		if (!strcmp(e[i].pdev, pdev) && !strcmp(e[i].name, name))
+			return &e[i];
+
+	igt_assert_f(0, "engine %s/%s not found\n", pdev, name);
+	return NULL;
+}
+
+static void check_engines(igt_drm_usage_t *usage, uint64_t render_ns,
+			  uint64_t rcs_ns)
+{
+	const igt_drm_usage_engine_t *e;
+	igt_drm_usage_engine_t *engines;
+	int count;
+
+	count = igt_drm_usage_engines(usage, &engines);
+	igt_assert_eq(count, 4);
+
+	e = find_engine(engines, count, IGPU, "render");
+	igt_assert_eq_u64(e->busy_ns, render_ns);
+	igt_assert_eq(e->capacity, 1);
+
+	/* busy before the first sample, idle since */
+	e = find_engine(engines, count, IGPU, "copy");
+	igt_assert_eq_u64(e->busy_ns, 0);
+
+	e = find_engine(engines, count, IGPU, "video");
+	igt_assert_eq_u64(e->busy_ns, 0);
+	igt_assert_eq(e->capacity, 2);
+
+	e = find_engine(engines, count, DGPU, "rcs");
+	igt_assert_eq_u64(e->busy_ns, rcs_ns);
+
+	free(engines);
+}
+
+static void test_tree(void)
+{
+	igt_drm_usage_t *usage;
+
+	usage = igt_drm_usage_create(root, ROOT_PID, 0);
+	igt_assert(usage);
+
+	/* the dup of client 7 is only accounted once, 100 and 300 not at all */
+	igt_assert_eq(igt_drm_usage_sample(usage, 1000000), 2);
+	igt_assert_eq(usage->num_clients, 2);
+	for (int i = 0; i < usage->num_clients; i++) {
+		igt_assert(usage->clients[i].first.id == 7 ||
+			   usage->clients[i].first.id == 3);
+		igt_assert_eq(usage->clients[i].held_fd, -1);
+	}
+
+	/* nothing is known to have run since the clients were first seen */
+	check_engines(usage, 0, 0);
+
+	igt_drm_usage_destroy(usage);
+
+	igt_assert(!igt_drm_usage_create("/nonexistent/proc", ROOT_PID, 0));
+}
+
+static void make_task(pid_t pid, const char *children)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "%d/task/%d", pid, pid);
+	scratch_mkdirs(root, path);
+
+	snprintf(path, sizeof(path), "%d/task/%d/children", pid, pid);
+	scratch_write(root, path, children);
+}
+
+static void test_children(void)
+{
+	static const pid_t tree[] = { ROOT_PID, 200, 201 };
+	char path[PATH_MAX];
+	igt_drm_usage_t *usage;
+
+	make_task(ROOT_PID, "200 ");
+	make_task(200, "201 ");
+	make_task(201, "400 ");
+
+	/* the tree comes from the children files, not from the parents */
+	snprintf(path, sizeof(path), "%s/200/status", root);
+	igt_assert_eq(unlink(path), 0);
+	snprintf(path, sizeof(path), "%s/201/status", root);
+	igt_assert_eq(unlink(path), 0);
+
+	usage = igt_drm_usage_create(root, ROOT_PID, 0);
+	igt_assert(usage);
+	igt_assert_eq(igt_drm_usage_sample(usage, 1000000), 2);
+	igt_assert_eq(usage->num_clients, 2);
+	igt_drm_usage_destroy(usage);
+
+	make_status(200, ROOT_PID);
+	make_status(201, 200);
+	for (int i = 0; i < ARRAY_SIZE(tree); i++) {
+		snprintf(path, sizeof(path), "%d/task", tree[i]);
+		scratch_remove(root, path);
+	}
+}
+
+static void test_samples(void)
+{
+	igt_drm_usage_region_t *regions;
+	igt_drm_usage_t *usage;
+	int count;
+
+	usage = igt_drm_usage_create(root, ROOT_PID, 0);
+	igt_assert(usage);
+
+	i915_client(200, 3, 7, 1000000, 4);
+	i915_client(200, 5, 7, 1000000, 4);
+	xe_client(201, 7, 3, 100, 1000);
+	igt_assert_eq(igt_drm_usage_sample(usage, 1000000), 2);
+
+	/* 1000 ticks per 1ms, so 200 more cycles are 200us */
+	i915_client(200, 3, 7, 3000000, 6);
+	i915_client(200, 5, 7, 3000000, 6);
+	xe_client(201, 7, 3, 300, 2000);
+	igt_assert_eq(igt_drm_usage_sample(usage, 2000000), 2);
+	check_engines(usage, 2000000, 200000);
+
+	/* the last sample of an exited process is kept */
+	i915_client(200, 3, 7, 4000000, 2);
+	i915_client(200, 5, 7, 4000000, 2);
+	scratch_remove(root, "201");
+	igt_assert_eq(igt_drm_usage_sample(usage, 3000000), 1);
+	check_engines(usage, 3000000, 200000);
+
+	count = igt_drm_usage_regions(usage, &regions);
+	igt_assert_eq(count, 2);
+	for (int i = 0; i < count; i++) {
+		if (!strcmp(regions[i].name, "system0")) {
+			igt_assert(!strcmp(regions[i].pdev, IGPU));
+			igt_assert_eq_u64(regions[i].peak_resident, 6 << 20);
+			igt_assert_eq_u64(regions[i].resident, 2 << 20);
+			igt_assert_eq_u64(regions[i].total, 8 << 20);
+		} else {
+			igt_assert(!strcmp(regions[i].name, "vram0"));
+			igt_assert(!strcmp(regions[i].pdev, DGPU));
+			igt_assert_eq_u64(regions[i].peak_resident, 64 << 20);
+			/* 201 has exited */
+			igt_assert_eq_u64(regions[i].resident, 0);
+		}
+	}
+	free(regions);
+
+	igt_drm_usage_destroy(usage);
+}
+
+igt_main
+{
+	igt_fixture
+		make_tree();
+
+	igt_describe("Find the clients of the descendants of a process");
+	igt_subtest("tree")
+		test_tree();
+
+	igt_describe("Find the descendants of a process from their children files");
+	igt_subtest("children")
+		test_children();
+
+	igt_describe("Accumulate engine time and memory over several samples");
+	igt_subtest("samples")
+		test_samples();
+
+	igt_fixture
+		scratch_remove(root, NULL);
+}
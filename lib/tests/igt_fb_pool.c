@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drm_fourcc.h"
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_fb_pool.h"
+#include "igt_rand.h"
+
+IGT_TEST_DESCRIPTION("Check the framebuffer pool policy against a fake allocator");
+
+#define MAX_FBS (1 << 14)
+
+/* Framebuffers as ids, with a word standing for their contents */
+struct fake {
+	uint32_t next_id;
+	bool live[MAX_FBS];
+	uint32_t contents[MAX_FBS];
+	int created;
+	int destroyed;
+	int cleared;
+};
+
+static unsigned int fake_create(struct igt_fb_pool *pool, int width, int height,
+				uint32_t format, uint64_t modifier,
+				struct igt_fb *fb)
+{
+	struct fake *f = pool->priv;
+
+	igt_assert(f->next_id < MAX_FBS - 1);
+
+	memset(fb, 0, sizeof(*fb));
+	fb->fb_id = ++f->next_id;
+	fb->fd = pool->fd;
+	fb->width = width;
+	fb->height = height;
+	fb->drm_format = format;
+	fb->modifier = modifier;
+	fb->size = (uint64_t)width * height * 4;
+
+	f->live[fb->fb_id] = true;
+	f->contents[fb->fb_id] = 0;
+	f->created++;
+
+	return fb->fb_id;
+}
+
+static void fake_destroy(struct igt_fb_pool *pool, struct igt_fb *fb)
+{
+	struct fake *f = pool->priv;
+
+	igt_assert(f->live[fb->fb_id]);
+	f->live[fb->fb_id] = false;
+	f->destroyed++;
+}
+
+static void fake_clear(struct igt_fb_pool *pool, struct igt_fb *fb)
+{
+	struct fake *f = pool->priv;
+
+	igt_assert(f->live[fb->fb_id]);
+	f->contents[fb->fb_id] = 0;
+	f->cleared++;
+}
+
+static const struct igt_fb_pool_ops fake_ops = {
+	.create = fake_create,
+	.destroy = fake_destroy,
+	.clear = fake_clear,
+};
+
+#define FB_SIZE(w, h) ((uint64_t)(w) * (h) * 4)
+
+static void test_reuse(void)
+{
+	struct fake f = {};
+	struct igt_fb_pool *pool = __igt_fb_pool_create(-1, FB_SIZE(64, 64) * 8,
+							&fake_ops, &f);
+	struct igt_fb a, b, c;
+	unsigned int id;
+
+	id = igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+			     DRM_FORMAT_MOD_LINEAR, 0, &a);
+	igt_assert_eq(id, a.fb_id);
+	igt_fb_pool_put(pool, &a);
+	igt_assert_eq(a.fb_id, 0);
+
+	/* the same parameters get the same framebuffer back */
+	igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+			DRM_FORMAT_MOD_LINEAR, 0, &b);
+	igt_assert_eq(b.fb_id, id);
+	igt_assert_eq(pool->stats.hits, 1);
+	igt_assert_eq(pool->stats.misses, 1);
+
+	/* but not while in use, nor for other parameters */
+	igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+			DRM_FORMAT_MOD_LINEAR, 0, &c);
+	igt_assert_neq(c.fb_id, id);
+	igt_fb_pool_put(pool, &c);
+
+	igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+			I915_FORMAT_MOD_X_TILED, 0, &c);
+	igt_fb_pool_put(pool, &c);
+	igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_ARGB8888,
+			DRM_FORMAT_MOD_LINEAR, 0, &c);
+	igt_fb_pool_put(pool, &c);
+	igt_fb_pool_get(pool, 64, 32, DRM_FORMAT_XRGB8888,
+			I915_FORMAT_MOD_X_TILED, 0, &c);
+	igt_fb_pool_put(pool, &c);
+	igt_assert_eq(f.created, 5);
+
+	igt_fb_pool_put(pool, &b);
+	igt_assert_eq(f.destroyed, 0);
+
+	igt_assert_eq(igt_fb_pool_destroy(pool), 0);
+	igt_assert_eq(f.destroyed, f.created);
+}
+
+static void test_clear(void)
+{
+	struct fake f = {};
+	struct igt_fb_pool *pool = __igt_fb_pool_create(-1, FB_SIZE(64, 64) * 8,
+							&fake_ops, &f);
+	struct igt_fb fb;
+
+	/* new framebuffers are clean */
+	igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+			DRM_FORMAT_MOD_LINEAR, IGT_FB_POOL_CLEAR, &fb);
+	igt_assert_eq(f.cleared, 0);
+	f.contents[fb.fb_id] = 0xdead;
+	igt_fb_pool_put(pool, &fb);
+
+	/* recycled ones keep their contents unless asked for a clear */
+	igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+			DRM_FORMAT_MOD_LINEAR, 0, &fb);
+	igt_assert_eq(f.cleared, 0);
+	igt_assert_eq(f.contents[fb.fb_id], 0xdead);
+	igt_fb_pool_put(pool, &fb);
+
+	igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+			DRM_FORMAT_MOD_LINEAR, IGT_FB_POOL_CLEAR, &fb);
+	igt_assert_eq(f.cleared, 1);
+	igt_assert_eq(f.contents[fb.fb_id], 0);
+	igt_assert_eq(pool->stats.clears, 1);
+	igt_fb_pool_put(pool, &fb);
+
+	igt_fb_pool_destroy(pool);
+}
+
+static void test_limit(void)
+{
+	struct fake f = {};
+	struct igt_fb_pool *pool = __igt_fb_pool_create(-1, FB_SIZE(64, 64) * 3,
+							&fake_ops, &f);
+	struct igt_fb fbs[5], fb;
+
+	for (int i = 0; i < ARRAY_SIZE(fbs); i++)
+		igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+				DRM_FORMAT_MOD_LINEAR, 0, &fbs[i]);
+
+	/* the pool limits the idle framebuffers only */
+	igt_assert_eq(f.destroyed, 0);
+
+	/* the least recently returned ones go first */
+	for (int i = 0; i < ARRAY_SIZE(fbs); i++)
+		igt_fb_pool_put(pool, &fbs[i]);
+	igt_assert_eq(f.destroyed, 2);
+	igt_assert(!f.live[1] && !f.live[2]);
+	igt_assert_eq(pool->idle_bytes, FB_SIZE(64, 64) * 3);
+	igt_assert_eq(pool->stats.evictions, 2);
+
+	/* and the most recently returned ones are reused first */
+	igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+			DRM_FORMAT_MOD_LINEAR, 0, &fb);
+	igt_assert_eq(fb.fb_id, 5);
+	igt_fb_pool_put(pool, &fb);
+
+	/* framebuffers larger than the limit are never kept */
+	igt_fb_pool_get(pool, 256, 256, DRM_FORMAT_XRGB8888,
+			DRM_FORMAT_MOD_LINEAR, 0, &fb);
+	igt_fb_pool_put(pool, &fb);
+	igt_assert(!f.live[6]);
+	igt_assert_eq(pool->idle_bytes, FB_SIZE(64, 64) * 3);
+
+	igt_fb_pool_trim(pool, FB_SIZE(64, 64));
+	igt_assert_eq(pool->idle_bytes, FB_SIZE(64, 64));
+	igt_assert(f.live[5]);
+
+	igt_fb_pool_destroy(pool);
+	igt_assert_eq(f.destroyed, f.created);
+}
+
+static void test_leaks(void)
+{
+	struct fake f = {};
+	struct igt_fb_pool *pool = __igt_fb_pool_create(-1, FB_SIZE(64, 64) * 8,
+							&fake_ops, &f);
+	struct igt_fb fbs[3];
+
+	for (int i = 0; i < ARRAY_SIZE(fbs); i++)
+		igt_fb_pool_get(pool, 64, 64, DRM_FORMAT_XRGB8888,
+				DRM_FORMAT_MOD_LINEAR, 0, &fbs[i]);
+	igt_fb_pool_put(pool, &fbs[1]);
+
+	/* returning twice is harmless, the id is reset */
+	igt_fb_pool_put(pool, &fbs[1]);
+	igt_assert_eq(igt_fb_pool_report_leaks(pool), 2);
+
+	/* the leaked ones are left to their users */
+	igt_assert_eq(igt_fb_pool_destroy(pool), 2);
+	igt_assert_eq(f.destroyed, 1);
+	igt_assert(f.live[fbs[0].fb_id] && f.live[fbs[2].fb_id]);
+}
+
+/*
+ * Random gets and puts over a few parameters, checking the pool against
+ * the state of the fake allocator.
+ */
+static void test_random(void)
+{
+	static const uint64_t modifiers[] = {
+		DRM_FORMAT_MOD_LINEAR,
+		I915_FORMAT_MOD_X_TILED,
+		I915_FORMAT_MOD_4_TILED,
+	};
+	static const uint32_t formats[] = {
+		DRM_FORMAT_XRGB8888,
+		DRM_FORMAT_NV12,
+	};
+	const uint64_t limit = FB_SIZE(128, 128) * 6;
+	struct igt_fb held[16] = {};
+	uint32_t seed = 0x5eed;
+	struct fake f = {};
+	struct igt_fb_pool *pool;
+
+	pool = __igt_fb_pool_create(-1, limit, &fake_ops, &f);
+
+	for (int step = 0; step < 5000; step++) {
+		int slot = hars_petruska_f54_1_random(&seed) % ARRAY_SIZE(held);
+		struct igt_fb *fb = &held[slot];
+		int live = 0, held_count = 0;
+
+		if (fb->fb_id) {
+			f.contents[fb->fb_id] = step + 1;
+			igt_fb_pool_put(pool, fb);
+		} else {
+			bool clear = hars_petruska_f54_1_random(&seed) & 1;
+			int size = 64 << (hars_petruska_f54_1_random(&seed) % 2);
+
+			igt_fb_pool_get(pool, size, size,
+					formats[hars_petruska_f54_1_random(&seed) % ARRAY_SIZE(formats)],
+					modifiers[hars_petruska_f54_1_random(&seed) % ARRAY_SIZE(modifiers)],
+					clear ? IGT_FB_POOL_CLEAR : 0, fb);
+			igt_assert(f.live[fb->fb_id]);
+			igt_assert_eq(fb->width, size);
+			if (clear)
+				igt_assert_eq(f.contents[fb->fb_id], 0);
+
+			/* never handed out twice */
+			for (int i = 0; i < ARRAY_SIZE(held); i++)
+				igt_assert(i == slot || held[i].fb_id != fb->fb_id);
+		}
+
+		igt_assert_lte_u64(pool->idle_bytes, limit);
+		for (int i = 0; i <= f.next_id; i++)
+			live += f.live[i];
+		for (int i = 0; i < ARRAY_SIZE(held); i++)
+			held_count += !!held[i].fb_id;
+		igt_assert_eq(live, held_count + igt_list_length(&pool->idle));
+	}
+
+	igt_info("%"PRIu64" hits, %"PRIu64" misses, %"PRIu64" clears, %"PRIu64" evictions\n",
+		 pool->stats.hits, pool->stats.misses,
+		 pool->stats.clears, pool->stats.evictions);
+	igt_assert(pool->stats.hits > pool->stats.misses);
+
+	for (int i = 0; i < ARRAY_SIZE(held); i++)
+		igt_fb_pool_put(pool, &held[i]);
+	igt_assert_eq(igt_fb_pool_destroy(pool), 0);
+	igt_assert_eq(f.destroyed, f.created);
+}
+
+igt_main
+{
+	igt_describe("Returned framebuffers are handed out again for the same parameters");
+	igt_subtest("reuse")
+		test_reuse();
+
+	igt_describe("Recycled framebuffers are cleared on demand, and only if used");
+	igt_subtest("clear")
+		test_clear();
+
+	igt_describe("Idle framebuffers beyond the limit are removed, oldest first");
+	igt_subtest("limit")
+		test_limit();
+
+	igt_describe("Framebuffers not returned are reported, and left alone");
+	igt_subtest("leaks")
+		test_leaks();
+
+	igt_describe("Random use keeps the pool consistent with the allocator");
+	igt_subtest("random")
+		test_random();
+}
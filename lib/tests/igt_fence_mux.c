@@ -0,0 +1,330 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "drmtest.h"
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_fence_mux.h"
+#include "igt_rand.h"
+#include "sw_sync.h"
+
+IGT_TEST_DESCRIPTION("Check the fence multiplexer with eventfd and sw_sync fences");
+
+#define MANY 4000
+
+/* An eventfd standing in for a fence, signaled by writing to it */
+struct mock {
+	int fd;
+	int64_t signaled_ns;
+	int64_t completed_ns;
+	int status;
+	int calls;
+};
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void completed(void *data, int status, uint64_t timestamp_ns)
+{
+	struct mock *m = data;
+
+	m->status = status;
+	m->completed_ns = timestamp_ns;
+	m->calls++;
+}
+
+static void mock_add(igt_fence_mux_t *mux, struct mock *m)
+{
+	m->fd = eventfd(0, EFD_CLOEXEC);
+	igt_assert(m->fd >= 0);
+	m->signaled_ns = 0;
+	m->calls = 0;
+
+	/* the mux owns a duplicate, as it closes it on completion */
+	igt_fence_mux_add_fd(mux, dup(m->fd), completed, m);
+}
+
+static void mock_signal(struct mock *m)
+{
+	uint64_t one = 1;
+
+	m->signaled_ns = now_ns();
+	igt_assert_eq(write(m->fd, &one, sizeof(one)), sizeof(one));
+	close(m->fd);
+}
+
+static void require_files(int count)
+{
+	struct rlimit rlim;
+
+	igt_assert(!getrlimit(RLIMIT_NOFILE, &rlim));
+	rlim.rlim_cur = rlim.rlim_max;
+	igt_assert(!setrlimit(RLIMIT_NOFILE, &rlim));
+	igt_require_f(rlim.rlim_cur >= 2 * count + 64,
+		      "Needs %d files, %lu allowed\n", 2 * count + 64,
+		      (unsigned long)rlim.rlim_cur);
+}
+
+static void test_any(void)
+{
+	struct mock mocks[16];
+	igt_fence_mux_t mux;
+	int64_t start;
+
+	igt_fence_mux_init(&mux);
+	for (int i = 0; i < ARRAY_SIZE(mocks); i++)
+		mock_add(&mux, &mocks[i]);
+
+	/* nothing signaled, until the deadline */
+	start = now_ns();
+	igt_assert_eq(igt_fence_mux_wait_any(&mux, igt_fence_mux_deadline(20 * 1000 * 1000)),
+		      -ETIME);
+	igt_assert_lte_s64(20 * 1000 * 1000, now_ns() - start);
+	igt_assert_eq(igt_fence_mux_wait_any(&mux, 0), -ETIME);
+
+	mock_signal(&mocks[3]);
+	mock_signal(&mocks[11]);
+	igt_assert_eq(igt_fence_mux_wait_any(&mux, IGT_FENCE_MUX_FOREVER), 2);
+	for (int i = 0; i < ARRAY_SIZE(mocks); i++) {
+		igt_assert_eq(mocks[i].calls, i == 3 || i == 11);
+		if (mocks[i].calls) {
+			igt_assert_eq(mocks[i].status, 1);
+			igt_assert_lte_s64(mocks[i].signaled_ns, mocks[i].completed_ns);
+		}
+	}
+	igt_assert_eq(mux.num_pending, ARRAY_SIZE(mocks) - 2);
+
+	/* each fence is delivered once */
+	igt_assert_eq(igt_fence_mux_wait_any(&mux, 0), -ETIME);
+
+	for (int i = 0; i < ARRAY_SIZE(mocks); i++)
+		if (i != 3 && i != 11)
+			close(mocks[i].fd);
+	igt_fence_mux_fini(&mux);
+}
+
+struct signaler {
+	struct mock *mocks;
+	int count;
+	int64_t delay_ns;
+};
+
+/* Signals the mocks in a random order */
+static void *signal_thread(void *arg)
+{
+	struct signaler *s = arg;
+	uint32_t seed = 1;
+	int *order;
+
+	order = malloc(s->count * sizeof(*order));
+	igt_assert(order);
+	for (int i = 0; i < s->count; i++)
+		order[i] = i;
+	igt_permute_array(order, s->count, igt_exchange_int);
+
+	for (int i = 0; i < s->count; i++) {
+		if (s->delay_ns && hars_petruska_f54_1_random(&seed) % 64 == 0)
+			nanosleep(&(struct timespec){ .tv_nsec = s->delay_ns }, NULL);
+		mock_signal(&s->mocks[order[i]]);
+	}
+	free(order);
+
+	return NULL;
+}
+
+static void test_all(int count, int64_t delay_ns)
+{
+	struct signaler s = { .count = count, .delay_ns = delay_ns };
+	igt_fence_mux_t mux;
+	pthread_t thread;
+
+	require_files(count);
+
+	s.mocks = calloc(count, sizeof(*s.mocks));
+	igt_assert(s.mocks);
+
+	igt_fence_mux_init(&mux);
+	for (int i = 0; i < count; i++)
+		mock_add(&mux, &s.mocks[i]);
+
+	pthread_create(&thread, NULL, signal_thread, &s);
+	igt_assert_eq(igt_fence_mux_wait_all(&mux, igt_fence_mux_deadline(10ll * NSEC_PER_SEC)),
+		      count);
+	pthread_join(thread, NULL);
+
+	igt_assert_eq(mux.num_pending, 0);
+	igt_assert_eq(mux.completed, count);
+	for (int i = 0; i < count; i++) {
+		igt_assert_eq(s.mocks[i].calls, 1);
+		igt_assert_lte_s64(s.mocks[i].signaled_ns, s.mocks[i].completed_ns);
+	}
+
+	igt_fence_mux_fini(&mux);
+	free(s.mocks);
+}
+
+static void test_deadline(void)
+{
+	struct mock mocks[8];
+	igt_fence_mux_t mux;
+
+	igt_fence_mux_init(&mux);
+	for (int i = 0; i < ARRAY_SIZE(mocks); i++)
+		mock_add(&mux, &mocks[i]);
+
+	/* the completed ones are delivered even if the wait times out */
+	for (int i = 1; i < ARRAY_SIZE(mocks); i++)
+		mock_signal(&mocks[i]);
+	igt_assert_eq(igt_fence_mux_wait_all(&mux, igt_fence_mux_deadline(10 * 1000 * 1000)),
+		      -ETIME);
+	for (int i = 0; i < ARRAY_SIZE(mocks); i++)
+		igt_assert_eq(mocks[i].calls, i > 0);
+
+	mock_signal(&mocks[0]);
+	igt_assert_eq(igt_fence_mux_wait_all(&mux, IGT_FENCE_MUX_FOREVER), 1);
+	igt_assert_eq(mocks[0].calls, 1);
+
+	/* nothing left to wait for */
+	igt_assert_eq(igt_fence_mux_wait_all(&mux, 0), 0);
+	igt_assert_eq(igt_fence_mux_wait_any(&mux, IGT_FENCE_MUX_FOREVER), 0);
+
+	igt_fence_mux_fini(&mux);
+}
+
+struct chain {
+	igt_fence_mux_t *mux;
+	int remaining;
+};
+
+/* Each completion adds the next fence of the chain, already signaled */
+static void chained(void *data, int status, uint64_t timestamp_ns)
+{
+	struct chain *c = data;
+
+	igt_assert_eq(status, 1);
+	if (!c->remaining--)
+		return;
+
+	igt_fence_mux_add_fd(c->mux, eventfd(1, EFD_CLOEXEC), chained, c);
+}
+
+static void test_chain(void)
+{
+	igt_fence_mux_t mux;
+	struct chain c = { .mux = &mux, .remaining = 100 };
+
+	igt_fence_mux_init(&mux);
+	igt_fence_mux_add_fd(&mux, eventfd(1, EFD_CLOEXEC), chained, &c);
+
+	igt_assert_eq(igt_fence_mux_wait_all(&mux, igt_fence_mux_deadline(NSEC_PER_SEC)),
+		      101);
+	igt_assert_eq(c.remaining, -1);
+
+	igt_fence_mux_fini(&mux);
+}
+
+struct sync_fence {
+	uint32_t seqno;
+	int status;
+	uint64_t timestamp_ns;
+	int calls;
+};
+
+static void sync_completed(void *data, int status, uint64_t timestamp_ns)
+{
+	struct sync_fence *f = data;
+
+	f->status = status;
+	f->timestamp_ns = timestamp_ns;
+	f->calls++;
+}
+
+/* sw_sync fences and eventfds mixed, the timestamps are the signal times */
+static void test_sw_sync(void)
+{
+	struct sync_fence fences[64] = {};
+	struct mock mock;
+	igt_fence_mux_t mux;
+	int64_t before;
+	int timeline;
+
+	igt_require_sw_sync();
+
+	timeline = sw_sync_timeline_create();
+	igt_fence_mux_init(&mux);
+
+	for (int i = 0; i < ARRAY_SIZE(fences); i++) {
+		fences[i].seqno = i + 1;
+		igt_fence_mux_add_sync_file(&mux,
+					    sw_sync_timeline_create_fence(timeline, i + 1),
+					    sync_completed, &fences[i]);
+	}
+	mock_add(&mux, &mock);
+
+	before = now_ns();
+	sw_sync_timeline_inc(timeline, 16);
+	igt_assert_eq(igt_fence_mux_wait_any(&mux, igt_fence_mux_deadline(NSEC_PER_SEC)),
+		      16);
+	for (int i = 0; i < ARRAY_SIZE(fences); i++) {
+		igt_assert_eq(fences[i].calls, i < 16);
+		if (i < 16) {
+			igt_assert_eq(fences[i].status, SW_SYNC_FENCE_STATUS_SIGNALED);
+			igt_assert_lte_s64(before, fences[i].timestamp_ns);
+			igt_assert_lte_s64(fences[i].timestamp_ns, now_ns());
+		}
+	}
+
+	mock_signal(&mock);
+	sw_sync_timeline_inc(timeline, ARRAY_SIZE(fences) - 16);
+	igt_assert_eq(igt_fence_mux_wait_all(&mux, igt_fence_mux_deadline(NSEC_PER_SEC)),
+		      ARRAY_SIZE(fences) - 16 + 1);
+	igt_assert_eq(mock.calls, 1);
+	for (int i = 0; i < ARRAY_SIZE(fences); i++)
+		igt_assert_eq(fences[i].calls, 1);
+
+	igt_fence_mux_fini(&mux);
+	close(timeline);
+}
+
+igt_main
+{
+	igt_describe("Waiting for any fence delivers the signaled ones");
+	igt_subtest("any")
+		test_any();
+
+	igt_describe("Waiting for all fences, signaled from another thread");
+	igt_subtest("all")
+		test_all(256, 100 * 1000);
+
+	igt_describe("Waiting for thousands of fences at once");
+	igt_subtest("many")
+		test_all(MANY, 0);
+
+	igt_describe("Waits give up at their deadline");
+	igt_subtest("deadline")
+		test_deadline();
+
+	igt_describe("Callbacks can add fences to the same wait");
+	igt_subtest("chain")
+		test_chain();
+
+	igt_describe("sw_sync fences report their own signal times");
+	igt_subtest("sw-sync")
+		test_sw_sync();
+}
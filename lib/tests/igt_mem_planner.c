@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_os.h"
+
+#include "igt_tests_common.h"
+
+IGT_TEST_DESCRIPTION("Exercise the memory planner against fake procfs and cgroup files");
+
+#define MiB(x) ((uint64_t)(x) << 20)
+
+static char root[] = "/tmp/igt_mem_planner.XXXXXX";
+static char procfs[PATH_MAX], cgroupfs[PATH_MAX];
+
+__attribute__((format(printf, 2, 3)))
+static void write_file(const char *path, const char *fmt, ...)
+{
+	char buf[1024];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	scratch_write(root, path, buf);
+}
+
+static void write_meminfo(uint64_t avail_kb, uint64_t swap_free_kb)
+{
+	write_file("proc/meminfo",
+		   "MemTotal:       16384000 kB\n"
+		   "MemFree:         1024000 kB\n"
+		   "MemAvailable:    %"PRIu64" kB\n"
+		   "Buffers:           10240 kB\n"
+		   "Cached:           102400 kB\n"
+		   "SwapCached:        20480 kB\n"
+		   "SwapTotal:       4096000 kB\n"
+		   "SwapFree:        %"PRIu64" kB\n"
+		   "HugePages_Total:      64\n"
+		   "HugePages_Free:       48\n"
+		   "HugePages_Rsvd:        0\n"
+		   "Hugepagesize:       2048 kB\n",
+		   avail_kb, swap_free_kb);
+}
+
+static void write_pressure(const char *path, double some_avg10,
+			   uint64_t some_total, double full_avg10,
+			   uint64_t full_total)
+{
+	write_file(path,
+		   "some avg10=%.2f avg60=0.00 avg300=0.00 total=%"PRIu64"\n"
+		   "full avg10=%.2f avg60=0.00 avg300=0.00 total=%"PRIu64"\n",
+		   some_avg10, some_total, full_avg10, full_total);
+}
+
+static void write_cgroup(const char *dir, const char *max, uint64_t current,
+			 uint64_t file, const char *swap_max,
+			 uint64_t swap_current)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "cgroup/%s/memory.max", dir);
+	write_file(path, "%s\n", max);
+	snprintf(path, sizeof(path), "cgroup/%s/memory.current", dir);
+	write_file(path, "%"PRIu64"\n", current);
+	snprintf(path, sizeof(path), "cgroup/%s/memory.stat", dir);
+	write_file(path, "anon 1234\nfile %"PRIu64"\nfile_mapped 4321\n", file);
+	snprintf(path, sizeof(path), "cgroup/%s/memory.swap.max", dir);
+	write_file(path, "%s\n", swap_max);
+	snprintf(path, sizeof(path), "cgroup/%s/memory.swap.current", dir);
+	write_file(path, "%"PRIu64"\n", swap_current);
+}
+
+static void make_tree(void)
+{
+	scratch_create(root);
+
+	scratch_mkdirs(root, "proc/self");
+	scratch_mkdir(root, "proc/pressure");
+	scratch_mkdirs(root, "cgroup/test.slice/job");
+
+	snprintf(procfs, sizeof(procfs), "%s/proc", root);
+	snprintf(cgroupfs, sizeof(cgroupfs), "%s/cgroup", root);
+
+	write_meminfo(8192000, 2048000);
+	write_pressure("proc/pressure/memory", 0, 0, 0, 0);
+}
+
+static uint64_t reserve(const struct igt_mem_info *info)
+{
+	return min(max(info->ram_total >> 6, MiB(32)), MiB(1024));
+}
+
+static void test_meminfo(void)
+{
+	const struct igt_mem_info *info;
+	struct igt_mem_planner *planner;
+
+	write_file("proc/self/cgroup", "0::/\n");
+	planner = igt_mem_planner_create(procfs, cgroupfs);
+	info = igt_mem_planner_info(planner);
+
+	igt_assert_eq_u64(info->ram_total, 16384000ull << 10);
+	igt_assert_eq_u64(info->ram_available,
+			  (8192000ull + 10240 + 102400 + 20480) << 10);
+	igt_assert_eq_u64(info->swap_total, 4096000ull << 10);
+	igt_assert_eq_u64(info->swap_free, 2048000ull << 10);
+	igt_assert_eq_u64(info->hugepage_size, MiB(2));
+	igt_assert_eq_u64(info->hugepages_total, 64);
+	igt_assert_eq_u64(info->hugepages_free, 48);
+
+	/* no cgroup limits in the root cgroup */
+	igt_assert_eq_u64(info->cgroup_limit, UINT64_MAX);
+	igt_assert_eq_u64(info->cgroup_headroom, UINT64_MAX);
+
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_RAM),
+			  info->ram_available - reserve(info));
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_RAM | CHECK_SWAP),
+			  info->ram_available - reserve(info) + info->swap_free);
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_HUGEPAGES),
+			  MiB(96));
+	/* hugepages come on top of the rest */
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_RAM | CHECK_HUGEPAGES),
+			  info->ram_available - reserve(info) + MiB(96));
+
+	/* a refresh rereads the already open files */
+	write_meminfo(1024, 0);
+	igt_assert_eq(igt_mem_planner_refresh(planner), 0);
+	igt_assert_eq_u64(info->ram_available,
+			  (1024ull + 10240 + 102400 + 20480) << 10);
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_RAM), 0);
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_RAM | CHECK_SWAP), 0);
+
+	write_meminfo(8192000, 2048000);
+	igt_mem_planner_destroy(planner);
+}
+
+static void test_cgroup(void)
+{
+	const struct igt_mem_info *info;
+	struct igt_mem_planner *planner;
+
+	write_file("proc/self/cgroup", "0::/test.slice/job\n");
+
+	/* the parent is the tighter limit, part of its usage is page cache */
+	write_cgroup("test.slice", "1073741824", MiB(900), MiB(300), "max", 0);
+	write_cgroup("test.slice/job", "max", MiB(600), MiB(100), "268435456", MiB(56));
+
+	planner = igt_mem_planner_create(procfs, cgroupfs);
+	info = igt_mem_planner_info(planner);
+
+	igt_assert_eq_u64(info->cgroup_limit, MiB(1024));
+	igt_assert_eq_u64(info->cgroup_headroom, MiB(1024 - 600));
+	igt_assert_eq_u64(info->cgroup_swap_headroom, MiB(200));
+
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_RAM),
+			  MiB(424) - reserve(info));
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_RAM | CHECK_SWAP),
+			  MiB(424) - reserve(info) + MiB(200));
+
+	/* the job grows past its parent limit */
+	write_cgroup("test.slice/job", "536870912", MiB(2000), 0, "max", 0);
+	igt_assert_eq(igt_mem_planner_refresh(planner), 0);
+	igt_assert_eq_u64(info->cgroup_limit, MiB(512));
+	igt_assert_eq_u64(info->cgroup_headroom, 0);
+	igt_assert_eq_u64(info->cgroup_swap_headroom, UINT64_MAX);
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_RAM), 0);
+
+	/* hugepages are not charged to the memory controller */
+	igt_assert_eq_u64(igt_mem_planner_budget(planner, CHECK_HUGEPAGES),
+			  MiB(96));
+
+	igt_mem_planner_destroy(planner);
+}
+
+static void test_pressure(void)
+{
+	struct igt_mem_planner *planner;
+
+	write_file("proc/self/cgroup", "0::/test.slice/job\n");
+	write_pressure("cgroup/test.slice/job/memory.pressure", 0, 1000, 0, 500);
+
+	planner = igt_mem_planner_create(procfs, cgroupfs);
+	igt_assert(igt_mem_planner_info(planner)->has_psi);
+
+	igt_assert_eq(igt_mem_planner_pressure(planner), IGT_MEM_PRESSURE_NONE);
+	igt_assert_eq(igt_mem_planner_pressure(planner), IGT_MEM_PRESSURE_NONE);
+	igt_assert_eq(igt_mem_planner_throttle(planner, 1000), 0);
+
+	write_pressure("cgroup/test.slice/job/memory.pressure", 25.0, 1000, 0, 500);
+	igt_assert_eq(igt_mem_planner_pressure(planner), IGT_MEM_PRESSURE_THROTTLE);
+	igt_assert_lte(30, igt_mem_planner_throttle(planner, 30));
+
+	igt_mem_planner_set_thresholds(planner, 30.0, 50.0);
+	igt_assert_eq(igt_mem_planner_pressure(planner), IGT_MEM_PRESSURE_NONE);
+
+	/* a burst of full stalls is caught before it shows in avg10 */
+	write_pressure("cgroup/test.slice/job/memory.pressure",
+		       25.0, 100000000, 0, 100000000);
+	igt_assert_eq(igt_mem_planner_pressure(planner), IGT_MEM_PRESSURE_ABORT);
+	igt_assert_eq(igt_mem_planner_pressure(planner), IGT_MEM_PRESSURE_NONE);
+
+	igt_mem_planner_destroy(planner);
+
+	/* without a cgroup pressure file the system one is used */
+	snprintf(procfs, sizeof(procfs), "%s/cgroup/test.slice/job/memory.pressure", root);
+	igt_assert_eq(unlink(procfs), 0);
+	snprintf(procfs, sizeof(procfs), "%s/proc", root);
+
+	write_pressure("proc/pressure/memory", 12.0, 0, 0, 0);
+	planner = igt_mem_planner_create(procfs, cgroupfs);
+	igt_assert(igt_mem_planner_info(planner)->has_psi);
+	igt_assert_eq(igt_mem_planner_pressure(planner), IGT_MEM_PRESSURE_THROTTLE);
+	igt_mem_planner_destroy(planner);
+
+	/* and no pressure information means no throttling */
+	snprintf(procfs, sizeof(procfs), "%s/proc/pressure/memory", root);
+	igt_assert_eq(unlink(procfs), 0);
+	snprintf(procfs, sizeof(procfs), "%s/proc", root);
+
+	planner = igt_mem_planner_create(procfs, cgroupfs);
+	igt_assert(!igt_mem_planner_info(planner)->has_psi);
+	igt_assert_eq(igt_mem_planner_pressure(planner), IGT_MEM_PRESSURE_NONE);
+	igt_mem_planner_destroy(planner);
+}
+
+igt_main
+{
+	igt_fixture
+		make_tree();
+
+	igt_describe("Check the meminfo fields and the budgets derived from them");
+	igt_subtest("meminfo")
+		test_meminfo();
+
+	igt_describe("Check the budget honors the tightest cgroup limit");
+	igt_subtest("cgroup")
+		test_cgroup();
+
+	igt_describe("Check memory pressure is classified against the thresholds");
+	igt_subtest("pressure")
+		test_pressure();
+
+	igt_fixture
+		scratch_remove(root, NULL);
+}
@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_probe_cache.h"
+
+IGT_TEST_DESCRIPTION("Check the on-disk probe cache with injected probes");
+
+struct probe {
+	uint64_t value;
+	unsigned int *calls;
+};
+
+static uint64_t counting_probe(int fd, const void *data)
+{
+	const struct probe *p = data;
+
+	(*p->calls)++;
+	return p->value;
+}
+
+static uint64_t failing_probe(int fd, const void *data)
+{
+	igt_assert_f(0, "%s should have been cached\n", (const char *)data);
+	return 0;
+}
+
+static void key_init(igt_probe_cache_key_t *key, uint16_t devid,
+		     const char *kernel, uint64_t params)
+{
+	memset(key, 0, sizeof(*key));
+	key->devid = devid;
+	strcpy(key->slot, "0000:03:00.0");
+	strcpy(key->kernel, kernel);
+	key->params = params;
+}
+
+static char *make_dir(void)
+{
+	static char dir[64];
+
+	strcpy(dir, "/tmp/igt_probe_cache.XXXXXX");
+	igt_assert(mkdtemp(dir));
+	igt_probe_cache_drop();
+
+	return dir;
+}
+
+/* Only the cache and its lock file are left behind */
+static void remove_dir(const char *dir)
+{
+	char filename[PATH_MAX];
+	struct dirent *de;
+	DIR *d;
+
+	d = opendir(dir);
+	igt_assert(d);
+	while ((de = readdir(d))) {
+		if (de->d_name[0] == '.')
+			continue;
+
+		igt_assert_f(!strcmp(de->d_name, "0000:03:00.0.probes") ||
+			     !strcmp(de->d_name, "0000:03:00.0.lock"),
+			     "Unexpected %s\n", de->d_name);
+		snprintf(filename, sizeof(filename), "%s/%s", dir, de->d_name);
+		unlink(filename);
+	}
+	closedir(d);
+	rmdir(dir);
+	igt_probe_cache_drop();
+}
+
+static void test_hit(void)
+{
+	unsigned int calls = 0;
+	struct probe p = { .value = 0x10000, .calls = &calls };
+	igt_probe_cache_key_t key;
+	char *dir = make_dir();
+
+	key_init(&key, 0x56a0, "abcdef", 1);
+
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "min-alignment-0-1",
+					    counting_probe, -1, &p), 0x10000);
+	igt_assert_eq(calls, 1);
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "min-alignment-0-1",
+					    counting_probe, -1, &p), 0x10000);
+	igt_assert_eq(calls, 1);
+
+	/* as another process would */
+	igt_probe_cache_drop();
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "min-alignment-0-1",
+					    failing_probe, -1,
+					    "min-alignment-0-1"), 0x10000);
+
+	p.value = 7;
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "cmdparser-version",
+					    counting_probe, -1, &p), 7);
+	igt_assert_eq(calls, 2);
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "min-alignment-0-1",
+					    failing_probe, -1,
+					    "min-alignment-0-1"), 0x10000);
+
+	remove_dir(dir);
+}
+
+static void test_invalidate(void)
+{
+	igt_probe_cache_key_t keys[4];
+	unsigned int calls = 0;
+	struct probe p = { .calls = &calls };
+	char *dir = make_dir();
+
+	key_init(&keys[0], 0x56a0, "abcdef", 1);
+	key_init(&keys[1], 0x56a1, "abcdef", 1);
+	key_init(&keys[2], 0x56a0, "fedcba", 1);
+	key_init(&keys[3], 0x56a0, "abcdef", 2);
+
+	/* each key change probes again, and replaces the previous probes */
+	for (int round = 0; round < 2; round++) {
+		for (int i = 0; i < ARRAY_SIZE(keys); i++) {
+			p.value = i;
+			igt_assert_eq_u64(__igt_probe_cache(dir, &keys[i], "probe",
+							    counting_probe, -1,
+							    &p), i);
+			igt_probe_cache_drop();
+			igt_assert_eq_u64(__igt_probe_cache(dir, &keys[i], "probe",
+							    failing_probe, -1,
+							    "probe"), i);
+		}
+	}
+	igt_assert_eq(calls, 2 * ARRAY_SIZE(keys));
+
+	remove_dir(dir);
+}
+
+struct nested {
+	const char *dir;
+	const igt_probe_cache_key_t *key;
+	struct probe inner;
+};
+
+static uint64_t nested_probe(int fd, const void *data)
+{
+	const struct nested *n = data;
+
+	return __igt_probe_cache(n->dir, n->key, "inner", counting_probe, fd,
+				 &n->inner) + 1;
+}
+
+static void test_nested(void)
+{
+	igt_probe_cache_key_t key;
+	unsigned int calls = 0;
+	struct nested n = { .inner = { .value = 41, .calls = &calls } };
+	char *dir = make_dir();
+
+	key_init(&key, 0x56a0, "abcdef", 1);
+	n.dir = dir;
+	n.key = &key;
+
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "outer", nested_probe,
+					    -1, &n), 42);
+	igt_probe_cache_drop();
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "outer", failing_probe,
+					    -1, "outer"), 42);
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "inner", failing_probe,
+					    -1, "inner"), 41);
+	igt_assert_eq(calls, 1);
+
+	remove_dir(dir);
+}
+
+/* Concurrent writers merge their probes instead of losing them */
+static void test_concurrent(void)
+{
+	igt_probe_cache_key_t key;
+	char *dir = make_dir();
+	char name[32];
+
+	key_init(&key, 0x56a0, "abcdef", 1);
+
+	igt_fork(child, 8) {
+		igt_probe_cache_drop();
+		for (int i = 0; i < 16; i++) {
+			unsigned int calls = 0;
+			struct probe p = { .value = child << 8 | i,
+					   .calls = &calls };
+
+			snprintf(name, sizeof(name), "child%d-%d", child, i);
+			__igt_probe_cache(dir, &key, name, counting_probe, -1,
+					  &p);
+		}
+	}
+	igt_waitchildren();
+
+	igt_probe_cache_drop();
+	for (int child = 0; child < 8; child++) {
+		for (int i = 0; i < 16; i++) {
+			snprintf(name, sizeof(name), "child%d-%d", child, i);
+			igt_assert_eq_u64(__igt_probe_cache(dir, &key, name,
+							    failing_probe, -1,
+							    name),
+					  child << 8 | i);
+		}
+	}
+
+	remove_dir(dir);
+}
+
+static void test_corrupt(void)
+{
+	unsigned int calls = 0;
+	struct probe p = { .value = 3, .calls = &calls };
+	igt_probe_cache_key_t key;
+	char filename[PATH_MAX];
+	char *dir = make_dir();
+	FILE *f;
+
+	key_init(&key, 0x56a0, "abcdef", 1);
+
+	snprintf(filename, sizeof(filename), "%s/0000:03:00.0.probes", dir);
+	f = fopen(filename, "w");
+	igt_assert(f);
+	fprintf(f, "devid 0x56a0\nslot 0000:03:00.0\nkern");
+	fclose(f);
+
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "probe",
+					    counting_probe, -1, &p), 3);
+	igt_assert_eq(calls, 1);
+	igt_probe_cache_drop();
+	igt_assert_eq_u64(__igt_probe_cache(dir, &key, "probe",
+					    failing_probe, -1, "probe"), 3);
+
+	remove_dir(dir);
+}
+
+/* Without a PCI device behind the fd, each lookup probes */
+static void test_no_device(void)
+{
+	unsigned int calls = 0;
+	struct probe p = { .value = 0x1000, .calls = &calls };
+	char *dir = make_dir();
+	int fd;
+
+	setenv("IGT_PROBE_CACHE", dir, 1);
+
+	fd = open("/dev/null", O_RDONLY);
+	igt_assert_lte(0, fd);
+	for (int i = 0; i < 2; i++)
+		igt_assert_eq_u64(igt_probe_cache(fd, "min-alignment-0-1",
+						  counting_probe, &p), 0x1000);
+	close(fd);
+
+	fd = open(dir, O_RDONLY | O_DIRECTORY);
+	igt_assert_lte(0, fd);
+	igt_assert_eq_u64(igt_probe_cache(fd, "min-alignment-0-1",
+					  counting_probe, &p), 0x1000);
+	close(fd);
+	igt_assert_eq(calls, 3);
+
+	unsetenv("IGT_PROBE_CACHE");
+	remove_dir(dir);
+}
+
+igt_main
+{
+	igt_describe("Probes are only run once, then read from the cache");
+	igt_subtest("hit")
+		test_hit();
+
+	igt_describe("Any change of the key probes again");
+	igt_subtest("invalidate")
+		test_invalidate();
+
+	igt_describe("Probes can use the cache themselves");
+	igt_subtest("nested")
+		test_nested();
+
+	igt_describe("Concurrent processes don't lose each other's probes");
+	igt_subtest("concurrent")
+		test_concurrent();
+
+	igt_describe("A truncated cache is probed again");
+	igt_subtest("corrupt")
+		test_corrupt();
+
+	igt_describe("Fds of other files are probed each time");
+	igt_subtest("no-device")
+		test_no_device();
+}
@@ -0,0 +1,349 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_proc.h"
+
+#include "igt_tests_common.h"
+
+IGT_TEST_DESCRIPTION("Exercise the /proc process inspector against a synthetic procfs");
+
+static char root[] = "/tmp/igt_proc.XXXXXX";
+
+/* /dev/null is 1:3 and /dev/zero 1:5 on every Linux system */
+static const struct {
+	pid_t pid;
+	const char *comm;
+	unsigned int euid, egid;
+	const char *fds[4];
+} procs[] = {
+	{ 1, "systemd", 0, 0, { "/dev/null", "/dev/null", "/dev/null" } },
+	{ 42, "pipewire-pulse", 1000, 1001, { "/dev/null", "/dev/zero", "card0" } },
+	{ 1234, "Xorg", 0, 44, { "/dev/zero", "card0", "card1", "/dev/zero" } },
+	{ 98765, "idle", 7, 8, { } },
+};
+
+static void make_link(const char *target, const char *path)
+{
+	char full[PATH_MAX], dest[PATH_MAX];
+
+	snprintf(full, sizeof(full), "%s/%s", root, path);
+	if (*target == '/')
+		snprintf(dest, sizeof(dest), "%s", target);
+	else
+		snprintf(dest, sizeof(dest), "%s/dev/dri/%s", root, target);
+	igt_assert_eq(symlink(dest, full), 0);
+}
+
+static void make_proc(int i)
+{
+	char path[64], buf[256];
+
+	snprintf(path, sizeof(path), "%d", procs[i].pid);
+	scratch_mkdir(root, path);
+
+	snprintf(path, sizeof(path), "%d/comm", procs[i].pid);
+	snprintf(buf, sizeof(buf), "%s\n", procs[i].comm);
+	scratch_write(root, path, buf);
+
+	snprintf(path, sizeof(path), "%d/status", procs[i].pid);
+	snprintf(buf, sizeof(buf),
+		 "Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\nPPid:\t%d\n"
+		 "Uid:\t4\t%u\t%u\t%u\nGid:\t5\t%u\t%u\t%u\nFDSize:\t64\n",
+		 procs[i].comm, i ? 1 : 0,
+		 procs[i].euid, procs[i].euid, procs[i].euid,
+		 procs[i].egid, procs[i].egid, procs[i].egid);
+	scratch_write(root, path, buf);
+
+	snprintf(path, sizeof(path), "%d/cwd", procs[i].pid);
+	make_link(i == 2 ? "." : "/", path);
+
+	snprintf(path, sizeof(path), "%d/fd", procs[i].pid);
+	scratch_mkdir(root, path);
+
+	for (int fd = 0; fd < ARRAY_SIZE(procs[i].fds) && procs[i].fds[fd]; fd++) {
+		snprintf(path, sizeof(path), "%d/fd/%d", procs[i].pid, fd);
+		make_link(procs[i].fds[fd], path);
+	}
+}
+
+static void make_tree(void)
+{
+	scratch_create(root);
+
+	scratch_mkdir(root, "dev");
+	scratch_mkdir(root, "dev/dri");
+	scratch_write(root, "dev/dri/card0", "");
+	scratch_write(root, "dev/dri/card1", "");
+
+	/* entries a procfs has besides the processes */
+	scratch_mkdir(root, "sys");
+	scratch_write(root, "uptime", "1.00 2.00\n");
+	make_link("/", "self");
+
+	for (int i = 0; i < ARRAY_SIZE(procs); i++)
+		make_proc(i);
+}
+
+static igt_proc_t *find_pid(igt_proc_snapshot_t *snap, pid_t pid)
+{
+	igt_proc_t *proc = igt_proc_find(snap, pid);
+
+	igt_assert_f(proc, "pid %d not found\n", pid);
+
+	return proc;
+}
+
+static void assert_comm(igt_proc_snapshot_t *snap, igt_proc_t *proc,
+			const char *expected)
+{
+	const char *comm = igt_proc_comm(snap, proc);
+
+	igt_assert_f(comm && !strcmp(comm, expected), "pid %d: %s != %s\n",
+		     proc->pid, comm ?: "(null)", expected);
+}
+
+static void test_snapshot(void)
+{
+	igt_proc_snapshot_t *snap;
+	igt_proc_t *proc;
+
+	snap = igt_proc_snapshot_create(root);
+	igt_assert(snap);
+	igt_assert_eq(snap->count, ARRAY_SIZE(procs));
+
+	for (int i = 0; i < ARRAY_SIZE(procs); i++) {
+		proc = find_pid(snap, procs[i].pid);
+		assert_comm(snap, proc, procs[i].comm);
+
+		igt_assert_eq(igt_proc_ids(snap, proc), 0);
+		igt_assert_eq(igt_proc_ppid(snap, proc), i ? 1 : 0);
+		igt_assert_eq_u32(proc->euid, procs[i].euid);
+		igt_assert_eq_u32(proc->egid, procs[i].egid);
+	}
+
+	igt_assert(!igt_proc_find(snap, 2));
+	igt_proc_snapshot_destroy(snap);
+
+	igt_assert(!igt_proc_snapshot_create("/nonexistent/proc"));
+}
+
+static void test_lazy(void)
+{
+	igt_proc_snapshot_t *snap;
+	igt_proc_t *proc;
+
+	snap = igt_proc_snapshot_create(root);
+	igt_assert(snap);
+
+	/* nothing but the pid is read when listing */
+	scratch_write(root, "1234/comm", "X\n");
+	proc = find_pid(snap, 1234);
+	assert_comm(snap, proc, "X");
+
+	/* once read, attributes are kept until the next refresh */
+	scratch_write(root, "1234/comm", "Xorg\n");
+	assert_comm(snap, proc, "X");
+	igt_assert_eq(igt_proc_snapshot_refresh(snap), ARRAY_SIZE(procs));
+	proc = find_pid(snap, 1234);
+	assert_comm(snap, proc, "Xorg");
+
+	igt_proc_snapshot_destroy(snap);
+}
+
+static void test_find_comm(void)
+{
+	igt_proc_snapshot_t *snap;
+	igt_proc_t *proc;
+
+	snap = igt_proc_snapshot_create(root);
+	igt_assert(snap);
+
+	proc = igt_proc_find_comm(snap, "xorg");
+	igt_assert(proc);
+	igt_assert_eq(proc->pid, 1234);
+
+	proc = igt_proc_find_comm(snap, "PIPEWIRE-PULSE");
+	igt_assert(proc);
+	igt_assert_eq(proc->pid, 42);
+
+	igt_assert(!igt_proc_find_comm(snap, "pipewire"));
+	igt_assert(!igt_proc_find_comm(snap, "Xorg2"));
+
+	igt_proc_snapshot_destroy(snap);
+}
+
+static int collect_fd(igt_proc_snapshot_t *snap, igt_proc_t *proc, int fd,
+		      const char *target, void *data)
+{
+	unsigned int *mask = data;
+
+	igt_assert(!(*mask & 1 << fd));
+	*mask |= 1 << fd;
+
+	return 0;
+}
+
+static unsigned int walk(igt_proc_snapshot_t *snap, pid_t pid,
+			 const igt_proc_fd_filter_t *filter)
+{
+	unsigned int mask = 0;
+
+	igt_assert_eq(igt_proc_for_each_fd(snap, find_pid(snap, pid), filter,
+					   collect_fd, &mask), 0);
+
+	return mask;
+}
+
+static int stop_walk(igt_proc_snapshot_t *snap, igt_proc_t *proc, int fd,
+		     const char *target, void *data)
+{
+	return 17;
+}
+
+static void test_fds(void)
+{
+	char dri[PATH_MAX], cwd[PATH_MAX];
+	igt_proc_fd_filter_t filter = { .major = -1, .minor = -1 };
+	igt_proc_snapshot_t *snap;
+
+	snap = igt_proc_snapshot_create(root);
+	igt_assert(snap);
+
+	igt_assert_eq_u32(walk(snap, 1, NULL), 0x7);
+	igt_assert_eq_u32(walk(snap, 1234, NULL), 0xf);
+	igt_assert_eq_u32(walk(snap, 98765, NULL), 0);
+
+	snprintf(dri, sizeof(dri), "%s/dev/dri/", root);
+	filter.prefix = dri;
+	igt_assert_eq_u32(walk(snap, 1, &filter), 0);
+	igt_assert_eq_u32(walk(snap, 42, &filter), 0x4);
+	igt_assert_eq_u32(walk(snap, 1234, &filter), 0x6);
+
+	/* the device filter follows the link to the device node */
+	filter.prefix = NULL;
+	filter.major = 1;
+	igt_assert_eq_u32(walk(snap, 1, &filter), 0x7);
+	igt_assert_eq_u32(walk(snap, 1234, &filter), 0x9);
+
+	filter.minor = 5;
+	igt_assert_eq_u32(walk(snap, 1, &filter), 0);
+	igt_assert_eq_u32(walk(snap, 42, &filter), 0x2);
+	igt_assert_eq_u32(walk(snap, 1234, &filter), 0x9);
+
+	filter.prefix = "/dev/null";
+	igt_assert_eq_u32(walk(snap, 1234, &filter), 0);
+
+	igt_assert_eq(igt_proc_for_each_fd(snap, find_pid(snap, 42), NULL,
+					   stop_walk, NULL), 17);
+
+	igt_assert_lt(0, igt_proc_cwd(snap, find_pid(snap, 1234), cwd, sizeof(cwd)));
+	igt_assert(!strncmp(cwd, root, strlen(root)));
+
+	igt_proc_snapshot_destroy(snap);
+}
+
+static void make_task(pid_t pid, pid_t tid, const char *children)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "%d/task", pid);
+	if (pid == tid)
+		scratch_mkdir(root, path);
+	snprintf(path, sizeof(path), "%d/task/%d", pid, tid);
+	scratch_mkdir(root, path);
+	snprintf(path, sizeof(path), "%d/task/%d/children", pid, tid);
+	scratch_write(root, path, children);
+}
+
+static void test_tree(void)
+{
+	igt_proc_snapshot_t *snap;
+
+	snap = igt_proc_snapshot_create(root);
+	igt_assert(snap);
+
+	/* without children files, the whole procfs has to be scanned */
+	igt_assert_eq(igt_proc_snapshot_refresh_tree(snap, 1), -ENOENT);
+
+	/* a child of each thread of 1234, and a bogus loop back to it */
+	make_task(1, 1, "42 1234 ");
+	make_task(1234, 1234, "");
+	make_task(1234, 1240, "98765 ");
+	make_task(98765, 98765, "1234 ");
+
+	igt_assert_eq(igt_proc_snapshot_refresh_tree(snap, 1), 3);
+	find_pid(snap, 42);
+	find_pid(snap, 1234);
+	assert_comm(snap, find_pid(snap, 98765), "idle");
+	igt_assert(!igt_proc_find(snap, 1));
+
+	igt_assert_eq(igt_proc_snapshot_refresh_tree(snap, 1234), 1);
+	find_pid(snap, 98765);
+
+	igt_assert_eq(igt_proc_snapshot_refresh(snap), ARRAY_SIZE(procs));
+
+	igt_proc_snapshot_destroy(snap);
+}
+
+static void test_exited(void)
+{
+	igt_proc_snapshot_t *snap;
+	igt_proc_t *proc;
+
+	snap = igt_proc_snapshot_create(root);
+	igt_assert(snap);
+
+	scratch_remove(root, "98765");
+
+	proc = find_pid(snap, 98765);
+	igt_assert(!igt_proc_comm(snap, proc));
+	igt_assert_lt(igt_proc_ids(snap, proc), 0);
+	igt_assert_eq(igt_proc_for_each_fd(snap, proc, NULL, collect_fd, NULL),
+		      -ENOENT);
+
+	igt_assert_eq(igt_proc_snapshot_refresh(snap), ARRAY_SIZE(procs) - 1);
+	igt_assert(!igt_proc_find(snap, 98765));
+
+	igt_proc_snapshot_destroy(snap);
+}
+
+igt_main
+{
+	igt_fixture
+		make_tree();
+
+	igt_describe("List processes and read their name, parent and ids");
+	igt_subtest("snapshot")
+		test_snapshot();
+
+	igt_describe("Check attributes are only read when asked for");
+	igt_subtest("lazy")
+		test_lazy();
+
+	igt_describe("Find processes by name, ignoring case");
+	igt_subtest("find-comm")
+		test_find_comm();
+
+	igt_describe("Walk the fds of processes through path and device filters");
+	igt_subtest("fds")
+		test_fds();
+
+	igt_describe("List the descendants of a process from its children files");
+	igt_subtest("tree")
+		test_tree();
+
+	igt_describe("Check processes exiting after the snapshot are handled");
+	igt_subtest("exited")
+		test_exited();
+
+	igt_fixture
+		scratch_remove(root, NULL);
+}
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#define _XOPEN_SOURCE 500
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+#include "igt_spike.h"
+
+#include "igt_tests_common.h"
+
+IGT_TEST_DESCRIPTION("Check the attribution of synthetic latency spikes against a fake tracefs");
+
+#define THRESHOLD_NS 50000
+
+static const char *cpu1_trace =
+	"# tracer: nop\n"
+	"#\n"
+	"            bash-100     [001] d..2.   100.000100: sched_switch: prev_comm=bash prev_pid=100 prev_prio=120 prev_state=S ==> next_comm=kworker/1:2 next_pid=42 next_prio=120\n"
+	"     kworker/1:2-42      [001] d.h1.   100.000600: irq_handler_entry: irq=16 name=i915\n"
+	"     kworker/1:2-42      [001] d.h1.   100.000650: i915_request_retire: dev=0, engine=0:0, ctx=1, seqno=2\n"
+	"     kworker/1:2-42      [001] d.h1.   100.000700: irq_handler_exit: irq=16 ret=handled\n"
+	"     kworker/1:2-42      [001] ..s1.   100.000750: softirq_entry: vec=1 [action=TIMER]\n"
+	"     kworker/1:2-42      [001] ..s1.   100.000800: softirq_exit: vec=1 [action=TIMER]\n"
+	"     kworker/1:2-42      [001] d..2.   100.000900: sched_switch: prev_comm=kworker/1:2 prev_pid=42 prev_prio=120 prev_state=R+ ==> next_comm=gem_syslatency next_pid=77 next_prio=0\n"
+	"  gem_syslatency-77      [001] .....   100.001000: tracing_mark_write: igt-spike: 0 cpu=1 latency=500000ns\n"
+	"  gem_syslatency-77      [001] d..2.   100.002000: sched_switch: prev_comm=gem_syslatency prev_pid=77 prev_prio=0 prev_state=S ==> next_comm=bash next_pid=100 next_prio=120\n";
+
+/* no marker, as if written from another CPU, nor cpu and flags columns */
+static const char *cpu0_trace =
+	"# tracer: nop\n"
+	"       <idle>-0       50.000000: sched_switch: prev_comm=swapper/0 prev_pid=0 prev_prio=120 prev_state=R ==> next_comm=Web Content next_pid=300 next_prio=120\n"
+	"  Web Content-300     50.000400: sched_switch: prev_comm=Web Content prev_pid=300 prev_prio=120 prev_state=S ==> next_comm=swapper/0 next_pid=0 next_prio=120\n"
+	"       <idle>-0       50.000600: xe_exec_queue_submit: dev=0000:03:00.0, 1:0x1, gt=0\n";
+
+static void read_value(const char *dir, const char *path, char *buf, size_t len)
+{
+	char name[256];
+	FILE *f;
+
+	snprintf(name, sizeof(name), "%s/%s", dir, path);
+	f = fopen(name, "r");
+	igt_assert(f);
+	igt_assert(fgets(buf, len, f));
+	fclose(f);
+}
+
+static void make_tracefs(const char *dir)
+{
+	scratch_mkdirs(dir, "events/sched/sched_switch");
+	scratch_mkdirs(dir, "events/sched/sched_wakeup");
+	scratch_mkdirs(dir, "events/irq/irq_handler_entry");
+	scratch_mkdirs(dir, "events/i915");
+	scratch_mkdirs(dir, "per_cpu/cpu0");
+	scratch_mkdirs(dir, "per_cpu/cpu1");
+
+	scratch_write(dir, "trace_marker", "");
+	scratch_write(dir, "tracing_on", "0");
+	scratch_write(dir, "events/sched/sched_switch/enable", "0\n");
+	scratch_write(dir, "events/sched/sched_wakeup/enable", "1\n");
+	scratch_write(dir, "events/irq/irq_handler_entry/enable", "0\n");
+	scratch_write(dir, "events/i915/enable", "X\n");
+	scratch_write(dir, "per_cpu/cpu0/trace", cpu0_trace);
+	scratch_write(dir, "per_cpu/cpu1/trace", cpu1_trace);
+}
+
+static const igt_spike_offender_t *
+find_offender(const igt_spike_window_t *w, const char *name)
+{
+	for (unsigned int i = 0; i < w->n_offenders; i++)
+		if (!strcmp(w->offenders[i].name, name))
+			return &w->offenders[i];
+
+	return NULL;
+}
+
+static const igt_spike_window_t *find_window(const igt_spike_t *spike,
+					     unsigned int seq)
+{
+	for (unsigned int i = 0; i < spike->n_windows; i++)
+		if (spike->windows[i].seq == seq)
+			return &spike->windows[i];
+
+	return NULL;
+}
+
+static void check_offender(const igt_spike_window_t *w, const char *name,
+			   uint64_t time_ns, unsigned int count)
+{
+	const igt_spike_offender_t *o = find_offender(w, name);
+
+	igt_assert_f(o, "%s not found\n", name);
+	igt_assert_eq_u64(o->time_ns, time_ns);
+	igt_assert_eq_u32(o->count, count);
+}
+
+static void test_attribution(void)
+{
+	char dir[] = "/tmp/igt_spike.XXXXXX";
+	const igt_spike_window_t *w;
+	igt_spike_t spike;
+	char buf[128];
+	char *report;
+	size_t len;
+	FILE *f;
+
+	scratch_create(dir);
+	make_tracefs(dir);
+
+	igt_assert(igt_spike_init(&spike, dir, THRESHOLD_NS, 0, 2));
+
+	read_value(dir, "events/sched/sched_switch/enable", buf, sizeof(buf));
+	igt_assert_eq(buf[0], '1');
+	read_value(dir, "tracing_on", buf, sizeof(buf));
+	igt_assert_eq(buf[0], '1');
+	igt_assert_eq_u32(spike.n_enabled, 2);
+
+	/* below the threshold, nothing happens */
+	igt_assert(!igt_spike_sample(&spike, 1, THRESHOLD_NS));
+	igt_assert_eq_u32(spike.n_spikes, 0);
+
+	igt_assert(igt_spike_sample(&spike, 1, 500000));
+	read_value(dir, "trace_marker", buf, sizeof(buf));
+	igt_assert_f(!strcmp(buf, "igt-spike: 0 cpu=1 latency=500000ns\n"),
+		     "marker: %s", buf);
+
+	w = find_window(&spike, 0);
+	igt_assert(w);
+	igt_assert_eq_u64(w->end_ns, 100001000000ull);
+	igt_assert_eq_u64(w->start_ns, 100000500000ull);
+	/* the sampling task and what it runs after the marker don't count */
+	igt_assert_eq_u32(w->n_offenders, 4);
+	igt_assert(!strcmp(w->offenders[0].name, "task:kworker/1:2"));
+	check_offender(w, "task:kworker/1:2", 400000, 1);
+	check_offender(w, "irq:i915", 100000, 1);
+	check_offender(w, "softirq:TIMER", 50000, 1);
+	check_offender(w, "gpu:i915_request_retire", 0, 1);
+	igt_assert(strstr(w->trace, "100.000600: irq_handler_entry"));
+	igt_assert(!strstr(w->trace, "100.000100"));
+	igt_assert(!strstr(w->trace, "100.002000"));
+
+	igt_assert(igt_spike_sample(&spike, 0, 800000));
+	w = find_window(&spike, 1);
+	igt_assert(w);
+	igt_assert_eq_u64(w->end_ns, 50000600000ull);
+	check_offender(w, "task:Web Content", 400000, 1);
+	check_offender(w, "gpu:xe_exec_queue_submit", 0, 1);
+
+	/* both windows are larger, the spike is counted but not kept */
+	igt_assert(!igt_spike_sample(&spike, 1, 100000));
+	igt_assert_eq_u32(spike.n_spikes, 3);
+	igt_assert(!find_window(&spike, 2));
+
+	/* evicts the smallest spike */
+	igt_assert(igt_spike_sample(&spike, 0, 1000000));
+	igt_assert_eq_u32(spike.n_windows, 2);
+	igt_assert(!find_window(&spike, 0));
+	w = find_window(&spike, 3);
+	igt_assert(w);
+	igt_assert_eq_u64(w->start_ns, 49999600000ull);
+
+	f = open_memstream(&report, &len);
+	igt_assert(f);
+	igt_spike_report(&spike, f, 3, false);
+	fclose(f);
+	igt_assert_f(strstr(report, "Spikes: 4 above 50.000us, 2 captured\n"),
+		     "%s", report);
+	igt_assert_f(strstr(report, "     800.000        2        2  task:Web Content\n"),
+		     "%s", report);
+	/* largest spike first */
+	igt_assert(strstr(report, "Spike 3:") < strstr(report, "Spike 1:"));
+	free(report);
+
+	igt_spike_fini(&spike);
+
+	read_value(dir, "events/sched/sched_switch/enable", buf, sizeof(buf));
+	igt_assert_eq(buf[0], '0');
+	read_value(dir, "events/sched/sched_wakeup/enable", buf, sizeof(buf));
+	igt_assert_eq(buf[0], '1');
+	read_value(dir, "events/i915/enable", buf, sizeof(buf));
+	igt_assert_eq(buf[0], 'X');
+	read_value(dir, "tracing_on", buf, sizeof(buf));
+	igt_assert_eq(buf[0], '0');
+
+	scratch_remove(dir, NULL);
+}
+
+static void test_restore(void)
+{
+	char dir[] = "/tmp/igt_spike.XXXXXX";
+	igt_spike_t spike;
+	char buf[128];
+
+	scratch_create(dir);
+	make_tracefs(dir);
+
+	/* someone else traces, and owns a snapshot */
+	scratch_write(dir, "tracing_on", "1");
+	scratch_write(dir, "snapshot", "# tracer: nop\n");
+
+	igt_assert(igt_spike_init(&spike, dir, THRESHOLD_NS, 0, 1));
+	igt_spike_fini(&spike);
+
+	read_value(dir, "tracing_on", buf, sizeof(buf));
+	igt_assert_eq(buf[0], '1');
+	read_value(dir, "snapshot", buf, sizeof(buf));
+	igt_assert(!strcmp(buf, "# tracer: nop\n"));
+
+	/* a snapshot of ours is freed */
+	scratch_write(dir, "snapshot", "# *** SNAPSHOT NOT ALLOCATED ***\n");
+
+	igt_assert(igt_spike_init(&spike, dir, THRESHOLD_NS, 0, 1));
+	igt_spike_fini(&spike);
+
+	read_value(dir, "snapshot", buf, sizeof(buf));
+	igt_assert_eq(buf[0], '0');
+
+	scratch_remove(dir, NULL);
+}
+
+igt_main
+{
+	igt_describe("Capture synthetic spikes and attribute them from fake traces");
+	igt_subtest("attribution")
+		test_attribution();
+
+	igt_describe("Leave tracing and the snapshot buffer as they were found");
+	igt_subtest("restore")
+		test_restore();
+}
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <inttypes.h>
+
+#include "igt_core.h"
+#include "igt_suballoc.h"
+
+IGT_TEST_DESCRIPTION("Exercise the ring suballocator against fake fences");
+
+/* A fake timeline: fence N has signaled once completed >= N */
+struct fake_timeline {
+	uint64_t completed;
+	uint64_t submitted;
+	unsigned int polls, waits;
+};
+
+static bool fake_wait(void *priv, uint64_t fence, int64_t timeout_ns)
+{
+	struct fake_timeline *tl = priv;
+
+	igt_assert(fence <= tl->submitted);
+
+	if (timeout_ns) {
+		tl->waits++;
+		if (tl->completed < fence)
+			tl->completed = fence;
+	} else {
+		tl->polls++;
+	}
+
+	return tl->completed >= fence;
+}
+
+static const struct igt_suballoc_ops fake_ops = {
+	.wait = fake_wait,
+};
+
+static void submit(struct igt_suballoc *sa, struct fake_timeline *tl)
+{
+	igt_suballoc_fence(sa, ++tl->submitted);
+}
+
+static void test_alignment(void)
+{
+	struct fake_timeline tl = {};
+	struct igt_suballoc sa;
+	uint64_t a, b, c;
+
+	igt_suballoc_init(&sa, 4096, 256, &fake_ops, &tl);
+
+	igt_assert(igt_suballoc_alloc(&sa, 1, &a));
+	igt_assert(igt_suballoc_alloc(&sa, 257, &b));
+	igt_assert(igt_suballoc_alloc(&sa, 256, &c));
+	igt_assert_eq_u64(a, 0);
+	igt_assert_eq_u64(b, 256);
+	igt_assert_eq_u64(c, 768);
+	igt_assert_eq_u64(igt_suballoc_used(&sa), 1024);
+
+	igt_assert(!igt_suballoc_alloc(&sa, 4097, &a));
+	igt_assert(!igt_suballoc_alloc(&sa, 0, &a));
+
+	igt_suballoc_fini(&sa);
+}
+
+static void test_unfenced_never_reused(void)
+{
+	struct fake_timeline tl = {};
+	struct igt_suballoc sa;
+	uint64_t offset;
+
+	igt_suballoc_init(&sa, 4096, 1024, &fake_ops, &tl);
+
+	for (int i = 0; i < 4; i++)
+		igt_assert(igt_suballoc_alloc(&sa, 1024, &offset));
+
+	/* nothing was submitted, so nothing can be waited upon */
+	igt_assert(!igt_suballoc_alloc(&sa, 1024, &offset));
+	igt_assert_eq(tl.waits, 0);
+
+	submit(&sa, &tl);
+	igt_assert(!igt_suballoc_try_alloc(&sa, 1024, &offset));
+	igt_assert(igt_suballoc_alloc(&sa, 1024, &offset));
+	igt_assert_eq_u64(offset, 0);
+	igt_assert_eq(tl.waits, 1);
+
+	igt_suballoc_fini(&sa);
+}
+
+static void test_retire_in_order(void)
+{
+	struct fake_timeline tl = {};
+	struct igt_suballoc sa;
+	uint64_t offset;
+
+	igt_suballoc_init(&sa, 4096, 1024, &fake_ops, &tl);
+
+	for (int i = 0; i < 4; i++) {
+		igt_assert(igt_suballoc_alloc(&sa, 1024, &offset));
+		submit(&sa, &tl);
+	}
+
+	/* nothing has completed yet */
+	igt_assert_eq(igt_suballoc_retire(&sa), 0);
+
+	tl.completed = 2;
+	igt_assert_eq(igt_suballoc_retire(&sa), 2);
+	igt_assert_eq_u64(igt_suballoc_used(&sa), 2048);
+
+	/* wraps into the space released by the first two submissions */
+	igt_assert(igt_suballoc_try_alloc(&sa, 2048, &offset));
+	igt_assert_eq_u64(offset, 0);
+	igt_assert(!igt_suballoc_try_alloc(&sa, 1024, &offset));
+
+	igt_suballoc_fini(&sa);
+}
+
+static void test_shared_fence(void)
+{
+	struct fake_timeline tl = {};
+	struct igt_suballoc sa;
+	uint64_t offset;
+
+	igt_suballoc_init(&sa, 1 << 16, 64, &fake_ops, &tl);
+
+	for (int i = 0; i < 32; i++)
+		igt_assert(igt_suballoc_alloc(&sa, 64, &offset));
+	submit(&sa, &tl);
+
+	tl.completed = tl.submitted;
+	igt_assert_eq(igt_suballoc_retire(&sa), 32);
+	/* one poll covers every chunk tagged with the same fence */
+	igt_assert_eq(tl.polls, 1);
+	igt_assert_eq_u64(igt_suballoc_used(&sa), 0);
+
+	igt_suballoc_fini(&sa);
+}
+
+static void test_wrap_stress(void)
+{
+	struct fake_timeline tl = {};
+	struct igt_suballoc sa;
+	uint32_t seed = 0x1234;
+
+	igt_suballoc_init(&sa, 1 << 14, 256, &fake_ops, &tl);
+
+	for (int i = 0; i < 10000; i++) {
+		uint64_t size, offset;
+
+		seed = seed * 1103515245 + 12345;
+		size = 1 + (seed >> 8) % 4096;
+
+		igt_assert(igt_suballoc_alloc(&sa, size, &offset));
+		igt_assert_eq_u64(offset % 256, 0);
+		igt_assert_lte_u64(offset + size, sa.size);
+
+		/* the new chunk must not overlap any chunk still in flight */
+		for (unsigned int n = 0; n + 1 < sa.count; n++) {
+			const struct igt_suballoc_chunk *c =
+				&sa.chunks[(sa.first + n) % sa.capacity];
+
+			igt_assert(offset + size <= c->offset ||
+				   offset >= c->offset + c->size);
+		}
+
+		submit(&sa, &tl);
+
+		/* the fake GPU completes submissions in bursts */
+		if (!(seed & 0x300) && tl.submitted - (seed & 3) > tl.completed)
+			tl.completed = tl.submitted - (seed & 3);
+	}
+
+	igt_suballoc_wait_idle(&sa);
+	igt_assert_eq(sa.count, 0);
+	igt_assert_eq_u64(sa.stats.allocs, sa.stats.retired);
+	igt_info("allocs %"PRIu64", waits %"PRIu64"\n",
+		 sa.stats.allocs, sa.stats.waits);
+
+	igt_suballoc_fini(&sa);
+}
+
+igt_main
+{
+	igt_describe("Check offsets honor the requested alignment");
+	igt_subtest("alignment")
+		test_alignment();
+
+	igt_describe("Check chunks without a fence are never handed out again");
+	igt_subtest("unfenced")
+		test_unfenced_never_reused();
+
+	igt_describe("Check chunks are retired in submission order");
+	igt_subtest("retire-in-order")
+		test_retire_in_order();
+
+	igt_describe("Check chunks sharing a fence are retired with one query");
+	igt_subtest("shared-fence")
+		test_shared_fence();
+
+	igt_describe("Allocate randomly sized chunks and check none overlap");
+	igt_subtest("wrap-stress")
+		test_wrap_stress();
+}
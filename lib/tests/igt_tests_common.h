@@ -30,7 +30,11 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <ftw.h>
+#include <limits.h>
 #include <regex.h>
+#include <string.h>
+#include <unistd.h>
 
 /*
  * We need to hide assert from the cocci igt test refactor spatch.
@@ -183,4 +187,66 @@ static inline bool matches(char *str, const char *regex)
 	regfree(&reg);
 	return !ret;
 }
+
+/*
+ * Scratch trees standing in for procfs, sysfs, configfs and the like: @root
+ * is a mkdtemp() template, and the other paths are relative to it.
+ */
+static inline void scratch_create(char *root)
+{
+	internal_assert(mkdtemp(root));
+}
+
+static inline void scratch_write(const char *root, const char *path,
+				 const char *data)
+{
+	char full[PATH_MAX];
+	ssize_t len = strlen(data);
+	int fd;
+
+	snprintf(full, sizeof(full), "%s/%s", root, path);
+	fd = open(full, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	internal_assert(fd >= 0);
+	internal_assert(write(fd, data, len) == len);
+	close(fd);
+}
+
+static inline void scratch_mkdir(const char *root, const char *path)
+{
+	char full[PATH_MAX];
+
+	snprintf(full, sizeof(full), "%s/%s", root, path);
+	internal_assert(mkdir(full, 0755) == 0);
+}
+
+/* Like scratch_mkdir(), creating the missing parents too */
+static inline void scratch_mkdirs(const char *root, const char *path)
+{
+	char full[PATH_MAX];
+
+	snprintf(full, sizeof(full), "%s/%s", root, path);
+	for (char *p = full + strlen(root) + 1; (p = strchr(p, '/')); *p++ = '/') {
+		*p = '\0';
+		mkdir(full, 0755);
+	}
+	internal_assert(mkdir(full, 0755) == 0);
+}
+
+static inline int scratch_rm_entry(const char *path, const struct stat *st,
+				   int flag, struct FTW *ftw)
+{
+	return remove(path);
+}
+
+/* Removes @path and everything below it, or the whole tree if NULL */
+static inline void scratch_remove(const char *root, const char *path)
+{
+	char full[PATH_MAX];
+
+	if (path)
+		snprintf(full, sizeof(full), "%s/%s", root, path);
+	else
+		snprintf(full, sizeof(full), "%s", root);
+	nftw(full, scratch_rm_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
 #endif
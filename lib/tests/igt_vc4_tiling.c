@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include "drmtest.h"
+#include "igt_aux.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+#include "igt_vc4.h"
+
+IGT_TEST_DESCRIPTION("Check the block based VC4 tiling converters against the per-pixel reference");
+
+static void fill_random(uint8_t *buf, size_t size, uint32_t *seed)
+{
+	for (size_t i = 0; i < size; i++)
+		buf[i] = hars_petruska_f54_1_random(seed);
+}
+
+static void copy_pixel(uint8_t *dst, const uint8_t *src, unsigned int bpp)
+{
+	memcpy(dst, src, bpp / 8);
+}
+
+static void test_t_tiled(unsigned int width, unsigned int height, unsigned int bpp)
+{
+	size_t linear_stride = ALIGN(width * bpp / 8, 64) + 64;
+	size_t tiled_stride = ALIGN(width * bpp / 8, 128);
+	size_t tiled_size = tiled_stride * ALIGN(height, 32);
+	size_t linear_size = linear_stride * height;
+	uint8_t *linear, *tiled, *ref;
+	uint32_t seed = width * height + bpp;
+
+	linear = malloc(linear_size);
+	tiled = malloc(tiled_size);
+	ref = malloc(tiled_size);
+	igt_assert(linear && tiled && ref);
+
+	/* linear -> tiled, padding left untouched in both */
+	fill_random(linear, linear_size, &seed);
+	fill_random(tiled, tiled_size, &seed);
+	memcpy(ref, tiled, tiled_size);
+
+	for (unsigned int y = 0; y < height; y++)
+		for (unsigned int x = 0; x < width; x++)
+			copy_pixel(ref + igt_vc4_t_tiled_offset(tiled_stride, height,
+								bpp, x, y),
+				   linear + y * linear_stride + x * bpp / 8, bpp);
+
+	igt_vc4_t_tiled_copy(tiled, linear, tiled_stride, linear_stride,
+			     width, height, bpp, true);
+	igt_assert(!memcmp(tiled, ref, tiled_size));
+
+	/* tiled -> linear */
+	free(ref);
+	ref = malloc(linear_size);
+	igt_assert(ref);
+
+	fill_random(tiled, tiled_size, &seed);
+	fill_random(linear, linear_size, &seed);
+	memcpy(ref, linear, linear_size);
+
+	for (unsigned int y = 0; y < height; y++)
+		for (unsigned int x = 0; x < width; x++)
+			copy_pixel(ref + y * linear_stride + x * bpp / 8,
+				   tiled + igt_vc4_t_tiled_offset(tiled_stride, height,
+								  bpp, x, y), bpp);
+
+	igt_vc4_t_tiled_copy(tiled, linear, tiled_stride, linear_stride,
+			     width, height, bpp, false);
+	igt_assert(!memcmp(linear, ref, linear_size));
+
+	free(linear);
+	free(tiled);
+	free(ref);
+}
+
+static void test_sand(unsigned int column_bytes, unsigned int width,
+		      unsigned int height, unsigned int bpp)
+{
+	size_t column_width = column_bytes / (bpp / 8);
+	size_t column_height = height + 16;
+	size_t column_size = column_bytes * column_height;
+	size_t tiled_size = column_size * DIV_ROUND_UP(width, column_width);
+	size_t linear_stride = width * bpp / 8 + 32;
+	size_t linear_size = linear_stride * height;
+	uint8_t *linear, *tiled, *ref;
+	uint32_t seed = column_bytes + width + height + bpp;
+
+	linear = malloc(linear_size);
+	tiled = malloc(tiled_size);
+	ref = malloc(tiled_size > linear_size ? tiled_size : linear_size);
+	igt_assert(linear && tiled && ref);
+
+	fill_random(linear, linear_size, &seed);
+	fill_random(tiled, tiled_size, &seed);
+	memcpy(ref, tiled, tiled_size);
+
+	for (unsigned int y = 0; y < height; y++)
+		for (unsigned int x = 0; x < width; x++)
+			copy_pixel(ref + igt_vc4_sand_tiled_offset(column_width,
+								   column_size,
+								   x, y, bpp),
+				   linear + y * linear_stride + x * bpp / 8, bpp);
+
+	igt_vc4_sand_tiled_copy(tiled, linear, column_width, column_size,
+				linear_stride, width, height, bpp, true);
+	igt_assert(!memcmp(tiled, ref, tiled_size));
+
+	fill_random(linear, linear_size, &seed);
+	memcpy(ref, linear, linear_size);
+
+	for (unsigned int y = 0; y < height; y++)
+		for (unsigned int x = 0; x < width; x++)
+			copy_pixel(ref + y * linear_stride + x * bpp / 8,
+				   tiled + igt_vc4_sand_tiled_offset(column_width,
+								     column_size,
+								     x, y, bpp), bpp);
+
+	igt_vc4_sand_tiled_copy(tiled, linear, column_width, column_size,
+				linear_stride, width, height, bpp, false);
+	igt_assert(!memcmp(linear, ref, linear_size));
+
+	free(linear);
+	free(tiled);
+	free(ref);
+}
+
+igt_main
+{
+	static const struct {
+		unsigned int width, height;
+	} sizes[] = {
+		{ 1, 1 },
+		{ 7, 3 },
+		{ 64, 64 },
+		{ 100, 37 },
+		{ 333, 129 },
+		{ 1920, 1080 },
+	};
+
+	igt_describe("Compare T-tiled conversion with the per-pixel reference");
+	igt_subtest("t-tiled") {
+		for (int i = 0; i < ARRAY_SIZE(sizes); i++) {
+			test_t_tiled(sizes[i].width, sizes[i].height, 16);
+			test_t_tiled(sizes[i].width, sizes[i].height, 32);
+		}
+	}
+
+	igt_describe("Compare SAND conversion with the per-pixel reference");
+	igt_subtest("sand") {
+		for (int i = 0; i < ARRAY_SIZE(sizes); i++) {
+			for (unsigned int col = 32; col <= 256; col *= 2) {
+				test_sand(col, sizes[i].width, sizes[i].height, 8);
+				test_sand(col, sizes[i].width, sizes[i].height, 16);
+			}
+		}
+	}
+}
@@ -0,0 +1,366 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <time.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_rand.h"
+#include "igt_vec.h"
+
+IGT_TEST_DESCRIPTION("Check the igt_vec operations and measure the bulk and lookup helpers");
+
+/* same layout as the format/modifier pairs tracked by the KMS tests */
+struct elem {
+	uint32_t format;
+	uint64_t modifier;
+};
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void check_contents(struct igt_vec *vec, const uint32_t *ref, int len)
+{
+	igt_assert_eq(igt_vec_length(vec), len);
+	for (int i = 0; i < len; i++)
+		igt_assert_eq_u32(*(uint32_t *)igt_vec_elem(vec, i), ref[i]);
+}
+
+static void test_basic(void)
+{
+	uint32_t ref[100];
+	struct igt_vec vec;
+
+	igt_vec_init(&vec, sizeof(uint32_t));
+
+	/* short vectors stay inline */
+	for (uint32_t i = 0; i < IGT_VEC_INLINE_BYTES / sizeof(uint32_t); i++) {
+		igt_vec_push(&vec, &i);
+		ref[i] = i;
+	}
+	igt_assert(vec.elems == (void *)vec.inline_elems);
+
+	for (uint32_t i = igt_vec_length(&vec); i < ARRAY_SIZE(ref); i++) {
+		igt_vec_push(&vec, &i);
+		ref[i] = i;
+	}
+	igt_assert(vec.elems != (void *)vec.inline_elems);
+	check_contents(&vec, ref, ARRAY_SIZE(ref));
+
+	/* removing the last element */
+	igt_vec_remove(&vec, 99);
+	igt_vec_remove(&vec, 0);
+	memmove(ref, ref + 1, 98 * sizeof(*ref));
+	check_contents(&vec, ref, 98);
+
+	igt_vec_insert(&vec, 10, &ref[50]);
+	igt_vec_insert(&vec, igt_vec_length(&vec), &ref[0]);
+	igt_assert_eq(igt_vec_index(&vec, &ref[50]), 10);
+	igt_assert_eq(igt_vec_index(&vec, &ref[0]), 0);
+
+	igt_vec_fini(&vec);
+
+	/* elements too large for the inline storage */
+	igt_vec_init(&vec, IGT_VEC_INLINE_BYTES + 1);
+	igt_assert(!vec.elems);
+	igt_vec_reserve(&vec, 3);
+	igt_assert(vec.elems);
+	igt_vec_fini(&vec);
+}
+
+static void test_append(void)
+{
+	uint32_t ref[1000];
+	struct igt_vec vec;
+	void *elems;
+
+	for (int i = 0; i < ARRAY_SIZE(ref); i++)
+		ref[i] = i * 7;
+
+	igt_vec_init(&vec, sizeof(uint32_t));
+
+	igt_vec_reserve(&vec, ARRAY_SIZE(ref));
+	elems = vec.elems;
+	igt_vec_append(&vec, ref, 3);
+	igt_vec_append(&vec, ref + 3, 0);
+	igt_vec_append(&vec, ref + 3, ARRAY_SIZE(ref) - 3);
+	igt_assert(vec.elems == elems);
+	check_contents(&vec, ref, ARRAY_SIZE(ref));
+
+	/* appending grows at most once */
+	igt_vec_append(&vec, ref, ARRAY_SIZE(ref));
+	igt_assert_eq(igt_vec_length(&vec), 2 * ARRAY_SIZE(ref));
+	igt_assert_eq_u32(*(uint32_t *)igt_vec_elem(&vec, 1999), ref[999]);
+
+	igt_vec_fini(&vec);
+}
+
+static void test_swap_remove(void)
+{
+	uint32_t ref[] = { 0, 1, 2, 3, 4, 5 };
+	struct igt_vec vec;
+
+	igt_vec_init(&vec, sizeof(uint32_t));
+	igt_vec_append(&vec, ref, ARRAY_SIZE(ref));
+
+	igt_vec_swap_remove(&vec, 1);
+	check_contents(&vec, (uint32_t[]) { 0, 5, 2, 3, 4 }, 5);
+	igt_vec_swap_remove(&vec, 4);
+	check_contents(&vec, (uint32_t[]) { 0, 5, 2, 3 }, 4);
+	igt_vec_swap_remove(&vec, 0);
+	check_contents(&vec, (uint32_t[]) { 3, 5, 2 }, 3);
+
+	igt_vec_fini(&vec);
+}
+
+static void test_sorted(void)
+{
+	uint32_t seed = 0x1234, ref[2000];
+	struct igt_vec vec;
+
+	igt_vec_init(&vec, sizeof(uint32_t));
+
+	for (int i = 0; i < ARRAY_SIZE(ref); i++) {
+		ref[i] = hars_petruska_f54_1_random(&seed) % 500;
+		igt_vec_insert_sorted(&vec, &ref[i], cmp_u32);
+	}
+
+	qsort(ref, ARRAY_SIZE(ref), sizeof(*ref), cmp_u32);
+	check_contents(&vec, ref, ARRAY_SIZE(ref));
+
+	for (uint32_t x = 0; x < 600; x++) {
+		int idx = igt_vec_bsearch(&vec, &x, cmp_u32);
+		int expected = -1;
+
+		for (int i = 0; i < ARRAY_SIZE(ref); i++)
+			if (ref[i] == x) {
+				expected = i;
+				break;
+			}
+
+		igt_assert_eq(idx, expected);
+	}
+
+	igt_vec_fini(&vec);
+}
+
+static void test_index(void)
+{
+	struct igt_vec hashed, linear;
+	uint32_t seed = 0x5678;
+
+	igt_vec_init(&hashed, sizeof(struct elem));
+	igt_vec_init(&linear, sizeof(struct elem));
+	igt_vec_enable_index(&hashed);
+
+	for (int i = 0; i < 20000; i++) {
+		struct elem e = {
+			.format = hars_petruska_f54_1_random(&seed) % 64,
+			.modifier = hars_petruska_f54_1_random(&seed) % 8,
+		};
+		int op = hars_petruska_f54_1_random(&seed) % 8;
+
+		igt_assert_eq(igt_vec_index(&hashed, &e),
+			      igt_vec_index(&linear, &e));
+
+		if (op < 5 || !igt_vec_length(&linear)) {
+			igt_vec_push(&hashed, &e);
+			igt_vec_push(&linear, &e);
+		} else if (op == 5) {
+			int idx = hars_petruska_f54_1_random(&seed) % igt_vec_length(&linear);
+
+			igt_vec_swap_remove(&hashed, idx);
+			igt_vec_swap_remove(&linear, idx);
+		} else if (op == 6) {
+			int idx = hars_petruska_f54_1_random(&seed) % igt_vec_length(&linear);
+
+			igt_vec_remove(&hashed, idx);
+			igt_vec_remove(&linear, idx);
+		} else {
+			int idx = hars_petruska_f54_1_random(&seed) % igt_vec_length(&linear);
+
+			igt_vec_insert(&hashed, idx, &e);
+			igt_vec_insert(&linear, idx, &e);
+		}
+	}
+
+	igt_vec_fini(&hashed);
+	igt_vec_fini(&linear);
+}
+
+/*
+ * The microbenchmarks only report the gains, timings are too noisy on
+ * shared machines to be asserted upon.
+ */
+
+static void bench_append(void)
+{
+	const int count = 1 << 20;
+	struct timespec start = {};
+	uint32_t *data;
+	struct igt_vec vec;
+	uint64_t push_ns, append_ns;
+
+	data = malloc(count * sizeof(*data));
+	igt_assert(data);
+	for (int i = 0; i < count; i++)
+		data[i] = i;
+
+	igt_vec_init(&vec, sizeof(uint32_t));
+	igt_nsec_elapsed(&start);
+	for (int i = 0; i < count; i++)
+		igt_vec_push(&vec, &data[i]);
+	push_ns = igt_nsec_elapsed(&start);
+	igt_vec_fini(&vec);
+
+	igt_vec_init(&vec, sizeof(uint32_t));
+	memset(&start, 0, sizeof(start));
+	igt_nsec_elapsed(&start);
+	igt_vec_reserve(&vec, count);
+	igt_vec_append(&vec, data, count);
+	append_ns = igt_nsec_elapsed(&start);
+	check_contents(&vec, data, count);
+	igt_vec_fini(&vec);
+
+	igt_info("%d elements: push %.2fms, reserve+append %.2fms\n",
+		 count, push_ns / 1e6, append_ns / 1e6);
+
+	free(data);
+}
+
+static void bench_index(void)
+{
+	const int count = 2048, lookups = 1 << 14;
+	struct igt_vec hashed, linear;
+	uint64_t linear_ns, hashed_ns;
+	struct timespec start = {};
+	uint32_t seed = 1;
+	int found = 0;
+
+	igt_vec_init(&hashed, sizeof(struct elem));
+	igt_vec_init(&linear, sizeof(struct elem));
+	igt_vec_enable_index(&hashed);
+
+	for (int i = 0; i < count; i++) {
+		struct elem e = { .format = i, .modifier = i * 3 };
+
+		igt_vec_push(&hashed, &e);
+		igt_vec_push(&linear, &e);
+	}
+
+	igt_nsec_elapsed(&start);
+	for (int i = 0; i < lookups; i++) {
+		uint32_t x = hars_petruska_f54_1_random(&seed) % (2 * count);
+		struct elem e = { .format = x, .modifier = x * 3 };
+
+		found += igt_vec_index(&linear, &e) >= 0;
+	}
+	linear_ns = igt_nsec_elapsed(&start);
+
+	seed = 1;
+	memset(&start, 0, sizeof(start));
+	igt_nsec_elapsed(&start);
+	for (int i = 0; i < lookups; i++) {
+		uint32_t x = hars_petruska_f54_1_random(&seed) % (2 * count);
+		struct elem e = { .format = x, .modifier = x * 3 };
+
+		found -= igt_vec_index(&hashed, &e) >= 0;
+	}
+	hashed_ns = igt_nsec_elapsed(&start);
+	igt_assert_eq(found, 0);
+
+	igt_info("%d lookups in %d elements: linear %.2fms, hashed %.2fms\n",
+		 lookups, count, linear_ns / 1e6, hashed_ns / 1e6);
+
+	igt_vec_fini(&hashed);
+	igt_vec_fini(&linear);
+}
+
+static void bench_sorted(void)
+{
+	const int count = 1 << 13;
+	uint64_t sorted_ns, linear_ns;
+	struct igt_vec sorted, linear;
+	struct timespec start = {};
+	uint32_t seed = 2;
+	int found = 0;
+
+	igt_vec_init(&sorted, sizeof(uint32_t));
+	igt_vec_init(&linear, sizeof(uint32_t));
+
+	for (int i = 0; i < count; i++) {
+		uint32_t x = hars_petruska_f54_1_random(&seed);
+
+		igt_vec_insert_sorted(&sorted, &x, cmp_u32);
+		igt_vec_push(&linear, &x);
+	}
+
+	seed = 3;
+	igt_nsec_elapsed(&start);
+	for (int i = 0; i < count; i++) {
+		uint32_t x = *(uint32_t *)igt_vec_elem(&linear,
+						       hars_petruska_f54_1_random(&seed) % count);
+
+		found += igt_vec_index(&linear, &x) >= 0;
+	}
+	linear_ns = igt_nsec_elapsed(&start);
+
+	seed = 3;
+	memset(&start, 0, sizeof(start));
+	igt_nsec_elapsed(&start);
+	for (int i = 0; i < count; i++) {
+		uint32_t x = *(uint32_t *)igt_vec_elem(&linear,
+						       hars_petruska_f54_1_random(&seed) % count);
+
+		found -= igt_vec_bsearch(&sorted, &x, cmp_u32) >= 0;
+	}
+	sorted_ns = igt_nsec_elapsed(&start);
+	igt_assert_eq(found, 0);
+
+	igt_info("%d lookups in %d elements: linear %.2fms, bsearch %.2fms\n",
+		 count, count, linear_ns / 1e6, sorted_ns / 1e6);
+
+	igt_vec_fini(&sorted);
+	igt_vec_fini(&linear);
+}
+
+igt_main
+{
+	igt_describe("Check push, insert and remove, in and out of the inline storage");
+	igt_subtest("basic")
+		test_basic();
+
+	igt_describe("Check reserve and bulk append");
+	igt_subtest("append")
+		test_append();
+
+	igt_describe("Check removal by moving the last element");
+	igt_subtest("swap-remove")
+		test_swap_remove();
+
+	igt_describe("Check sorted insertion and binary search");
+	igt_subtest("sorted")
+		test_sorted();
+
+	igt_describe("Check hashed lookups match the linear search across changes");
+	igt_subtest("index")
+		test_index();
+
+	igt_describe("Compare element wise push with reserve and bulk append");
+	igt_subtest("bench-append")
+		bench_append();
+
+	igt_describe("Compare linear and hashed lookups");
+	igt_subtest("bench-index")
+		bench_index();
+
+	igt_describe("Compare linear lookups with binary search in a sorted vector");
+	igt_subtest("bench-sorted")
+		bench_sorted();
+}
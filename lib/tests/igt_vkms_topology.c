@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <xf86drmMode.h>
+
+#include "igt_core.h"
+#include "igt_vkms.h"
+
+#include "igt_tests_common.h"
+
+IGT_TEST_DESCRIPTION("Exercise the declarative VKMS topology helpers against a fake configfs tree");
+
+static char root[] = "/tmp/igt_vkms_topology.XXXXXX";
+
+static igt_vkms_config_t base_config(void)
+{
+	return (igt_vkms_config_t) {
+		.device_name = "topology",
+		.planes = {
+			{
+				.name = "primary0",
+				.type = DRM_PLANE_TYPE_PRIMARY,
+				.possible_crtcs = { "crtc0" },
+			},
+			{
+				.name = "primary1",
+				.type = DRM_PLANE_TYPE_PRIMARY,
+				.possible_crtcs = { "crtc1" },
+			},
+			{
+				.name = "overlay0",
+				.possible_crtcs = { "crtc0", "crtc1" },
+			},
+		},
+		.crtcs = {
+			{ .name = "crtc0" },
+			{ .name = "crtc1", .writeback = true },
+		},
+		.encoders = {
+			{ .name = "encoder0", .possible_crtcs = { "crtc0" } },
+			{ .name = "encoder1", .possible_crtcs = { "crtc1" } },
+		},
+		.connectors = {
+			{
+				.name = "connector0",
+				.possible_encoders = { "encoder0", "encoder1" },
+			},
+		},
+	};
+}
+
+static bool exists(igt_vkms_t *dev, const char *rel)
+{
+	char path[PATH_MAX];
+	struct stat st;
+
+	snprintf(path, sizeof(path), "%s/%s", dev->path, rel);
+
+	return lstat(path, &st) == 0;
+}
+
+static int read_value(igt_vkms_t *dev, const char *rel)
+{
+	char path[PATH_MAX], buf[16] = {};
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dev->path, rel);
+	fd = open(path, O_RDONLY);
+	igt_assert_fd(fd);
+	igt_assert(read(fd, buf, sizeof(buf) - 1) > 0);
+	close(fd);
+
+	return atoi(buf);
+}
+
+static void test_validate(void)
+{
+	igt_vkms_config_t cfg;
+	char err[256];
+
+	cfg = base_config();
+	igt_assert_f(igt_vkms_config_validate(&cfg, err, sizeof(err)), "%s\n", err);
+
+	cfg = base_config();
+	cfg.planes[1].type = DRM_PLANE_TYPE_OVERLAY;
+	igt_assert(!igt_vkms_config_validate(&cfg, err, sizeof(err)));
+	igt_debug("%s\n", err);
+
+	cfg = base_config();
+	cfg.planes[2].type = DRM_PLANE_TYPE_PRIMARY;
+	igt_assert(!igt_vkms_config_validate(&cfg, err, sizeof(err)));
+
+	cfg = base_config();
+	cfg.encoders[1].possible_crtcs[0] = "crtc7";
+	igt_assert(!igt_vkms_config_validate(&cfg, err, sizeof(err)));
+
+	cfg = base_config();
+	cfg.encoders[1].name = "encoder0";
+	igt_assert(!igt_vkms_config_validate(&cfg, err, sizeof(err)));
+
+	cfg = base_config();
+	cfg.connectors[0].possible_encoders[0] = NULL;
+	igt_assert(!igt_vkms_config_validate(&cfg, err, sizeof(err)));
+
+	cfg = (igt_vkms_config_t) { .device_name = "empty" };
+	igt_assert(!igt_vkms_config_validate(&cfg, err, sizeof(err)));
+}
+
+static void test_apply(void)
+{
+	igt_vkms_config_t cfg = base_config();
+	igt_vkms_t *dev;
+	int ops;
+
+	dev = igt_vkms_device_create("apply");
+	igt_assert(dev);
+
+	/* 8 items, 3 non-default values and 8 links */
+	ops = igt_vkms_device_apply_config(dev, &cfg);
+	igt_assert_eq(ops, 19);
+
+	igt_assert(exists(dev, "crtcs/crtc1"));
+	igt_assert(exists(dev, "planes/overlay0/possible_crtcs/crtc1"));
+	igt_assert(exists(dev, "connectors/connector0/possible_encoders/encoder1"));
+	igt_assert_eq(read_value(dev, "planes/primary0/type"), DRM_PLANE_TYPE_PRIMARY);
+	igt_assert_eq(read_value(dev, "crtcs/crtc1/writeback"), 1);
+
+	/* Nothing changed, nothing written */
+	igt_assert_eq(igt_vkms_device_apply_config(dev, &cfg), 0);
+
+	/* Drop a link and an encoder, add a cursor, flip the connector */
+	cfg.connectors[0].possible_encoders[1] = NULL;
+	cfg.connectors[0].status = DRM_MODE_DISCONNECTED;
+	cfg.encoders[1].name = NULL;
+	cfg.planes[3] = (igt_vkms_plane_config_t) {
+		.name = "cursor0",
+		.type = DRM_PLANE_TYPE_CURSOR,
+		.possible_crtcs = { "crtc0" },
+	};
+
+	ops = igt_vkms_device_apply_config(dev, &cfg);
+	/* 2 unlinks, 1 rmdir, 1 mkdir, 1 type, 1 link, 1 status */
+	igt_assert_eq(ops, 7);
+
+	igt_assert(!exists(dev, "encoders/encoder1"));
+	igt_assert(!exists(dev, "connectors/connector0/possible_encoders/encoder1"));
+	igt_assert(exists(dev, "planes/cursor0/possible_crtcs/crtc0"));
+	igt_assert_eq(read_value(dev, "connectors/connector0/status"),
+		      DRM_MODE_DISCONNECTED);
+
+	igt_assert_eq(igt_vkms_device_apply_config(dev, &cfg), 0);
+
+	free(dev->path);
+	free(dev);
+}
+
+static void test_pool(void)
+{
+	igt_vkms_config_t cfg = base_config();
+	igt_vkms_t *a, *b, *c;
+	char path[PATH_MAX];
+
+	a = igt_vkms_pool_get(&cfg);
+	igt_assert(exists(a, "enabled"));
+	igt_assert_eq(read_value(a, "enabled"), 1);
+
+	/* A device in use is never shared */
+	b = igt_vkms_pool_get(&cfg);
+	igt_assert(a != b);
+	igt_assert(strcmp(a->path, b->path));
+
+	igt_vkms_pool_put(a);
+	c = igt_vkms_pool_get(&cfg);
+	igt_assert(c == a);
+
+	/* Same topology again: the device is reused as is */
+	igt_vkms_pool_put(c);
+	igt_assert_eq(igt_vkms_device_apply_config(c, &cfg), 0);
+
+	cfg.crtcs[1].writeback = false;
+	c = igt_vkms_pool_get(&cfg);
+	igt_assert(c == a);
+	igt_assert_eq(read_value(c, "crtcs/crtc1/writeback"), 0);
+
+	igt_vkms_pool_put(b);
+	igt_vkms_pool_put(c);
+
+	snprintf(path, sizeof(path), "%s", a->path);
+	igt_vkms_pool_destroy();
+	igt_assert(access(path, F_OK));
+}
+
+igt_main
+{
+	igt_fixture {
+		scratch_create(root);
+		igt_vkms_set_configfs_path(root);
+	}
+
+	igt_describe("Check invalid topologies are rejected up front");
+	igt_subtest("validate")
+		test_validate();
+
+	igt_describe("Check only the differences are applied to a device");
+	igt_subtest("apply")
+		test_apply();
+
+	igt_describe("Check pooled devices are recycled");
+	igt_subtest("pool")
+		test_pool();
+
+	igt_fixture {
+		igt_vkms_set_configfs_path(NULL);
+		scratch_remove(root, NULL);
+	}
+}
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "igt_core.h"
+#include "igt_window_stats.h"
+
+IGT_TEST_DESCRIPTION("Check the aggregation of synthetic samples in time windows");
+
+#define N_SAMPLES 100000
+#define SAMPLE_NS 100
+#define WINDOW_NS 1000000
+
+/*
+ * A sample every 100ns, alternating between two contexts every 10
+ * samples, every 97th sample being dropped like an invalid report.
+ */
+static bool synthetic_sample(void *data, uint64_t idx, uint64_t *ts_ns,
+			     uint32_t *key, double *values)
+{
+	if (idx % 97 == 0)
+		return false;
+
+	*ts_ns = idx * SAMPLE_NS;
+	*key = (idx / 10) % 2 ? 7 : 3;
+	values[0] = idx;
+	values[1] = idx % 5;
+
+	return true;
+}
+
+static void check_same(const igt_window_stats_t *a, const igt_window_stats_t *b)
+{
+	igt_assert_eq_u64(a->n_windows, b->n_windows);
+
+	for (uint64_t i = 0; i < a->n_windows; i++) {
+		const igt_window_stats_window_t *wa = &a->windows[i];
+		const igt_window_stats_window_t *wb = &b->windows[i];
+
+		igt_assert_eq_u64(wa->index, wb->index);
+		igt_assert_eq_u32(wa->key, wb->key);
+		igt_assert_eq_u64(wa->n_samples, wb->n_samples);
+		for (unsigned int v = 0; v < a->n_values; v++) {
+			igt_assert_eq_double(wa->min[v], wb->min[v]);
+			igt_assert_eq_double(wa->max[v], wb->max[v]);
+			igt_assert_eq_double(wa->sum[v], wb->sum[v]);
+		}
+	}
+}
+
+static void test_windows(void)
+{
+	igt_window_stats_t stats;
+	uint64_t total = 0;
+
+	igt_window_stats_init(&stats, WINDOW_NS, 2, false);
+	igt_window_stats_collect(&stats, N_SAMPLES, synthetic_sample, NULL, 1);
+
+	/* 10000 samples per window */
+	igt_assert_eq_u64(stats.n_windows, N_SAMPLES * SAMPLE_NS / WINDOW_NS);
+	for (uint64_t i = 0; i < stats.n_windows; i++) {
+		const igt_window_stats_window_t *w = &stats.windows[i];
+		uint64_t first = i * 10000, last = first + 9999;
+
+		igt_assert_eq_u64(w->index, i);
+		igt_assert_eq_u32(w->key, 0);
+		total += w->n_samples;
+
+		igt_assert_eq_double(w->min[0], first % 97 ? first : first + 1);
+		igt_assert_eq_double(w->max[0], last % 97 ? last : last - 1);
+		igt_assert_eq_double(w->min[1], 0);
+		igt_assert_eq_double(w->max[1], 4);
+	}
+	igt_assert_eq_u64(total, N_SAMPLES - (N_SAMPLES + 96) / 97);
+
+	igt_window_stats_fini(&stats);
+	igt_assert_eq_u64(stats.n_windows, 0);
+}
+
+static void test_per_key(void)
+{
+	igt_window_stats_t stats;
+
+	igt_window_stats_init(&stats, WINDOW_NS, 2, true);
+	igt_window_stats_collect(&stats, N_SAMPLES, synthetic_sample, NULL, 1);
+
+	igt_assert_eq_u64(stats.n_windows, 2 * N_SAMPLES * SAMPLE_NS / WINDOW_NS);
+	for (uint64_t i = 0; i < stats.n_windows; i++) {
+		const igt_window_stats_window_t *w = &stats.windows[i];
+
+		igt_assert_eq_u64(w->index, i / 2);
+		igt_assert_eq_u32(w->key, i % 2 ? 7 : 3);
+		/* 500 runs of 10 samples, minus the dropped ones */
+		igt_assert_lte_u64(5000 - 60, w->n_samples);
+		igt_assert_lte_u64(w->n_samples, 5000);
+	}
+
+	igt_window_stats_fini(&stats);
+}
+
+static void test_threads(void)
+{
+	igt_window_stats_t ref, stats;
+
+	for (int per_key = 0; per_key <= 1; per_key++) {
+		igt_window_stats_init(&ref, WINDOW_NS / 3, 2, per_key);
+		igt_window_stats_collect(&ref, N_SAMPLES, synthetic_sample, NULL, 1);
+
+		/* window boundaries don't line up with the chunks */
+		igt_window_stats_init(&stats, WINDOW_NS / 3, 2, per_key);
+		igt_window_stats_collect(&stats, N_SAMPLES, synthetic_sample, NULL, 7);
+		check_same(&ref, &stats);
+		igt_window_stats_fini(&stats);
+
+		igt_window_stats_init(&stats, WINDOW_NS / 3, 2, per_key);
+		igt_window_stats_collect(&stats, N_SAMPLES, synthetic_sample, NULL, 0);
+		check_same(&ref, &stats);
+		igt_window_stats_fini(&stats);
+
+		igt_window_stats_fini(&ref);
+	}
+}
+
+static void test_csv(void)
+{
+	const char * const names[] = { "busy", "count" };
+	igt_window_stats_t stats;
+	char *buf = NULL;
+	size_t len = 0;
+	FILE *f;
+
+	igt_window_stats_init(&stats, 2000, 2, true);
+	igt_window_stats_collect(&stats, 40, synthetic_sample, NULL, 4);
+
+	f = open_memstream(&buf, &len);
+	igt_assert(f);
+	igt_window_stats_write_csv(&stats, f, "ctx_id", names);
+	fclose(f);
+
+	igt_assert_f(!strcmp(buf,
+			     "start_ns,end_ns,ctx_id,samples,busy_min,busy_avg,busy_max,count_min,count_avg,count_max\n"
+			     "0,2000,0x3,9,1,5,9,0,2.22222222222222,4\n"
+			     "0,2000,0x7,10,10,14.5,19,0,2,4\n"
+			     "2000,4000,0x3,10,20,24.5,29,0,2,4\n"
+			     "2000,4000,0x7,10,30,34.5,39,0,2,4\n"),
+		     "%s", buf);
+
+	free(buf);
+	igt_window_stats_fini(&stats);
+}
+
+igt_main
+{
+	igt_describe("Aggregate samples in time windows");
+	igt_subtest("windows")
+		test_windows();
+
+	igt_describe("Split the windows per sample key");
+	igt_subtest("per-key")
+		test_per_key();
+
+	igt_describe("Get the same windows whatever the number of threads");
+	igt_subtest("threads")
+		test_threads();
+
+	igt_describe("Export the windows as CSV");
+	igt_subtest("csv")
+		test_csv();
+}
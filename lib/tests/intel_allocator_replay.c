@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "igt_core.h"
+#include "intel_allocator.h"
+#include "intel_allocator_replay.h"
+
+IGT_TEST_DESCRIPTION("Check the replay of synthetic allocator traces");
+
+#define SZ 0x10000ull
+
+static FILE *trace_begin(char **buf, size_t *len, int pid)
+{
+	FILE *f = open_memstream(buf, len);
+
+	igt_assert(f);
+	fprintf(f, "# intel_allocator trace pid=%d\n", pid);
+
+	return f;
+}
+
+static void trace_open(FILE *f, uint64_t ts, int tid, uint64_t ahnd,
+		       uint32_t ctx, uint8_t type)
+{
+	fprintf(f, "%" PRIu64 " %d open 0x%" PRIx64 " fd=3 ctx=%u vm=0"
+		" start=0x40000 end=0x100000000 type=%u strategy=1"
+		" alignment=0x1000\n", ts, tid, ahnd, ctx, type);
+}
+
+static void trace_alloc(FILE *f, uint64_t ts, int tid, uint64_t ahnd,
+			uint32_t handle, uint64_t size)
+{
+	fprintf(f, "%" PRIu64 " %d alloc 0x%" PRIx64 " handle=%u size=0x%" PRIx64
+		" alignment=0x1000 pat=0 strategy=0 offset=0x0\n",
+		ts, tid, ahnd, handle, size);
+}
+
+static void trace_free(FILE *f, uint64_t ts, int tid, uint64_t ahnd,
+		       uint32_t handle)
+{
+	fprintf(f, "%" PRIu64 " %d free 0x%" PRIx64 " handle=%u freed=1\n",
+		ts, tid, ahnd, handle);
+}
+
+static void trace_close(FILE *f, uint64_t ts, int tid, uint64_t ahnd)
+{
+	fprintf(f, "%" PRIu64 " %d close 0x%" PRIx64 " empty=1\n",
+		ts, tid, ahnd);
+}
+
+/* The buffer of the stream is only there once closed */
+static void load(struct intel_allocator_replay *replay, FILE *f, char **buf,
+		 size_t *len)
+{
+	fclose(f);
+	f = fmemopen(*buf, *len, "r");
+	igt_assert(f);
+	igt_assert(intel_allocator_replay_load(replay, f));
+	fclose(f);
+	free(*buf);
+}
+
+/*
+ * A thousand objects allocated, every other one freed, then the rest: the
+ * holes left behind fragment the address space until the end.
+ */
+static void checkerboard(struct intel_allocator_replay *replay, uint8_t type,
+			 uint64_t step)
+{
+	uint64_t ts = 1000;
+	size_t len;
+	char *buf;
+	FILE *f;
+
+	f = trace_begin(&buf, &len, 100);
+	trace_open(f, ts, 100, 1, 0, type);
+	for (uint32_t h = 1; h <= 1000; h++)
+		trace_alloc(f, ts += step, 100 + h % 2, 1, h, SZ);
+	for (uint32_t h = 1; h <= 1000; h += 2)
+		trace_free(f, ts += step, 100, 1, h);
+	fprintf(f, "%" PRIu64 " 100 reserve 0x1 handle=0 start=0xffff0000"
+		" end=0x100000000 reserved=1\n", ts += step);
+	fprintf(f, "%" PRIu64 " 100 unreserve 0x1 handle=0 start=0xffff0000"
+		" end=0x100000000 unreserved=1\n", ts += step);
+	for (uint32_t h = 2; h <= 1000; h += 2)
+		trace_free(f, ts += step, 101, 1, h);
+	trace_close(f, ts += step, 100, 1);
+	load(replay, f, &buf, &len);
+}
+
+static void test_load(void)
+{
+	struct intel_allocator_replay replay;
+	const struct intel_allocator_trace_entry *e;
+	static const char invalid[] =
+		"# intel_allocator trace pid=7\n"
+		"10 7 open 0x1 fd=3 ctx=0 vm=0\n";
+	size_t len;
+	char *buf;
+	FILE *f;
+
+	f = trace_begin(&buf, &len, 7);
+	trace_open(f, 10, 7, 1, 0, INTEL_ALLOCATOR_SIMPLE);
+	fprintf(f, "# comment\n\n");
+	trace_alloc(f, 20, 8, 1, 5, SZ);
+	fprintf(f, "# intel_allocator trace pid=9\n");
+	trace_open(f, 30, 9, 1, 2, INTEL_ALLOCATOR_RELOC);
+	trace_close(f, 40, 9, 1);
+	load(&replay, f, &buf, &len);
+
+	igt_assert_eq(igt_vec_length(&replay.entries), 6);
+	igt_assert_eq(replay.processes, 2);
+	igt_assert_eq(replay.threads, 3);
+
+	e = igt_vec_elem(&replay.entries, 1);
+	igt_assert_eq(e->op, INTEL_ALLOCATOR_TRACE_OPEN);
+	igt_assert_eq_u64(e->open.end, 0x100000000ull);
+	igt_assert_eq_u64(e->open.default_alignment, 0x1000);
+	e = igt_vec_elem(&replay.entries, 2);
+	igt_assert_eq(e->op, INTEL_ALLOCATOR_TRACE_ALLOC);
+	igt_assert_eq(e->tid, 8);
+	igt_assert_eq(e->alloc.handle, 5);
+	igt_assert_eq_u64(e->alloc.size, SZ);
+	e = igt_vec_elem(&replay.entries, 4);
+	igt_assert_eq(e->open.ctx, 2);
+	igt_assert_eq(e->open.allocator_type, INTEL_ALLOCATOR_RELOC);
+	intel_allocator_replay_fini(&replay);
+
+	f = fmemopen((void *)invalid, strlen(invalid), "r");
+	igt_assert(!intel_allocator_replay_load(&replay, f));
+	fclose(f);
+	intel_allocator_replay_fini(&replay);
+}
+
+static void test_replay(uint8_t type)
+{
+	struct intel_allocator_replay replay;
+
+	checkerboard(&replay, INTEL_ALLOCATOR_SIMPLE, 1);
+	intel_allocator_replay_run(&replay, type, false);
+
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_OPEN].count, 1);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_ALLOC].count, 1000);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_FREE].count, 1000);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_RESERVE].count, 1);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_UNRESERVE].count, 1);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_CLOSE].count, 1);
+	for (int op = 0; op < INTEL_ALLOCATOR_TRACE_OPS; op++) {
+		/* reloc has no reservations */
+		bool reserve = op == INTEL_ALLOCATOR_TRACE_RESERVE ||
+			op == INTEL_ALLOCATOR_TRACE_UNRESERVE;
+
+		igt_assert_eq(replay.ops[op].failed,
+			      reserve && type == INTEL_ALLOCATOR_RELOC);
+	}
+
+	igt_assert_lte(intel_allocator_replay_percentile(&replay, INTEL_ALLOCATOR_TRACE_ALLOC, 50),
+		       intel_allocator_replay_percentile(&replay, INTEL_ALLOCATOR_TRACE_ALLOC, 99));
+	igt_assert_lte(intel_allocator_replay_percentile(&replay, INTEL_ALLOCATOR_TRACE_ALLOC, 99),
+		       intel_allocator_replay_percentile(&replay, INTEL_ALLOCATOR_TRACE_ALLOC, 100));
+	igt_assert(intel_allocator_replay_percentile(&replay, INTEL_ALLOCATOR_TRACE_ALLOC, 100));
+
+	/* samples at 256, 512, ... 1792 mutations */
+	igt_assert_eq(replay.samples, 7);
+	if (type == INTEL_ALLOCATOR_SIMPLE)
+		igt_assert(replay.max_fragmentation > 0.0);
+	igt_assert(replay.max_fragmentation < 1.0);
+	igt_assert(replay.fragmentation <= replay.max_fragmentation);
+
+	/* a second run replaces the results */
+	intel_allocator_replay_run(&replay, type, false);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_ALLOC].count, 1000);
+	igt_assert_eq(replay.samples, 7);
+
+	intel_allocator_replay_report(&replay, stdout);
+	intel_allocator_replay_fini(&replay);
+}
+
+/* Handles opened on the same ctx share the allocator, as live */
+static void test_shared(void)
+{
+	struct intel_allocator_replay replay;
+	size_t len;
+	char *buf;
+	FILE *f;
+
+	f = trace_begin(&buf, &len, 200);
+	trace_open(f, 1, 200, 1, 0, INTEL_ALLOCATOR_SIMPLE);
+	trace_open(f, 2, 201, 2, 0, INTEL_ALLOCATOR_SIMPLE);
+	trace_open(f, 3, 201, 3, 1, INTEL_ALLOCATOR_SIMPLE);
+	trace_alloc(f, 4, 200, 1, 1, SZ);
+	trace_close(f, 5, 200, 1);
+	trace_free(f, 6, 201, 2, 1);
+	trace_free(f, 7, 201, 3, 1);
+	trace_close(f, 8, 201, 2);
+	trace_close(f, 9, 201, 3);
+	/* closed above, and unknown */
+	trace_free(f, 10, 201, 2, 1);
+	trace_free(f, 11, 201, 4, 1);
+	load(&replay, f, &buf, &len);
+
+	intel_allocator_replay_run(&replay, 0, false);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_OPEN].count, 3);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_CLOSE].count, 3);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_FREE].count, 2);
+	/* the other ctx had nothing to free */
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_FREE].failed, 3);
+	intel_allocator_replay_fini(&replay);
+}
+
+/* Subtests reinitialize the allocators, dropping what was left open */
+static void test_reset(void)
+{
+	struct intel_allocator_replay replay;
+	size_t len;
+	char *buf;
+	FILE *f;
+
+	f = trace_begin(&buf, &len, 300);
+	trace_open(f, 1, 300, 1, 0, INTEL_ALLOCATOR_SIMPLE);
+	trace_alloc(f, 2, 300, 1, 1, SZ);
+	fprintf(f, "# intel_allocator reset pid=300\n");
+	/* the same ahnd again, on a fresh allocator */
+	trace_open(f, 3, 300, 1, 0, INTEL_ALLOCATOR_SIMPLE);
+	trace_free(f, 4, 300, 1, 1);
+	trace_close(f, 5, 300, 1);
+	load(&replay, f, &buf, &len);
+
+	igt_assert_eq(replay.processes, 1);
+	igt_assert_eq(replay.resets, 1);
+
+	intel_allocator_replay_run(&replay, 0, false);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_OPEN].count, 2);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_OPEN].failed, 0);
+	/* the object leaked by the first subtest is gone */
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_FREE].failed, 1);
+	igt_assert_eq(replay.ops[INTEL_ALLOCATOR_TRACE_CLOSE].failed, 0);
+	intel_allocator_replay_fini(&replay);
+}
+
+static void test_paced(void)
+{
+	struct intel_allocator_replay replay;
+	uint64_t full;
+
+	/* 2000 operations over 50ms */
+	checkerboard(&replay, INTEL_ALLOCATOR_SIMPLE, 25000);
+
+	intel_allocator_replay_run(&replay, 0, false);
+	full = replay.duration_ns;
+
+	intel_allocator_replay_run(&replay, 0, true);
+	igt_debug("full speed: %" PRIu64 "ns, paced: %" PRIu64 "ns\n",
+		  full, replay.duration_ns);
+	igt_assert_lte(50 * 1000 * 1000, replay.duration_ns);
+	igt_assert_lt(full, replay.duration_ns);
+
+	intel_allocator_replay_fini(&replay);
+}
+
+igt_main
+{
+	igt_describe("Traces are parsed back into operations");
+	igt_subtest("load")
+		test_load();
+
+	igt_describe("Replay against the simple allocator");
+	igt_subtest("replay-simple")
+		test_replay(INTEL_ALLOCATOR_SIMPLE);
+
+	igt_describe("Replay of a simple allocator trace against the reloc one");
+	igt_subtest("replay-reloc")
+		test_replay(INTEL_ALLOCATOR_RELOC);
+
+	igt_describe("Opens of the same ctx share an allocator");
+	igt_subtest("shared")
+		test_shared();
+
+	igt_describe("Allocator resets between subtests start the replay over");
+	igt_subtest("reset")
+		test_reset();
+
+	igt_describe("Paced replay follows the logged timestamps");
+	igt_subtest("paced")
+		test_paced();
+}
@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include "igt_core.h"
+#include "igt_rand.h"
+#include "intel_aux_pgtable.h"
+#include "intel_batchbuffer.h"
+#include "intel_bufops.h"
+
+IGT_TEST_DESCRIPTION("Check the persistent AUX page table against the from scratch builder");
+
+#define DEVID_TGL	0x9a49
+#define DEVID_MTL	0x7d55
+
+#define NUM_SLOTS	24
+
+struct storage {
+	void *ptr;
+	uint64_t address;
+	uint32_t size;
+};
+
+static uint64_t block_size(uint32_t devid)
+{
+	return devid == DEVID_MTL ? 1 << 20 : 1 << 16;
+}
+
+static void init_buf(struct intel_buf *buf, uint32_t handle, uint64_t addr,
+		     uint32_t width, uint32_t height, int kind)
+{
+	uint64_t ccs_offset;
+
+	memset(buf, 0, sizeof(*buf));
+	buf->handle = handle;
+	buf->addr.offset = addr;
+	buf->compression = I915_COMPRESSION_RENDER;
+	buf->width = width;
+	buf->height = height;
+
+	switch (kind) {
+	case 0:
+		buf->tiling = I915_TILING_Y;
+		buf->bpp = 32;
+		buf->depth = 24;
+		break;
+	case 1:
+		buf->tiling = I915_TILING_4;
+		buf->bpp = 64;
+		break;
+	case 2:
+		buf->tiling = I915_TILING_Y;
+		buf->bpp = 8;
+		buf->format_is_yuv = true;
+		buf->format_is_yuv_semiplanar = true;
+		buf->yuv_semiplanar_bpp = 8;
+		break;
+	default:
+		buf->tiling = I915_TILING_4;
+		buf->bpp = 16;
+		buf->format_is_yuv = true;
+		buf->format_is_yuv_semiplanar = true;
+		buf->yuv_semiplanar_bpp = 10;
+		break;
+	}
+
+	buf->surface[0].stride = ALIGN(width * buf->bpp / 8, 512);
+	buf->surface[0].size = (uint64_t)buf->surface[0].stride * height;
+	ccs_offset = buf->surface[0].size;
+
+	if (buf->format_is_yuv_semiplanar) {
+		buf->surface[1].offset = buf->surface[0].size;
+		buf->surface[1].stride = buf->surface[0].stride;
+		buf->surface[1].size = buf->surface[0].size / 2;
+		ccs_offset += buf->surface[1].size;
+	}
+
+	ccs_offset = ALIGN(ccs_offset, 4096);
+	buf->ccs[0].offset = ccs_offset;
+	buf->ccs[0].stride = buf->surface[0].stride / 512 * 64;
+	buf->size = ccs_offset + ALIGN(buf->surface[0].size / 256, 4096);
+
+	if (buf->format_is_yuv_semiplanar) {
+		buf->ccs[1].offset = buf->size;
+		buf->ccs[1].stride = buf->ccs[0].stride;
+		buf->size += ALIGN(buf->surface[1].size / 256, 4096);
+	}
+	buf->bo_size = buf->size;
+}
+
+static void random_buf(struct intel_buf *buf, uint32_t handle, uint32_t devid)
+{
+	/* a small address space, so that new buffers land over stale ones */
+	uint64_t addr = (uint64_t)(hars_petruska_f54_1_random_unsafe() % 4) << 36 |
+			(uint64_t)(hars_petruska_f54_1_random_unsafe() % 64) *
+			block_size(devid);
+
+	init_buf(buf, handle, addr,
+		 64 + hars_petruska_f54_1_random_unsafe() % 2048,
+		 16 + hars_petruska_f54_1_random_unsafe() % 1024,
+		 hars_petruska_f54_1_random_unsafe() % 4);
+}
+
+static bool bufs_overlap(const struct intel_buf *a, const struct intel_buf *b,
+			 uint32_t devid)
+{
+	uint64_t a_end = ALIGN(a->addr.offset + a->size, block_size(devid));
+	uint64_t b_end = ALIGN(b->addr.offset + b->size, block_size(devid));
+
+	return a->addr.offset < b_end && b->addr.offset < a_end;
+}
+
+static void storage_alloc(struct storage *st, uint32_t size)
+{
+	free(st->ptr);
+	st->ptr = aligned_alloc(4096, size);
+	igt_assert(st->ptr);
+	st->size = size;
+	/* a different GPU address every time to catch stale pointers */
+	st->address = (st->address ?: 0xfff000000000ull) - ALIGN(size, 1 << 20);
+}
+
+static int update(struct intel_aux_pgtable *pgt, struct storage *st,
+		  struct intel_buf **bufs, int buf_count)
+{
+	int ret;
+
+	while ((ret = intel_aux_pgtable_update(pgt, bufs, buf_count)) == -ENOSPC) {
+		do {
+			storage_alloc(st, st->size * 2);
+		} while (intel_aux_pgtable_set_storage(pgt, st->ptr, st->address,
+						       st->size));
+	}
+
+	return ret;
+}
+
+static void compare(struct intel_aux_pgtable *pgt, uint32_t devid,
+		    struct intel_buf **bufs, int buf_count)
+{
+	struct storage ref = {};
+	uint32_t size;
+
+	size = intel_aux_pgtable_build(devid, bufs, buf_count, NULL, 0);
+	storage_alloc(&ref, ALIGN(size, 4096));
+	memset(ref.ptr, 0, ref.size);
+	intel_aux_pgtable_build(devid, bufs, buf_count, ref.ptr, ref.address);
+
+	/* walk the blocks the way the builder does, plane by plane */
+	for (int i = 0; i < buf_count; i++) {
+		const struct intel_buf *buf = bufs[i];
+		int planes = buf->format_is_yuv_semiplanar ? 2 : 1;
+
+		for (int p = 0; p < planes; p++) {
+			uint64_t start = buf->addr.offset + buf->surface[p].offset;
+			uint64_t end = start + buf->surface[p].size;
+
+			for (uint64_t addr = start; addr < end; addr += block_size(devid)) {
+				uint64_t expected;
+
+				expected = intel_aux_pgtable_translate(devid, ref.ptr,
+								       ref.address,
+								       addr);
+				igt_assert_neq_u64(expected, 0);
+				igt_assert_eq_u64(intel_aux_pgtable_lookup(pgt, addr),
+						  expected);
+			}
+		}
+	}
+
+	free(ref.ptr);
+}
+
+static void sort_bufs(struct intel_buf **bufs, int buf_count)
+{
+	if (buf_count == 2 && bufs[0]->addr.offset > bufs[1]->addr.offset) {
+		struct intel_buf *tmp = bufs[0];
+
+		bufs[0] = bufs[1];
+		bufs[1] = tmp;
+	}
+}
+
+static void test_compare(uint32_t devid)
+{
+	struct intel_buf slots[NUM_SLOTS];
+	struct intel_aux_pgtable_stats stats;
+	struct intel_aux_pgtable *pgt;
+	struct storage st = {};
+	uint32_t next_handle = 1;
+	uint64_t written = 0, rebuilt = 0;
+
+	hars_petruska_f54_1_random_seed(devid);
+
+	for (int i = 0; i < NUM_SLOTS; i++)
+		random_buf(&slots[i], next_handle++, devid);
+
+	pgt = intel_aux_pgtable_new(devid);
+	storage_alloc(&st, 64 * 1024);
+	igt_assert_eq(intel_aux_pgtable_set_storage(pgt, st.ptr, st.address,
+						    st.size), 0);
+
+	for (int loop = 0; loop < 2000; loop++) {
+		struct intel_buf *bufs[2];
+		int buf_count = 1 + hars_petruska_f54_1_random_unsafe() % 2;
+		int ret;
+
+		for (int i = 0; i < buf_count; i++) {
+			struct intel_buf *buf;
+			uint32_t r = hars_petruska_f54_1_random_unsafe();
+
+			buf = &slots[r % NUM_SLOTS];
+			switch ((r >> 8) % 16) {
+			case 0:
+			case 1:
+				/* destroyed, a new buffer takes its place */
+				random_buf(buf, next_handle++, devid);
+				break;
+			case 2:
+				/* rebound elsewhere */
+				random_buf(buf, buf->handle, devid);
+				break;
+			}
+			bufs[i] = buf;
+		}
+
+		if (buf_count == 2 &&
+		    (bufs[0] == bufs[1] || bufs_overlap(bufs[0], bufs[1], devid)))
+			buf_count = 1;
+		sort_bufs(bufs, buf_count);
+
+		ret = update(pgt, &st, bufs, buf_count);
+		igt_assert_lte(0, ret);
+		compare(pgt, devid, bufs, buf_count);
+
+		/* nothing to do the second time around */
+		igt_assert(!intel_aux_pgtable_needs_update(pgt, bufs, buf_count));
+		igt_assert_eq(intel_aux_pgtable_update(pgt, bufs, buf_count), 0);
+
+		if (!(loop % 100))
+			intel_aux_pgtable_check(pgt);
+
+		written += ret;
+		rebuilt += intel_aux_pgtable_build(devid, bufs, buf_count, NULL, 0) /
+			   sizeof(uint64_t);
+	}
+
+	intel_aux_pgtable_check(pgt);
+	stats = intel_aux_pgtable_get_stats(pgt);
+	igt_info("%"PRIu64" entries written, %"PRIu64" table entries rebuilt from scratch, %u tables, %"PRIu64" storage rebuilds\n",
+		 written, rebuilt, stats.tables, stats.rebuilds);
+
+	intel_aux_pgtable_free(pgt);
+	free(st.ptr);
+}
+
+static void test_incremental(uint32_t devid)
+{
+	struct intel_aux_pgtable_stats stats;
+	struct intel_aux_pgtable *pgt;
+	struct intel_buf a, b, *bufs[2] = { &a, &b };
+	struct storage st = {};
+
+	pgt = intel_aux_pgtable_new(devid);
+	/* just enough for the top level table, two buffers and a move */
+	storage_alloc(&st, 256 * 1024);
+	igt_assert_eq(intel_aux_pgtable_set_storage(pgt, st.ptr, st.address,
+						    st.size), 0);
+
+	init_buf(&a, 1, 1ull << 32, 1024, 512, 0);
+	init_buf(&b, 2, 3ull << 40, 1024, 512, 2);
+
+	igt_assert_lt(0, intel_aux_pgtable_update(pgt, bufs, 2));
+	compare(pgt, devid, bufs, 2);
+	stats = intel_aux_pgtable_get_stats(pgt);
+	/* top level plus one L2 and one L1 table for each buffer */
+	igt_assert_eq(stats.tables, 5);
+
+	/* same buffers, same addresses: nothing is written */
+	igt_assert_eq(intel_aux_pgtable_update(pgt, bufs, 2), 0);
+	igt_assert_eq(intel_aux_pgtable_update(pgt, &bufs[1], 1), 0);
+
+	/* a format change only rewrites the L1 entries of that buffer */
+	init_buf(&a, 1, 1ull << 32, 1024, 512, 1);
+	igt_assert_lt(0, intel_aux_pgtable_update(pgt, bufs, 1));
+	igt_assert_eq(intel_aux_pgtable_get_stats(pgt).tables_allocated,
+		      stats.tables_allocated);
+	compare(pgt, devid, bufs, 2);
+
+	/* moving a buffer releases the tables of its old location */
+	init_buf(&a, 1, 2ull << 40, 1024, 512, 1);
+	igt_assert_lt(0, intel_aux_pgtable_update(pgt, bufs, 1));
+	compare(pgt, devid, bufs, 2);
+	igt_assert_eq(intel_aux_pgtable_get_stats(pgt).tables, 5);
+	igt_assert_eq_u64(intel_aux_pgtable_lookup(pgt, 1ull << 32), 0);
+	intel_aux_pgtable_check(pgt);
+
+	/* a new buffer over a stale one replaces it */
+	init_buf(&b, 3, 3ull << 40, 4096, 512, 0);
+	igt_assert(intel_aux_pgtable_needs_update(pgt, &bufs[1], 1));
+	igt_assert_lt(0, intel_aux_pgtable_update(pgt, &bufs[1], 1));
+	compare(pgt, devid, bufs, 2);
+	igt_assert_eq(intel_aux_pgtable_get_stats(pgt).mappings, 2);
+
+	intel_aux_pgtable_evict(pgt, 1);
+	intel_aux_pgtable_evict(pgt, 3);
+	intel_aux_pgtable_check(pgt);
+	stats = intel_aux_pgtable_get_stats(pgt);
+	igt_assert_eq(stats.tables, 1);
+	igt_assert_eq(stats.mappings, 0);
+	igt_assert_eq(stats.tables_allocated, stats.tables_freed + 1);
+
+	/* released tables are reused, the storage never runs out */
+	for (int i = 0; i < 16; i++) {
+		init_buf(&a, 1, (uint64_t)(2 * i + 1) << 36, 1024, 512, 0);
+		init_buf(&b, 3, (uint64_t)(2 * i + 2) << 36, 1024, 512, 2);
+		igt_assert_lt(0, intel_aux_pgtable_update(pgt, bufs, 2));
+		compare(pgt, devid, bufs, 2);
+	}
+	intel_aux_pgtable_check(pgt);
+	igt_assert_eq(intel_aux_pgtable_get_stats(pgt).tables, 5);
+
+	intel_aux_pgtable_free(pgt);
+	free(st.ptr);
+}
+
+static void test_relocate(uint32_t devid)
+{
+	struct intel_aux_pgtable *pgt;
+	struct intel_buf bufs[8], *ptrs[8];
+	struct storage st = {};
+
+	pgt = intel_aux_pgtable_new(devid);
+	storage_alloc(&st, 32 * 1024);
+	igt_assert_eq(intel_aux_pgtable_set_storage(pgt, st.ptr, st.address,
+						    st.size), 0);
+
+	/* too small for a single buffer, the storage has to grow */
+	for (int i = 0; i < ARRAY_SIZE(bufs); i++) {
+		init_buf(&bufs[i], i + 1, (uint64_t)(i + 1) << 38, 512, 256, i % 4);
+		ptrs[i] = &bufs[i];
+		igt_assert_lt(0, update(pgt, &st, &ptrs[i], 1));
+	}
+
+	intel_aux_pgtable_check(pgt);
+	for (int i = 0; i < ARRAY_SIZE(bufs); i++)
+		compare(pgt, devid, &ptrs[i], 1);
+
+	/* the table moving rewrites every pointer */
+	storage_alloc(&st, st.size);
+	igt_assert_eq(intel_aux_pgtable_set_storage(pgt, st.ptr, st.address,
+						    st.size), 0);
+	intel_aux_pgtable_check(pgt);
+	for (int i = 0; i < ARRAY_SIZE(bufs); i++)
+		compare(pgt, devid, &ptrs[i], 1);
+
+	intel_aux_pgtable_free(pgt);
+	free(st.ptr);
+}
+
+igt_main
+{
+	static const struct {
+		const char *name;
+		uint32_t devid;
+	} platforms[] = {
+		{ "tgl", DEVID_TGL },
+		{ "mtl", DEVID_MTL },
+	};
+
+	for (int i = 0; i < ARRAY_SIZE(platforms); i++) {
+		igt_describe("Compare with the from scratch builder on random buffer sets");
+		igt_subtest_f("compare-%s", platforms[i].name)
+			test_compare(platforms[i].devid);
+
+		igt_describe("Check only changed entries are written and unused tables are released");
+		igt_subtest_f("incremental-%s", platforms[i].name)
+			test_incremental(platforms[i].devid);
+
+		igt_describe("Check the table survives growing and moving its storage");
+		igt_subtest_f("relocate-%s", platforms[i].name)
+			test_relocate(platforms[i].devid);
+	}
+}
@@ -0,0 +1,361 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include "igt_core.h"
+#include "intel_blt.h"
+#include "i915/intel_memory_region.h"
+
+IGT_TEST_DESCRIPTION("Decode the batches built by the blitter stream without a device");
+
+#define DG2_DEVID	0x56a0
+#define BATCH_SIZE	4096
+#define MAX_CMDS	256
+#define MAX_SUBMITS	8
+
+#define OP_FLUSH	0x1000
+#define OP_BLOCK_COPY	0x41
+#define OP_FAST_COPY	0x42
+#define OP_MEM_COPY	0x5a
+#define OP_MEM_SET	0x5b
+
+struct cmd {
+	unsigned int op;
+	uint64_t src, dst;
+};
+
+struct submit {
+	struct cmd cmds[MAX_CMDS];
+	int num_cmds;
+	int num_objs;
+	int written;
+};
+
+struct mock {
+	struct submit submits[MAX_SUBMITS];
+	int num_submits;
+	int offset_calls;
+};
+
+static uint64_t addr(const uint32_t *cs, int lo)
+{
+	return cs[lo] | (uint64_t)cs[lo + 1] << 32;
+}
+
+/* Walks the batch the way the command streamer would and records each blit */
+static void decode(struct submit *sub, const uint32_t *cs, uint64_t size)
+{
+	unsigned int i = 0;
+
+	while (i < size / sizeof(*cs)) {
+		uint32_t dw = cs[i];
+		struct cmd *cmd = &sub->cmds[sub->num_cmds];
+		unsigned int len;
+
+		if (dw == MI_BATCH_BUFFER_END)
+			return;
+
+		if (dw == MI_NOOP) {
+			i++;
+			continue;
+		}
+
+		igt_assert(sub->num_cmds < MAX_CMDS);
+
+		if ((dw >> 29) == 0) {
+			igt_assert_eq_u32(dw, MI_FLUSH_DW_CMD | 2);
+			cmd->op = OP_FLUSH;
+			len = 4;
+		} else {
+			igt_assert_eq_u32(dw >> 29, 2);
+			cmd->op = (dw >> 22) & 0x7f;
+			len = (dw & 0xff) + 2;
+
+			switch (cmd->op) {
+			case OP_BLOCK_COPY:
+				cmd->dst = addr(cs + i, 4);
+				cmd->src = addr(cs + i, 9);
+				break;
+			case OP_FAST_COPY:
+				cmd->dst = addr(cs + i, 4);
+				cmd->src = addr(cs + i, 8);
+				break;
+			case OP_MEM_COPY:
+				cmd->src = addr(cs + i, 5);
+				cmd->dst = addr(cs + i, 7);
+				break;
+			case OP_MEM_SET:
+				cmd->dst = addr(cs + i, 4);
+				break;
+			default:
+				igt_assert_f(0, "unexpected opcode %x\n", cmd->op);
+			}
+		}
+
+		sub->num_cmds++;
+		i += len;
+	}
+
+	igt_assert_f(0, "batch not terminated\n");
+}
+
+static uint64_t mock_offset(struct blt_stream *s, uint32_t handle,
+			    uint64_t size, uint64_t alignment,
+			    uint8_t pat_index)
+{
+	struct mock *m = s->priv;
+
+	m->offset_calls++;
+
+	return (uint64_t)handle << 32 | 0x10000;
+}
+
+static int mock_exec(struct blt_stream *s)
+{
+	struct mock *m = s->priv;
+	struct submit *sub;
+
+	igt_assert(m->num_submits < MAX_SUBMITS);
+	sub = &m->submits[m->num_submits++];
+
+	decode(sub, (uint32_t *)s->ptr, s->pos);
+	sub->num_objs = s->num_objs;
+	for (int i = 0; i < s->num_objs; i++)
+		sub->written += s->objs[i].write;
+
+	return 0;
+}
+
+static const struct blt_stream_ops mock_ops = {
+	.offset = mock_offset,
+	.exec = mock_exec,
+};
+
+static struct blt_stream *create(struct mock *m, void **batch)
+{
+	memset(m, 0, sizeof(*m));
+	*batch = calloc(1, BATCH_SIZE);
+	igt_assert(*batch);
+
+	return __blt_stream_create(DG2_DEVID, INTEL_DRIVER_I915, *batch,
+				   BATCH_SIZE, 0x1000, &mock_ops, m);
+}
+
+static void fast_copy(struct blt_stream *s, uint32_t src, uint32_t dst)
+{
+	struct blt_copy_data blt = {
+		.driver = INTEL_DRIVER_I915,
+		.color_depth = CD_32bit,
+	};
+
+	blt_set_object(&blt.src, src, SZ_64K, REGION_SMEM, 0, 0, T_LINEAR,
+		       COMPRESSION_DISABLED, COMPRESSION_TYPE_3D);
+	blt_set_object(&blt.dst, dst, SZ_64K, REGION_SMEM, 0, 0, T_LINEAR,
+		       COMPRESSION_DISABLED, COMPRESSION_TYPE_3D);
+	blt_set_geom(&blt.src, 512, 0, 0, 128, 128, 0, 0);
+	blt_set_geom(&blt.dst, 512, 0, 0, 128, 128, 0, 0);
+
+	blt_stream_fast_copy(s, &blt);
+}
+
+static void block_copy(struct blt_stream *s, uint32_t src, uint32_t dst)
+{
+	struct blt_copy_data blt = {
+		.driver = INTEL_DRIVER_I915,
+		.color_depth = CD_32bit,
+	};
+
+	blt_set_object(&blt.src, src, SZ_64K, REGION_SMEM, 0, 0, T_LINEAR,
+		       COMPRESSION_DISABLED, COMPRESSION_TYPE_3D);
+	blt_set_object(&blt.dst, dst, SZ_64K, REGION_SMEM, 0, 0, T_TILE4,
+		       COMPRESSION_DISABLED, COMPRESSION_TYPE_3D);
+	blt_set_geom(&blt.src, 512, 0, 0, 128, 128, 0, 0);
+	blt_set_geom(&blt.dst, 512, 0, 0, 128, 128, 0, 0);
+
+	blt_stream_block_copy(s, &blt, NULL);
+}
+
+static void mem_set(struct blt_stream *s, uint32_t dst)
+{
+	struct blt_mem_set_data mem = {
+		.driver = INTEL_DRIVER_I915,
+		.fill_type = TYPE_LINEAR,
+	};
+
+	blt_set_mem_object(&mem.dst, dst, SZ_64K, SZ_4K, SZ_4K, 16,
+			   REGION_SMEM, 0, 0, COMPRESSION_DISABLED);
+
+	blt_stream_mem_set(s, &mem, 0xa5);
+}
+
+static void mem_copy(struct blt_stream *s, uint32_t src, uint32_t dst)
+{
+	struct blt_mem_copy_data mem = {
+		.driver = INTEL_DRIVER_I915,
+		.mode = MODE_BYTE,
+		.copy_type = TYPE_LINEAR,
+	};
+
+	blt_set_mem_object(&mem.src, src, SZ_64K, SZ_64K, SZ_64K, 1,
+			   REGION_SMEM, 0, 0, COMPRESSION_DISABLED);
+	blt_set_mem_object(&mem.dst, dst, SZ_64K, SZ_64K, SZ_64K, 1,
+			   REGION_SMEM, 0, 0, COMPRESSION_DISABLED);
+
+	blt_stream_mem_copy(s, &mem);
+}
+
+static void check_cmd(const struct cmd *cmd, unsigned int op,
+		      uint32_t src, uint32_t dst)
+{
+	igt_assert_eq_u32(cmd->op, op);
+	if (src)
+		igt_assert_eq_u64(cmd->src, (uint64_t)src << 32 | 0x10000);
+	if (dst)
+		igt_assert_eq_u64(cmd->dst, (uint64_t)dst << 32 | 0x10000);
+}
+
+static void test_single_submit(void)
+{
+	struct blt_stream *s;
+	struct submit *sub;
+	struct mock m;
+	void *batch;
+
+	s = create(&m, &batch);
+
+	/* independent blits are not separated */
+	mem_set(s, 1);
+	mem_set(s, 2);
+	fast_copy(s, 3, 4);
+	block_copy(s, 5, 6);
+	mem_copy(s, 7, 8);
+	igt_assert_eq(m.num_submits, 0);
+
+	igt_assert_eq(blt_stream_flush(s), 0);
+	igt_assert_eq(m.num_submits, 1);
+	igt_assert_eq(blt_stream_flush(s), 0);
+	igt_assert_eq(m.num_submits, 1);
+
+	sub = &m.submits[0];
+	igt_assert_eq(sub->num_cmds, 5);
+	check_cmd(&sub->cmds[0], OP_MEM_SET, 0, 1);
+	check_cmd(&sub->cmds[1], OP_MEM_SET, 0, 2);
+	check_cmd(&sub->cmds[2], OP_FAST_COPY, 3, 4);
+	check_cmd(&sub->cmds[3], OP_BLOCK_COPY, 5, 6);
+	check_cmd(&sub->cmds[4], OP_MEM_COPY, 7, 8);
+
+	igt_assert_eq(sub->num_objs, 8);
+	igt_assert_eq(sub->written, 5);
+	igt_assert_eq(m.offset_calls, 8);
+	igt_assert_eq(s->stats.flushes, 0);
+
+	blt_stream_destroy(s);
+	free(batch);
+}
+
+static void test_hazards(void)
+{
+	struct blt_stream *s;
+	struct submit *sub;
+	struct mock m;
+	void *batch;
+
+	s = create(&m, &batch);
+
+	mem_set(s, 1);
+	fast_copy(s, 1, 2);	/* RAW on 1 */
+	fast_copy(s, 1, 3);	/* two readers of 1 */
+	mem_set(s, 1);		/* WAR on 1 */
+	mem_set(s, 4);
+	mem_set(s, 4);		/* WAW on 4 */
+	fast_copy(s, 2, 5);	/* 2 written before the last flush */
+	blt_stream_destroy(s);
+
+	igt_assert_eq(m.num_submits, 1);
+	sub = &m.submits[0];
+	igt_assert_eq(sub->num_cmds, 10);
+	check_cmd(&sub->cmds[0], OP_MEM_SET, 0, 1);
+	check_cmd(&sub->cmds[1], OP_FLUSH, 0, 0);
+	check_cmd(&sub->cmds[2], OP_FAST_COPY, 1, 2);
+	check_cmd(&sub->cmds[3], OP_FAST_COPY, 1, 3);
+	check_cmd(&sub->cmds[4], OP_FLUSH, 0, 0);
+	check_cmd(&sub->cmds[5], OP_MEM_SET, 0, 1);
+	check_cmd(&sub->cmds[6], OP_MEM_SET, 0, 4);
+	check_cmd(&sub->cmds[7], OP_FLUSH, 0, 0);
+	check_cmd(&sub->cmds[8], OP_MEM_SET, 0, 4);
+	check_cmd(&sub->cmds[9], OP_FAST_COPY, 2, 5);
+
+	/* every object is resolved once per submission */
+	igt_assert_eq(m.offset_calls, 5);
+	igt_assert_eq(sub->num_objs, 5);
+	igt_assert_eq(sub->written, 5);
+
+	free(batch);
+}
+
+static void test_overflow(void)
+{
+	const int count = 200;
+	struct blt_stream *s;
+	struct mock m;
+	void *batch;
+	int total = 0;
+
+	s = create(&m, &batch);
+
+	/*
+	 * Each mem-set overwrites the previous one, 11 dwords with the flush.
+	 * 24 bytes are kept for a flush and the batch end, so a 4K batch
+	 * holds 93 of them.
+	 */
+	for (int i = 0; i < count; i++)
+		mem_set(s, 1);
+	fast_copy(s, 2, 3);
+
+	igt_assert_eq(m.num_submits, 2);
+	igt_assert_eq(s->stats.ops, count + 1);
+	igt_assert_eq(s->stats.flushes, count - 3);
+	blt_stream_destroy(s);
+	igt_assert_eq(m.num_submits, 3);
+
+	for (int i = 0; i < m.num_submits; i++) {
+		struct submit *sub = &m.submits[i];
+
+		/* a new submission starts without pending hazards */
+		check_cmd(&sub->cmds[0], OP_MEM_SET, 0, 1);
+
+		for (int j = 0; j < sub->num_cmds; j++) {
+			if (sub->cmds[j].op != OP_MEM_SET)
+				continue;
+
+			total++;
+			if (j)
+				igt_assert_eq_u32(sub->cmds[j - 1].op, OP_FLUSH);
+		}
+	}
+
+	igt_assert_eq(m.submits[0].num_cmds, 2 * 93 - 1);
+	igt_assert_eq(m.submits[1].num_cmds, 2 * 93 - 1);
+	check_cmd(&m.submits[2].cmds[m.submits[2].num_cmds - 1],
+		  OP_FAST_COPY, 2, 3);
+	igt_assert_eq(m.submits[2].num_objs, 3);
+	igt_assert_eq(total, count);
+
+	free(batch);
+}
+
+igt_main
+{
+	igt_describe("Check independent blits share a submission without flushes");
+	igt_subtest("single-submit")
+		test_single_submit();
+
+	igt_describe("Check flushes are emitted only between dependent blits");
+	igt_subtest("hazards")
+		test_hazards();
+
+	igt_describe("Check a full batch is submitted and the stream carries on");
+	igt_subtest("overflow")
+		test_overflow();
+}
@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <string.h>
+
+#include "drmtest.h"
+#include "igt_core.h"
+#include "igt_list.h"
+#include "igt_rand.h"
+#include "intel_pat.h"
+#include "xe/xe_util.h"
+
+IGT_TEST_DESCRIPTION("Check the merging of the xe bind queue against a mock backend");
+
+#define SZ_PAGE		0x1000ull
+#define MAX_BINDS	32
+
+struct bind {
+	struct drm_xe_vm_bind_op ops[1024];
+	uint32_t num_ops;
+	uint32_t sync_in, sync_out;
+};
+
+static struct {
+	struct bind binds[MAX_BINDS];
+	int num_binds;
+} mock;
+
+static void mock_bind(struct xe_bind_queue *q, struct drm_xe_vm_bind_op *ops,
+		      uint32_t num_ops, uint32_t sync_in, uint32_t sync_out)
+{
+	struct bind *b = &mock.binds[mock.num_binds++];
+
+	igt_assert(mock.num_binds <= MAX_BINDS);
+	igt_assert(num_ops <= ARRAY_SIZE(b->ops));
+	if (num_ops)
+		memcpy(b->ops, ops, num_ops * sizeof(*ops));
+	b->num_ops = num_ops;
+	b->sync_in = sync_in;
+	b->sync_out = sync_out;
+}
+
+static const struct xe_bind_queue_ops mock_ops = {
+	.bind = mock_bind,
+};
+
+static struct xe_bind_queue *mock_create(void)
+{
+	memset(&mock, 0, sizeof(mock));
+
+	return __xe_bind_queue_create(&mock_ops, NULL);
+}
+
+static void assert_op(const struct drm_xe_vm_bind_op *op, uint32_t kind,
+		      uint32_t handle, uint64_t obj_offset, uint64_t addr,
+		      uint64_t range)
+{
+	igt_assert_eq_u32(op->op, kind);
+	igt_assert_eq_u32(op->obj, handle);
+	igt_assert_eq_u64(op->obj_offset, obj_offset);
+	igt_assert_eq_u64(op->addr, addr);
+	igt_assert_eq_u64(op->range, range);
+}
+
+static void test_merge(void)
+{
+	struct xe_bind_queue *q;
+	struct bind *b;
+
+	q = mock_create();
+
+	/* the pages of one object, in any order, at the same delta */
+	xe_bind_queue_map(q, 1, SZ_PAGE, 0x101000, SZ_PAGE, 2);
+	xe_bind_queue_map(q, 1, 0, 0x100000, SZ_PAGE, 2);
+	xe_bind_queue_map(q, 1, 2 * SZ_PAGE, 0x102000, 100, 2);
+	xe_bind_queue_map(q, 1, 0, 0x100000, 2 * SZ_PAGE, 2);
+
+	/* another object, another delta, another PAT */
+	xe_bind_queue_map(q, 2, 0, 0x103000, SZ_PAGE, 2);
+	xe_bind_queue_map(q, 1, 0, 0x200000, SZ_PAGE, 2);
+	xe_bind_queue_map(q, 1, 0, 0x201000, SZ_PAGE, 3);
+
+	xe_bind_queue_prefetch(q, 0x100000, SZ_PAGE, 1);
+	xe_bind_queue_prefetch(q, 0x101000, SZ_PAGE, 1);
+	xe_bind_queue_prefetch(q, 0x102000, SZ_PAGE, 0);
+
+	/* the last one joins both */
+	xe_bind_queue_unmap(q, 0x300000, SZ_PAGE);
+	xe_bind_queue_unmap(q, 0x302000, SZ_PAGE);
+	xe_bind_queue_unmap(q, 0x301000, SZ_PAGE);
+
+	igt_assert_eq(xe_bind_queue_flush(q, 0, 0), 7);
+	igt_assert_eq(mock.num_binds, 1);
+	b = &mock.binds[0];
+	assert_op(&b->ops[0], DRM_XE_VM_BIND_OP_MAP, 1, 0, 0x100000, 3 * SZ_PAGE);
+	igt_assert_eq(b->ops[0].pat_index, 2);
+	assert_op(&b->ops[1], DRM_XE_VM_BIND_OP_MAP, 2, 0, 0x103000, SZ_PAGE);
+	assert_op(&b->ops[2], DRM_XE_VM_BIND_OP_MAP, 1, 0, 0x200000, SZ_PAGE);
+	assert_op(&b->ops[3], DRM_XE_VM_BIND_OP_MAP, 1, 0, 0x201000, SZ_PAGE);
+	igt_assert_eq(b->ops[3].pat_index, 3);
+	assert_op(&b->ops[4], DRM_XE_VM_BIND_OP_PREFETCH, 0, 0, 0x100000, 2 * SZ_PAGE);
+	igt_assert_eq(b->ops[4].prefetch_mem_region_instance, 1);
+	assert_op(&b->ops[5], DRM_XE_VM_BIND_OP_PREFETCH, 0, 0, 0x102000, SZ_PAGE);
+	assert_op(&b->ops[6], DRM_XE_VM_BIND_OP_UNMAP, 0, 0, 0x300000, 3 * SZ_PAGE);
+
+	igt_assert_eq(q->stats.queued, 13);
+	igt_assert_eq(q->stats.merged, 6);
+	igt_assert_eq(q->stats.cancelled, 0);
+
+	xe_bind_queue_destroy(q);
+	igt_assert_eq(mock.num_binds, 1);
+}
+
+/* Operations are never merged across another one on the same range */
+static void test_order(void)
+{
+	struct xe_bind_queue *q;
+	struct bind *b;
+
+	q = mock_create();
+
+	xe_bind_queue_map(q, 1, 0, 0x100000, SZ_PAGE, 0);
+	xe_bind_queue_prefetch(q, 0x100000, SZ_PAGE, 1);
+	xe_bind_queue_unmap(q, 0x101000, SZ_PAGE);
+	xe_bind_queue_map(q, 1, SZ_PAGE, 0x101000, SZ_PAGE, 0);
+	xe_bind_queue_prefetch(q, 0x101000, SZ_PAGE, 1);
+
+	igt_assert_eq(xe_bind_queue_flush(q, 0, 0), 5);
+	b = &mock.binds[0];
+	assert_op(&b->ops[0], DRM_XE_VM_BIND_OP_MAP, 1, 0, 0x100000, SZ_PAGE);
+	assert_op(&b->ops[1], DRM_XE_VM_BIND_OP_PREFETCH, 0, 0, 0x100000, SZ_PAGE);
+	assert_op(&b->ops[2], DRM_XE_VM_BIND_OP_UNMAP, 0, 0, 0x101000, SZ_PAGE);
+	assert_op(&b->ops[3], DRM_XE_VM_BIND_OP_MAP, 1, SZ_PAGE, 0x101000, SZ_PAGE);
+	assert_op(&b->ops[4], DRM_XE_VM_BIND_OP_PREFETCH, 0, 0, 0x101000, SZ_PAGE);
+
+	/* an unmap is not cancelled past an older unmap, but joins it */
+	xe_bind_queue_map(q, 1, 0, 0x100000, SZ_PAGE, 0);
+	xe_bind_queue_prefetch(q, 0x100000, SZ_PAGE, 1);
+	xe_bind_queue_unmap(q, 0x101000, SZ_PAGE);
+	xe_bind_queue_map(q, 1, SZ_PAGE, 0x101000, SZ_PAGE, 0);
+	xe_bind_queue_prefetch(q, 0x101000, SZ_PAGE, 1);
+	xe_bind_queue_unmap(q, 0x101000, SZ_PAGE);
+	xe_bind_queue_unmap(q, 0x100000, 2 * SZ_PAGE);
+
+	igt_assert_eq(xe_bind_queue_flush(q, 0, 0), 3);
+	b = &mock.binds[1];
+	assert_op(&b->ops[0], DRM_XE_VM_BIND_OP_MAP, 1, 0, 0x100000, SZ_PAGE);
+	assert_op(&b->ops[1], DRM_XE_VM_BIND_OP_PREFETCH, 0, 0, 0x100000, SZ_PAGE);
+	assert_op(&b->ops[2], DRM_XE_VM_BIND_OP_UNMAP, 0, 0, 0x100000, 2 * SZ_PAGE);
+
+	xe_bind_queue_destroy(q);
+}
+
+static void test_cancel(void)
+{
+	struct xe_bind_queue *q;
+	struct bind *b;
+
+	q = mock_create();
+
+	/* exact pairs vanish, with what was queued in between */
+	xe_bind_queue_map(q, 1, 0, 0x100000, 4 * SZ_PAGE, 0);
+	xe_bind_queue_prefetch(q, 0x101000, SZ_PAGE, 1);
+	xe_bind_queue_unmap(q, 0x100000, 4 * SZ_PAGE);
+	igt_assert_eq(q->stats.cancelled, 3);
+	igt_assert_eq(xe_bind_queue_flush(q, 0, 0), 0);
+	igt_assert_eq(mock.num_binds, 0);
+
+	/* a wider unmap drops the maps, but may cover older mappings */
+	xe_bind_queue_map(q, 1, 0, 0x100000, SZ_PAGE, 0);
+	xe_bind_queue_map(q, 2, 0, 0x102000, SZ_PAGE, 0);
+	xe_bind_queue_unmap(q, 0x100000, 4 * SZ_PAGE);
+
+	/* a partial unmap drops nothing */
+	xe_bind_queue_map(q, 3, 0, 0x200000, 2 * SZ_PAGE, 0);
+	xe_bind_queue_unmap(q, 0x200000, SZ_PAGE);
+
+	igt_assert_eq(xe_bind_queue_flush(q, 0, 0), 3);
+	b = &mock.binds[0];
+	assert_op(&b->ops[0], DRM_XE_VM_BIND_OP_UNMAP, 0, 0, 0x100000, 4 * SZ_PAGE);
+	assert_op(&b->ops[1], DRM_XE_VM_BIND_OP_MAP, 3, 0, 0x200000, 2 * SZ_PAGE);
+	assert_op(&b->ops[2], DRM_XE_VM_BIND_OP_UNMAP, 0, 0, 0x200000, SZ_PAGE);
+	igt_assert_eq(q->stats.cancelled, 5);
+
+	/* a map flushed already is not cancelled */
+	xe_bind_queue_unmap(q, 0x200000, 2 * SZ_PAGE);
+	igt_assert_eq(xe_bind_queue_flush(q, 0, 0), 1);
+
+	xe_bind_queue_destroy(q);
+}
+
+static void test_flush(void)
+{
+	struct xe_bind_queue *q;
+	struct xe_object objs[1000];
+	struct igt_list_head list;
+
+	q = mock_create();
+
+	/* thousands of small buffers, in a single bind */
+	IGT_INIT_LIST_HEAD(&list);
+	for (int i = 0; i < ARRAY_SIZE(objs); i++) {
+		objs[i].handle = i + 1;
+		objs[i].offset = 0x100000 + i * SZ_PAGE;
+		objs[i].size = 256;
+		objs[i].pat_index = DEFAULT_PAT_INDEX;
+		objs[i].bind_op = XE_OBJECT_BIND;
+		igt_list_add_tail(&objs[i].link, &list);
+	}
+	xe_bind_queue_objects(q, &list);
+	igt_assert_eq(xe_bind_queue_flush(q, 5, 6), ARRAY_SIZE(objs));
+	igt_assert_eq(mock.num_binds, 1);
+	igt_assert_eq(mock.binds[0].sync_in, 5);
+	igt_assert_eq(mock.binds[0].sync_out, 6);
+	for (int i = 0; i < ARRAY_SIZE(objs); i++) {
+		assert_op(&mock.binds[0].ops[i], DRM_XE_VM_BIND_OP_MAP, i + 1, 0,
+			  0x100000 + i * SZ_PAGE, SZ_PAGE);
+		igt_assert_eq(mock.binds[0].ops[i].pat_index, DEFAULT_PAT_INDEX);
+	}
+
+	/* and their unbind in a single operation */
+	for (int i = 0; i < ARRAY_SIZE(objs); i++)
+		objs[i].bind_op = XE_OBJECT_UNBIND;
+	xe_bind_queue_objects(q, &list);
+	igt_assert_eq(xe_bind_queue_flush(q, 0, 7), 1);
+	assert_op(&mock.binds[1].ops[0], DRM_XE_VM_BIND_OP_UNMAP, 0, 0, 0x100000,
+		  ARRAY_SIZE(objs) * SZ_PAGE);
+
+	/* the out-fence is signaled even with nothing to bind */
+	igt_assert_eq(xe_bind_queue_flush(q, 0, 8), 0);
+	igt_assert_eq(mock.num_binds, 3);
+	igt_assert_eq(mock.binds[2].num_ops, 0);
+	igt_assert_eq(mock.binds[2].sync_out, 8);
+	igt_assert_eq(xe_bind_queue_flush(q, 0, 0), 0);
+	igt_assert_eq(mock.num_binds, 3);
+
+	igt_assert_eq(q->stats.flushes, 3);
+	igt_assert_eq(q->stats.submitted, ARRAY_SIZE(objs) + 1);
+
+	xe_bind_queue_destroy(q);
+}
+
+#define PAGES 64
+
+struct page {
+	uint32_t handle;	/* 0 if unmapped */
+	uint64_t obj_offset;
+	uint8_t pat_index;
+	uint32_t region;
+};
+
+static void apply(struct page *vm, const struct drm_xe_vm_bind_op *op)
+{
+	for (uint64_t off = 0; off < op->range; off += SZ_PAGE) {
+		struct page *p = &vm[(op->addr + off) / SZ_PAGE];
+
+		switch (op->op) {
+		case DRM_XE_VM_BIND_OP_MAP:
+			p->handle = op->obj;
+			p->obj_offset = op->obj_offset + off;
+			p->pat_index = op->pat_index;
+			p->region = 0;
+			break;
+		case DRM_XE_VM_BIND_OP_UNMAP:
+			memset(p, 0, sizeof(*p));
+			break;
+		case DRM_XE_VM_BIND_OP_PREFETCH:
+			if (p->handle)
+				p->region = op->prefetch_mem_region_instance;
+			break;
+		}
+	}
+}
+
+static bool unmapped(const struct page *vm, uint64_t first, uint64_t count)
+{
+	for (uint64_t i = first; i < first + count; i++)
+		if (vm[i].handle)
+			return false;
+
+	return true;
+}
+
+/*
+ * Random sequences of operations end in the same address space whether
+ * applied one by one or merged by the queue.
+ */
+static void test_random(void)
+{
+	struct page expected[PAGES], vm[PAGES];
+	struct xe_bind_queue *q;
+	uint32_t seed = 1;
+
+	q = mock_create();
+
+	for (int round = 0; round < 2000; round++) {
+		memset(expected, 0, sizeof(expected));
+		memset(vm, 0, sizeof(vm));
+		mock.num_binds = 0;
+
+		for (int i = 0; i < 64; i++) {
+			uint64_t first = hars_petruska_f54_1_random(&seed) % PAGES;
+			uint64_t count = 1 + hars_petruska_f54_1_random(&seed) % 4;
+			struct drm_xe_vm_bind_op op = {
+				.addr = first * SZ_PAGE,
+				.range = count * SZ_PAGE,
+			};
+
+			if (first + count > PAGES)
+				continue;
+
+			switch (hars_petruska_f54_1_random(&seed) % 3) {
+			case 0:
+				/* maps only target unmapped space */
+				if (!unmapped(expected, first, count))
+					continue;
+				op.op = DRM_XE_VM_BIND_OP_MAP;
+				op.obj = 1 + hars_petruska_f54_1_random(&seed) % 2;
+				op.obj_offset = hars_petruska_f54_1_random(&seed) % 2 ?
+					op.addr : 0;
+				op.pat_index = hars_petruska_f54_1_random(&seed) % 2;
+				xe_bind_queue_map(q, op.obj, op.obj_offset, op.addr,
+						  op.range, op.pat_index);
+				break;
+			case 1:
+				op.op = DRM_XE_VM_BIND_OP_UNMAP;
+				xe_bind_queue_unmap(q, op.addr, op.range);
+				break;
+			case 2:
+				op.op = DRM_XE_VM_BIND_OP_PREFETCH;
+				op.prefetch_mem_region_instance = 1 +
+					hars_petruska_f54_1_random(&seed) % 2;
+				xe_bind_queue_prefetch(q, op.addr, op.range,
+						       op.prefetch_mem_region_instance);
+				break;
+			}
+			apply(expected, &op);
+
+			if (hars_petruska_f54_1_random(&seed) % 32 == 0)
+				xe_bind_queue_flush(q, 0, 1);
+		}
+		xe_bind_queue_flush(q, 0, 1);
+
+		for (int i = 0; i < mock.num_binds; i++)
+			for (int j = 0; j < mock.binds[i].num_ops; j++)
+				apply(vm, &mock.binds[i].ops[j]);
+
+		igt_assert_f(!memcmp(expected, vm, sizeof(vm)),
+			     "Round %d diverged\n", round);
+	}
+
+	igt_info("queued %" PRIu64 ", merged %" PRIu64 ", cancelled %" PRIu64
+		 ", submitted %" PRIu64 "\n", q->stats.queued, q->stats.merged,
+		 q->stats.cancelled, q->stats.submitted);
+	igt_assert(q->stats.merged);
+	igt_assert(q->stats.cancelled);
+	igt_assert_lt(q->stats.submitted, q->stats.queued);
+
+	xe_bind_queue_destroy(q);
+}
+
+igt_main
+{
+	igt_describe("Adjacent and overlapping operations are merged");
+	igt_subtest("merge")
+		test_merge();
+
+	igt_describe("Merging keeps operations on the same range ordered");
+	igt_subtest("order")
+		test_order();
+
+	igt_describe("Maps unmapped before the flush are dropped");
+	igt_subtest("cancel")
+		test_cancel();
+
+	igt_describe("Each flush is a single bind with its fences");
+	igt_subtest("flush")
+		test_flush();
+
+	igt_describe("Merged operations give the same address space");
+	igt_subtest("random")
+		test_random();
+}
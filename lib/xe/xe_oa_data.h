@@ -34,6 +34,9 @@ enum intel_xe_perf_record_type {
 	/* intel_xe_perf_record_timestamp_correlation */
 	INTEL_XE_PERF_RECORD_TYPE_TIMESTAMP_CORRELATION,
 
+	/* intel_xe_perf_record_marker */
+	INTEL_XE_PERF_RECORD_TYPE_MARKER,
+
 	INTEL_XE_PERF_RECORD_MAX /* non-ABI */
 };
 
@@ -94,6 +97,34 @@ struct intel_xe_perf_record_timestamp_correlation {
 	uint64_t gpu_timestamp;
 } __attribute__((packed));
 
+enum intel_xe_perf_marker_type {
+	INTEL_XE_PERF_MARKER_LABEL = 0,
+	INTEL_XE_PERF_MARKER_BEGIN,
+	INTEL_XE_PERF_MARKER_END,
+};
+
+#define INTEL_XE_PERF_MARKER_LABEL_SIZE (64)
+
+/* User annotation (phase begin/end or a plain label), timestamped
+ * by the recorder when it receives it and written inline with the OA
+ * reports.
+ */
+struct intel_xe_perf_record_marker {
+	/* In the correlation clock */
+	uint64_t cpu_timestamp;
+
+	/* Engine timestamp associated with the OA unit */
+	uint64_t gpu_timestamp;
+
+	/* enum intel_xe_perf_marker_type */
+	uint32_t type;
+
+	uint32_t pad;
+
+	/* NUL terminated */
+	char label[INTEL_XE_PERF_MARKER_LABEL_SIZE];
+} __attribute__((packed));
+
 #ifdef __cplusplus
 };
 #endif
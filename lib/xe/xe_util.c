@@ -166,37 +166,17 @@ static struct drm_xe_vm_bind_op *xe_alloc_bind_ops(int xe,
 	return bind_ops;
 }
 
-/**
- * xe_bind_unbind_async:
- * @xe: drm fd of Xe device
- * @vm: vm to bind/unbind objects to/from
- * @bind_engine: bind engine, 0 if default
- * @obj_list: list of xe_object
- * @sync_in: sync object (fence-in), 0 if there's no input dependency
- * @sync_out: sync object (fence-out) to signal on bind/unbind completion,
- *            if 0 wait for bind/unbind completion.
- *
- * Function iterates over xe_object @obj_list, prepares binding operation
- * and does bind/unbind in one step. Providing sync_in / sync_out allows
- * working in pipelined mode. With sync_in and sync_out set to 0 function
- * waits until binding operation is complete.
- */
-void xe_bind_unbind_async(int xe, uint32_t vm, uint32_t bind_engine,
-			  struct igt_list_head *obj_list,
+static void __xe_bind_ops(int xe, uint32_t vm, uint32_t bind_engine,
+			  struct drm_xe_vm_bind_op *bind_ops, uint32_t num_binds,
 			  uint32_t sync_in, uint32_t sync_out)
 {
-	struct drm_xe_vm_bind_op *bind_ops;
 	struct drm_xe_sync tabsyncs[2] = {
 		{ .type = DRM_XE_SYNC_TYPE_SYNCOBJ, .handle = sync_in },
 		{ .type = DRM_XE_SYNC_TYPE_SYNCOBJ, .flags = DRM_XE_SYNC_FLAG_SIGNAL, .handle = sync_out },
 	};
 	struct drm_xe_sync *syncs;
-	uint32_t num_binds = 0;
 	int num_syncs;
 
-	bind_info("[Binding to vm: %u]\n", vm);
-	bind_ops = xe_alloc_bind_ops(xe, obj_list, &num_binds);
-
 	if (!num_binds) {
 		if (sync_out)
 			syncobj_signal(xe, &sync_out, 1);
@@ -218,32 +198,383 @@ void xe_bind_unbind_async(int xe, uint32_t vm, uint32_t bind_engine,
 	bind_info("[Binding syncobjs: (in: %u, out: %u)]\n",
 		  tabsyncs[0].handle, tabsyncs[1].handle);
 
-	if (num_binds == 1) {
-		if ((bind_ops[0].op & 0xffff) == DRM_XE_VM_BIND_OP_MAP)
-			igt_assert_eq(__xe_vm_bind(xe, vm, bind_engine, bind_ops[0].obj,
-						   0, bind_ops[0].addr, bind_ops[0].range,
-						   DRM_XE_VM_BIND_OP_MAP, 0,
-						   syncs, num_syncs, 0,
-						   bind_ops[0].pat_index, 0), 0);
-		else
-			igt_assert_eq(__xe_vm_bind(xe, vm, bind_engine, 0,
-						   0, bind_ops[0].addr, bind_ops[0].range,
-						   DRM_XE_VM_BIND_OP_UNMAP, 0,
-						   syncs, num_syncs, 0,
-						   bind_ops[0].pat_index, 0), 0);
-	} else {
+	if (num_binds == 1)
+		igt_assert_eq(__xe_vm_bind(xe, vm, bind_engine, bind_ops[0].obj,
+					   bind_ops[0].obj_offset, bind_ops[0].addr,
+					   bind_ops[0].range, bind_ops[0].op,
+					   bind_ops[0].flags, syncs, num_syncs,
+					   bind_ops[0].prefetch_mem_region_instance,
+					   bind_ops[0].pat_index, 0), 0);
+	else
 		xe_vm_bind_array(xe, vm, bind_engine, bind_ops,
 				 num_binds, syncs, num_syncs);
-	}
 
 	if (!sync_out) {
 		igt_assert_eq(syncobj_wait_err(xe, &tabsyncs[1].handle, 1, INT64_MAX, 0), 0);
 		syncobj_destroy(xe, tabsyncs[1].handle);
 	}
+}
+
+/**
+ * xe_bind_unbind_async:
+ * @xe: drm fd of Xe device
+ * @vm: vm to bind/unbind objects to/from
+ * @bind_engine: bind engine, 0 if default
+ * @obj_list: list of xe_object
+ * @sync_in: sync object (fence-in), 0 if there's no input dependency
+ * @sync_out: sync object (fence-out) to signal on bind/unbind completion,
+ *            if 0 wait for bind/unbind completion.
+ *
+ * Function iterates over xe_object @obj_list, prepares binding operation
+ * and does bind/unbind in one step. Providing sync_in / sync_out allows
+ * working in pipelined mode. With sync_in and sync_out set to 0 function
+ * waits until binding operation is complete.
+ */
+void xe_bind_unbind_async(int xe, uint32_t vm, uint32_t bind_engine,
+			  struct igt_list_head *obj_list,
+			  uint32_t sync_in, uint32_t sync_out)
+{
+	struct drm_xe_vm_bind_op *bind_ops;
+	uint32_t num_binds = 0;
+
+	bind_info("[Binding to vm: %u]\n", vm);
+	bind_ops = xe_alloc_bind_ops(xe, obj_list, &num_binds);
+
+	__xe_bind_ops(xe, vm, bind_engine, bind_ops, num_binds,
+		      sync_in, sync_out);
 
 	free(bind_ops);
 }
 
+static bool bind_overlaps(const struct drm_xe_vm_bind_op *a,
+			  const struct drm_xe_vm_bind_op *b)
+{
+	return a->addr < b->addr + b->range && b->addr < a->addr + a->range;
+}
+
+static bool bind_contains(const struct drm_xe_vm_bind_op *outer,
+			  const struct drm_xe_vm_bind_op *inner)
+{
+	return outer->addr <= inner->addr &&
+		inner->addr + inner->range <= outer->addr + outer->range;
+}
+
+/*
+ * Whether @op can grow @prev into a single operation: same kind, ranges
+ * overlapping or adjacent, and for maps the same object mapped at the same
+ * delta with the same PAT index.
+ */
+static bool bind_mergeable(const struct drm_xe_vm_bind_op *prev,
+			   const struct drm_xe_vm_bind_op *op)
+{
+	if (prev->op != op->op || prev->flags != op->flags ||
+	    op->addr > prev->addr + prev->range ||
+	    prev->addr > op->addr + op->range)
+		return false;
+
+	switch (op->op) {
+	case DRM_XE_VM_BIND_OP_MAP:
+		return prev->obj == op->obj && prev->pat_index == op->pat_index &&
+			prev->addr - prev->obj_offset == op->addr - op->obj_offset;
+	case DRM_XE_VM_BIND_OP_PREFETCH:
+		return prev->prefetch_mem_region_instance ==
+			op->prefetch_mem_region_instance;
+	default:
+		return true;
+	}
+}
+
+/*
+ * Drops the pending maps and prefetches the unmap @op covers. A map is
+ * expected to target unmapped space, as the allocators hand it out, so a
+ * map followed by the unmap of exactly its range cancels out completely.
+ *
+ * Returns: true if @op itself is cancelled.
+ */
+static bool bind_queue_cancel(struct xe_bind_queue *q,
+			      const struct drm_xe_vm_bind_op *op)
+{
+	for (int i = igt_vec_length(&q->pending) - 1; i >= 0; i--) {
+		struct drm_xe_vm_bind_op *prev = igt_vec_elem(&q->pending, i);
+		bool exact;
+
+		if (!bind_overlaps(prev, op))
+			continue;
+
+		/* anything else has to stay ordered before the unmap */
+		if (prev->op == DRM_XE_VM_BIND_OP_UNMAP ||
+		    !bind_contains(op, prev))
+			break;
+
+		exact = prev->op == DRM_XE_VM_BIND_OP_MAP &&
+			prev->addr == op->addr && prev->range == op->range;
+
+		bind_debug("bind queue: cancelled op %u at %llx\n", prev->op,
+			   (long long)prev->addr);
+		igt_vec_remove(&q->pending, i);
+		q->stats.cancelled++;
+
+		if (exact) {
+			q->stats.cancelled++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void bind_queue_push(struct xe_bind_queue *q,
+			    const struct drm_xe_vm_bind_op *op)
+{
+	struct drm_xe_vm_bind_op *prev, *cur;
+	int i;
+
+	q->stats.queued++;
+
+	if (op->op == DRM_XE_VM_BIND_OP_UNMAP && bind_queue_cancel(q, op))
+		return;
+
+	igt_vec_push(&q->pending, (void *)op);
+	i = igt_vec_length(&q->pending) - 1;
+
+	/*
+	 * Merging moves an operation before the ones queued after the one it
+	 * is merged into, so none of those may touch its range. The merged
+	 * range may in turn touch an older operation, so go on from there.
+	 */
+	for (int j = i - 1; j >= 0; j--) {
+		uint64_t start, end;
+
+		prev = igt_vec_elem(&q->pending, j);
+		cur = igt_vec_elem(&q->pending, i);
+
+		if (bind_mergeable(prev, cur)) {
+			start = min_t(uint64_t, prev->addr, cur->addr);
+			end = max_t(uint64_t, prev->addr + prev->range,
+				    cur->addr + cur->range);
+
+			if (prev->op == DRM_XE_VM_BIND_OP_MAP)
+				prev->obj_offset -= prev->addr - start;
+			prev->addr = start;
+			prev->range = end - start;
+
+			igt_vec_remove(&q->pending, i);
+			q->stats.merged++;
+			i = j;
+			continue;
+		}
+
+		if (bind_overlaps(prev, cur))
+			break;
+	}
+}
+
+static void xe_bind_queue_bind(struct xe_bind_queue *q,
+			       struct drm_xe_vm_bind_op *ops, uint32_t num_ops,
+			       uint32_t sync_in, uint32_t sync_out)
+{
+	for (uint32_t i = 0; i < num_ops; i++)
+		if (ops[i].pat_index == DEFAULT_PAT_INDEX)
+			ops[i].pat_index = intel_get_pat_idx_wb(q->fd);
+
+	__xe_bind_ops(q->fd, q->vm, q->bind_engine, ops, num_ops,
+		      sync_in, sync_out);
+}
+
+static const struct xe_bind_queue_ops bind_queue_ops = {
+	.bind = xe_bind_queue_bind,
+};
+
+/**
+ * __xe_bind_queue_create:
+ * @ops: backend submitting the merged operations
+ * @priv: backend private data
+ *
+ * Creates a bind queue submitting through @ops, which allows checking the
+ * merging of the operations without a device. xe_bind_queue_create() should
+ * be used otherwise.
+ *
+ * Returns: the new bind queue.
+ */
+struct xe_bind_queue *__xe_bind_queue_create(const struct xe_bind_queue_ops *ops,
+					     void *priv)
+{
+	struct xe_bind_queue *q;
+
+	q = calloc(1, sizeof(*q));
+	igt_assert(q);
+
+	q->fd = -1;
+	q->ops = ops;
+	q->priv = priv;
+	igt_vec_init(&q->pending, sizeof(struct drm_xe_vm_bind_op));
+
+	return q;
+}
+
+/**
+ * xe_bind_queue_create:
+ * @xe: drm fd of Xe device
+ * @vm: vm to bind/unbind objects to/from
+ * @bind_engine: bind engine, 0 if default
+ *
+ * Creates a queue accumulating bind, unbind and prefetch operations on @vm
+ * until xe_bind_queue_flush(), so that many small operations turn into a
+ * single array bind with a single out-fence. While queued, operations on
+ * adjacent or overlapping ranges are merged, and a map unmapped before the
+ * flush is dropped altogether.
+ *
+ * Returns: the new bind queue.
+ */
+struct xe_bind_queue *xe_bind_queue_create(int xe, uint32_t vm,
+					   uint32_t bind_engine)
+{
+	struct xe_bind_queue *q = __xe_bind_queue_create(&bind_queue_ops, NULL);
+
+	q->fd = xe;
+	q->vm = vm;
+	q->bind_engine = bind_engine;
+
+	return q;
+}
+
+/**
+ * xe_bind_queue_destroy:
+ * @q: bind queue
+ *
+ * Flushes the pending operations, waiting for their completion, and frees
+ * @q.
+ */
+void xe_bind_queue_destroy(struct xe_bind_queue *q)
+{
+	xe_bind_queue_flush(q, 0, 0);
+	igt_vec_fini(&q->pending);
+	free(q);
+}
+
+/**
+ * xe_bind_queue_map:
+ * @q: bind queue
+ * @handle: object to map
+ * @obj_offset: offset in the object
+ * @addr: address to map at
+ * @size: size of the mapping, rounded up to 4KiB
+ * @pat_index: PAT index, or DEFAULT_PAT_INDEX
+ *
+ * Queues the mapping of @handle at @addr, which is expected to be unmapped.
+ */
+void xe_bind_queue_map(struct xe_bind_queue *q, uint32_t handle,
+		       uint64_t obj_offset, uint64_t addr, uint64_t size,
+		       uint8_t pat_index)
+{
+	struct drm_xe_vm_bind_op op = {
+		.op = DRM_XE_VM_BIND_OP_MAP,
+		.obj = handle,
+		.obj_offset = obj_offset,
+		.addr = addr,
+		.range = ALIGN(size, 4096),
+		.pat_index = pat_index,
+	};
+
+	bind_queue_push(q, &op);
+}
+
+/**
+ * xe_bind_queue_unmap:
+ * @q: bind queue
+ * @addr: start of the range
+ * @size: size of the range, rounded up to 4KiB
+ *
+ * Queues the unmapping of [@addr, @addr + @size).
+ */
+void xe_bind_queue_unmap(struct xe_bind_queue *q, uint64_t addr, uint64_t size)
+{
+	struct drm_xe_vm_bind_op op = {
+		.op = DRM_XE_VM_BIND_OP_UNMAP,
+		.addr = addr,
+		.range = ALIGN(size, 4096),
+		.pat_index = DEFAULT_PAT_INDEX,
+	};
+
+	bind_queue_push(q, &op);
+}
+
+/**
+ * xe_bind_queue_prefetch:
+ * @q: bind queue
+ * @addr: start of the range
+ * @size: size of the range, rounded up to 4KiB
+ * @region: memory region instance to prefetch to
+ *
+ * Queues the prefetch of [@addr, @addr + @size) to @region.
+ */
+void xe_bind_queue_prefetch(struct xe_bind_queue *q, uint64_t addr,
+			    uint64_t size, uint32_t region)
+{
+	struct drm_xe_vm_bind_op op = {
+		.op = DRM_XE_VM_BIND_OP_PREFETCH,
+		.addr = addr,
+		.range = ALIGN(size, 4096),
+		.prefetch_mem_region_instance = region,
+		.pat_index = DEFAULT_PAT_INDEX,
+	};
+
+	bind_queue_push(q, &op);
+}
+
+/**
+ * xe_bind_queue_objects:
+ * @q: bind queue
+ * @obj_list: list of xe_object
+ *
+ * Queues the bind or unbind of each object of @obj_list, as
+ * xe_bind_unbind_async() would submit them.
+ */
+void xe_bind_queue_objects(struct xe_bind_queue *q,
+			   struct igt_list_head *obj_list)
+{
+	struct xe_object *obj;
+
+	igt_list_for_each_entry(obj, obj_list, link) {
+		if (obj->bind_op == XE_OBJECT_BIND)
+			xe_bind_queue_map(q, obj->handle, 0, obj->offset,
+					  obj->size, obj->pat_index);
+		else
+			xe_bind_queue_unmap(q, obj->offset, obj->size);
+	}
+}
+
+/**
+ * xe_bind_queue_flush:
+ * @q: bind queue
+ * @sync_in: sync object (fence-in), 0 if there's no input dependency
+ * @sync_out: sync object (fence-out) to signal on completion, if 0 wait for
+ *            completion
+ *
+ * Submits the pending operations of @q in a single bind, in the order they
+ * were queued. With nothing pending, @sync_out is still signaled.
+ *
+ * Returns: the number of operations submitted.
+ */
+int xe_bind_queue_flush(struct xe_bind_queue *q, uint32_t sync_in,
+			uint32_t sync_out)
+{
+	int num_ops = igt_vec_length(&q->pending);
+
+	if (!num_ops && !sync_out)
+		return 0;
+
+	q->ops->bind(q, num_ops ? igt_vec_elem(&q->pending, 0) : NULL,
+		     num_ops, sync_in, sync_out);
+
+	q->stats.flushes++;
+	q->stats.submitted += num_ops;
+	igt_vec_fini(&q->pending);
+	igt_vec_init(&q->pending, sizeof(struct drm_xe_vm_bind_op));
+
+	return num_ops;
+}
+
 static uint32_t reference_clock(int fd, int gt_id)
 {
 	struct xe_device *dev = xe_device_get(fd);
@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include <xe_drm.h>
 
+#include "igt_vec.h"
 #include "xe_query.h"
 
 #define XE_IS_SYSMEM_MEMORY_REGION(fd, region) \
@@ -47,6 +48,49 @@ void xe_bind_unbind_async(int fd, uint32_t vm, uint32_t bind_engine,
 			  struct igt_list_head *obj_list,
 			  uint32_t sync_in, uint32_t sync_out);
 
+struct xe_bind_queue;
+
+struct xe_bind_queue_ops {
+	void (*bind)(struct xe_bind_queue *q, struct drm_xe_vm_bind_op *ops,
+		     uint32_t num_ops, uint32_t sync_in, uint32_t sync_out);
+};
+
+struct xe_bind_queue {
+	int fd;
+	uint32_t vm;
+	uint32_t bind_engine;
+
+	const struct xe_bind_queue_ops *ops;
+	void *priv;
+
+	/* struct drm_xe_vm_bind_op, in submission order */
+	struct igt_vec pending;
+
+	struct {
+		uint64_t queued;
+		uint64_t merged;
+		uint64_t cancelled;
+		uint64_t flushes;
+		uint64_t submitted;
+	} stats;
+};
+
+struct xe_bind_queue *__xe_bind_queue_create(const struct xe_bind_queue_ops *ops,
+					     void *priv);
+struct xe_bind_queue *xe_bind_queue_create(int xe, uint32_t vm,
+					   uint32_t bind_engine);
+void xe_bind_queue_destroy(struct xe_bind_queue *q);
+void xe_bind_queue_map(struct xe_bind_queue *q, uint32_t handle,
+		       uint64_t obj_offset, uint64_t addr, uint64_t size,
+		       uint8_t pat_index);
+void xe_bind_queue_unmap(struct xe_bind_queue *q, uint64_t addr, uint64_t size);
+void xe_bind_queue_prefetch(struct xe_bind_queue *q, uint64_t addr,
+			    uint64_t size, uint32_t region);
+void xe_bind_queue_objects(struct xe_bind_queue *q,
+			   struct igt_list_head *obj_list);
+int xe_bind_queue_flush(struct xe_bind_queue *q, uint32_t sync_in,
+			uint32_t sync_out);
+
 uint32_t xe_nsec_to_ticks(int fd, int gt_id, uint64_t ns);
 
 void xe_fast_copy(int fd,
@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <json.h>
+
+#include "bisect.h"
+#include "executor.h"
+#include "resultgen.h"
+
+static const char * const failures[] = {
+	"fail",
+	"dmesg-fail",
+	"dmesg-warn",
+	"crash",
+	"timeout",
+	"incomplete",
+	"abort",
+	NULL,
+};
+
+/*
+ * Zeller's ddmin: try each of n chunks alone, then each complement,
+ * doubling the granularity when neither reproduces, until every single
+ * unit has been tried for removal.
+ */
+size_t bisect_minimize(size_t *units, size_t count,
+		       bisect_reproduces_t reproduces, void *data)
+{
+	size_t *complement;
+	size_t n = 2;
+
+	if (!count || reproduces(units, 0, data))
+		return 0;
+
+	complement = malloc(count * sizeof(*complement));
+
+	while (count >= 2) {
+		bool reduced = false;
+		size_t i;
+
+		for (i = 0; i < n; i++) {
+			size_t start = i * count / n, end = (i + 1) * count / n;
+
+			if (reproduces(units + start, end - start, data)) {
+				memmove(units, units + start,
+					(end - start) * sizeof(*units));
+				count = end - start;
+				n = 2;
+				reduced = true;
+				break;
+			}
+		}
+
+		/* with 2 chunks, the complements are the chunks */
+		for (i = 0; !reduced && n > 2 && i < n; i++) {
+			size_t start = i * count / n, end = (i + 1) * count / n;
+			size_t len = count - (end - start);
+
+			memcpy(complement, units, start * sizeof(*units));
+			memcpy(complement + start, units + end,
+			       (count - end) * sizeof(*units));
+
+			if (reproduces(complement, len, data)) {
+				memcpy(units, complement, len * sizeof(*units));
+				count = len;
+				n = n - 1 > 2 ? n - 1 : 2;
+				reduced = true;
+			}
+		}
+
+		if (reduced)
+			continue;
+
+		if (n >= count)
+			break;
+
+		n = 2 * n < count ? 2 * n : count;
+	}
+
+	free(complement);
+	return count;
+}
+
+static bool is_failure(const char *result)
+{
+	for (int i = 0; failures[i]; i++)
+		if (!strcmp(result, failures[i]))
+			return true;
+
+	return false;
+}
+
+static const char *get_result(struct json_object *results, const char *test)
+{
+	struct json_object *tests, *obj;
+
+	if (!json_object_object_get_ex(results, "tests", &tests) ||
+	    !json_object_object_get_ex(tests, test, &obj) ||
+	    !json_object_object_get_ex(obj, "result", &obj))
+		return NULL;
+
+	return json_object_get_string(obj);
+}
+
+/* The test results in execution order, so the first failure is the cause */
+static bool find_failure(struct bisect *bisect, struct json_object *results,
+			 const char *test)
+{
+	struct json_object *tests;
+
+	if (test) {
+		const char *result = get_result(results, test);
+
+		if (!result) {
+			fprintf(stderr, "bisect: No result for %s\n", test);
+			return false;
+		}
+
+		bisect->test = strdup(test);
+		bisect->result = strdup(result);
+		return true;
+	}
+
+	if (!json_object_object_get_ex(results, "tests", &tests))
+		return false;
+
+	json_object_object_foreach(tests, name, obj) {
+		struct json_object *result;
+
+		if (!json_object_object_get_ex(obj, "result", &result) ||
+		    !is_failure(json_object_get_string(result)))
+			continue;
+
+		bisect->test = strdup(name);
+		bisect->result = strdup(json_object_get_string(result));
+		return true;
+	}
+
+	fprintf(stderr, "bisect: No failure in the results\n");
+	return false;
+}
+
+static void add_unit(struct job_list *list, const char *binary,
+		     const char *subtest)
+{
+	struct job_list_entry *entry;
+
+	list->entries = realloc(list->entries,
+				(list->size + 1) * sizeof(*list->entries));
+	entry = &list->entries[list->size++];
+
+	entry->binary = strdup(binary);
+	entry->subtests = NULL;
+	entry->subtest_count = 0;
+	if (subtest) {
+		entry->subtests = malloc(sizeof(*entry->subtests));
+		entry->subtests[0] = strdup(subtest);
+		entry->subtest_count = 1;
+	}
+}
+
+/*
+ * One unit per subtest, for the finest granularity. Subtests already
+ * excluded by a resume don't run, so don't matter.
+ */
+static void split_units(struct job_list *units, const struct job_list *list)
+{
+	for (size_t i = 0; i < list->size; i++) {
+		const struct job_list_entry *entry = &list->entries[i];
+
+		if (!entry->subtest_count)
+			add_unit(units, entry->binary, NULL);
+
+		for (size_t k = 0; k < entry->subtest_count; k++)
+			if (entry->subtests[k][0] != '!')
+				add_unit(units, entry->binary,
+					 entry->subtests[k]);
+	}
+}
+
+/* The unit running the test, or one of its dynamic subtests */
+static bool unit_runs(const struct job_list_entry *unit, const char *test)
+{
+	char name[PATH_MAX];
+	size_t len;
+
+	generate_piglit_name(unit->binary,
+			     unit->subtest_count ? unit->subtests[0] : NULL,
+			     name, sizeof(name));
+	len = strlen(name);
+
+	return !strncmp(test, name, len) &&
+		(test[len] == '\0' || test[len] == '@');
+}
+
+bool bisect_init(struct bisect *bisect, int resultsdirfd,
+		 const char *test, const char *workdir)
+{
+	struct json_object *results;
+	struct job_list list;
+	bool found;
+
+	memset(bisect, 0, sizeof(*bisect));
+	init_settings(&bisect->settings);
+	init_job_list(&bisect->units);
+	init_job_list(&list);
+
+	if (!read_settings_from_dir(&bisect->settings, resultsdirfd) ||
+	    !read_job_list(&list, resultsdirfd)) {
+		fprintf(stderr, "bisect: Cannot read the settings and job list\n");
+		return false;
+	}
+
+	split_units(&bisect->units, &list);
+	free_job_list(&list);
+
+	results = generate_results_json(resultsdirfd);
+	if (!results)
+		return false;
+
+	found = find_failure(bisect, results, test);
+	json_object_put(results);
+	if (!found)
+		return false;
+
+	for (bisect->target = 0; bisect->target < bisect->units.size; bisect->target++)
+		if (unit_runs(&bisect->units.entries[bisect->target], bisect->test))
+			break;
+
+	if (bisect->target == bisect->units.size) {
+		fprintf(stderr, "bisect: %s is not in the job list\n", bisect->test);
+		return false;
+	}
+
+	bisect->workdir = absolute_path(workdir);
+	if (mkdir(bisect->workdir, 0755) && errno != EEXIST) {
+		fprintf(stderr, "bisect: Cannot create %s: %s\n",
+			bisect->workdir, strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+void bisect_fini(struct bisect *bisect)
+{
+	clear_settings(&bisect->settings);
+	free_job_list(&bisect->units);
+	free(bisect->test);
+	free(bisect->result);
+	free(bisect->workdir);
+}
+
+bool bisect_run(struct bisect *bisect, const size_t *units, size_t count,
+		const char *name, bool *reproduced)
+{
+	struct settings *settings = &bisect->settings;
+	struct execute_state state;
+	struct json_object *results;
+	struct job_list list;
+	const char *result;
+	char path[PATH_MAX];
+	int dirfd;
+
+	init_job_list(&list);
+	for (size_t i = 0; i <= count; i++) {
+		const struct job_list_entry *unit =
+			&bisect->units.entries[i < count ? units[i] : bisect->target];
+
+		add_unit(&list, unit->binary,
+			 unit->subtest_count ? unit->subtests[0] : NULL);
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", bisect->workdir, name);
+	free(settings->results_path);
+	settings->results_path = strdup(path);
+	settings->overwrite = true;
+	settings->dry_run = false;
+
+	bisect->runs++;
+	if (!initialize_execute_state(&state, settings, &list)) {
+		free_job_list(&list);
+		return false;
+	}
+
+	/* an abort still leaves results for what ran */
+	execute(&state, settings, &list);
+	free_job_list(&list);
+
+	if ((dirfd = open(path, O_DIRECTORY | O_RDONLY)) < 0)
+		return false;
+
+	results = generate_results_json(dirfd);
+	close(dirfd);
+	if (!results)
+		return false;
+
+	result = get_result(results, bisect->test);
+	*reproduced = result && !strcmp(result, bisect->result);
+	json_object_put(results);
+
+	return true;
+}
+
+bool bisect_reproduces(const size_t *units, size_t count, void *data)
+{
+	struct bisect *bisect = data;
+	bool reproduced = false;
+
+	/* out of budget, stop reducing */
+	if (bisect->max_runs && bisect->runs >= bisect->max_runs)
+		return false;
+
+	if (!bisect_run(bisect, units, count, BISECT_CANDIDATE_DIRNAME,
+			&reproduced))
+		fprintf(stderr, "bisect: Running a candidate failed\n");
+
+	if (bisect->settings.log_level >= LOG_LEVEL_NORMAL)
+		printf("bisect: run %zu, %zu tests before %s: %s\n",
+		       bisect->runs, count, bisect->test,
+		       reproduced ? "reproduced" : "passed");
+
+	return reproduced;
+}
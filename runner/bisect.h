@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: MIT
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef RUNNER_BISECT_H
+#define RUNNER_BISECT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "job_list.h"
+#include "settings.h"
+
+/*
+ * Returns whether running the given units, in that order, before the
+ * failing one reproduces the failure.
+ */
+typedef bool (*bisect_reproduces_t)(const size_t *units, size_t count,
+				    void *data);
+
+/*
+ * Delta debugging: reduces the units to a 1-minimal subsequence that
+ * still reproduces the failure, i.e. from which no unit can be removed
+ * without losing it. The units are kept in their order, and the
+ * reproducer is expected to reproduce with all of them.
+ *
+ * Returns the number of units left at the start of the array.
+ */
+size_t bisect_minimize(size_t *units, size_t count,
+		       bisect_reproduces_t reproduces, void *data);
+
+struct bisect {
+	struct settings settings;
+	/* The job list of the results, one entry per subtest */
+	struct job_list units;
+	/* The unit of the failure */
+	size_t target;
+	/* Piglit name and result of the failure */
+	char *test;
+	char *result;
+	char *workdir;
+	size_t runs;
+	size_t max_runs;
+};
+
+/*
+ * Reads the settings and job list of a results directory, and finds
+ * the failure to reproduce: test, or the first failing test when NULL.
+ * The candidates will be run in workdir.
+ */
+bool bisect_init(struct bisect *bisect, int resultsdirfd,
+		 const char *test, const char *workdir);
+void bisect_fini(struct bisect *bisect);
+
+/* A bisect_reproduces_t running the candidates with the executor */
+bool bisect_reproduces(const size_t *units, size_t count, void *data);
+
+/*
+ * Runs the units followed by the failing one in workdir/name, keeping
+ * its results and job list.
+ */
+bool bisect_run(struct bisect *bisect, const size_t *units, size_t count,
+		const char *name, bool *reproduced);
+
+#define BISECT_CANDIDATE_DIRNAME "candidate"
+#define BISECT_MINIMAL_DIRNAME "minimal"
+
+#endif /* RUNNER_BISECT_H */
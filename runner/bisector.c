@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "bisect.h"
+#include "resultgen.h"
+
+static void usage(const char *name, FILE *f)
+{
+	fprintf(f, "Usage: %s [options] results-directory work-directory\n\n"
+		"Searches the job list of the results for the minimal sequence\n"
+		"of tests preceding a failure that still reproduces it. The\n"
+		"candidates are run in work-directory/" BISECT_CANDIDATE_DIRNAME ", the minimal\n"
+		"sequence is run again in work-directory/" BISECT_MINIMAL_DIRNAME ", which keeps\n"
+		"its job list and results.\n\n"
+		"Options:\n"
+		"  -t, --test <name>     Failure to reproduce, e.g. igt@foo@bar\n"
+		"                        (default: the first failure)\n"
+		"  -n, --max-runs <n>    Stop reducing after n runs\n"
+		"  -h, --help            Show this help\n",
+		name);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option long_options[] = {
+		{ "test", required_argument, NULL, 't' },
+		{ "max-runs", required_argument, NULL, 'n' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 },
+	};
+	struct bisect bisect;
+	const char *test = NULL;
+	size_t max_runs = 0;
+	size_t *units, count;
+	bool reproduced = false;
+	int dirfd, c;
+
+	while ((c = getopt_long(argc, argv, "t:n:h", long_options, NULL)) != -1) {
+		switch (c) {
+		case 't':
+			test = optarg;
+			break;
+		case 'n':
+			max_runs = strtoul(optarg, NULL, 0);
+			break;
+		case 'h':
+			usage(argv[0], stdout);
+			return 0;
+		default:
+			usage(argv[0], stderr);
+			return 1;
+		}
+	}
+
+	if (argc - optind != 2) {
+		usage(argv[0], stderr);
+		return 1;
+	}
+
+	if ((dirfd = open(argv[optind], O_RDONLY | O_DIRECTORY)) < 0) {
+		fprintf(stderr, "Failure opening %s: %s\n", argv[optind], strerror(errno));
+		return 127;
+	}
+
+	if (!bisect_init(&bisect, dirfd, test, argv[optind + 1])) {
+		fprintf(stderr, "bisect failed at initialization step\n");
+		return 127;
+	}
+	close(dirfd);
+	bisect.max_runs = max_runs;
+
+	printf("Reproducing %s (%s) after %zu tests\n",
+	       bisect.test, bisect.result, bisect.target);
+
+	units = malloc(bisect.target * sizeof(*units));
+	for (count = 0; count < bisect.target; count++)
+		units[count] = count;
+
+	if (!bisect_reproduces(units, count, &bisect)) {
+		fprintf(stderr, "%s doesn't reproduce with the full job list\n",
+			bisect.test);
+		free(units);
+		bisect_fini(&bisect);
+		return 1;
+	}
+
+	count = bisect_minimize(units, count, bisect_reproduces, &bisect);
+
+	if (!bisect_run(&bisect, units, count, BISECT_MINIMAL_DIRNAME,
+			&reproduced) || !reproduced) {
+		fprintf(stderr, "The minimal job list doesn't reproduce %s anymore\n",
+			bisect.test);
+		free(units);
+		bisect_fini(&bisect);
+		return 1;
+	}
+
+	generate_results_path(bisect.settings.results_path);
+
+	printf("Minimal job list after %zu runs, in %s:\n",
+	       bisect.runs, bisect.settings.results_path);
+	for (size_t i = 0; i <= count; i++) {
+		const struct job_list_entry *unit =
+			&bisect.units.entries[i < count ? units[i] : bisect.target];
+
+		printf("  %s%s%s\n", unit->binary,
+		       unit->subtest_count ? " " : "",
+		       unit->subtest_count ? unit->subtests[0] : "");
+	}
+
+	free(units);
+	bisect_fini(&bisect);
+
+	return 0;
+}
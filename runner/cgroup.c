@@ -0,0 +1,424 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cgroup.h"
+
+/*
+ * Each test can be run in its own leaf of a cgroup v2 subtree delegated to
+ * the runner. Writing to cgroup.kill of the leaf kills everything the test
+ * started, including the processes that left its process group, and
+ * cgroup.events notifies when the last of them is gone. The cpu, memory
+ * and io controllers of the leaf account what the test used and can limit
+ * it.
+ */
+
+#define CPU_MAX_PERIOD_US 100000
+
+static bool write_str(int dirfd, const char *name, const char *str)
+{
+	ssize_t len = strlen(str);
+	bool ret;
+	int fd;
+
+	fd = openat(dirfd, name, O_WRONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	ret = write(fd, str, len) == len;
+	close(fd);
+
+	return ret;
+}
+
+static ssize_t read_str(int dirfd, const char *name, char *buf, size_t size)
+{
+	ssize_t len;
+	int fd;
+
+	fd = openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	len = read(fd, buf, size - 1);
+	close(fd);
+
+	if (len >= 0)
+		buf[len] = '\0';
+
+	return len;
+}
+
+/* Value of @key in a flat keyed file like cpu.stat or memory.events */
+static bool find_key(const char *buf, const char *key, uint64_t *val)
+{
+	size_t keylen = strlen(key);
+	const char *line = buf;
+
+	while (line && *line) {
+		if (!strncmp(line, key, keylen) && line[keylen] == ' ')
+			return sscanf(line + keylen, "%" SCNu64, val) == 1;
+
+		line = strchr(line, '\n');
+		if (line)
+			line++;
+	}
+
+	return false;
+}
+
+static bool controller_enabled(const char *controllers, const char *name)
+{
+	size_t len = strlen(name);
+	const char *s = controllers;
+
+	while ((s = strstr(s, name))) {
+		if ((s == controllers || s[-1] == ' ') &&
+		    (s[len] == ' ' || s[len] == '\n' || !s[len]))
+			return true;
+		s += len;
+	}
+
+	return false;
+}
+
+/**
+ * runner_cgroup_init: Prepares the root of the test cgroups.
+ * @root: path to a cgroup v2 directory delegated to the runner
+ * @memory_max: memory limit of the tests in bytes, 0 for no limit
+ * @cpu_max: CPU limit of the tests in percent of a CPU, 0 for no limit
+ *
+ * Enables the cpu, memory and io controllers for the children of @root, as
+ * far as they are available. The runner itself must not be in @root, a
+ * cgroup with processes can't distribute controllers to its children.
+ *
+ * Returns: a directory fd of @root, or -1 if it can't be used or doesn't
+ * provide the controllers needed by the limits.
+ */
+int runner_cgroup_init(const char *root, size_t memory_max, int cpu_max)
+{
+	static const char * const controllers[] = { "cpu", "memory", "io" };
+	char buf[256], enable[16];
+	bool changed = false;
+	int rootfd;
+
+	rootfd = open(root, O_DIRECTORY | O_RDONLY | O_CLOEXEC);
+	if (rootfd < 0)
+		return -1;
+
+	if (read_str(rootfd, "cgroup.subtree_control", buf, sizeof(buf)) < 0)
+		goto err;
+
+	for (int i = 0; i < sizeof(controllers) / sizeof(controllers[0]); i++) {
+		if (controller_enabled(buf, controllers[i]))
+			continue;
+
+		snprintf(enable, sizeof(enable), "+%s", controllers[i]);
+		changed |= write_str(rootfd, "cgroup.subtree_control", enable);
+	}
+
+	if (changed &&
+	    read_str(rootfd, "cgroup.subtree_control", buf, sizeof(buf)) < 0)
+		goto err;
+
+	if ((memory_max && !controller_enabled(buf, "memory")) ||
+	    (cpu_max && !controller_enabled(buf, "cpu")))
+		goto err;
+
+	return rootfd;
+
+err:
+	close(rootfd);
+	return -1;
+}
+
+/**
+ * runner_cgroup_create: Creates the cgroup of a test.
+ * @rootfd: directory fd from runner_cgroup_init()
+ * @name: name of the cgroup in @rootfd
+ * @memory_max: memory limit in bytes, 0 for no limit
+ * @cpu_max: CPU limit in percent of a CPU, 0 for no limit
+ *
+ * An already existing cgroup is reused, it may have been left behind by an
+ * earlier run that was interrupted.
+ *
+ * Returns: a directory fd of the cgroup, or -1 on failure.
+ */
+int runner_cgroup_create(int rootfd, const char *name,
+			 size_t memory_max, int cpu_max)
+{
+	char buf[64];
+	int fd;
+
+	if (mkdirat(rootfd, name, 0755) && errno != EEXIST)
+		return -1;
+
+	fd = openat(rootfd, name, O_DIRECTORY | O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	if (memory_max) {
+		snprintf(buf, sizeof(buf), "%zu", memory_max);
+		if (!write_str(fd, "memory.max", buf))
+			goto err;
+
+		/* Don't leave a test half killed by the OOM killer */
+		write_str(fd, "memory.oom.group", "1");
+	}
+
+	if (cpu_max) {
+		snprintf(buf, sizeof(buf), "%d %d",
+			 cpu_max * (CPU_MAX_PERIOD_US / 100), CPU_MAX_PERIOD_US);
+		if (!write_str(fd, "cpu.max", buf))
+			goto err;
+	}
+
+	return fd;
+
+err:
+	close(fd);
+	unlinkat(rootfd, name, AT_REMOVEDIR);
+	return -1;
+}
+
+/**
+ * runner_cgroup_join: Moves the calling process into a cgroup.
+ * @cgroupfd: directory fd from runner_cgroup_create()
+ *
+ * Meant to be called by the test process between fork() and exec(), so
+ * that everything the test starts is accounted to the cgroup.
+ */
+bool runner_cgroup_join(int cgroupfd)
+{
+	return write_str(cgroupfd, "cgroup.procs", "0");
+}
+
+/**
+ * runner_cgroup_kill: Kills all processes in a cgroup.
+ * @cgroupfd: directory fd from runner_cgroup_create()
+ *
+ * Kernels without cgroup.kill get a SIGKILL sent to each process listed in
+ * the cgroup instead, which misses the processes forked meanwhile.
+ */
+bool runner_cgroup_kill(int cgroupfd)
+{
+	char *line = NULL;
+	size_t len = 0;
+	bool ret = false;
+	FILE *f;
+	int fd;
+
+	if (write_str(cgroupfd, "cgroup.kill", "1"))
+		return true;
+
+	fd = openat(cgroupfd, "cgroup.procs", O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	f = fdopen(fd, "r");
+	if (!f) {
+		close(fd);
+		return false;
+	}
+
+	ret = true;
+	while (getline(&line, &len, f) > 0) {
+		pid_t pid = atoi(line);
+
+		if (pid > 0 && kill(pid, SIGKILL) && errno != ESRCH)
+			ret = false;
+	}
+
+	free(line);
+	fclose(f);
+
+	return ret;
+}
+
+static int elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1000 +
+		(now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/**
+ * runner_cgroup_wait_empty: Waits for a cgroup to have no processes.
+ * @cgroupfd: directory fd from runner_cgroup_create()
+ * @timeout_ms: how long to wait at most
+ *
+ * Sleeps until cgroup.events reports the cgroup unpopulated, the kernel
+ * signals every change of the file with POLLPRI.
+ *
+ * Returns: true once the cgroup is empty, false on timeout or error.
+ */
+bool runner_cgroup_wait_empty(int cgroupfd, int timeout_ms)
+{
+	struct pollfd pfd = { .events = POLLPRI };
+	struct timespec start;
+	uint64_t populated;
+	bool ret = false;
+	char buf[256];
+
+	pfd.fd = openat(cgroupfd, "cgroup.events", O_RDONLY | O_CLOEXEC);
+	if (pfd.fd < 0)
+		return false;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (;;) {
+		ssize_t len;
+		int left;
+
+		len = pread(pfd.fd, buf, sizeof(buf) - 1, 0);
+		if (len < 0)
+			break;
+		buf[len] = '\0';
+
+		if (!find_key(buf, "populated", &populated))
+			break;
+
+		if (!populated) {
+			ret = true;
+			break;
+		}
+
+		left = timeout_ms - elapsed_ms(&start);
+		if (left <= 0)
+			break;
+
+		if (poll(&pfd, 1, left) < 0 && errno != EINTR)
+			break;
+	}
+
+	close(pfd.fd);
+
+	return ret;
+}
+
+static void save_keys(int cgroupfd, const char *name, const char *prefix,
+		      const char * const *keys, FILE *out)
+{
+	char buf[4096];
+	uint64_t val;
+
+	if (read_str(cgroupfd, name, buf, sizeof(buf)) < 0)
+		return;
+
+	for (; *keys; keys++)
+		if (find_key(buf, *keys, &val))
+			fprintf(out, "%s%s : %" PRIu64 "\n", prefix, *keys, val);
+}
+
+/* io.stat has a line of key=value pairs per device, sum them up */
+static void save_io_stat(int cgroupfd, FILE *out)
+{
+	static const char * const keys[] = { "rbytes", "wbytes", "rios", "wios" };
+	const int num_keys = sizeof(keys) / sizeof(keys[0]);
+	uint64_t sums[sizeof(keys) / sizeof(keys[0])] = {};
+	char buf[4096], *tok, *saveptr;
+	bool found = false;
+
+	if (read_str(cgroupfd, "io.stat", buf, sizeof(buf)) < 0)
+		return;
+
+	for (tok = strtok_r(buf, " \n", &saveptr); tok;
+	     tok = strtok_r(NULL, " \n", &saveptr)) {
+		char *eq = strchr(tok, '=');
+
+		if (!eq)
+			continue;
+
+		*eq = '\0';
+		for (int i = 0; i < num_keys; i++) {
+			if (!strcmp(tok, keys[i])) {
+				sums[i] += strtoull(eq + 1, NULL, 10);
+				found = true;
+			}
+		}
+	}
+
+	/* An empty io.stat means no io at all */
+	if (!found && buf[0])
+		return;
+
+	for (int i = 0; i < num_keys; i++)
+		fprintf(out, "io_%s : %" PRIu64 "\n", keys[i], sums[i]);
+}
+
+/**
+ * runner_cgroup_save_stats: Saves what the processes of a cgroup used.
+ * @cgroupfd: directory fd from runner_cgroup_create()
+ * @dirfd: directory fd of the test results
+ * @sync: whether to fsync the results
+ *
+ * Writes the CPU time from cpu.stat, the memory high watermark from
+ * memory.peak, the OOM kills from memory.events and the io from io.stat,
+ * summed over the devices, to #CGROUP_RESFILENAME in @dirfd. Statistics of
+ * controllers not enabled for the cgroup are left out.
+ */
+bool runner_cgroup_save_stats(int cgroupfd, int dirfd, bool sync)
+{
+	static const char * const cpu_keys[] = {
+		"usage_usec", "user_usec", "system_usec", NULL
+	};
+	static const char * const memory_events_keys[] = { "oom_kill", NULL };
+	char buf[64];
+	uint64_t peak;
+	FILE *out;
+	int fd;
+
+	fd = openat(dirfd, CGROUP_RESFILENAME,
+		    O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0666);
+	if (fd < 0)
+		return false;
+
+	out = fdopen(fd, "w");
+	if (!out) {
+		close(fd);
+		return false;
+	}
+
+	save_keys(cgroupfd, "cpu.stat", "cpu_", cpu_keys, out);
+
+	if (read_str(cgroupfd, "memory.peak", buf, sizeof(buf)) > 0 &&
+	    sscanf(buf, "%" SCNu64, &peak) == 1)
+		fprintf(out, "memory_peak : %" PRIu64 "\n", peak);
+
+	save_keys(cgroupfd, "memory.events", "memory_", memory_events_keys, out);
+	save_io_stat(cgroupfd, out);
+
+	fflush(out);
+	if (sync)
+		fsync(fd);
+	fclose(out);
+
+	return true;
+}
+
+/**
+ * runner_cgroup_remove: Removes the cgroup of a test.
+ * @rootfd: directory fd from runner_cgroup_init()
+ * @name: name of the cgroup in @rootfd
+ *
+ * The cgroup must be empty.
+ */
+bool runner_cgroup_remove(int rootfd, const char *name)
+{
+	return !unlinkat(rootfd, name, AT_REMOVEDIR) || errno == ENOENT;
+}
@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: MIT
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef RUNNER_CGROUP_H
+#define RUNNER_CGROUP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+int runner_cgroup_init(const char *root, size_t memory_max, int cpu_max);
+int runner_cgroup_create(int rootfd, const char *name,
+			 size_t memory_max, int cpu_max);
+bool runner_cgroup_join(int cgroupfd);
+bool runner_cgroup_kill(int cgroupfd);
+bool runner_cgroup_wait_empty(int cgroupfd, int timeout_ms);
+bool runner_cgroup_save_stats(int cgroupfd, int dirfd, bool sync);
+bool runner_cgroup_remove(int rootfd, const char *name);
+
+#define CGROUP_RESFILENAME "cgroup.txt"
+
+#endif /* RUNNER_CGROUP_H */
@@ -37,7 +37,9 @@
 #include "igt_facts.h"
 #include "igt_taints.h"
 #include "igt_vec.h"
+#include "cgroup.h"
 #include "executor.h"
+#include "gpu_usage.h"
 #include "kmemleak.h"
 #include "output_strings.h"
 #include "runnercomms.h"
@@ -45,6 +47,7 @@
 #define KMSG_HEADER "[IGT] "
 #define KMSG_WARN 4
 #define GRACEFUL_EXITCODE -SIGHUP
+#define CGROUP_KILL_TIMEOUT_MS 5000
 
 static struct {
 	int *fds;
@@ -734,12 +737,15 @@ static long dump_dmesg(int kmsgfd, int outfd, ssize_t size)
 	}
 }
 
-static bool kill_child(int sig, pid_t child)
+static bool kill_child(int sig, pid_t child, int cgroupfd)
 {
 	/*
 	 * Send the signal to the child directly, and to the child's
-	 * process group.
+	 * process group. A SIGKILL also goes to everything in the
+	 * test's cgroup, which catches what left the process group.
 	 */
+	if (sig == SIGKILL && cgroupfd >= 0)
+		runner_cgroup_kill(cgroupfd);
 	kill(-child, sig);
 	if (kill(child, sig) && errno == ESRCH) {
 		errf("Child process does not exist. This shouldn't happen.\n");
@@ -956,7 +962,8 @@ static size_t calc_last_dmesg_chunk(size_t limit, size_t disk_usage)
  */
 static int monitor_output(pid_t child,
 			  int outfd, int errfd, int socketfd,
-			  int kmsgfd, int sigfd,
+			  int kmsgfd, int sigfd, int cgroupfd,
+			  struct runner_gpu_usage *gpu,
 			  int *outputs,
 			  double *time_spent,
 			  struct settings *settings,
@@ -1049,6 +1056,7 @@ static int monitor_output(pid_t child,
 		}
 
 		runner_gettime(&time_now);
+		runner_gpu_usage_tick(gpu);
 
 		/* TODO: Refactor these handlers to their own functions */
 		if (outfd >= 0 && FD_ISSET(outfd, &set)) {
@@ -1250,6 +1258,7 @@ static int monitor_output(pid_t child,
 					}
 				}
 
+				runner_gpu_usage_packet(gpu, packet);
 				write_packet_with_canary(outputs[_F_SOCKET], packet, settings->sync);
 				disk_usage += packet->size;
 
@@ -1394,7 +1403,7 @@ static int monitor_output(pid_t child,
 
 				aborting = true;
 				killed = SIGQUIT;
-				if (!kill_child(killed, child)) {
+				if (!kill_child(killed, child, cgroupfd)) {
 					errf("Error terminating child with %s, errno=%d\n",
 					     killed == SIGQUIT ? "SIGQUIT" : "SIGKILL", errno);
 
@@ -1573,7 +1582,7 @@ static int monitor_output(pid_t child,
 			}
 
 			killed = next_kill_signal(killed);
-			if (!kill_child(killed, child)) {
+			if (!kill_child(killed, child, cgroupfd)) {
 				errf("Error at terminating test with %s, errno=%d\n",
 				     killed == SIGQUIT ? "SIGQUIT" : "SIGKILL", errno);
 				killed = -1;
@@ -1616,7 +1625,7 @@ static int monitor_output(pid_t child,
 }
 
 static void __attribute__((noreturn))
-execute_test_process(int outfd, int errfd, int socketfd,
+execute_test_process(int outfd, int errfd, int socketfd, int cgroupfd,
 		     struct settings *settings,
 		     struct job_list_entry *entry)
 {
@@ -1629,6 +1638,11 @@ execute_test_process(int outfd, int errfd, int socketfd,
 
 	setpgid(0, 0);
 
+	if (cgroupfd >= 0 && !runner_cgroup_join(cgroupfd)) {
+		fprintf(stderr, "Cannot move the test to its cgroup: %m\n");
+		exit(IGT_EXIT_INVALID);
+	}
+
 	igt_vec_init(&arg_vec, sizeof(char *));
 
 	rootlen = strlen(settings->test_root);
@@ -1756,6 +1770,25 @@ static char *entry_display_name(struct job_list_entry *entry)
 	return ret;
 }
 
+/*
+ * Whatever the test left running goes down with its cgroup, so that
+ * the statistics cover everything the test started and the next test
+ * doesn't share the machine with leftovers.
+ */
+static void finish_test_cgroup(int rootfd, int cgroupfd, const char *name,
+			       int dirfd, struct settings *settings)
+{
+	if (!runner_cgroup_kill(cgroupfd) ||
+	    !runner_cgroup_wait_empty(cgroupfd, CGROUP_KILL_TIMEOUT_MS))
+		errf("Warning: Processes left in cgroup %s\n", name);
+
+	if (!runner_cgroup_save_stats(cgroupfd, dirfd, settings->sync))
+		errf("Warning: Cannot save the statistics of cgroup %s\n", name);
+
+	if (!runner_cgroup_remove(rootfd, name))
+		errf("Warning: Cannot remove cgroup %s: %m\n", name);
+}
+
 /*
  * Returns:
  *  =0 - Success
@@ -1767,7 +1800,7 @@ static int execute_next_entry(struct execute_state *state,
 			      double *time_spent,
 			      struct settings *settings,
 			      struct job_list_entry *entry,
-			      int testdirfd, int resdirfd,
+			      int testdirfd, int resdirfd, int cgrouprootfd,
 			      int sigfd, sigset_t *sigmask,
 			      char **abortreason,
 			      bool *abort_already_written)
@@ -1779,7 +1812,9 @@ static int execute_next_entry(struct execute_state *state,
 	int errpipe[2] = { -1, -1 };
 	int socket[2] = { -1, -1 };
 	int outfd, errfd, socketfd;
-	char name[32];
+	int cgroupfd = -1;
+	char name[32], cgroupname[64];
+	struct runner_gpu_usage *gpu = NULL;
 	pid_t child;
 	int result;
 	size_t idx = state->next;
@@ -1814,6 +1849,19 @@ static int execute_next_entry(struct execute_state *state,
 		goto out_pipe;
 	}
 
+	if (cgrouprootfd >= 0) {
+		snprintf(cgroupname, sizeof(cgroupname), "igt_runner.%d.%zd",
+			 getpid(), idx);
+		cgroupfd = runner_cgroup_create(cgrouprootfd, cgroupname,
+						settings->cgroup_memory_max,
+						settings->cgroup_cpu_max);
+		if (cgroupfd < 0) {
+			errf("Error creating cgroup %s: %m\n", cgroupname);
+			result = -1;
+			goto out_pipe;
+		}
+	}
+
 	if ((kmsgfd = open("/dev/kmsg", O_RDONLY | O_CLOEXEC | O_NONBLOCK)) < 0) {
 		errf("Warning: Cannot open /dev/kmsg\n");
 	} else {
@@ -1871,7 +1919,8 @@ static int execute_next_entry(struct execute_state *state,
 		}
 		setenv("IGT_SENTINEL_ON_STDERR", "1", 1);
 
-		execute_test_process(outfd, errfd, socketfd, settings, entry);
+		execute_test_process(outfd, errfd, socketfd, cgroupfd,
+				     settings, entry);
 		/* unreachable */
 	}
 
@@ -1883,13 +1932,28 @@ static int execute_next_entry(struct execute_state *state,
 	close(socket[1]);
 	outpipe[1] = errpipe[1] = socket[1] = -1;
 
+	/* The fds of the test are not held, it gets to release its contexts */
+	if (settings->gpu_usage) {
+		gpu = runner_gpu_usage_start(NULL, getpid(), dirfd,
+					     settings->sync);
+		if (!gpu)
+			errf("Warning: Cannot track the GPU usage of the test\n");
+	}
+
 	result = monitor_output(child, outfd, errfd, socketfd,
-				kmsgfd, sigfd,
+				kmsgfd, sigfd, cgroupfd, gpu,
 				outputs, time_spent, settings,
 				abortreason, abort_already_written);
 
+	runner_gpu_usage_finish(gpu);
+
 out_kmsgfd:
 	close(kmsgfd);
+	if (cgroupfd >= 0) {
+		finish_test_cgroup(cgrouprootfd, cgroupfd, cgroupname,
+				   dirfd, settings);
+		close(cgroupfd);
+	}
 out_pipe:
 	close(outpipe[0]);
 	close(outpipe[1]);
@@ -1960,6 +2024,18 @@ static bool clear_test_result_directory(int dirfd)
 		}
 	}
 
+	if (remove_file(dirfd, CGROUP_RESFILENAME)) {
+		errf("Error deleting %s from test result directory: %m\n",
+		     CGROUP_RESFILENAME);
+		return false;
+	}
+
+	if (remove_file(dirfd, GPU_USAGE_RESFILENAME)) {
+		errf("Error deleting %s from test result directory: %m\n",
+		     GPU_USAGE_RESFILENAME);
+		return false;
+	}
+
 	return true;
 }
 
@@ -2419,6 +2495,7 @@ bool execute(struct execute_state *state,
 	     struct job_list *job_list)
 {
 	int resdirfd, testdirfd, unamefd, timefd, sigfd;
+	int cgrouprootfd = -1;
 	struct environment_variable *env_var;
 	struct utsname unamebuf;
 	sigset_t sigmask;
@@ -2533,6 +2610,18 @@ bool execute(struct execute_state *state,
 	}
 	close(unamefd);
 
+	if (settings->cgroup_root) {
+		cgrouprootfd = runner_cgroup_init(settings->cgroup_root,
+						  settings->cgroup_memory_max,
+						  settings->cgroup_cpu_max);
+		if (cgrouprootfd < 0) {
+			errf("Error: Cannot use %s for the test cgroups\n",
+			     settings->cgroup_root);
+			status = false;
+			goto end;
+		}
+	}
+
 	/* Check if we're already in abort-state at bootup */
 	{
 		char *reason;
@@ -2597,7 +2686,7 @@ bool execute(struct execute_state *state,
 						    &time_spent,
 						    settings,
 						    &job_list->entries[state->next],
-						    testdirfd, resdirfd,
+						    testdirfd, resdirfd, cgrouprootfd,
 						    sigfd, &sigmask,
 						    &reason, &already_written);
 
@@ -2663,6 +2752,7 @@ bool execute(struct execute_state *state,
 			}
 			close(sigfd);
 			close(testdirfd);
+			close(cgrouprootfd);
 			if (!initialize_execute_state_from_resume(resdirfd, state, settings, job_list))
 				return false;
 			state->time_left = time_left;
@@ -2704,6 +2794,7 @@ bool execute(struct execute_state *state,
  end_post_signal_restore:
 	close(sigfd);
 	close(testdirfd);
+	close(cgrouprootfd);
 	close(resdirfd);
 	return status;
 }
@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "igt_drm_usage.h"
+#include "gpu_usage.h"
+
+/*
+ * GPU time and memory of a test, attributed to its subtests and dynamic
+ * subtests. The DRM fdinfo of the processes under the runner is sampled
+ * when the test reports a subtest boundary over the comms socket, and at
+ * most once per SAMPLE_INTERVAL_NS in between to catch memory peaks, so
+ * the cost doesn't depend on how much output the test produces. Boundaries
+ * less than GPU_USAGE_BOUNDARY_INTERVAL_NS after the previous sample reuse
+ * it, so that tests with thousands of short dynamic subtests don't walk
+ * the processes thousands of times, at the cost of charging what ran since
+ * that sample to the next scope.
+ *
+ * Each subtest, each dynamic subtest and a binary without subtests get
+ * lines like
+ *
+ *   engine <pdev> <engine class> <busy ns>[ <name>]
+ *   region <pdev> <memory region> <peak resident bytes>[ <name>]
+ *
+ * in GPU_USAGE_RESFILENAME, where <name> is the subtest name, or the
+ * subtest and dynamic subtest names joined with '@', and is left out for
+ * the binary itself.
+ */
+
+#define SAMPLE_INTERVAL_NS 1000000000ull
+
+enum {
+	SCOPE_SUBTEST,
+	SCOPE_DYNAMIC,
+	NUM_SCOPES,
+};
+
+struct scope {
+	bool open;
+	char *name;
+	/* busy time when the scope was opened */
+	igt_drm_usage_engine_t *engines;
+	int num_engines;
+	/* highest sampled resident memory, in peak_resident */
+	igt_drm_usage_region_t *regions;
+	int num_regions;
+};
+
+struct runner_gpu_usage {
+	igt_drm_usage_t *usage;
+	FILE *out;
+	bool sync;
+	uint64_t last_ns;
+	struct scope scopes[NUM_SCOPES];
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void update_peaks(struct scope *scope,
+			 const igt_drm_usage_region_t *regions, int count)
+{
+	for (int i = 0; i < count; i++) {
+		igt_drm_usage_region_t *r = NULL;
+
+		for (int n = 0; n < scope->num_regions; n++) {
+			if (!strcmp(scope->regions[n].pdev, regions[i].pdev) &&
+			    !strcmp(scope->regions[n].name, regions[i].name)) {
+				r = &scope->regions[n];
+				break;
+			}
+		}
+
+		if (!r) {
+			scope->regions = realloc(scope->regions,
+						 (scope->num_regions + 1) * sizeof(*r));
+			r = &scope->regions[scope->num_regions++];
+			*r = regions[i];
+			r->peak_resident = 0;
+		}
+
+		if (regions[i].resident > r->peak_resident)
+			r->peak_resident = regions[i].resident;
+	}
+}
+
+static void sample(struct runner_gpu_usage *gpu)
+{
+	igt_drm_usage_region_t *regions;
+	int count;
+
+	gpu->last_ns = now_ns();
+	igt_drm_usage_sample(gpu->usage, gpu->last_ns);
+
+	count = igt_drm_usage_regions(gpu->usage, &regions);
+	for (int i = 0; i < NUM_SCOPES; i++)
+		if (gpu->scopes[i].open)
+			update_peaks(&gpu->scopes[i], regions, count);
+	free(regions);
+}
+
+static void drop_scope(struct scope *scope)
+{
+	free(scope->name);
+	free(scope->engines);
+	free(scope->regions);
+	memset(scope, 0, sizeof(*scope));
+}
+
+/* Must follow a sample */
+static void open_scope(struct runner_gpu_usage *gpu, int idx, const char *name)
+{
+	struct scope *scope = &gpu->scopes[idx];
+	igt_drm_usage_region_t *regions;
+	int count;
+
+	drop_scope(scope);
+	scope->open = true;
+	scope->name = name ? strdup(name) : NULL;
+	scope->num_engines = igt_drm_usage_engines(gpu->usage, &scope->engines);
+
+	count = igt_drm_usage_regions(gpu->usage, &regions);
+	update_peaks(scope, regions, count);
+	free(regions);
+}
+
+static uint64_t start_busy_ns(const struct scope *scope,
+			      const igt_drm_usage_engine_t *e)
+{
+	for (int i = 0; i < scope->num_engines; i++)
+		if (!strcmp(scope->engines[i].pdev, e->pdev) &&
+		    !strcmp(scope->engines[i].name, e->name))
+			return scope->engines[i].busy_ns;
+
+	return 0;
+}
+
+/* Must follow a sample */
+static void close_scope(struct runner_gpu_usage *gpu, int idx)
+{
+	struct scope *scope = &gpu->scopes[idx];
+	const char *sep = scope->name ? " " : "";
+	const char *name = scope->name ?: "";
+	igt_drm_usage_engine_t *engines;
+	int count;
+
+	if (!scope->open)
+		return;
+
+	count = igt_drm_usage_engines(gpu->usage, &engines);
+	for (int i = 0; i < count; i++) {
+		uint64_t start = start_busy_ns(scope, &engines[i]);
+		uint64_t busy = engines[i].busy_ns;
+
+		fprintf(gpu->out, "engine %s %s %" PRIu64 "%s%s\n",
+			engines[i].pdev[0] ? engines[i].pdev : "-",
+			engines[i].name, busy > start ? busy - start : 0,
+			sep, name);
+	}
+	free(engines);
+
+	for (int i = 0; i < scope->num_regions; i++)
+		fprintf(gpu->out, "region %s %s %" PRIu64 "%s%s\n",
+			scope->regions[i].pdev[0] ? scope->regions[i].pdev : "-",
+			scope->regions[i].name, scope->regions[i].peak_resident,
+			sep, name);
+
+	fflush(gpu->out);
+	if (gpu->sync)
+		fdatasync(fileno(gpu->out));
+
+	drop_scope(scope);
+}
+
+/**
+ * runner_gpu_usage_start: Starts tracking the GPU usage of a test.
+ * @procfs: path to a procfs, NULL for /proc
+ * @root: pid of the runner, the test is one of its children
+ * @dirfd: directory fd of the test results
+ * @sync: whether to sync the results after each subtest
+ *
+ * Returns: a tracker, or NULL if the processes can't be inspected.
+ */
+struct runner_gpu_usage *runner_gpu_usage_start(const char *procfs, pid_t root,
+						int dirfd, bool sync)
+{
+	struct runner_gpu_usage *gpu;
+	int fd;
+
+	gpu = calloc(1, sizeof(*gpu));
+	if (!gpu)
+		return NULL;
+
+	gpu->usage = igt_drm_usage_create(procfs, root, 0);
+	if (!gpu->usage)
+		goto err;
+
+	fd = openat(dirfd, GPU_USAGE_RESFILENAME,
+		    O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0666);
+	if (fd < 0)
+		goto err_usage;
+
+	gpu->out = fdopen(fd, "w");
+	if (!gpu->out) {
+		close(fd);
+		goto err_usage;
+	}
+
+	gpu->sync = sync;
+
+	/* until a subtest starts, the binary itself is the scope */
+	sample(gpu);
+	open_scope(gpu, SCOPE_SUBTEST, NULL);
+
+	return gpu;
+
+err_usage:
+	igt_drm_usage_destroy(gpu->usage);
+err:
+	free(gpu);
+	return NULL;
+}
+
+/**
+ * runner_gpu_usage_packet: Accounts a packet received from the test.
+ * @gpu: tracker, or NULL
+ * @packet: packet from the comms socket
+ *
+ * Subtest and dynamic subtest starts and results close the current
+ * scopes and open new ones, other packets are ignored.
+ */
+void runner_gpu_usage_packet(struct runner_gpu_usage *gpu,
+			     const struct runnerpacket *packet)
+{
+	struct scope *subtest;
+	runnerpacket_read_helper helper;
+	char *name;
+
+	if (!gpu)
+		return;
+
+	switch (packet->type) {
+	case PACKETTYPE_SUBTEST_START:
+	case PACKETTYPE_SUBTEST_RESULT:
+	case PACKETTYPE_DYNAMIC_SUBTEST_START:
+	case PACKETTYPE_DYNAMIC_SUBTEST_RESULT:
+		break;
+	default:
+		return;
+	}
+
+	helper = read_runnerpacket(packet);
+	subtest = &gpu->scopes[SCOPE_SUBTEST];
+
+	if (now_ns() - gpu->last_ns >= GPU_USAGE_BOUNDARY_INTERVAL_NS)
+		sample(gpu);
+
+	switch (helper.type) {
+	case PACKETTYPE_SUBTEST_START:
+		close_scope(gpu, SCOPE_DYNAMIC);
+		/* a binary with subtests has no usage of its own */
+		if (subtest->open && !subtest->name)
+			drop_scope(subtest);
+		close_scope(gpu, SCOPE_SUBTEST);
+		if (helper.subteststart.name)
+			open_scope(gpu, SCOPE_SUBTEST, helper.subteststart.name);
+		break;
+	case PACKETTYPE_SUBTEST_RESULT:
+		close_scope(gpu, SCOPE_DYNAMIC);
+		close_scope(gpu, SCOPE_SUBTEST);
+		break;
+	case PACKETTYPE_DYNAMIC_SUBTEST_START:
+		close_scope(gpu, SCOPE_DYNAMIC);
+		if (!helper.dynamicsubteststart.name || !subtest->name)
+			break;
+		if (asprintf(&name, "%s@%s", subtest->name,
+			     helper.dynamicsubteststart.name) < 0)
+			break;
+		open_scope(gpu, SCOPE_DYNAMIC, name);
+		free(name);
+		break;
+	case PACKETTYPE_DYNAMIC_SUBTEST_RESULT:
+		close_scope(gpu, SCOPE_DYNAMIC);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * runner_gpu_usage_tick: Samples if enough time passed since the last one.
+ * @gpu: tracker, or NULL
+ *
+ * Meant to be called on every iteration of the test monitoring loop.
+ */
+void runner_gpu_usage_tick(struct runner_gpu_usage *gpu)
+{
+	if (gpu && now_ns() - gpu->last_ns >= SAMPLE_INTERVAL_NS)
+		sample(gpu);
+}
+
+/**
+ * runner_gpu_usage_finish: Stops tracking the GPU usage of a test.
+ * @gpu: tracker, or NULL
+ *
+ * Takes a last sample for the subtests still running, and frees @gpu.
+ */
+void runner_gpu_usage_finish(struct runner_gpu_usage *gpu)
+{
+	if (!gpu)
+		return;
+
+	sample(gpu);
+	close_scope(gpu, SCOPE_DYNAMIC);
+	close_scope(gpu, SCOPE_SUBTEST);
+
+	fclose(gpu->out);
+	igt_drm_usage_destroy(gpu->usage);
+	free(gpu);
+}
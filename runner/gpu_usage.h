@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: MIT
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef RUNNER_GPU_USAGE_H
+#define RUNNER_GPU_USAGE_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "runnercomms.h"
+
+struct runner_gpu_usage;
+
+struct runner_gpu_usage *runner_gpu_usage_start(const char *procfs, pid_t root,
+						int dirfd, bool sync);
+void runner_gpu_usage_packet(struct runner_gpu_usage *gpu,
+			     const struct runnerpacket *packet);
+void runner_gpu_usage_tick(struct runner_gpu_usage *gpu);
+void runner_gpu_usage_finish(struct runner_gpu_usage *gpu);
+
+#define GPU_USAGE_RESFILENAME "gpu_usage.txt"
+
+/* subtest boundaries closer than this share a sample */
+#define GPU_USAGE_BOUNDARY_INTERVAL_NS 10000000ull
+
+#endif /* RUNNER_GPU_USAGE_H */
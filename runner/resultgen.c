@@ -13,6 +13,8 @@
 
 #include "igt_aux.h"
 #include "igt_core.h"
+#include "cgroup.h"
+#include "gpu_usage.h"
 #include "runnercomms.h"
 #include "resultgen.h"
 #include "settings.h"
@@ -1156,6 +1158,132 @@ static bool fill_from_dmesg(int fd,
 	return true;
 }
 
+/*
+ * The cgroup covers the whole execution of the binary, in multiple mode
+ * all of its subtests get the same statistics.
+ */
+static void fill_from_cgroup(int dirfd, char *binary,
+			     struct subtest_list *subtests,
+			     struct json_object *tests)
+{
+	struct json_object *stats, *current_test;
+	char piglit_name[256];
+	char dynamic_piglit_name[256];
+	char *name = NULL;
+	uint64_t val;
+	size_t i, k;
+	FILE *f;
+	int fd;
+
+	if ((fd = openat(dirfd, CGROUP_RESFILENAME, O_RDONLY)) < 0)
+		return;
+
+	if ((f = fdopen(fd, "r")) == NULL) {
+		close(fd);
+		return;
+	}
+
+	stats = json_object_new_object();
+	while (fscanf(f, "%ms : %" SCNu64 "\n", &name, &val) == 2) {
+		json_object_object_add(stats, name, json_object_new_int64(val));
+		free(name);
+		name = NULL;
+	}
+	free(name);
+	fclose(f);
+
+	for (i = 0; i < subtests->size; i++) {
+		generate_piglit_name(binary, subtests->subs[i].name, piglit_name, sizeof(piglit_name));
+		current_test = get_or_create_json_object(tests, piglit_name);
+		json_object_object_add(current_test, "cgroup", json_object_get(stats));
+
+		for (k = 0; k < subtests->subs[i].dynamic_size; k++) {
+			generate_piglit_name_for_dynamic(piglit_name, subtests->subs[i].dynamic_names[k],
+							 dynamic_piglit_name, sizeof(dynamic_piglit_name));
+			current_test = get_or_create_json_object(tests, dynamic_piglit_name);
+			json_object_object_add(current_test, "cgroup", json_object_get(stats));
+		}
+	}
+
+	if (subtests->size == 0) {
+		generate_piglit_name(binary, NULL, piglit_name, sizeof(piglit_name));
+		current_test = get_or_create_json_object(tests, piglit_name);
+		json_object_object_add(current_test, "cgroup", json_object_get(stats));
+	}
+
+	json_object_put(stats);
+}
+
+/*
+ * Engine time and peak memory per device are recorded for each subtest
+ * and dynamic subtest, or for the binary when it has no subtests.
+ */
+static void fill_from_gpu_usage(int dirfd, char *binary,
+				struct json_object *tests)
+{
+	struct json_object *current_test, *usage;
+	char piglit_name[256];
+	char dynamic_piglit_name[256];
+	char *kind, *pdev, *key, *name, *dynamic;
+	char *line = NULL;
+	size_t linelen = 0;
+	uint64_t val;
+	FILE *f;
+	int fd, n;
+
+	if ((fd = openat(dirfd, GPU_USAGE_RESFILENAME, O_RDONLY)) < 0)
+		return;
+
+	if ((f = fdopen(fd, "r")) == NULL) {
+		close(fd);
+		return;
+	}
+
+	while (getline(&line, &linelen, f) > 0) {
+		name = NULL;
+		n = sscanf(line, "%ms %ms %ms %" SCNu64 " %ms",
+			   &kind, &pdev, &key, &val, &name);
+		if (n < 4) {
+			if (n >= 1)
+				free(kind);
+			if (n >= 2)
+				free(pdev);
+			if (n >= 3)
+				free(key);
+			continue;
+		}
+
+		dynamic = name ? strchr(name, '@') : NULL;
+		if (dynamic)
+			*dynamic++ = '\0';
+
+		generate_piglit_name(binary, name, piglit_name, sizeof(piglit_name));
+		if (dynamic) {
+			generate_piglit_name_for_dynamic(piglit_name, dynamic,
+							 dynamic_piglit_name,
+							 sizeof(dynamic_piglit_name));
+			current_test = get_or_create_json_object(tests, dynamic_piglit_name);
+		} else {
+			current_test = get_or_create_json_object(tests, piglit_name);
+		}
+
+		usage = get_or_create_json_object(current_test, "gpu-usage");
+		usage = get_or_create_json_object(usage, pdev);
+		usage = get_or_create_json_object(usage,
+						  !strcmp(kind, "engine") ?
+						  "engine-busy-ns" : "peak-resident");
+		json_object_object_add(usage, key, json_object_new_int64(val));
+
+		free(kind);
+		free(pdev);
+		free(key);
+		free(name);
+	}
+
+	free(line);
+	fclose(f);
+}
+
 static const char *result_from_exitcode(int exitcode)
 {
 	switch (exitcode) {
@@ -2241,6 +2369,9 @@ static bool parse_test_directory(int dirfd,
 		fprintf(stderr, "Error parsing output files (dmesg.txt)\n");
 	}
 
+	fill_from_cgroup(dirfd, entry->binary, &subtests, results->tests);
+	fill_from_gpu_usage(dirfd, entry->binary, results->tests);
+
 	override_results(entry->binary, &subtests, results->tests);
 	prune_subtests(settings, entry, &subtests, results->tests);
 
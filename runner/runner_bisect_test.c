@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "igt.h"
+
+#include "bisect.h"
+#include "executor.h"
+#include "job_list.h"
+#include "resultgen.h"
+#include "runner_tests_common.h"
+#include "settings.h"
+
+static const char testdatadir[] = TESTDATA_DIRECTORY;
+
+/* The failure needs all of these to run before it */
+struct culprits {
+	const size_t *needed;
+	size_t count;
+	size_t runs;
+};
+
+static bool synthetic_reproduces(const size_t *units, size_t count, void *data)
+{
+	struct culprits *c = data;
+
+	c->runs++;
+	for (size_t i = 0; i < c->count; i++) {
+		size_t k;
+
+		for (k = 0; k < count; k++)
+			if (units[k] == c->needed[i])
+				break;
+		if (k == count)
+			return false;
+	}
+
+	return true;
+}
+
+static void check_minimize(size_t n_units, const size_t *needed, size_t count)
+{
+	struct culprits c = { .needed = needed, .count = count };
+	size_t units[n_units], left;
+
+	for (size_t i = 0; i < n_units; i++)
+		units[i] = i;
+
+	left = bisect_minimize(units, n_units, synthetic_reproduces, &c);
+	igt_debug("%zu units left after %zu runs\n", left, c.runs);
+
+	igt_assert_eq(left, count);
+	for (size_t i = 0; i < count; i++)
+		igt_assert_eq(units[i], needed[i]);
+	igt_assert_lt(c.runs, n_units * n_units);
+}
+
+static void add_subtest(struct job_list *list, const char *binary,
+			const char *subtest)
+{
+	struct job_list_entry *entry;
+
+	list->entries = realloc(list->entries,
+				(list->size + 1) * sizeof(*list->entries));
+	entry = &list->entries[list->size++];
+	entry->binary = strdup(binary);
+	entry->subtests = malloc(sizeof(*entry->subtests));
+	entry->subtests[0] = strdup(subtest);
+	entry->subtest_count = 1;
+}
+
+/*
+ * A full run of the fake binary, where "victim" fails because of
+ * "poison" three subtests earlier, is reduced to just those two.
+ */
+static void test_victim(void)
+{
+	static const char * const subtests[] = {
+		"first", "second", "poison", "third", "victim", "last",
+	};
+	char dir[] = "/tmp/runner_bisect_test.XXXXXX";
+	char results[PATH_MAX], work[PATH_MAX], state[PATH_MAX];
+	const char *argv[] = { "runner", "--allow-non-root", "--quiet",
+			       testdatadir, results };
+	struct execute_state exec;
+	struct settings settings;
+	struct job_list list;
+	struct bisect bisect;
+	size_t units[4] = { 0, 1, 2, 3 }, count;
+	bool reproduced = false;
+	int dirfd;
+
+	scratch_create(dir);
+	snprintf(results, sizeof(results), "%s/results", dir);
+	snprintf(work, sizeof(work), "%s/work", dir);
+	snprintf(state, sizeof(state), "%s/poisoned", dir);
+	setenv("BISECT_VICTIM_STATE", state, 1);
+
+	init_settings(&settings);
+	init_job_list(&list);
+	igt_assert(parse_options(ARRAY_SIZE(argv), (char **)argv, &settings));
+	for (int i = 0; i < ARRAY_SIZE(subtests); i++)
+		add_subtest(&list, "bisect-victim", subtests[i]);
+
+	igt_assert(initialize_execute_state(&exec, &settings, &list));
+	igt_assert(execute(&exec, &settings, &list));
+	free_job_list(&list);
+	clear_settings(&settings);
+
+	dirfd = open(results, O_DIRECTORY | O_RDONLY);
+	igt_assert_fd(dirfd);
+	igt_assert(bisect_init(&bisect, dirfd, NULL, work));
+	close(dirfd);
+
+	igt_assert_eq(strcmp(bisect.test, "igt@bisect-victim@victim"), 0);
+	igt_assert_eq(strcmp(bisect.result, "fail"), 0);
+	igt_assert_eq(bisect.target, 4);
+
+	count = bisect_minimize(units, 4, bisect_reproduces, &bisect);
+	igt_assert_eq(count, 1);
+	igt_assert_eq(units[0], 2);
+
+	igt_assert(bisect_run(&bisect, units, count, BISECT_MINIMAL_DIRNAME,
+			      &reproduced));
+	igt_assert(reproduced);
+
+	/* the minimal job list is kept along with its results */
+	init_job_list(&list);
+	dirfd = open(bisect.settings.results_path, O_DIRECTORY | O_RDONLY);
+	igt_assert_fd(dirfd);
+	igt_assert(read_job_list(&list, dirfd));
+	close(dirfd);
+	igt_assert_eq(list.size, 2);
+	igt_assert_eq(strcmp(list.entries[0].subtests[0], "poison"), 0);
+	igt_assert_eq(strcmp(list.entries[1].subtests[0], "victim"), 0);
+	free_job_list(&list);
+
+	bisect_fini(&bisect);
+	unsetenv("BISECT_VICTIM_STATE");
+	scratch_remove(dir, NULL);
+}
+
+igt_main
+{
+	igt_subtest("minimize-single") {
+		static const size_t needed[] = { 7 };
+
+		check_minimize(20, needed, ARRAY_SIZE(needed));
+	}
+
+	igt_subtest("minimize-pair") {
+		static const size_t needed[] = { 3, 15 };
+
+		check_minimize(20, needed, ARRAY_SIZE(needed));
+	}
+
+	igt_subtest("minimize-none")
+		check_minimize(20, NULL, 0);
+
+	igt_subtest("minimize-all") {
+		static const size_t needed[] = { 0, 1, 2, 3 };
+
+		check_minimize(4, needed, ARRAY_SIZE(needed));
+	}
+
+	igt_subtest("bisect-victim")
+		test_victim();
+}
@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+
+#include "igt.h"
+#include "cgroup.h"
+#include "runner_tests_common.h"
+
+/*
+ * A fake cgroupfs made of regular files: the kernel side of each control
+ * file is played by the test.
+ */
+static char root[] = "/tmp/runner_cgroup_test.XXXXXX";
+
+static void assert_file(const char *path, const char *expected)
+{
+	char full[PATH_MAX], buf[1024];
+	ssize_t len;
+	int fd;
+
+	snprintf(full, sizeof(full), "%s/%s", root, path);
+	fd = open(full, O_RDONLY);
+	igt_assert_fd(fd);
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+
+	igt_assert_lte(0, len);
+	buf[len] = '\0';
+	igt_assert_f(!strcmp(buf, expected), "%s: '%s' != '%s'\n",
+		     path, buf, expected);
+}
+
+static void make_leaf(const char *name)
+{
+	char path[PATH_MAX];
+
+	scratch_mkdir(root, name);
+
+	snprintf(path, sizeof(path), "%s/cgroup.procs", name);
+	scratch_write(root, path, "");
+	snprintf(path, sizeof(path), "%s/cgroup.events", name);
+	scratch_write(root, path, "populated 0\nfrozen 0\n");
+}
+
+static int open_leaf(const char *name)
+{
+	char path[PATH_MAX];
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", root, name);
+	fd = open(path, O_DIRECTORY | O_RDONLY);
+	igt_assert_fd(fd);
+
+	return fd;
+}
+
+static void test_init(void)
+{
+	int fd;
+
+	scratch_write(root, "cgroup.subtree_control", "cpu io memory\n");
+	fd = runner_cgroup_init(root, 1 << 20, 50);
+	igt_assert_fd(fd);
+	close(fd);
+
+	/* controllers already enabled are left alone */
+	assert_file("cgroup.subtree_control", "cpu io memory\n");
+
+	scratch_write(root, "cgroup.subtree_control", "io\n");
+	fd = runner_cgroup_init(root, 0, 0);
+	igt_assert_fd(fd);
+	close(fd);
+
+	/* a fake file doesn't enable anything, the limits can't be had */
+	scratch_write(root, "cgroup.subtree_control", "io\n");
+	igt_assert_eq(runner_cgroup_init(root, 1 << 20, 0), -1);
+	scratch_write(root, "cgroup.subtree_control", "io memory\n");
+	igt_assert_eq(runner_cgroup_init(root, 0, 50), -1);
+
+	igt_assert_eq(runner_cgroup_init("/nonexistent/cgroup", 0, 0), -1);
+}
+
+static void test_create(void)
+{
+	char path[PATH_MAX];
+	struct stat st;
+	int rootfd, fd;
+
+	rootfd = open(root, O_DIRECTORY | O_RDONLY);
+	igt_assert_fd(rootfd);
+
+	make_leaf("limits");
+	scratch_write(root, "limits/memory.max", "max\n");
+	scratch_write(root, "limits/memory.oom.group", "0");
+	scratch_write(root, "limits/cpu.max", "max 100000\n");
+
+	fd = runner_cgroup_create(rootfd, "limits", 64 << 20, 150);
+	igt_assert_fd(fd);
+	assert_file("limits/memory.max", "67108864");
+	assert_file("limits/memory.oom.group", "1");
+	assert_file("limits/cpu.max", "150000 100000");
+
+	igt_assert(runner_cgroup_join(fd));
+	assert_file("limits/cgroup.procs", "0");
+	close(fd);
+
+	/* no memory.max, the new cgroup doesn't have the memory controller */
+	igt_assert_eq(runner_cgroup_create(rootfd, "nomem", 64 << 20, 0), -1);
+	snprintf(path, sizeof(path), "%s/nomem", root);
+	igt_assert_eq(stat(path, &st), -1);
+
+	fd = runner_cgroup_create(rootfd, "nolimits", 0, 0);
+	igt_assert_fd(fd);
+	close(fd);
+	igt_assert(runner_cgroup_remove(rootfd, "nolimits"));
+	snprintf(path, sizeof(path), "%s/nolimits", root);
+	igt_assert_eq(stat(path, &st), -1);
+	igt_assert(runner_cgroup_remove(rootfd, "nolimits"));
+
+	close(rootfd);
+}
+
+static void test_kill(void)
+{
+	char pids[32];
+	pid_t child;
+	int fd, status;
+
+	make_leaf("kill");
+	scratch_write(root, "kill/cgroup.kill", "0");
+
+	fd = open_leaf("kill");
+	igt_assert(runner_cgroup_kill(fd));
+	assert_file("kill/cgroup.kill", "1");
+
+	/* without cgroup.kill the listed processes get a SIGKILL each */
+	unlinkat(fd, "cgroup.kill", 0);
+	child = fork();
+	igt_assert_lte(0, child);
+	if (!child) {
+		pause();
+		exit(0);
+	}
+
+	snprintf(pids, sizeof(pids), "%d\n", child);
+	scratch_write(root, "kill/cgroup.procs", pids);
+	igt_assert(runner_cgroup_kill(fd));
+
+	igt_assert_eq(waitpid(child, &status, 0), child);
+	igt_assert(WIFSIGNALED(status));
+	igt_assert_eq(WTERMSIG(status), SIGKILL);
+
+	close(fd);
+}
+
+static void test_wait_empty(void)
+{
+	struct timespec start, now;
+	int fd;
+
+	make_leaf("wait");
+	fd = open_leaf("wait");
+
+	igt_assert(runner_cgroup_wait_empty(fd, 1000));
+
+	scratch_write(root, "wait/cgroup.events", "populated 1\nfrozen 0\n");
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	igt_assert(!runner_cgroup_wait_empty(fd, 20));
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	igt_assert_lte(20, igt_time_elapsed(&start, &now) * 1000);
+
+	scratch_write(root, "wait/cgroup.events", "frozen 0\n");
+	igt_assert(!runner_cgroup_wait_empty(fd, 1000));
+
+	close(fd);
+}
+
+static void test_stats(void)
+{
+	int fd, resfd;
+
+	make_leaf("stats");
+	scratch_write(root, "stats/cpu.stat",
+		   "usage_usec 1500\nuser_usec 1000\nsystem_usec 500\n"
+		   "nr_periods 0\nnr_throttled 0\nthrottled_usec 0\n");
+	scratch_write(root, "stats/memory.peak", "8388608\n");
+	scratch_write(root, "stats/memory.events",
+		   "low 0\nhigh 0\nmax 3\noom 1\noom_kill 1\noom_group_kill 1\n");
+	scratch_write(root, "stats/io.stat",
+		   "8:0 rbytes=4096 wbytes=8192 rios=1 wios=2 dbytes=0 dios=0\n"
+		   "259:0 rbytes=1000 wbytes=0 rios=3 wios=0 dbytes=0 dios=0\n");
+
+	fd = open_leaf("stats");
+	resfd = open(root, O_DIRECTORY | O_RDONLY);
+	igt_assert_fd(resfd);
+
+	igt_assert(runner_cgroup_save_stats(fd, resfd, true));
+	assert_file(CGROUP_RESFILENAME,
+		    "cpu_usage_usec : 1500\n"
+		    "cpu_user_usec : 1000\n"
+		    "cpu_system_usec : 500\n"
+		    "memory_peak : 8388608\n"
+		    "memory_oom_kill : 1\n"
+		    "io_rbytes : 5096\n"
+		    "io_wbytes : 8192\n"
+		    "io_rios : 4\n"
+		    "io_wios : 2\n");
+
+	/* only what the enabled controllers provide */
+	unlinkat(fd, "memory.peak", 0);
+	unlinkat(fd, "memory.events", 0);
+	scratch_write(root, "stats/io.stat", "");
+	igt_assert(runner_cgroup_save_stats(fd, resfd, false));
+	assert_file(CGROUP_RESFILENAME,
+		    "cpu_usage_usec : 1500\n"
+		    "cpu_user_usec : 1000\n"
+		    "cpu_system_usec : 500\n"
+		    "io_rbytes : 0\n"
+		    "io_wbytes : 0\n"
+		    "io_rios : 0\n"
+		    "io_wios : 0\n");
+
+	close(resfd);
+	close(fd);
+}
+
+igt_main
+{
+	igt_fixture {
+		scratch_create(root);
+		scratch_write(root, "cgroup.procs", "");
+	}
+
+	igt_subtest("init")
+		test_init();
+
+	igt_subtest("create")
+		test_create();
+
+	igt_subtest("kill")
+		test_kill();
+
+	igt_subtest("wait-empty")
+		test_wait_empty();
+
+	igt_subtest("stats")
+		test_stats();
+
+	igt_fixture
+		scratch_remove(root, NULL);
+}
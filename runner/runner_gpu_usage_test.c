@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "igt.h"
+#include "gpu_usage.h"
+#include "runner_tests_common.h"
+
+/*
+ * A fake procfs where 100 plays the runner and 200 the test, with one
+ * i915 client whose counters are changed between the subtest boundaries.
+ */
+#define RUNNER_PID 100
+#define TEST_PID 200
+#define IGPU "0000:00:02.0"
+
+static char root[] = "/tmp/runner_gpu_usage_test.XXXXXX";
+
+static void assert_file(int dirfd, const char *path, const char *expected)
+{
+	char buf[4096];
+	ssize_t len;
+	int fd;
+
+	fd = openat(dirfd, path, O_RDONLY);
+	igt_assert_fd(fd);
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+
+	igt_assert_lte(0, len);
+	buf[len] = '\0';
+	igt_assert_f(!strcmp(buf, expected), "%s: '%s' != '%s'\n",
+		     path, buf, expected);
+}
+
+static void make_proc(pid_t pid, pid_t ppid)
+{
+	char path[64], buf[256];
+
+	snprintf(path, sizeof(path), "%d", pid);
+	scratch_mkdir(root, path);
+	snprintf(path, sizeof(path), "%d/fd", pid);
+	scratch_mkdir(root, path);
+	snprintf(path, sizeof(path), "%d/fdinfo", pid);
+	scratch_mkdir(root, path);
+
+	snprintf(path, sizeof(path), "%d/status", pid);
+	snprintf(buf, sizeof(buf),
+		 "Name:\tproc%d\nPPid:\t%d\nUid:\t0\t0\t0\t0\nGid:\t0\t0\t0\t0\n",
+		 pid, ppid);
+	scratch_write(root, path, buf);
+}
+
+static void client(unsigned long render_ns, unsigned int resident_mib)
+{
+	char path[64], buf[512];
+
+	snprintf(path, sizeof(path), "%d/fdinfo/3", TEST_PID);
+	snprintf(buf, sizeof(buf),
+		 "pos:\t0\nflags:\t02100002\n"
+		 "drm-driver:\ti915\n"
+		 "drm-client-id:\t7\n"
+		 "drm-pdev:\t" IGPU "\n"
+		 "drm-total-system0:\t8 MiB\n"
+		 "drm-resident-system0:\t%u MiB\n"
+		 "drm-engine-render:\t%lu ns\n"
+		 "drm-engine-copy:\t500 ns\n",
+		 resident_mib, render_ns);
+	scratch_write(root, path, buf);
+}
+
+static void make_test(void)
+{
+	char path[PATH_MAX];
+
+	make_proc(TEST_PID, RUNNER_PID);
+	snprintf(path, sizeof(path), "%s/%d/fd/3", root, TEST_PID);
+	igt_assert_eq(symlink("/dev/dri/renderD128", path), 0);
+	client(1000, 1);
+}
+
+static void exit_test(void)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "%d", TEST_PID);
+	scratch_remove(root, path);
+}
+
+static void packet(struct runner_gpu_usage *gpu, struct runnerpacket *p)
+{
+	runner_gpu_usage_packet(gpu, p);
+	free(p);
+}
+
+/* lets the next boundary take a sample of its own */
+static void wait_boundary(void)
+{
+	usleep(GPU_USAGE_BOUNDARY_INTERVAL_NS / 1000);
+}
+
+static void test_subtests(int dirfd)
+{
+	struct runner_gpu_usage *gpu;
+
+	make_test();
+	gpu = runner_gpu_usage_start(root, RUNNER_PID, dirfd, true);
+	igt_assert(gpu);
+
+	packet(gpu, runnerpacket_log(STDOUT_FILENO, "starting\n"));
+	packet(gpu, runnerpacket_subtest_start("first"));
+
+	client(5000, 8);
+	wait_boundary();
+	packet(gpu, runnerpacket_dynamic_subtest_start("dyn"));
+
+	client(6000, 2);
+	wait_boundary();
+	packet(gpu, runnerpacket_dynamic_subtest_result("dyn", "pass", "0.1", NULL));
+	packet(gpu, runnerpacket_subtest_result("first", "pass", "0.2", NULL));
+
+	/* the last sample of the exited test still counts */
+	packet(gpu, runnerpacket_subtest_start("second"));
+	client(7500, 4);
+	sleep(1);
+	runner_gpu_usage_tick(gpu);
+	runner_gpu_usage_packet(NULL, NULL);
+	exit_test();
+	runner_gpu_usage_finish(gpu);
+
+	assert_file(dirfd, GPU_USAGE_RESFILENAME,
+		    "engine " IGPU " render 1000 first@dyn\n"
+		    "engine " IGPU " copy 0 first@dyn\n"
+		    "region " IGPU " system0 8388608 first@dyn\n"
+		    "engine " IGPU " render 5000 first\n"
+		    "engine " IGPU " copy 0 first\n"
+		    "region " IGPU " system0 8388608 first\n"
+		    "engine " IGPU " render 1500 second\n"
+		    "engine " IGPU " copy 0 second\n"
+		    "region " IGPU " system0 4194304 second\n");
+}
+
+static void test_boundaries(int dirfd)
+{
+	struct runner_gpu_usage *gpu;
+
+	make_test();
+	gpu = runner_gpu_usage_start(root, RUNNER_PID, dirfd, false);
+	igt_assert(gpu);
+
+	packet(gpu, runnerpacket_subtest_start("first"));
+	wait_boundary();
+
+	client(2000, 1);
+	packet(gpu, runnerpacket_dynamic_subtest_start("a"));
+
+	/* too close to the start of a to take another sample */
+	client(3000, 1);
+	packet(gpu, runnerpacket_dynamic_subtest_result("a", "pass", "0.0", NULL));
+	packet(gpu, runnerpacket_dynamic_subtest_start("b"));
+
+	/* so what a ran is charged to b */
+	client(4000, 1);
+	wait_boundary();
+	packet(gpu, runnerpacket_dynamic_subtest_result("b", "pass", "0.0", NULL));
+	packet(gpu, runnerpacket_subtest_result("first", "pass", "0.0", NULL));
+
+	runner_gpu_usage_finish(gpu);
+	exit_test();
+
+	assert_file(dirfd, GPU_USAGE_RESFILENAME,
+		    "engine " IGPU " render 0 first@a\n"
+		    "engine " IGPU " copy 0 first@a\n"
+		    "region " IGPU " system0 1048576 first@a\n"
+		    "engine " IGPU " render 2000 first@b\n"
+		    "engine " IGPU " copy 0 first@b\n"
+		    "region " IGPU " system0 1048576 first@b\n"
+		    "engine " IGPU " render 3000 first\n"
+		    "engine " IGPU " copy 0 first\n"
+		    "region " IGPU " system0 1048576 first\n");
+}
+
+static void test_binary(int dirfd)
+{
+	struct runner_gpu_usage *gpu;
+
+	make_test();
+	gpu = runner_gpu_usage_start(root, RUNNER_PID, dirfd, false);
+	igt_assert(gpu);
+
+	client(3000, 16);
+	runner_gpu_usage_finish(gpu);
+	exit_test();
+
+	assert_file(dirfd, GPU_USAGE_RESFILENAME,
+		    "engine " IGPU " render 2000\n"
+		    "engine " IGPU " copy 0\n"
+		    "region " IGPU " system0 16777216\n");
+
+	igt_assert(!runner_gpu_usage_start("/nonexistent/proc", RUNNER_PID,
+					   dirfd, false));
+}
+
+igt_main
+{
+	char resdir[PATH_MAX];
+	int dirfd = -1;
+
+	igt_fixture {
+		scratch_create(root);
+		make_proc(RUNNER_PID, 1);
+
+		scratch_mkdir(root, "results");
+		snprintf(resdir, sizeof(resdir), "%s/results", root);
+		dirfd = open(resdir, O_DIRECTORY | O_RDONLY);
+		igt_assert_fd(dirfd);
+	}
+
+	igt_subtest("subtests")
+		test_subtests(dirfd);
+
+	igt_subtest("boundaries")
+		test_boundaries(dirfd);
+
+	igt_subtest("binary")
+		test_binary(dirfd);
+
+	igt_fixture {
+		close(dirfd);
+		scratch_remove(root, NULL);
+	}
+}
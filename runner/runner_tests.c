@@ -205,6 +205,10 @@ static void assert_settings_equal(struct settings *one, struct settings *two)
 	igt_assert_eq(one->piglit_style_dmesg, two->piglit_style_dmesg);
 	igt_assert_eq(one->dmesg_warn_level, two->dmesg_warn_level);
 	igt_assert_eq(one->prune_mode, two->prune_mode);
+	igt_assert_eqstr(one->cgroup_root, two->cgroup_root);
+	igt_assert_eq_u64(one->cgroup_memory_max, two->cgroup_memory_max);
+	igt_assert_eq(one->cgroup_cpu_max, two->cgroup_cpu_max);
+	igt_assert_eq(one->gpu_usage, two->gpu_usage);
 
 	igt_assert_eq(igt_vec_length(&one->hook_strs), igt_vec_length(&two->hook_strs));
 	for (size_t i = 0; i < igt_vec_length(&one->hook_strs); i++) {
@@ -321,6 +325,7 @@ igt_main
 
 		igt_assert(!settings->piglit_style_dmesg);
 		igt_assert_eq(settings->dmesg_warn_level, 4);
+		igt_assert(!settings->gpu_usage);
 	}
 
 	igt_subtest_group {
@@ -485,6 +490,10 @@ igt_main
 				       "--hook", "echo hello",
 				       "--hook", "echo world",
 				       "--prune-mode=keep-subtests",
+				       "--cgroup", "path-to-cgroup",
+				       "--cgroup-memory-max", "64M",
+				       "--cgroup-cpu-max", "150",
+				       "--gpu-usage",
 				       "test-root-dir",
 				       "path-to-results",
 		};
@@ -543,6 +552,11 @@ igt_main
 
 		igt_assert(settings->piglit_style_dmesg);
 		igt_assert_eq(settings->dmesg_warn_level, 3);
+
+		igt_assert(strstr(settings->cgroup_root, "path-to-cgroup") != NULL);
+		igt_assert_eq_u64(settings->cgroup_memory_max, 64UL << 20);
+		igt_assert_eq(settings->cgroup_cpu_max, 150);
+		igt_assert(settings->gpu_usage);
 	}
 	igt_subtest("parse-list-all") {
 		const char *argv[] = { "runner",
@@ -694,6 +708,24 @@ igt_main
 		igt_assert_eq_u64(settings->disk_usage_limit, 1024UL * 1024UL * 1024UL);
 	}
 
+	igt_subtest("cgroup-limits-require-cgroup") {
+		const char *argv[] = { "runner",
+				       "--cgroup-memory-max=1G",
+				       "test-root-dir",
+				       "results-path",
+		};
+
+		igt_assert(!parse_options(ARRAY_SIZE(argv), (char**)argv, settings));
+
+		argv[1] = "--cgroup-cpu-max=50";
+		igt_assert(!parse_options(ARRAY_SIZE(argv), (char**)argv, settings));
+
+		argv[1] = "--cgroup=path-to-cgroup";
+		igt_assert(parse_options(ARRAY_SIZE(argv), (char**)argv, settings));
+		igt_assert_eq_u64(settings->cgroup_memory_max, 0);
+		igt_assert_eq(settings->cgroup_cpu_max, 0);
+	}
+
 	igt_subtest("prune-modes") {
 		const char *argv[] = { "runner",
 			               "--prune-mode=keep-dynamic-subtests",
@@ -997,6 +1029,10 @@ igt_main
 					       "--use-watchdog",
 					       "--piglit-style-dmesg",
 					       "--prune-mode=keep-all",
+					       "--cgroup", "/sys/fs/cgroup/igt",
+					       "--cgroup-memory-max=16M",
+					       "--cgroup-cpu-max=200",
+					       "--gpu-usage",
 					       "--hook", "echo hello",
 					       "--hook", "echo hello\necho newline",
 					       "--hook", "echo hello\necho newline\\still the second line",
@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+#ifndef RUNNER_TESTS_COMMON_H
+#define RUNNER_TESTS_COMMON_H
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "igt_core.h"
+
+/*
+ * Scratch trees standing in for procfs, cgroupfs and results directories:
+ * @root is a mkdtemp() template, and the other paths are relative to it.
+ */
+static inline void scratch_create(char *root)
+{
+	igt_assert(mkdtemp(root));
+}
+
+static inline void scratch_write(const char *root, const char *path,
+				 const char *data)
+{
+	char full[PATH_MAX];
+	int fd;
+
+	snprintf(full, sizeof(full), "%s/%s", root, path);
+	fd = open(full, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	igt_assert_fd(fd);
+	igt_assert_eq(write(fd, data, strlen(data)), strlen(data));
+	close(fd);
+}
+
+static inline void scratch_mkdir(const char *root, const char *path)
+{
+	char full[PATH_MAX];
+
+	snprintf(full, sizeof(full), "%s/%s", root, path);
+	igt_assert_eq(mkdir(full, 0755), 0);
+}
+
+static inline int scratch_rm_entry(const char *path, const struct stat *st,
+				   int flag, struct FTW *ftw)
+{
+	return remove(path);
+}
+
+/* Removes @path and everything below it, or the whole tree if NULL */
+static inline void scratch_remove(const char *root, const char *path)
+{
+	char full[PATH_MAX];
+
+	if (path)
+		snprintf(full, sizeof(full), "%s/%s", root, path);
+	else
+		snprintf(full, sizeof(full), "%s", root);
+	nftw(full, scratch_rm_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+#endif /* RUNNER_TESTS_COMMON_H */
@@ -35,6 +35,10 @@ enum {
 	OPT_HELP_HOOK,
 	OPT_VERSION,
 	OPT_PRUNE_MODE,
+	OPT_CGROUP,
+	OPT_CGROUP_MEMORY_MAX,
+	OPT_CGROUP_CPU_MAX,
+	OPT_GPU_USAGE,
 	OPT_HELP = 'h',
 	OPT_NAME = 'n',
 	OPT_DRY_RUN = 'd',
@@ -185,7 +189,7 @@ static size_t char_to_multiplier(char c)
 	return 0;
 }
 
-static bool parse_usage_limit(struct settings *settings, const char *optarg)
+static bool parse_size(size_t *size, const char *optarg)
 {
 	size_t value;
 	char *endptr = NULL;
@@ -204,10 +208,15 @@ static bool parse_usage_limit(struct settings *settings, const char *optarg)
 		value *= multiplier;
 	}
 
-	settings->disk_usage_limit = value;
+	*size = value;
 	return true;
 }
 
+static bool parse_usage_limit(struct settings *settings, const char *optarg)
+{
+	return parse_size(&settings->disk_usage_limit, optarg);
+}
+
 static const char *usage_str =
 	"usage: runner [options] [test_root] results-path\n"
 	"   or: runner --list-all [options] [test_root]\n\n"
@@ -320,6 +329,20 @@ static const char *usage_str =
 	"                        Forward HOOK_STR to the --hook option of each test.\n"
 	"  --help-hook\n"
 	"                        Show detailed usage information for --hook.\n"
+	"  --cgroup <path>       Run each test in its own cgroup created in the cgroup v2\n"
+	"                        directory <path>, which must be writable by the runner\n"
+	"                        and not contain the runner itself. Processes left behind\n"
+	"                        by a test are killed with the cgroup, and the CPU time,\n"
+	"                        peak memory and io of the test are added to the results.\n"
+	"  --cgroup-memory-max <limit>\n"
+	"                        Limit the memory of each test to <limit> bytes. The limit\n"
+	"                        can use suffixes k, M and G. Requires --cgroup\n"
+	"  --cgroup-cpu-max <percent>\n"
+	"                        Limit the CPU time of each test to <percent> of one CPU.\n"
+	"                        Requires --cgroup\n"
+	"  --gpu-usage           Add the GPU engine time and the peak memory of each\n"
+	"                        memory region used by each subtest to the results, as\n"
+	"                        reported by DRM fdinfo.\n"
 	"\n"
 	"  [test_root]           Directory that contains the IGT tests. The environment\n"
 	"                        variable IGT_TEST_ROOT will be used if set, overriding\n"
@@ -664,6 +687,7 @@ void clear_settings(struct settings *settings)
 	free(settings->test_root);
 	free(settings->results_path);
 	free(settings->code_coverage_script);
+	free(settings->cgroup_root);
 
 	free_regexes(&settings->include_regexes);
 	free_regexes(&settings->exclude_regexes);
@@ -714,6 +738,10 @@ bool parse_options(int argc, char **argv,
 		{"prune-mode", required_argument, NULL, OPT_PRUNE_MODE},
 		{"blacklist", required_argument, NULL, OPT_BLACKLIST},
 		{"list-all", no_argument, NULL, OPT_LIST_ALL},
+		{"cgroup", required_argument, NULL, OPT_CGROUP},
+		{"cgroup-memory-max", required_argument, NULL, OPT_CGROUP_MEMORY_MAX},
+		{"cgroup-cpu-max", required_argument, NULL, OPT_CGROUP_CPU_MAX},
+		{"gpu-usage", no_argument, NULL, OPT_GPU_USAGE},
 		{ 0, 0, 0, 0},
 	};
 
@@ -852,6 +880,25 @@ bool parse_options(int argc, char **argv,
 		case OPT_LIST_ALL:
 			settings->list_all = true;
 			break;
+		case OPT_CGROUP:
+			settings->cgroup_root = absolute_path(optarg);
+			break;
+		case OPT_CGROUP_MEMORY_MAX:
+			if (!parse_size(&settings->cgroup_memory_max, optarg)) {
+				usage(stderr, "Cannot parse cgroup memory limit");
+				goto error;
+			}
+			break;
+		case OPT_CGROUP_CPU_MAX:
+			settings->cgroup_cpu_max = atoi(optarg);
+			if (settings->cgroup_cpu_max <= 0) {
+				usage(stderr, "Cannot parse cgroup CPU limit");
+				goto error;
+			}
+			break;
+		case OPT_GPU_USAGE:
+			settings->gpu_usage = true;
+			break;
 		case '?':
 			usage(stderr, NULL);
 			goto error;
@@ -867,6 +914,12 @@ bool parse_options(int argc, char **argv,
 	if (settings->prune_mode < 0)
 		settings->prune_mode = PRUNE_KEEP_ALL;
 
+	if ((settings->cgroup_memory_max || settings->cgroup_cpu_max) &&
+	    !settings->cgroup_root) {
+		usage(stderr, "cgroup limits require --cgroup");
+		goto error;
+	}
+
 	if (settings->list_all) { /* --list-all doesn't require results path */
 		switch (argc - optind) {
 		case 1:
@@ -975,6 +1028,24 @@ bool validate_settings(struct settings *settings)
 		return false;
 	}
 
+	if (settings->cgroup_root) {
+		dirfd = open(settings->cgroup_root, O_DIRECTORY | O_RDONLY);
+		if (dirfd < 0) {
+			fprintf(stderr, "cgroup directory %s cannot be opened\n",
+				settings->cgroup_root);
+			return false;
+		}
+
+		if (faccessat(dirfd, "cgroup.procs", F_OK, 0)) {
+			fprintf(stderr, "%s is not a cgroup v2 directory\n",
+				settings->cgroup_root);
+			close(dirfd);
+			return false;
+		}
+
+		close(dirfd);
+	}
+
 	if (settings->enable_code_coverage) {
 		if (!executable_file(settings->code_coverage_script)) {
 			fprintf(stderr, "%s doesn't exist or is not executable\n", settings->code_coverage_script);
@@ -1253,6 +1324,12 @@ bool serialize_settings(struct settings *settings)
 	SERIALIZE_INT(f, settings, enable_code_coverage);
 	SERIALIZE_INT(f, settings, cov_results_per_test);
 	SERIALIZE_STR(f, settings, code_coverage_script);
+	if (settings->cgroup_root) {
+		SERIALIZE_STR(f, settings, cgroup_root);
+		SERIALIZE_UL(f, settings, cgroup_memory_max);
+		SERIALIZE_INT(f, settings, cgroup_cpu_max);
+	}
+	SERIALIZE_INT(f, settings, gpu_usage);
 	SERIALIZE_STR_ARRAY(f, settings, cmdline.argv, cmdline.argc);
 
 	if (settings->sync) {
@@ -1371,6 +1448,10 @@ bool read_settings_from_file(struct settings *settings, FILE *f)
 		PARSE_INT(settings, name, val, enable_code_coverage);
 		PARSE_INT(settings, name, val, cov_results_per_test);
 		PARSE_STR(settings, name, val, code_coverage_script);
+		PARSE_STR(settings, name, val, cgroup_root);
+		PARSE_UL(settings, name, val, cgroup_memory_max);
+		PARSE_INT(settings, name, val, cgroup_cpu_max);
+		PARSE_INT(settings, name, val, gpu_usage);
 		PARSE_STR_ARRAY(settings, name, val, cmdline.argv, cmdline.argc);
 
 		printf("Warning: Unknown field in settings file: %s = %s\n",
@@ -81,6 +81,10 @@ struct settings {
 	char *code_coverage_script;
 	bool enable_code_coverage;
 	bool cov_results_per_test;
+	char *cgroup_root;
+	size_t cgroup_memory_max;
+	int cgroup_cpu_max;
+	bool gpu_usage;
 	struct {
 		int argc;
 		char **argv;
@@ -0,0 +1,43 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "igt.h"
+
+/*
+ * The "victim" subtest fails only when "poison" ran before it, in this
+ * or an earlier process, leaving a file behind. Not part of the
+ * testdata test list, the bisection test runs it explicitly.
+ */
+static const char *state_file(void)
+{
+	const char *path = getenv("BISECT_VICTIM_STATE");
+
+	igt_require_f(path, "BISECT_VICTIM_STATE not set\n");
+	return path;
+}
+
+igt_main
+{
+	igt_subtest("first")
+		igt_debug("Harmless\n");
+
+	igt_subtest("second")
+		igt_debug("Harmless\n");
+
+	igt_subtest("poison") {
+		int fd = open(state_file(), O_CREAT | O_WRONLY, 0644);
+
+		igt_assert_fd(fd);
+		close(fd);
+	}
+
+	igt_subtest("third")
+		igt_debug("Harmless\n");
+
+	igt_subtest("victim")
+		igt_assert_f(unlink(state_file()) < 0,
+			     "Poisoned by an earlier subtest\n");
+
+	igt_subtest("last")
+		igt_debug("Harmless\n");
+}
@@ -10,6 +10,8 @@
 #include <amdgpu.h>
 #include <amdgpu_drm.h>
 #include "lib/amdgpu/amd_PM4.h"
+#include "lib/amdgpu/amd_command_submission.h"
+#include "lib/amdgpu/amd_ib_pool.h"
 #include "lib/amdgpu/amd_ip_blocks.h"
 #include "lib/amdgpu/amd_memory.h"
 
@@ -35,6 +37,7 @@ static void amdgpu_cs_sync(amdgpu_context_handle context,
 
 #define SYNC 0x1
 #define FORK 0x2
+#define POOL 0x4
 static void nop_cs(amdgpu_device_handle device,
 		   amdgpu_context_handle context,
 		   const char *name,
@@ -146,6 +149,68 @@ static void nop_cs(amdgpu_device_handle device,
 	free(ring_context);
 }
 
+/*
+ * Same as nop_cs(), but going through amdgpu_test_exec_cs_helper() with an
+ * IB pool, keeping up to POOL_DEPTH submissions in flight.
+ */
+#define POOL_DEPTH 32
+static void nop_cs_pool(amdgpu_device_handle device,
+			amdgpu_context_handle context,
+			const char *name,
+			unsigned int ip_type,
+			unsigned int ring,
+			unsigned int timeout,
+			unsigned int flags)
+{
+	const int ncpus = flags & FORK ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+	uint32_t nops[16];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nops); i++)
+		nops[i] = GFX_COMPUTE_NOP;
+
+	igt_fork(child, ncpus) {
+		struct amdgpu_ring_context *ring_context;
+		struct timespec tv = {};
+		uint64_t submit_ns, sync_ns;
+		unsigned long count;
+
+		ring_context = calloc(1, sizeof(*ring_context));
+		igt_assert(ring_context);
+		ring_context->context_handle = context;
+		ring_context->ring_id = ring;
+		ring_context->pm4 = nops;
+		ring_context->pm4_size = ARRAY_SIZE(nops);
+		ring_context->pm4_dw = ARRAY_SIZE(nops);
+
+		/* the pool bookkeeping is per process, so one pool per child */
+		ring_context->ib_pool = amdgpu_ib_pool_create(device,
+							      POOL_DEPTH * 4096,
+							      POOL_DEPTH);
+
+		count = 0;
+		igt_nsec_elapsed(&tv);
+		igt_until_timeout(timeout) {
+			amdgpu_test_exec_cs_helper(device, ip_type, ring_context, 0);
+			if (flags & SYNC)
+				igt_assert_eq(amdgpu_ib_pool_sync(ring_context->ib_pool), 0);
+
+			count++;
+		}
+		submit_ns = igt_nsec_elapsed(&tv);
+		igt_assert_eq(amdgpu_ib_pool_sync(ring_context->ib_pool), 0);
+		sync_ns = igt_nsec_elapsed(&tv);
+
+		igt_info("%s.%d: %'lu cycles, submit %.2fus, sync %.2fus\n",
+			 name, child, count,
+			 1e-3 * submit_ns / count, 1e-3 * sync_ns / count);
+
+		amdgpu_ib_pool_destroy(ring_context->ib_pool);
+		free(ring_context);
+	}
+	igt_waitchildren();
+}
+
 igt_main
 {
 	amdgpu_device_handle device;
@@ -158,6 +223,9 @@ igt_main
 		{ "sync", SYNC },
 		{ "fork", FORK },
 		{ "sync-fork", SYNC | FORK },
+		{ "pool", POOL },
+		{ "pool-sync", POOL | SYNC },
+		{ "pool-fork", POOL | FORK },
 		{ },
 	}, *p;
 	const struct engine {
@@ -198,7 +266,11 @@ igt_main
 		for (e = engines; e->name; e++) {
 			igt_describe("Stressful-and-multiple-cs-of-nop-operations-using-multiple-processes-with-the-same-GPU-context");
 			igt_subtest_with_dynamic_f("cs-nops-with-%s-%s0", p->name, e->name) {
-				if (arr_cap[e->ip_type]) {
+				if (arr_cap[e->ip_type] && (p->flags & POOL)) {
+					igt_dynamic_f("cs-nop-with-%s-%s0", p->name, e->name)
+					nop_cs_pool(device, context, e->name, e->ip_type, 0, 20,
+						    p->flags);
+				} else if (arr_cap[e->ip_type]) {
 					igt_dynamic_f("cs-nop-with-%s-%s0", p->name, e->name)
 					nop_cs(device, context, e->name, e->ip_type, 0, 20,
 					       p->flags, 0);
@@ -209,6 +281,10 @@ igt_main
 
 #ifdef AMDGPU_USERQ_ENABLED
 	for (p = phase; p->name; p++) {
+		/* the IB pool only covers kernel queue submissions */
+		if (p->flags & POOL)
+			continue;
+
 		for (e = engines; e->name; e++) {
 			igt_describe("Stressful-and-multiple-cs-of-nop-operations-using-multiple-processes-with-the-same-GPU-context-UMQ");
 			igt_subtest_with_dynamic_f("cs-nops-with-%s-%s0-with-UQ-Submission", p->name, e->name) {
@@ -18,11 +18,14 @@
  * Test category: uapi
  *
  * SUBTEST: read-all-entries
- * Description: Read all entries from debugfs path validating debugfs entries
+ * Description: Read all entries from debugfs path validating debugfs entries,
+ *              none of them may take longer than 10 seconds
  */
 
 IGT_TEST_DESCRIPTION("Read entries from debugfs");
 
+#define NODE_TIMEOUT_MS 10000
+
 igt_main
 {
 	int debugfs = -1;
@@ -38,7 +41,7 @@ igt_main
 
 	igt_describe("Read all entries from debugfs path.");
 	igt_subtest("read-all-entries") {
-		igt_dir_process_files_simple(debugfs);
+		igt_assert_eq(igt_dir_crawl_simple(debugfs, NODE_TIMEOUT_MS), 0);
 	}
 
 	igt_fixture {
@@ -18,12 +18,15 @@
  * Test category: uapi
  *
  * SUBTEST: read-all-entries
- * Description: Read all entries from sysfs path
+ * Description: Read all entries from sysfs path, none of them may take longer
+ *              than 10 seconds
  *
  */
 
 IGT_TEST_DESCRIPTION("Read entries from sysfs paths.");
 
+#define NODE_TIMEOUT_MS 10000
+
 igt_main
 {
 	int fd = -1;
@@ -39,7 +42,7 @@ igt_main
 
 	igt_describe("Read all entries from sysfs path.");
 	igt_subtest("read-all-entries")
-		igt_dir_process_files_simple(sysfs);
+		igt_assert_eq(igt_dir_crawl_simple(sysfs, NODE_TIMEOUT_MS), 0);
 
 	igt_fixture {
 		close(sysfs);
@@ -91,6 +91,7 @@ check_buf(int fd, uint32_t handle, uint32_t val)
 
 static void run_test (int fd, int count)
 {
+	struct igt_mem_planner *planner = igt_mem_planner();
 	struct buf_ops *bops;
 	struct intel_bb *ibb;
 	uint32_t *start_val;
@@ -109,6 +110,10 @@ static void run_test (int fd, int count)
 	for (i = 0; i < count; i++) {
 		uint32_t val;
 
+		/* let reclaim catch up every 64MiB rather than thrash into OOM */
+		if (i % 64 == 0)
+			igt_mem_planner_throttle(planner, 1000);
+
 		intel_buf_init(bops, &bufs[i], WIDTH, HEIGHT, 32, 0,
 			       I915_TILING_NONE, I915_COMPRESSION_NONE);
 		val = rand();
@@ -209,9 +214,14 @@ igt_main
 	}
 
 	igt_subtest("swap-thrash") {
-		uint64_t swap_mb = igt_get_total_swap_mb();
-		igt_require(swap_mb > 0);
-		count = ((igt_get_avail_ram_mb() + (swap_mb / 2)) * 1024*1024) / SIZE;
+		struct igt_mem_planner *planner = igt_mem_planner();
+		uint64_t ram, swap;
+
+		igt_require(igt_mem_planner_refresh(planner) == 0);
+		ram = igt_mem_planner_budget(planner, CHECK_RAM);
+		swap = igt_mem_planner_budget(planner, CHECK_RAM | CHECK_SWAP) - ram;
+		igt_require(swap > 0);
+		count = (ram + swap / 2) / SIZE;
 		igt_require_memory(count, SIZE, CHECK_RAM | CHECK_SWAP);
 		run_test(fd, count);
 	}
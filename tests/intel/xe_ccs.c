@@ -115,8 +115,9 @@ static void surf_copy(int xe,
 	struct blt_copy_data blt = {};
 	struct blt_block_copy_data_ext ext = {};
 	struct blt_ctrl_surf_copy_data surf = {};
+	struct blt_stream *stream;
 	const uint32_t bpp = 32;
-	uint32_t bb1, bb2, ccs, ccs2, *ccsmap, *ccsmap2;
+	uint32_t bb1, ccs, ccs2, *ccsmap, *ccsmap2;
 	uint64_t bb_size, ccssize = mid->size / CCS_RATIO(xe);
 	uint64_t ccs_bo_size = ALIGN(ccssize, xe_get_default_alignment(xe));
 	uint32_t *ccscopy;
@@ -204,8 +205,6 @@ static void surf_copy(int xe,
 				 uc_mocs, DEFAULT_PAT_INDEX, DIRECT_ACCESS);
 	blt_set_ctrl_surf_object(&surf.dst, mid->handle, mid->region, mid->size,
 				 uc_mocs, comp_pat_index, INDIRECT_ACCESS);
-	blt_ctrl_surf_copy(xe, ctx, NULL, ahnd, &surf);
-	intel_ctx_xe_sync(ctx, true);
 
 	blt_copy_init(xe, &blt);
 	blt.color_depth = CD_32bit;
@@ -214,9 +213,12 @@ static void surf_copy(int xe,
 	blt_set_copy_object(&blt.dst, dst);
 	blt_set_object_ext(&ext.src, mid->compression_type, mid->x2, mid->y2, SURFACE_TYPE_2D);
 	blt_set_object_ext(&ext.dst, 0, dst->x2, dst->y2, SURFACE_TYPE_2D);
-	bb2 = xe_bo_create(xe, 0, bb_size, sysmem, 0);
-	blt_set_batch(&blt.bb, bb2, bb_size, sysmem);
-	blt_block_copy(xe, ctx, NULL, ahnd, &blt, &ext);
+
+	/* ccs write and decompressing copy go out in a single batch */
+	stream = blt_stream_create(xe, ctx, NULL, ahnd, sysmem, bb_size);
+	blt_stream_ctrl_surf_copy(stream, &surf);
+	blt_stream_block_copy(stream, &blt, &ext);
+	igt_assert_eq(blt_stream_flush(stream), 0);
 	intel_ctx_xe_sync(ctx, true);
 	WRITE_PNG(xe, run_id, "corrupted", &blt.dst, dst->x2, dst->y2, bpp);
 	result = memcmp(src->ptr, dst->ptr, src->size);
@@ -232,10 +234,11 @@ static void surf_copy(int xe,
 	else
 		/* retrieve back ccs */
 		memcpy(ccsmap, ccscopy, ccssize);
-	blt_ctrl_surf_copy(xe, ctx, NULL, ahnd, &surf);
-
-	blt_block_copy(xe, ctx, NULL, ahnd, &blt, &ext);
+	blt_stream_ctrl_surf_copy(stream, &surf);
+	blt_stream_block_copy(stream, &blt, &ext);
+	igt_assert_eq(blt_stream_flush(stream), 0);
 	intel_ctx_xe_sync(ctx, true);
+	blt_stream_destroy(stream);
 	WRITE_PNG(xe, run_id, "corrected", &blt.dst, dst->x2, dst->y2, bpp);
 	result = memcmp(src->ptr, dst->ptr, src->size);
 	if (result)
@@ -245,7 +248,6 @@ static void surf_copy(int xe,
 	gem_close(xe, ccs);
 	gem_close(xe, ccs2);
 	gem_close(xe, bb1);
-	gem_close(xe, bb2);
 
 	igt_assert_f(result == 0,
 		     "Source and destination surfaces are different after "
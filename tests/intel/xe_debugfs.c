@@ -61,9 +61,12 @@ static int xe_validate_entries(igt_dir_t *igt_dir,
 	return 0;
 }
 
+#define NODE_TIMEOUT_MS 10000
+
 /**
  * SUBTEST: xe-base
- * Description: Check if various debugfs devnodes exist and test reading them
+ * Description: Check if various debugfs devnodes exist and test reading them,
+ *              none of them may take longer than 10 seconds
  */
 static void
 xe_test_base(int fd, struct drm_xe_query_config *config, igt_dir_t *igt_dir)
@@ -81,6 +84,8 @@ xe_test_base(int fd, struct drm_xe_query_config *config, igt_dir_t *igt_dir)
 		"clients",
 		"name"
 	};
+	igt_dir_crawl_opts_t opts = { .timeout_ms = NODE_TIMEOUT_MS };
+	igt_dir_crawl_t crawl;
 	char reference[4096];
 	int val = 0;
 
@@ -136,6 +141,12 @@ xe_test_base(int fd, struct drm_xe_query_config *config, igt_dir_t *igt_dir)
 
 	xe_validate_entries(igt_dir, expected_files,
 			    ARRAY_SIZE(expected_files));
+
+	igt_dir_crawl(igt_dir, &opts, &crawl);
+	igt_dir_crawl_report(&crawl, 10);
+	igt_assert_f(!crawl.timed_out, "%u debugfs nodes timed out\n",
+		     crawl.timed_out);
+	igt_dir_crawl_fini(&crawl);
 }
 
 /**
@@ -597,6 +597,10 @@ static void prepare_crtc(data_t *data, int cursor_w, int cursor_h)
 		      DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR,
 		      &data->primary_fb[SWCOMPARISONBUFFER2]);
 
+	/* only cairo draws into these, one cursor area at a time */
+	for (int i = 0; i < MAXCURSORBUFFER; i++)
+		igt_fb_enable_shadow(&data->primary_fb[i]);
+
 	data->primary = igt_output_get_plane_type(output, DRM_PLANE_TYPE_PRIMARY);
 	data->cursor = igt_output_get_plane_type(output, DRM_PLANE_TYPE_CURSOR);
 
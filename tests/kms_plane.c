@@ -33,6 +33,8 @@
  */
 
 #include "igt.h"
+#include "igt_crc_cache.h"
+#include "igt_fb_pool.h"
 #include "igt_vec.h"
 #include <errno.h>
 #include <stdbool.h>
@@ -114,6 +116,9 @@ typedef struct {
 	uint32_t crop;
 	bool extended;
 	unsigned int flags;
+	igt_crc_cache_t ref_crcs;
+	struct igt_fb_pool *fb_pool;
+	unsigned int display_ver;
 } data_t;
 
 static bool all_pipes;
@@ -617,11 +622,11 @@ static void prepare_format_color(data_t *data, enum pipe pipe,
 	cairo_t *cr;
 	const int localcrop = format == DRM_FORMAT_XRGB8888 ? 0 : data->crop;
 
-	igt_create_fb_with_bo_size(data->drm_fd,
-				   width + localcrop * 2,
-				   height + localcrop * 2,
-				   format, modifier, color_encoding,
-				   color_range, fb, 0, 0);
+	/* everything is painted over below, no need to clear */
+	igt_fb_pool_get(data->fb_pool, width + localcrop * 2,
+			height + localcrop * 2, format, modifier, 0, fb);
+	fb->color_encoding = color_encoding;
+	fb->color_range = color_range;
 
 	cr = igt_get_cairo_ctx(data->drm_fd, fb);
 
@@ -704,7 +709,7 @@ static void capture_format_crcs_single(data_t *data, enum pipe pipe,
 	igt_display_commit2(&data->display, data->display.is_atomic ?
 			    COMMIT_ATOMIC : COMMIT_UNIVERSAL);
 
-	igt_remove_fb(data->drm_fd, &old_fb);
+	igt_fb_pool_put(data->fb_pool, &old_fb);
 
 	igt_pipe_crc_get_current(data->drm_fd, data->pipe_crc, &crc[0]);
 }
@@ -718,6 +723,7 @@ static void capture_format_crcs_multiple(data_t *data, enum pipe pipe,
 					 igt_crc_t crc[], struct igt_fb *fb)
 {
 	unsigned int vblank[ARRAY_SIZE(colors_extended)];
+	struct igt_fb retired = {};
 	struct drm_event_vblank ev;
 	int i;
 
@@ -740,6 +746,7 @@ restart_round:
 			if (i >= 2)
 				vblank[i - 2] = ev.sequence;
 		}
+		igt_fb_pool_put(data->fb_pool, &retired);
 
 		/*
 		 * The flip issued during frame N will latch
@@ -770,7 +777,7 @@ restart_round:
 				igt_display_commit_atomic(&data->display,
 							  DRM_MODE_ATOMIC_ALLOW_MODESET,
 							  NULL);
-				igt_remove_fb(data->drm_fd, &old_fb);
+				igt_fb_pool_put(data->fb_pool, &old_fb);
 				goto restart_round;
 			}
 		} else {
@@ -797,7 +804,12 @@ restart_round:
 			}
 		}
 
-		igt_remove_fb(data->drm_fd, &old_fb);
+		/*
+		 * The previous fb may be scanned out until this flip latches,
+		 * so it only goes back to the pool, to be painted with the
+		 * next color, once that was seen in the next round.
+		 */
+		retired = old_fb;
 	}
 
 	if (data->display.is_atomic) {
@@ -820,6 +832,7 @@ restart_round:
 		 */
 		vblank[i - 1] = kmstest_get_vblank(data->drm_fd, pipe, 0) + 1;
 	}
+	igt_fb_pool_put(data->fb_pool, &retired);
 
 	/*
 	 * Get the remaining two crcs
@@ -1029,6 +1042,82 @@ static bool skip_format_mod(data_t *data,
 	return false;
 }
 
+struct ref_capture {
+	data_t *data;
+	enum pipe pipe;
+	igt_plane_t *plane;
+	uint32_t format;
+	uint64_t modifier;
+	int width, height;
+	struct igt_fb *fb;
+};
+
+static void capture_ref_crcs_single(void *_ref, igt_crc_t crc[], int count)
+{
+	struct ref_capture *ref = _ref;
+
+	capture_format_crcs_single(ref->data, ref->pipe, ref->plane,
+				   ref->format, ref->modifier,
+				   ref->width, ref->height, IGT_COLOR_YCBCR_BT709,
+				   IGT_COLOR_YCBCR_LIMITED_RANGE, crc, ref->fb);
+}
+
+static void capture_ref_crcs_multiple(void *_ref, igt_crc_t crc[], int count)
+{
+	struct ref_capture *ref = _ref;
+
+	capture_format_crcs_multiple(ref->data, ref->pipe, ref->plane,
+				     ref->format, ref->modifier,
+				     ref->width, ref->height, IGT_COLOR_YCBCR_BT709,
+				     IGT_COLOR_YCBCR_LIMITED_RANGE, crc, ref->fb);
+}
+
+/*
+ * The references only depend on what reaches the pipe CRC, so they are
+ * shared by all the pipes and planes showing the same thing in the same
+ * mode. The output is part of the source as "auto" may pick a port CRC.
+ */
+static void capture_ref_crcs(data_t *data, enum pipe pipe,
+			     igt_output_t *output, igt_plane_t *plane,
+			     uint32_t format, uint64_t modifier,
+			     int width, int height,
+			     igt_crc_t ref_crc[][ARRAY_SIZE(colors_extended)],
+			     struct igt_fb *fb)
+{
+	const int localcrop = format == DRM_FORMAT_XRGB8888 ? 0 : data->crop;
+	struct ref_capture ref = {
+		.data = data,
+		.pipe = pipe,
+		.plane = plane,
+		.format = format,
+		.modifier = modifier,
+		.width = width,
+		.height = height,
+		.fb = fb,
+	};
+	drmModeModeInfo *mode = igt_output_get_mode(output);
+	igt_crc_cache_key_t key;
+	char source[64];
+
+	snprintf(source, sizeof(source), IGT_PIPE_CRC_SOURCE_AUTO ":%s",
+		 igt_output_name(output));
+
+	igt_crc_cache_key_init(&key, source, mode, data->display_ver,
+			       "%s " IGT_FORMAT_FMT " %dx%d crop %d single",
+			       kmstest_plane_type_name(plane->type),
+			       IGT_FORMAT_ARGS(format), width, height, localcrop);
+	igt_crc_cache_get(&data->ref_crcs, &key, ref_crc[SINGLE_CRC_SET], 1,
+			  capture_ref_crcs_single, &ref);
+
+	igt_crc_cache_key_init(&key, source, mode, data->display_ver,
+			       "%s " IGT_FORMAT_FMT " %dx%d crop %d %s colors",
+			       kmstest_plane_type_name(plane->type),
+			       IGT_FORMAT_ARGS(format), width, height, localcrop,
+			       data->extended ? "extended" : "reduced");
+	igt_crc_cache_get(&data->ref_crcs, &key, ref_crc[MULTIPLE_CRC_SET],
+			  data->num_colors, capture_ref_crcs_multiple, &ref);
+}
+
 static void test_format_plane(data_t *data, enum pipe pipe,
 			      igt_output_t *output, igt_plane_t *plane, igt_fb_t *primary_fb)
 {
@@ -1079,15 +1168,8 @@ static void test_format_plane(data_t *data, enum pipe pipe,
 
 	check_allowed_plane_size_64x64(data, plane, &width, &height, ref.format);
 
-	capture_format_crcs_single(data, pipe, plane, ref.format, ref.modifier,
-				   width, height, IGT_COLOR_YCBCR_BT709,
-				   IGT_COLOR_YCBCR_LIMITED_RANGE,
-				   ref_crc[SINGLE_CRC_SET], &fb);
-
-	capture_format_crcs_multiple(data, pipe, plane, ref.format, ref.modifier,
-				     width, height, IGT_COLOR_YCBCR_BT709,
-				     IGT_COLOR_YCBCR_LIMITED_RANGE,
-				     ref_crc[MULTIPLE_CRC_SET], &fb);
+	capture_ref_crcs(data, pipe, output, plane, ref.format, ref.modifier,
+			 width, height, ref_crc, &fb);
 
 	/*
 	 * Make sure we have some difference between the colors. This
@@ -1145,7 +1227,7 @@ static void test_format_plane(data_t *data, enum pipe pipe,
 	igt_pipe_crc_stop(data->pipe_crc);
 
 	igt_plane_set_fb(plane, clear_fb);
-	igt_remove_fb(data->drm_fd, &fb);
+	igt_fb_pool_put(data->fb_pool, &fb);
 
 	igt_vec_fini(&tested_formats);
 
@@ -1458,11 +1540,19 @@ igt_main_args("", long_opts, help_str, opt_handler, &data)
 
 		igt_require_pipe_crc(data.drm_fd);
 		igt_display_require(&data.display, data.drm_fd);
+
+		igt_crc_cache_init(&data.ref_crcs);
+		data.fb_pool = igt_fb_pool_create(data.drm_fd, 256 << 20);
+		if (is_intel_device(data.drm_fd))
+			data.display_ver = intel_display_ver(intel_get_drm_devid(data.drm_fd));
 	}
 
 	run_tests_for_pipe_plane(&data);
 
 	igt_fixture {
+		igt_crc_cache_report(&data.ref_crcs);
+		igt_crc_cache_fini(&data.ref_crcs);
+		igt_fb_pool_destroy(data.fb_pool);
 		igt_display_fini(&data.display);
 		drm_close_driver(data.drm_fd);
 	}
@@ -131,7 +131,12 @@ static bool device_exists(const char *name)
 	return find_device(name, &card);
 }
 
-static void assert_device_config(igt_vkms_config_t *cfg)
+static const char *device_name(igt_vkms_t *dev)
+{
+	return strrchr(dev->path, '/') + 1;
+}
+
+static void __assert_device_config(const char *name, igt_vkms_config_t *cfg)
 {
 	struct igt_device_card card;
 	drmModeResPtr res;
@@ -148,12 +153,12 @@ static void assert_device_config(igt_vkms_config_t *cfg)
 	int n_connector_status_drm[4] = {0};
 	int fd;
 
-	found = find_device(cfg->device_name, &card);
-	igt_assert_f(found, "Device '%s' not found\n", cfg->device_name);
+	found = find_device(name, &card);
+	igt_assert_f(found, "Device '%s' not found\n", name);
 
 	fd = igt_open_card(&card);
 	igt_assert_f(fd >= 0, "Error opening device '%s' at path '%s'\n",
-		     cfg->device_name, card.card);
+		     name, card.card);
 	igt_assert_f(!drmSetClientCap(fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1),
 		     "Error setting DRM_CLIENT_CAP_UNIVERSAL_PLANES\n");
 	igt_assert_f(!drmSetClientCap(fd, DRM_CLIENT_CAP_ATOMIC, 1),
@@ -210,6 +215,11 @@ static void assert_device_config(igt_vkms_config_t *cfg)
 	close(fd);
 }
 
+static void assert_device_config(igt_vkms_config_t *cfg)
+{
+	__assert_device_config(cfg->device_name, cfg);
+}
+
 /**
  * SUBTEST: device-default-files
  * Description: Test that creating a VKMS device creates the default files and
@@ -1895,6 +1905,203 @@ static void test_enabled_connector_hot_plug(void)
 	igt_vkms_device_destroy(dev);
 }
 
+/**
+ * SUBTEST: apply-config
+ * Description: Test that applying a configuration to an existing VKMS device
+ *              only changes what differs, and that the device matches it once
+ *              enabled again.
+ */
+
+static void test_apply_config(void)
+{
+	igt_vkms_t *dev;
+
+	igt_vkms_config_t cfg1 = {
+		.device_name = __func__,
+		.planes = {
+			{
+				.name = "plane0",
+				.type = DRM_PLANE_TYPE_PRIMARY,
+				.possible_crtcs = { "crtc0" },
+			},
+		},
+		.crtcs = {
+			{ .name = "crtc0" },
+		},
+		.encoders = {
+			{ .name = "encoder0", .possible_crtcs = { "crtc0" } },
+		},
+		.connectors = {
+			{
+				.name = "connector0",
+				.status = DRM_MODE_CONNECTED,
+				.possible_encoders = { "encoder0" },
+			},
+		},
+	};
+	igt_vkms_config_t cfg2 = {
+		.device_name = __func__,
+		.planes = {
+			{
+				.name = "plane0",
+				.type = DRM_PLANE_TYPE_PRIMARY,
+				.possible_crtcs = { "crtc0" },
+			},
+			{
+				.name = "plane1",
+				.type = DRM_PLANE_TYPE_PRIMARY,
+				.possible_crtcs = { "crtc1" },
+			},
+			{
+				.name = "plane2",
+				.type = DRM_PLANE_TYPE_CURSOR,
+				.possible_crtcs = { "crtc1" },
+			},
+		},
+		.crtcs = {
+			{ .name = "crtc0" },
+			{ .name = "crtc1", .writeback = true },
+		},
+		.encoders = {
+			{ .name = "encoder0", .possible_crtcs = { "crtc0" } },
+			{ .name = "encoder1", .possible_crtcs = { "crtc1" } },
+		},
+		.connectors = {
+			{
+				.name = "connector0",
+				.status = DRM_MODE_DISCONNECTED,
+				.possible_encoders = { "encoder0" },
+			},
+			{
+				.name = "connector1",
+				.status = DRM_MODE_CONNECTED,
+				.possible_encoders = { "encoder1" },
+			},
+		},
+	};
+
+	dev = igt_vkms_device_create_from_config(&cfg1);
+	igt_assert(dev);
+
+	igt_vkms_device_set_enabled(dev, true);
+	igt_assert(igt_vkms_device_is_enabled(dev));
+	assert_device_config(&cfg1);
+
+	/* Nothing to do, the device stays enabled */
+	igt_assert_eq(igt_vkms_device_apply_config(dev, &cfg1), 0);
+	igt_assert(igt_vkms_device_is_enabled(dev));
+
+	/* Changing the topology disables the device */
+	igt_assert_lt(0, igt_vkms_device_apply_config(dev, &cfg2));
+	igt_assert(!igt_vkms_device_is_enabled(dev));
+
+	igt_vkms_device_set_enabled(dev, true);
+	igt_assert(igt_vkms_device_is_enabled(dev));
+	assert_device_config(&cfg2);
+	igt_assert_eq(igt_vkms_device_apply_config(dev, &cfg2), 0);
+
+	/* And back */
+	igt_assert_lt(0, igt_vkms_device_apply_config(dev, &cfg1));
+	igt_vkms_device_set_enabled(dev, true);
+	igt_assert(igt_vkms_device_is_enabled(dev));
+	assert_device_config(&cfg1);
+
+	igt_vkms_device_destroy(dev);
+}
+
+/**
+ * SUBTEST: pool-reuse
+ * Description: Test that devices handed back to the VKMS device pool are
+ *              reconfigured and reused instead of creating new ones.
+ */
+
+static void test_pool_reuse(void)
+{
+	igt_vkms_t *dev1, *dev2, *dev, *other;
+
+	igt_vkms_config_t cfg1 = {
+		.device_name = __func__,
+		.planes = {
+			{
+				.name = "plane0",
+				.type = DRM_PLANE_TYPE_PRIMARY,
+				.possible_crtcs = { "crtc0" },
+			},
+		},
+		.crtcs = {
+			{ .name = "crtc0" },
+		},
+		.encoders = {
+			{ .name = "encoder0", .possible_crtcs = { "crtc0" } },
+		},
+		.connectors = {
+			{
+				.name = "connector0",
+				.status = DRM_MODE_CONNECTED,
+				.possible_encoders = { "encoder0" },
+			},
+		},
+	};
+	igt_vkms_config_t cfg2 = {
+		.device_name = __func__,
+		.planes = {
+			{
+				.name = "plane0",
+				.type = DRM_PLANE_TYPE_PRIMARY,
+				.possible_crtcs = { "crtc0" },
+			},
+			{
+				.name = "plane1",
+				.type = DRM_PLANE_TYPE_OVERLAY,
+				.possible_crtcs = { "crtc0" },
+			},
+		},
+		.crtcs = {
+			{ .name = "crtc0", .writeback = true },
+		},
+		.encoders = {
+			{ .name = "encoder0", .possible_crtcs = { "crtc0" } },
+		},
+		.connectors = {
+			{
+				.name = "connector0",
+				.status = DRM_MODE_DISCONNECTED,
+				.possible_encoders = { "encoder0" },
+			},
+		},
+	};
+
+	dev1 = igt_vkms_pool_get(&cfg1);
+	igt_assert(igt_vkms_device_is_enabled(dev1));
+	__assert_device_config(device_name(dev1), &cfg1);
+
+	/* Devices in use are not handed out twice */
+	dev2 = igt_vkms_pool_get(&cfg1);
+	igt_assert(dev2 != dev1);
+	__assert_device_config(device_name(dev2), &cfg1);
+
+	igt_vkms_pool_put(dev1);
+	igt_vkms_pool_put(dev2);
+
+	/* An idle device is reconfigured rather than a new one created */
+	dev = igt_vkms_pool_get(&cfg2);
+	igt_assert(dev == dev1 || dev == dev2);
+	igt_assert(igt_vkms_device_is_enabled(dev));
+	__assert_device_config(device_name(dev), &cfg2);
+
+	/* And the one still matching is preferred */
+	other = igt_vkms_pool_get(&cfg1);
+	igt_assert(other == (dev == dev1 ? dev2 : dev1));
+	igt_assert(igt_vkms_device_is_enabled(other));
+	__assert_device_config(device_name(other), &cfg1);
+
+	igt_vkms_pool_put(dev);
+	igt_vkms_pool_put(other);
+	igt_vkms_pool_destroy();
+
+	igt_assert(!device_exists(__func__));
+}
+
 igt_main
 {
 	struct {
@@ -1940,6 +2147,8 @@ igt_main
 		{ "enabled-encoder-cannot-change", test_enabled_encoder_cannot_change },
 		{ "enabled-connector-cannot-change", test_enabled_connector_cannot_change },
 		{ "enabled-connector-hot-plug", test_enabled_connector_hot_plug },
+		{ "apply-config", test_apply_config },
+		{ "pool-reuse", test_pool_reuse },
 	};
 
 	igt_fixture {
@@ -1957,6 +2166,7 @@ igt_main
 	igt_fixture {
 		igt_require_vkms();
 		igt_require_vkms_configfs();
+		igt_vkms_pool_destroy();
 		igt_vkms_destroy_all_devices();
 	}
 }
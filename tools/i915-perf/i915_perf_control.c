@@ -25,10 +25,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 #include "i915_perf_recorder_commands.h"
 
+struct channel {
+	FILE *fifo;
+	int socket_fd;
+};
+
 static void
 usage(const char *name)
 {
@@ -37,10 +44,45 @@ usage(const char *name)
 		"\n"
 		"     --help,               -h         Print this screen\n"
 		"     --command-fifo,       -f <path>  Path to a command fifo\n"
-		"     --dump,               -d <path>  Write a content of circular buffer to path\n",
+		"     --control-socket,     -S <path>  Path to the control socket of the recorder,\n"
+		"                                      used instead of the command fifo\n"
+		"     --dump,               -d <path>  Write a content of circular buffer to path\n"
+		"     --marker,             -m <label> Record a marker\n"
+		"     --begin,              -b <label> Record the beginning of a phase\n"
+		"     --end,                -e <label> Record the end of a phase\n"
+		"     --snapshot,           -s <path>  With a marker, write a content of circular buffer\n"
+		"                                      to path once the snapshot delay has elapsed\n"
+		"     --snapshot-delay,     -D <ms>    Delay between the marker and the snapshot\n"
+		"                                      (default = 0)\n",
 		name);
 }
 
+static char *
+absolute_path(const char *path)
+{
+	char *cwd, *abs_path;
+
+	if (path[0] == '/')
+		return strdup(path);
+
+	cwd = getcwd(NULL, 0);
+	if (asprintf(&abs_path, "%s/%s", cwd, path) < 0)
+		abs_path = NULL;
+	free(cwd);
+
+	return abs_path;
+}
+
+static bool
+send_command(const struct channel *channel, const void *data, uint32_t len)
+{
+	if (channel->fifo)
+		return fwrite(data, len, 1, channel->fifo) == 1;
+
+	/* A single datagram, so that the recorder gets whole commands. */
+	return send(channel->socket_fd, data, len, 0) == len;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -48,15 +90,23 @@ main(int argc, char *argv[])
 		{"help",                       no_argument, 0, 'h'},
 		{"dump",                 required_argument, 0, 'd'},
 		{"command-fifo",         required_argument, 0, 'f'},
+		{"control-socket",       required_argument, 0, 'S'},
 		{"quit",                       no_argument, 0, 'q'},
+		{"marker",               required_argument, 0, 'm'},
+		{"begin",                required_argument, 0, 'b'},
+		{"end",                  required_argument, 0, 'e'},
+		{"snapshot",             required_argument, 0, 's'},
+		{"snapshot-delay",       required_argument, 0, 'D'},
 		{0, 0, 0, 0}
 	};
 	const char *command_fifo = I915_PERF_RECORD_FIFO_PATH, *dump_file = NULL;
-	FILE *command_fifo_file;
-	int opt;
+	const char *control_socket = NULL, *marker_label = NULL, *snapshot_file = NULL;
+	struct channel channel = { .socket_fd = -1 };
+	uint32_t marker_type = INTEL_PERF_MARKER_LABEL, snapshot_delay = 0;
+	int opt, ret = EXIT_SUCCESS;
 	bool quit = false;
 
-	while ((opt = getopt_long(argc, argv, "hd:f:q", long_options, NULL)) != -1) {
+	while ((opt = getopt_long(argc, argv, "hd:f:S:qm:b:e:s:D:", long_options, NULL)) != -1) {
 		switch (opt) {
 		case 'h':
 			usage(argv[0]);
@@ -67,9 +117,30 @@ main(int argc, char *argv[])
 		case 'f':
 			command_fifo = optarg;
 			break;
+		case 'S':
+			control_socket = optarg;
+			break;
 		case 'q':
 			quit = true;
 			break;
+		case 'm':
+			marker_type = INTEL_PERF_MARKER_LABEL;
+			marker_label = optarg;
+			break;
+		case 'b':
+			marker_type = INTEL_PERF_MARKER_BEGIN;
+			marker_label = optarg;
+			break;
+		case 'e':
+			marker_type = INTEL_PERF_MARKER_END;
+			marker_label = optarg;
+			break;
+		case 's':
+			snapshot_file = optarg;
+			break;
+		case 'D':
+			snapshot_delay = atoi(optarg);
+			break;
 		default:
 			fprintf(stderr, "Internal error: "
 				"unexpected getopt value: %d\n", opt);
@@ -78,44 +149,88 @@ main(int argc, char *argv[])
 		}
 	}
 
-	if (!command_fifo)
+	if (snapshot_file && !marker_label) {
+		fprintf(stderr, "A snapshot requires a marker\n");
 		return EXIT_FAILURE;
+	}
 
-	command_fifo_file = fopen(command_fifo, "r+");
-	if (!command_fifo_file) {
-		fprintf(stderr, "Unable to open command file\n");
-		return EXIT_FAILURE;
+	if (control_socket) {
+		struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+		if (strlen(control_socket) >= sizeof(addr.sun_path)) {
+			fprintf(stderr, "Control socket path too long\n");
+			return EXIT_FAILURE;
+		}
+		strcpy(addr.sun_path, control_socket);
+
+		channel.socket_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+		if (channel.socket_fd < 0 ||
+		    connect(channel.socket_fd, (struct sockaddr *) &addr,
+			    sizeof(addr)) != 0) {
+			fprintf(stderr, "Unable to connect to control socket\n");
+			return EXIT_FAILURE;
+		}
+	} else {
+		if (!command_fifo)
+			return EXIT_FAILURE;
+
+		channel.fifo = fopen(command_fifo, "r+");
+		if (!channel.fifo) {
+			fprintf(stderr, "Unable to open command file\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	/* Before any dump, so that the dump contains the marker. */
+	if (marker_label) {
+		char *snapshot = snapshot_file ? absolute_path(snapshot_file) : NULL;
+		uint32_t snapshot_len = snapshot ? strlen(snapshot) + 1 : 0;
+		uint32_t total_len = sizeof(struct recorder_command_base) +
+			sizeof(struct recorder_command_marker) + snapshot_len;
+		struct {
+			struct recorder_command_base base;
+			struct recorder_command_marker marker;
+			uint8_t snapshot[];
+		} *data = calloc(1, total_len);
+
+		data->base.command = RECORDER_COMMAND_MARKER;
+		data->base.size = total_len;
+		data->marker.type = marker_type;
+		data->marker.snapshot_delay_ms = snapshot_delay;
+		snprintf(data->marker.label, sizeof(data->marker.label),
+			 "%s", marker_label);
+		if (snapshot_len)
+			memcpy(data->snapshot, snapshot, snapshot_len);
+
+		if (!send_command(&channel, data, total_len)) {
+			fprintf(stderr, "Unable to send marker\n");
+			ret = EXIT_FAILURE;
+		}
+
+		free(snapshot);
+		free(data);
 	}
 
 	if (dump_file) {
-		if (dump_file[0] == '/') {
-			uint32_t total_len =
-				sizeof(struct recorder_command_base) + strlen(dump_file) + 1;
-			struct {
-				struct recorder_command_base base;
-				uint8_t dump[];
-			} *data = malloc(total_len);
-
-			data->base.command = RECORDER_COMMAND_DUMP;
-			data->base.size = total_len;
-			snprintf((char *) data->dump, strlen(dump_file) + 1, "%s", dump_file);
-
-			fwrite(data, total_len, 1, command_fifo_file);
-		} else {
-			char *cwd = getcwd(NULL, 0);
-			uint32_t path_len = strlen(cwd) + 1 + strlen(dump_file) + 1;
-			uint32_t total_len = sizeof(struct recorder_command_base) + path_len;
-			struct {
-				struct recorder_command_base base;
-				uint8_t dump[];
-			} *data = malloc(total_len);
-
-			data->base.command = RECORDER_COMMAND_DUMP;
-			data->base.size = total_len;
-			snprintf((char *) data->dump, path_len, "%s/%s", cwd, dump_file);
-
-			fwrite(data, total_len, 1, command_fifo_file);
+		char *dump = absolute_path(dump_file);
+		uint32_t total_len =
+			sizeof(struct recorder_command_base) + strlen(dump) + 1;
+		struct {
+			struct recorder_command_base base;
+			uint8_t dump[];
+		} *data = malloc(total_len);
+
+		data->base.command = RECORDER_COMMAND_DUMP;
+		data->base.size = total_len;
+		memcpy(data->dump, dump, strlen(dump) + 1);
+
+		if (!send_command(&channel, data, total_len)) {
+			fprintf(stderr, "Unable to send dump command\n");
+			ret = EXIT_FAILURE;
 		}
+
+		free(dump);
+		free(data);
 	}
 
 	if (quit) {
@@ -124,10 +239,16 @@ main(int argc, char *argv[])
 			.size = sizeof(base),
 		};
 
-		fwrite(&base, sizeof(base), 1, command_fifo_file);
+		if (!send_command(&channel, &base, sizeof(base))) {
+			fprintf(stderr, "Unable to send quit command\n");
+			ret = EXIT_FAILURE;
+		}
 	}
 
-	fclose(command_fifo_file);
+	if (channel.fifo)
+		fclose(channel.fifo);
+	if (channel.socket_fd != -1)
+		close(channel.socket_fd);
 
-	return EXIT_SUCCESS;
+	return ret;
 }
@@ -37,6 +37,7 @@
 #include <i915_drm.h>
 
 #include "igt_core.h"
+#include "igt_window_stats.h"
 #include "intel_chipset.h"
 #include "i915/perf.h"
 #include "i915/perf_data_reader.h"
@@ -54,7 +55,14 @@ usage(void)
 	       "     --counters, -c c1,c2,...  List of counters to display values for.\n"
 	       "                               Use 'all' to display all counters.\n"
 	       "                               Use 'list' to list available counters.\n"
-	       "     --reports, -r             Print out data per report.\n");
+	       "     --reports, -r             Print out data per report.\n"
+	       "     --window, -w <ms>         Aggregate the counters in windows of <ms>\n"
+	       "                               milliseconds, and write the min/avg/max of\n"
+	       "                               each counter per window as CSV.\n"
+	       "     --per-context, -p         Split the windows per context (hw_id).\n"
+	       "     --output, -o <file>       Write the CSV to <file> instead of stdout.\n"
+	       "     --threads, -j <n>         Number of threads aggregating the counters,\n"
+	       "                               one per CPU by default.\n");
 }
 
 static struct intel_perf_logical_counter *
@@ -202,6 +210,142 @@ print_report_deltas(const struct intel_perf_data_reader *reader,
 	}
 }
 
+static const char *
+marker_type_name(uint32_t type)
+{
+	switch (type) {
+	case INTEL_PERF_MARKER_LABEL: return "label";
+	case INTEL_PERF_MARKER_BEGIN: return "begin";
+	case INTEL_PERF_MARKER_END:   return "end";
+	default:                return "unknown";
+	}
+}
+
+static void
+print_marker(const struct intel_perf_marker_item *item, const char *indent)
+{
+	fprintf(stdout, "%sMarker: CPU=0x%016" PRIx64 " GPU=0x%016" PRIx64
+		" report=%u %s '%s'\n",
+		indent, item->marker->cpu_timestamp, item->marker->gpu_timestamp,
+		item->record, marker_type_name(item->marker->type),
+		item->marker->label);
+}
+
+struct window_source {
+	const struct intel_perf_data_reader *reader;
+	struct intel_perf_logical_counter **counters;
+	uint32_t n_counters;
+	/* per record, time since the first record and context */
+	uint64_t *ts_ns;
+	uint32_t *hw_ids;
+};
+
+static bool
+read_window_sample(void *data, uint64_t idx,
+		   uint64_t *ts_ns, uint32_t *key, double *values)
+{
+	const struct window_source *src = data;
+	const struct intel_perf_data_reader *reader = src->reader;
+	struct intel_perf_accumulator accu;
+
+	intel_perf_accumulate_reports(&accu,
+				      reader->perf, reader->metric_set,
+				      reader->records[idx],
+				      reader->records[idx + 1]);
+
+	*ts_ns = src->ts_ns[idx];
+	*key = src->hw_ids[idx];
+
+	for (uint32_t c = 0; c < src->n_counters; c++) {
+		struct intel_perf_logical_counter *counter = src->counters[c];
+
+		switch (counter->storage) {
+		case INTEL_PERF_LOGICAL_COUNTER_STORAGE_UINT64:
+		case INTEL_PERF_LOGICAL_COUNTER_STORAGE_UINT32:
+		case INTEL_PERF_LOGICAL_COUNTER_STORAGE_BOOL32:
+			values[c] = counter->read_uint64(reader->perf,
+							 reader->metric_set,
+							 accu.deltas);
+			break;
+		case INTEL_PERF_LOGICAL_COUNTER_STORAGE_DOUBLE:
+		case INTEL_PERF_LOGICAL_COUNTER_STORAGE_FLOAT:
+			values[c] = counter->read_float(reader->perf,
+							reader->metric_set,
+							accu.deltas);
+			break;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Only the deltas between consecutive reports are needed, which are
+ * computed by chunks of the recording in parallel. The timestamps are
+ * first unwrapped in a single cheap pass.
+ */
+static void
+print_windows(const struct intel_perf_data_reader *reader,
+	      struct intel_perf_logical_counter **counters,
+	      uint32_t n_counters,
+	      uint64_t window_ns, bool per_context,
+	      unsigned int n_threads, FILE *out)
+{
+	const uint64_t mask = reader->perf->devinfo.oa_timestamp_mask;
+	const uint64_t freq = reader->perf->devinfo.timestamp_frequency;
+	struct window_source src = {
+		.reader = reader,
+		.counters = counters,
+		.n_counters = n_counters,
+	};
+	igt_window_stats_t stats;
+	const char **names;
+	uint64_t ticks = 0, prev, ts;
+
+	igt_window_stats_init(&stats, window_ns, n_counters, per_context);
+	names = malloc(sizeof(*names) * MAX(n_counters, 1));
+	for (uint32_t c = 0; c < n_counters; c++)
+		names[c] = counters[c]->symbol_name;
+
+	if (reader->n_records < 2)
+		goto write;
+
+	src.ts_ns = calloc(reader->n_records, sizeof(*src.ts_ns));
+	src.hw_ids = malloc(reader->n_records * sizeof(*src.hw_ids));
+	assert(src.ts_ns && src.hw_ids);
+
+	prev = intel_perf_read_record_timestamp(reader->perf, reader->metric_set,
+						reader->records[0]);
+	for (uint32_t r = 1; r < reader->n_records; r++) {
+		ts = intel_perf_read_record_timestamp(reader->perf, reader->metric_set,
+						      reader->records[r]);
+		ticks += (ts - prev) & mask;
+		prev = ts;
+		src.ts_ns[r] = ticks / freq * 1000000000ull +
+			       ticks % freq * 1000000000ull / freq;
+	}
+
+	memset(src.hw_ids, 0xff, reader->n_records * sizeof(*src.hw_ids));
+	for (uint32_t i = 0; i < reader->n_timelines; i++) {
+		const struct intel_perf_timeline_item *item = &reader->timelines[i];
+
+		for (uint32_t r = item->record_start; r < item->record_end; r++)
+			src.hw_ids[r] = item->hw_id;
+	}
+
+	igt_window_stats_collect(&stats, reader->n_records - 1,
+				 read_window_sample, &src, n_threads);
+
+	free(src.ts_ns);
+	free(src.hw_ids);
+
+write:
+	igt_window_stats_write_csv(&stats, out, "hw_id", names);
+
+	free(names);
+	igt_window_stats_fini(&stats);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -209,17 +353,23 @@ main(int argc, char *argv[])
 		{"help",             no_argument, 0, 'h'},
 		{"counters",   required_argument, 0, 'c'},
 		{"reports",          no_argument, 0, 'r'},
+		{"window",     required_argument, 0, 'w'},
+		{"per-context",      no_argument, 0, 'p'},
+		{"output",     required_argument, 0, 'o'},
+		{"threads",    required_argument, 0, 'j'},
 		{0, 0, 0, 0}
 	};
 	struct intel_perf_data_reader reader;
 	struct intel_perf_logical_counter **counters;
 	const struct intel_device_info *devinfo;
-	const char *counter_names = NULL;
+	const char *counter_names = NULL, *output = NULL;
 	int32_t n_counters;
-	int fd, opt;
-	bool print_reports = false;
+	int fd, opt, ret = EXIT_SUCCESS;
+	bool print_reports = false, per_context = false;
+	unsigned int n_threads = 0;
+	uint64_t window_ns = 0;
 
-	while ((opt = getopt_long(argc, argv, "hc:r", long_options, NULL)) != -1) {
+	while ((opt = getopt_long(argc, argv, "hc:rw:po:j:", long_options, NULL)) != -1) {
 		switch (opt) {
 		case 'h':
 			usage();
@@ -230,6 +380,22 @@ main(int argc, char *argv[])
 		case 'r':
 			print_reports = true;
 			break;
+		case 'w':
+			window_ns = strtod(optarg, NULL) * 1000000;
+			if (!window_ns) {
+				fprintf(stderr, "Invalid window '%s'.\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'p':
+			per_context = true;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'j':
+			n_threads = atoi(optarg);
+			break;
 		default:
 			fprintf(stderr, "Internal error: "
 				"unexpected getopt value: %d\n", opt);
@@ -260,6 +426,24 @@ main(int argc, char *argv[])
 	if (n_counters < 0)
 		goto exit;
 
+	if (window_ns) {
+		FILE *out = output ? fopen(output, "w") : stdout;
+
+		if (!out) {
+			fprintf(stderr, "Cannot open '%s': %s.\n",
+				output, strerror(errno));
+			ret = EXIT_FAILURE;
+			goto exit;
+		}
+
+		print_windows(&reader, counters, n_counters, window_ns,
+			      per_context, n_threads, out);
+
+		if (out != stdout)
+			fclose(out);
+		goto exit;
+	}
+
 	devinfo = intel_get_device_info(reader.devinfo.devid);
 
 	fprintf(stdout, "Recorded on device=0x%x(%s) graphics_ver=%i\n",
@@ -271,6 +455,7 @@ main(int argc, char *argv[])
 	fprintf(stdout, "Reports: %u\n", reader.n_records);
 	fprintf(stdout, "Context switches: %u\n", reader.n_timelines);
 	fprintf(stdout, "Timestamp correlation points: %u\n", reader.n_correlations);
+	fprintf(stdout, "Markers: %u\n", reader.n_markers);
 
 	if (reader.n_correlations < 2) {
 		fprintf(stderr, "Less than 2 CPU/GPU timestamp correlation points.\n");
@@ -308,6 +493,9 @@ main(int argc, char *argv[])
 			"WARNING: This could lead to inconsistent counter values.\n");
 	}
 
+	for (uint32_t i = 0; i < reader.n_markers; i++)
+		print_marker(&reader.markers[i], "");
+
 	for (uint32_t i = 0; i < reader.n_timelines; i++) {
 		const struct intel_perf_timeline_item *item = &reader.timelines[i];
 
@@ -325,6 +513,10 @@ main(int argc, char *argv[])
 
 		if (print_reports) {
 			for (uint32_t r = item->record_start; r < item->record_end; r++) {
+				for (uint32_t m = 0; m < reader.n_markers; m++) {
+					if (reader.markers[m].record == r)
+						print_marker(&reader.markers[m], " ");
+				}
 				fprintf(stdout, " report%i = %s\n",
 					r - item->record_start,
 					intel_perf_read_report_reason(reader.perf, reader.records[r]));
@@ -337,8 +529,9 @@ main(int argc, char *argv[])
 	}
 
  exit:
+	free(counters);
 	intel_perf_data_reader_fini(&reader);
 	close(fd);
 
-	return EXIT_SUCCESS;
+	return ret;
 }
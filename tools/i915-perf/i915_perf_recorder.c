@@ -35,10 +35,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/sysmacros.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -408,6 +410,14 @@ struct recording_context {
 	const char *command_fifo;
 	int command_fifo_fd;
 
+	const char *control_socket;
+	int control_socket_fd;
+
+	/* Snapshot of the circular buffer requested along with a marker. */
+	char *snapshot_path;
+	struct timespec snapshot_time;
+	uint64_t snapshot_delay_ns;
+
 	uint64_t poll_period;
 
 	struct i915_engine_class_instance engine;
@@ -684,64 +694,185 @@ write_correlation_timestamps(FILE *output, int drm_fd)
 }
 
 static void
-read_command_file(struct recording_context *ctx)
+dump_circular_buffer(struct recording_context *ctx, const char *path)
 {
-	struct recorder_command_base header;
-	ssize_t ret = read(ctx->command_fifo_fd, &header, sizeof(header));
+	FILE *file;
 
-	if (ret < 0)
-		return;
+	fprintf(stdout, "Writing circular buffer to %s\n", path);
+
+	file = fopen(path, "w+");
+	if (file) {
+		struct chunk chunks[2];
 
-	switch (header.command) {
-	case RECORDER_COMMAND_DUMP: {
-		uint32_t len = header.size - sizeof(header), offset = 0;
-		uint8_t *dump = malloc(len);
-		FILE *file;
-
-		while (offset < len &&
-		       ((ret = read(ctx->command_fifo_fd,
-				    (void *) dump + offset, len - offset)) > 0
-			|| errno == EAGAIN)) {
-			if (ret > 0)
-				offset += ret;
+		fflush(ctx->output_stream);
+		get_chunks(chunks, &ctx->circular_buffer,
+			   false, ctx->circular_buffer.size);
+
+		if (!write_version(file, ctx) ||
+		    !write_header(file, ctx) ||
+		    !write_topology(file, ctx) ||
+		    fwrite(chunks[0].data, chunks[0].len, 1, file) != 1 ||
+		    (chunks[1].len > 0 &&
+		     fwrite(chunks[1].data, chunks[1].len, 1, file) != 1) ||
+		    !write_correlation_timestamps(file, ctx->drm_fd)) {
+			fprintf(stderr, "Unable to write circular buffer data in file '%s'\n",
+				path);
 		}
+		fclose(file);
+	} else
+		fprintf(stderr, "Unable to write dump file '%s'\n", path);
+}
 
-		fprintf(stdout, "Writing circular buffer to %s\n", dump);
-
-		file = fopen((const char *) dump, "w+");
-		if (file) {
-			struct chunk chunks[2];
-
-			fflush(ctx->output_stream);
-			get_chunks(chunks, &ctx->circular_buffer,
-				   false, ctx->circular_buffer.size);
-
-			if (!write_version(file, ctx) ||
-			    !write_header(file, ctx) ||
-			    !write_topology(file, ctx) ||
-			    fwrite(chunks[0].data, chunks[0].len, 1, file) != 1 ||
-			    (chunks[1].len > 0 &&
-			     fwrite(chunks[1].data, chunks[1].len, 1, file) != 1) ||
-			    !write_correlation_timestamps(file, ctx->drm_fd)) {
-				fprintf(stderr, "Unable to write circular buffer data in file '%s'\n",
-					dump);
-			}
-			fclose(file);
-		} else
-			fprintf(stderr, "Unable to write dump file '%s'\n", dump);
+static void
+write_marker(struct recording_context *ctx,
+	     const struct recorder_command_marker *cmd,
+	     const char *snapshot)
+{
+	struct intel_perf_record_timestamp_correlation corr;
+	struct intel_perf_record_marker marker = {
+		.type = cmd->type,
+	};
+	struct drm_i915_perf_record_header header = {
+		.type = INTEL_PERF_RECORD_TYPE_MARKER,
+		.size = sizeof(header) + sizeof(marker),
+	};
 
-		free(dump);
-		break;
+	snprintf(marker.label, sizeof(marker.label), "%.*s",
+		 (int) sizeof(cmd->label), cmd->label);
+
+	/* Flush the reports preceding the marker so that it lands in
+	 * order in the stream, then timestamp it in both domains.
+	 */
+	if (!write_i915_perf_data(ctx->output_stream, ctx->perf_fd) ||
+	    !get_correlation_timestamps(&corr, ctx->drm_fd)) {
+		fprintf(stderr, "Unable to timestamp marker '%s'\n", marker.label);
+		return;
+	}
+
+	marker.cpu_timestamp = corr.cpu_timestamp;
+	marker.gpu_timestamp = corr.gpu_timestamp;
+
+	if (fwrite(&header, sizeof(header), 1, ctx->output_stream) != 1 ||
+	    fwrite(&marker, sizeof(marker), 1, ctx->output_stream) != 1) {
+		fprintf(stderr, "Unable to write marker '%s'\n", marker.label);
+		return;
 	}
+
+	if (!snapshot || !snapshot[0])
+		return;
+
+	if (!ctx->circular_buffer.data) {
+		fprintf(stderr, "Not recording in a circular buffer, ignoring snapshot '%s'\n",
+			snapshot);
+		return;
+	}
+
+	if (ctx->snapshot_path) {
+		fprintf(stderr, "Snapshot '%s' already pending, ignoring snapshot '%s'\n",
+			ctx->snapshot_path, snapshot);
+		return;
+	}
+
+	ctx->snapshot_path = strdup(snapshot);
+	ctx->snapshot_delay_ns = cmd->snapshot_delay_ms * 1000000ull;
+	igt_gettime(&ctx->snapshot_time);
+}
+
+static uint64_t
+snapshot_remaining_ns(struct recording_context *ctx)
+{
+	uint64_t elapsed_ns = igt_nsec_elapsed(&ctx->snapshot_time);
+
+	return elapsed_ns < ctx->snapshot_delay_ns ?
+		ctx->snapshot_delay_ns - elapsed_ns : 0;
+}
+
+static void
+handle_command(struct recording_context *ctx,
+	       const struct recorder_command_base *header,
+	       const uint8_t *payload, uint32_t len)
+{
+	switch (header->command) {
+	case RECORDER_COMMAND_DUMP:
+		dump_circular_buffer(ctx, (const char *) payload);
+		break;
 	case RECORDER_COMMAND_QUIT:
 		quit = true;
 		break;
+	case RECORDER_COMMAND_MARKER: {
+		const struct recorder_command_marker *marker =
+			(const struct recorder_command_marker *) payload;
+
+		if (len < sizeof(*marker)) {
+			fprintf(stderr, "Truncated marker command\n");
+			break;
+		}
+
+		write_marker(ctx, marker,
+			     len > sizeof(*marker) ? (const char *) (marker + 1) : NULL);
+		break;
+	}
 	default:
-		fprintf(stderr, "Unknown command 0x%x\n", header.command);
+		fprintf(stderr, "Unknown command 0x%x\n", header->command);
 		break;
 	}
 }
 
+static void
+read_command_file(struct recording_context *ctx)
+{
+	struct recorder_command_base header;
+	ssize_t ret = read(ctx->command_fifo_fd, &header, sizeof(header));
+	uint32_t len, offset = 0;
+	uint8_t *payload;
+
+	if (ret < (ssize_t) sizeof(header) || header.size < sizeof(header))
+		return;
+
+	/* Always NUL terminated for the paths. */
+	len = header.size - sizeof(header);
+	payload = calloc(1, len + 1);
+
+	while (offset < len &&
+	       ((ret = read(ctx->command_fifo_fd,
+			    (void *) payload + offset, len - offset)) > 0
+		|| errno == EAGAIN)) {
+		if (ret > 0)
+			offset += ret;
+	}
+
+	handle_command(ctx, &header, payload, len);
+
+	free(payload);
+}
+
+static void
+read_control_socket(struct recording_context *ctx)
+{
+	union {
+		struct recorder_command_base header;
+		uint8_t data[sizeof(struct recorder_command_base) +
+			     sizeof(struct recorder_command_marker) + PATH_MAX + 1];
+	} msg;
+	ssize_t ret;
+
+	/* Each datagram is a whole command, handle all the queued ones. */
+	while ((ret = recv(ctx->control_socket_fd, msg.data,
+			   sizeof(msg.data) - 1, 0)) > 0 || errno == EINTR) {
+		if (ret < 0)
+			continue;
+
+		if (ret < (ssize_t) sizeof(msg.header) || msg.header.size != ret) {
+			fprintf(stderr, "Invalid command of %zd bytes\n", ret);
+			continue;
+		}
+
+		msg.data[ret] = 0;
+		handle_command(ctx, &msg.header, msg.data + sizeof(msg.header),
+			       ret - sizeof(msg.header));
+	}
+}
+
 static void
 print_metric_sets(const struct intel_perf *perf)
 {
@@ -811,6 +942,8 @@ usage(const char *name)
 		"                                       be recorded.\n"
 		"     --command-fifo,       -f <path>   Path to a command fifo, implies circular buffer\n"
 		"                                       (To use with i915-perf-control)\n"
+		"     --control-socket,     -S <path>   Path to a control socket, to send markers\n"
+		"                                       with low latency (To use with i915-perf-control)\n"
 		"     --output,             -o <path>   Output file (default = i915_perf.record)\n"
 		"     --cpu-clock,          -k <path>   Cpu clock to use for correlations\n"
 		"                                       Values: boot, mono, mono_raw (default = mono)\n"
@@ -836,6 +969,12 @@ teardown_recording_context(struct recording_context *ctx)
 	if (ctx->command_fifo_fd != -1)
 		close(ctx->command_fifo_fd);
 
+	if (ctx->control_socket)
+		unlink(ctx->control_socket);
+	if (ctx->control_socket_fd != -1)
+		close(ctx->control_socket_fd);
+	free(ctx->snapshot_path);
+
 	if (ctx->output_stream)
 		fclose(ctx->output_stream);
 
@@ -887,6 +1026,7 @@ main(int argc, char *argv[])
 		{"output",               required_argument, 0, 'o'},
 		{"size",                 required_argument, 0, 's'},
 		{"command-fifo",         required_argument, 0, 'f'},
+		{"control-socket",       required_argument, 0, 'S'},
 		{"cpu-clock",            required_argument, 0, 'k'},
 		{"poll-period",          required_argument, 0, 'P'},
 		{"engine-class",         required_argument, 0, 'e'},
@@ -918,12 +1058,14 @@ main(int argc, char *argv[])
 		.command_fifo = I915_PERF_RECORD_FIFO_PATH,
 		.command_fifo_fd = -1,
 
+		.control_socket_fd = -1,
+
 		/* 5 ms poll period */
 		.poll_period = 5 * 1000 * 1000,
 		.engine = { USHRT_MAX, USHRT_MAX },
 	};
 
-	while ((opt = getopt_long(argc, argv, "hc:d:p:m:Co:s:f:k:P:e:i:", long_options, NULL)) != -1) {
+	while ((opt = getopt_long(argc, argv, "hc:d:p:m:Co:s:f:S:k:P:e:i:", long_options, NULL)) != -1) {
 		switch (opt) {
 		case 'h':
 			usage(argv[0]);
@@ -956,6 +1098,9 @@ main(int argc, char *argv[])
 			ctx.command_fifo = optarg;
 			circular_size = 8 * 1024 * 1024;
 			break;
+		case 'S':
+			ctx.control_socket = optarg;
+			break;
 		case 'k': {
 			bool found = false;
 			for (uint32_t i = 0; i < ARRAY_SIZE(clock_names); i++) {
@@ -1090,6 +1235,31 @@ main(int argc, char *argv[])
 		}
 	}
 
+	if (ctx.control_socket) {
+		struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+		if (strlen(ctx.control_socket) >= sizeof(addr.sun_path)) {
+			fprintf(stderr, "Control socket path too long '%s'\n",
+				ctx.control_socket);
+			ctx.control_socket = NULL;
+			goto fail;
+		}
+		strcpy(addr.sun_path, ctx.control_socket);
+
+		ctx.control_socket_fd = socket(AF_UNIX,
+					       SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+					       0);
+		if (ctx.control_socket_fd < 0 ||
+		    bind(ctx.control_socket_fd, (struct sockaddr *) &addr,
+			 sizeof(addr)) != 0) {
+			fprintf(stderr, "Unable to create control socket '%s': %s\n",
+				ctx.control_socket, strerror(errno));
+			/* Not ours to unlink. */
+			ctx.control_socket = NULL;
+			goto fail;
+		}
+	}
+
 	if (circular_size) {
 		ctx.circular_buffer.allocated_size = circular_size;
 		ctx.circular_buffer.data = malloc(circular_size);
@@ -1161,15 +1331,20 @@ main(int argc, char *argv[])
 	poll_time_ns = corr_period_ns;
 
 	while (!quit) {
-		struct pollfd pollfd[2] = {
-			{         ctx.perf_fd, POLLIN, 0 },
-			{ ctx.command_fifo_fd, POLLIN, 0 },
+		struct pollfd pollfd[3] = {
+			{           ctx.perf_fd, POLLIN, 0 },
+			{   ctx.command_fifo_fd, POLLIN, 0 },
+			{ ctx.control_socket_fd, POLLIN, 0 },
 		};
-		uint64_t elapsed_ns;
+		uint64_t elapsed_ns, timeout_ns = poll_time_ns;
 		int ret;
 
+		if (ctx.snapshot_path)
+			timeout_ns = MIN(timeout_ns, snapshot_remaining_ns(&ctx));
+
+		/* poll() ignores the negative fds of the unused channels. */
 		igt_gettime(&now);
-		ret = poll(pollfd, ctx.command_fifo_fd != -1 ? 2 : 1, poll_time_ns / 1000000);
+		ret = poll(pollfd, ARRAY_SIZE(pollfd), timeout_ns / 1000000);
 		if (ret < 0 && errno != EINTR) {
 			fprintf(stderr, "Failed to poll i915-perf stream: %s\n",
 				strerror(errno));
@@ -1188,6 +1363,16 @@ main(int argc, char *argv[])
 			if (pollfd[1].revents & POLLIN) {
 				read_command_file(&ctx);
 			}
+
+			if (pollfd[2].revents & POLLIN)
+				read_control_socket(&ctx);
+		}
+
+		if (ctx.snapshot_path && !snapshot_remaining_ns(&ctx)) {
+			write_i915_perf_data(ctx.output_stream, ctx.perf_fd);
+			dump_circular_buffer(&ctx, ctx.snapshot_path);
+			free(ctx.snapshot_path);
+			ctx.snapshot_path = NULL;
 		}
 
 		elapsed_ns = igt_nsec_elapsed(&now);
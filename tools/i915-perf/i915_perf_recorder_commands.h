@@ -25,16 +25,19 @@
 
 #include <stdint.h>
 
+#include "i915/perf_data.h"
+
 #define I915_PERF_RECORD_FIFO_PATH "/tmp/.i915-perf-record"
 
 enum recorder_command {
 	RECORDER_COMMAND_DUMP = 1,
 	RECORDER_COMMAND_QUIT,
+	RECORDER_COMMAND_MARKER,
 };
 
 struct recorder_command_base {
 	uint32_t command;
-	uint32_t size; /* size of recorder_command_base + dump in bytes */
+	uint32_t size; /* size of recorder_command_base + payload in bytes */
 };
 
 /*
@@ -45,4 +48,14 @@ struct recorder_command_dump {
 };
 */
 
+/* The marker after the recorder_command_base header, optionally followed
+ * by the NUL terminated path of a snapshot of the circular buffer taken
+ * snapshot_delay_ms after the marker.
+ */
+struct recorder_command_marker {
+	uint32_t type; /* enum intel_perf_marker_type */
+	uint32_t snapshot_delay_ms;
+	char label[INTEL_PERF_MARKER_LABEL_SIZE];
+};
+
 #endif
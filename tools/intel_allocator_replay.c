@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright © 2026 Intel Corporation
+ */
+
+/*
+ * Replays an allocator trace, as logged with IGT_ALLOCATOR_TRACE=<file>,
+ * against the allocator backends without any device, and reports the
+ * latency of the operations and the fragmentation of the address spaces.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "intel_allocator.h"
+#include "intel_allocator_replay.h"
+
+static void usage(const char *name, FILE *f)
+{
+	fprintf(f, "Usage: %s [options] trace\n\n"
+		"Options:\n"
+		"  -a, --allocator <simple|reloc>  Replay against this allocator\n"
+		"                                  (default: as logged)\n"
+		"  -p, --paced                     Keep the logged pacing\n"
+		"  -n, --runs <n>                  Replay n times (default: 1)\n"
+		"  -h, --help                      Show this help\n",
+		name);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct option long_options[] = {
+		{ "allocator", required_argument, NULL, 'a' },
+		{ "paced", no_argument, NULL, 'p' },
+		{ "runs", required_argument, NULL, 'n' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 },
+	};
+	struct intel_allocator_replay replay;
+	uint8_t type = 0;
+	bool paced = false;
+	int runs = 1, c;
+	FILE *trace;
+
+	while ((c = getopt_long(argc, argv, "a:pn:h", long_options, NULL)) != -1) {
+		switch (c) {
+		case 'a':
+			if (!strcmp(optarg, "simple")) {
+				type = INTEL_ALLOCATOR_SIMPLE;
+			} else if (!strcmp(optarg, "reloc")) {
+				type = INTEL_ALLOCATOR_RELOC;
+			} else {
+				usage(argv[0], stderr);
+				return 1;
+			}
+			break;
+		case 'p':
+			paced = true;
+			break;
+		case 'n':
+			runs = atoi(optarg);
+			break;
+		case 'h':
+			usage(argv[0], stdout);
+			return 0;
+		default:
+			usage(argv[0], stderr);
+			return 1;
+		}
+	}
+
+	if (argc - optind != 1 || runs < 1) {
+		usage(argv[0], stderr);
+		return 1;
+	}
+
+	trace = fopen(argv[optind], "r");
+	if (!trace) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	if (!intel_allocator_replay_load(&replay, trace)) {
+		fclose(trace);
+		intel_allocator_replay_fini(&replay);
+		return 1;
+	}
+	fclose(trace);
+
+	for (int i = 0; i < runs; i++) {
+		intel_allocator_replay_run(&replay, type, paced);
+		if (runs > 1)
+			printf("Run %d:\n", i + 1);
+		intel_allocator_replay_report(&replay, stdout);
+	}
+
+	intel_allocator_replay_fini(&replay);
+
+	return 0;
+}
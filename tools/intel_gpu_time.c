@@ -26,21 +26,25 @@
  *
  */
 
-#include <unistd.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/time.h>
+#include <sys/prctl.h>
 #include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
 #include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
 
-#include "intel_io.h"
-#include "intel_chipset.h"
-#include "intel_reg.h"
+#include "igt_drm_usage.h"
 
-#define SAMPLES_PER_SEC             10000
+#define DEFAULT_INTERVAL_MS	1000
 
-static volatile int goddo;
+#define min(a, b) ((a) < (b) ? (a) : (b))
 
 static pid_t spawn(char **argv)
 {
@@ -54,60 +58,169 @@ static pid_t spawn(char **argv)
 	exit(1);
 }
 
-static void sighandler(int sig)
+static int pidfd_open(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+	return syscall(SYS_pidfd_open, pid, 0);
+#else
+	return -1;
+#endif
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static double to_sec(const struct timeval *tv)
+{
+	return tv->tv_sec + 1e-6 * tv->tv_usec;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-H] [-i interval_ms] cmd [args...]\n"
+		"\n"
+		"Runs cmd and reports the CPU time of its process tree, and the\n"
+		"GPU time and memory of the DRM clients it opened, from fdinfo.\n"
+		"Clients are looked up every interval_ms (default %d) and when\n"
+		"cmd exits, a client opened and closed in between is missed.\n"
+		"\n"
+		"With -H, a duplicate of every client fd is held until cmd exits,\n"
+		"so that clients of exited processes are still sampled. This also\n"
+		"keeps their objects alive and the device open, which gets in the\n"
+		"way of commands unbinding or reloading the driver.\n",
+		name, DEFAULT_INTERVAL_MS);
+}
+
+static double report(igt_drm_usage_t *tracker, uint64_t elapsed_ns)
 {
-	goddo = sig;
+	igt_drm_usage_engine_t *engines;
+	igt_drm_usage_region_t *regions;
+	double gpu = 0;
+	int count;
+
+	count = igt_drm_usage_engines(tracker, &engines);
+	for (int i = 0; i < count; i++) {
+		double busy;
+
+		busy = 100. * engines[i].busy_ns /
+		       (elapsed_ns * (engines[i].capacity ?: 1));
+		if (busy > gpu)
+			gpu = busy;
+
+		printf("%s %-16s busy: %" PRIu64 ".%06" PRIu64 "s, %.1f%%\n",
+		       engines[i].pdev, engines[i].name,
+		       engines[i].busy_ns / 1000000000,
+		       engines[i].busy_ns / 1000 % 1000000, busy);
+	}
+	free(engines);
+
+	count = igt_drm_usage_regions(tracker, &regions);
+	for (int i = 0; i < count; i++)
+		printf("%s %-16s resident: %" PRIu64 " KiB peak, total: %" PRIu64 " KiB\n",
+		       regions[i].pdev, regions[i].name,
+		       regions[i].peak_resident >> 10, regions[i].total >> 10);
+	free(regions);
+
+	return gpu;
 }
 
 int main(int argc, char **argv)
 {
-	pid_t child;
-	uint64_t ring_idle = 0, ring_time = 0;
-	struct timeval start, end;
+	int interval = DEFAULT_INTERVAL_MS, timeout;
+	unsigned int flags = 0;
+	igt_drm_usage_t *tracker;
+	uint64_t start, elapsed;
 	static struct rusage rusage;
-	struct intel_mmio_data mmio_data;
+	struct pollfd pfd;
+	pid_t child;
+	double gpu;
 	int status;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "+Hi:h")) != -1) {
+		switch (opt) {
+		case 'H':
+			flags |= IGT_DRM_USAGE_HOLD_FDS;
+			break;
+		case 'i':
+			interval = atoi(optarg);
+			if (interval > 0)
+				break;
+			/* fallthrough */
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
 
-	intel_mmio_use_pci_bar(&mmio_data, intel_get_pci_device());
+	if (optind == argc) {
+		usage(argv[0]);
+		return 1;
+	}
 
-	if (argc == 1) {
-		fprintf(stderr, "usage: %s cmd [args...]\n", argv[0]);
+	/* Orphans of the command get reparented to us and stay tracked */
+	prctl(PR_SET_CHILD_SUBREAPER, 1);
+
+	tracker = igt_drm_usage_create(NULL, getpid(), flags);
+	if (!tracker) {
+		fprintf(stderr, "failed to open /proc\n");
 		return 1;
 	}
 
-	signal(SIGCHLD, sighandler);
 	signal(SIGINT, SIG_IGN);
 	signal(SIGQUIT, SIG_IGN);
 
-	gettimeofday(&start, NULL);
-	child = spawn(argv+1);
+	start = now_ns();
+	child = spawn(argv + optind);
 	if (child < 0)
 		return 127;
 
-	while (!goddo) {
-		uint32_t ring_head, ring_tail;
-
-		ring_head = INREG(LP_RING + RING_HEAD) & HEAD_ADDR;
-		ring_tail = INREG(LP_RING + RING_TAIL) & TAIL_ADDR;
-
-		if (ring_tail == ring_head)
-			ring_idle++;
-		ring_time++;
-
-		usleep(1000000 / SAMPLES_PER_SEC);
+	/*
+	 * Start sampling early so that short commands get seen, and back
+	 * off to the interval for the long ones.
+	 */
+	timeout = min(10, interval);
+	pfd.fd = pidfd_open(child);
+	pfd.events = POLLIN;
+	if (pfd.fd >= 0) {
+		while (!poll(&pfd, 1, timeout)) {
+			igt_drm_usage_sample(tracker, now_ns());
+			timeout = min(2 * timeout, interval);
+		}
+		close(pfd.fd);
+	} else {
+		while (!waitpid(child, &status, WNOHANG)) {
+			igt_drm_usage_sample(tracker, now_ns());
+			usleep(timeout * 1000);
+			timeout = min(2 * timeout, interval);
+		}
 	}
-	gettimeofday(&end, NULL);
-	timersub(&end, &start, &end);
+
+	/* Held fds, if any, keep the clients of exited processes readable */
+	igt_drm_usage_sample(tracker, now_ns());
+	elapsed = now_ns() - start;
 
 	waitpid(child, &status, 0);
+	while (waitpid(-1, NULL, WNOHANG) > 0)
+		;
 
 	getrusage(RUSAGE_CHILDREN, &rusage);
-	printf("user: %ld.%06lds, sys: %ld.%06lds, elapsed: %ld.%06lds, CPU: %.1f%%, GPU: %.1f%%\n",
+	gpu = report(tracker, elapsed);
+	printf("user: %ld.%06lds, sys: %ld.%06lds, elapsed: %" PRIu64 ".%06" PRIu64 "s, CPU: %.1f%%, GPU: %.1f%%\n",
 	       rusage.ru_utime.tv_sec, rusage.ru_utime.tv_usec,
 	       rusage.ru_stime.tv_sec, rusage.ru_stime.tv_usec,
-	       end.tv_sec, end.tv_usec,
-	       100*(rusage.ru_utime.tv_sec + 1e-6*rusage.ru_utime.tv_usec + rusage.ru_stime.tv_sec + 1e-6*rusage.ru_stime.tv_usec) / (end.tv_sec + 1e-6*end.tv_usec),
-	       100 - ring_idle * 100. / ring_time);
+	       elapsed / 1000000000, elapsed / 1000 % 1000000,
+	       100 * (to_sec(&rusage.ru_utime) + to_sec(&rusage.ru_stime)) / (1e-9 * elapsed),
+	       gpu);
+
+	igt_drm_usage_destroy(tracker);
 
 	return WEXITSTATUS(status);
 }